@@ -23,6 +23,8 @@
 #include <map>
 #include <limits>
 
+#include "util/wordcmp.h"
+
 #if defined(_WIN32)
 #undef max
 #undef min
@@ -95,17 +97,17 @@ dodouble:
                 return 1;
             }
         case jstOID:
-            return memcmp(l.value(), r.value(), 12);
+            return wordcmp(l.value(), r.value(), 12);
         case Code:
         case Symbol:
         case String:
             /* todo: a utf sort order version one day... */
             {
-                // we use memcmp as we allow zeros in UTF8 strings
+                // we use wordcmp (memcmp order) as we allow zeros in UTF8 strings
                 int lsz = l.valuestrsize();
                 int rsz = r.valuestrsize();
                 int common = min(lsz, rsz);
-                int res = memcmp(l.valuestr(), r.valuestr(), common);
+                int res = wordcmp(l.valuestr(), r.valuestr(), common);
                 if( res ) 
                     return res;
                 // longer string is the greater one
@@ -118,13 +120,13 @@ dodouble:
             int lsz = l.valuesize();
             int rsz = r.valuesize();
             if ( lsz - rsz != 0 ) return lsz - rsz;
-            return memcmp(l.value(), r.value(), lsz);
+            return wordcmp(l.value(), r.value(), lsz);
         }
         case BinData: {
             int lsz = l.objsize(); // our bin data size in bytes, not including the subtype byte
             int rsz = r.objsize();
             if ( lsz - rsz != 0 ) return lsz - rsz;
-            return memcmp(l.value()+4, r.value()+4, lsz+1);
+            return wordcmp(l.value()+4, r.value()+4, lsz+1);
         }
         case RegEx: {
             int c = strcmp(l.regex(), r.regex());
@@ -247,13 +249,16 @@ dodouble:
         return b.obj();
     }
 
-    inline void BSONObj::getFields(unsigned n, const char **fieldNames, BSONElement *fields) const { 
+    inline void BSONObj::getFields(unsigned n, const char **fieldNames, BSONElement *fields) const {
         BSONObjIterator i(*this);
         while ( i.more() ) {
             BSONElement e = i.next();
             const char *p = e.fieldName();
             for( unsigned i = 0; i < n; i++ ) {
-                if( strcmp(p, fieldNames[i]) == 0 ) {
+                const char *f = fieldNames[i];
+                // first byte filter: nearly every miss in a scan differs in
+                // the first character, so skip the strcmp call for those
+                if( p[0] == f[0] && ( p[0] == 0 || strcmp(p+1, f+1) == 0 ) ) {
                     fields[i] = e;
                     break;
                 }
@@ -262,10 +267,13 @@ dodouble:
     }
 
     inline BSONElement BSONObj::getField(const StringData& name) const {
+        const char *d = name.data();
         BSONObjIterator i(*this);
         while ( i.more() ) {
             BSONElement e = i.next();
-            if ( strcmp(e.fieldName(), name.data()) == 0 )
+            const char *p = e.fieldName();
+            // see getFields() - avoid a strcmp call per non-matching element
+            if ( p[0] == d[0] && ( p[0] == 0 || strcmp(p+1, d+1) == 0 ) )
                 return e;
         }
         return BSONElement();
@@ -903,11 +911,36 @@ dodouble:
         return BSONFieldValue<BSONObj>( _name , b.obj() );
     }
 
-    // used by jsonString()
+    // used by jsonString().  table-driven: 1 marks characters that always
+    // need escaping (quote, backslash, controls), 2 marks '/' which is only
+    // escaped when escape_slash is set.  runs of plain characters - the
+    // overwhelmingly common case - are copied in bulk rather than a branch
+    // per character.
     inline string escape( string s , bool escape_slash=false) {
+        static const unsigned char escapeTable[256] = {
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x00-0x0f control
+            1,1,1,1,1,1,1,1,1,1,1,1,1,1,1,1, // 0x10-0x1f control
+            0,0,1,0,0,0,0,0,0,0,0,0,0,0,0,2, // 0x22 '"'  0x2f '/'
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+            0,0,0,0,0,0,0,0,0,0,0,0,1,0,0,0, // 0x5c '\\'
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,
+            0,0,0,0,0,0,0,0,0,0,0,0,0,0,0,0
+            // 0x80-0xff are all zero initialized - utf8 passes through
+        };
+        const unsigned char mask = escape_slash ? 3 : 1;
         StringBuilder ret;
-        for ( string::iterator i = s.begin(); i != s.end(); ++i ) {
-            switch ( *i ) {
+        const char *p = s.c_str();
+        const char *end = p + s.size();
+        while ( p < end ) {
+            const char *q = p;
+            while ( q < end && ( escapeTable[ (unsigned char) *q ] & mask ) == 0 )
+                ++q;
+            if ( q > p )
+                ret.write( p , (int)( q - p ) );
+            if ( q == end )
+                break;
+            switch ( *q ) {
             case '"':
                 ret << "\\\"";
                 break;
@@ -915,7 +948,7 @@ dodouble:
                 ret << "\\\\";
                 break;
             case '/':
-                ret << (escape_slash ? "\\/" : "/");
+                ret << "\\/";
                 break;
             case '\b':
                 ret << "\\b";
@@ -932,16 +965,13 @@ dodouble:
             case '\t':
                 ret << "\\t";
                 break;
-            default:
-                if ( *i >= 0 && *i <= 0x1f ) {
-                    //TODO: these should be utf16 code-units not bytes
-                    char c = *i;
-                    ret << "\\u00" << toHexLower(&c, 1);
-                }
-                else {
-                    ret << *i;
-                }
+            default: {
+                //TODO: these should be utf16 code-units not bytes
+                char c = *q;
+                ret << "\\u00" << toHexLower(&c, 1);
+            }
             }
+            p = q + 1;
         }
         return ret.str();
     }
@@ -356,6 +356,13 @@ namespace mongo {
         /** true unless corrupt */
         bool valid() const;
 
+        /** single pass structural sanity check of the buffer - element sizes,
+            string null termination, nesting depth.  considerably cheaper than
+            valid() (no recursion, no element construction, no exceptions) so
+            it is suitable for screening every untrusted document on receipt.
+            does not do semantic checks (utf8 etc). */
+        bool structurallyValid() const;
+
         /** @return an md5 value for this object. */
         string md5() const;
 
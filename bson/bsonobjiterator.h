@@ -109,6 +109,35 @@ namespace mongo {
         int _cur;
     };
 
+    /** lookup table over an object's top level fields, built in one pass.  getField()
+        binary searches a (field name sorted) table of element positions instead of
+        rescanning the object, which matters when many fields of a wide document will
+        be fetched - e.g. one per query predicate in the Matcher.  BSON itself cannot
+        carry such a table as the bytes are the wire and storage format, so this is a
+        transient side structure; the object's buffer must outlive the index. */
+    class BSONFieldIndex {
+    public:
+        BSONFieldIndex( const BSONObj& o );
+
+        ~BSONFieldIndex() {
+            assert( _fields );
+            delete[] _fields;
+            _fields = 0;
+        }
+
+        /** @return the named element, eoo() if not present */
+        BSONElement getField( const char *name ) const;
+
+        /** start of the indexed object's buffer - lets a caller check the index
+            matches the object in hand before using it */
+        const char * objdata() const { return _objdata; }
+
+    private:
+        const char *_objdata;
+        const char ** _fields; // element positions, sorted by field name
+        int _nfields;
+    };
+
     /** transform a BSON array into a vector of BSONElements.
         we match array # positions with their vector position, and ignore
         any fields with non-numeric field names.
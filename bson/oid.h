@@ -55,7 +55,11 @@ namespace mongo {
         bool operator<=( const OID& other ) const { return compare( other ) <= 0; }
 
         /** @return the object ID output as 24 hex digits */
-        string str() const { return toHexLower(data, 12); }
+        string str() const {
+            char buf[24];
+            toHex( data , 12 , buf , true );
+            return string( buf , 24 );
+        }
         string toString() const { return str(); }
 
         static OID gen() { OID o; o.init(); return o; }
@@ -108,7 +112,14 @@ namespace mongo {
 #pragma pack()
 
     ostream& operator<<( ostream &s, const OID &o );
-    inline StringBuilder& operator<< (StringBuilder& s, const OID& o) { return (s << o.str()); }
+    inline StringBuilder& operator<< (StringBuilder& s, const OID& o) {
+        // formats straight into the builder - object ids dominate json exports,
+        // so no intermediate string here
+        char buf[24];
+        toHex( o.getData() , 12 , buf , true );
+        s.write( buf , 24 );
+        return s;
+    }
 
     /** Formatting mode for generating JSON from BSON.
         See <http://mongodb.onconfluence.com/display/DOCS/Mongo+Extended+JSON>
@@ -125,7 +136,9 @@ namespace mongo {
     };
 
     inline ostream& operator<<( ostream &s, const OID &o ) {
-        s << o.str();
+        char buf[24];
+        toHex( o.getData() , 12 , buf , true );
+        s.write( buf , 24 );
         return s;
     }
 
@@ -20,6 +20,7 @@
 #include <string>
 #include <string.h>
 #include <stdio.h>
+#include <boost/thread/tss.hpp>
 #include "../inline_decls.h"
 #include "../stringdata.h"
 
@@ -47,13 +48,99 @@ namespace mongo {
 
     void msgasserted(int msgid, const char *msg);
 
-    class TrivialAllocator { 
+    class TrivialAllocator {
     public:
         void* Malloc(size_t sz) { return malloc(sz); }
         void* Realloc(void *p, size_t sz) { return realloc(p, sz); }
         void Free(void *p) { free(p); }
     };
 
+    /** small per-thread cache of recently freed builder blocks.  every operation
+        builds and tears down several BufBuilders, and the malloc/free churn for
+        their blocks shows up in profiles; recycling through this pool keeps the
+        blocks warm across builders (and across operations) on a thread.  blocks
+        are ordinary malloc blocks, so anything that leaves via decouple() can
+        still be free()d by its eventual owner as always.
+    */
+    class BufBlockPool {
+    public:
+        enum { MaxBlocks = 8, MinRecycled = 512, MaxRecycled = 256 * 1024 };
+
+        BufBlockPool() : _n(0) {}
+        ~BufBlockPool() {
+            while( _n )
+                free( _blocks[--_n].p );
+        }
+
+        /** @param found set to the actual size of the returned block
+            @return a cached block of at least sz bytes, or 0 if none */
+        void* get(size_t sz, size_t& found) {
+            for( int i = 0; i < _n; i++ ) {
+                if( _blocks[i].sz >= sz ) {
+                    void *p = _blocks[i].p;
+                    found = _blocks[i].sz;
+                    _blocks[i] = _blocks[--_n];
+                    return p;
+                }
+            }
+            return 0;
+        }
+
+        /** @return true if the block was taken; caller frees it otherwise */
+        bool put(void* p, size_t sz) {
+            if( sz < MinRecycled || sz > MaxRecycled || _n == MaxBlocks )
+                return false;
+            _blocks[_n].p = p;
+            _blocks[_n].sz = sz;
+            _n++;
+            return true;
+        }
+
+    private:
+        struct Block { void *p; size_t sz; };
+        Block _blocks[MaxBlocks];
+        int _n;
+    };
+
+    inline BufBlockPool& bufBlockPool() {
+        static boost::thread_specific_ptr<BufBlockPool> pool;
+        BufBlockPool *p = pool.get();
+        if( p == 0 ) {
+            p = new BufBlockPool();
+            pool.reset(p);
+        }
+        return *p;
+    }
+
+    /** allocator that recycles blocks through the thread's BufBlockPool.  a
+        builder has at most one live block at a time, so the allocator instance
+        just remembers its current size for the eventual put().  blocks come from
+        malloc underneath: decouple()d buffers never return here and are free()d
+        by whoever ends up owning them. */
+    class PooledAllocator {
+    public:
+        void* Malloc(size_t sz) {
+            size_t found;
+            void *p = bufBlockPool().get(sz, found);
+            if( p ) {
+                _sz = found;
+                return p;
+            }
+            _sz = sz;
+            return malloc(sz);
+        }
+        void* Realloc(void *p, size_t sz) {
+            _sz = sz;
+            return realloc(p, sz);
+        }
+        void Free(void *p) {
+            if( !bufBlockPool().put(p, _sz) )
+                free(p);
+        }
+    private:
+        size_t _sz; // size of this builder's (single) live block
+    };
+
     class StackAllocator {
     public:
         enum { SZ = 512 };
@@ -196,10 +283,22 @@ namespace mongo {
             int a = size * 2;
             if ( a == 0 )
                 a = 512;
+            else if ( size > 1024 * 1024 ) {
+                // doubling is right while buffers are small, but a large document
+                // doubling from 16MB reserves 32MB to write one byte past the end.
+                // past 1MB grow by half, rounded up to a page boundary.
+                a = size + size / 2;
+                a = ( a + 4095 ) & ~4095;
+            }
             if ( l > a )
-                a = l + 16 * 1024;
-            if ( a > BufferMaxSize )
-                msgasserted(13548, "BufBuilder grow() > 64MB");
+                a = ( l + 16 * 1024 + 4095 ) & ~4095;
+            if ( a > BufferMaxSize ) {
+                // only assert when the *content* is oversized; an overshooting
+                // growth estimate just gets clamped
+                if ( l > BufferMaxSize )
+                    msgasserted(13548, "BufBuilder grow() > 64MB");
+                a = BufferMaxSize;
+            }
             data = (char *) al.Realloc(data, a);
             size= a;
         }
@@ -211,7 +310,7 @@ namespace mongo {
         friend class StringBuilder;
     };
 
-    typedef _BufBuilder<TrivialAllocator> BufBuilder;
+    typedef _BufBuilder<PooledAllocator> BufBuilder;
 
     /** The StackBufBuilder builds smaller datasets on the stack instead of using malloc.
           this can be significantly faster for small bufs.  However, you can not decouple() the 
@@ -0,0 +1,74 @@
+// wordcmp.h
+
+/*    Copyright 2011 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include <string.h>
+
+namespace mongo {
+
+    /** lexicographic (memcmp order) comparison done a machine word per step.
+
+        index keys and bson string values are usually short - a dozen bytes or
+        so - which is the regime where the call overhead and size dispatch
+        inside the libc memcmp cost more than the compare itself.  reading
+        eight bytes at a time and byte swapping on little endian keeps the
+        whole thing inline and branch light.  on platforms where we don't know
+        unaligned loads are ok (or the swap builtins are missing) this is just
+        memcmp.
+    */
+#if defined(__GNUC__) && ( __GNUC__ > 4 || ( __GNUC__ == 4 && __GNUC_MINOR__ >= 3 ) ) && \
+    ( defined(__x86_64__) || defined(__i386__) )
+    inline int wordcmp(const void* lv, const void* rv, unsigned n) {
+        const char *l = (const char *) lv;
+        const char *r = (const char *) rv;
+        while( n >= 8 ) {
+            // unaligned loads are fine on x86
+            unsigned long long a = *(const unsigned long long *) l;
+            unsigned long long b = *(const unsigned long long *) r;
+            if( a != b ) {
+                a = __builtin_bswap64(a);
+                b = __builtin_bswap64(b);
+                return a < b ? -1 : 1;
+            }
+            l += 8; r += 8; n -= 8;
+        }
+        if( n >= 4 ) {
+            unsigned a = *(const unsigned *) l;
+            unsigned b = *(const unsigned *) r;
+            if( a != b ) {
+                a = __builtin_bswap32(a);
+                b = __builtin_bswap32(b);
+                return a < b ? -1 : 1;
+            }
+            l += 4; r += 4; n -= 4;
+        }
+        while( n ) {
+            int x = (int)(unsigned char)*l - (int)(unsigned char)*r;
+            if( x )
+                return x;
+            l++; r++; n--;
+        }
+        return 0;
+    }
+#else
+    inline int wordcmp(const void* l, const void* r, unsigned n) {
+        return memcmp(l, r, n);
+    }
+#endif
+
+}
@@ -121,6 +121,7 @@ namespace mongo {
     }
 
     unsigned PoolForHost::_maxPerHost = 50;
+    unsigned PoolForHost::_minPerHost = 0;
 
     // ------ DBConnectionPool ------
 
@@ -132,18 +133,26 @@ namespace mongo {
           _hooks( new list<DBConnectionHook*>() ) { 
     }
 
+    shared_ptr<PoolForHost> DBConnectionPool::_forKey( const PoolKey& key ) {
+        scoped_lock L(_mutex);
+        shared_ptr<PoolForHost>& p = _pools[key];
+        if ( ! p )
+            p.reset( new PoolForHost() );
+        return p;
+    }
+
     DBClientBase* DBConnectionPool::_get(const string& ident , double socketTimeout ) {
         assert( ! inShutdown() );
-        scoped_lock L(_mutex);
-        PoolForHost& p = _pools[PoolKey(ident,socketTimeout)];
-        return p.get( this , socketTimeout );
+        shared_ptr<PoolForHost> p = _forKey( PoolKey(ident,socketTimeout) );
+        scoped_spinlock lk( p->lock() );
+        return p->get( this , socketTimeout );
     }
 
     DBClientBase* DBConnectionPool::_finishCreate( const string& host , double socketTimeout , DBClientBase* conn ) {
         {
-            scoped_lock L(_mutex);
-            PoolForHost& p = _pools[PoolKey(host,socketTimeout)];
-            p.createdOne( conn );
+            shared_ptr<PoolForHost> p = _forKey( PoolKey(host,socketTimeout) );
+            scoped_spinlock lk( p->lock() );
+            p->createdOne( conn );
         }
 
         onCreate( conn );
@@ -189,8 +198,9 @@ namespace mongo {
             delete c;
             return;
         }
-        scoped_lock L(_mutex);
-        _pools[PoolKey(host,c->getSoTimeout())].done(this,c);
+        shared_ptr<PoolForHost> p = _forKey( PoolKey(host,c->getSoTimeout()) );
+        scoped_spinlock lk( p->lock() );
+        p->done(this,c);
     }
 
 
@@ -199,10 +209,15 @@ namespace mongo {
     }
 
     void DBConnectionPool::flush() {
-        scoped_lock L(_mutex);
-        for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); i++ ) {
-            PoolForHost& p = i->second;
-            p.flush();
+        vector< shared_ptr<PoolForHost> > all;
+        {
+            scoped_lock L(_mutex);
+            for ( PoolMap::iterator i = _pools.begin(); i != _pools.end(); i++ )
+                all.push_back( i->second );
+        }
+        for ( size_t i=0; i<all.size(); i++ ) {
+            scoped_spinlock lk( all[i]->lock() );
+            all[i]->flush();
         }
     }
 
@@ -247,32 +262,40 @@ namespace mongo {
 
         set<string> replicaSets;
         
-        BSONObjBuilder bb( b.subobjStart( "hosts" ) );
+        vector< pair< PoolKey, shared_ptr<PoolForHost> > > pools;
         {
             scoped_lock lk( _mutex );
-            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                if ( i->second.numCreated() == 0 )
-                    continue;
+            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i )
+                pools.push_back( make_pair( i->first, i->second ) );
+        }
 
-                string s = str::stream() << i->first.ident << "::" << i->first.timeout;
+        BSONObjBuilder bb( b.subobjStart( "hosts" ) );
+        for ( size_t j=0; j<pools.size(); j++ ) {
+            const PoolKey& key = pools[j].first;
+            PoolForHost& p = *pools[j].second;
+            scoped_spinlock lk( p.lock() );
 
-                BSONObjBuilder temp( bb.subobjStart( s ) );
-                temp.append( "available" , i->second.numAvailable() );
-                temp.appendNumber( "created" , i->second.numCreated() );
-                temp.done();
+            if ( p.numCreated() == 0 )
+                continue;
 
-                avail += i->second.numAvailable();
-                created += i->second.numCreated();
+            string s = str::stream() << key.ident << "::" << key.timeout;
 
-                long long& x = createdByType[i->second.type()];
-                x += i->second.numCreated();
+            BSONObjBuilder temp( bb.subobjStart( s ) );
+            temp.append( "available" , p.numAvailable() );
+            temp.appendNumber( "created" , p.numCreated() );
+            temp.done();
 
-                {
-                    string setName = i->first.ident;
-                    if ( setName.find( "/" ) != string::npos ) {
-                        setName = setName.substr( 0 , setName.find( "/" ) );
-                        replicaSets.insert( setName );
-                    }
+            avail += p.numAvailable();
+            created += p.numCreated();
+
+            long long& x = createdByType[p.type()];
+            x += p.numCreated();
+
+            {
+                string setName = key.ident;
+                if ( setName.find( "/" ) != string::npos ) {
+                    setName = setName.substr( 0 , setName.find( "/" ) );
+                    replicaSets.insert( setName );
                 }
             }
         }
@@ -343,16 +366,21 @@ namespace mongo {
     }
 
 
-    void DBConnectionPool::taskDoWork() { 
+    void DBConnectionPool::taskDoWork() {
         vector<DBClientBase*> toDelete;
-        
+
+        vector< shared_ptr<PoolForHost> > all;
         {
-            // we need to get the connections inside the lock
-            // but we can actually delete them outside
             scoped_lock lk( _mutex );
-            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
-                i->second.getStaleConnections( toDelete );
-            }
+            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i )
+                all.push_back( i->second );
+        }
+
+        // we need to get the connections inside the (per host) lock
+        // but we can actually delete them outside
+        for ( size_t i=0; i<all.size(); i++ ) {
+            scoped_spinlock lk( all[i]->lock() );
+            all[i]->getStaleConnections( toDelete );
         }
 
         for ( size_t i=0; i<toDelete.size(); i++ ) {
@@ -364,6 +392,53 @@ namespace mongo {
                 // we don't care if there was a socket error
             }
         }
+
+        if ( PoolForHost::getMinPerHost() > 0 )
+            _prewarm();
+    }
+
+    void DBConnectionPool::_prewarm() {
+        // find hosts that have been used but are below the idle floor.  connect
+        // outside all locks -- connects are slow and that is the point of
+        // doing them here rather than at checkout time.
+        vector<PoolKey> needy;
+        {
+            scoped_lock lk( _mutex );
+            for ( PoolMap::iterator i=_pools.begin(); i!=_pools.end(); ++i ) {
+                scoped_spinlock sl( i->second->lock() );
+                if ( i->second->numCreated() > 0 &&
+                     i->second->numAvailable() < (int)PoolForHost::getMinPerHost() )
+                    needy.push_back( i->first );
+            }
+        }
+
+        for ( size_t i=0; i<needy.size(); i++ ) {
+            const PoolKey& key = needy[i];
+            for ( unsigned n=0; n<PoolForHost::getMinPerHost() && !inShutdown(); n++ ) {
+                {
+                    shared_ptr<PoolForHost> p = _forKey( key );
+                    scoped_spinlock lk( p->lock() );
+                    if ( p->numAvailable() >= (int)PoolForHost::getMinPerHost() )
+                        break;
+                }
+
+                string errmsg;
+                ConnectionString cs = ConnectionString::parse( key.ident , errmsg );
+                if ( ! cs.isValid() )
+                    break;
+                DBClientBase *c = cs.connect( errmsg, key.timeout );
+                if ( ! c ) {
+                    LOG(1) << _name << ": pre-warm connect to " << key.ident << " failed: " << errmsg << endl;
+                    break; // host presumably down; the next pass will retry
+                }
+                onCreate( c );
+
+                shared_ptr<PoolForHost> p = _forKey( key );
+                scoped_spinlock lk( p->lock() );
+                p->createdOne( c );
+                p->done( this, c );
+            }
+        }
     }
 
     // ------ ScopedDbConnection ------
@@ -22,6 +22,7 @@
 #include "redef_macros.h"
 
 #include "../util/background.h"
+#include "../util/concurrency/spin_lock.h"
 
 namespace mongo {
 
@@ -29,22 +30,19 @@ namespace mongo {
     class DBConnectionPool;
 
     /**
-     * not thread safe
-     * thread safety is handled by DBConnectionPool
+     * not thread safe itself -- DBConnectionPool locks lock() around calls, so
+     * operations on different hosts never contend with each other
      */
-    class PoolForHost {
+    class PoolForHost : boost::noncopyable {
     public:
         PoolForHost()
             : _created(0) {}
 
-        PoolForHost( const PoolForHost& other ) {
-            assert(other._pool.size() == 0);
-            _created = other._created;
-            assert( _created == 0 );
-        }
-
         ~PoolForHost();
 
+        /** per-host lock -- a spinlock as the critical sections are just stack ops */
+        SpinLock& lock() { return _lock; }
+
         int numAvailable() const { return (int)_pool.size(); }
 
         void createdOne( DBClientBase * base );
@@ -65,6 +63,12 @@ namespace mongo {
 
         static void setMaxPerHost( unsigned max ) { _maxPerHost = max; }
         static unsigned getMaxPerHost() { return _maxPerHost; }
+
+        /** floor of idle connections per host -- the pool cleaner task opens new
+            connections in the background for hosts that have dropped below this,
+            so checkout doesn't pay connect+auth latency.  0 (the default) disables. */
+        static void setMinPerHost( unsigned min ) { _minPerHost = min; }
+        static unsigned getMinPerHost() { return _minPerHost; }
     private:
 
         struct StoredConnection {
@@ -76,12 +80,15 @@ namespace mongo {
             time_t when;
         };
 
+        SpinLock _lock;
+
         std::stack<StoredConnection> _pool;
-        
+
         long long _created;
         ConnectionString::ConnectionType _type;
 
         static unsigned _maxPerHost;
+        static unsigned _minPerHost;
     };
 
     class DBConnectionHook {
@@ -156,11 +163,18 @@ namespace mongo {
             bool operator()( const PoolKey& a , const PoolKey& b ) const;
         };
 
-        typedef map<PoolKey,PoolForHost,poolKeyCompare> PoolMap; // servername -> pool
+        typedef map<PoolKey,shared_ptr<PoolForHost>,poolKeyCompare> PoolMap; // servername -> pool
+
+        /** look up (creating if needed) the pool for a key.  _mutex only guards
+            the map itself; the returned pool is locked per host via its lock(). */
+        shared_ptr<PoolForHost> _forKey( const PoolKey& key );
+
+        /** background-create connections for hosts below the configured floor */
+        void _prewarm();
 
-        mongo::mutex _mutex;
+        mongo::mutex _mutex; // guards _pools (the map) only
         string _name;
-        
+
         PoolMap _pools;
 
         // pointers owned by me, right now they leak on shutdown
@@ -533,6 +533,14 @@ namespace mongo {
         return DBClientBase::auth(dbname, username, password.c_str(), errmsg, false);
     }
 
+    bool DBClientConnection::negotiateWireCompression() {
+        BSONObj info;
+        if ( ! runCommand( "admin" , BSON( "setWireCompression" << 1 ) , info ) )
+            return false;
+        port().setCompressOut( true );
+        return true;
+    }
+
     /** query N objects from the database into an array.  makes sense mostly when you want a small number of results.  if a huge number, use 
         query() and iterate the cursor. 
      */
@@ -566,6 +574,12 @@ namespace mongo {
         return _connect( errmsg );
     }
 
+    void DBClientConnection::setSocketTimeout( double secs ) {
+        _so_timeout = secs;
+        if ( p.get() )
+            p->setTimeout( secs );
+    }
+
     bool DBClientConnection::_connect( string& errmsg ) {
         _serverString = _server.toString();
         // we keep around SockAddr for connection life -- maybe MessagingPort
@@ -702,14 +716,19 @@ namespace mongo {
             /* connection CANNOT be used anymore as more data may be on the way from the server.
                we have to reconnect.
                */
-            _failed = true;
-            p->shutdown();
+            abandonExhaust();
             throw;
         }
 
         return n;
     }
 
+    void DBClientConnection::abandonExhaust() {
+        _failed = true;
+        if ( p )
+            p->shutdown();
+    }
+
     void DBClientBase::insert( const string & ns , BSONObj obj , int flags) {
         Message toSend;
 
@@ -909,8 +928,25 @@ namespace mongo {
         toSend.setData(dbQuery, b.buf(), b.len());
     }
 
+    /* gives an outbound operation a fresh trace id unless the calling thread
+       is already servicing a traced operation, in which case that id is
+       propagated instead (see util/net/message.h) */
+    struct ScopedTraceId {
+        bool mine;
+        ScopedTraceId() {
+            mine = currentTraceId() == 0;
+            if ( mine )
+                setCurrentTraceId( newTraceId() );
+        }
+        ~ScopedTraceId() {
+            if ( mine )
+                setCurrentTraceId( 0 );
+        }
+    };
+
     void DBClientConnection::say( Message &toSend, bool isRetry ) {
         checkConnection();
+        ScopedTraceId trace;
         try {
             port().say( toSend );
         }
@@ -933,6 +969,7 @@ namespace mongo {
                  an exception.  we should make it return void and just throw an exception anytime
                  it fails
         */
+        ScopedTraceId trace;
         try {
             if ( !port().call(toSend, response) ) {
                 _failed = true;
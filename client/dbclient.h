@@ -747,6 +747,13 @@ namespace mongo {
         WriteConcern getWriteConcern() const { return _writeConcern; }
         void setWriteConcern( WriteConcern w ) { _writeConcern = w; }
 
+        /** set a socket level timeout, in seconds, for subsequent operations
+            on this connection; 0 clears it.  an operation that hits the
+            timeout leaves the connection mid message, so the caller should
+            discard the connection rather than reuse it.  no-op for connection
+            types that aren't backed by a single socket. */
+        virtual void setSocketTimeout( double secs ) {}
+
         /** send a query to the database.
          @param ns namespace to query, format is <dbname>.<collectname>[.<collectname>]*
          @param query query to perform on the collection.  this is a BSONObj (binary JSON)
@@ -796,6 +803,11 @@ namespace mongo {
 
         virtual void killCursor( long long cursorID ) = 0;
 
+        /** called by DBClientCursor when an exhaust query is abandoned before the
+            stream is drained.  connection types that stream must override and drop
+            the connection - the unread batches make it unusable. */
+        virtual void abandonExhaust() {}
+
         virtual bool callRead( Message& toSend , Message& response ) = 0;
         // virtual bool callWrite( Message& toSend , Message& response ) = 0; // TODO: add this if needed
         
@@ -877,6 +889,11 @@ namespace mongo {
 
         virtual bool auth(const string &dbname, const string &username, const string &pwd, string& errmsg, bool digestPassword = true);
 
+        /** ask the server to enable snappy compression of messages on this
+            connection (both directions).  @return false if the server is too
+            old or refuses; the connection stays usable, just uncompressed. */
+        bool negotiateWireCompression();
+
         virtual auto_ptr<DBClientCursor> query(const string &ns, Query query=Query(), int nToReturn = 0, int nToSkip = 0,
                                                const BSONObj *fieldsToReturn = 0, int queryOptions = 0 , int batchSize = 0 ) {
             checkConnection();
@@ -913,6 +930,7 @@ namespace mongo {
         string getServerAddress() const { return _serverString; }
 
         virtual void killCursor( long long cursorID );
+        virtual void abandonExhaust();
         virtual bool callRead( Message& toSend , Message& response ) { return call( toSend , response ); }
         virtual void say( Message &toSend, bool isRetry = false );
         virtual bool recv( Message& m );
@@ -921,6 +939,7 @@ namespace mongo {
         virtual ConnectionString::ConnectionType type() const { return ConnectionString::MASTER; }
         void setSoTimeout(double to) { _so_timeout = to; }
         double getSoTimeout() const { return _so_timeout; }
+        virtual void setSocketTimeout( double secs ); // applies to the live socket too
 
         virtual bool lazySupported() const { return true; }
 
@@ -961,6 +980,54 @@ namespace mongo {
 #endif
     };
 
+    /** Accumulates documents client side and sends them as vector inserts
+        whenever a count or byte threshold is reached, so a bulk load makes one
+        round trip per batch instead of one per document.  Call flush() (or let
+        the destructor do it) to send any remainder.
+
+        Example:
+            BulkInserter bulk( conn, "test.foo" );
+            for ( ... )
+                bulk.insert( obj );
+            bulk.flush();
+    */
+    class BulkInserter : boost::noncopyable {
+    public:
+        enum { DefaultMaxDocs = 1000 , DefaultMaxBytes = 4 * 1024 * 1024 };
+        BulkInserter( DBClientInterface& conn , const string& ns , int flags = 0 ,
+                      int maxDocs = DefaultMaxDocs , int maxBytes = DefaultMaxBytes )
+            : _conn( conn ) , _ns( ns ) , _flags( flags ) ,
+              _maxDocs( maxDocs ) , _maxBytes( maxBytes ) , _bytes( 0 ) {
+        }
+        ~BulkInserter() {
+            DESTRUCTOR_GUARD( flush(); );
+        }
+        /** queue a document, sending the pending batch first if it is full */
+        void insert( const BSONObj& o ) {
+            if ( ! _docs.empty() && ( (int)_docs.size() >= _maxDocs || _bytes + o.objsize() > _maxBytes ) )
+                flush();
+            _docs.push_back( o );
+            _bytes += o.objsize();
+        }
+        /** send any pending documents */
+        void flush() {
+            if ( _docs.empty() )
+                return;
+            _conn.insert( _ns , _docs , _flags );
+            _docs.clear();
+            _bytes = 0;
+        }
+        int pending() const { return (int)_docs.size(); }
+    private:
+        DBClientInterface& _conn;
+        const string _ns;
+        const int _flags;
+        const int _maxDocs;
+        const int _maxBytes;
+        vector<BSONObj> _docs;
+        int _bytes;
+    };
+
     /** pings server to check if it's up
      */
     bool serverAlive( const string &uri );
@@ -225,13 +225,20 @@ namespace mongo {
         if( prev.host().size() ){
             scoped_lock lk( _lock );
             for ( unsigned i=0; i<_nodes.size(); i++ ) {
-                if ( prev != _nodes[i].addr ) 
+                if ( prev != _nodes[i].addr )
                     continue;
 
                 wasFound = true;
 
-                if ( _nodes[i].okForSecondaryQueries() )
-                    return prev;
+                if ( _nodes[i].okForSecondaryQueries() ) {
+                    /* stay put only while within the latency window of the
+                       nearest node, so a connection made during a blip doesn't
+                       pin a far-away secondary forever */
+                    int best = _nearestSecondary_inlock();
+                    if ( best < 0 || _nodes[i].pingTimeMillis <= _nodes[best].pingTimeMillis + _latencyWindowMillis )
+                        return prev;
+                    LOG(1) << "slave '" << prev << "' is outside the latency window, reselecting" << endl;
+                }
 
                 break;
             }
@@ -246,6 +253,19 @@ namespace mongo {
         return getSlave();
     }
 
+    int ReplicaSetMonitor::_nearestSecondary_inlock() const {
+        int best = -1;
+        for ( unsigned i=0; i<_nodes.size(); i++ ) {
+            if ( (int)i == _master )
+                continue;
+            if ( ! _nodes[i].okForSecondaryQueries() )
+                continue;
+            if ( best < 0 || _nodes[i].pingTimeMillis < _nodes[best].pingTimeMillis )
+                best = i;
+        }
+        return best;
+    }
+
     HostAndPort ReplicaSetMonitor::getSlave() {
 
         LOG(2) << "selecting new slave from replica set " << getServerAddress() << endl;
@@ -258,25 +278,44 @@ namespace mongo {
 
             {
                 scoped_lock lk( _lock );
-                
-                unsigned i = 0;
-                for ( ; i<_nodes.size(); i++ ) {
-                    _nextSlave = ( _nextSlave + 1 ) % _nodes.size();
-                    if ( _nextSlave == _master ){
-                        LOG(2) << "not selecting " << _nodes[_nextSlave] << " as it is the current master" << endl;
-                        continue;
+
+                int best = _nearestSecondary_inlock();
+                if ( best >= 0 ) {
+                    /* everything within the latency window of the nearest node is
+                       equivalent - rotate among those so close peers share the load,
+                       but never pick a node a whole datacenter further away */
+                    const int cutoff = _nodes[best].pingTimeMillis + _latencyWindowMillis;
+                    for ( unsigned i=0; i<_nodes.size(); i++ ) {
+                        _nextSlave = ( _nextSlave + 1 ) % _nodes.size();
+                        if ( _nextSlave == _master )
+                            continue;
+                        if ( ! _nodes[ _nextSlave ].okForSecondaryQueries() )
+                            continue;
+                        if ( _nodes[ _nextSlave ].pingTimeMillis <= cutoff )
+                            return _nodes[ _nextSlave ].addr;
+                        LOG(2) << "not selecting " << _nodes[_nextSlave] << " as it is outside the latency window" << endl;
+                    }
+                    return _nodes[best].addr;
+                }
+
+                if ( ( xxx + 1 ) >= MAX ) {
+                    // no usable secondary at all - take any "ok" node
+                    for ( unsigned i=0; i<_nodes.size(); i++ ) {
+                        _nextSlave = ( _nextSlave + 1 ) % _nodes.size();
+                        if ( _nextSlave == _master ){
+                            LOG(2) << "not selecting " << _nodes[_nextSlave] << " as it is the current master" << endl;
+                            continue;
+                        }
+                        if ( _nodes[ _nextSlave ].ok )
+                            return _nodes[ _nextSlave ].addr;
+                        LOG(2) << "not selecting " << _nodes[_nextSlave] << " as it is not ok to use" << endl;
                     }
-                    if ( _nodes[ _nextSlave ].okForSecondaryQueries() || ( _nodes[ _nextSlave ].ok && ( xxx + 1 ) >= MAX ) )
-                        return _nodes[ _nextSlave ].addr;
-                    
-                    LOG(2) << "not selecting " << _nodes[_nextSlave] << " as it is not ok to use" << endl;
                 }
-                
             }
 
             check(false);
         }
-        
+
         LOG(2) << "no suitable slave nodes found, returning default node " << _nodes[ 0 ] << endl;
 
         return _nodes[0].addr;
@@ -302,6 +341,19 @@ namespace mongo {
             return;
         }
 
+        // the primary's optime is the reference point for estimating secondary lag
+        Date_t primaryOptimeDate(0);
+        {
+            BSONObjIterator hi(status["members"].Obj());
+            while (hi.more()) {
+                BSONObj member = hi.next().Obj();
+                if (member["state"].Number() == 1 && member["optimeDate"].type() == Date) {
+                    primaryOptimeDate = member["optimeDate"].Date();
+                    break;
+                }
+            }
+        }
+
         BSONObjIterator hi(status["members"].Obj());
         while (hi.more()) {
             BSONObj member = hi.next().Obj();
@@ -312,14 +364,22 @@ namespace mongo {
                 continue;
             }
 
+            int lag = -1;
+            if (primaryOptimeDate.millis && member["optimeDate"].type() == Date) {
+                Date_t d = member["optimeDate"].Date();
+                lag = d.millis >= primaryOptimeDate.millis ? 0 : (int)((primaryOptimeDate.millis - d.millis) / 1000);
+            }
+
             double state = member["state"].Number();
             if (member["health"].Number() == 1 && (state == 1 || state == 2)) {
                 scoped_lock lk( _lock );
                 _nodes[m].ok = true;
+                _nodes[m].lagSeconds = lag;
             }
             else {
                 scoped_lock lk( _lock );
                 _nodes[m].ok = false;
+                _nodes[m].lagSeconds = lag;
             }
         }
     }
@@ -369,7 +429,10 @@ namespace mongo {
             }
 
             if ( nodesOffset >= 0 ) {
-                _nodes[nodesOffset].pingTimeMillis = t.millis();
+                int ping = t.millis();
+                if ( _nodes[nodesOffset].pingTimeMillis )
+                    ping = ( _nodes[nodesOffset].pingTimeMillis * 3 + ping ) / 4; // smooth out blips
+                _nodes[nodesOffset].pingTimeMillis = ping;
                 _nodes[nodesOffset].hidden = o["hidden"].trueValue();
                 _nodes[nodesOffset].secondary = o["secondary"].trueValue();
                 _nodes[nodesOffset].ismaster = o["ismaster"].trueValue();
@@ -505,7 +568,8 @@ namespace mongo {
                                 "ismaster" << _nodes[i].ismaster <<
                                 "hidden" << _nodes[i].hidden <<
                                 "secondary" << _nodes[i].secondary <<
-                                "pingTimeMillis" << _nodes[i].pingTimeMillis  ) );
+                                "pingTimeMillis" << _nodes[i].pingTimeMillis <<
+                                "lagSeconds" << _nodes[i].lagSeconds  ) );
             
         }
         hosts.done();
@@ -518,6 +582,8 @@ namespace mongo {
     mongo::mutex ReplicaSetMonitor::_setsLock( "ReplicaSetMonitor" );
     map<string,ReplicaSetMonitorPtr> ReplicaSetMonitor::_sets;
     ReplicaSetMonitor::ConfigChangeHook ReplicaSetMonitor::_hook;
+    int ReplicaSetMonitor::_latencyWindowMillis = 15;
+    int ReplicaSetMonitor::_maxLagSeconds = 0;
     // --------------------------------
     // ----- DBClientReplicaSet ---------
     // --------------------------------
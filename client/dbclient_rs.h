@@ -62,6 +62,19 @@ namespace mongo {
          */
         static void setConfigChangeHook( ConfigChangeHook hook );
 
+        /**
+         * slaveOk reads are routed to the nearest secondary; nodes within this
+         * many ms of the nearest are treated as equivalent and share the load
+         * round-robin
+         */
+        static void setLatencyWindowMillis( int ms ) { _latencyWindowMillis = ms; }
+
+        /**
+         * if > 0, secondaries estimated to be more than this many seconds
+         * behind the primary are not used for slaveOk reads
+         */
+        static void setMaxLagSeconds( int secs ) { _maxLagSeconds = secs; }
+
         ~ReplicaSetMonitor();
 
         /** @return HostAndPort or throws an exception */
@@ -136,18 +149,26 @@ namespace mongo {
         int _find_inlock( const string& server ) const ;
         int _find( const HostAndPort& server ) const ;
 
+        /** index of the lowest-ping node that is ok for secondary queries, or -1 */
+        int _nearestSecondary_inlock() const;
+
         mutable mongo::mutex _lock; // protects _nodes
         mutable mongo::mutex  _checkConnectionLock;
 
         string _name;
         struct Node {
-            Node( const HostAndPort& a , DBClientConnection* c ) 
-                : addr( a ) , conn(c) , ok(true) , 
-                  ismaster(false), secondary( false ) , hidden( false ) , pingTimeMillis(0) {
+            Node( const HostAndPort& a , DBClientConnection* c )
+                : addr( a ) , conn(c) , ok(true) ,
+                  ismaster(false), secondary( false ) , hidden( false ) , pingTimeMillis(0) , lagSeconds(-1) {
             }
 
             bool okForSecondaryQueries() const {
-                return ok && secondary && ! hidden;
+                return ok && secondary && ! hidden && ! tooFarBehind();
+            }
+
+            /** @return true if the lag exclusion option is on and this node is known to exceed it */
+            bool tooFarBehind() const {
+                return _maxLagSeconds > 0 && lagSeconds > _maxLagSeconds;
             }
 
             BSONObj toBSON() const {
@@ -176,9 +197,13 @@ namespace mongo {
             bool ismaster;
             bool secondary; 
             bool hidden;
-            
+
             int pingTimeMillis;
 
+            // estimated replication lag behind the primary, from replSetGetStatus
+            // optimes.  -1 when unknown
+            int lagSeconds;
+
         };
 
         /**
@@ -193,6 +218,9 @@ namespace mongo {
         static map<string,ReplicaSetMonitorPtr> _sets; // set name to Monitor
 
         static ConfigChangeHook _hook;
+
+        static int _latencyWindowMillis; // see setLatencyWindowMillis()
+        static int _maxLagSeconds;       // see setMaxLagSeconds(); 0 = off
     };
 
     /** Use this class to connect to a replica set of servers.  The class will manage
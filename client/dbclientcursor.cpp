@@ -101,6 +101,12 @@ namespace mongo {
     void DBClientCursor::requestMore() {
         assert( cursorId && b.pos == b.nReturned );
 
+        if ( opts & QueryOption_Exhaust ) {
+            // the server streams the batches with no getMore requests from us
+            exhaustReceiveMore();
+            return;
+        }
+
         if (haveLimit) {
             nToReturn -= b.nReturned;
             assert(nToReturn > 0);
@@ -281,6 +287,14 @@ namespace mongo {
         DESTRUCTOR_GUARD (
 
         if ( cursorId && _ownCursor && ! inShutdown() ) {
+            if ( ( opts & QueryOption_Exhaust ) && _client ) {
+                /* an exhaust stream is still arriving.  the server won't look at a
+                   killCursors message until it is done blasting, so the socket cannot
+                   be reused - drop the connection rather than hand the next caller
+                   someone else's batches. */
+                _client->abandonExhaust();
+                return;
+            }
             BufBuilder b;
             b.appendNum( (int)0 ); // reserved
             b.appendNum( (int)1 ); // number
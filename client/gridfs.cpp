@@ -33,6 +33,9 @@
 namespace mongo {
 
     const unsigned DEFAULT_CHUNK_SIZE = 256 * 1024;
+    // upload window: chunks are buffered and sent several-per-insert-message,
+    // so a big file doesn't pay a round trip per chunk
+    const unsigned MAX_PENDING_BYTES = 4 * 1024 * 1024;
 
     GridFSChunk::GridFSChunk( BSONObj o ) {
         _data = o;
@@ -73,14 +76,24 @@ namespace mongo {
         BSONObj idObj = BSON("_id" << id);
 
         int chunkNumber = 0;
+        vector<BSONObj> pending;
+        unsigned pendingBytes = 0;
         while (data < end) {
             int chunkLen = MIN(_chunkSize, (unsigned)(end-data));
             GridFSChunk c(idObj, chunkNumber, data, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            pending.push_back( c._data );
+            pendingBytes += chunkLen;
+            if ( pendingBytes >= MAX_PENDING_BYTES ) {
+                _client.insert( _chunksNS.c_str() , pending );
+                pending.clear();
+                pendingBytes = 0;
+            }
 
             chunkNumber++;
             data += chunkLen;
         }
+        if ( ! pending.empty() )
+            _client.insert( _chunksNS.c_str() , pending );
 
         return insertFile(remoteName, id, length, contentType);
     }
@@ -102,6 +115,8 @@ namespace mongo {
 
         int chunkNumber = 0;
         gridfs_offset length = 0;
+        vector<BSONObj> pending;
+        unsigned pendingBytes = 0;
         while (!feof(fd)) {
             //boost::scoped_array<char>buf (new char[_chunkSize+1]);
             char * buf = new char[_chunkSize+1];
@@ -115,13 +130,21 @@ namespace mongo {
                 assert(chunkLen <= _chunkSize);
             }
 
-            GridFSChunk c(idObj, chunkNumber, buf, chunkLen);
-            _client.insert( _chunksNS.c_str() , c._data );
+            GridFSChunk c(idObj, chunkNumber, buf, chunkLen); // copies buf into the bson
+            pending.push_back( c._data );
+            pendingBytes += chunkLen;
+            if ( pendingBytes >= MAX_PENDING_BYTES ) {
+                _client.insert( _chunksNS.c_str() , pending );
+                pending.clear();
+                pendingBytes = 0;
+            }
 
             length += chunkLen;
             chunkNumber++;
             delete[] buf;
         }
+        if ( ! pending.empty() )
+            _client.insert( _chunksNS.c_str() , pending );
 
         if (fd != stdin)
             fclose( fd );
@@ -216,13 +239,27 @@ namespace mongo {
 
         const int num = getNumChunks();
 
-        for ( int i=0; i<num; i++ ) {
-            GridFSChunk c = getChunk( i );
+        /* one cursor sorted by chunk number instead of a findOne round trip
+           per chunk - the server streams many chunks per batch so the
+           transfer is bound by bandwidth, not per-chunk latency */
+        BSONObjBuilder b;
+        b.appendAs( _obj["_id"] , "files_id" );
+        auto_ptr<DBClientCursor> cursor =
+            _grid->_client.query( _grid->_chunksNS.c_str() ,
+                                  Query( b.obj() ).sort( BSON( "n" << 1 ) ) );
+
+        int n = 0;
+        while ( cursor.get() && cursor->more() && n < num ) {
+            BSONObj o = cursor->next();
+            uassert( 15942 , "chunks out of order" , o["n"].numberInt() == n );
+            n++;
+            GridFSChunk c( o );
 
             int len;
             const char * data = c.data( len );
             out.write( data , len );
         }
+        uassert( 15943 , "not all chunks found" , n == num );
 
         return getContentLength();
     }
@@ -69,6 +69,7 @@
 #include "clientOnly.cpp"
 #include "gridfs.cpp"
 #include "dbclientcursor.cpp"
+#include "writepipeline.cpp"
 
 #include "../util/text.cpp"
 #include "dbclient_rs.cpp"
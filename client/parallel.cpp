@@ -346,6 +346,9 @@ namespace mongo {
 
     // --------  ParallelSortClusteredCursor -----------
 
+    // missing sort fields compare as null, same as woSortOrder
+    static const BSONObj _staticNull = BSON( "" << BSONNULL );
+
     ParallelSortClusteredCursor::ParallelSortClusteredCursor( const set<ServerAndQuery>& servers , QueryMessage& q ,
             const BSONObj& sortKey )
         : ClusteredCursor( q ) , _servers( servers ) {
@@ -366,6 +369,7 @@ namespace mongo {
     void ParallelSortClusteredCursor::_finishCons() {
         _numServers = _servers.size();
         _cursors = 0;
+        _mergeWinner = -1;
 
         if ( ! _sortKey.isEmpty() && ! _fields.isEmpty() ) {
             // we need to make sure the sort key is in the projection
@@ -678,34 +682,95 @@ namespace mongo {
     }
 
     BSONObj ParallelSortClusteredCursor::next() {
-        BSONObj best = BSONObj();
-        int bestFrom = -1;
+        if ( _sortKey.isEmpty() ) {
+            // no sort - just take from the first cursor with data
+            for ( int i=0; i<_numServers; i++) {
+                if ( _cursors[i].more() )
+                    return _cursors[i].next();
+            }
+            uasserted( 10019 , "no more elements" );
+        }
 
-        for ( int i=0; i<_numServers; i++) {
-            if ( ! _cursors[i].more() )
-                continue;
+        if ( _mergeTree.empty() )
+            _initMergeTree();
 
-            BSONObj me = _cursors[i].peek();
+        int best = _mergeWinner;
+        uassert( 10019 ,  "no more elements" , best >= 0 && ! _mergeKeys[best].empty() );
 
-            if ( best.isEmpty() ) {
-                best = me;
-                bestFrom = i;
-                if( _sortKey.isEmpty() ) break;
-                continue;
-            }
-
-            int comp = best.woSortOrder( me , _sortKey , true );
-            if ( comp < 0 )
-                continue;
+        BSONObj ret = _cursors[best].next();
+        _loadMergeKey( best );
+        _replayMerge( best );
+        return ret;
+    }
 
-            best = me;
-            bestFrom = i;
+    void ParallelSortClusteredCursor::_loadMergeKey( int i ) {
+        _mergeKeys[i].clear();
+        if ( ! _cursors[i].more() )
+            return;
+        BSONObj me = _cursors[i].peek();
+        BSONObjIterator f( _sortKey );
+        while ( f.more() ) {
+            BSONElement e = me.getFieldDotted( f.next().fieldName() );
+            if ( e.eoo() )
+                e = _staticNull.firstElement();
+            _mergeKeys[i].push_back( e );
         }
+    }
 
-        uassert( 10019 ,  "no more elements" , ! best.isEmpty() );
-        _cursors[bestFrom].next();
+    bool ParallelSortClusteredCursor::_mergeBefore( int a , int b ) {
+        // an empty key means the cursor is exhausted - it always loses
+        if ( _mergeKeys[a].empty() )
+            return false;
+        if ( _mergeKeys[b].empty() )
+            return true;
 
-        return best;
+        // same comparison woSortOrder does, but against the cached elements
+        BSONObjIterator i( _sortKey );
+        for ( unsigned k = 0; k < _mergeKeys[a].size(); k++ ) {
+            BSONElement f = i.next();
+            int x = _mergeKeys[a][k].woCompare( _mergeKeys[b][k] , false );
+            if ( f.number() < 0 )
+                x = -x;
+            if ( x != 0 )
+                return x < 0;
+        }
+        return a > b; // ties keep the old linear scan's pick (last equal cursor)
+    }
+
+    void ParallelSortClusteredCursor::_initMergeTree() {
+        int n = _numServers;
+        _mergeKeys.resize( n );
+        for ( int i = 0; i < n; i++ )
+            _loadMergeKey( i );
+
+        // leaf i plays its way up from node (i+n)/2.  a climber parks at an
+        // empty node; the second arrival plays it, the winner climbs on and
+        // the loser stays.  exactly one climber makes it past the root.
+        _mergeTree.assign( n , -1 );
+        _mergeWinner = -1;
+        for ( int i = 0; i < n; i++ ) {
+            int w = i;
+            for ( int node = ( i + n ) / 2; node >= 1; node /= 2 ) {
+                if ( _mergeTree[node] == -1 ) {
+                    _mergeTree[node] = w;
+                    w = -1;
+                    break;
+                }
+                if ( _mergeBefore( _mergeTree[node] , w ) )
+                    std::swap( w , _mergeTree[node] );
+            }
+            if ( w != -1 )
+                _mergeWinner = w;
+        }
+    }
+
+    void ParallelSortClusteredCursor::_replayMerge( int from ) {
+        int w = from;
+        for ( int node = ( from + _numServers ) / 2; node >= 1; node /= 2 ) {
+            if ( _mergeBefore( _mergeTree[node] , w ) )
+                std::swap( w , _mergeTree[node] );
+        }
+        _mergeWinner = w;
     }
 
     void ParallelSortClusteredCursor::_explain( map< string,list<BSONObj> >& out ) {
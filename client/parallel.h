@@ -246,6 +246,23 @@ namespace mongo {
 
         FilteringClientCursor * _cursors;
         int _needToSkip;
+
+    private:
+        /** tournament (loser tree) merge state, built lazily on the first
+            next() when there is a sort key.  _mergeTree[1..n-1] hold the
+            losers of each match; the overall winner is kept separately.
+            _mergeKeys caches the pre-extracted _sortKey elements of each
+            cursor's current document, so picking the next document costs
+            O(log n) element compares instead of a woSortOrder of the full
+            document against every shard's. */
+        void _initMergeTree();
+        void _loadMergeKey( int i );
+        bool _mergeBefore( int a , int b );
+        void _replayMerge( int from );
+
+        vector<int> _mergeTree;
+        vector< vector<BSONElement> > _mergeKeys;
+        int _mergeWinner;
     };
 
     /**
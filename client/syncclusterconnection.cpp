@@ -24,6 +24,8 @@
 
 namespace mongo {
 
+    void assembleRequest( const string &ns, BSONObj query, int nToReturn, int nToSkip, const BSONObj *fieldsToReturn, int queryOptions, Message &toSend );
+
     SyncClusterConnection::SyncClusterConnection( const list<HostAndPort> & L, double socketTimeout) : _mutex("SyncClusterConnection"), _socketTimeout( socketTimeout ) {
         {
             stringstream s;
@@ -73,49 +75,83 @@ namespace mongo {
         return fsync( errmsg );
     }
 
-    bool SyncClusterConnection::fsync( string& errmsg ) {
-        bool ok = true;
-        errmsg = "";
+    void SyncClusterConnection::_cmdOnAll( const BSONObj& cmd , vector<BSONObj>& res , vector<string>& errors ) {
+        res.resize( _conns.size() );
+        errors.resize( _conns.size() );
+
+        Message toSend;
+        assembleRequest( "admin.$cmd" , cmd , 1 , 0 , 0 , 0 , toSend );
+
+        // phase 1: get the command on the wire to every node.  say() assigns a
+        // fresh message id per send, so one Message can be reused here just as
+        // in say() below.
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            BSONObj res;
             try {
-                if ( _conns[i]->simpleCommand( "admin" , &res , "fsync" ) )
-                    continue;
+                _conns[i]->say( toSend );
             }
             catch ( DBException& e ) {
-                errmsg += e.toString();
+                errors[i] = e.toString();
             }
             catch ( std::exception& e ) {
-                errmsg += e.what();
+                errors[i] = e.what();
             }
             catch ( ... ) {
+                errors[i] = "unknown failure";
             }
-            ok = false;
-            errmsg += " " + _conns[i]->toString() + ":" + res.toString();
         }
-        return ok;
-    }
-
-    void SyncClusterConnection::_checkLast() {
-        _lastErrors.clear();
-        vector<string> errors;
 
+        // phase 2: gather the replies.  each connection has exactly one
+        // request outstanding so no id matching is needed.
         for ( size_t i=0; i<_conns.size(); i++ ) {
-            BSONObj res;
-            string err;
+            if ( ! errors[i].empty() )
+                continue;
             try {
-                if ( ! _conns[i]->runCommand( "admin" , BSON( "getlasterror" << 1 << "fsync" << 1 ) , res ) )
-                    err = "cmd failed: ";
+                Message reply;
+                if ( ! _conns[i]->recv( reply ) ) {
+                    errors[i] = "no reply";
+                    continue;
+                }
+                QueryResult * qr = (QueryResult*) reply.singleData();
+                if ( qr->nReturned < 1 ) {
+                    errors[i] = "empty reply";
+                    continue;
+                }
+                res[i] = BSONObj( qr->data() ).getOwned();
+            }
+            catch ( DBException& e ) {
+                errors[i] = e.toString();
             }
             catch ( std::exception& e ) {
-                err += e.what();
+                errors[i] = e.what();
             }
             catch ( ... ) {
-                err += "unknown failure";
+                errors[i] = "unknown failure";
             }
-            _lastErrors.push_back( res.getOwned() );
-            errors.push_back( err );
         }
+    }
+
+    bool SyncClusterConnection::fsync( string& errmsg ) {
+        bool ok = true;
+        errmsg = "";
+
+        vector<BSONObj> res;
+        vector<string> errors;
+        _cmdOnAll( BSON( "fsync" << 1 ) , res , errors );
+
+        for ( size_t i=0; i<_conns.size(); i++ ) {
+            if ( errors[i].empty() && isOk( res[i] ) )
+                continue;
+            ok = false;
+            errmsg += errors[i] + " " + _conns[i]->toString() + ":" + res[i].toString();
+        }
+        return ok;
+    }
+
+    void SyncClusterConnection::_checkLast() {
+        _lastErrors.clear();
+        vector<string> errors;
+
+        _cmdOnAll( BSON( "getlasterror" << 1 << "fsync" << 1 ) , _lastErrors , errors );
 
         assert( _lastErrors.size() == errors.size() && _lastErrors.size() == _conns.size() );
 
@@ -268,7 +304,24 @@ namespace mongo {
     }
 
     void SyncClusterConnection::insert( const string &ns, const vector< BSONObj >& v , int flags) {
-        uassert( 10023 , "SyncClusterConnection bulk insert not implemented" , 0);
+        if ( v.empty() )
+            return;
+
+        for ( size_t i=0; i<v.size(); i++ ) {
+            uassert( 15947 , (string)"SyncClusterConnection::insert obj has to have an _id: " + v[i].jsonString() ,
+                     ns.find( ".system.indexes" ) != string::npos || v[i]["_id"].type() );
+        }
+
+        string errmsg;
+        if ( ! prepare( errmsg ) )
+            throw UserException( 15948 , (string)"SyncClusterConnection::insert prepare failed: " + errmsg );
+
+        // one bulk insert message per node rather than a round trip per object
+        for ( size_t i=0; i<_conns.size(); i++ ) {
+            _conns[i]->insert( ns , v , flags );
+        }
+
+        _checkLast();
     }
 
     void SyncClusterConnection::remove( const string &ns , Query query, bool justOne ) {
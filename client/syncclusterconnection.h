@@ -107,6 +107,15 @@ namespace mongo {
         void _checkLast();
         void _connect( string host );
 
+        /**
+         * runs an admin command on every connection in parallel: the command is
+         * sent to all nodes before any reply is read, so the wait is one round
+         * trip total rather than one per node.
+         * @param res    one reply per connection (empty object if the node failed)
+         * @param errors one entry per connection; empty string if the node replied
+         */
+        void _cmdOnAll( const BSONObj& cmd , vector<BSONObj>& res , vector<string>& errors );
+
         string _address;
         vector<string> _connAddresses;
         vector<DBClientConnection*> _conns;
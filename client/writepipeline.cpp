@@ -0,0 +1,73 @@
+// writepipeline.cpp
+
+/*    Copyright 2011 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#include "pch.h"
+#include "writepipeline.h"
+
+namespace mongo {
+
+    WritePipeline::WritePipeline( DBClientBase &conn , int n , int millis )
+        : _conn( conn ) , _n( n ) , _millis( millis ) {
+        massert( 15981 , "WritePipeline batch size must be positive" , n > 0 );
+    }
+
+    WritePipeline::~WritePipeline() {
+        DESTRUCTOR_GUARD(
+            if ( _callbacks.size() )
+                flush();
+        );
+    }
+
+    void WritePipeline::insert( const string &ns , BSONObj obj , const Callback &cb , int flags ) {
+        _conn.insert( ns , obj , flags );
+        _written( cb );
+    }
+
+    void WritePipeline::update( const string &ns , Query query , BSONObj obj , const Callback &cb , bool upsert , bool multi ) {
+        _conn.update( ns , query , obj , upsert , multi );
+        _written( cb );
+    }
+
+    void WritePipeline::remove( const string &ns , Query query , const Callback &cb , bool justOne ) {
+        _conn.remove( ns , query , justOne );
+        _written( cb );
+    }
+
+    void WritePipeline::_written( const Callback &cb ) {
+        if ( _callbacks.empty() )
+            _timer.reset();
+        _callbacks.push_back( cb );
+        if ( (int)_callbacks.size() >= _n || _timer.millis() >= _millis )
+            flush();
+    }
+
+    BSONObj WritePipeline::flush() {
+        if ( _callbacks.empty() )
+            return BSONObj();
+        BSONObj res = _conn.getLastErrorDetailed();
+        // hand the batch off before dispatching so a callback that issues new
+        // writes through this pipeline starts a fresh batch
+        vector<Callback> batch;
+        batch.swap( _callbacks );
+        for ( vector<Callback>::const_iterator i = batch.begin(); i != batch.end(); ++i ) {
+            if ( *i )
+                (*i)( res );
+        }
+        return res;
+    }
+
+} // namespace mongo
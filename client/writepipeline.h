@@ -0,0 +1,85 @@
+/** @file writepipeline.h pipelined acknowledged writes */
+
+/*    Copyright 2011 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+#pragma once
+
+#include "dbclient.h"
+#include "../util/timer.h"
+
+namespace mongo {
+
+    /** Pipelines acknowledged writes on a single connection.
+
+        A caller that wants every write acknowledged normally sends getLastError
+        after each one, serializing a network round trip per document.  A
+        WritePipeline queues the acknowledgement instead: writes go out
+        immediately, a single getLastError is sent once n writes have
+        accumulated or millis ms have passed since the first unconfirmed write,
+        and the result is handed to the callback attached to each write in the
+        batch.
+
+        getLastError describes the connection state after the last operation
+        only, so an error cannot be attributed to an individual write within a
+        batch; every callback in the affected batch receives the same result
+        object.  Use a smaller batch size when finer attribution matters.
+
+        Not thread safe - use from one thread, like the underlying connection.
+        The time limit is checked as writes are issued; an idle pipeline does
+        not flush until flush() is called or it is destroyed.
+
+        example:
+            WritePipeline p( c , 100 , 50 );
+            for ( ... )
+                p.insert( "foo.bar" , obj , myCallback );
+            p.flush();
+    */
+    class WritePipeline : boost::noncopyable {
+    public:
+        /** receives the getLastError result covering the write's batch */
+        typedef boost::function<void(const BSONObj&)> Callback;
+
+        /** @param n send a getLastError after this many unconfirmed writes
+            @param millis ... or when the oldest unconfirmed write is this old
+        */
+        WritePipeline( DBClientBase &conn , int n = 100 , int millis = 50 );
+
+        /** flushes anything still queued; errors are logged, not thrown */
+        ~WritePipeline();
+
+        void insert( const string &ns , BSONObj obj , const Callback &cb = Callback() , int flags = 0 );
+        void update( const string &ns , Query query , BSONObj obj , const Callback &cb = Callback() , bool upsert = false , bool multi = false );
+        void remove( const string &ns , Query query , const Callback &cb = Callback() , bool justOne = false );
+
+        /** send getLastError for everything queued and run the callbacks.
+            @return the getLastError result, or an empty object if nothing was queued
+        */
+        BSONObj flush();
+
+        /** @return number of writes issued but not yet confirmed */
+        int pending() const { return (int)_callbacks.size(); }
+
+    private:
+        void _written( const Callback &cb );
+
+        DBClientBase &_conn;
+        int _n;
+        int _millis;
+        vector<Callback> _callbacks;
+        Timer _timer; // since the first unconfirmed write
+    };
+
+} // namespace mongo
@@ -48,6 +48,7 @@ namespace mongo {
 
     private:
         NamespaceString _ns;
+        static mongo::mutex m; // so dump() can run without any db lock
         static map<string, unsigned> dbsInProg;
         static set<string> nsInProg;
     };
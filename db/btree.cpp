@@ -192,7 +192,10 @@ namespace mongo {
             wassert( foo >= 0 && this->n < Size() );
             foo = this->emptySize;
             wassert( foo >= 0 && this->emptySize < V::BucketSize );
-            wassert( this->topSize >= this->n && this->topSize <= V::BucketSize );
+            // when keys share data bytes topSize can legally be less than n, but an
+            // unshared bucket storing less than a byte per key has corrupt accounting
+            foo = this->topSize;
+            wassert( foo >= ( ( this->flags & SharedKeyData ) ? 0 : this->n ) && this->topSize <= V::BucketSize );
         }
 
         // this is very slow so don't do often
@@ -323,23 +326,54 @@ namespace mongo {
         this->nextChild = kn.prevChildBucket;
 
         this->n--;
-        // This is risky because the key we are returning points to this unalloc'ed memory,
-        // and we are assuming that the last key points to the last allocated
-        // bson region.
         this->emptySize += sizeof(_KeyNode);
-        _unalloc(keysize);
+        if ( this->n > 0 && k(this->n-1).keyDataOfs() == k(this->n).keyDataOfs() ) {
+            // popped key shared its data bytes with the new last key - leave them allocated
+        }
+        else {
+            // This is risky because the key we are returning points to this unalloc'ed memory,
+            // and we are assuming that the last key points to the last allocated
+            // bson region.
+            _unalloc(keysize);
+        }
+    }
+
+    /**
+     * duplicate key compression: equal keys sort adjacent in a bucket, so a key whose
+     * data bytes are identical to a neighbor's can point at the neighbor's data rather
+     * than storing a second copy.  readers just follow keyDataOfs as always, so buckets
+     * with shared key data remain readable by code unaware of sharing.  _pack() preserves
+     * sharing and reclaims data bytes no _KeyNode references any more.
+     *
+     * @return data offset of a key adjacent to keypos with data bytes identical to
+     * 'key', or -1 if none.  only positions keypos-1 and keypos can qualify since the
+     * bucket is sorted.
+     */
+    template< class V >
+    short BucketBasics<V>::_sharedKeyDataOfs( int keypos, const Key& key ) const {
+        for( int j = keypos - 1; j <= keypos; ++j ) {
+            if ( j < 0 || j >= this->n )
+                continue;
+            const KeyNode kn = keyNode(j);
+            if ( kn.key.dataSize() == key.dataSize() &&
+                    memcmp( kn.key.data(), key.data(), key.dataSize() ) == 0 ) {
+                return k(j).keyDataOfs();
+            }
+        }
+        return -1;
     }
 
     /** add a key.  must be > all existing.  be careful to set next ptr right. */
     template< class V >
     bool BucketBasics<V>::_pushBack(const DiskLoc recordLoc, const Key& key, const Ordering &order, const DiskLoc prevChild) {
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        short sharedOfs = _sharedKeyDataOfs( this->n, key );
+        int bytesNeeded = ( sharedOfs >= 0 ? 0 : key.dataSize() ) + sizeof(_KeyNode);
         if ( bytesNeeded > this->emptySize )
             return false;
         assert( bytesNeeded <= this->emptySize );
         if( this->n ) {
             const KeyNode klast = keyNode(this->n-1);
-            if(  klast.key.woCompare(key, order) > 0 ) { 
+            if(  klast.key.woCompare(key, order) > 0 ) {
                 log() << "btree bucket corrupt? consider reindexing or running validate command" << endl;
                 log() << "  klast: " << keyNode(this->n-1).key.toString() << endl;
                 log() << "  key:   " << key.toString() << endl;
@@ -351,10 +385,16 @@ namespace mongo {
         _KeyNode& kn = k(this->n++);
         kn.prevChildBucket = prevChild;
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs( (short) _alloc(key.dataSize()) );
-        short ofs = kn.keyDataOfs();
-        char *p = dataAt(ofs);
-        memcpy(p, key.data(), key.dataSize());
+        if ( sharedOfs >= 0 ) {
+            kn.setKeyDataOfs( sharedOfs );
+            this->flags |= SharedKeyData;
+        }
+        else {
+            kn.setKeyDataOfs( (short) _alloc(key.dataSize()) );
+            short ofs = kn.keyDataOfs();
+            char *p = dataAt(ofs);
+            memcpy(p, key.data(), key.dataSize());
+        }
 
         return true;
     }
@@ -370,9 +410,12 @@ namespace mongo {
     template< class V >
     bool BucketBasics<V>::basicInsert(const DiskLoc thisLoc, int &keypos, const DiskLoc recordLoc, const Key& key, const Ordering &order) const {
         assert( keypos >= 0 && keypos <= this->n );
-        int bytesNeeded = key.dataSize() + sizeof(_KeyNode);
+        short sharedOfs = _sharedKeyDataOfs( keypos, key );
+        int bytesNeeded = ( sharedOfs >= 0 ? 0 : key.dataSize() ) + sizeof(_KeyNode);
         if ( bytesNeeded > this->emptySize ) {
             _pack(thisLoc, order, keypos);
+            sharedOfs = _sharedKeyDataOfs( keypos, key ); // data offsets moved
+            bytesNeeded = ( sharedOfs >= 0 ? 0 : key.dataSize() ) + sizeof(_KeyNode);
             if ( bytesNeeded > this->emptySize )
                 return false;
         }
@@ -402,10 +445,18 @@ namespace mongo {
         _KeyNode& kn = b->k(keypos);
         kn.prevChildBucket.Null();
         kn.recordLoc = recordLoc;
-        kn.setKeyDataOfs((short) b->_alloc(key.dataSize()) );
-        char *p = b->dataAt(kn.keyDataOfs());
-        getDur().declareWriteIntent(p, key.dataSize());
-        memcpy(p, key.data(), key.dataSize());
+        if ( sharedOfs >= 0 ) {
+            // identical data bytes already present in an adjacent key - share them
+            kn.setKeyDataOfs( sharedOfs );
+            getDur().declareWriteIntent( &b->flags, sizeof(b->flags) );
+            b->flags |= SharedKeyData;
+        }
+        else {
+            kn.setKeyDataOfs((short) b->_alloc(key.dataSize()) );
+            char *p = b->dataAt(kn.keyDataOfs());
+            getDur().declareWriteIntent(p, key.dataSize());
+            memcpy(p, key.data(), key.dataSize());
+        }
         return true;
     }
 
@@ -423,12 +474,24 @@ namespace mongo {
         if ( this->flags & Packed ) {
 	  return V::BucketSize - this->emptySize - headerSize();
         }
+        // keys sharing data bytes are stored once no matter how they are
+        // interleaved with other keys - must match the copy logic in
+        // _packReadyForMod().  counted[] is indexed by data offset.
+        bool counted[V::BucketSize];
+        for( int j = 0; j < this->n; ++j ) {
+            counted[ k( j ).keyDataOfs() ] = false;
+        }
         int size = 0;
         for( int j = 0; j < this->n; ++j ) {
             if ( mayDropKey( j, refPos ) ) {
                 continue;
             }
-            size += keyNode( j ).key.dataSize() + sizeof( _KeyNode );
+            size += sizeof( _KeyNode );
+            short dataOfs = k( j ).keyDataOfs();
+            if ( !counted[ dataOfs ] ) {
+                counted[ dataOfs ] = true;
+                size += keyNode( j ).key.dataSize();
+            }
         }
         return size;
     }
@@ -462,9 +525,20 @@ namespace mongo {
 
         int tdz = totalDataSize();
         char temp[V::BucketSize];
+        // old data ofs -> new data ofs for data bytes already copied into temp.
+        // keys sharing data bytes keep sharing after the pack no matter how the
+        // sharers are interleaved with other keys, so packing never grows
+        // topSize.  sharing is only ever established between byte identical
+        // keys (see _sharedKeyDataOfs()), so equal old offsets imply equal
+        // sizes.  indexed by data offset; -1 means not copied yet.
+        short newOfs[V::BucketSize];
+        for ( int j = 0; j < this->n; j++ ) {
+            newOfs[ k(j).keyDataOfs() ] = -1;
+        }
         int ofs = tdz;
         this->topSize = 0;
         int i = 0;
+        bool anyShared = false;
         for ( int j = 0; j < this->n; j++ ) {
             if( mayDropKey( j, refPos ) ) {
                 continue; // key is unused and has no children - drop it
@@ -476,11 +550,19 @@ namespace mongo {
                 k( i ) = k( j );
             }
             short ofsold = k(i).keyDataOfs();
-            int sz = keyNode(i).key.dataSize();
-            ofs -= sz;
-            this->topSize += sz;
-            memcpy(temp+ofs, dataAt(ofsold), sz);
-            k(i).setKeyDataOfsSavingUse( ofs );
+            if ( newOfs[ofsold] >= 0 ) {
+                // data bytes already copied for an earlier key - keep sharing
+                k(i).setKeyDataOfsSavingUse( newOfs[ofsold] );
+                anyShared = true;
+            }
+            else {
+                int sz = keyNode(i).key.dataSize();
+                ofs -= sz;
+                this->topSize += sz;
+                memcpy(temp+ofs, dataAt(ofsold), sz);
+                k(i).setKeyDataOfsSavingUse( ofs );
+                newOfs[ofsold] = (short) ofs;
+            }
             ++i;
         }
         if ( refPos == this->n ) {
@@ -499,6 +581,12 @@ namespace mongo {
             assert( foo >= 0 );
         }
 
+        if ( anyShared ) {
+            this->flags |= SharedKeyData;
+        }
+        else {
+            this->flags &= ~SharedKeyData;
+        }
         setPacked();
 
         assertValid( order );
@@ -735,12 +823,20 @@ namespace mongo {
         recordLoc = rl;
         globalIndexCounters.btree( (char*)this );
 
-        // binary search for this key
+        // binary search for this key.  the _KeyNode array at the front of the
+        // bucket is contiguous, but the key bytes it points at are scattered
+        // through the bucket body, so each probe is typically a cache miss.
+        // the next probe is one of the two quarter points; start those key
+        // bytes toward cache while we compare the current key.
         bool dupsChecked = false;
         int l=0;
         int h=this->n-1;
         while ( l <= h ) {
             int m = (l+h)/2;
+            if ( h - l > 3 ) {
+                prefetch( (void*)( this->data + this->k( (l+m-1)/2 ).keyDataOfs() ) );
+                prefetch( (void*)( this->data + this->k( (m+1+h)/2 ).keyDataOfs() ) );
+            }
             KeyNode M = this->keyNode(m);
             int x = key.woCompare(M.key, order);
             if ( x == 0 ) {
@@ -1494,6 +1590,24 @@ namespace mongo {
         return DiskLoc();
     }
 
+    template< class V >
+    void BtreeBucket<V>::prefetchSiblings(const DiskLoc& thisLoc, int direction, int n) const {
+        if ( this->parent.isNull() )
+            return;
+        const BtreeBucket *p = BTREE(this->parent);
+        int pos = indexInParent( thisLoc );
+        for ( int i = 0; i < n; i++ ) {
+            pos += direction;
+            if ( pos < 0 || pos > p->n )
+                break;
+            DiskLoc sib = p->childForPos( pos );
+            if ( sib.isNull() )
+                break;
+            // computes the mapped address without reading the bucket itself
+            MAdvise::willNeed( (void *) BTREE(sib) , V::BucketSize );
+        }
+    }
+
     template< class V >
     DiskLoc BtreeBucket<V>::locate(const IndexDetails& idx, const DiskLoc& thisLoc, const BSONObj& key, const Ordering &order, int& pos, bool& found, const DiskLoc &recordLoc, int direction) const {
         KeyOwned k(key);
@@ -1748,6 +1862,41 @@ namespace mongo {
         _log() << "\n" << indent << "  " << hex << this->nextChild.getOfs() << dec << endl;
     }
 
+    /* append-mostly workloads (timestamps, ObjectIds) put nearly every new
+       key after all existing ones, yet still paid a key-compare descent from
+       the root per insert.  one comparison against our own last key detects
+       the case; the rightmost spine is then followed by child pointers alone.
+       stateless, so there is no cached position to invalidate when another
+       writer splits buckets between calls. */
+    template< class V >
+    bool BtreeBucket<V>::appendRightmost(const DiskLoc thisLoc, const DiskLoc recordLoc,
+                                         const Key& key, const Ordering &order, IndexDetails& idx) const {
+        if ( this->n == 0 )
+            return false;
+
+        // a random insert falls out here, having cost one comparison
+        if ( key.woCompare( keyNode(this->n - 1).key, order ) <= 0 )
+            return false;
+
+        DiskLoc loc = thisLoc;
+        const BtreeBucket *b = this;
+        while ( !b->nextChild.isNull() ) {
+            loc = b->nextChild;
+            b = BTREE(loc);
+        }
+
+        if ( b != this ) {
+            if ( b->n == 0 )
+                return false;
+            // ties (dup keys) take the regular path with its dup handling
+            if ( key.woCompare( b->keyNode(b->n - 1).key, order ) <= 0 )
+                return false;
+        }
+
+        b->insertHere( loc, b->n, recordLoc, key, order, DiskLoc(), DiskLoc(), idx );
+        return true;
+    }
+
     /** todo: meaning of return code unclear clean up */
     template< class V >
     int BtreeBucket<V>::bt_insert(const DiskLoc thisLoc, const DiskLoc recordLoc,
@@ -1763,7 +1912,9 @@ namespace mongo {
             }
         }
 
-        int x = _insert(thisLoc, recordLoc, key, order, dupsAllowed, DiskLoc(), DiskLoc(), idx);
+        int x = 0;
+        if ( !toplevel || !appendRightmost(thisLoc, recordLoc, key, order, idx) )
+            x = _insert(thisLoc, recordLoc, key, order, dupsAllowed, DiskLoc(), DiskLoc(), idx);
         this->assertValid( order );
 
         return x;
@@ -406,6 +406,13 @@ namespace mongo {
          *  - Otherwise false is returned and there is no change.
          */
         bool _pushBack(const DiskLoc recordLoc, const Key& key, const Ordering &order, const DiskLoc prevChild);
+
+        /**
+         * @return data offset of a key adjacent to keypos whose data bytes exactly
+         * match 'key', for duplicate key data sharing, or -1 if there is none.
+         */
+        short _sharedKeyDataOfs( int keypos, const Key& key ) const;
+
         void pushBack(const DiskLoc recordLoc, const Key& key, const Ordering &order, const DiskLoc prevChild) {
             bool ok = _pushBack( recordLoc , key , order , prevChild );
             assert(ok);
@@ -449,8 +456,12 @@ namespace mongo {
         /* !Packed means there is deleted fragment space within the bucket.
            We "repack" when we run out of space before considering the node
            to be full.
+           SharedKeyData means some keys in the bucket may point at the same
+           data bytes (see _sharedKeyDataOfs()), so topSize can legally be
+           smaller than the sum of the keys' data sizes.  _packReadyForMod()
+           clears the flag again when no sharing remains.
            */
-        enum Flags { Packed=1 };
+        enum Flags { Packed=1, SharedKeyData=2 };
 
         /** n == 0 is ok */
         const Loc& childForPos(int p) const { return p == this->n ? this->nextChild : k(p).prevChildBucket; }
@@ -720,6 +731,14 @@ namespace mongo {
         /** Advance in specified direction to the specified key */
         void advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) const;
 
+        /**
+         * Advise the OS that the next n sibling buckets in the given direction
+         * will be needed soon, so their page faults overlap with work on this
+         * bucket.  The siblings' DiskLocs come from the (already resident)
+         * parent, so nothing is touched synchronously.  Best effort.
+         */
+        void prefetchSiblings(const DiskLoc& thisLoc, int direction, int n) const;
+
         /** Locate a key with fields comprised of a combination of keyBegin fields and keyEnd fields. */
         void customLocate(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, pair< DiskLoc, int > &bestParent ) const;
 
@@ -937,6 +956,16 @@ namespace mongo {
                     const Key& key, const Ordering &order, bool dupsAllowed,
                     const DiskLoc lChild, const DiskLoc rChild, IndexDetails &idx) const;
 
+        /**
+         * Append fast path for in-order keys: if key sorts strictly after
+         * every key in the tree, insert it into the rightmost leaf directly,
+         * following child pointers only and skipping the per-level binary
+         * searches of a full descent.  Must be called on the head bucket.
+         * @return true if the key was inserted
+         */
+        bool appendRightmost(const DiskLoc thisLoc, const DiskLoc recordLoc,
+                             const Key& key, const Ordering &order, IndexDetails &idx) const;
+
         bool find(const IndexDetails& idx, const Key& key, const DiskLoc &recordLoc, const Ordering &order, int& pos, bool assertIfDup) const;        
         bool customFind( int l, int h, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction, DiskLoc &thisLoc, int &keyOfs, pair< DiskLoc, int > &bestParent ) const;
         static void findLargestKey(const DiskLoc& thisLoc, DiskLoc& largestLoc, int& largestKey);
@@ -1018,7 +1047,10 @@ namespace mongo {
             return false;
         }
 
-        virtual bool modifiedKeys() const { return _multikey; }
+        /** multikey traversal produces dup keys; typed indexes (e.g. hashed)
+            store a transformation of the document's value, so their keys can't
+            be used to reconstruct fields either.  see definition. */
+        virtual bool modifiedKeys() const;
         virtual bool isMultiKey() const { return _multikey; }
 
         /*const _KeyNode& _currKeyNode() const {
@@ -1053,6 +1085,11 @@ namespace mongo {
 
         void forgetEndKey() { endKey = BSONObj(); }
 
+        /** seek to the first used key whose first prefixLen fields compare greater
+            than the corresponding fields of the current key.  this is a key-level
+            hop - no document is touched - for distinct()-style skip scans. */
+        void advancePastPrefix( int prefixLen );
+
         virtual CoveredIndexMatcher *matcher() const { return _matcher.get(); }
         virtual shared_ptr< CoveredIndexMatcher > matcherPtr() const { return _matcher; }
 
@@ -1084,6 +1121,11 @@ namespace mongo {
         virtual DiskLoc _locate(const BSONObj& key, const DiskLoc& loc) = 0;
         virtual DiskLoc _advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller) = 0;
         virtual void _advanceTo(DiskLoc &thisLoc, int &keyOfs, const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive, const Ordering &order, int direction ) = 0;
+        virtual void _prefetchSiblings() = 0;
+
+        // after this many consecutive bucket crossings we treat the scan as a
+        // range scan and start hinting upcoming sibling buckets to the OS
+        enum { PrefetchMinBuckets = 2, PrefetchBuckets = 3 };
 
         /** set initial bucket */
         void init();
@@ -1112,6 +1154,7 @@ namespace mongo {
         shared_ptr< CoveredIndexMatcher > _matcher;
         bool _independentFieldRanges;
         long long _nscanned;
+        int _sequentialBuckets; // consecutive bucket crossings while advancing
     };
 
     /** Renames the index namespace for this btree's index. */
@@ -22,6 +22,7 @@
 #include "jsobj.h"
 #include "curop-inl.h"
 #include "queryutil.h"
+#include "stats/indexstats.h"
 
 namespace mongo {
 
@@ -157,6 +158,9 @@ namespace mongo {
         virtual DiskLoc _advance(const DiskLoc& thisLoc, int& keyOfs, int direction, const char *caller) {
             return thisLoc.btree<V>()->advance(thisLoc, keyOfs, direction, caller);
         }
+        virtual void _prefetchSiblings() {
+            bucket.btree<V>()->prefetchSiblings( bucket, _direction, PrefetchBuckets );
+        }
         virtual void _audit() {
             out() << "BtreeCursor(). dumping head bucket" << endl;
             indexDetails.head.btree<V>()->dump();
@@ -250,6 +254,9 @@ namespace mongo {
         }
         c->init();
         dassert( c->_dups.size() == 0 );
+        IndexUsage::global.noteAccess( _id.indexNamespace() );
+        // btree probes land on scattered buckets - turn kernel readahead off
+        cc().database()->getFile( _id.head.a() )->flagAccessPattern( MAdvise::Random );
         return c;
     }
 
@@ -258,6 +265,8 @@ namespace mongo {
         const shared_ptr< FieldRangeVector > &_bounds, int _direction )
     {
         int v = _id.version();
+        IndexUsage::global.noteAccess( _id.indexNamespace() );
+        cc().database()->getFile( _id.head.a() )->flagAccessPattern( MAdvise::Random );
         if( v == 1 )
             return new BtreeCursorImpl<V1>(_d,_idxNo,_id,_bounds,_direction);
         if( v == 0 )
@@ -283,7 +292,8 @@ namespace mongo {
         _direction( _direction ),
         _spec( _id.getSpec() ),
         _independentFieldRanges( false ),
-        _nscanned( 0 ) {
+        _nscanned( 0 ),
+        _sequentialBuckets( 0 ) {
         audit();
     }
 
@@ -300,7 +310,8 @@ namespace mongo {
         _boundsIterator( new FieldRangeVectorIterator( *_bounds  ) ),
         _spec( _id.getSpec() ),
         _independentFieldRanges( true ),
-        _nscanned( 0 ) {
+        _nscanned( 0 ),
+        _sequentialBuckets( 0 ) {
         massert( 13384, "BtreeCursor FieldRangeVector constructor doesn't accept special indexes", !_spec.getType() );
         audit();
         startKey = _bounds->startKey();
@@ -312,7 +323,15 @@ namespace mongo {
 
     /** Properly destroy forward declared class members. */
     BtreeCursor::~BtreeCursor() {}
-    
+
+    bool BtreeCursor::modifiedKeys() const {
+        /* typed indexes (hashed, geo) store a transformation of the document's
+           values, so the matcher must always look at the full document for them,
+           and covered (index only) query plans must not be used. */
+        return _multikey || _spec.getType() != 0;
+    }
+
+
     void BtreeCursor::audit() {
         dassert( d->idxNo((IndexDetails&) indexDetails) == idxNo );
     }
@@ -330,6 +349,18 @@ namespace mongo {
         checkEnd();
     }
 
+    void BtreeCursor::advancePastPrefix( int prefixLen ) {
+        if ( !ok() )
+            return;
+        // with afterKey true the fields past prefixLen are never examined, so
+        // empty end vectors are fine even for compound indexes
+        vector< const BSONElement * > keyEnd;
+        vector< bool > keyEndInclusive;
+        advanceTo( currKey(), prefixLen, true, keyEnd, keyEndInclusive );
+        skipUnusedKeys();
+        checkEnd();
+    }
+
     void BtreeCursor::skipAndCheck() {
         int startNscanned = _nscanned;
         skipUnusedKeys();
@@ -387,6 +418,7 @@ namespace mongo {
     }
 
     void BtreeCursor::advanceTo( const BSONObj &keyBegin, int keyBeginLen, bool afterKey, const vector< const BSONElement * > &keyEnd, const vector< bool > &keyEndInclusive) {
+        _sequentialBuckets = 0; // a seek breaks the run of adjacent buckets
         _advanceTo( bucket, keyOfs, keyBegin, keyBeginLen, afterKey, keyEnd, keyEndInclusive, _ordering, _direction );
     }
 
@@ -395,7 +427,16 @@ namespace mongo {
         if ( bucket.isNull() )
             return false;
 
+        DiskLoc before = bucket;
         bucket = _advance(bucket, keyOfs, _direction, "BtreeCursor::advance");
+        if ( bucket != before && !bucket.isNull() ) {
+            /* crossed into another bucket.  once that has happened a few times
+               in a row this looks like a range scan, so hint upcoming sibling
+               buckets to the OS - their page faults then overlap with
+               assembling results from this one. */
+            if ( ++_sequentialBuckets >= PrefetchMinBuckets )
+                _prefetchSiblings();
+        }
 
         if ( !_independentFieldRanges ) {
             skipUnusedKeys();
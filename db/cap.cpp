@@ -177,6 +177,15 @@ namespace mongo {
                 ret = i;
                 break;
             }
+            if ( cappedSlotSize && i.drec()->lengthWithHeaders == len &&
+                    ( i != cappedFirstDeletedInCurExtent() || nextIsInCapExtent( i ) ) ) {
+                // uniform slot mode: an exact fit leaves no sliver behind, so we may only
+                // take this DR if the extent keeps another one - otherwise the extent
+                // would vanish from cappedListOfAllDeletedRecords().  cappedAlloc() will
+                // free up a second slot and retry if we pass here.
+                ret = i;
+                break;
+            }
         }
 
         /* unlink ourself from the deleted list */
@@ -251,7 +260,11 @@ namespace mongo {
 
             DiskLoc fr = theCapExtent()->firstRecord;
             theDataFileMgr.deleteRecord(ns, fr.rec(), fr, true); // ZZZZZZZZZZZZ
-            compact();
+            // uniform slot mode skips this: the freed record exact-fits the next
+            // insert as-is, so the O(n^2) coalescing pass isn't needed on every
+            // wrap-around delete.
+            if ( !cappedSlotSize )
+                compact();
             if( ++passes > maxPasses ) {
                 log() << "passes ns:" << ns << " len:" << len << " maxPasses: " << maxPasses << '\n';
                 log() << "passes max:" << max << " nrecords:" << stats.nrecords << " datasize: " << stats.datasize << endl;
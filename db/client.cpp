@@ -32,6 +32,7 @@
 #include "dbwebserver.h"
 #include "../util/mongoutils/html.h"
 #include "../util/mongoutils/checksum.h"
+#include "../util/mongoutils/str.h"
 #include "../util/file_allocator.h"
 #include "repl/rs.h"
 #include "../scripting/engine.h"
@@ -99,6 +100,7 @@ namespace mongo {
         _shutdown(false),
         _desc(desc),
         _god(0),
+        _opPriority(0),
         _lastOp(0),
         _mp(p) {
         _connectionId = setThreadName(desc);
@@ -155,6 +157,15 @@ namespace mongo {
 
     BSONObj CachedBSONObj::_tooBig = fromjson("{\"$msg\":\"query not recording (too large)\"}");
     AtomicUInt CurOp::_nextOpNum;
+    long long CurOp::maxOpMemoryBytes = 0; // 0 = no limit; setParameter maxOpMemoryMB
+
+    void CurOp::noteMemUsed( long long bytes ) {
+        _memUsed += bytes;
+        if ( maxOpMemoryBytes && _memUsed > maxOpMemoryBytes ) {
+            uasserted( 15996 , str::stream() << "operation exceeded memory limit: used " << _memUsed
+                       << " bytes, cap is " << maxOpMemoryBytes << " (maxOpMemoryMB)" );
+        }
+    }
 
     Client::Context::Context( string ns , Database * db, bool doauth )
         : _client( currentClient.get() ) , _oldContext( _client->_context ) ,
@@ -405,6 +416,9 @@ namespace mongo {
 
         b.append( "op" , opToString( _op ) );
 
+        if ( _debug.traceId )
+            b.appendNumber( "traceid" , (long long) _debug.traceId );
+
         b.append("ns", _ns);
 
         _query.append( b , "query" );
@@ -437,11 +451,17 @@ namespace mongo {
             }
         }
 
-        if( killed() ) 
+        if( killed() )
             b.append("killed", true);
+
+        if( isLowPriority() )
+            b.append("lowPriority", true);
         
         b.append( "numYields" , _numYields );
 
+        if( _memUsed )
+            b.appendNumber( "memUsed" , _memUsed );
+
         return b.obj();
     }
 
@@ -550,22 +570,10 @@ namespace mongo {
     } clientListPlugin;
 
     int Client::recommendedYieldMicros( int * writers , int * readers ) {
-        int num = 0;
-        int w = 0;
-        int r = 0;
-        {
-            scoped_lock bl(clientsMutex);
-            for ( set<Client*>::iterator i=clients.begin(); i!=clients.end(); ++i ) {
-                Client* c = *i;
-                if ( c->curop()->isWaitingForLock() ) {
-                    num++;
-                    if ( c->curop()->getLockType() > 0 )
-                        w++;
-                    else
-                        r++;
-                }
-            }
-        }
+        // queue depth straight off the lock - no need to walk every Client
+        // under clientsMutex to find out who is waiting
+        int w = dbMutex.writersWaiting();
+        int r = dbMutex.readersWaiting();
 
         if ( writers )
             *writers = w;
@@ -575,6 +583,11 @@ namespace mongo {
         int time = r * 100;
         time += w * 500;
 
+        // low priority ops stay off the lock longer per waiter, so the
+        // waiters get several turns before we take ours again
+        if ( time > 0 && haveClient() && cc().curop()->isLowPriority() )
+            time *= 4;
+
         time = min( time , 1000000 );
 
         // there has been a kill request for this op - we should yield to allow the op to stop
@@ -612,6 +625,7 @@ namespace mongo {
 
         op = 0;
         iscommand = false;
+        traceId = 0;
         ns = "";
         query = BSONObj();
         updateobj = BSONObj();
@@ -686,6 +700,8 @@ namespace mongo {
         OPDEBUG_TOSTRING_HELP( nreturned );
         if ( responseLength )
             s << " reslen:" << responseLength;
+        if ( traceId )
+            s << " traceid:" << traceId;
         s << " " << executionTime << "ms";
 
         return s.str();
@@ -723,6 +739,8 @@ namespace mongo {
         
         OPDEBUG_APPEND_NUMBER( nreturned );
         OPDEBUG_APPEND_NUMBER( responseLength );
+        if ( traceId )
+            b.appendNumber( "traceid" , (long long) traceId );
         b.append( "millis" , executionTime );
         
     }
@@ -81,6 +81,10 @@ namespace mongo {
         AuthenticationInfo * getAuthenticationInfo() { return &_ai; }
         bool isAdmin() { return _ai.isAuthorized( "admin" ); }
         CurOp* curop() const { return _curOp; }
+        /** default scheduling priority for ops run by this client - each new
+            CurOp picks this up.  see CurOp::Priority. */
+        int opPriority() const { return _opPriority; }
+        void setOpPriority( int p ) { _opPriority = p; }
         Context* getContext() const { return _context; }
         Database* database() const {  return _context ? _context->db() : 0; }
         const char *ns() const { return _context->ns(); }
@@ -107,6 +111,7 @@ namespace mongo {
         bool _shutdown;
         const char *_desc;
         bool _god;
+        int _opPriority;
         AuthenticationInfo _ai;
         ReplTime _lastOp;
         BSONObj _handshake;
@@ -28,28 +28,42 @@
 #include <time.h>
 #include "db.h"
 #include "commands.h"
+#include "ops/query.h"
 #include "repl_block.h"
 #include "../util/processinfo.h"
 
 namespace mongo {
 
-    CCById ClientCursor::clientCursorsById;
-    boost::recursive_mutex& ClientCursor::ccmutex( *(new boost::recursive_mutex()) );
+    ClientCursor::IdShard ClientCursor::_idShards[ClientCursor::NumIdShards];
     long long ClientCursor::numberTimedOut = 0;
 
     void aboutToDeleteForSharding( const Database* db , const DiskLoc& dl ); // from s/d_logic.h
 
     /*static*/ void ClientCursor::assertNoCursors() {
-        recursive_scoped_lock lock(ccmutex);
-        if( clientCursorsById.size() ) {
+        if( numCursors() ) {
             log() << "ERROR clientcursors exist but should not at this point" << endl;
-            ClientCursor *cc = clientCursorsById.begin()->second;
-            log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
-            clientCursorsById.clear();
+            for ( unsigned sh = 0; sh < NumIdShards; sh++ ) {
+                recursive_scoped_lock lock( _idShards[sh].mx );
+                CCById& m = _idShards[sh].byId;
+                if ( m.size() ) {
+                    ClientCursor *cc = m.begin()->second;
+                    log() << "first one: " << cc->_cursorid << ' ' << cc->_ns << endl;
+                }
+                m.clear();
+            }
             assert(false);
         }
     }
 
+    unsigned ClientCursor::numCursors() {
+        unsigned n = 0;
+        for ( unsigned sh = 0; sh < NumIdShards; sh++ ) {
+            recursive_scoped_lock lock( _idShards[sh].mx );
+            n += _idShards[sh].byId.size();
+        }
+        return n;
+    }
+
 
     void ClientCursor::setLastLoc_inlock(DiskLoc L) {
         assert( _pos != -2 ); // defensive - see ~ClientCursor
@@ -83,53 +97,45 @@ namespace mongo {
 
         bool isDB = (dot == &ns[len-1]); // first (and only) dot is the last char
 
-        {
-            //cout << "\nTEMP invalidate " << ns << endl;
-            recursive_scoped_lock lock(ccmutex);
-
-            Database *db = cc().database();
-            assert(db);
-            assert( str::startsWith(ns, db->name) );
-
-            for( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end(); /*++i*/ ) {
+        Database *db = cc().database();
+        assert(db);
+        assert( str::startsWith(ns, db->name) );
+
+        /* collect ids shard by shard, then claim and delete each outside the
+           shard mutexes.  we hold the write lock, so no new cursors for this
+           ns can appear and a concurrent erase() (which takes a read lock
+           before claiming) cannot interleave. */
+        vector<CursorId> toDelete;
+        for ( unsigned sh = 0; sh < NumIdShards; sh++ ) {
+            recursive_scoped_lock lock( _idShards[sh].mx );
+            CCById& m = _idShards[sh].byId;
+            for( CCById::iterator i = m.begin(); i != m.end(); ++i ) {
                 ClientCursor *cc = i->second;
 
-                ++i; // we may be removing this node
-
                 if( cc->_db != db )
                     continue;
 
                 if (isDB) {
                     // already checked that db matched above
                     dassert( str::startsWith(cc->_ns.c_str(), ns) );
-                    delete cc; //removes self from ccByID
-                }
-                else {
-                    if ( str::equals(cc->_ns.c_str(), ns) )
-                        delete cc; //removes self from ccByID
+                    toDelete.push_back(i->first);
                 }
+                else if ( str::equals(cc->_ns.c_str(), ns) )
+                    toDelete.push_back(i->first);
             }
+        }
 
-            /*
-            note : we can't iterate byloc because clientcursors may exist with a loc of null in which case
-                   they are not in the map.  perhaps they should not exist though in the future?  something to
-                   change???
-
-            CCByLoc& bl = db->ccByLoc;
-            for ( CCByLoc::iterator i = bl.begin(); i != bl.end(); ++i ) {
-                ClientCursor *cc = i->second;
-                if ( strncmp(ns, cc->ns.c_str(), len) == 0 ) {
-                    assert( cc->_db == db );
-                    toDelete.push_back(i->second);
-                }
-            }*/
-
-            /*cout << "TEMP after invalidate " << endl;
-            for( auto i = clientCursorsById.begin(); i != clientCursorsById.end(); ++i ) {
-                cout << "  " << i->second->ns << endl;
-            }
-            cout << "TEMP after invalidate done" << endl;*/
+        for ( vector<CursorId>::iterator i = toDelete.begin(); i != toDelete.end(); ++i ) {
+            ClientCursor *cc = _claim( *i );
+            if ( cc ) // deleted even if pinned - the namespace is going away
+                delete cc;
         }
+
+        /*
+        note : we can't iterate byloc because clientcursors may exist with a loc of null in which case
+               they are not in the map.  perhaps they should not exist though in the future?  something to
+               change???
+        */
     }
 
     bool ClientCursor::shouldTimeout( unsigned millis ) {
@@ -137,23 +143,56 @@ namespace mongo {
         return _idleAgeMillis > 600000 && _pinValue == 0;
     }
 
-    /* called every 4 seconds.  millis is amount of idle time passed since the last call -- could be zero */
-    void ClientCursor::idleTimeReport(unsigned millis) {
+    /* called every 4 seconds by the cursor monitor.  incremental: each pass
+       visits at most MaxCursorsPerSweep cursors, resuming where the previous
+       pass stopped, so a pass never holds a shard mutex for long no matter how
+       many cursors are open.  a cursor's idle time is measured from the
+       sweep's previous visit to it (_sweptAtMillis), so slower full cycles
+       don't undercount idleness.
+    */
+    void ClientCursor::idleTimeReport() {
         readlock lk("");
-        recursive_scoped_lock lock(ccmutex);
-        for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end();  ) {
-            CCById::iterator j = i;
-            i++;
-            if( j->second->shouldTimeout( millis ) ) {
-                numberTimedOut++;
-                LOG(1) << "killing old cursor " << j->second->_cursorid << ' ' << j->second->_ns
-                       << " idle:" << j->second->idleTime() << "ms\n";
-                delete j->second;
+
+        const int MaxCursorsPerSweep = 1000;
+        static unsigned shard = 0;                              // monitor thread only
+        static CursorId pos = numeric_limits<long long>::min(); // last id visited within 'shard'
+
+        unsigned long long now = curTimeMillis64();
+        vector<CursorId> victims;
+        int visited = 0;
+
+        for ( unsigned shardsDone = 0; shardsDone < NumIdShards && visited < MaxCursorsPerSweep; ) {
+            IdShard& s = _idShards[shard];
+            {
+                recursive_scoped_lock lock(s.mx);
+                CCById::iterator i = s.byId.upper_bound( pos );
+                while ( i != s.byId.end() && visited < MaxCursorsPerSweep ) {
+                    ClientCursor *cc = i->second;
+                    pos = i->first;
+                    ++i;
+                    ++visited;
+                    // updateLocation() may bump _sweptAtMillis past 'now' under a concurrent read lock
+                    unsigned idle = now > cc->_sweptAtMillis ? (unsigned)( now - cc->_sweptAtMillis ) : 0;
+                    cc->_sweptAtMillis = now;
+                    if ( cc->shouldTimeout( idle ) )
+                        victims.push_back( pos );
+                }
+                if ( i != s.byId.end() )
+                    break; // out of budget mid shard - resume here next pass
             }
+            shard = ( shard + 1 ) % NumIdShards;
+            pos = numeric_limits<long long>::min();
+            shardsDone++;
         }
-        unsigned sz = clientCursorsById.size();
+
+        for ( vector<CursorId>::iterator i = victims.begin(); i != victims.end(); ++i ) {
+            if ( _eraseIfUnpinned( *i ) )
+                numberTimedOut++;
+        }
+
+        unsigned sz = numCursors();
         static time_t last;
-        if( sz >= 100000 ) { 
+        if( sz >= 100000 ) {
             if( time(0) - last > 300 ) {
                 last = time(0);
                 log() << "warning number of open cursors is very large: " << sz << endl;
@@ -165,8 +204,8 @@ namespace mongo {
        note this is potentially slow
     */
     void ClientCursor::informAboutToDeleteBucket(const DiskLoc& b) {
-        recursive_scoped_lock lock(ccmutex);
         Database *db = cc().database();
+        recursive_scoped_lock lock(db->ccByLocMutex);
         CCByLoc& bl = db->ccByLoc;
         RARELY if ( bl.size() > 70 ) {
             log() << "perf warning: byLoc.size=" << bl.size() << " in aboutToDeleteBucket\n";
@@ -183,11 +222,14 @@ namespace mongo {
 
     /* must call this on a delete so we clean up the cursors. */
     void ClientCursor::aboutToDelete(const DiskLoc& dl) {
-        recursive_scoped_lock lock(ccmutex);
-
         Database *db = cc().database();
         assert(db);
 
+        /* held for the whole scan: a concurrently dying cursor blocks in its
+           destructor on this mutex, so the raw pointers collected below stay
+           valid until we are done with them. */
+        recursive_scoped_lock lock(db->ccByLocMutex);
+
         aboutToDeleteForSharding( db , dl );
 
         CCByLoc& bl = db->ccByLoc;
@@ -267,8 +309,10 @@ namespace mongo {
         _ns(ns), _db( cc().database() ),
         _c(c), _pos(0),
         _query(query),  _queryOptions(queryOptions),
-        _idleAgeMillis(0), _pinValue(0),
-        _doingDeletes(false), _yieldSometimesTracker(128,10) {
+        _idleAgeMillis(0), _sweptAtMillis(curTimeMillis64()),
+        _batchBytesTarget(0), _lastBatchBytes(0), _lastBatchSentMillis(0),
+        _staged(0), _stagedN(0), _pinValue(0),
+        _doingDeletes(false), _unregistered(false), _yieldSometimesTracker(128,10) {
 
         dbMutex.assertAtLeastReadLocked();
 
@@ -276,9 +320,16 @@ namespace mongo {
         assert( str::startsWith(_ns, _db->name) );
         if( queryOptions & QueryOption_NoCursorTimeout )
             noTimeout();
-        recursive_scoped_lock lock(ccmutex);
-        _cursorid = allocCursorId_inlock();
-        clientCursorsById.insert( make_pair(_cursorid, this) );
+        for( ;; ) {
+            CursorId x = candidateCursorId();
+            IdShard& s = _shardFor(x);
+            recursive_scoped_lock lock(s.mx);
+            if ( s.byId.count(x) == 0 ) { // a collision is vanishingly rare for a random 64 bit id
+                _cursorid = x;
+                s.byId.insert( make_pair(x, this) );
+                break;
+            }
+        }
 
         if ( ! _c->modifiedKeys() ) {
             // store index information so we can decide if we can
@@ -307,14 +358,19 @@ namespace mongo {
         }
 
         {
-            recursive_scoped_lock lock(ccmutex);
+            recursive_scoped_lock lock( _db->ccByLocMutex );
             setLastLoc_inlock( DiskLoc() ); // removes us from bylocation multimap
-            clientCursorsById.erase(_cursorid);
+        }
 
-            // defensive:
-            (CursorId&)_cursorid = -1;
-            _pos = -2;
+        if ( ! _unregistered ) { // erase() and friends already claimed us out of the shard
+            IdShard& s = _shardFor(_cursorid);
+            recursive_scoped_lock lock(s.mx);
+            s.byId.erase(_cursorid);
         }
+
+        // defensive:
+        (CursorId&)_cursorid = -1;
+        _pos = -2;
     }
 
     bool ClientCursor::getFieldsDotted( const string& name, BSONElementSet &ret, BSONObj& holder ) {
@@ -394,12 +450,13 @@ namespace mongo {
     void ClientCursor::updateLocation() {
         assert( _cursorid );
         _idleAgeMillis = 0;
+        _sweptAtMillis = curTimeMillis64(); // so the timeout sweep doesn't charge us for time before this use
         DiskLoc cl = _c->refLoc();
         if ( lastLoc() == cl ) {
             //log() << "info: lastloc==curloc " << ns << '\n';
         }
         else {
-            recursive_scoped_lock lock(ccmutex);
+            recursive_scoped_lock lock(_db->ccByLocMutex);
             setLastLoc_inlock(cl);
         }
         // may be necessary for MultiCursor even when cl hasn't changed
@@ -413,8 +470,11 @@ namespace mongo {
         int micros = Client::recommendedYieldMicros( &writers , &readers );
 
         if ( micros > 0 && writers == 0 && dbMutex.getState() <= 0 ) {
-            // we have a read lock, and only reads are coming on, so why bother unlocking
-            micros = 0;
+            // we have a read lock, and only reads are coming on, so why bother
+            // unlocking... unless we are low priority - then a queued reader
+            // outranks us and we get out of its way too
+            if ( ! cc().curop()->isLowPriority() )
+                micros = 0;
         }
 
         return micros;
@@ -441,9 +501,11 @@ namespace mongo {
             return 0;
         
         Record * rec = l.rec();
-        if ( rec->likelyInPhysicalMemory() ) 
+        bool inMemory = rec->likelyInPhysicalMemory();
+        Top::global.faultCheck( _ns , inMemory ); // sampled per-ns residency stats
+        if ( inMemory )
             return 0;
-        
+
         return rec;
     }
 
@@ -451,7 +513,13 @@ namespace mongo {
         if ( yielded ) {
             *yielded = false;   
         }
-        if ( ! _yieldSometimesTracker.ping() ) {
+        /* adaptive: between scheduled checks we still give way the moment a
+           writer queues up behind us, rather than holding the lock for the
+           rest of the interval.  when nobody is waiting, yieldSuggest() below
+           comes back zero and we don't bother unlocking at all. */
+        bool lowPriority = cc().curop()->isLowPriority();
+        if ( ! _yieldSometimesTracker.ping() && dbMutex.writersWaiting() == 0 &&
+                ! ( lowPriority && dbMutex.readersWaiting() > 0 ) ) {
             Record* rec = _recordForYield( need );
             if ( rec ) {
                 if ( yielded ) {
@@ -565,19 +633,65 @@ namespace mongo {
         return ClientCursor::recoverFromYield( data );
     }
 
-    long long ctmLast = 0; // so we don't have to do find() which is a little slow very often.
-    long long ClientCursor::allocCursorId_inlock() {
+    /* candidate only - the ClientCursor constructor checks it against the id shard for collisions */
+    static CursorId candidateCursorId() {
         long long ctm = curTimeMillis64();
         dassert( ctm );
-        long long x;
-        while ( 1 ) {
-            x = (((long long)rand()) << 32);
-            x = x ^ ctm;
-            if ( ctm != ctmLast || ClientCursor::find_inlock(x, false) == 0 )
-                break;
-        }
-        ctmLast = ctm;
-        return x;
+        return (((long long)rand()) << 32) ^ ctm;
+    }
+
+    bool ClientCursor::erase( CursorId id ) {
+        /* the read lock keeps the cursor's Database alive for the destructor
+           and excludes a write locked invalidate()/aboutToDelete() scan from
+           running between our claim below and the delete.  recursive - fine
+           if the caller already holds the db lock. */
+        readlock lk("");
+
+        ClientCursor *cc;
+        {
+            IdShard& s = _shardFor(id);
+            recursive_scoped_lock lock(s.mx);
+            cc = find_inlock(id);
+            if ( ! cc )
+                return false;
+            assert( cc->_pinValue < 100 ); // you can't still have an active ClientCursor::Pointer
+            s.byId.erase(id);
+            cc->_unregistered = true; // ours now - a racing erase can no longer find it
+        }
+        delete cc; // outside the shard mutex - the destructor takes the byLoc mutex
+        return true;
+    }
+
+    ClientCursor* ClientCursor::_claim( CursorId id ) {
+        IdShard& s = _shardFor(id);
+        recursive_scoped_lock lock(s.mx);
+        ClientCursor *cc = find_inlock(id, false);
+        if ( ! cc )
+            return 0;
+        s.byId.erase(id);
+        cc->_unregistered = true;
+        return cc;
+    }
+
+    bool ClientCursor::_eraseIfUnpinned( CursorId id ) {
+        dbMutex.assertAtLeastReadLocked(); // see erase() - idleTimeReport() holds a read lock
+
+        ClientCursor *cc;
+        {
+            IdShard& s = _shardFor(id);
+            recursive_scoped_lock lock(s.mx);
+            cc = find_inlock(id, false);
+            if ( ! cc )
+                return false;
+            if ( cc->_pinValue ) // pinned (or made noTimeout) since the sweep looked at it
+                return false;
+            s.byId.erase(id);
+            cc->_unregistered = true;
+        }
+        LOG(1) << "killing old cursor " << id << ' ' << cc->_ns
+               << " idle:" << cc->idleTime() << "ms\n";
+        delete cc;
+        return true;
     }
 
     void ClientCursor::storeOpForSlave( DiskLoc last ) {
@@ -598,21 +712,52 @@ namespace mongo {
         mongo::updateSlaveLocation( curop , _ns.c_str() , _slaveReadTill );
     }
 
+    int ClientCursor::nextBatchBytes() {
+        if ( _batchBytesTarget == 0 )
+            _batchBytesTarget = MaxBytesToReturnToClientAtOnce;
+        if ( _lastBatchSentMillis ) {
+            long long gap = curTimeMillis64() - _lastBatchSentMillis;
+            if ( gap < 50 ) {
+                // back within 50ms of the last reply - the client is draining
+                // batches as fast as we build them, so fewer, bigger round trips
+                // win.  double up, to a cap.
+                if ( _batchBytesTarget < 4 * MaxBytesToReturnToClientAtOnce )
+                    _batchBytesTarget *= 2;
+            }
+            else if ( gap > 1000 ) {
+                // an interactive or throttled consumer - no reason to make it
+                // wait on (or buffer) an oversized batch
+                _batchBytesTarget = MaxBytesToReturnToClientAtOnce;
+            }
+        }
+        return _batchBytesTarget;
+    }
+
+    void ClientCursor::noteBatchSent( int bytes ) {
+        _lastBatchBytes = bytes;
+        _lastBatchSentMillis = curTimeMillis64();
+    }
+
 
     void ClientCursor::appendStats( BSONObjBuilder& result ) {
-        recursive_scoped_lock lock(ccmutex);
-        result.appendNumber("totalOpen", clientCursorsById.size() );
-        result.appendNumber("clientCursors_size", (int) numCursors());
-        result.appendNumber("timedOut" , numberTimedOut);
+        unsigned total = 0;
         unsigned pinned = 0;
         unsigned notimeout = 0;
-        for ( CCById::iterator i = clientCursorsById.begin(); i != clientCursorsById.end(); i++ ) {
-            unsigned p = i->second->_pinValue;
-            if( p >= 100 )
-                pinned++;
-            else if( p > 0 )
-                notimeout++;
+        for ( unsigned sh = 0; sh < NumIdShards; sh++ ) {
+            recursive_scoped_lock lock( _idShards[sh].mx );
+            CCById& m = _idShards[sh].byId;
+            total += m.size();
+            for ( CCById::iterator i = m.begin(); i != m.end(); i++ ) {
+                unsigned p = i->second->_pinValue;
+                if( p >= 100 )
+                    pinned++;
+                else if( p > 0 )
+                    notimeout++;
+            }
         }
+        result.appendNumber("totalOpen", total );
+        result.appendNumber("clientCursors_size", (int) total);
+        result.appendNumber("timedOut" , numberTimedOut);
         if( pinned ) 
             result.append("pinned", pinned);
         if( notimeout )
@@ -677,11 +822,10 @@ namespace mongo {
     void ClientCursorMonitor::run() {
         Client::initThread("clientcursormon");
         Client& client = cc();
-        Timer t;
         const int Secs = 4;
         unsigned n = 0;
         while ( ! inShutdown() ) {
-            ClientCursor::idleTimeReport( t.millisReset() );
+            ClientCursor::idleTimeReport();
             sleepsecs(Secs);
             if( ++n % (60/4) == 0 /*once a minute*/ ) { 
                 sayMemoryStatus();
@@ -691,11 +835,13 @@ namespace mongo {
     }
 
     void ClientCursor::find( const string& ns , set<CursorId>& all ) {
-        recursive_scoped_lock lock(ccmutex);
-
-        for ( CCById::iterator i=clientCursorsById.begin(); i!=clientCursorsById.end(); ++i ) {
-            if ( i->second->_ns == ns )
-                all.insert( i->first );
+        for ( unsigned sh = 0; sh < NumIdShards; sh++ ) {
+            recursive_scoped_lock lock( _idShards[sh].mx );
+            CCById& m = _idShards[sh].byId;
+            for ( CCById::iterator i=m.begin(); i!=m.end(); ++i ) {
+                if ( i->second->_ns == ns )
+                    all.insert( i->first );
+            }
         }
     }
 
@@ -102,7 +102,7 @@ namespace mongo {
             }
             ~Pointer() { release(); }
             Pointer(long long cursorid) {
-                recursive_scoped_lock lock(ccmutex);
+                recursive_scoped_lock lock( _shardFor(cursorid).mx );
                 _c = ClientCursor::find_inlock(cursorid, true);
                 if( _c ) {
                     if( _c->_pinValue >= 100 ) {
@@ -281,11 +281,14 @@ namespace mongo {
         ShardChunkManagerPtr getChunkManager(){ return _chunkManager; }
 
     private:
+        /** caller must hold _db->ccByLocMutex */
         void setLastLoc_inlock(DiskLoc);
 
+        /** caller must hold the id shard mutex for this id */
         static ClientCursor* find_inlock(CursorId id, bool warn = true) {
-            CCById::iterator it = clientCursorsById.find(id);
-            if ( it == clientCursorsById.end() ) {
+            CCById& m = _shardFor(id).byId;
+            CCById::iterator it = m.find(id);
+            if ( it == m.end() ) {
                 if ( warn )
                     OCCASIONALLY out() << "ClientCursor::find(): cursor not found in map " << id << " (ok after a drop)\n";
                 return 0;
@@ -294,7 +297,7 @@ namespace mongo {
         }
     public:
         static ClientCursor* find(CursorId id, bool warn = true) {
-            recursive_scoped_lock lock(ccmutex);
+            recursive_scoped_lock lock( _shardFor(id).mx );
             ClientCursor *c = find_inlock(id, warn);
             // if this asserts, your code was not thread safe - you either need to set no timeout
             // for the cursor or keep a ClientCursor::Pointer in scope for it.
@@ -302,16 +305,7 @@ namespace mongo {
             return c;
         }
 
-        static bool erase(CursorId id) {
-            recursive_scoped_lock lock(ccmutex);
-            ClientCursor *cc = find_inlock(id);
-            if ( cc ) {
-                assert( cc->_pinValue < 100 ); // you can't still have an active ClientCursor::Pointer
-                delete cc;
-                return true;
-            }
-            return false;
-        }
+        static bool erase(CursorId id);
 
         /**
          * @return number of cursors found
@@ -342,16 +336,48 @@ namespace mongo {
 
         unsigned idleTime() const { return _idleAgeMillis; }
 
+        /** adaptive reply batch sizing for getMore.  a consumer that comes right
+            back for the next batch (a streaming scan) is granted progressively
+            larger batches, up to a cap; one that dawdles drops back to the
+            default.  @return the byte limit to use for the next reply batch */
+        int nextBatchBytes();
+
+        /** note that a reply batch of the given size was just handed off */
+        void noteBatchSent( int bytes );
+
+        /** @return reply size of the last getMore batch, 0 if none yet sent.
+            used to right-size the next reply buffer - batch sizes on a
+            streaming scan are very stable from one getMore to the next. */
+        int lastBatchBytes() const { return _lastBatchBytes; }
+
+        /** speculative batch for tailable cursors.  after a reply batch fills,
+            getMore keeps scanning into this buffer (copies, so capped rollover
+            can't bite) and the next getMore is served from it instantly.
+            serialized reply bytes, ready to append to a reply buffer. */
+        enum { MaxStagedBytes = 64 * 1024 };
+        bool haveStaged() const { return _stagedN > 0; }
+        int stagedBytes() const { return _staged.len(); }
+        BufBuilder& stagedBuf() { return _staged; }
+        void noteStaged() { _stagedN++; }
+        /** move the staged results into b.  @return how many documents */
+        int drainStaged( BufBuilder& b ) {
+            b.appendBuf( _staged.buf() , _staged.len() );
+            int n = _stagedN;
+            _staged.reset();
+            _stagedN = 0;
+            return n;
+        }
+
         void setDoingDeletes( bool doingDeletes ) {_doingDeletes = doingDeletes; }
 
         void slaveReadTill( const OpTime& t ) { _slaveReadTill = t; }
 
     public: // static methods
 
-        static void idleTimeReport(unsigned millis);
+        static void idleTimeReport();
 
         static void appendStats( BSONObjBuilder& result );
-        static unsigned numCursors() { return clientCursorsById.size(); }
+        static unsigned numCursors();
         static void informAboutToDeleteBucket(const DiskLoc& b);
         static void aboutToDelete(const DiskLoc& dl);
         static void find( const string& ns , set<CursorId>& all );
@@ -385,6 +411,12 @@ namespace mongo {
 
         DiskLoc _lastLoc;                        // use getter and setter not this (important)
         unsigned _idleAgeMillis;                 // how long has the cursor been around, relative to server idle time
+        unsigned long long _sweptAtMillis;       // when the timeout sweep last visited us - see idleTimeReport()
+        int _batchBytesTarget;                   // see nextBatchBytes(); 0 until first getMore
+        int _lastBatchBytes;                     // see lastBatchBytes()
+        unsigned long long _lastBatchSentMillis; // when the last reply batch was handed off; 0 = none yet
+        BufBuilder _staged;                      // see haveStaged(); empty for non-tailable cursors
+        int _stagedN;                            // # documents in _staged
 
         /* 0 = normal
            1 = no timeout allowed
@@ -393,6 +425,7 @@ namespace mongo {
         unsigned _pinValue;
 
         bool _doingDeletes;
+        bool _unregistered;              // already removed from its id shard - see erase()
         ElapsedTracker _yieldSometimesTracker;
 
         ShardChunkManagerPtr _chunkManager;
@@ -406,10 +439,33 @@ namespace mongo {
 
     private: // static members
 
-        static CCById clientCursorsById;
+        /* the open cursor registry is sharded by cursor id so that heavy
+           concurrent find/getMore traffic doesn't serialize on one mutex.
+           the byLoc side lives per Database (Database::ccByLoc) under its
+           own ccByLocMutex.
+
+           lock ordering: a database's ccByLocMutex may be held while taking
+           an id shard mutex (aboutToDelete deletes capped cursors mid scan),
+           NEVER the reverse.  thus erase() claims a cursor out of its shard
+           and deletes it after releasing the shard mutex.
+        */
+        enum { NumIdShards = 16 };
+        struct IdShard : boost::noncopyable {
+            boost::recursive_mutex mx;
+            CCById byId;
+        };
+        static IdShard _idShards[NumIdShards];
+        static IdShard& _shardFor( CursorId id ) { return _idShards[ (unsigned long long)id % NumIdShards ]; }
+
+        /** remove id from its shard so no one else can find or delete it.
+            @return the claimed cursor (caller deletes, outside the shard mutex), or 0 if gone */
+        static ClientCursor* _claim( CursorId id );
+
+        /** erase for the timeout sweep: skips (rather than asserting on) a cursor
+            that got pinned after the sweep decided to kill it */
+        static bool _eraseIfUnpinned( CursorId id );
+
         static long long numberTimedOut;
-        static boost::recursive_mutex& ccmutex;   // must use this for all statics above!
-        static CursorId allocCursorId_inlock();
 
     };
 
@@ -27,6 +27,7 @@
 #include "db.h"
 #include "instance.h"
 #include "repl.h"
+#include "../util/concurrency/thread_pool.h"
 
 namespace mongo {
 
@@ -54,6 +55,16 @@ namespace mongo {
         auto_ptr< DBClientWithCommands > conn;
         void copy(const char *from_ns, const char *to_ns, bool isindex, bool logForRepl,
                   bool masterSameProcess, bool slaveOk, bool mayYield, bool mayBeInterrupted, Query q = Query());
+        void copyOneCollection(const BSONObj& collection, const string& todb, bool logForRepl,
+                               bool masterSameProcess, bool slaveOk, bool snapshot,
+                               bool mayYield, bool mayBeInterrupted);
+        bool goParallel(const char *masterHost, string& errmsg, const string& todb,
+                        const list<BSONObj>& toClone, bool logForRepl, bool slaveOk,
+                        bool snapshot, bool mayBeInterrupted, int parallel);
+        struct ParallelCloneState;
+        static void parallelCloneTask(string masterHost, BSONObj collection, string todb,
+                                      bool logForRepl, bool slaveOk, bool snapshot,
+                                      bool mayBeInterrupted, ParallelCloneState *state);
         struct Fun;
     public:
         Cloner() { }
@@ -66,7 +77,7 @@ namespace mongo {
         void setConnection( DBClientWithCommands *c ) { conn.reset( c ); }
 
         /** copy the entire database */
-        bool go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode = 0);
+        bool go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode = 0, int parallel = 0);
 
         bool copyCollection( const string& from , const string& ns , const BSONObj& query , string& errmsg , bool mayYield, bool mayBeInterrupted, bool copyIndexes = true, bool logForRepl = true );
     };
@@ -285,7 +296,130 @@ namespace mongo {
     extern bool inDBRepair;
     void ensureIdIndexForNewNs(const char *ns);
 
-    bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode) {
+    /* clone one collection (a vetted system.namespaces entry) to <todb>.
+       caller must hold the write lock with a context set for the destination db.
+       copy() temp-releases the lock around the remote reads as usual. */
+    void Cloner::copyOneCollection(const BSONObj& collection, const string& todb, bool logForRepl,
+                                   bool masterSameProcess, bool slaveOk, bool snapshot,
+                                   bool mayYield, bool mayBeInterrupted) {
+        log(2) << "  really will clone: " << collection << endl;
+        const char * from_name = collection["name"].valuestr();
+        BSONObj options = collection.getObjectField("options");
+
+        /* change name "<fromdb>.collection" -> <todb>.collection */
+        const char *p = strchr(from_name, '.');
+        assert(p);
+        string to_name = todb + p;
+
+        bool wantIdIndex = false;
+        {
+            string err;
+            const char *toname = to_name.c_str();
+            /* we defer building id index for performance - building it in batch is much faster */
+            userCreateNS(toname, options, err, logForRepl, &wantIdIndex);
+        }
+        log(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
+        Query q;
+        if( snapshot )
+            q.snapshot();
+        copy(from_name, to_name.c_str(), false, logForRepl, masterSameProcess, slaveOk, mayYield, mayBeInterrupted, q);
+
+        if( wantIdIndex ) {
+            /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
+               that occur during the initial sync.  inDBRepair makes dropDups be true.
+               */
+            bool old = inDBRepair;
+            try {
+                inDBRepair = true;
+                ensureIdIndexForNewNs(to_name.c_str());
+                inDBRepair = old;
+            }
+            catch(...) {
+                inDBRepair = old;
+                throw;
+            }
+        }
+    }
+
+    /** first failure across the parallel clone tasks, if any */
+    struct Cloner::ParallelCloneState {
+        ParallelCloneState() : m("ParallelCloneState"), failed(false) {}
+        mongo::mutex m;
+        bool failed;
+        string errmsg;
+        void fail( const string& msg ) {
+            scoped_lock lk( m );
+            if ( !failed ) {
+                failed = true;
+                errmsg = msg;
+            }
+        }
+    };
+
+    /* runs on a ThreadPool worker.  each task clones one collection over its own
+       connection so the network reads of several collections overlap; the actual
+       inserts still serialize on the write lock, taken per batch as in the serial
+       path, so the lock is free whenever a task is waiting on the wire. */
+    void Cloner::parallelCloneTask(string masterHost, BSONObj collection, string todb,
+                                   bool logForRepl, bool slaveOk, bool snapshot,
+                                   bool mayBeInterrupted, ParallelCloneState *state) {
+        if ( currentClient.get() == 0 )
+            Client::initThread("clone");
+        try {
+            if ( state->failed )
+                return; // a sibling task already failed; don't bother
+            Cloner cloner;
+            {
+                string errmsg;
+                auto_ptr<DBClientConnection> con( new DBClientConnection() );
+                if ( !con->connect( masterHost, errmsg ) ) {
+                    state->fail( "parallel clone couldn't connect to " + masterHost + " " + errmsg );
+                    return;
+                }
+                if ( !replAuthenticate( con.get() ) ) {
+                    state->fail( "parallel clone couldn't authenticate to " + masterHost );
+                    return;
+                }
+                cloner.setConnection( con.release() );
+            }
+            writelock lk(todb);
+            Client::Context ctx(todb);
+            cloner.copyOneCollection( collection, todb, logForRepl, /*masterSameProcess*/false, slaveOk, snapshot, /*mayYield*/true, mayBeInterrupted );
+        }
+        catch ( DBException& e ) {
+            state->fail( str::stream() << "parallel clone exception cloning " << collection["name"].valuestr() << ": " << e.what() );
+        }
+        catch ( std::exception& e ) {
+            state->fail( str::stream() << "parallel clone exception cloning " << collection["name"].valuestr() << ": " << e.what() );
+        }
+    }
+
+    /* clone the collections in toClone concurrently.  caller holds the write lock;
+       we temp-release it here for the duration so the tasks can take it per batch.
+       secondary index builds still happen afterwards in go(), once the data is in
+       place, so they get the batch bottom-up BtreeBuilder path. */
+    bool Cloner::goParallel(const char *masterHost, string& errmsg, const string& todb,
+                            const list<BSONObj>& toClone, bool logForRepl, bool slaveOk,
+                            bool snapshot, bool mayBeInterrupted, int parallel) {
+        log() << "cloning " << toClone.size() << " collections from " << masterHost << " with " << parallel << " threads" << endl;
+        ParallelCloneState state;
+        {
+            dbtemprelease r;
+            ThreadPool pool(parallel);
+            for ( list<BSONObj>::const_iterator i = toClone.begin(); i != toClone.end(); i++ ) {
+                pool.schedule( boost::bind( &Cloner::parallelCloneTask, string(masterHost), *i, todb,
+                                            logForRepl, slaveOk, snapshot, mayBeInterrupted, &state ) );
+            }
+            pool.join();
+        }
+        if ( state.failed ) {
+            errmsg = state.errmsg;
+            return false;
+        }
+        return true;
+    }
+
+    bool Cloner::go(const char *masterHost, string& errmsg, const string& fromdb, bool logForRepl, bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode, int parallel) {
         if ( errCode ) {
             *errCode = 0;
         }
@@ -382,48 +516,17 @@ namespace mongo {
             }
         }
 
-        for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
-            {
-                mayInterrupt( mayBeInterrupted );
-                dbtempreleaseif r( mayYield );
-            }
-            BSONObj collection = *i;
-            log(2) << "  really will clone: " << collection << endl;
-            const char * from_name = collection["name"].valuestr();
-            BSONObj options = collection.getObjectField("options");
-
-            /* change name "<fromdb>.collection" -> <todb>.collection */
-            const char *p = strchr(from_name, '.');
-            assert(p);
-            string to_name = todb + p;
-
-            bool wantIdIndex = false;
-            {
-                string err;
-                const char *toname = to_name.c_str();
-                /* we defer building id index for performance - building it in batch is much faster */
-                userCreateNS(toname, options, err, logForRepl, &wantIdIndex);
-            }
-            log(1) << "\t\t cloning " << from_name << " -> " << to_name << endl;
-            Query q;
-            if( snapshot )
-                q.snapshot();
-            copy(from_name, to_name.c_str(), false, logForRepl, masterSameProcess, slaveOk, mayYield, mayBeInterrupted, q);
-
-            if( wantIdIndex ) {
-                /* we need dropDups to be true as we didn't do a true snapshot and this is before applying oplog operations
-                   that occur during the initial sync.  inDBRepair makes dropDups be true.
-                   */
-                bool old = inDBRepair;
-                try {
-                    inDBRepair = true;
-                    ensureIdIndexForNewNs(to_name.c_str());
-                    inDBRepair = old;
-                }
-                catch(...) {
-                    inDBRepair = old;
-                    throw;
+        if ( parallel > 1 && !masterSameProcess && mayYield && toClone.size() > 1 ) {
+            if ( !goParallel( masterHost, errmsg, todb, toClone, logForRepl, slaveOk, snapshot, mayBeInterrupted, parallel ) )
+                return false;
+        }
+        else {
+            for ( list<BSONObj>::iterator i=toClone.begin(); i != toClone.end(); i++ ) {
+                {
+                    mayInterrupt( mayBeInterrupted );
+                    dbtempreleaseif r( mayYield );
                 }
+                copyOneCollection( *i, todb, logForRepl, masterSameProcess, slaveOk, snapshot, mayYield, mayBeInterrupted );
             }
         }
 
@@ -441,9 +544,9 @@ namespace mongo {
     }
 
     bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
-                   bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode) {
+                   bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield, bool mayBeInterrupted, int *errCode, int parallel) {
         Cloner c;
-        return c.go(masterHost, errmsg, fromdb, logForReplication, slaveOk, useReplAuth, snapshot, mayYield, mayBeInterrupted, errCode);
+        return c.go(masterHost, errmsg, fromdb, logForReplication, slaveOk, useReplAuth, snapshot, mayYield, mayBeInterrupted, errCode, parallel);
     }
 
     /* Usage:
@@ -457,18 +560,19 @@ namespace mongo {
         virtual LockType locktype() const { return WRITE; }
         virtual void help( stringstream &help ) const {
             help << "clone this database from an instance of the db on another host\n";
-            help << "{ clone : \"host13\" }";
+            help << "{ clone : \"host13\" [, parallel : <n> ] }";
         }
         CmdClone() : Command("clone") { }
         virtual bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
             string from = cmdObj.getStringField("clone");
             if ( from.empty() )
                 return false;
+            int parallel = cmdObj["parallel"].numberInt();
             /* replication note: we must logOp() not the command, but the cloned data -- if the slave
                were to clone it would get a different point-in-time and not match.
                */
             return cloneFrom(from.c_str(), errmsg, dbname,
-                             /*logForReplication=*/!fromRepl, /*slaveOk*/false, /*usereplauth*/false, /*snapshot*/true, /*mayYield*/true, /*mayBeInterrupted*/false);
+                             /*logForReplication=*/!fromRepl, /*slaveOk*/false, /*usereplauth*/false, /*snapshot*/true, /*mayYield*/true, /*mayBeInterrupted*/false, 0, parallel);
         }
     } cmdclone;
 
@@ -29,10 +29,12 @@ namespace mongo {
      *                      for example repairDatabase need not use it.
      * @param errCode     - If provided, this will be set on error to the server's error code.  Currently
      *                      this will only be set if there is an error in the initial system.namespaces query.
+     * @param parallel    - if > 1, clone that many collections concurrently, each over its own
+     *                      connection (remote sources only; requires mayYield).
      */
     bool cloneFrom(const char *masterHost, string& errmsg, const string& fromdb, bool logForReplication,
                    bool slaveOk, bool useReplAuth, bool snapshot, bool mayYield,
-                   bool mayBeInterrupted, int *errCode = 0);
+                   bool mayBeInterrupted, int *errCode = 0, int parallel = 0);
 
     bool copyCollectionFromRemote(const string& host, const string& ns, const BSONObj& query, string& errmsg, bool logForRepl, bool mayYield, bool mayBeInterrupted);
 
@@ -69,6 +69,7 @@ namespace mongo {
         bool quiet;            // --quiet
         bool noTableScan;      // --notablescan no table scans allowed
         bool prealloc;         // --noprealloc no preallocation of data files
+        int preallocFiles;     // --preallocFiles spare datafiles kept ready per database
         bool preallocj;        // --nopreallocj no preallocation of journal files
         bool smallfiles;       // --smallfiles allocate smaller data files
 
@@ -77,9 +78,11 @@ namespace mongo {
         bool quota;            // --quota
         int quotaFiles;        // --quotaFiles
         bool cpu;              // --cpu show cpu time periodically
+        bool defrag;           // --defrag background compaction of fragmented namespaces
 
         bool dur;                       // --dur durability (now --journal)
         unsigned journalCommitInterval; // group/batch commit interval ms
+        unsigned journalStreams;        // how many journal file streams to hash databases across
 
         /** --durOptions 7      dump journal and terminate without doing anything further
             --durOptions 4      recover and terminate without listening
@@ -100,8 +103,11 @@ namespace mongo {
         int defaultProfile;    // --profile
         int slowMS;            // --time in ms that is "slow"
 
+        bool asyncInserts;     // --asyncInserts stage unacknowledged inserts for a background writer (experimental)
         int pretouch;          // --pretouch for replication application (experimental)
+        int indexBuildThreads; // --indexBuildThreads scan/sort threads for foreground index builds (experimental)
         bool moveParanoia;     // for move chunk paranoia
+        bool numaInterleave;   // --numaInterleave spread memory across NUMA nodes ourselves
         double syncdelay;      // seconds between fsyncs
 
         bool noUnixSocket;     // --nounixsocket
@@ -137,12 +143,13 @@ namespace mongo {
 
     // todo move to cmdline.cpp?
     inline CmdLine::CmdLine() :
-        port(DefaultDBPort), rest(false), jsonp(false), quiet(false), noTableScan(false), prealloc(true), preallocj(true), smallfiles(sizeof(int*) == 4),
+        port(DefaultDBPort), rest(false), jsonp(false), quiet(false), noTableScan(false), prealloc(true), preallocFiles(1), preallocj(true), smallfiles(sizeof(int*) == 4),
         configsvr(false),
-        quota(false), quotaFiles(8), cpu(false), durOptions(0), objcheck(false), oplogSize(0), defaultProfile(0), slowMS(100), pretouch(0), moveParanoia( true ),
-        syncdelay(60), noUnixSocket(false), socket("/tmp") 
+        quota(false), quotaFiles(8), cpu(false), defrag(false), durOptions(0), objcheck(false), oplogSize(0), defaultProfile(0), slowMS(100), asyncInserts(false), pretouch(0), indexBuildThreads(1), moveParanoia( true ),
+        numaInterleave(false), syncdelay(60), noUnixSocket(false), socket("/tmp") 
     {
         journalCommitInterval = 0; // 0 means use default
+        journalStreams = 1;
         dur = false;
 #if defined(_DURABLEDEFAULTON)
         dur = true;
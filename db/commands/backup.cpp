@@ -0,0 +1,241 @@
+// backup.cpp
+
+/**
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "../commands.h"
+#include "../instance.h"
+#include "../dur.h"
+#include "../cmdline.h"
+#include "../namespace.h"
+#include "../../util/file.h"
+
+#include <boost/filesystem/operations.hpp>
+
+namespace mongo {
+
+    namespace dur {
+        void setAgeOutJournalFiles(bool rotate);
+        boost::filesystem::path getJournalDir();
+    }
+
+    /* online backup without fsync+lock.
+
+       with journaling on, a copy of the data files - even one taken while
+       writes are in flight, so individual files may be torn - plus every
+       journal file written since before the data file copy began, replays on
+       startup to a consistent state.  so the procedure is:
+
+         1. backupStart     - journal age-out is suspended so the needed
+                              journal prefix stays on disk; returns the file
+                              list
+         2. backupFetch     - stream each data file, then each journal file,
+                              in sequential chunks (optionally throttled)
+         3. backupEnd       - resumes journal age-out
+
+       contrast with the fsync command's lock:true, which blocks all writes
+       for the duration of the copy.
+    */
+
+    // one backup at a time; the OID pairs fetch/end calls with their start,
+    // as the fsync lock does for its unlock
+    static mongo::mutex backupMutex("backup");
+    static bool backupActive = false;
+    static OID backupID;
+    static double backupMBPerSec = 0;
+    static Timer backupTimer;
+    static long long backupBytes = 0;
+
+    class BackupStartCommand : public Command {
+    public:
+        BackupStartCommand() : Command( "backupStart" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const {
+            help << "{ backupStart : 1 , [throttleMBPerSec : n] }\n"
+                    "begin an online backup.  copy the returned data files, then the\n"
+                    "journal files, with backupFetch, and finish with backupEnd.";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            uassert( 15958 , "backupStart requires journaling to be enabled (--dur)" , cmdLine.dur );
+
+            double throttle = cmdObj["throttleMBPerSec"].numberDouble();
+            uassert( 15959 , "throttleMBPerSec cannot be negative" , throttle >= 0 );
+
+            {
+                scoped_lock lk(backupMutex);
+                uassert( 15960 , "a backup is already in progress, use backupEnd first" , !backupActive );
+                backupActive = true;
+                backupID.init();
+                backupMBPerSec = throttle;
+                backupTimer.reset();
+                backupBytes = 0;
+            }
+
+            // keep every journal file from here on until backupEnd - replay
+            // needs the full prefix back to before the data file copy starts
+            dur::setAgeOutJournalFiles(false);
+
+            // make sure everything acknowledged so far is in the journal
+            getDur().awaitCommit();
+
+            log() << "backupStart " << backupID << " throttleMBPerSec:" << throttle << endl;
+
+            // data files first, then journal files, in the order to copy them.
+            // with --directoryperdb data files sit one directory down.
+            BSONArrayBuilder files( result.subarrayStart( "files" ) );
+            boost::filesystem::path root( dbpath );
+            _listDir( files , root , "" );
+            for ( boost::filesystem::directory_iterator i( root );
+                    i != boost::filesystem::directory_iterator(); ++i ) {
+                string leaf = boost::filesystem::path(*i).leaf();
+                if ( boost::filesystem::is_directory( *i ) && leaf != "journal" && leaf.length() && leaf[0] != '$' )
+                    _listDir( files , *i , leaf + '/' );
+            }
+            _listDir( files , dur::getJournalDir() , "journal/" );
+            files.done();
+
+            result.append( "backupId" , backupID );
+            return true;
+        }
+
+    private:
+        static void _listDir( BSONArrayBuilder& files , const boost::filesystem::path& dir , const string& prefix ) {
+            if ( !boost::filesystem::exists( dir ) )
+                return;
+            for ( boost::filesystem::directory_iterator i( dir );
+                    i != boost::filesystem::directory_iterator(); ++i ) {
+                if ( boost::filesystem::is_directory( *i ) )
+                    continue;
+                string leaf = boost::filesystem::path(*i).leaf();
+                if ( leaf == "mongod.lock" )
+                    continue;
+                BSONObjBuilder b( files.subobjStart() );
+                b.append( "name" , prefix + leaf );
+                b.appendNumber( "length" , (long long) boost::filesystem::file_size( *i ) );
+                b.done();
+            }
+        }
+    } backupStartCmd;
+
+    class BackupFetchCommand : public Command {
+        enum { MaxChunk = 4 * 1024 * 1024 };
+    public:
+        BackupFetchCommand() : Command( "backupFetch" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const {
+            help << "{ backupFetch : 1 , backupId : <id> , file : <name> , offset : <n> }\n"
+                    "read the next chunk of a file listed by backupStart.  a zero length\n"
+                    "result means end of file.";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            double throttle;
+            {
+                scoped_lock lk(backupMutex);
+                uassert( 15961 , "no backup in progress with that backupId" ,
+                         backupActive && cmdObj["backupId"].type() == jstOID && cmdObj["backupId"].OID() == backupID );
+                throttle = backupMBPerSec;
+            }
+
+            string name = cmdObj["file"].str();
+            uassert( 15962 , "bad file name" ,
+                     !name.empty() && name[0] != '/' && name[0] != '\\' &&
+                     name.find( ".." ) == string::npos && name.find( ':' ) == string::npos );
+
+            long long offset = cmdObj["offset"].numberLong();
+            uassert( 15963 , "offset cannot be negative" , offset >= 0 );
+
+            boost::filesystem::path p = boost::filesystem::path( dbpath ) / name;
+            File f;
+            f.open( p.string().c_str() , true );
+            uassert( 15964 , str::stream() << "couldn't open file " << name , f.is_open() && !f.bad() );
+
+            // clamp against the current length - journal files grow while a
+            // backup runs and we want the bytes that exist now
+            long long fileLen = f.len();
+            int n = 0;
+            if ( offset < fileLen )
+                n = (int) min( (long long) MaxChunk , fileLen - offset );
+
+            boost::scoped_array<char> buf( new char[ n ? n : 1 ] );
+            if ( n ) {
+                f.read( offset , buf.get() , n );
+                uassert( 15965 , str::stream() << "error reading file " << name , !f.bad() );
+            }
+
+            result.append( "offset" , offset );
+            result.append( "length" , n );
+            result.appendBinData( "data" , n , BinDataGeneral , buf.get() );
+
+            if ( throttle > 0 && n ) {
+                long long sent;
+                int ms;
+                {
+                    scoped_lock lk(backupMutex);
+                    backupBytes += n;
+                    sent = backupBytes;
+                    ms = backupTimer.millis();
+                }
+                // token bucket: sleep until the bytes sent so far fit the rate
+                long long budget = (long long)( throttle * 1024 * 1024 * ( ms / 1000.0 ) );
+                if ( sent > budget ) {
+                    sleepmillis( (long long)( ( sent - budget ) * 1000.0 / ( throttle * 1024 * 1024 ) ) );
+                }
+            }
+
+            return true;
+        }
+    } backupFetchCmd;
+
+    class BackupEndCommand : public Command {
+    public:
+        BackupEndCommand() : Command( "backupEnd" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const {
+            help << "{ backupEnd : 1 , backupId : <id> }\n"
+                    "finish an online backup and resume journal file age-out.";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            long long bytes;
+            int ms;
+            {
+                scoped_lock lk(backupMutex);
+                uassert( 15966 , "no backup in progress with that backupId" ,
+                         backupActive && cmdObj["backupId"].type() == jstOID && cmdObj["backupId"].OID() == backupID );
+                backupActive = false;
+                bytes = backupBytes;
+                ms = backupTimer.millis();
+            }
+
+            dur::setAgeOutJournalFiles(true);
+
+            log() << "backupEnd " << cmdObj["backupId"].OID() << " bytes:" << bytes << " timeMillis:" << ms << endl;
+
+            result.appendNumber( "bytes" , bytes );
+            result.append( "timeMillis" , ms );
+            return true;
+        }
+    } backupEndCmd;
+
+}
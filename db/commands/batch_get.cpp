@@ -0,0 +1,103 @@
+// batch_get.cpp
+
+/**
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "../commands.h"
+#include "../instance.h"
+#include "../index.h"
+#include "../pdfile.h"
+#include "../curop-inl.h"
+
+namespace mongo {
+
+    /* fetch many documents by _id in a single command.  each lookup is a
+       direct probe of the _id index, as in Helpers::findById, skipping the
+       query planner and per-query setup a $in query or N findOnes would pay.
+       probes are made in key order so they walk the btree sequentially. */
+    class BatchGetCommand : public Command {
+    public:
+        BatchGetCommand() : Command( "batchGet" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return READ; }
+        virtual void help( stringstream &help ) const {
+            help << "{ batchGet : 'collection name' , ids : [ ... ] }\n"
+                    "returns the documents whose _id appears in ids, in _id order.\n"
+                    "ids not found are omitted from the result.";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            Timer t;
+            string ns = dbname + '.' + cmdObj.firstElement().valuestr();
+
+            uassert( 15952 , "ids must be an array" , cmdObj["ids"].type() == Array );
+            vector<BSONElement> ids = cmdObj["ids"].Array();
+
+            int bufSize = BSONObjMaxUserSize - 4096;
+            BufBuilder bb( bufSize );
+            BSONArrayBuilder arr( bb );
+
+            long long n = 0;
+            long long nscanned = 0;
+
+            NamespaceDetails * d = nsdetails( ns.c_str() );
+            if ( d ) {
+                int idxNo = d->findIdIndex();
+                uassert( 15953 , "batchGet needs an _id index" , idxNo >= 0 );
+                IndexDetails& idx = d->idx( idxNo );
+                IndexInterface& ii = idx.idxInterface();
+
+                // probe in key order for btree locality; this is also the
+                // order documents come back in
+                sort( ids.begin() , ids.end() , BSONElementCmpWithoutField() );
+
+                for ( unsigned i = 0; i < ids.size(); i++ ) {
+                    if ( i > 0 && ids[i].valuesEqual( ids[i-1] ) )
+                        continue; // duplicate id requested
+                    nscanned++;
+
+                    BSONObjBuilder kb;
+                    kb.appendAs( ids[i] , "" );
+                    BSONObj key = kb.obj();
+
+                    DiskLoc loc = ii.findSingle( idx , idx.head , key );
+                    if ( loc.isNull() )
+                        continue;
+
+                    BSONObj o = loc.obj();
+                    uassert( 15954 , "batchGet result too big, 16mb cap" ,
+                             ( bb.len() + o.objsize() + 1024 ) < bufSize );
+                    arr.append( o );
+                    n++;
+
+                    RARELY killCurrentOp.checkForInterrupt();
+                }
+            }
+
+            result.appendArray( "documents" , arr.done() );
+            {
+                BSONObjBuilder b;
+                b.appendNumber( "n" , n );
+                b.appendNumber( "nscanned" , nscanned );
+                b.appendNumber( "timems" , t.millis() );
+                result.append( "stats" , b.obj() );
+            }
+            return true;
+        }
+
+    } batchGetCmd;
+
+}
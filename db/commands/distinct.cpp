@@ -20,6 +20,7 @@
 #include "../instance.h"
 #include "../queryoptimizer.h"
 #include "../clientcursor.h"
+#include "../btree.h"
 
 namespace mongo {
 
@@ -62,6 +63,7 @@ namespace mongo {
             }
 
             shared_ptr<Cursor> cursor;
+            BtreeCursor * skip = 0; // when set, we can hop between distinct key values
             if ( ! query.isEmpty() ) {
                 cursor = NamespaceDetailsTransient::getCursor(ns.c_str() , query , BSONObj() );
             }
@@ -78,7 +80,14 @@ namespace mongo {
 
                     if ( idx.inKeyPattern( key ) ) {
                         cursor = bestGuessCursor( ns.c_str() , BSONObj() , idx.keyPattern() );
-                        if( cursor.get() ) break;
+                        if( cursor.get() ) {
+                            if ( str::equals( idx.keyPattern().firstElement().fieldName() , key.c_str() ) ) {
+                                // the distinct field is the leading index column, so
+                                // we can seek between values instead of scanning
+                                skip = dynamic_cast<BtreeCursor*>( cursor.get() );
+                            }
+                            break;
+                        }
                     }
 
                 }
@@ -94,7 +103,31 @@ namespace mongo {
             
             auto_ptr<ClientCursor> cc (new ClientCursor(QueryOption_NoCursorTimeout, cursor, ns));
 
-            while ( cursor->ok() ) {
+            if ( skip ) {
+                // index-only distinct: values come straight off the btree keys, and
+                // after recording each one we seek to the next distinct value of the
+                // field.  no DiskLoc is ever dereferenced, so a huge collection with
+                // few distinct values costs a handful of btree descents.
+                while ( cursor->ok() ) {
+                    nscanned++;
+                    n++;
+
+                    BSONElement e = skip->currKey().firstElement();
+                    int now = bb.len();
+                    uassert( 15925 , "distinct too big, 16mb cap", ( now + e.size() + 1024 ) < bufSize );
+                    arr.append( e ); // each value shows up exactly once
+                    values.insert( BSONElement( start + now ) );
+
+                    skip->advancePastPrefix( 1 );
+
+                    if ( !cc->yieldSometimes( ClientCursor::DontNeed ) ) {
+                        cc.release();
+                        break;
+                    }
+                    RARELY killCurrentOp.checkForInterrupt();
+                }
+            }
+            else while ( cursor->ok() ) {
                 nscanned++;
                 bool loadedObject = false;
 
@@ -136,8 +169,15 @@ namespace mongo {
             }
 
             assert( start == bb.buf() );
-
-            result.appendArray( "values" , arr.done() );
+            arr.done();
+
+            // emit in sorted (woCompare, no field name) order - the set
+            // iterates that way.  mongos relies on this ordering to union
+            // shard results with a streaming merge instead of a full set.
+            BSONArrayBuilder sorted( bb.len() + 128 );
+            for ( BSONElementSet::iterator i = values.begin(); i != values.end(); ++i )
+                sorted.append( *i );
+            result.appendArray( "values" , sorted.arr() );
 
             {
                 BSONObjBuilder b;
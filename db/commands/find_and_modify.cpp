@@ -29,8 +29,11 @@ namespace mongo {
             help <<
                  "{ findAndModify: \"collection\", query: {processed:false}, update: {$set: {processed:true}}, new: true}\n"
                  "{ findAndModify: \"collection\", query: {processed:false}, remove: true, sort: {priority:-1}}\n"
+                 "{ findAndModify: \"collection\", query: {processed:false}, update: {$set: {processed:true}}, batch: 10}\n"
                  "Either update or remove is required, all other fields have default values.\n"
-                 "Output is in the \"value\" field\n";
+                 "Output is in the \"value\" field\n"
+                 "With batch: n, up to n matching documents are claimed atomically and returned in \"values\".\n"
+                 "Batch mode does not support upsert or the $ positional operator.\n";
         }
 
         CmdFindAndModify() : Command("findAndModify", false, "findandmodify") { }
@@ -60,6 +63,60 @@ namespace mongo {
                     fields = NULL; // do projection in post-processing
             }
 
+            if (!cmdObj["batch"].eoo()) {
+                // batched claim mode for queue-style workloads: grab up to n
+                // matching documents in a single command.  we hold the write
+                // lock throughout, so the whole batch is claimed atomically and
+                // one lock acquisition and one query plan cover all of them,
+                // instead of one findAndModify round trip per document.
+                int batchSize = cmdObj["batch"].numberInt();
+                uassert(15926, "batch must be a positive number", batchSize > 0);
+                uassert(15927, "batch mode does not support upsert", !upsert);
+
+                bool remove = cmdObj["remove"].trueValue();
+                BSONElement update = cmdObj["update"];
+                if (remove)
+                    uassert(12515, "can't remove and update", update.eoo());
+                else
+                    uassert(12516, "must specify remove or update", !update.eoo());
+
+                vector<BSONObj> claimed;
+                {
+                    auto_ptr<DBClientCursor> c = db.query(ns, q, batchSize, 0, fields);
+                    while (c->more())
+                        claimed.push_back(c->next().getOwned());
+                }
+
+                BSONArrayBuilder values(result.subarrayStart("values"));
+                for (unsigned i = 0; i < claimed.size(); i++) {
+                    BSONObj out = claimed[i];
+
+                    if (remove)
+                        db.remove(ns, QUERY("_id" << out["_id"]), 1);
+                    else
+                        db.update(ns, QUERY("_id" << out["_id"]), update.embeddedObjectUserCheck());
+
+                    BSONObj gle = db.getLastErrorDetailed();
+                    if (gle["err"].type() == String) {
+                        values.done();
+                        result.append("lastErrorObject", gle);
+                        errmsg = gle["err"].String();
+                        return false;
+                    }
+
+                    if (!remove && cmdObj["new"].trueValue())
+                        out = db.findOne(ns, QUERY("_id" << out["_id"]), fields);
+
+                    if (!fieldsHolder.isEmpty() && !fields)
+                        out = projection.transform(out);
+
+                    values.append(out);
+                }
+                values.done();
+                result.append("n", (int)claimed.size());
+                return true;
+            }
+
             BSONObj out = db.findOne(ns, q, fields);
             if (out.isEmpty()) {
                 if (!upsert) {
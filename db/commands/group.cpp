@@ -24,6 +24,117 @@
 
 namespace mongo {
 
+    /* native accumulators for the group command - see GroupCommand::groupNative().
+       these run entirely in C++, so a declarative group-by never crosses the
+       JS boundary. */
+
+    enum AccumOp { AccumSum , AccumAvg , AccumMin , AccumMax , AccumPush , AccumCount };
+
+    struct AccumSpec {
+        string outField; // name in the result row
+        AccumOp op;
+        string inField;  // dotted path of the source value (unused for $count)
+    };
+
+    /* running state of one accumulator for one group */
+    struct AccumState {
+        AccumState() : sum(0) , count(0) {}
+        double sum;
+        long long count;
+        BSONObj minmax;         // single (unnamed) element holder; empty = nothing seen
+        vector<BSONObj> pushed; // single element holders, in scan order
+    };
+
+    static void parseAccumulators( const BSONObj& spec , vector<AccumSpec>& out ) {
+        BSONObjIterator i( spec );
+        while ( i.more() ) {
+            BSONElement e = i.next();
+            uassert( 15929 , "accumulator spec must be an object like { total : { $sum : 'x' } }" ,
+                     e.type() == Object );
+            BSONObj o = e.Obj();
+            uassert( 15930 , "accumulator needs exactly one operator" , o.nFields() == 1 );
+            BSONElement op = o.firstElement();
+
+            AccumSpec s;
+            s.outField = e.fieldName();
+            const char * name = op.fieldName();
+            if ( str::equals( name , "$sum" ) )
+                s.op = AccumSum;
+            else if ( str::equals( name , "$avg" ) )
+                s.op = AccumAvg;
+            else if ( str::equals( name , "$min" ) )
+                s.op = AccumMin;
+            else if ( str::equals( name , "$max" ) )
+                s.op = AccumMax;
+            else if ( str::equals( name , "$push" ) )
+                s.op = AccumPush;
+            else if ( str::equals( name , "$count" ) )
+                s.op = AccumCount;
+            else
+                uasserted( 15931 , str::stream() << "unknown group accumulator: " << name );
+
+            if ( s.op != AccumCount ) {
+                uassert( 15932 , "accumulator operand must be a field name string" , op.type() == String );
+                s.inField = op.String();
+            }
+            out.push_back( s );
+        }
+        uassert( 15933 , "no accumulators specified" , out.size() > 0 );
+    }
+
+    static unsigned hashKeyBytes( const BSONObj& o ) {
+        // FNV-1a over the raw key bytes
+        unsigned h = 2166136261u;
+        const char * p = o.objdata();
+        for ( int i = o.objsize(); i > 0; i-- , p++ ) {
+            h ^= (unsigned char) *p;
+            h *= 16777619;
+        }
+        return h;
+    }
+
+    enum { RunBatchDocs = 256 }; // documents gathered per yield point in the single group scan
+
+    /* fold a batch of extracted elements into a running sum.  the elements are
+       converted to a contiguous double array one run of same-typed values at a
+       time, so the bson type is dispatched once per run - via the unchecked
+       _number* accessors - rather than once per element, and the summation is a
+       plain loop over doubles.  non-numeric values are skipped, matching
+       isNumber() in the general path. */
+    static void sumElementRuns( const vector<BSONElement>& vals , double& sum , long long& count ) {
+        double buf[RunBatchDocs];
+        unsigned i = 0;
+        while ( i < vals.size() ) {
+            BSONType t = vals[i].type();
+            unsigned j = i + 1;
+            while ( j < vals.size() && vals[j].type() == t )
+                j++;
+            unsigned m = 0;
+            switch ( t ) {
+            case NumberDouble:
+                for ( unsigned k = i; k < j; k++ )
+                    buf[m++] = vals[k]._numberDouble();
+                break;
+            case NumberInt:
+                for ( unsigned k = i; k < j; k++ )
+                    buf[m++] = (double) vals[k]._numberInt();
+                break;
+            case NumberLong:
+                for ( unsigned k = i; k < j; k++ )
+                    buf[m++] = (double) vals[k]._numberLong();
+                break;
+            default:
+                break;
+            }
+            double s = 0;
+            for ( unsigned k = 0; k < m; k++ )
+                s += buf[k];
+            sum += s;
+            count += m;
+            i = j;
+        }
+    }
+
     class GroupCommand : public Command {
     public:
         GroupCommand() : Command("group") {}
@@ -31,7 +142,10 @@ namespace mongo {
         virtual bool slaveOk() const { return false; }
         virtual bool slaveOverrideOk() { return true; }
         virtual void help( stringstream &help ) const {
-            help << "http://www.mongodb.org/display/DOCS/Aggregation";
+            help << "http://www.mongodb.org/display/DOCS/Aggregation\n"
+                 << "instead of $reduce/initial, 'accumulators' selects native operators, e.g.\n"
+                 << "{ group : { ns : ... , key : { a : 1 } , accumulators : { total : { $sum : 'x' } , n : { $count : 1 } } } }\n"
+                 << "operators: $sum $avg $min $max $push $count";
         }
 
         BSONObj getKey( const BSONObj& obj , const BSONObj& keyPattern , ScriptingFunction func , double avgSize , Scope * s ) {
@@ -155,13 +269,238 @@ namespace mongo {
             return true;
         }
 
-        bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+        /* scan for the single group (empty key) case: every document lands in
+           the one group, so rather than updating accumulator state per document
+           we gather each source field's elements for a batch of documents and
+           fold them in with sumElementRuns().  the saved elements point into
+           the records themselves, so each batch is folded before the next
+           yield point. */
+        void singleGroupScan( const shared_ptr<Cursor>& cursor , ClientCursor::CleanupPointer& ccPointer ,
+                              const vector<AccumSpec>& accums , vector<AccumState>& st , long long& n ) {
+            vector< vector<BSONElement> > batch( accums.size() );
 
-            if ( !globalScriptEngine ) {
-                errmsg = "server-side JavaScript execution is disabled";
-                return false;
+            while ( cursor->ok() ) {
+
+                if ( !ccPointer->yieldSometimes( ClientCursor::WillNeed ) ||
+                    !cursor->ok() ) {
+                    break;
+                }
+
+                for ( int scanned = 0; cursor->ok() && scanned < RunBatchDocs; scanned++ ) {
+
+                    if ( ( cursor->matcher() && !cursor->matcher()->matchesCurrent( cursor.get() ) ) ||
+                        cursor->getsetdup( cursor->currLoc() ) ) {
+                        cursor->advance();
+                        continue;
+                    }
+
+                    BSONObj obj = cursor->current();
+                    cursor->advance();
+                    n++;
+
+                    for ( unsigned a = 0; a < accums.size(); a++ ) {
+                        if ( accums[a].op == AccumCount ) {
+                            st[a].count++;
+                            continue;
+                        }
+                        BSONElement v = obj.getFieldDotted( accums[a].inField );
+                        if ( !v.eoo() )
+                            batch[a].push_back( v );
+                    }
+                }
+
+                for ( unsigned a = 0; a < accums.size(); a++ ) {
+                    sumElementRuns( batch[a] , st[a].sum , st[a].count );
+                    batch[a].clear();
+                }
+            }
+        }
+
+        /* declarative group-by: one scan, groups kept in an open addressing
+           hash table (linear probing) keyed on the raw extracted key bytes.
+           no JS scope is ever entered, so this also works with scripting
+           disabled. */
+        bool groupNative( const string& ns , const BSONObj& query , const BSONObj& keyPattern ,
+                          const vector<AccumSpec>& accums , string& errmsg , BSONObjBuilder& result ) {
+
+            vector<int> table( 1024 , -1 );   // power of two; holds indexes into keys/groups
+            vector<unsigned> hashes;          // cached so rehashing doesn't rescan key bytes
+            vector<BSONObj> keys;
+            vector< vector<AccumState> > groups;
+            long long n = 0;
+
+            shared_ptr<Cursor> cursor = NamespaceDetailsTransient::getCursor(ns.c_str() , query);
+            ClientCursor::CleanupPointer ccPointer;
+            ccPointer.reset( new ClientCursor( QueryOption_NoCursorTimeout, cursor, ns ) );
+
+            // with an empty key everything is one group, and if the accumulators
+            // only ever touch sum/count state we can extract values in typed
+            // batches instead of walking the hash table per document.
+            bool runTyped = keyPattern.isEmpty();
+            for ( unsigned a = 0; a < accums.size() && runTyped; a++ )
+                runTyped = accums[a].op == AccumSum || accums[a].op == AccumAvg || accums[a].op == AccumCount;
+
+            if ( runTyped ) {
+                vector<AccumState> st( accums.size() );
+                singleGroupScan( cursor , ccPointer , accums , st , n );
+                if ( n ) {
+                    // same group the general loop would have made: key is {}
+                    keys.push_back( BSONObj() );
+                    groups.push_back( st );
+                }
+            }
+
+            while ( !runTyped && cursor->ok() ) {
+
+                if ( !ccPointer->yieldSometimes( ClientCursor::MaybeCovered ) ||
+                    !cursor->ok() ) {
+                    break;
+                }
+
+                if ( ( cursor->matcher() && !cursor->matcher()->matchesCurrent( cursor.get() ) ) ||
+                    cursor->getsetdup( cursor->currLoc() ) ) {
+                    cursor->advance();
+                    continue;
+                }
+
+                if ( !ccPointer->yieldSometimes( ClientCursor::WillNeed ) ||
+                    !cursor->ok() ) {
+                    break;
+                }
+
+                BSONObj obj = cursor->current();
+                cursor->advance();
+                n++;
+
+                BSONObj key = obj.extractFields( keyPattern , true );
+                unsigned h = hashKeyBytes( key );
+
+                int gi = -1;
+                unsigned mask = table.size() - 1;
+                for ( unsigned probe = h & mask; ; probe = ( probe + 1 ) & mask ) {
+                    int x = table[probe];
+                    if ( x == -1 ) {
+                        // new group
+                        gi = keys.size();
+                        uassert( 10043 , "group() can't handle more than 20000 unique keys" , gi < 20000 );
+                        table[probe] = gi;
+                        hashes.push_back( h );
+                        keys.push_back( key.getOwned() );
+                        groups.push_back( vector<AccumState>( accums.size() ) );
+                        break;
+                    }
+                    if ( hashes[x] == h && keys[x].binaryEqual( key ) ) {
+                        gi = x;
+                        break;
+                    }
+                }
+
+                if ( keys.size() * 2 > table.size() ) {
+                    // keep the load factor under 1/2
+                    vector<int> bigger( table.size() * 2 , -1 );
+                    unsigned bmask = bigger.size() - 1;
+                    for ( unsigned x = 0; x < keys.size(); x++ ) {
+                        unsigned probe = hashes[x] & bmask;
+                        while ( bigger[probe] != -1 )
+                            probe = ( probe + 1 ) & bmask;
+                        bigger[probe] = x;
+                    }
+                    table.swap( bigger );
+                }
+
+                vector<AccumState>& st = groups[gi];
+                for ( unsigned a = 0; a < accums.size(); a++ ) {
+                    const AccumSpec& spec = accums[a];
+                    AccumState& s = st[a];
+
+                    if ( spec.op == AccumCount ) {
+                        s.count++;
+                        continue;
+                    }
+
+                    BSONElement v = obj.getFieldDotted( spec.inField );
+                    if ( v.eoo() )
+                        continue;
+
+                    switch ( spec.op ) {
+                    case AccumSum:
+                    case AccumAvg:
+                        if ( v.isNumber() ) {
+                            s.sum += v.number();
+                            s.count++;
+                        }
+                        break;
+                    case AccumMin:
+                    case AccumMax: {
+                        int cmp = s.minmax.isEmpty() ? 0 : v.woCompare( s.minmax.firstElement() , false );
+                        if ( s.minmax.isEmpty() ||
+                             ( spec.op == AccumMin ? cmp < 0 : cmp > 0 ) ) {
+                            BSONObjBuilder b( v.size() + 8 );
+                            b.appendAs( v , "" );
+                            s.minmax = b.obj();
+                        }
+                        break;
+                    }
+                    case AccumPush: {
+                        BSONObjBuilder b( v.size() + 8 );
+                        b.appendAs( v , "" );
+                        s.pushed.push_back( b.obj() );
+                        break;
+                    }
+                    default:
+                        assert( false );
+                    }
+                }
+            }
+            ccPointer.reset();
+
+            BSONArrayBuilder arr( result.subarrayStart( "retval" ) );
+            for ( unsigned gi = 0; gi < keys.size(); gi++ ) {
+                BSONObjBuilder b( arr.subobjStart() );
+                b.appendElements( keys[gi] );
+                for ( unsigned a = 0; a < accums.size(); a++ ) {
+                    const AccumSpec& spec = accums[a];
+                    const AccumState& s = groups[gi][a];
+                    switch ( spec.op ) {
+                    case AccumSum:
+                        b.append( spec.outField , s.sum );
+                        break;
+                    case AccumCount:
+                        b.appendNumber( spec.outField , s.count );
+                        break;
+                    case AccumAvg:
+                        if ( s.count )
+                            b.append( spec.outField , s.sum / s.count );
+                        else
+                            b.appendNull( spec.outField );
+                        break;
+                    case AccumMin:
+                    case AccumMax:
+                        if ( s.minmax.isEmpty() )
+                            b.appendNull( spec.outField );
+                        else
+                            b.appendAs( s.minmax.firstElement() , spec.outField );
+                        break;
+                    case AccumPush: {
+                        BSONArrayBuilder vals( b.subarrayStart( spec.outField ) );
+                        for ( unsigned i = 0; i < s.pushed.size(); i++ )
+                            vals.append( s.pushed[i].firstElement() );
+                        vals.done();
+                        break;
+                    }
+                    }
+                }
+                b.done();
             }
-            
+            arr.done();
+
+            result.append( "count" , (double) n );
+            result.append( "keys" , (int) keys.size() );
+            return true;
+        }
+
+        bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+
             /* db.$cmd.findOne( { group : <p> } ) */
             const BSONObj& p = jsobj.firstElement().embeddedObjectUserCheck();
 
@@ -196,6 +535,21 @@ namespace mongo {
                 // no key specified, will use entire object as key
             }
 
+            if ( p["accumulators"].type() == Object ) {
+                // declarative native path - no JS involved
+                uassert( 15934 , "accumulators can't be combined with $reduce/initial/finalize" ,
+                         p["$reduce"].eoo() && p["initial"].eoo() && p["finalize"].eoo() );
+                uassert( 15935 , "accumulators can't be combined with $keyf" , keyf.empty() );
+                vector<AccumSpec> accums;
+                parseAccumulators( p["accumulators"].Obj() , accums );
+                return groupNative( ns , q , key , accums , errmsg , result );
+            }
+
+            if ( !globalScriptEngine ) {
+                errmsg = "server-side JavaScript execution is disabled";
+                return false;
+            }
+
             BSONElement reduce = p["$reduce"];
             if ( reduce.eoo() ) {
                 errmsg = "$reduce has to be set";
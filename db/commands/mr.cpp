@@ -26,6 +26,8 @@
 #include "../queryoptimizer.h"
 #include "../matcher.h"
 #include "../clientcursor.h"
+#include "../index.h"
+#include "../extsort.h"
 #include "../replutil.h"
 #include "../../s/d_chunk_manager.h"
 #include "../../s/d_logic.h"
@@ -320,29 +322,18 @@ namespace mongo {
             if ( ! _onDisk )
                 return;
 
-            if (_config.incLong != _config.tempLong) {
-                // create the inc collection and make sure we have index on "0" key
-                _db.dropCollection( _config.incLong );
-                {
-                    writelock l( _config.incLong );
-                    Client::Context ctx( _config.incLong );
-                    string err;
-                    if ( ! userCreateNS( _config.incLong.c_str() , BSON( "autoIndexId" << 0 ) , err , false ) ) {
-                        uasserted( 13631 , str::stream() << "userCreateNS failed for mr incLong ns: " << _config.incLong << " err: " << err );
-                    }
-                }
-
-                BSONObj sortKey = BSON( "0" << 1 );
-                _db.ensureIndex( _config.incLong , sortKey );
-            }
+            // note there is no longer an incremental collection to set up here -
+            // spilled tuples go to the external sorter's run files instead
 
-            // create temp collection
+            // create temp collection.  marked { temp : true } so a leftover
+            // from a crashed job is dropped at the next startup instead of
+            // lingering in the database
             _db.dropCollection( _config.tempLong );
             {
                 writelock lock( _config.tempLong.c_str() );
                 Client::Context ctx( _config.tempLong.c_str() );
                 string errmsg;
-                if ( ! userCreateNS( _config.tempLong.c_str() , BSONObj() , errmsg , true ) ) {
+                if ( ! userCreateNS( _config.tempLong.c_str() , BSON( "temp" << true ) , errmsg , true ) ) {
                     uasserted( 13630 , str::stream() << "userCreateNS failed for mr tempLong ns: " << _config.tempLong << " err: " << errmsg );
                 }
             }
@@ -448,31 +439,59 @@ namespace mongo {
                 _db.dropCollection( _config.tempLong );
             }
             else if ( _config.outType == Config::REDUCE ) {
-                // reduce: apply reduce op on new result and existing one
+                // reduce: merge-join the new results against the output collection
+                // in _id order.  a batch of new keys is matched with one index range
+                // scan over the output collection instead of a point lookup per key,
+                // and all reads for a batch finish before its writes begin.
+                const int maxBatch = 1000;
+                const int maxBatchBytes = 4 * 1024 * 1024;
                 BSONList values;
 
-                auto_ptr<DBClientCursor> cursor = _db.query( _config.tempLong , BSONObj() );
+                auto_ptr<DBClientCursor> cursor = _db.query( _config.tempLong , Query().sort( BSON( "_id" << 1 ) ) );
                 while ( cursor->more() ) {
-                    BSONObj temp = cursor->next();
-                    BSONObj old;
+                    // collect a batch of new results, in key order
+                    vector<BSONObj> batch;
+                    int batchBytes = 0;
+                    while ( cursor->more() && (int)batch.size() < maxBatch && batchBytes < maxBatchBytes ) {
+                        BSONObj temp = cursor->next().getOwned();
+                        batchBytes += temp.objsize();
+                        batch.push_back( temp );
+                    }
 
-                    bool found;
+                    // stream the existing docs for the batch's key range, keeping
+                    // only those matching a new key.  both sides are _id-ordered so
+                    // a single forward pass lines them up.
+                    vector<BSONObj> olds( batch.size() );
                     {
-                        Client::Context tx( _config.finalLong );
-                        found = Helpers::findOne( _config.finalLong.c_str() , temp["_id"].wrap() , old , true );
-                    }
+                        auto_ptr<DBClientCursor> existing =
+                            _db.query( _config.finalLong ,
+                                       QUERY( "_id" << GTE << batch.front()["_id"] << LTE << batch.back()["_id"] )
+                                           .sort( BSON( "_id" << 1 ) ) );
+                        unsigned i = 0;
+                        while ( existing->more() && i < batch.size() ) {
+                            BSONObj o = existing->next();
+                            while ( i < batch.size() && batch[i]["_id"].woCompare( o["_id"] , false ) < 0 )
+                                i++;
+                            if ( i < batch.size() && batch[i]["_id"].woCompare( o["_id"] , false ) == 0 ) {
+                                olds[i] = o.getOwned();
+                                i++;
+                            }
+                        }
+                    } // cursor over the output collection closed before we write to it
 
-                    if ( found ) {
-                        // need to reduce
-                        values.clear();
-                        values.push_back( temp );
-                        values.push_back( old );
-                        Helpers::upsert( _config.finalLong , _config.reducer->finalReduce( values , _config.finalizer.get() ) );
-                    }
-                    else {
-                        Helpers::upsert( _config.finalLong , temp );
+                    for ( unsigned i = 0; i < batch.size(); i++ ) {
+                        if ( olds[i].isEmpty() ) {
+                            // new key - no reduce needed
+                            Helpers::upsert( _config.finalLong , batch[i] );
+                        }
+                        else {
+                            values.clear();
+                            values.push_back( batch[i] );
+                            values.push_back( olds[i] );
+                            Helpers::upsert( _config.finalLong , _config.reducer->finalReduce( values , _config.finalizer.get() ) );
+                        }
+                        getDur().commitIfNeeded();
                     }
-                    getDur().commitIfNeeded();
                 }
                 _db.dropCollection( _config.tempLong );
             }
@@ -510,7 +529,22 @@ namespace mongo {
             getDur().commitIfNeeded();
         }
 
-        State::State( const Config& c ) : _config( c ), _size(0), _dupCount(0), _numEmits(0) {
+        /**
+         * Spill a tuple to the external sorter.  This replaces the old btree-indexed
+         * incremental collection: tuples are appended to sorted run files and merged
+         * back in key order for the final reduce, never round-tripping through the
+         * storage engine (no lock, no journal, no index maintenance).
+         */
+        void State::_spill( const BSONObj& o ) {
+            assert( _onDisk );
+            if ( ! _sorter ) {
+                _sorter.reset( new BSONObjExternalSorter( *IndexDetails::iis[1] , BSON( "0" << 1 ) ) );
+            }
+            _sorter->add( o , DiskLoc() );
+            _numSpilled++;
+        }
+
+        State::State( const Config& c ) : _config( c ), _size(0), _dupCount(0), _numSpilled(0), _numEmits(0) {
             _temp.reset( new InMemory() );
             _onDisk = _config.outType != Config::INMEMORY;
         }
@@ -669,89 +703,49 @@ namespace mongo {
                 return;
             }
 
-            // use index on "0" to pull sorted data
+            // stream the spilled tuples back merged in key order
             assert( _temp->size() == 0 );
             BSONObj sortKey = BSON( "0" << 1 );
-            {
-                bool foundIndex = false;
-
-                auto_ptr<DBClientCursor> idx = _db.getIndexes( _config.incLong );
-                while ( idx.get() && idx->more() ) {
-                    BSONObj x = idx->next();
-                    if ( sortKey.woCompare( x["key"].embeddedObject() ) == 0 ) {
-                        foundIndex = true;
-                        break;
-                    }
-                }
 
-                assert( foundIndex );
-            }
+            assert( pm == op->setMessage( "m/r: (3/3) final reduce to collection" , _numSpilled ) );
 
-            readlock rl( _config.incLong.c_str() );
-            Client::Context ctx( _config.incLong );
+            if ( ! _sorter ) {
+                // nothing was ever spilled
+                pm.finished();
+                return;
+            }
+            _sorter->sort();
 
             BSONObj prev;
             BSONList all;
 
-            assert( pm == op->setMessage( "m/r: (3/3) final reduce to collection" , _db.count( _config.incLong, BSONObj(), QueryOption_SlaveOk ) ) );
-
-            shared_ptr<Cursor> temp = bestGuessCursor( _config.incLong.c_str() , BSONObj() , sortKey );
-            auto_ptr<ClientCursor> cursor( new ClientCursor( QueryOption_NoCursorTimeout , temp , _config.incLong.c_str() ) );
-
-            // iterate over all sorted objects
-            while ( cursor->ok() ) {
-                BSONObj o = cursor->current().getOwned();
-                cursor->advance();
+            /* no database lock is held while we iterate - the spill files are ours
+               alone.  insert() below takes the write lock per result. */
+            auto_ptr<BSONObjExternalSorter::Iterator> it = _sorter->iterator();
+            while ( it->more() ) {
+                BSONObj o = it->next().first.getOwned();
 
                 pm.hit();
 
                 if ( o.woSortOrder( prev , sortKey ) == 0 ) {
                     // object is same as previous, add to array
                     all.push_back( o );
-                    if ( pm->hits() % 1000 == 0 ) {
-                        if ( ! cursor->yield() ) {
-                            cursor.release();
-                            break;
-                        }
-                        killCurrentOp.checkForInterrupt();
-                    }
                     continue;
                 }
 
-                ClientCursor::YieldLock yield (cursor.get());
-
-                try {
-                    // reduce a finalize array
-                    finalReduce( all );
-                }
-                catch (...) {
-                    yield.relock();
-                    cursor.release();
-                    throw;
-                }
+                // reduce and finalize the previous group, then start the next
+                finalReduce( all );
 
                 all.clear();
                 prev = o;
                 all.push_back( o );
 
-                if ( ! yield.stillOk() ) {
-                    cursor.release();
-                    break;
-                }
-
                 killCurrentOp.checkForInterrupt();
             }
-            
-            // we need to release here since we temp release below
-            cursor.release();
 
-            {
-                dbtempreleasecond tl;
-                if ( ! tl.unlocked() )
-                    log( LL_WARNING ) << "map/reduce can't temp release" << endl;
-                // reduce and finalize last array
-                finalReduce( all );
-            }
+            // reduce and finalize last array
+            finalReduce( all );
+            _sorter.reset();
 
             pm.finished();
         }
@@ -780,10 +774,8 @@ namespace mongo {
                 if ( all.size() == 1 ) {
                     // only 1 value for this key
                     if ( _onDisk ) {
-                        // this key has low cardinality, so just write to collection
-                        writelock l(_config.incLong);
-                        Client::Context ctx(_config.incLong.c_str());
-                        _insertToInc( *(all.begin()) );
+                        // this key has low cardinality, so just spill it
+                        _spill( *(all.begin()) );
                     }
                     else {
                         // add to new map
@@ -803,22 +795,19 @@ namespace mongo {
         }
 
         /**
-         * Dumps the entire in memory map to the inc collection.
+         * Dumps the entire in memory map to the external sorter.
          */
         void State::dumpToInc() {
             if ( ! _onDisk )
                 return;
 
-            writelock l(_config.incLong);
-            Client::Context ctx(_config.incLong);
-
             for ( InMemory::iterator i=_temp->begin(); i!=_temp->end(); i++ ) {
                 BSONList& all = i->second;
                 if ( all.size() < 1 )
                     continue;
 
                 for ( BSONList::iterator j=all.begin(); j!=all.end(); j++ )
-                    _insertToInc( *j );
+                    _spill( *j );
             }
             _temp->clear();
             _size = 0;
@@ -1051,7 +1040,7 @@ namespace mongo {
                     // do reduce in memory
                     // this will be the last reduce needed for inline mode
                     state.reduceInMemory();
-                    // if not inline: dump the in memory map to inc collection, all data is on disk
+                    // if not inline: dump the in memory map to the sorter, all data is on disk
                     state.dumpToInc();
                     // final reduce
                     state.finalReduce( op , pm );
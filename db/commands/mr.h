@@ -21,6 +21,8 @@
 
 namespace mongo {
 
+    class BSONObjExternalSorter;
+
     namespace mr {
 
         typedef vector<BSONObj> BSONList;
@@ -232,7 +234,7 @@ namespace mongo {
             void reduceInMemory();
 
             /**
-             * transfers in memory storage to temp collection
+             * transfers in memory storage to the external sorter spill files
              */
             void dumpToInc();
             void insertToInc( BSONObj& o );
@@ -289,6 +291,12 @@ namespace mongo {
 
             void _add( InMemory* im , const BSONObj& a , long& size );
 
+            /**
+             * hands a tuple to the external sorter spill files (append-only,
+             * merged back in key order for the final reduce)
+             */
+            void _spill( const BSONObj& o );
+
             scoped_ptr<Scope> _scope;
             bool _onDisk; // if the end result of this map reduce is disk or not
 
@@ -296,6 +304,9 @@ namespace mongo {
             long _size; // bytes in _temp
             long _dupCount; // number of duplicate key entries
 
+            scoped_ptr<BSONObjExternalSorter> _sorter; // spilled tuples, sorted by key
+            long long _numSpilled; // tuples handed to _sorter
+
             long long _numEmits;
 
             bool _jsMode;
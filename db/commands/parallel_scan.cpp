@@ -0,0 +1,125 @@
+// parallel_scan.cpp
+
+/**
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "../commands.h"
+#include "../instance.h"
+#include "../pdfile.h"
+#include "../cursor.h"
+#include "../clientcursor.h"
+
+namespace mongo {
+
+    /* table scan restricted to one partition's extents.  stops as soon as the
+       scan walks out of them; matching on the extent set rather than a single
+       end marker tolerates an extent emptying out mid-scan, in which case the
+       forward strategy skips it and can land past a simple boundary. */
+    class ExtentRangeCursor : public BasicCursor {
+    public:
+        ExtentRangeCursor( const DiskLoc& start , const set<DiskLoc>& extents )
+            : BasicCursor( start ) , _extents( extents ) { }
+        virtual string toString() { return "ExtentRangeCursor"; }
+        virtual bool advance() {
+            BasicCursor::advance();
+            if ( ! curr.isNull() && _extents.count( curr.rec()->myExtentLoc( curr ) ) == 0 ) {
+                last = curr;
+                curr = DiskLoc();
+            }
+            return ok();
+        }
+    private:
+        const set<DiskLoc> _extents;
+    };
+
+    /* partitions a collection's extent chain into disjoint ranges, one cursor
+       per range, so separate connections can scan them concurrently and
+       together saturate storage a single table scan cannot.  each cursor is a
+       normal ClientCursor - drive it with getMore as usual. */
+    class ParallelCollectionScanCmd : public Command {
+    public:
+        ParallelCollectionScanCmd() : Command( "parallelCollectionScan" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return READ; }
+        virtual void help( stringstream &help ) const {
+            help << "{ parallelCollectionScan : 'collection name' , numCursors : n }\n"
+                    "returns up to n cursor ids covering disjoint parts of the collection.\n"
+                    "documents inserted while the cursors are open may or may not be seen.";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + '.' + cmdObj.firstElement().valuestr();
+
+            int numCursors = cmdObj["numCursors"].numberInt();
+            uassert( 15955 , "numCursors must be between 1 and 128" , numCursors >= 1 && numCursors <= 128 );
+
+            NamespaceDetails * d = nsdetails( ns.c_str() );
+            uassert( 15956 , "ns does not exist" , d );
+            uassert( 15957 , "parallelCollectionScan not supported on capped collections" , ! d->capped );
+
+            // walk the extent chain once, noting each extent and its size
+            vector<DiskLoc> extents;
+            long long totalLen = 0;
+            for ( DiskLoc el = d->firstExtent; ! el.isNull(); el = el.ext()->xnext ) {
+                extents.push_back( el );
+                totalLen += el.ext()->length;
+            }
+
+            if ( numCursors > (int) extents.size() )
+                numCursors = (int) extents.size();
+
+            BSONArrayBuilder arr( result.subarrayStart( "cursors" ) );
+
+            // greedily assign contiguous extents to each partition, balancing
+            // on extent bytes so similarly sized ranges hit the disk evenly
+            unsigned i = 0;
+            for ( int c = 0; c < numCursors && i < extents.size(); c++ ) {
+                long long target = totalLen / ( numCursors - c );
+                long long len = 0;
+                set<DiskLoc> mine;
+                DiskLoc start;
+                while ( i < extents.size() && ( len < target || mine.empty() ) ) {
+                    // always leave one extent per remaining partition
+                    if ( (int) ( extents.size() - i ) <= numCursors - c - 1 && ! mine.empty() )
+                        break;
+                    Extent * e = extents[i].ext();
+                    if ( start.isNull() && ! e->firstRecord.isNull() )
+                        start = e->firstRecord;
+                    mine.insert( extents[i] );
+                    len += e->length;
+                    i++;
+                }
+                totalLen -= len;
+
+                if ( start.isNull() )
+                    continue; // nothing but empty extents in this range
+
+                shared_ptr<Cursor> cursor( new ExtentRangeCursor( start , mine ) );
+                ClientCursor * cc = new ClientCursor( 0 , cursor , ns );
+                BSONObjBuilder b( arr.subobjStart() );
+                b.append( "id" , (long long) cc->cursorid() );
+                b.append( "extents" , (int) mine.size() );
+                b.done();
+            }
+
+            arr.done();
+            result.append( "numExtents" , (int) extents.size() );
+            return true;
+        }
+
+    } parallelCollectionScanCmd;
+
+}
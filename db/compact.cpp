@@ -28,6 +28,9 @@
 #include "background.h"
 #include "extsort.h"
 #include "compact.h"
+#include "clientcursor.h"
+#include "instance.h"
+#include "../util/background.h"
 #include "../util/concurrency/task.h"
 
 namespace mongo {
@@ -134,6 +137,320 @@ namespace mongo {
         return skipped;
     }
 
+    /* unlink from the free lists any deleted records that live inside ext, so the
+       allocator cannot hand back space in the extent we are about to empty.  unlike
+       the full compact we leave entries in other extents alone - they stay usable
+       by the copies we are about to make. */
+    static void orphanDeletedRecordsInExtent(NamespaceDetails *d, const DiskLoc ext) {
+        for( int b = 0; b < Buckets; b++ ) {
+            DiskLoc prev;
+            DiskLoc cur = d->deletedList[b];
+            while( !cur.isNull() ) {
+                DeletedRecord *dr = cur.drec();
+                DiskLoc next = dr->nextDeleted;
+                if( cur.a() == ext.a() && dr->extentOfs == ext.getOfs() ) {
+                    if( prev.isNull() )
+                        d->deletedList[b].writing() = next;
+                    else
+                        prev.drec()->nextDeleted.writing() = next;
+                }
+                else {
+                    prev = cur;
+                }
+                cur = next;
+            }
+        }
+    }
+
+    /* move the index entries for a record from oldLoc to where compaction copied it.
+       the object bytes are identical so the key set is unchanged - we just retarget
+       each entry's DiskLoc.  newLoc may be null, meaning just remove the entries
+       (used for invalid objects that are not coming along). */
+    static void moveIndexEntries(NamespaceDetails *d, BSONObj& obj, const DiskLoc& oldLoc, const DiskLoc& newLoc) {
+        for( int x = 0; x < d->nIndexes; x++ ) {
+            IndexDetails& idx = d->idx(x);
+            IndexInterface& ii = idx.idxInterface();
+            Ordering ordering = Ordering::make(idx.keyPattern());
+            BSONObjSet keys;
+            idx.getKeysFromObject(obj, keys);
+            for( BSONObjSet::iterator k = keys.begin(); k != keys.end(); k++ ) {
+                /* unindex before inserting so a unique index never sees both copies */
+                bool found = ii.unindex(idx.head, idx, *k, oldLoc);
+                if( !found ) {
+                    RARELY warning() << "compact couldn't unindex key " << *k << " in " << idx.indexNamespace() << endl;
+                }
+                if( !newLoc.isNull() )
+                    ii.bt_insert(idx.head, newLoc, *k, ordering, /*dupsAllowed*/true, idx);
+            }
+        }
+    }
+
+    /** move every record out of the collection's first extent, maintaining the indexes
+        as we go, then unlink and free the extent.  unlike compactExtent() above the
+        indexes stay online throughout, so the namespace remains usable between passes.
+        @return number of skipped (invalid) documents */
+    static unsigned compactHeadExtent(const char *ns, NamespaceDetails *d, bool validate) {
+        DiskLoc ext = d->firstExtent;
+        Extent *e = ext.ext();
+        e->assertOk();
+        assert( e->validates() );
+        unsigned skipped = 0;
+
+        {
+            // the next/prev pointers within the extent might not be in order so we first page the whole thing in
+            // sequentially
+            log() << "compact paging in len=" << e->length/1000000.0 << "MB" << endl;
+            Timer t;
+            MAdvise adv(e, e->length, MAdvise::Sequential);
+            const char *p = (const char *) e;
+            for( int i = 0; i < e->length; i += 4096 ) {
+                faux += *p;
+            }
+            int ms = t.millis();
+            if( ms > 1000 )
+                log() << "compact end paging in " << ms << "ms " << e->length/1000000.0/ms << "MB/sec" << endl;
+        }
+
+        orphanDeletedRecordsInExtent(d, ext);
+
+        /* moving records invalidates any cursor positioned in this extent.  cheaper to
+           invalidate them all than to track which ones are affected. */
+        ClientCursor::invalidate(ns);
+
+        unsigned totalSize = 0;
+        int nrecs = 0;
+        DiskLoc L = e->firstRecord;
+        while( !L.isNull() ) {
+            DiskLoc old = L;
+            Record *recOld = L.rec();
+            L = recOld->nextInExtent(L);
+            nrecs++;
+            BSONObj objOld(recOld);
+
+            if( !validate || objOld.valid() ) {
+                unsigned sz = objOld.objsize();
+                unsigned lenWHdr = sz + Record::HeaderSize;
+                totalSize += lenWHdr;
+                DiskLoc loc = allocateSpaceForANewRecord(ns, d, lenWHdr, false);
+                uassert(15936, "compact error out of space during compaction", !loc.isNull());
+                Record *recNew = loc.rec();
+                recNew = (Record *) getDur().writingPtr(recNew, lenWHdr);
+                addRecordToRecListInExtent(recNew, loc);
+                memcpy(recNew->data, objOld.objdata(), sz);
+                moveIndexEntries(d, objOld, old, loc);
+            }
+            else {
+                if( ++skipped <= 10 )
+                    log() << "compact skipping invalid object" << endl;
+                try {
+                    /* the document is not coming along; scrub whatever index entries we can find for it */
+                    moveIndexEntries(d, objOld, old, DiskLoc());
+                }
+                catch( AssertionException& ) {
+                    problem() << "compact couldn't unindex invalid object at " << old.toString() << endl;
+                }
+            }
+
+            if( L.isNull() ) {
+                // we just did the very last record from the old extent.  it's still pointed to
+                // by the old extent ext, but that will be fixed below after this loop
+                break;
+            }
+
+            /* orphan the old records periodically so our commit block doesn't get too large.
+               the records already moved are indexed at their new locations, so the state on
+               disk is consistent after every commit - an interrupted pass resumes by simply
+               running the command again. */
+            bool stopping = false;
+            RARELY stopping = *killCurrentOp.checkForInterruptNoAssert(false) != 0;
+            if( stopping || getDur().aCommitIsNeeded() ) {
+                e->firstRecord.writing() = L;
+                Record *r = L.rec();
+                getDur().writingInt(r->prevOfs) = DiskLoc::NullOfs;
+                getDur().commitIfNeeded();
+                killCurrentOp.checkForInterrupt(false);
+            }
+        }
+
+        assert( d->firstExtent == ext );
+        assert( d->lastExtent != ext );
+        DiskLoc newFirst = e->xnext;
+        d->firstExtent.writing() = newFirst;
+        newFirst.ext()->xprev.writing().Null();
+        getDur().writing(e)->markEmpty();
+        freeExtents(ext,ext);
+        getDur().commitIfNeeded();
+
+        // the moved records never went through deleteRecord(), so upsert location
+        // hints into the freed extent are still cached - drop them before the
+        // write lock is released and an upsert can consult one
+        NamespaceDetailsTransient::get_w(ns).clearUpsertLocs();
+
+        log() << "compact " << nrecs << " documents " << totalSize/1000000.0 << "MB" << endl;
+
+        return skipped;
+    }
+
+    /** compact the collection one extent at a time, keeping the indexes online.  the
+        write lock is taken per extent and released in between, so other operations on
+        the namespace interleave.  progress lives in the extent chain itself - each
+        pass consumes d->firstExtent - so the operation resumes after a stop or
+        restart simply by running the command again. */
+    bool compactIncremental(const string& ns, string& errmsg, bool validate, int nExtents, BSONObjBuilder& result) {
+        massert( 15937, "bad ns", NamespaceString::normal(ns.c_str()) );
+        massert( 15938, "can't compact a system namespace", !str::contains(ns, ".system.") );
+
+        int done = 0;
+        long long skipped = 0;
+        long long remaining = 0;
+        for( int i = 0; i < nExtents; i++ ) {
+            writelock lk;
+            BackgroundOperation::assertNoBgOpInProgForNs(ns.c_str());
+            Client::Context ctx(ns);
+            NamespaceDetails *d = nsdetails(ns.c_str());
+            massert( 15939, str::stream() << "namespace " << ns << " does not exist", d );
+            massert( 15940, "cannot compact capped collection", !d->capped );
+
+            remaining = 0;
+            for( DiskLoc L = d->firstExtent; !L.isNull(); L = L.ext()->xnext )
+                remaining++;
+            if( remaining <= 1 ) {
+                /* can't empty the only extent - the records have nowhere else to go */
+                break;
+            }
+
+            log() << "compact " << ns << " extent begin (" << remaining << " extents)" << endl;
+            skipped += compactHeadExtent(ns.c_str(), d, validate);
+            done++;
+            remaining--;
+            log() << "compact " << ns << " extent end" << endl;
+
+            killCurrentOp.checkForInterrupt(false);
+        }
+
+        if( skipped )
+            result.append("invalidObjects", skipped);
+        result.append("extentsCompacted", done);
+        result.appendNumber("extentsRemaining", remaining);
+        result.appendBool("done", remaining <= 1);
+        return true;
+    }
+
+    /* --defrag : background reclamation of deleted space.
+
+       churny namespaces accumulate deleted records forever unless compact or
+       repairDatabase runs in a maintenance window.  this job watches the
+       freelists and, when a namespace is mostly dead space, runs head-extent
+       compaction passes (the same resumable machinery as
+       { compact : ..., incremental : true }) until it is healthy again.  each
+       pass empties one extent into the collection's remaining free space and
+       returns the empty extent to the database free list, holding the write
+       lock only for that pass.
+    */
+    class DefragJob : public BackgroundJob {
+    public:
+        string name() const { return "DefragJob"; }
+
+        /** @return true if the namespace is fragmented enough to repay a pass.
+            mostly-dead is the trigger: deleted bytes over half of live bytes,
+            with a floor so small namespaces never churn. */
+        bool fragmented(NamespaceDetails *d) {
+            if( d->capped )
+                return false;
+            int extents = 0;
+            for( DiskLoc L = d->firstExtent; !L.isNull(); L = L.ext()->xnext )
+                extents++;
+            if( extents <= 1 )
+                return false; // the records have nowhere else to go
+            long long counts[Buckets];
+            long long bytes[Buckets];
+            d->deletedListOccupancy(counts, bytes);
+            long long deleted = 0;
+            for( int i = 0; i < Buckets; i++ )
+                deleted += bytes[i];
+            return deleted > (long long)DefragMinBytes && deleted > d->stats.datasize / 2;
+        }
+
+        void doDB(const string& dbName) {
+            vector<string> colls;
+            {
+                DBDirectClient db;
+                auto_ptr<DBClientCursor> c = db.query(dbName + ".system.namespaces", BSONObj());
+                while( c->more() ) {
+                    string ns = c->next()["name"].String();
+                    if( NamespaceString::normal(ns.c_str()) && !str::contains(ns, ".system.") )
+                        colls.push_back(ns);
+                }
+            }
+
+            for( unsigned i = 0; i < colls.size(); i++ ) {
+                const string& ns = colls[i];
+                try {
+                    // quick look without blocking writers
+                    {
+                        readlock lk(ns);
+                        Client::Context ctx(ns);
+                        NamespaceDetails *d = nsdetails(ns.c_str());
+                        if( d == 0 || !fragmented(d) )
+                            continue;
+                    }
+
+                    // back off while there is queueing on the write lock; space
+                    // reclamation can always wait, pile-ups can't
+                    while( dbMutex.writersWaiting() + dbMutex.readersWaiting() > 2 && !inShutdown() )
+                        sleepmillis(100);
+                    if( inShutdown() )
+                        return;
+
+                    writelock lk;
+                    Client::Context ctx(ns);
+                    NamespaceDetails *d = nsdetails(ns.c_str());
+                    if( d == 0 || !fragmented(d) ) // re-check; the world may have changed
+                        continue;
+                    BackgroundOperation::assertNoBgOpInProgForNs(ns.c_str());
+                    log() << "defrag " << ns << " pass begin" << endl;
+                    unsigned skipped = compactHeadExtent(ns.c_str(), d, true);
+                    if( skipped )
+                        log() << "defrag " << ns << " skipped " << skipped << " invalid objects" << endl;
+                    log() << "defrag " << ns << " pass end" << endl;
+                }
+                catch( std::exception& e ) {
+                    log() << "defrag error on " << ns << ": " << e.what() << endl;
+                }
+            }
+        }
+
+        void run() {
+            Client::initThread("defrag");
+            cc().getAuthenticationInfo()->authorize("admin", "_defrag");
+            cc().setOpPriority( CurOp::LOW ); // maintenance yields to user ops
+
+            while( !inShutdown() ) {
+                sleepsecs(DefragSecs);
+                try {
+                    vector<string> dbs;
+                    getDatabaseNames(dbs);
+                    for( unsigned i = 0; i < dbs.size(); i++ ) {
+                        if( dbs[i] == "local" )
+                            continue;
+                        doDB(dbs[i]);
+                    }
+                }
+                catch( std::exception& e ) {
+                    log() << "defrag: error in pass: " << e.what() << endl;
+                }
+            }
+            cc().shutdown();
+        }
+
+    private:
+        enum { DefragSecs = 60, DefragMinBytes = 16 * 1024 * 1024 };
+    };
+
+    void startDefragBackgroundJob() {
+        (new DefragJob())->go();
+    }
+
     extern SortPhaseOne *precalced;
 
     bool _compact(const char *ns, NamespaceDetails *d, string& errmsg, bool validate, BSONObjBuilder& result) { 
@@ -149,8 +466,11 @@ namespace mongo {
 
         ProgressMeterHolder pm( cc().curop()->setMessage( "compact extent" , extents.size() ) );
 
-        // same data, but might perform a little different after compact?
-        NamespaceDetailsTransient::get_w(ns).clearQueryCache();
+        // every record is about to move and the old extents will be freed without
+        // individual deleteRecord() calls, so drop everything derived from record
+        // locations (cached upsert locs especially - a stale one would be read),
+        // along with the query cache since plans may perform differently after.
+        NamespaceDetailsTransient::clearForPrefix(ns);
 
         int nidx = d->nIndexes;
         scoped_array<IndexSpec> indexSpecs( new IndexSpec[nidx] );
@@ -170,6 +490,7 @@ namespace mongo {
                 }
                 BSONObj o = b.obj().getOwned();
                 phase1[x].sorter.reset( new BSONObjExternalSorter( idx.idxInterface(), o.getObjectField("key") ) );
+                phase1[x].sorter->setIndexKeys();
                 phase1[x].sorter->hintNumObjects( d->stats.nrecords );
                 indexSpecs[x++].reset(o);
             }
@@ -268,9 +589,12 @@ namespace mongo {
         virtual void help( stringstream& help ) const {
             help << "compact collection\n"
                 "warning: this operation blocks the server and is slow. you can cancel with cancelOp()\n"
-                "{ compact : <collection_name>, [force:true], [validate:true] }\n"
+                "{ compact : <collection_name>, [force:true], [validate:true], [incremental:true], [extents:<n>] }\n"
                 "  force - allows to run on a replica set primary\n"
-                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (default is true in this version)\n";
+                "  validate - check records are noncorrupt before adding to newly compacting extents. slower but safer (default is true in this version)\n"
+                "  incremental - compact extents one at a time, releasing the write lock in between and keeping\n"
+                "    the indexes online.  rerun until the result reports done:true; progress survives restarts.\n"
+                "  extents - with incremental, how many extents to do per invocation (default 1)\n";
         }
         virtual bool requiresAuth() { return true; }
         CompactCmd() : Command("compact") { }
@@ -282,13 +606,22 @@ namespace mongo {
                 return false;
             }
 
-            if( isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) { 
+            bool incremental = cmdObj["incremental"].trueValue();
+
+            if( !incremental && isCurrentlyAReplSetPrimary() && !cmdObj["force"].trueValue() ) {
                 errmsg = "will not run compact on an active replica set primary as this is a slow blocking operation. use force:true to force";
                 return false;
             }
 
             string ns = db + '.' + coll;
             bool validate = !cmdObj.hasElement("validate") || cmdObj["validate"].trueValue(); // default is true at the moment
+
+            if( incremental ) {
+                int nExtents = cmdObj["extents"].isNumber() ? cmdObj["extents"].numberInt() : 1;
+                uassert( 15941, "extents must be >= 1", nExtents >= 1 );
+                return compactIncremental(ns, errmsg, validate, nExtents, result);
+            }
+
             bool ok = compact(ns, errmsg, validate, result);
             return ok;
         }
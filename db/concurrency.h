@@ -19,10 +19,11 @@
 /*mongod concurrency rules & notes will be placed here.
 
    Mutex heirarchy (1 = "leaf")
-     name                   level
-     Logstream::mutex       1
-     ClientCursor::ccmutex  2
-     dblock                 3
+     name                        level
+     Logstream::mutex            1
+     ClientCursor id shard mx    2
+     Database::ccByLocMutex      2.5 (may take an id shard mx, never vice versa)
+     dblock                      3
 
      End func name with _inlock to indicate "caller must lock before calling".
 */
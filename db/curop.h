@@ -47,6 +47,7 @@ namespace mongo {
         // basic options
         int op;
         bool iscommand;
+        unsigned traceId;          // cross-tier correlation id, 0 if the client sent none
         Namespace ns;
         BSONObj query;
         BSONObj updateobj;
@@ -200,6 +201,14 @@ namespace mongo {
 
         void markCommand() { _command = true; }
 
+        /* scheduling class.  low priority ops yield earlier and stay off the
+           lock longer whenever anyone else is queued, so interactive work is
+           not stuck behind maintenance (reindex, ttl deletes, sync). */
+        enum Priority { LOW = -1 , NORMAL = 0 };
+        int getPriority() const     { return _priority; }
+        void setPriority( int p )   { _priority = p; }
+        bool isLowPriority() const  { return _priority < 0; }
+
         void waitingForLock( int type ) {
             _waitingForLock = true;
             if ( type > 0 )
@@ -292,6 +301,39 @@ namespace mongo {
         CurOp *parent() const { return _wrapped; }
         void kill() { _killed = true; }
         bool killed() const { return _killed; }
+
+        /** server side time limit for this operation.  0 = no limit (the default). */
+        void setMaxTimeMicros( unsigned long long m ) { _maxTimeMicros = m; }
+
+        /** deadline check cheap enough for per-document scan loops: the clock
+            is only consulted once every 64 calls, so a runaway scan notices
+            within milliseconds without a gettimeofday per object. */
+        bool maxTimeExpired() {
+            if ( _maxTimeMicros == 0 )
+                return false;
+            if ( ( ++_maxTimeCheckTicks & 0x3F ) != 0 )
+                return false;
+            return curTimeMicros64() - startTime() > _maxTimeMicros;
+        }
+        /** per-op cap in bytes on the transient memory noted below.
+            0 = no limit (the default).  set via setParameter maxOpMemoryMB. */
+        static long long maxOpMemoryBytes;
+
+        /** attribute transient memory allocated on behalf of this op.  only the
+            big consumers bother (in-memory sorts, external sort batches, parsed
+            $in ranges) - this is attribution, not a malloc hook.  asserts if the
+            op crosses maxOpMemoryBytes so a pathological query fails cleanly
+            instead of letting the OOM killer pick a victim. */
+        void noteMemUsed( long long bytes );
+
+        void noteMemFreed( long long bytes ) {
+            _memUsed -= bytes;
+            if ( _memUsed < 0 )
+                _memUsed = 0;
+        }
+
+        long long memUsed() const { return _memUsed; }
+
         void yielded() { _numYields++; }
         void setNS(const char *ns) {
             strncpy(_ns, ns, Namespace::MaxNsLen);
@@ -310,6 +352,7 @@ namespace mongo {
         int _op;
         bool _command;
         int _lockType; // see concurrency.h for values
+        int _priority; // see Priority above
         bool _waitingForLock;
         int _dbprofile; // 0=off, 1=slow, 2=all
         AtomicUInt _opNum;
@@ -321,10 +364,14 @@ namespace mongo {
         ProgressMeter _progressMeter;
         volatile bool _killed;
         int _numYields;
+        unsigned long long _maxTimeMicros; // 0 = no limit
+        unsigned _maxTimeCheckTicks;
+        long long _memUsed; // bytes, see noteMemUsed()
 
         void _reset() {
             _command = false;
             _lockType = 0;
+            _priority = _client->opPriority();
             _dbprofile = 0;
             _end = 0;
             _waitingForLock = false;
@@ -332,6 +379,9 @@ namespace mongo {
             _progressMeter.finished();
             _killed = false;
             _numYields = 0;
+            _maxTimeMicros = 0;
+            _maxTimeCheckTicks = 0;
+            _memUsed = 0;
         }
     };
 
@@ -35,6 +35,11 @@ namespace mongo {
             curr = s->next( curr );
         }
         incNscanned();
+        if ( ok() && s == forward() && curr.a() != _advisedFile ) {
+            // a table scan reads the file front to back - let the kernel read ahead
+            cc().database()->getFile( curr.a() )->flagAccessPattern( MAdvise::Sequential );
+            _advisedFile = curr.a();
+        }
         return ok();
     }
 
@@ -163,4 +168,120 @@ namespace mongo {
 
         return i;
     }
+
+    RandomSampleCursor::RandomSampleCursor( NamespaceDetails *d, int numWanted ) :
+        _totalLength(), _remaining( numWanted ), _nscanned() {
+        _rand = ( ( (unsigned long long) rand() ) << 32 ) ^ curTimeMicros64();
+        if ( _rand == 0 )
+            _rand = 0x2545f4914f6cdd1dULL; // xorshift state must be nonzero
+        if ( d ) {
+            for( DiskLoc el = d->firstExtent; !el.isNull(); el = el.ext()->xnext ) {
+                Extent *e = el.ext();
+                if ( !e->firstRecord.isNull() ) {
+                    _totalLength += e->length;
+                    _extents.push_back( make_pair( el, _totalLength ) );
+                }
+            }
+        }
+        next();
+    }
+
+    unsigned long long RandomSampleCursor::random64() {
+        // xorshift - cheap and plenty random for sampling
+        unsigned long long x = _rand;
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        _rand = x;
+        return x;
+    }
+
+    bool RandomSampleCursor::advance() {
+        killCurrentOp.checkForInterrupt();
+        if ( _curr.isNull() )
+            return false;
+        return next();
+    }
+
+    bool RandomSampleCursor::next() {
+        _curr = DiskLoc();
+        if ( _totalLength == 0 || _remaining <= 0 )
+            return false;
+        // a draw can miss - e.g. its forward probe is cut off by a long run of
+        // freed space - so retry a bounded number of times
+        for( int attempt = 0; attempt < 100; ++attempt ) {
+            ++_nscanned;
+            DiskLoc loc = randomRecord();
+            if ( !loc.isNull() ) {
+                --_remaining;
+                _curr = loc;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    DiskLoc RandomSampleCursor::randomRecord() {
+        // draw an extent weighted by its length
+        unsigned long long pick = random64() % _totalLength;
+        unsigned lo = 0, hi = _extents.size() - 1;
+        while( lo < hi ) {
+            unsigned mid = ( lo + hi ) / 2;
+            if ( pick < _extents[ mid ].second )
+                hi = mid;
+            else
+                lo = mid + 1;
+        }
+        Extent *e = _extents[ lo ].first.ext();
+        int dataLen = e->length - Extent::HeaderSize();
+        if ( dataLen <= Record::HeaderSize )
+            return DiskLoc();
+        int rel = Extent::HeaderSize() + (int)( random64() % (unsigned long long) dataLen );
+        return probeExtent( e, rel );
+    }
+
+    DiskLoc RandomSampleCursor::probeExtent( Extent *e, int rel ) const {
+        const int base = e->myLoc.getOfs();
+        const int end = e->length;                 // offsets below are relative to the extent
+        const int firstRel = Extent::HeaderSize();
+        if ( rel < firstRel )
+            rel = firstRel;
+        rel = ( rel + 3 ) & ~3;
+        int steps = 4096; // bound the forward probe; the caller retries elsewhere
+        for( ; rel + Record::HeaderSize <= end && steps--; rel += 4 ) {
+            Record *r = (Record *) ( ( (char *) e ) + rel );
+            if ( r->extentOfs != base )
+                continue;
+            if ( r->lengthWithHeaders < Record::HeaderSize + 5 ||
+                 r->lengthWithHeaders > end - rel )
+                continue;
+            // the doubly linked record chain gives a strong check that this is
+            // a live record start rather than data bytes or a freed record
+            if ( r->nextOfs == DiskLoc::NullOfs ) {
+                if ( e->lastRecord.getOfs() != base + rel )
+                    continue;
+            }
+            else {
+                if ( r->nextOfs < base + firstRel || r->nextOfs + Record::HeaderSize > base + end )
+                    continue;
+                Record *n = e->getRecord( DiskLoc( e->myLoc.a(), r->nextOfs ) );
+                if ( n->prevOfs != base + rel )
+                    continue;
+            }
+            if ( r->prevOfs == DiskLoc::NullOfs ) {
+                if ( e->firstRecord.getOfs() != base + rel )
+                    continue;
+            }
+            else {
+                if ( r->prevOfs < base + firstRel || r->prevOfs + Record::HeaderSize > base + end )
+                    continue;
+                Record *p = e->getRecord( DiskLoc( e->myLoc.a(), r->prevOfs ) );
+                if ( p->nextOfs != base + rel )
+                    continue;
+            }
+            return DiskLoc( e->myLoc.a(), base + rel );
+        }
+        return DiskLoc();
+    }
+
 } // namespace mongo
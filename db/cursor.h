@@ -26,13 +26,14 @@ namespace mongo {
 
     class NamespaceDetails;
     class Record;
+    class Extent;
     class CoveredIndexMatcher;
 
     /* Query cursors, base class.  This is for our internal cursors.  "ClientCursor" is a separate
        concept and is for the user's cursor.
 
-       WARNING concurrency: the vfunctions below are called back from within a
-       ClientCursor::ccmutex.  Don't cause a deadlock, you've been warned.
+       WARNING concurrency: the vfunctions below are called back from within
+       ClientCursor registry mutexes.  Don't cause a deadlock, you've been warned.
     */
     class Cursor : boost::noncopyable {
     public:
@@ -193,7 +194,8 @@ namespace mongo {
         bool tailable_;
         shared_ptr< CoveredIndexMatcher > _matcher;
         long long _nscanned;
-        void init() { tailable_ = false; }
+        int _advisedFile; // last datafile flagged for sequential access
+        void init() { tailable_ = false; _advisedFile = -1; }
     };
 
     /* used for order { $natural: -1 } */
@@ -228,4 +230,52 @@ namespace mongo {
         NamespaceDetails *nsd;
     };
 
+    /**
+     * Returns approximately uniform random samples of a collection without
+     * scanning it: an extent is drawn from the extent chain weighted by
+     * length, then a random offset within it is probed for a valid record
+     * header.  Sampling is with replacement, so the same document may be
+     * returned more than once.  Runs under a continuously held read lock
+     * (no yield support).
+     */
+    class RandomSampleCursor : public Cursor {
+    public:
+        /** @param numWanted maximum number of samples to return */
+        RandomSampleCursor( NamespaceDetails *d, int numWanted );
+        virtual bool ok() { return !_curr.isNull(); }
+        virtual Record* _current() {
+            assert( ok() );
+            return _curr.rec();
+        }
+        virtual BSONObj current() {
+            Record *r = _current();
+            BSONObj j(r);
+            return j;
+        }
+        virtual DiskLoc currLoc() { return _curr; }
+        virtual bool advance();
+        /** This cursor will be ignored for yielding by the client cursor implementation. */
+        virtual DiskLoc refLoc() { return DiskLoc(); }
+        virtual bool supportGetMore() { return false; }
+        virtual bool supportYields() { return false; }
+        /** sampling is with replacement, so duplicates are deliberate */
+        virtual bool getsetdup(DiskLoc loc) { return false; }
+        virtual bool isMultiKey() const { return false; }
+        virtual bool modifiedKeys() const { return false; }
+        virtual long long nscanned() { return _nscanned; }
+        virtual string toString() { return "RandomSampleCursor"; }
+    private:
+        bool next();
+        DiskLoc randomRecord();
+        DiskLoc probeExtent( Extent *e, int ofs ) const;
+        unsigned long long random64();
+        // (extent location, cumulative length) for a weighted draw
+        vector< pair<DiskLoc, unsigned long long> > _extents;
+        unsigned long long _totalLength;
+        int _remaining;
+        long long _nscanned;
+        DiskLoc _curr;
+        unsigned long long _rand; // xorshift state
+    };
+
 } // namespace mongo
@@ -163,12 +163,29 @@ namespace mongo {
         if ( p == 0 ) {
             boost::filesystem::path fullName = fileName( n );
             string fullNameString = fullName.string();
-            p = new MongoDataFile(n);
             int minSize = 0;
-            if ( n != 0 && files[ n - 1 ] )
+            if ( n != 0 && n - 1 < (int) files.size() && files[ n - 1 ] )
                 minSize = files[ n - 1 ]->getHeader()->fileLength;
             if ( sizeNeeded + DataFileHeader::HeaderSize > minSize )
                 minSize = sizeNeeded + DataFileHeader::HeaderSize;
+            if ( !preallocateOnly ) {
+                // adopt a file the warmer mapped in the background, if there
+                // is one - then crossing the boundary is just this swap plus
+                // the header init
+                p = DataFileWarmer::get()->take( fullNameString, minSize );
+                if ( p ) {
+                    try {
+                        p->finishOpen();
+                    }
+                    catch ( AssertionException& ) {
+                        delete p;
+                        throw;
+                    }
+                    files[n] = p;
+                    return p;
+                }
+            }
+            p = new MongoDataFile(n);
             try {
                 p->open( fullNameString.c_str(), minSize, preallocateOnly );
             }
@@ -187,8 +204,15 @@ namespace mongo {
     MongoDataFile* Database::addAFile( int sizeNeeded, bool preallocateNextFile ) {
         int n = (int) files.size();
         MongoDataFile *ret = getFile( n, sizeNeeded );
-        if ( preallocateNextFile )
-            preallocateAFile();
+        if ( preallocateNextFile ) {
+            preallocateRunway();
+            if ( cmdLine.prealloc )
+                // also map the next file ahead of need, so the next boundary
+                // crossing is a pointer swap in getFile() rather than an mmap
+                // under the write lock
+                DataFileWarmer::get()->request( fileName( n + 1 ).string(), n + 1,
+                                                files[ n ]->getHeader()->fileLength );
+        }
         return ret;
     }
 
@@ -80,6 +80,16 @@ namespace mongo {
          */
         void preallocateAFile() { getFile( numFiles() , 0, true ); }
 
+        /**
+         * keeps --preallocFiles spare files requested ahead of the newest
+         * mapped file, so crossing a file boundary under an insert burst
+         * doesn't wait on zero filling
+         */
+        void preallocateRunway() {
+            for( int i = 0; i < cmdLine.preallocFiles; i++ )
+                getFile( numFiles() + i , 0, true );
+        }
+
         MongoDataFile* suitableFile( const char *ns, int sizeNeeded, bool preallocate, bool enforceQuota );
 
         Extent* allocExtent( const char *ns, int size, bool capped, bool enforceQuota );
@@ -127,6 +137,10 @@ namespace mongo {
         int profile; // 0=off.
         const string profileName; // "alleyinsider.system.profile"
         CCByLoc ccByLoc;
+        // guards ccByLoc.  may be held while taking a ClientCursor id shard
+        // mutex (capped cursors die during an aboutToDelete scan), never the
+        // reverse - see the lock ordering note in clientcursor.h.
+        boost::recursive_mutex ccByLocMutex;
         int magic; // used for making sure the object is still loaded in memory
     };
 
@@ -35,6 +35,8 @@
 #include "cmdline.h"
 #include "stats/snapshots.h"
 #include "../util/concurrency/task.h"
+#include "../util/concurrency/thread_pool.h"
+#include "../util/file.h"
 #include "../util/version.h"
 #include "../util/ramlog.h"
 #include "../util/net/message_server.h"
@@ -42,7 +44,10 @@
 #include "restapi.h"
 #include "dbwebserver.h"
 #include "dur.h"
+#include "dur_journalformat.h"
 #include "concurrency.h"
+#include "ttl.h"
+#include "ops/insertqueue.h"
 #include "../s/d_writeback.h"
 
 #if defined(_WIN32)
@@ -71,6 +76,7 @@ namespace mongo {
 
     void setupSignals( bool inFork );
     void startReplication();
+    void startDefragBackgroundJob(); // compact.cpp
     void exitCleanly( ExitCode code );
 
     CmdLine cmdLine;
@@ -158,11 +164,18 @@ namespace mongo {
     class MyMessageHandler : public MessageHandler {
     public:
         virtual void connected( AbstractMessagingPort* p ) {
-            Client& c = Client::initThread("conn", p);
-            c.getAuthenticationInfo()->isLocalHost = p->remote().isLocalHost();
+            /* Client state is allocated lazily in process().  many connections
+               (monitor probes, load balancer health checks, reconnect storms)
+               come and go without ever issuing an operation, and connection
+               setup is hot when an app tier reconnects per request. */
         }
 
         virtual void process( Message& m , AbstractMessagingPort* port , LastError * le) {
+            if ( !currentClient.get() ) {
+                Client& c = Client::initThread("conn", port);
+                c.getAuthenticationInfo()->isLocalHost = port->remote().isLocalHost();
+            }
+
             while ( true ) {
                 if ( inShutdown() ) {
                     log() << "got request after shutdown()" << endl;
@@ -187,7 +200,8 @@ namespace mongo {
                             BufBuilder b(512);
                             b.appendNum((int) 0 /*size set later in appendData()*/);
                             b.appendNum(header->id);
-                            b.appendNum(header->responseTo);
+                            // responseTo carries the trace id on requests (see message.h)
+                            b.appendNum( currentTraceId() ? (int) currentTraceId() : -1 );
                             b.appendNum((int) dbGetMore);
                             b.appendNum((int) 0);
                             b.appendStr(ns);
@@ -211,6 +225,16 @@ namespace mongo {
             globalScriptEngine->threadDone();
         }
 
+        // event-driven server support: the connection's Client travels with the
+        // connection, not the worker thread.  see MessageHandler declaration.
+        virtual void* suspended( AbstractMessagingPort* p ) {
+            return currentClient.release();
+        }
+        virtual void resumed( AbstractMessagingPort* p , void* state ) {
+            assert( currentClient.get() == 0 );
+            currentClient.reset( static_cast<Client*>( state ) );
+        }
+
     };
 
     void listen(int port) {
@@ -261,6 +285,42 @@ namespace mongo {
         return repairDatabase( dbName.c_str(), errmsg );
     }
 
+    /** quick pdfile version check used at startup.  reads each database's
+        first datafile header directly, off a worker pool, so a node with many
+        databases doesn't pay a serial database open per db before it can
+        listen.  databases that fail the check (or whose header can't be read)
+        are flagged for the full serial pass, which reports errors properly. */
+    class PdfileVersionCheck {
+    public:
+        PdfileVersionCheck() : _mutex( "PdfileVersionCheck" ) {}
+        void check( string dbName ) { // runs on a ThreadPool worker
+            bool current = false;
+            try {
+                boost::filesystem::path p( dbpath );
+                if ( directoryperdb )
+                    p /= dbName;
+                p /= ( dbName + ".0" );
+                File f;
+                f.open( p.string().c_str(), /*readOnly*/ true );
+                if ( f.is_open() ) {
+                    int v[ 2 ]; // DataFileHeader version, versionMinor
+                    f.read( 0, (char *) v, sizeof( v ) );
+                    current = !f.bad() && v[ 0 ] == VERSION && v[ 1 ] == VERSION_MINOR;
+                }
+            }
+            catch ( ... ) {
+            }
+            if ( !current ) {
+                scoped_lock lk( _mutex );
+                _flagged.push_back( dbName );
+            }
+        }
+        vector< string > flagged() const { return _flagged; }
+    private:
+        mongo::mutex _mutex;
+        vector< string > _flagged;
+    };
+
     // ran at startup.
     static void repairDatabasesAndCheckVersion() {
         //        LastError * le = lastError.get( true );
@@ -273,6 +333,19 @@ namespace mongo {
         dblock lk;
         vector< string > dbNames;
         getDatabaseNames( dbNames );
+
+        if ( !forceRepair && dbNames.size() > 1 ) {
+            // narrow the serial pass below to the databases that actually need
+            // attention; up to date databases are then not opened at all until
+            // first use, after the listener is up
+            PdfileVersionCheck vc;
+            ThreadPool pool( (int) std::min( dbNames.size(), (size_t) 8 ) );
+            for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
+                pool.schedule( boost::bind( &PdfileVersionCheck::check, &vc, *i ) );
+            }
+            pool.join();
+            dbNames = vc.flagged();
+        }
         for ( vector< string >::iterator i = dbNames.begin(); i != dbNames.end(); ++i ) {
             string dbName = *i;
             log(1) << "\t" << dbName << endl;
@@ -337,6 +410,18 @@ namespace mongo {
         Client::GodScope gs;
         vector< string > toDelete;
         DBDirectClient cli;
+
+        // collections created with { temp : true } (e.g. map-reduce
+        // intermediates) are only meaningful to the process that made them
+        vector< string > dbNames;
+        getDatabaseNames( dbNames );
+        for ( vector< string >::iterator d = dbNames.begin(); d != dbNames.end(); ++d ) {
+            string nsListNs = *d + ".system.namespaces";
+            auto_ptr< DBClientCursor > c = cli.query( nsListNs, Query( BSON( "options.temp" << true ) ) );
+            while( c->more() )
+                toDelete.push_back( c->next().getStringField( "name" ) );
+        }
+
         auto_ptr< DBClientCursor > c = cli.query( "local.system.namespaces", Query( fromjson( "{name:/^local.temp./}" ) ) );
         while( c->more() ) {
             BSONObj o = c->next();
@@ -380,7 +465,11 @@ namespace mongo {
                 }
 
                 Date_t start = jsTime();
-                int numFiles = MemoryMappedFile::flushAll( true );
+                /* spread the per-file msyncs across half the sync interval
+                   instead of bursting them all at once - the data is just as
+                   durable (worst case page age grows by half an interval) but
+                   the io no longer arrives as a sawtooth */
+                int numFiles = MemoryMappedFile::flushAllPaced( cmdLine.syncdelay > 0 ? (int)(cmdLine.syncdelay * 1000 / 2) : 0 );
                 time_flushing = (int) (jsTime() - start);
 
                 globalFlushCounters.flushed(time_flushing);
@@ -404,6 +493,13 @@ namespace mongo {
 
         Client::initThread("initandlisten");
 
+        if( cmdLine.numaInterleave ) {
+            // set the policy before anything allocates or maps so it is
+            // inherited by every thread we spawn from here - dur, the datafile
+            // syncer, the listener and its connection threads
+            numaInterleaveThisThread();
+        }
+
         Logstream::get().addGlobalTee( new RamLog("global") );
 
         bool is32bit = sizeof(int*) == 4;
@@ -476,9 +572,15 @@ namespace mongo {
         /* this is for security on certain platforms (nonce generation) */
         srand((unsigned) (curTimeMicros() ^ startupSrandTimer.micros()));
 
-        snapshotThread.go();
+        if ( cmdLine.cpu )
+            snapshotThread.go();
         clientCursorMonitor.go();
         PeriodicTask::theRunner->go();
+        startTTLBackgroundJob();
+        if ( cmdLine.defrag )
+            startDefragBackgroundJob();
+        if ( cmdLine.asyncInserts )
+            startInsertQueueWriter();
 
         listen(listenPort);
 
@@ -559,6 +661,7 @@ int main(int argc, char* argv[]) {
     CmdLine::addGlobalOptions( general_options , hidden_options );
 
     general_options.add_options()
+    ("asyncInserts", "apply inserts via a background writer - relaxed visibility, use getLastError to wait for your writes")
     ("auth", "run with security")
     ("cpu", "periodically show cpu and iowait utilization")
     ("dbpath", po::value<string>() , "directory for datafiles")
@@ -567,16 +670,19 @@ int main(int argc, char* argv[]) {
     ("journal", "enable journaling")
     ("journalOptions", po::value<int>(), "journal diagnostic options")
     ("journalCommitInterval", po::value<unsigned>(), "how often to group/batch commit (ms)")
+    ("journalStreams", po::value<unsigned>(), "number of journal file streams to hash databases across")
     ("ipv6", "enable IPv6 support (disabled by default)")
     ("jsonp","allow JSONP access via http (has security implications)")
     ("noauth", "run without security")
     ("nohttpinterface", "disable http interface")
     ("nojournal", "disable journaling (journaling is on by default for 64 bit)")
     ("noprealloc", "disable data file preallocation - will often hurt performance")
+    ("preallocFiles", po::value<int>(), "number of spare datafiles to keep allocated ahead of need per database (default 1)")
     ("noscripting", "disable scripting engine")
     ("notablescan", "do not allow table scans")
     ("nssize", po::value<int>()->default_value(16), ".ns file size (in MB) for new databases")
     ("profile",po::value<int>(), "0=off 1=slow, 2=all")
+    ("defrag", "background compaction of namespaces with heavy deleted space")
     ("quota", "limits each database to a certain number of files (8 default)")
     ("quotaFiles", po::value<int>(), "number of files allower per db, requires --quota")
     ("rest","turn on simple rest api")
@@ -585,6 +691,7 @@ int main(int argc, char* argv[]) {
     ("slowms",po::value<int>(&cmdLine.slowMS)->default_value(100), "value of slow for profile and console log" )
     ("smallfiles", "use a smaller default file size")
 #if defined(__linux__)
+    ("numaInterleave", "interleave memory and mappings across NUMA nodes (alternative to numactl --interleave=all)")
     ("shutdown", "kill a running server (for init scripts)")
 #endif
     ("syncdelay",po::value<double>(&cmdLine.syncdelay)->default_value(60), "seconds between disk syncs (0=never, but not recommended)")
@@ -622,6 +729,7 @@ int main(int argc, char* argv[]) {
 
     hidden_options.add_options()
     ("pretouch", po::value<int>(), "n pretouch threads for applying replicationed operations")
+    ("indexBuildThreads", po::value<int>(), "n scan/sort threads for foreground index builds")
     ("command", po::value< vector<string> >(), "command")
     ("cacheSize", po::value<long>(), "cache size (in MB) for rec store")
     ("nodur", "disable journaling (currently the default)")
@@ -715,6 +823,9 @@ int main(int argc, char* argv[]) {
         if (params.count("cpu")) {
             cmdLine.cpu = true;
         }
+        if (params.count("defrag")) {
+            cmdLine.defrag = true;
+        }
         if (params.count("noauth")) {
             noauth = true;
         }
@@ -749,6 +860,13 @@ int main(int argc, char* argv[]) {
                 dbexit( EXIT_BADOPTIONS );
             }
         }
+        if( params.count("journalStreams") ) {
+            cmdLine.journalStreams = params["journalStreams"].as<unsigned>();
+            if( cmdLine.journalStreams < 1 || cmdLine.journalStreams > dur::MaxJournalStreams ) {
+                out() << "--journalStreams out of allowed range (1-" << dur::MaxJournalStreams << ")" << endl;
+                dbexit( EXIT_BADOPTIONS );
+            }
+        }
         if (params.count("journalOptions")) {
             cmdLine.durOptions = params["journalOptions"].as<int>();
         }
@@ -759,6 +877,16 @@ int main(int argc, char* argv[]) {
                 dbexit( EXIT_BADOPTIONS );
             }
         }
+        if (params.count("preallocFiles")) {
+            cmdLine.preallocFiles = params["preallocFiles"].as<int>();
+            if (cmdLine.preallocFiles < 1 || cmdLine.preallocFiles > 100) {
+                out() << "--preallocFiles out of allowed range (1-100)" << endl;
+                dbexit( EXIT_BADOPTIONS );
+            }
+        }
+        if (params.count("numaInterleave")) {
+            cmdLine.numaInterleave = true;
+        }
         if (params.count("nocursors")) {
             useCursors = false;
         }
@@ -813,6 +941,9 @@ int main(int argc, char* argv[]) {
         if (params.count("notablescan")) {
             cmdLine.noTableScan = true;
         }
+        if (params.count("asyncInserts")) {
+            cmdLine.asyncInserts = true;
+        }
         if (params.count("master")) {
             replSettings.master = true;
         }
@@ -840,6 +971,13 @@ int main(int argc, char* argv[]) {
         if( params.count("pretouch") ) {
             cmdLine.pretouch = params["pretouch"].as<int>();
         }
+        if( params.count("indexBuildThreads") ) {
+            cmdLine.indexBuildThreads = params["indexBuildThreads"].as<int>();
+            if( cmdLine.indexBuildThreads < 1 || cmdLine.indexBuildThreads > 64 ) {
+                out() << "--indexBuildThreads out of allowed range (1-64)" << endl;
+                dbexit( EXIT_BADOPTIONS );
+            }
+        }
         if (params.count("replSet")) {
             if (params.count("slavedelay")) {
                 out() << "--slavedelay cannot be used with --replSet" << endl;
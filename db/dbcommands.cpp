@@ -22,6 +22,7 @@
 
 #include "pch.h"
 #include "ops/query.h"
+#include "ops/insertqueue.h"
 #include "pdfile.h"
 #include "jsobj.h"
 #include "../bson/util/builder.h"
@@ -31,7 +32,10 @@
 #include "../util/lruishmap.h"
 #include "../util/md5.hpp"
 #include "../util/processinfo.h"
+#include "../util/file_allocator.h"
 #include "../util/ramlog.h"
+#include "../util/compress.h"
+#include "../util/net/message_port.h"
 #include "json.h"
 #include "repl.h"
 #include "repl_block.h"
@@ -44,10 +48,12 @@
 #include "queryoptimizer.h"
 #include "../scripting/engine.h"
 #include "stats/counters.h"
+#include "stats/indexstats.h"
 #include "background.h"
 #include "../util/version.h"
 #include "../s/d_writeback.h"
 #include "dur_stats.h"
+#include "lockstats.h"
 
 namespace mongo {
 
@@ -55,15 +61,24 @@ namespace mongo {
         void setAgeOutJournalFiles(bool rotate);
     }
     /** @return true if fields found */
-    bool setParmsMongodSpecific(const string& dbname, BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) { 
+    bool setParmsMongodSpecific(const string& dbname, BSONObj& cmdObj, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+        bool found = false;
         BSONElement e = cmdObj["ageOutJournalFiles"];
         if( !e.eoo() ) {
             bool r = e.trueValue();
             log() << "ageOutJournalFiles " << r << endl;
             dur::setAgeOutJournalFiles(r);
-            return true;
+            found = true;
+        }
+        e = cmdObj["maxOpMemoryMB"];
+        if( !e.eoo() ) {
+            long long mb = e.numberLong();
+            uassert( 15997 , "maxOpMemoryMB can't be negative" , mb >= 0 );
+            CurOp::maxOpMemoryBytes = mb * 1024 * 1024;
+            log() << "setParameter maxOpMemoryMB=" << mb << endl;
+            found = true;
         }
-        return false;
+        return found;
     }
 
     void flushDiagLog();
@@ -120,6 +135,12 @@ namespace mongo {
                  << "  { wtimeout:m} - timeout for w in m milliseconds";
         }
         bool run(const string& dbname, BSONObj& _cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            if ( cmdLine.asyncInserts ) {
+                // inserts this connection staged must be applied before we
+                // report on them or a subsequent read can see them
+                InsertQueue::global.waitUntilDrained();
+            }
+
             LastError *le = lastError.disableForCommand();
 
             bool err = false;
@@ -224,7 +245,13 @@ namespace mongo {
 
                     assert( sprintf( buf , "w block pass: %lld" , ++passes ) < 30 );
                     c.curop()->setMessage( buf );
-                    sleepmillis(1);
+                    /* park until a slave report can have changed the verdict;
+                       updateSlaveLocation() wakes us directly when one does.  the
+                       cap keeps wtimeout and killOp checks responsive. */
+                    int maxSleep = 100;
+                    if ( timeout > 0 && timeout - t.millis() < maxSleep )
+                        maxSleep = (int)( timeout - t.millis() ) + 1;
+                    waitForReplicatedEnough( op , e , maxSleep );
                     killCurrentOp.checkForInterrupt();
                 }
                 result.appendNumber( "wtime" , t.millis() );
@@ -444,7 +471,7 @@ namespace mongo {
             result.appendDate( "localTime" , jsTime() );
 
             {
-                BSONObjBuilder t;
+                BSONObjBuilder t( result.subobjStart( "globalLock" ) );
 
                 unsigned long long last, start, timeLocked;
                 dbMutex.info().getTimingInfo(start, timeLocked);
@@ -477,7 +504,7 @@ namespace mongo {
 
 
 
-                result.append( "globalLock" , t.obj() );
+                t.done();
             }
             timeBuilder.appendNumber( "after basic" , Listener::getElapsedTimeMillis() - start );
 
@@ -550,15 +577,31 @@ namespace mongo {
                 bb.done();
             }
 
+            {
+                // pending drains to 0 once the preallocation runway is topped up
+                BSONObjBuilder bb( result.subobjStart( "fileAllocator" ) );
+                bb.append( "runway" , cmdLine.preallocFiles );
+                bb.append( "pending" , FileAllocator::get()->pendingAllocations() );
+                bb.appendBool( "failed" , FileAllocator::get()->hasFailed() );
+                bb.done();
+            }
+
             {
                 BSONObjBuilder bb( result.subobjStart( "cursors" ) );
                 ClientCursor::appendStats( bb );
                 bb.done();
             }
 
+            if ( cmdLine.asyncInserts ) {
+                BSONObjBuilder bb( result.subobjStart( "insertQueue" ) );
+                InsertQueue::global.appendStats( bb );
+                bb.done();
+            }
+
             {
                 BSONObjBuilder bb( result.subobjStart( "network" ) );
                 networkCounter.append( bb );
+                bb.appendNumber( "accepts" , Listener::acceptCount() );
                 bb.done();
             }
 
@@ -580,6 +623,31 @@ namespace mongo {
 
             result.append( "opcounters" , globalOpCounters.getObj() );
 
+            {
+                BSONObjBuilder bb( result.subobjStart( "latencyHistograms" ) );
+                bb.append( "note" , "bin names are exclusive upper bounds in microseconds" );
+                Top::global.appendLatencyStats( bb );
+                bb.done();
+            }
+
+            {
+                BSONObjBuilder bb( result.subobjStart( "lockStats" ) );
+                writeLockStats.append( bb );
+                bb.done();
+            }
+
+            {
+                // sampled residency probes; per collection detail via the
+                // workingSet command
+                BSONObjBuilder bb( result.subobjStart( "workingSet" ) );
+                Top::CollectionData g = Top::global.getGlobalData();
+                bb.appendNumber( "checks" , g.faultChecks );
+                bb.appendNumber( "faults" , g.faults );
+                bb.done();
+            }
+
+            timeBuilder.appendNumber( "after latency" , Listener::getElapsedTimeMillis() - start );
+
             {
                 BSONObjBuilder asserts( result.subobjStart( "asserts" ) );
                 asserts.append( "regular" , assertionCount.regular );
@@ -592,6 +660,34 @@ namespace mongo {
 
             timeBuilder.appendNumber( "after asserts" , Listener::getElapsedTimeMillis() - start );
 
+            {
+                // current ops using the most noted transient memory (see
+                // CurOp::noteMemUsed - sorts, external sort batches, $in
+                // parsing).  attribution only covers the big allocators.
+                BSONObjBuilder bb( result.subobjStart( "opMemory" ) );
+                bb.appendNumber( "maxOpMemoryBytes" , CurOp::maxOpMemoryBytes );
+                multimap<long long,BSONObj> byMem;
+                {
+                    scoped_lock bl(Client::clientsMutex);
+                    for( set<Client*>::const_iterator i = Client::clients.begin(); i != Client::clients.end(); i++ ) {
+                        CurOp * co = (*i)->curop();
+                        if ( co == 0 || ! co->active() || co->memUsed() == 0 )
+                            continue;
+                        BSONObjBuilder t;
+                        t.append( "opid" , co->opNum() );
+                        t.append( "ns" , co->getNS() );
+                        t.appendNumber( "memUsed" , co->memUsed() );
+                        byMem.insert( make_pair( co->memUsed() , t.obj() ) );
+                    }
+                }
+                BSONArrayBuilder top( bb.subarrayStart( "top" ) );
+                int n = 0;
+                for( multimap<long long,BSONObj>::reverse_iterator i = byMem.rbegin(); i != byMem.rend() && n < 5; i++, n++ )
+                    top.append( i->second );
+                top.done();
+                bb.done();
+            }
+
             result.append( "writeBacksQueued" , ! writeBackManager.queuesEmpty() );
 
             if( cmdLine.dur ) {
@@ -630,6 +726,285 @@ namespace mongo {
         time_t started;
     } cmdServerStatus;
 
+    /** a slim serverStatus for monitoring tools: returns only the requested
+        counter sections, with numeric fields already converted to deltas since
+        the caller's previous call (matched up via the returned token).  a
+        monitor polling every second transfers a few hundred bytes instead of
+        the full serverStatus payload, and the expensive sections aren't
+        computed at all.  mongostat --discover uses this.
+    */
+    class CmdStatusDelta : public Command {
+    public:
+        CmdStatusDelta() : Command( "statusDelta" ) , _mutex( "statusDelta" ) , _nextToken( 1 ) { }
+
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+
+        virtual void help( stringstream& help ) const {
+            help << "slim serverStatus for monitoring: numeric fields are deltas since the caller's last call\n";
+            help << "{ statusDelta : 1 , token : <from last reply> , sections : [ 'opcounters' , ... ] }";
+        }
+
+        bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            bool authed = cc().getAuthenticationInfo()->isAuthorizedReads("admin");
+
+            BSONObjBuilder cb;
+            if ( cmdObj["sections"].type() == Array ) {
+                BSONObjIterator i( cmdObj["sections"].Obj() );
+                while ( i.more() ) {
+                    BSONElement e = i.next();
+                    uassert( 15971 , "sections entries must be strings" , e.type() == String );
+                    appendSection( e.String() , cb , authed );
+                }
+            }
+            else {
+                static const char * defaults[] = { "opcounters" , "opcountersRepl" , "globalLock" , "mem" , "connections" ,
+                                                   "extra_info" , "indexCounters" , "backgroundFlushing" , "network" , "repl" , 0 };
+                for ( int i = 0; defaults[i]; i++ )
+                    appendSection( defaults[i] , cb , authed );
+            }
+            BSONObj cur = cb.obj();
+
+            unsigned long long now = curTimeMillis64();
+            BSONObj prev;
+            unsigned long long prevWhen = 0;
+            {
+                scoped_lock lk( _mutex );
+
+                map<long long,Snapshot>::iterator i = _snapshots.find( cmdObj["token"].numberLong() );
+                if ( i != _snapshots.end() ) {
+                    prev = i->second.data;
+                    prevWhen = i->second.when;
+                    _snapshots.erase( i );
+                }
+
+                // monitors that went away must not leak their snapshots
+                for ( map<long long,Snapshot>::iterator j = _snapshots.begin(); j != _snapshots.end(); ) {
+                    if ( now - j->second.when > 10 * 60 * 1000 )
+                        _snapshots.erase( j++ );
+                    else
+                        ++j;
+                }
+                uassert( 15972 , "too many statusDelta monitors" , _snapshots.size() < 1000 );
+
+                long long token = _nextToken++;
+                Snapshot& s = _snapshots[token];
+                s.when = now;
+                s.data = cur;
+                result.append( "token" , token );
+            }
+
+            if ( prev.isEmpty() ) {
+                // first call, or our snapshot of this caller expired
+                result.appendBool( "initial" , true );
+                result.appendElements( cur );
+            }
+            else {
+                result.append( "dtMillis" , (long long)( now - prevWhen ) );
+                diffNumeric( cur , prev , result );
+            }
+            return true;
+        }
+
+    private:
+        struct Snapshot {
+            unsigned long long when;
+            BSONObj data;
+        };
+
+        /** numeric fields become (cur - prev); subobjects recurse; everything
+            else passes through as-is.  a caller can rebuild absolute values by
+            summing, so mixing counters and gauges in one section is fine. */
+        static void diffNumeric( const BSONObj& cur , const BSONObj& prev , BSONObjBuilder& b ) {
+            BSONObjIterator i( cur );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                BSONElement p = prev[e.fieldName()];
+                if ( e.type() == Object && p.type() == Object ) {
+                    BSONObjBuilder sub( b.subobjStart( e.fieldName() ) );
+                    diffNumeric( e.Obj() , p.Obj() , sub );
+                    sub.done();
+                }
+                else if ( e.isNumber() && p.isNumber() ) {
+                    if ( e.type() == NumberDouble || p.type() == NumberDouble )
+                        b.append( e.fieldName() , e.numberDouble() - p.numberDouble() );
+                    else
+                        b.appendNumber( e.fieldName() , (long long)( e.numberLong() - p.numberLong() ) );
+                }
+                else {
+                    b.append( e );
+                }
+            }
+        }
+
+        void appendSection( const string& name , BSONObjBuilder& result , bool authed ) {
+            if ( name == "opcounters" ) {
+                result.append( "opcounters" , globalOpCounters.getObj() );
+            }
+            else if ( name == "opcountersRepl" ) {
+                if ( anyReplEnabled() )
+                    result.append( "opcountersRepl" , replOpCounters.getObj() );
+            }
+            else if ( name == "globalLock" ) {
+                BSONObjBuilder t( result.subobjStart( "globalLock" ) );
+
+                unsigned long long last, start, timeLocked;
+                dbMutex.info().getTimingInfo(start, timeLocked);
+                last = curTimeMicros64();
+                t.append( "totalTime" , (double)( last - start ) );
+                t.append( "lockTime" , (double)timeLocked );
+
+                {
+                    BSONObjBuilder ttt( t.subobjStart( "currentQueue" ) );
+                    int w=0, r=0;
+                    Client::recommendedYieldMicros( &w , &r );
+                    ttt.append( "total" , w + r );
+                    ttt.append( "readers" , r );
+                    ttt.append( "writers" , w );
+                    ttt.done();
+                }
+                {
+                    BSONObjBuilder ttt( t.subobjStart( "activeClients" ) );
+                    int w=0, r=0;
+                    Client::getActiveClientCount( w , r );
+                    ttt.append( "total" , w + r );
+                    ttt.append( "readers" , r );
+                    ttt.append( "writers" , w );
+                    ttt.done();
+                }
+                t.done();
+            }
+            else if ( name == "mem" ) {
+                BSONObjBuilder t( result.subobjStart( "mem" ) );
+                t.append( "bits" , ( sizeof(int*) == 4 ? 32 : 64 ) );
+                ProcessInfo p;
+                if ( p.supported() ) {
+                    t.appendNumber( "resident" , p.getResidentSize() );
+                    t.appendNumber( "virtual" , p.getVirtualMemorySize() );
+                    t.appendBool( "supported" , true );
+                }
+                else {
+                    t.appendBool( "supported" , false );
+                }
+                int m = (int) (MemoryMappedFile::totalMappedLength() / ( 1024 * 1024 ));
+                t.appendNumber( "mapped" , m );
+                if ( cmdLine.dur )
+                    t.appendNumber( "mappedWithJournal" , m * 2 );
+                t.done();
+            }
+            else if ( name == "connections" ) {
+                BSONObjBuilder bb( result.subobjStart( "connections" ) );
+                bb.append( "current" , connTicketHolder.used() );
+                bb.append( "available" , connTicketHolder.available() );
+                bb.done();
+            }
+            else if ( name == "extra_info" ) {
+                BSONObjBuilder bb( result.subobjStart( "extra_info" ) );
+                ProcessInfo p;
+                p.getExtraInfo(bb);
+                bb.done();
+            }
+            else if ( name == "indexCounters" ) {
+                BSONObjBuilder bb( result.subobjStart( "indexCounters" ) );
+                globalIndexCounters.append( bb );
+                bb.done();
+            }
+            else if ( name == "backgroundFlushing" ) {
+                BSONObjBuilder bb( result.subobjStart( "backgroundFlushing" ) );
+                globalFlushCounters.append( bb );
+                bb.done();
+            }
+            else if ( name == "network" ) {
+                BSONObjBuilder bb( result.subobjStart( "network" ) );
+                networkCounter.append( bb );
+                bb.appendNumber( "accepts" , Listener::acceptCount() );
+                bb.done();
+            }
+            else if ( name == "repl" ) {
+                if ( anyReplEnabled() ) {
+                    BSONObjBuilder bb( result.subobjStart( "repl" ) );
+                    appendReplicationInfo( bb , authed , 0 );
+                    bb.done();
+                }
+            }
+            else {
+                uasserted( 15973 , str::stream() << "unknown statusDelta section: " << name );
+            }
+        }
+
+        mongo::mutex _mutex;
+        map<long long,Snapshot> _snapshots; // keyed by the token we handed out
+        long long _nextToken;
+    } cmdStatusDelta;
+
+    struct ConnIpTotals {
+        ConnIpTotals() : conns(0), ops(0), bytesIn(0), bytesOut(0) {}
+        int conns;
+        long long ops;
+        long long bytesIn;
+        long long bytesOut;
+    };
+
+    class CmdConnStats : public Command {
+    public:
+        CmdConnStats() : Command( "connStats" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "op and byte counters per client ip, from the per-connection counters.\n";
+            help << "{ connStats : 1 , detail : true } also lists every connection.";
+        }
+        virtual bool run(const string&, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            bool detail = cmdObj["detail"].trueValue();
+
+            map<string,ConnIpTotals> byIp;
+            BSONArrayBuilder conns;
+            {
+                scoped_lock bl(Client::clientsMutex);
+                for( set<Client*>::iterator i = Client::clients.begin(); i != Client::clients.end(); i++ ) {
+                    AbstractMessagingPort *mp = (*i)->port();
+                    if ( ! mp )
+                        continue;
+
+                    HostAndPort remote = mp->remote();
+                    ConnIpTotals& t = byIp[ remote.host() ];
+                    t.conns++;
+                    t.ops += mp->connOps();
+                    t.bytesIn += mp->connBytesIn();
+                    t.bytesOut += mp->connBytesOut();
+
+                    if ( detail ) {
+                        BSONObjBuilder b( conns.subobjStart() );
+                        b.append( "remote" , remote.toString() );
+                        b.appendNumber( "ops" , mp->connOps() );
+                        b.appendNumber( "bytesIn" , mp->connBytesIn() );
+                        b.appendNumber( "bytesOut" , mp->connBytesOut() );
+                        b.done();
+                    }
+                }
+            }
+
+            {
+                BSONObjBuilder ips( result.subobjStart( "byIp" ) );
+                for ( map<string,ConnIpTotals>::const_iterator i = byIp.begin(); i != byIp.end(); ++i ) {
+                    BSONObjBuilder b( ips.subobjStart( i->first ) );
+                    b.append( "conns" , i->second.conns );
+                    b.appendNumber( "ops" , i->second.ops );
+                    b.appendNumber( "bytesIn" , i->second.bytesIn );
+                    b.appendNumber( "bytesOut" , i->second.bytesOut );
+                    b.done();
+                }
+                ips.done();
+            }
+
+            if ( detail )
+                result.append( "connections" , conns.arr() );
+
+            return true;
+        }
+    } cmdConnStats;
+
     class CmdGetOpTime : public Command {
     public:
         virtual bool slaveOk() const {
@@ -975,6 +1350,38 @@ namespace mongo {
         }
     } cmdReIndex;
 
+    /** runtime control of background index builds.
+        { indexBuildControl : 1 [, maxDocsPerSec : <n>] [, pause : <bool>] }
+        maxDocsPerSec 0 means unthrottled.  always returns the current settings
+        plus progress of any builds in flight (docs done, last indexed DiskLoc),
+        so { indexBuildControl : 1 } alone is a pure status query. */
+    class CmdIndexBuildControl : public Command {
+    public:
+        CmdIndexBuildControl() : Command( "indexBuildControl" ) { }
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "throttle, pause or watch background index builds\n";
+            help << "{ indexBuildControl : 1 [, maxDocsPerSec : <n>] [, pause : <bool>] }";
+        }
+        bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool /*fromRepl*/) {
+            if ( cmdObj["maxDocsPerSec"].isNumber() ) {
+                int n = cmdObj["maxDocsPerSec"].numberInt();
+                uassert( 15976 , "maxDocsPerSec cannot be negative" , n >= 0 );
+                bgIndexBuildControl.setMaxDocsPerSec( n );
+            }
+            if ( !cmdObj["pause"].eoo() ) {
+                bool b = cmdObj["pause"].trueValue();
+                if ( b != bgIndexBuildControl.paused() )
+                    tlog() << "CMD: indexBuildControl " << ( b ? "pause" : "resume" ) << endl;
+                bgIndexBuildControl.setPaused( b );
+            }
+            bgIndexBuildControl.appendInfo( result );
+            return true;
+        }
+    } cmdIndexBuildControl;
+
     class CmdListDatabases : public Command {
     public:
         virtual bool slaveOk() const {
@@ -1164,6 +1571,109 @@ namespace mongo {
         }
     } cmdFileMD5;
 
+    char touchFaux; // sink for the page-in reads below; never examined
+
+    /** walk the extents of a namespace and read a byte per page so the data is
+        faulted into the file system cache before queries need it.  the raw
+        pointers stay valid after we give up the db lock because we hold
+        MongoFile::mmmutex shared, which blocks unmapping.
+    */
+    struct TouchLocation {
+        const char *p;
+        int len;
+    };
+
+    static void touchNs( const string& ns ) {
+        vector< TouchLocation > locs;
+        {
+            readlock lk(ns);
+            Client::Context ctx(ns);
+            NamespaceDetails *nsd = nsdetails(ns.c_str());
+            uassert( 15912 , str::stream() << "namespace " << ns << " does not exist" , nsd );
+            for( DiskLoc L = nsd->firstExtent; !L.isNull(); L = L.ext()->xnext ) {
+                Extent *e = L.ext();
+                TouchLocation tl = { (const char *) e , e->length };
+                locs.push_back( tl );
+            }
+        }
+
+        RWLockRecursive::Shared lk(MongoFile::mmmutex);
+
+        string msg = str::stream() << "touch " << ns << " extents";
+        ProgressMeterHolder pm( cc().curop()->setMessage( msg.c_str() , locs.size() ) );
+        for( vector<TouchLocation>::iterator i = locs.begin(); i != locs.end(); ++i ) {
+            MAdvise adv( (void*)i->p , i->len , MAdvise::Sequential );
+            const char *p = i->p;
+            for( int ofs = 0; ofs < i->len; ofs += 4096 )
+                touchFaux += p[ofs];
+            pm.hit();
+            killCurrentOp.checkForInterrupt(false);
+        }
+        pm.finished();
+    }
+
+    class TouchCmd : public Command {
+    public:
+        virtual LockType locktype() const { return NONE; }
+        virtual bool adminOnly() const { return false; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool maintenanceMode() const { return true; }
+        virtual bool logTheOp() { return false; }
+        virtual void help( stringstream& help ) const {
+            help << "touch collection\n"
+                "Page in all pages of memory containing every extent for the given collection\n"
+                "{ touch : <collection_name>, [data : true] , [index : true] }\n"
+                " at least one of data or index must be true; default is both are false\n";
+        }
+        virtual bool requiresAuth() { return true; }
+        TouchCmd() : Command("touch") { }
+
+        virtual bool run(const string& db, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            string coll = cmdObj.firstElement().valuestr();
+            if( coll.empty() || db.empty() ) {
+                errmsg = "no collection name specified";
+                return false;
+            }
+            string ns = db + '.' + coll;
+            if ( ! NamespaceString::normal(ns.c_str()) ) {
+                errmsg = "bad namespace name";
+                return false;
+            }
+
+            bool touch_indexes( cmdObj["index"].trueValue() );
+            bool touch_data( cmdObj["data"].trueValue() );
+            if ( ! (touch_indexes || touch_data) ) {
+                errmsg = "must specify at least one of (data:true, index:true)";
+                return false;
+            }
+
+            if( touch_data ) {
+                log() << "touch " << ns << " data" << endl;
+                touchNs( ns );
+            }
+
+            if( touch_indexes ) {
+                // enumerate the index namespaces under the lock, touch them after releasing it
+                vector<string> indexes;
+                {
+                    readlock lk(ns);
+                    Client::Context ctx(ns);
+                    NamespaceDetails *nsd = nsdetails(ns.c_str());
+                    uassert( 15913 , str::stream() << "namespace " << ns << " does not exist" , nsd );
+                    NamespaceDetails::IndexIterator ii = nsd->ii();
+                    while( ii.more() )
+                        indexes.push_back( ii.next().indexNamespace() );
+                }
+                for( vector<string>::iterator i = indexes.begin(); i != indexes.end(); ++i ) {
+                    log() << "touch " << *i << endl;
+                    touchNs( *i );
+                }
+            }
+
+            return true;
+        }
+    } touchCmd;
+
     static IndexDetails *cmdIndexDetailsForRange( const char *ns, string &errmsg, BSONObj &min, BSONObj &max, BSONObj &keyPattern ) {
         if ( ns[ 0 ] == '\0' || min.isEmpty() || max.isEmpty() ) {
             errmsg = "invalid command syntax (note: min and max are required)";
@@ -1293,6 +1803,57 @@ namespace mongo {
         }
     }
 
+    class CollSample : public Command {
+    public:
+        CollSample() : Command( "collSample", false, "collsample" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return READ; }
+        virtual void help( stringstream &help ) const {
+            help << "{ collSample:\"blog.posts\" , size : 10 }\n"
+                    "    returns approximately uniform random samples of a collection\n"
+                    "    without scanning it.  sampling is with replacement.";
+        }
+        bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + "." + jsobj.firstElement().valuestr();
+            Client::Context cx( ns );
+
+            NamespaceDetails *nsd = nsdetails( ns.c_str() );
+            if ( ! nsd ) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            int size = 10;
+            if ( jsobj["size"].isNumber() ) {
+                size = jsobj["size"].numberInt();
+                if ( size <= 0 || size > 1000 ) {
+                    errmsg = "size has to be between 1 and 1000";
+                    return false;
+                }
+            }
+            else if ( jsobj["size"].trueValue() ) {
+                errmsg = "size has to be a number > 0";
+                return false;
+            }
+
+            RandomSampleCursor c( nsd, size );
+            BSONArrayBuilder samples( result.subarrayStart( "samples" ) );
+            long long len = 0;
+            while( c.ok() ) {
+                BSONObj o = c.current();
+                len += o.objsize();
+                if ( len > BSONObjMaxUserSize / 2 ) {
+                    // leave room in the reply for the remaining samples
+                    break;
+                }
+                samples.append( o );
+                c.advance();
+            }
+            samples.done();
+            return true;
+        }
+    } cmdCollSample;
+
     class CollectionStats : public Command {
     public:
         CollectionStats() : Command( "collStats", false, "collstats" ) {}
@@ -1300,7 +1861,8 @@ namespace mongo {
         virtual LockType locktype() const { return READ; }
         virtual void help( stringstream &help ) const {
             help << "{ collStats:\"blog.posts\" , scale : 1 } scale divides sizes e.g. for KB use 1024\n"
-                    "    avgObjSize - in bytes";
+                    "    avgObjSize - in bytes\n"
+                    "    add compression:true to sample records and estimate snappy compressibility";
         }
         bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             string ns = dbname + "." + jsobj.firstElement().valuestr();
@@ -1352,15 +1914,178 @@ namespace mongo {
             if ( nsd->capped ) {
                 result.append( "capped" , nsd->capped );
                 result.append( "max" , nsd->max );
+                if ( nsd->cappedSlotSize )
+                    result.append( "slotSize" , (int) nsd->cappedSlotSize );
+            }
+
+            if ( jsobj["compression"].trueValue() ) {
+                /* estimate what storing compressed records would buy.  snappy
+                   per record is what a compressed record format would achieve
+                   on its own; per 64KB block approximates sharing compression
+                   context across neighboring small documents. */
+                const long long maxSample = 4 * 1024 * 1024;
+                shared_ptr<Cursor> c = theDataFileMgr.findAll( ns.c_str() );
+                long long sampledRecords = 0;
+                long long sampledBytes = 0;
+                long long perRecordCompressed = 0;
+                long long blockCompressed = 0;
+                string block, out;
+                while ( c->ok() && sampledBytes < maxSample ) {
+                    Record *r = c->_current();
+                    sampledRecords++;
+                    sampledBytes += r->netLength();
+                    out.clear();
+                    perRecordCompressed += compress( r->data , r->netLength() , &out );
+                    block.append( r->data , r->netLength() );
+                    if ( block.size() >= 64 * 1024 ) {
+                        out.clear();
+                        blockCompressed += compress( block.data() , block.size() , &out );
+                        block.clear();
+                    }
+                    c->advance();
+                }
+                if ( block.size() ) {
+                    out.clear();
+                    blockCompressed += compress( block.data() , block.size() , &out );
+                }
+                BSONObjBuilder comp( result.subobjStart( "compression" ) );
+                comp.appendNumber( "sampledRecords" , sampledRecords );
+                comp.appendNumber( "sampledBytes" , sampledBytes );
+                comp.appendNumber( "perRecordCompressedBytes" , perRecordCompressed );
+                comp.appendNumber( "blockCompressedBytes" , blockCompressed );
+                if ( sampledBytes && perRecordCompressed && blockCompressed ) {
+                    comp.append( "perRecordRatio" , double(sampledBytes) / double(perRecordCompressed) );
+                    comp.append( "blockRatio" , double(sampledBytes) / double(blockCompressed) );
+                }
+                comp.done();
             }
 
-            if ( verbose )
+            if ( verbose ) {
                 result.appendArray( "extents" , extents.arr() );
 
+                if ( ! nsd->capped ) {
+                    // per size-class freelist occupancy - this walks every
+                    // deleted chain, hence verbose only
+                    long long counts[Buckets];
+                    long long bytes[Buckets];
+                    nsd->deletedListOccupancy( counts, bytes );
+                    BSONArrayBuilder freelist;
+                    for ( int i = 0; i < Buckets; i++ ) {
+                        if ( counts[i] == 0 )
+                            continue;
+                        BSONObjBuilder bin( freelist.subobjStart() );
+                        bin.append( "bucketSize" , bucketSizes[i] );
+                        bin.appendNumber( "count" , counts[i] );
+                        bin.appendNumber( "bytes" , bytes[i] / scale );
+                        bin.done();
+                    }
+                    result.appendArray( "freelist" , freelist.arr() );
+                }
+            }
+
             return true;
         }
     } cmdCollectionStatis;
 
+    /* per index read and maintenance counters, for finding dead indexes */
+    class CmdIndexStats : public Command {
+    public:
+        CmdIndexStats() : Command( "indexStats" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return READ; }
+        virtual void help( stringstream &help ) const {
+            help << "{ indexStats : \"collname\" }\n"
+                    "    per index access and maintenance counters since startup.\n"
+                    "    an index with keysInserted piling up and no accesses is a drop candidate";
+        }
+        bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + "." + jsobj.firstElement().valuestr();
+            Client::Context cx( ns );
+
+            NamespaceDetails * d = nsdetails( ns.c_str() );
+            if ( ! d ) {
+                errmsg = "ns not found";
+                return false;
+            }
+
+            result.append( "ns" , ns.c_str() );
+
+            BSONObjBuilder indexes( result.subobjStart( "indexes" ) );
+            NamespaceDetails::IndexIterator ii = d->ii();
+            while ( ii.more() ) {
+                IndexDetails& idx = ii.next();
+                IndexUsage::Data data = IndexUsage::global.get( idx.indexNamespace() );
+                BSONObjBuilder b( indexes.subobjStart( idx.indexName() ) );
+                b.appendNumber( "accesses" , data.accesses );
+                b.appendNumber( "keysInserted" , data.keysInserted );
+                b.appendNumber( "keysRemoved" , data.keysRemoved );
+                if ( data.lastAccess )
+                    b.appendDate( "lastAccess" , data.lastAccess );
+                b.done();
+            }
+            indexes.done();
+            return true;
+        }
+    } cmdIndexStats;
+
+    class CollectionModCommand : public Command {
+    public:
+        CollectionModCommand() : Command( "collMod" ) {}
+        virtual bool slaveOk() const { return false; }
+        virtual LockType locktype() const { return WRITE; }
+        virtual bool logTheOp() { return true; }
+        virtual void help( stringstream &help ) const {
+            help << "Sets collection options.\n"
+                    "Example: { collMod: 'foo', paddingFactor: 1.5 }  explicit padding, 1.0 to 4.0\n"
+                    "Example: { collMod: 'foo', usePowerOf2Sizes: true }  quantize record allocations to powers of two\n"
+                    "Example: { collMod: 'foo', adaptivePadding: true }  preallocate from observed post-update sizes";
+        }
+        bool run(const string& dbname, BSONObj& jsobj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
+            string ns = dbname + "." + jsobj.firstElement().valuestr();
+            Client::Context ctx( ns );
+
+            NamespaceDetails *d = nsdetails( ns.c_str() );
+            if ( ! d ) {
+                errmsg = "ns not found";
+                return false;
+            }
+            if ( d->capped ) {
+                errmsg = "cannot change allocation options on a capped collection";
+                return false;
+            }
+
+            BSONElement e = jsobj["usePowerOf2Sizes"];
+            if ( ! e.eoo() ) {
+                result.appendBool( "usePowerOf2Sizes_old" , d->usingPowerOf2Sizes() );
+                if ( e.trueValue() )
+                    d->setUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
+                else
+                    d->clearUserFlag( NamespaceDetails::Flag_UsePowerOf2Sizes );
+            }
+
+            e = jsobj["adaptivePadding"];
+            if ( ! e.eoo() ) {
+                result.appendBool( "adaptivePadding_old" , d->usingAdaptivePadding() );
+                if ( e.trueValue() )
+                    d->setUserFlag( NamespaceDetails::Flag_AdaptivePadding );
+                else
+                    d->clearUserFlag( NamespaceDetails::Flag_AdaptivePadding );
+            }
+
+            e = jsobj["paddingFactor"];
+            if ( ! e.eoo() ) {
+                if ( ! e.isNumber() || e.number() < 1.0 || e.number() > 4.0 ) {
+                    errmsg = "paddingFactor must be a number between 1.0 and 4.0";
+                    return false;
+                }
+                result.append( "paddingFactor_old" , d->paddingFactor );
+                *getDur().writing(&d->paddingFactor) = e.number();
+            }
+
+            return true;
+        }
+    } collectionModCommand;
+
     class DBStats : public Command {
     public:
         DBStats() : Command( "dbStats", false, "dbstats" ) {}
@@ -1927,8 +2652,9 @@ namespace mongo {
         // switch to bool, but wait a bit longer before switching?
         // anObjBuilder.append("ok", ok);
         anObjBuilder.append("ok", ok?1.0:0.0);
-        BSONObj x = anObjBuilder.done();
-        b.appendBuf((void*) x.objdata(), x.objsize());
+        // when the caller constructed anObjBuilder over b (the reply path), this
+        // finishes the document right in the output buffer -- no copy
+        anObjBuilder.doneFast();
 
         return true;
     }
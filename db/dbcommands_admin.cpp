@@ -28,6 +28,7 @@
 #include "namespace-inl.h"
 #include "commands.h"
 #include "cmdline.h"
+#include "clientcursor.h"
 #include "btree.h"
 #include "curop-inl.h"
 #include "../util/background.h"
@@ -152,10 +153,12 @@ namespace mongo {
         }
 
         virtual void help(stringstream& h) const { h << "Validate contents of a namespace by scanning its data structures for correctness.  Slow.\n"
-                                                        "Add full:true option to do a more thorough check"; }
+                                                        "Add full:true option to do a more thorough check\n"
+                                                        "Add sample:<pct> to deep check only that percentage of records (quick spot check)\n"
+                                                        "Add yield:true to release the read lock periodically during the record scan"; }
 
         virtual LockType locktype() const { return READ; }
-        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool> } */
+        //{ validate: "collectionnamewithoutthedbpart" [, scandata: <bool>] [, full: <bool>] [, sample: <pct>] [, yield: <bool>] } */
 
         bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl ) {
             string ns = dbname + "." + cmdObj.firstElement().valuestrsafe();
@@ -176,7 +179,14 @@ namespace mongo {
     private:
         void validateNS(const char *ns, NamespaceDetails *d, const BSONObj& cmdObj, BSONObjBuilder& result) {
             const bool full = cmdObj["full"].trueValue();
-            const bool scanData = full || cmdObj["scandata"].trueValue();
+            const int samplePct = cmdObj["sample"].isNumber() ? cmdObj["sample"].numberInt() : 0;
+            uassert( 15987 , "sample must be between 1 and 100" , samplePct >= 0 && samplePct <= 100 );
+            const bool scanData = full || samplePct > 0 || cmdObj["scandata"].trueValue();
+            /* deep check every sampleEvery-th record; 0 = only when full */
+            const int sampleEvery = samplePct ? ( samplePct >= 100 ? 1 : 100 / samplePct ) : 0;
+            /* capped cursors don't survive yields; everything else can release
+               the read lock periodically so validate stops starving writers */
+            const bool doYield = cmdObj["yield"].trueValue() && ! d->capped;
 
             bool valid = true;
             BSONArrayBuilder errors; // explanation(s) for why valid = false
@@ -237,8 +247,13 @@ namespace mongo {
                 }
 
                 set<DiskLoc> recs;
+                bool scanAborted = false;
                 if( scanData ) {
                     shared_ptr<Cursor> c = theDataFileMgr.findAll(ns);
+                    auto_ptr<ClientCursor> cl;
+                    if ( doYield )
+                        cl.reset( new ClientCursor( QueryOption_NoCursorTimeout , c , ns ) );
+                    ProgressMeterHolder pm( cc().curop()->setMessage( "validate scan" , d->stats.nrecords ) );
                     int n = 0;
                     int nInvalid = 0;
                     long long len = 0;
@@ -247,6 +262,8 @@ namespace mongo {
                     DiskLoc cl_last;
                     while ( c->ok() ) {
                         n++;
+                        pm.hit();
+                        killCurrentOp.checkForInterrupt();
 
                         DiskLoc cl = c->currLoc();
                         if ( n < 1000000 )
@@ -261,7 +278,7 @@ namespace mongo {
                         len += r->lengthWithHeaders;
                         nlen += r->netLength();
 
-                        if (full){
+                        if ( full || ( sampleEvery && n % sampleEvery == 0 ) ) {
                             BSONObj obj(r);
                             if (!obj.isValid() || !obj.valid()){ // both fast and deep checks
                                 valid = false;
@@ -285,6 +302,15 @@ namespace mongo {
                         }
 
                         c->advance();
+                        if ( cl.get() && ! cl->yieldSometimes( ClientCursor::DontNeed ) ) {
+                            // cursor died during a yield (e.g. the collection was dropped)
+                            cl.release();
+                            scanAborted = true;
+                            break;
+                        }
+                    }
+                    if ( scanAborted ) {
+                        result.append( "scanWarning" , "scan stopped early: cursor died during a yield.  rerun, or rerun without yield:true, for a complete scan" );
                     }
                     if ( d->capped && !d->capLooped() ) {
                         result.append("cappedOutOfOrder", outOfOrder);
@@ -295,7 +321,7 @@ namespace mongo {
                     }
                     result.append("objectsFound", n);
 
-                    if (full) {
+                    if (full || sampleEvery) {
                         result.append("invalidObjects", nInvalid);
                     }
 
@@ -311,8 +337,11 @@ namespace mongo {
                 int ndel = 0;
                 long long delSize = 0;
                 int incorrect = 0;
+                BSONArrayBuilder delBucketArray;
                 for ( int i = 0; i < Buckets; i++ ) {
                     DiskLoc loc = d->deletedList[i];
+                    long long bucketCount = 0;
+                    long long bucketBytes = 0;
                     try {
                         int k = 0;
                         while ( !loc.isNull() ) {
@@ -339,6 +368,8 @@ namespace mongo {
 
                             DeletedRecord *d = loc.drec();
                             delSize += d->lengthWithHeaders;
+                            bucketCount++;
+                            bucketBytes += d->lengthWithHeaders;
                             loc = d->nextDeleted;
                             k++;
                             killCurrentOp.checkForInterrupt();
@@ -348,13 +379,30 @@ namespace mongo {
                         errors << ("exception in deleted chain for bucket " + BSONObjBuilder::numStr(i));
                         valid = false;
                     }
+                    if ( bucketCount ) {
+                        BSONObjBuilder bin( delBucketArray.subobjStart() );
+                        bin.append( "bucket", i );
+                        bin.append( "bucketSize", bucketSizes[i] );
+                        bin.appendNumber( "count", bucketCount );
+                        bin.appendNumber( "bytes", bucketBytes );
+                        bin.done();
+                    }
                 }
                 result.appendNumber("deletedCount", ndel);
                 result.appendNumber("deletedSize", delSize);
+                result.append("deletedBuckets", delBucketArray.arr());
 
                 if ( incorrect ) {
-                    errors << (BSONObjBuilder::numStr(incorrect) + " records from datafile are in deleted list");
-                    valid = false;
+                    if ( doYield ) {
+                        /* records deleted during a yield legitimately show up in
+                           both our live set and the deleted lists; with yields
+                           this cross check can't distinguish that from corruption */
+                        result.append( "recordsInDeletedList" , incorrect );
+                    }
+                    else {
+                        errors << (BSONObjBuilder::numStr(incorrect) + " records from datafile are in deleted list");
+                        valid = false;
+                    }
                 }
 
                 int idxn = 0;
@@ -363,9 +411,11 @@ namespace mongo {
                     BSONObjBuilder indexes; // not using subObjStart to be exception safe
                     NamespaceDetails::IndexIterator i = d->ii();
                     while( i.more() ) {
+                        killCurrentOp.checkForInterrupt();
                         IndexDetails& id = i.next();
                         long long keys = id.idxInterface().fullValidate(id.head, id.keyPattern());
                         indexes.appendNumber(id.indexNamespace(), keys);
+                        idxn++;
                     }
                     result.append("keysPerIndex", indexes.done());
                 }
@@ -529,6 +579,89 @@ namespace mongo {
 
     } fsyncCmd;
 
+    bool refusingWrites = false; // read from db/instance.cpp
+    static volatile bool shutdownPrepareDraining = false;
+
+    /* warm shutdown preparation.  refuses new writes (reads are still served,
+       and writers get a clean error via getLastError so they can fail over),
+       then spreads the dirty page flush over a window instead of leaving it
+       all for dbexit's final burst.  a rolling restart becomes:
+          { shutdownPrepare : 1 , windowSecs : 60 }
+          { shutdownPrepare : 1 , status : true }   // poll until drained
+          { shutdown : 1 }                          // now has little to flush
+       { shutdownPrepare : 1 , abort : true } takes writes again.
+    */
+    class ShutdownPrepareCommand : public Command {
+        class DrainJob : public BackgroundJob {
+        public:
+            DrainJob( int windowSecs ) : BackgroundJob( true /* delete self */ ), _windowSecs( windowSecs ) {}
+        protected:
+            virtual string name() const { return "shutdownPrepare"; }
+            void run() {
+                Client::initThread( "shutdownPrepare" );
+                log() << "shutdownPrepare: flushing dirty pages over " << _windowSecs << "s" << endl;
+                Timer t;
+                int n = MemoryMappedFile::flushAllPaced( _windowSecs * 1000 );
+                if ( refusingWrites ) {
+                    // residual pages dirtied by writes that were in flight when
+                    // the window started; small by now so this burst is cheap
+                    MemoryMappedFile::flushAll( true );
+                    log() << "shutdownPrepare: drained, flushed " << n << " files in " << t.seconds() << "s, ready for shutdown" << endl;
+                }
+                else {
+                    log() << "shutdownPrepare: aborted" << endl;
+                }
+                shutdownPrepareDraining = false;
+                cc().shutdown();
+            }
+        private:
+            int _windowSecs;
+        };
+    public:
+        ShutdownPrepareCommand() : Command( "shutdownPrepare" ) {}
+        virtual LockType locktype() const { return NONE; }
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual void help(stringstream& h) const {
+            h << "stop accepting writes and pace the dirty page flush ahead of a shutdown\n"
+                 "{ shutdownPrepare : 1 , windowSecs : 60 }  then poll with status:true; abort:true resumes writes";
+        }
+        virtual bool run(const string& dbname, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            if ( cmdObj["status"].trueValue() ) {
+                result.appendBool( "refusingWrites" , refusingWrites );
+                result.appendBool( "draining" , shutdownPrepareDraining );
+                return true;
+            }
+
+            if ( cmdObj["abort"].trueValue() ) {
+                if ( ! refusingWrites ) {
+                    errmsg = "shutdownPrepare not in progress";
+                    return false;
+                }
+                refusingWrites = false;
+                log() << "shutdownPrepare: abort requested, accepting writes again" << endl;
+                result.append( "info" , "accepting writes again" );
+                return true;
+            }
+
+            uassert( 15999 , "shutdownPrepare already in progress" , ! refusingWrites );
+
+            int windowSecs = cmdObj["windowSecs"].numberInt();
+            if ( windowSecs <= 0 )
+                windowSecs = 60;
+
+            refusingWrites = true;
+            shutdownPrepareDraining = true;
+            DrainJob * j = new DrainJob( windowSecs );
+            j->go();
+
+            log() << "CMD shutdownPrepare: not accepting writes, draining over " << windowSecs << "s" << endl;
+            result.append( "info" , "stopped accepting writes; flushing dirty pages in background" );
+            result.append( "windowSecs" , windowSecs );
+            return true;
+        }
+    } shutdownPrepareCmd;
+
     // Note that this will only unlock the current lock.  If another thread
     // relocks before we return we still consider the unlocking successful.
     // This is imporant because if two scripts are trying to fsync-lock, each
@@ -44,6 +44,7 @@
 #include "background.h"
 #include "../util/version.h"
 #include "../util/ramlog.h"
+#include "../util/net/message_port.h"
 
 namespace mongo {
 
@@ -85,6 +86,7 @@ namespace mongo {
             help << "  quiet\n";
             help << "  notablescan\n";
             help << "  logLevel\n";
+            help << "  logAsync\n";
             help << "  syncdelay\n";
             help << "{ getParameter:'*' } to get everything\n";
         }
@@ -102,6 +104,10 @@ namespace mongo {
             if( all || cmdObj.hasElement("logLevel") ) {
                 result.append("logLevel", logLevel);
             }
+            if( all || cmdObj.hasElement("logAsync") ) {
+                result.append("logAsync", Logstream::asyncFlush());
+                result.appendNumber("logAsyncDropped", Logstream::asyncDropped());
+            }
             if( all || cmdObj.hasElement("syncdelay") ) {
                 result.append("syncdelay", cmdLine.syncdelay);
             }
@@ -131,7 +137,9 @@ namespace mongo {
             help << "{ setParameter:1, <param>:<value> }\n";
             help << "supported so far:\n";
             help << "  journalCommitInterval\n";
+            help << "  logAsync\n";
             help << "  logLevel\n";
+            help << "  maxOpMemoryMB\n";
             help << "  notablescan\n";
             help << "  quiet\n";
             help << "  syncdelay\n";
@@ -176,6 +184,12 @@ namespace mongo {
                 logLevel = cmdObj["logLevel"].numberInt();
                 s++;
             }
+            if( cmdObj.hasElement( "logAsync" ) ) {
+                if( s == 0 )
+                    result.append("was", Logstream::asyncFlush() );
+                Logstream::setAsyncFlush( cmdObj["logAsync"].trueValue() );
+                s++;
+            }
             if( cmdObj.hasElement( "replApplyBatchSize" ) ) {
                 if( s == 0 )
                     result.append("was", replApplyBatchSize );
@@ -210,6 +224,52 @@ namespace mongo {
         }
     } pingCmd;
 
+    /* negotiate snappy wire compression for this connection.  a client sends
+       { setWireCompression : 1 } once after connecting and may then send
+       compressed messages; we start compressing what we send it as well.
+       receivers always understand compressed messages (a header flag marks
+       them), so there is no ordering problem with the reply.  see
+       MessagingPort::say/recv.
+    */
+    class CmdSetWireCompression : public Command {
+    public:
+        CmdSetWireCompression() : Command( "setWireCompression" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const { help << "enable snappy compression of messages on this connection"; }
+        virtual bool run(const string&, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            MessagingPort *mp = dynamic_cast<MessagingPort*>( cc().port() );
+            if ( mp == 0 ) {
+                errmsg = "no messaging port associated with this connection";
+                return false;
+            }
+            mp->setCompressOut( true );
+            result.append( "compression", "snappy" );
+            return true;
+        }
+    } cmdSetWireCompression;
+
+    /* set the scheduling class for ops on this connection.
+       { setOpPriority : -1 } marks subsequent ops low priority: they yield
+       the db lock earlier and stay off it longer whenever other ops are
+       queued.  use for bulk/maintenance work that should not hurt
+       interactive latency.  { setOpPriority : 0 } restores normal.
+    */
+    class CmdSetOpPriority : public Command {
+    public:
+        CmdSetOpPriority() : Command( "setOpPriority" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream &help ) const { help << "set op scheduling class for this connection: -1 low, 0 normal"; }
+        virtual bool run(const string&, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            int p = cmdObj.firstElement().numberInt();
+            uassert( 15967 , "priority must be -1 (low) or 0 (normal)" , p == CurOp::LOW || p == CurOp::NORMAL );
+            result.append( "was" , cc().opPriority() );
+            cc().setOpPriority( p );
+            return true;
+        }
+    } cmdSetOpPriority;
+
     class FeaturesCmd : public Command {
     public:
         FeaturesCmd() : Command( "features", true ) {}
@@ -61,18 +61,20 @@ namespace mongo {
                       int nReturned, int startingFrom,
                       long long cursorId 
                       ) {
-        BufBuilder b(32768);
-        b.skip(sizeof(QueryResult));
-        b.appendBuf(data, size);
-        QueryResult *qr = (QueryResult *) b.buf();
-        qr->_resultFlags() = queryResultFlags;
-        qr->len = b.len();
-        qr->setOperation(opReply);
-        qr->cursorId = cursorId;
-        qr->startingFrom = startingFrom;
-        qr->nReturned = nReturned;
-        b.decouple();
-        Message resp(qr, true);
+        /* scatter-gather: the QueryResult header and the caller's buffer go out as
+           two iovecs (coalesced by sendmsg in Socket::send), so the result bytes
+           are not copied into an intermediate contiguous reply buffer.  safe to
+           borrow the caller's buffer because reply() sends synchronously. */
+        QueryResult qr;
+        qr._resultFlags() = queryResultFlags;
+        qr.len = sizeof(QueryResult) + size;
+        qr.setOperation(opReply);
+        qr.cursorId = cursorId;
+        qr.startingFrom = startingFrom;
+        qr.nReturned = nReturned;
+        Message resp;
+        resp.appendExternalData( (const char *) &qr, sizeof(QueryResult) );
+        resp.appendExternalData( (const char *) data, size );
         p->reply(requestMsg, resp, requestMsg.header()->id);
     }
 
@@ -61,13 +61,21 @@ namespace mongo {
     class DbWebServer : public MiniWebServer {
     public:
         DbWebServer(const string& ip, int port, const AdminAccess* webUsers)
-            : MiniWebServer("admin web console", ip, port), _webUsers(webUsers) {
+            : MiniWebServer("admin web console", ip, port), _webUsers(webUsers),
+              _homeCacheMutex("DbWebServer"), _homeCacheTime(0) {
             WebStatusPlugin::initAll();
         }
 
     private:
         const AdminAccess* _webUsers; // not owned here
 
+        // monitoring tends to poll the home page aggressively and every
+        // section is a snapshot anyway, so renders inside the TTL are reused
+        enum { HomePageCacheMillis = 1000 };
+        mongo::mutex _homeCacheMutex;
+        string _homeCache;
+        unsigned long long _homeCacheTime;
+
         void doUnlockedStuff(stringstream& ss) {
             /* this is in the header already ss << "port:      " << port << '\n'; */
             ss << "<pre>";
@@ -202,6 +210,16 @@ namespace mongo {
             }
 
             responseCode = 200;
+            headers.push_back( "Content-Type: text/html;charset=utf-8" );
+
+            {
+                scoped_lock lk( _homeCacheMutex );
+                if ( _homeCacheTime && curTimeMillis64() - _homeCacheTime < HomePageCacheMillis ) {
+                    responseMsg = _homeCache;
+                    return;
+                }
+            }
+
             stringstream ss;
             string dbname;
             {
@@ -249,7 +267,12 @@ namespace mongo {
 
             ss << "</body></html>\n";
             responseMsg = ss.str();
-            headers.push_back( "Content-Type: text/html;charset=utf-8" );
+
+            {
+                scoped_lock lk( _homeCacheMutex );
+                _homeCache = responseMsg;
+                _homeCacheTime = curTimeMillis64();
+            }
         }
 
         void _rejectREST( string& responseMsg , int& responseCode, vector<string>& headers ) {
@@ -386,7 +409,8 @@ namespace mongo {
 
     class StatusHandler : public DbWebHandler {
     public:
-        StatusHandler() : DbWebHandler( "_status" , 1 , false ) {}
+        StatusHandler() : DbWebHandler( "_status" , 1 , false ),
+            _cacheMutex("StatusHandler"), _cacheTime(0) {}
 
         virtual void handle( const char *rq, string url, BSONObj params,
                              string& responseMsg, int& responseCode,
@@ -394,6 +418,16 @@ namespace mongo {
             headers.push_back( "Content-Type: application/json;charset=utf-8" );
             responseCode = 200;
 
+            // the plain form is what monitoring polls; serve it from cache
+            // inside the TTL so pollers never stack up behind each other
+            if ( params.isEmpty() ) {
+                scoped_lock lk( _cacheMutex );
+                if ( _cacheTime && curTimeMillis64() - _cacheTime < CacheMillis ) {
+                    responseMsg = _cache;
+                    return;
+                }
+            }
+
             static vector<string> commands;
             if ( commands.size() == 0 ) {
                 commands.push_back( "serverStatus" );
@@ -432,8 +466,19 @@ namespace mongo {
 
             responseMsg = buf.obj().jsonString();
 
+            if ( params.isEmpty() ) {
+                scoped_lock lk( _cacheMutex );
+                _cache = responseMsg;
+                _cacheTime = curTimeMillis64();
+            }
         }
 
+    private:
+        enum { CacheMillis = 1000 };
+        mongo::mutex _cacheMutex;
+        string _cache;
+        unsigned long long _cacheTime;
+
     } statusHandler;
 
     class CommandListHandler : public DbWebHandler {
@@ -529,6 +574,7 @@ namespace mongo {
     void webServerThread(const AdminAccess* adminAccess) {
         boost::scoped_ptr<const AdminAccess> adminAccessPtr(adminAccess); // adminAccess is owned here
         Client::initThread("websvr");
+        cc().setOpPriority( CurOp::LOW ); // status rendering yields to production ops
         const int p = cmdLine.port + 1000;
         DbWebServer mini(cmdLine.bind_ip, p, adminAccessPtr.get());
         mini.initAndListen();
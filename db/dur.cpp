@@ -41,13 +41,17 @@
      READLOCK dbMutex
      LOCK groupCommitMutex
        PREPLOGBUFFER()
-     READLOCK mmmutex
        commitJob.reset()
      UNLOCK dbMutex                                     // now other threads can write
+       hand buffer to the journal writer thread         // and we can prepare the next commit
+     UNLOCK groupCommitMutex
+
+     on the journal writer thread, per buffer, in handoff order:
        WRITETOJOURNAL()
+       notify getlasterror waiters
+     READLOCK mmmutex
        WRITETODATAFILES()
      UNLOCK mmmutex
-     UNLOCK groupCommitMutex
 
      on the next write lock acquisition for dbMutex:    // see MongoMutex::_acquiredWriteLock()
        REMAPPRIVATEVIEW()
@@ -74,8 +78,8 @@ namespace mongo {
 
     namespace dur {
 
-        void PREPLOGBUFFER(JSectHeader& outParm);
-        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed);
+        void PREPLOGBUFFER(JSectHeader outParm[]); // one per journal stream
+        void WRITETOJOURNAL(unsigned streamNo, JSectHeader h, AlignedBuilder& uncompressed);
         void WRITETODATAFILES(const JSectHeader& h, AlignedBuilder& uncompressed);
 
         /** declared later in this file
@@ -226,7 +230,16 @@ namespace mongo {
             return true;
         }
 
+        // wakes durThread so a waiting getLastError j:true doesn't sit out the rest of
+        // the commit interval.  see durThread().
+        static mongo::mutex earlyCommitMutex("earlyCommit");
+        static boost::condition earlyCommitWakeup;
+
         bool DurableImpl::awaitCommit() {
+            {
+                scoped_lock lk(earlyCommitMutex);
+                earlyCommitWakeup.notify_one();
+            }
             commitJob._notify.awaitBeyondNow();
             return true;
         }
@@ -484,6 +497,133 @@ namespace mongo {
             stats.curr->_remapPrivateViewMicros += t.micros();
         }
 
+        /** pipelines journal writes on a dedicated thread so the commit thread can go
+            straight back to preparing the next group commit while the previous buffer
+            is still being fsynced.  the writer acknowledges getLastError waiters (with
+            the commit number captured at handoff) once a buffer is on disk in the
+            journal, and then applies it to the data files.
+
+            concurrency: write() is only called with groupCommitMutex held, so buffers
+            are queued in commit number order and processed FIFO -- acknowledgements
+            thus never go out of order.  paths that must not overlap the writer
+            (remapping commits, file closes, journal truncation) call flush() first.
+        */
+        class JournalWriter : boost::noncopyable {
+        public:
+            JournalWriter() : _mx("journalWriter"), _writing(false) {
+                for( int i = 0; i < NBuffers; i++ )
+                    _free.push_back( &_buffers[i] );
+            }
+
+            /** queue the commit job's prepared buffers (one per journal stream) for
+                writing.  swaps their storage with recycled builders so the caller can
+                refill them immediately.  blocks only if all buffers are in flight
+                (the journal is far behind).
+                @param h    section headers, one per stream
+                @param when commit number to acknowledge once the buffers are journaled
+            */
+            void write(const JSectHeader h[], NotifyAll::When when) {
+                scoped_lock lk(_mx);
+                while( _free.empty() )
+                    _doneOne.wait(lk.boost());
+                Buffer *b = _free.back();
+                _free.pop_back();
+                b->when = when;
+                b->nStreams = nJournalStreams();
+                for( unsigned s = 0; s < b->nStreams; s++ ) {
+                    b->h[s] = h[s];
+                    b->b[s]->swap(commitJob.ab(s));
+                }
+                _q.push_back(b);
+                _queued.notify_one();
+            }
+
+            /** wait until everything queued so far has reached the journal and the
+                data files.  cheap (one mutex acquisition) when the writer is idle. */
+            void flush() {
+                scoped_lock lk(_mx);
+                while( !_q.empty() || _writing )
+                    _doneOne.wait(lk.boost());
+            }
+
+            /** the writer thread's main loop -- see startup() */
+            void run() {
+                Client::initThread("journalwriter");
+                while( 1 ) {
+                    Buffer *b;
+                    {
+                        scoped_lock lk(_mx);
+                        while( _q.empty() ) {
+                            if( inShutdown() ) {
+                                cc().shutdown();
+                                return;
+                            }
+                            _queued.timed_wait(lk.boost(), incxtimemillis(100));
+                        }
+                        b = _q.front();
+                        _q.erase(_q.begin());
+                        _writing = true;
+                    }
+                    try {
+                        for( unsigned s = 0; s < b->nStreams; s++ ) {
+                            if( b->b[s]->len() )
+                                WRITETOJOURNAL(s, b->h[s], *b->b[s]);
+                        }
+
+                        // data is now in the journal, which is sufficient for acknowledging getLastError.
+                        // (ok to crash after that)
+                        commitJob._notify.notifyAll(b->when);
+
+                        {
+                            // stop any file from closing/unmapping until we have applied this buffer
+                            RWLockRecursive::Shared lk3(MongoFile::mmmutex);
+                            for( unsigned s = 0; s < b->nStreams; s++ ) {
+                                if( b->b[s]->len() )
+                                    WRITETODATAFILES(b->h[s], *b->b[s]);
+                            }
+                        }
+                        for( unsigned s = 0; s < b->nStreams; s++ )
+                            b->b[s]->reset();
+                    }
+                    catch(std::exception& e) {
+                        log() << "exception in journal writer thread causing immediate shutdown: " << e.what() << endl;
+                        mongoAbort("dur5");
+                    }
+                    {
+                        scoped_lock lk(_mx);
+                        _writing = false;
+                        _free.push_back(b);
+                        _doneOne.notify_all();
+                    }
+                }
+            }
+
+        private:
+            enum { NBuffers = 4 };
+            struct Buffer {
+                Buffer() : nStreams(1) {
+                    b[0] = new AlignedBuilder(4 * 1024 * 1024);
+                    for( unsigned s = 1; s < MaxJournalStreams; s++ ) {
+                        // start small; these grow on demand if extra streams are configured
+                        b[s] = new AlignedBuilder(8192);
+                    }
+                }
+                JSectHeader h[MaxJournalStreams]; // one section per journal stream
+                NotifyAll::When when;
+                unsigned nStreams;                // how many of h/b are in use
+                AlignedBuilder* b[MaxJournalStreams];
+            };
+            mongo::mutex _mx;          // protects the members below
+            boost::condition _queued;  // a buffer was added to _q
+            boost::condition _doneOne; // a buffer was recycled; write() and flush() wait on this
+            Buffer _buffers[NBuffers];
+            vector<Buffer*> _q;        // in flight, oldest first (tiny, so vector is fine as a fifo)
+            vector<Buffer*> _free;
+            bool _writing;             // a buffer is out of _q but not yet recycled
+        } journalWriter;
+
+        static void journalWriterThread() { journalWriter.run(); }
+
         // lock order: dbMutex first, then this
         mutex groupCommitMutex("groupCommit");
 
@@ -497,33 +637,31 @@ namespace mongo {
             commitJob.beginCommit();
 
             if( !commitJob.hasWritten() ) {
-                // getlasterror request could have came after the data was already committed
+                // getlasterror request could have came after the data was already committed.
+                // can't acknowledge before buffers already handed to the writer are journaled.
+                journalWriter.flush();
                 commitJob.notifyCommitted();
                 return true;
             }
-            JSectHeader h;
+            JSectHeader h[MaxJournalStreams];
             PREPLOGBUFFER(h);
 
-            RWLockRecursive::Shared lk3(MongoFile::mmmutex);
-
-            unsigned abLen = commitJob._ab.len();
+            NotifyAll::When commitNumber = commitJob.commitNumber();
             commitJob.reset(); // must be reset before allowing anyone to write
             DEV assert( !commitJob.hasWritten() );
 
-            // release the readlock -- allowing others to now write while we are writing to the journal (etc.)
+            // release the readlock -- allowing others to now write while the writer
+            // thread journals the buffer
             lk1.reset();
 
             // ****** now other threads can do writes ******
-            WRITETOJOURNAL(h, commitJob._ab);
-            assert( abLen == commitJob._ab.len() ); // a check that no one touched the builder while we were doing work. if so, our locking is wrong.
-
-            // data is now in the journal, which is sufficient for acknowledging getLastError.
-            // (ok to crash after that)
-            commitJob.notifyCommitted();
 
-            WRITETODATAFILES(h, commitJob._ab);
-            assert( abLen == commitJob._ab.len() ); // check again wasn't modded
-            commitJob._ab.reset();
+            // hand the prepared buffer off and return.  the writer thread notifies
+            // getLastError waiters once the buffer is in the (on disk) journal and
+            // then applies it to the data files.  we go straight back to gathering
+            // the next group commit, so the next PREPLOGBUFFER overlaps this
+            // buffer's fsync.  the swap inside leaves us recycled buffers to fill.
+            journalWriter.write(h, commitNumber);
 
             // can't : dbMutex._remapPrivateViewRequested = true;
 
@@ -556,6 +694,12 @@ namespace mongo {
 
        /** locking: in read lock when called. */
         static void _groupCommit() {
+            // drain the writer thread first.  we cannot acknowledge waiters below until
+            // buffers already handed off are journaled, and we cannot remap private
+            // views until those buffers have reached the data files.  this also keeps
+            // all journal file appends ordered through one thread at a time.
+            journalWriter.flush();
+
             commitJob.beginCommit();
 
             if( !commitJob.hasWritten() ) {
@@ -568,23 +712,30 @@ namespace mongo {
             // (and we are only read locked in the dbMutex, so it could happen)
             scoped_lock lk(groupCommitMutex);
 
-            JSectHeader h;
+            JSectHeader h[MaxJournalStreams];
             PREPLOGBUFFER(h);
 
             // todo : write to the journal outside locks, as this write can be slow.
-            //        however, be careful then about remapprivateview as that cannot be done 
+            //        however, be careful then about remapprivateview as that cannot be done
             //        if new writes are then pending in the private maps.
-            WRITETOJOURNAL(h, commitJob._ab);
+            for( unsigned s = 0; s < nJournalStreams(); s++ ) {
+                if( commitJob.ab(s).len() )
+                    WRITETOJOURNAL(s, h[s], commitJob.ab(s));
+            }
 
             // data is now in the journal, which is sufficient for acknowledging getLastError.
             // (ok to crash after that)
             commitJob.notifyCommitted();
 
-            WRITETODATAFILES(h, commitJob._ab);
+            for( unsigned s = 0; s < nJournalStreams(); s++ ) {
+                if( commitJob.ab(s).len() )
+                    WRITETODATAFILES(h[s], commitJob.ab(s));
+            }
             debugValidateAllMapsMatch();
 
             commitJob.reset();
-            commitJob._ab.reset();
+            for( unsigned s = 0; s < nJournalStreams(); s++ )
+                commitJob.ab(s).reset();
 
             // REMAPPRIVATEVIEW
             //
@@ -679,6 +830,7 @@ namespace mongo {
             }
             else {
                 assert( inShutdown() );
+                journalWriter.flush(); // don't let a view unmap under an in-flight WRITETODATAFILES
                 if( commitJob.hasWritten() ) {
                     log() << "journal warning files are closing outside locks with writes pending" << endl;
                 }
@@ -713,13 +865,19 @@ namespace mongo {
                     // we do this in a couple blocks (the invoke()), which makes it a tiny bit faster (only a little) on throughput,
                     // but is likely also less spiky on our cpu usage, which is good.
 
-                    // commit sooner if one or more getLastError j:true is pending
-                    sleepmillis(oneThird);
-                    for( unsigned i = 1; i <= 2; i++ ) {
-                        if( commitJob._notify.nWaiting() )
-                            break;
-                        commitJob.wi()._deferred.invoke();
-                        sleepmillis(oneThird);
+                    // group commit adaptively: sessions blocking in awaitCommit() wake us
+                    // immediately rather than being polled at interval/3 granularity, so one
+                    // synchronousAppend to the journal acknowledges every waiter at once.
+                    // with no waiters we still commit every journalCommitInterval ms, which
+                    // remains the (runtime settable) latency ceiling.
+                    {
+                        scoped_lock lk(earlyCommitMutex);
+                        for( unsigned waited = 0; waited < ms; waited += oneThird ) {
+                            if( commitJob._notify.nWaiting() )
+                                break;
+                            commitJob.wi()._deferred.invoke();
+                            earlyCommitWakeup.timed_wait(lk.boost(), incxtimemillis(oneThird));
+                        }
                     }
 
                     go();
@@ -735,6 +893,7 @@ namespace mongo {
         void recover();
 
         void releasingWriteLock() {
+            commitJob.flushStaged(); // operation boundary - push this op's merged intents to the deferred queue
             // implicit commitIfNeeded check on each write unlock
             DEV commitJob._nSinceCommitIfNeededCall = 0; // implicit commit if needed
             if( commitJob.bytes() > UncommittedBytesLimit || cmdLine.durOptions & CmdLine::DurAlwaysCommit ) {
@@ -777,6 +936,7 @@ namespace mongo {
             preallocateFiles();
 
             boost::thread t(durThread);
+            boost::thread tw(journalWriterThread);
         }
 
         void DurableImpl::syncDataAndTruncateJournal() {
@@ -32,8 +32,14 @@ namespace mongo {
             commitJob.wi()._insertWriteIntent(d.p, d.len);
         }
 
+        /** ranges this close are journaled as one entry - the gap bytes cost
+            less than another JEntry header.  journaling a gap is safe: the
+            private view bytes there are either the committed values or a
+            newer declared write, so replaying them is a no-op or a repeat. */
+        enum { MaxCoalesceGap = sizeof(JEntry) };
+
         void WriteIntent::absorb(const WriteIntent& other) {
-            dassert(overlaps(other));
+            dassert(nearby(other, MaxCoalesceGap));
 
             void* newStart = min(start(), other.start());
             p = max(p, other.p);
@@ -47,6 +53,7 @@ namespace mongo {
 
             _alreadyNoted.clear();
             _writes.clear();
+            _micros.clear();
             _ops.clear();
             _drained = false;
 #if defined(DEBUG_WRITE_INTENT)
@@ -68,6 +75,15 @@ namespace mongo {
         void Writes::_insertWriteIntent(void* p, int len) {
             WriteIntent wi(p, len);
 
+            if (len <= MaxMicroLen) {
+                // tiny in-place update.  keep it out of the coalescing set and
+                // journal it as a packed micro entry.  overlap with a basic write
+                // is fine: both snapshot the private view at prep time, so on
+                // replay the bytes agree (same rationale as the coalesce gap).
+                _micros.push_back(wi);
+                return;
+            }
+
             if (_writes.empty()) {
                 _writes.insert(wi);
                 return;
@@ -78,17 +94,17 @@ namespace mongo {
             iterator closest = _writes.lower_bound(wi);
             // closest.end() >= wi.end()
 
-            if ((closest != _writes.end() && closest->overlaps(wi)) || // high end
-                    (closest != _writes.begin() && (--closest)->overlaps(wi))) { // low end
+            if ((closest != _writes.end() && closest->nearby(wi, MaxCoalesceGap)) || // high end
+                    (closest != _writes.begin() && (--closest)->nearby(wi, MaxCoalesceGap))) { // low end
                 if (closest->contains(wi))
                     return; // nothing to do
 
-                // find overlapping range and merge into wi
+                // find overlapping and nearly adjacent ranges and merge into wi
                 iterator   end(closest);
                 iterator begin(closest);
-                while (  end->overlaps(wi)) { wi.absorb(*end); ++end; if (end == _writes.end()) break; }  // look forwards
-                while (begin->overlaps(wi)) { wi.absorb(*begin); if (begin == _writes.begin()) break; --begin; } // look backwards
-                if (!begin->overlaps(wi)) ++begin; // make inclusive
+                while (  end->nearby(wi, MaxCoalesceGap)) { wi.absorb(*end); ++end; if (end == _writes.end()) break; }  // look forwards
+                while (begin->nearby(wi, MaxCoalesceGap)) { wi.absorb(*begin); if (begin == _writes.begin()) break; --begin; } // look backwards
+                if (!begin->nearby(wi, MaxCoalesceGap)) ++begin; // make inclusive
 
                 DEV { // ensure we're not deleting anything we shouldn't
                     for (iterator it(begin); it != end; ++it) {
@@ -127,22 +143,37 @@ namespace mongo {
 
         size_t privateMapBytes = 0; // used by _REMAPPRIVATEVIEW to track how much / how fast to remap
 
-        void CommitJob::beginCommit() { 
+        void CommitJob::beginCommit() {
             DEV dbMutex.assertAtLeastReadLocked();
+            flushStaged(); // a writer committing mid-operation may still have staged intents
             _commitNumber = _notify.now();
             stats.curr->_commits++;
         }
 
         void CommitJob::reset() {
             _hasWritten = false;
+            _nStaged = 0;
             _wi.clear();
             privateMapBytes += _bytes;
             _bytes = 0;
             _nSinceCommitIfNeededCall = 0;
         }
 
-        CommitJob::CommitJob() : _ab(4 * 1024 * 1024) , _hasWritten(false), 
-            _bytes(0), _nSinceCommitIfNeededCall(0) { 
+        void CommitJob::flushStaged() {
+            for( int i = 0; i < _nStaged; i++ )
+                _wi.insertWriteIntent( _staged[i].start() , _staged[i].length() );
+            _nStaged = 0;
+            wassert( _wi._writes.size() <  2000000 );
+        }
+
+        CommitJob::CommitJob() : _hasWritten(false),
+            _bytes(0), _nSinceCommitIfNeededCall(0) {
+            _nStaged = 0;
+            _abs[0] = new AlignedBuilder(4 * 1024 * 1024);
+            for( unsigned s = 1; s < MaxJournalStreams; s++ ) {
+                // start small; these grow on demand if extra streams are configured
+                _abs[s] = new AlignedBuilder(8192);
+            }
             _commitNumber = 0;
         }
 
@@ -188,10 +219,26 @@ namespace mongo {
                 }
 #endif
 
-                // remember intent. we will journal it in a bit
-                _wi.insertWriteIntent(p, len);
-                wassert( _wi._writes.size() <  2000000 );
-                //assert(  _wi._writes.size() < 20000000 );
+                // remember intent. we will journal it in a bit.  stage it first:
+                // the rest of this operation's intents are likely nearby (record
+                // plus its freelist/stats/index updates), and merging them here is
+                // cheaper than queueing each one and merging in the set later.
+                WriteIntent wi(p, len);
+                int i;
+                for( i = 0; i < _nStaged; i++ ) {
+                    if( _staged[i].nearby(wi, MaxCoalesceGap) ) {
+                        if( !_staged[i].contains(wi) ) {
+                            wi.absorb(_staged[i]);
+                            _staged[i] = wi;
+                        }
+                        break;
+                    }
+                }
+                if( i == _nStaged ) {
+                    if( _nStaged == NStaged )
+                        flushStaged();
+                    _staged[_nStaged++] = wi;
+                }
 
                 {
                     // a bit over conservative in counting pagebytes used
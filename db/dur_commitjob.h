@@ -52,6 +52,12 @@ namespace mongo {
                 return (start() <= rhs.end() && end() >= rhs.start());
             }
 
+            // overlapping, or close enough that journaling the gap is cheaper
+            // than the header of a separate journal entry
+            bool nearby(const WriteIntent& rhs, int slack) const {
+                return ((char*)start() - slack <= (char*)rhs.end() && (char*)end() + slack >= (char*)rhs.start());
+            }
+
             // is merging necessary?
             bool contains(const WriteIntent& rhs) const {
                 return (start() <= rhs.start() && end() >= rhs.end());
@@ -89,7 +95,7 @@ namespace mongo {
             */
             bool checkAndSet(void* p, int len) {
                 unsigned x = mongoutils::hashPointer(p);
-                pair<void*, int> nd = nodes[x % N];
+                pair<void*, int>& nd = nodes[x % N];
                 if( nd.first == p ) {
                     if( nd.second < len ) {
                         nd.second = len;
@@ -115,9 +121,16 @@ namespace mongo {
                 static void go(const D& d);
             };
         public:
+            /** writes this small skip the coalescing set and are journaled as packed
+                micro entries (see JMicroRun).  in-place field updates ($inc of a
+                counter etc.) land here; anything bigger follows the normal path.
+            */
+            enum { MaxMicroLen = 64 };
+
             TaskQueue<D> _deferred;
             Already<127> _alreadyNoted;
             set<WriteIntent> _writes;
+            vector<WriteIntent> _micros; // tiny writes, journaled densely (see JMicroRun)
             vector< shared_ptr<DurOp> > _ops; // all the ops other than basic writes
             bool _drained; // _deferred is drained?  for asserting/testing
 
@@ -160,7 +173,10 @@ namespace mongo {
         */
         class CommitJob : boost::noncopyable {
         public:
-            AlignedBuilder _ab; // for direct i/o writes to journal
+            /** builders for direct i/o writes to the journal, one per journal
+                stream.  PREPLOGBUFFER hashes each database onto a stream; with
+                the default single stream only ab(0) is ever used. */
+            AlignedBuilder& ab(unsigned streamNo) { return *_abs[streamNo]; }
 
             CommitJob();
 
@@ -170,6 +186,13 @@ namespace mongo {
             /** note an operation other than a "basic write" */
             void noteOp(shared_ptr<DurOp> p);
 
+            /** push staged intents (see note()) out to the deferred queue.
+                called at the write lock release boundary, on commit, and when
+                the staging buffer fills.  must hold the write lock unless the
+                buffer is known empty (e.g. durThread commits with writers
+                excluded). */
+            void flushStaged();
+
             set<WriteIntent>& writes() {
                 if( !_wi._drained ) {
                     // generally, you don't want to use the set until it is prepared (after deferred ops are applied)
@@ -194,6 +217,10 @@ namespace mongo {
             /** the commit code calls this when data reaches the journal (on disk) */
             void notifyCommitted() { _notify.notifyAll(_commitNumber); }
 
+            /** current commit number - captured at handoff to the journal writer
+                thread, which acknowledges it once the buffer is on disk */
+            NotifyAll::When commitNumber() const { return _commitNumber; }
+
             /** we check how much written and if it is getting to be a lot, we commit sooner. */
             size_t bytes() const { return _bytes; }
 
@@ -203,10 +230,21 @@ namespace mongo {
 
             Writes& wi() { return _wi; }
         private:
+            AlignedBuilder* _abs[MaxJournalStreams];
             NotifyAll::When _commitNumber;
             bool _hasWritten;
             Writes _wi; // todo: fix name
             size_t _bytes;
+
+            /** one operation declares a cluster of intents - record, freelist,
+                namespace stats, index buckets - many of them adjacent.  they are
+                staged here and merged before anything is queued, so the cluster
+                reaches the deferred queue as a few ranges instead of a dozen.
+                safe without further locking: note() runs under the write lock
+                and the buffer is empty whenever that lock is not held. */
+            enum { NStaged = 32 };
+            WriteIntent _staged[NStaged];
+            int _nStaged;
         public:
             NotifyAll _notify; // for getlasterror fsync:true acknowledgements
             unsigned _nSinceCommitIfNeededCall;
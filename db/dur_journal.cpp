@@ -69,7 +69,23 @@ namespace mongo {
 
         bool usingPreallocate = false;
 
+        // size of the preallocated-file ring.  retired journal files are
+        // recycled into these slots instead of being deleted, so steady state
+        // journal rollover reuses existing fully-allocated files.
+        const int NPreallocFiles = 3;
+
+        unsigned nJournalStreams() {
+            unsigned n = cmdLine.journalStreams;
+            if( n < 1 )
+                n = 1;
+            if( n > MaxJournalStreams )
+                n = MaxJournalStreams;
+            return n;
+        }
+
         void removeOldJournalFile(path p);
+        void queueForJournalFileWorker(const string& s);
+        void drainJournalFileWorker();
 
         filesystem::path getJournalDir() {
             filesystem::path p(dbpath);
@@ -104,19 +120,24 @@ namespace mongo {
             magic[0] = magic[1] = magic[2] = magic[3] = '\n';
 
             Checksum c;
-            c.gen(begin, (unsigned) len);
+            c.genCrc32c(begin, (unsigned) len);
             memcpy(hash, c.bytes, sizeof(hash));
         }
 
         bool JSectFooter::checkHash(const void* begin, int len) const {
-            if( !magicOk() ) { 
+            if( !magicOk() ) {
                 log() << "journal footer not valid" << endl;
                 return false;
             }
             Checksum c;
-            c.gen(begin, len);
+            c.genCrc32c(begin, len);
             DEV log() << "checkHash len:" << len << " hash:" << toHex(hash, 16) << " current:" << toHex(c.bytes, 16) << endl;
-            if( memcmp(hash, c.bytes, sizeof(hash)) == 0 ) 
+            if( memcmp(hash, c.bytes, sizeof(hash)) == 0 )
+                return true;
+            // sections written before journal format 0x414b carry the old hash
+            Checksum old;
+            old.gen(begin, (unsigned) len);
+            if( memcmp(hash, old.bytes, sizeof(hash)) == 0 )
                 return true;
             log() << "journal checkHash mismatch, got: " << toHex(c.bytes, 16) << " expected: " << toHex(hash,16) << endl;
             return false;
@@ -139,7 +160,8 @@ namespace mongo {
             n1 = n2 = n3 = n4 = '\n';
         }
 
-        Journal j;
+        Journal journals[MaxJournalStreams];
+        Journal &j = journals[0]; // stream 0: always present, owns the lsn file
 
         const unsigned long long LsnShutdownSentinel = ~((unsigned long long)0);
 
@@ -148,6 +170,7 @@ namespace mongo {
             _ageOut = true;
             _written = 0;
             _nextFileNumber = 0;
+            _streamNo = 0;
             _curLogFile = 0;
             _curFileId = 0;
             _preFlushTime = 0;
@@ -157,7 +180,10 @@ namespace mongo {
 
         path Journal::getFilePathFor(int filenumber) const {
             filesystem::path p(dir);
-            p /= string(str::stream() << "j._" << filenumber);
+            if( _streamNo == 0 )
+                p /= string(str::stream() << "j._" << filenumber);
+            else
+                p /= string(str::stream() << "j." << _streamNo << "_" << filenumber);
             return p;
         }
 
@@ -170,7 +196,7 @@ namespace mongo {
                         i != boost::filesystem::directory_iterator();
                         ++i ) {
                     string fileName = boost::filesystem::path(*i).leaf();
-                    if( str::startsWith(fileName, "j._") )
+                    if( str::startsWith(fileName, "j.") ) // any stream: j._<n> or j.<s>_<n>
                         return true;
                 }
             }
@@ -181,12 +207,13 @@ namespace mongo {
         /** throws */
         void removeJournalFiles() {
             log() << "removeJournalFiles" << endl;
+            drainJournalFileWorker(); // so the background recycler can't race us in the journal dir
             try {
                 for ( boost::filesystem::directory_iterator i( getJournalDir() );
                         i != boost::filesystem::directory_iterator();
                         ++i ) {
                     string fileName = boost::filesystem::path(*i).leaf();
-                    if( str::startsWith(fileName, "j._") ) {
+                    if( str::startsWith(fileName, "j.") ) { // any stream: j._<n> or j.<s>_<n>
                         try {
                             removeOldJournalFile(*i);
                         }
@@ -217,15 +244,19 @@ namespace mongo {
 
         /** at clean shutdown */
         bool okToCleanUp = false; // successful recovery would set this to true
-        void Journal::cleanup(bool _log) {
+        void Journal::cleanup() {
+            scoped_lock lk(_curLogFileMutex);
+            closeCurrentJournalFile();
+        }
+        void journalCleanup(bool _log) {
             if( !okToCleanUp )
                 return;
 
             if( _log )
                 log() << "journalCleanup..." << endl;
             try {
-                scoped_lock lk(_curLogFileMutex);
-                closeCurrentJournalFile();
+                for( unsigned s = 0; s < nJournalStreams(); s++ )
+                    journals[s].cleanup();
                 removeJournalFiles();
             }
             catch(std::exception& e) {
@@ -233,7 +264,6 @@ namespace mongo {
                 throw;
             }
         }
-        void journalCleanup(bool log) { j.cleanup(log); }
 
         bool _preallocateIsFaster() {
             bool faster = false;
@@ -294,22 +324,28 @@ namespace mongo {
 
             ProgressMeter m(len, 3/*secs*/, 10/*hits between time check (once every 6.4MB)*/);
 
-            File f;
-            f.open( p.string().c_str() , /*read-only*/false , /*direct-io*/false );
-            assert( f.is_open() );
-            fileofs loc = 0;
-            while ( loc < len ) {
-                f.write( loc , b.buf() , BLKSZ );
-                loc += BLKSZ;
-                m.hit(BLKSZ);
+            // build under a temp name and rename once complete, so a rotating
+            // journal (or a crash) never sees a half written prealloc file
+            filesystem::path tmp( p.string() + ".temp" );
+            {
+                File f;
+                f.open( tmp.string().c_str() , /*read-only*/false , /*direct-io*/false );
+                assert( f.is_open() );
+                fileofs loc = 0;
+                while ( loc < len ) {
+                    f.write( loc , b.buf() , BLKSZ );
+                    loc += BLKSZ;
+                    m.hit(BLKSZ);
+                }
+                assert( loc == len );
+                f.fsync();
             }
-            assert( loc == len );
-            f.fsync();
+            boost::filesystem::rename(tmp, p);
         }
 
         // throws
         void _preallocateFiles() {
-            for( int i = 0; i <= 2; i++ ) {
+            for( int i = 0; i < NPreallocFiles; i++ ) {
                 string fn = str::stream() << "prealloc." << i;
                 filesystem::path filepath = getJournalDir() / fn;
 
@@ -331,19 +367,28 @@ namespace mongo {
                 ( cmdLine.preallocj && preallocateIsFaster() ) ) {
                     usingPreallocate = true;
                     try {
-                        _preallocateFiles();
+                        // the first file is wanted right away - open() below
+                        // will take it.  the rest of the ring fills in the
+                        // background instead of stalling startup.
+                        preallocateFile( getJournalDir() / "prealloc.0" , DataLimitPerJournalFile );
                     }
                     catch(...) {
                         log() << "warning caught exception in preallocateFiles, continuing" << endl;
                     }
+                    queueForJournalFileWorker( "" );
             }
-            j.open();
+            for( unsigned s = 0; s < nJournalStreams(); s++ )
+                journals[s].open();
         }
 
         void removeOldJournalFile(path p) { 
-            if( usingPreallocate ) {
+            {
+                // recycle into the prealloc ring when there is a free slot,
+                // whether or not eager preallocation is on - the ring then
+                // self populates from retired files and rollover stops paying
+                // file creation and deletion in steady state
                 try {
-                    for( int i = 0; i <= 2; i++ ) {
+                    for( int i = 0; i < NPreallocFiles; i++ ) {
                         string fn = str::stream() << "prealloc." << i;
                         filesystem::path filepath = getJournalDir() / fn;
                         if( !filesystem::exists(filepath) ) {
@@ -370,7 +415,7 @@ namespace mongo {
                 }
             }
 
-            // already have 3 prealloc files, so delete this file
+            // the prealloc ring is full, so delete this file
             try {
                 boost::filesystem::remove(p);
             }
@@ -379,10 +424,70 @@ namespace mongo {
             }
         }
 
+        // recycling or preallocating a journal file means megabytes of zeroing
+        // and several metadata syncs; inline in rotate() that shows up as a
+        // commit latency spike.  retired files are handed to this worker
+        // instead.  an empty entry is a request to top up the prealloc ring.
+        namespace {
+            mongo::mutex journalWorkerMutex("durFileWorker");
+            boost::condition journalWorkerCond; // both "work queued" and "work finished"
+            list<string> journalWorkerQueue;
+            bool journalWorkerStarted = false;
+            bool journalWorkerBusy = false;
+        }
+
+        static void journalFileWorker() {
+            setThreadName( "durFileWorker" );
+            while( 1 ) {
+                string todo;
+                {
+                    scoped_lock lk(journalWorkerMutex);
+                    while( journalWorkerQueue.empty() )
+                        journalWorkerCond.wait(lk.boost());
+                    todo = journalWorkerQueue.front();
+                    journalWorkerQueue.pop_front();
+                    journalWorkerBusy = true;
+                }
+                try {
+                    if( todo.empty() )
+                        _preallocateFiles();
+                    else
+                        removeOldJournalFile(path(todo));
+                }
+                catch(...) {
+                    log() << "warning caught exception in journal file worker" << endl;
+                }
+                {
+                    scoped_lock lk(journalWorkerMutex);
+                    journalWorkerBusy = false;
+                    journalWorkerCond.notify_all();
+                }
+            }
+        }
+
+        void queueForJournalFileWorker(const string& s) {
+            scoped_lock lk(journalWorkerMutex);
+            if( !journalWorkerStarted ) {
+                boost::thread t(journalFileWorker);
+                journalWorkerStarted = true;
+            }
+            journalWorkerQueue.push_back(s);
+            journalWorkerCond.notify_all();
+        }
+
+        /** block until the worker has finished everything queued so far.
+            call before doing anything to the journal dir the worker might
+            race with (e.g. removing all the files at clean shutdown). */
+        void drainJournalFileWorker() {
+            scoped_lock lk(journalWorkerMutex);
+            while( !journalWorkerQueue.empty() || journalWorkerBusy )
+                journalWorkerCond.wait(lk.boost());
+        }
+
         // find a prealloc.<n> file, presumably to take and use
         path findPrealloced() { 
             try {
-                for( int i = 0; i <= 2; i++ ) {
+                for( int i = 0; i < NPreallocFiles; i++ ) {
                     string fn = str::stream() << "prealloc." << i;
                     filesystem::path filepath = getJournalDir() / fn;
                     if( filesystem::exists(filepath) )
@@ -396,10 +501,11 @@ namespace mongo {
 
         /** assure journal/ dir exists. throws. call during startup. */
         void journalMakeDir() {
-            j.init();
-
             filesystem::path p = getJournalDir();
-            j.dir = p.string();
+            for( unsigned s = 0; s < nJournalStreams(); s++ ) {
+                journals[s].init(s);
+                journals[s].dir = p.string();
+            }
             log() << "journal dir=" << j.dir << endl;
             if( !exists(j.dir) ) {
                 try {
@@ -450,10 +556,14 @@ namespace mongo {
             }
         }
 
-        void Journal::init() {
+        void Journal::init(unsigned streamNo) {
             assert( _curLogFile == 0 );
-            MongoFile::notifyPreFlush = preFlush;
-            MongoFile::notifyPostFlush = postFlush;
+            _streamNo = streamNo;
+            if( streamNo == 0 ) {
+                // stream 0 tracks the lsn for all streams; there is only one lsn file
+                MongoFile::notifyPreFlush = preFlush;
+                MongoFile::notifyPostFlush = postFlush;
+            }
         }
 
         void Journal::open() {
@@ -575,11 +685,13 @@ namespace mongo {
             while( !_oldJournalFiles.empty() ) {
                 JFile f = _oldJournalFiles.front();
 
-                if( f.lastEventTimeMs < _lastFlushTime + ExtraKeepTimeMs ) {
-                    // eligible for deletion
-                    path p( f.filename );
+                // stream 0 owns the lsn bookkeeping; its flush time covers all streams
+                if( f.lastEventTimeMs < journals[0]._lastFlushTime + ExtraKeepTimeMs ) {
+                    // eligible for deletion.  recycling it does zeroing and
+                    // fsyncs, so hand it off rather than doing that here, in
+                    // the middle of a rotate under _curLogFileMutex.
                     log() << "old journal file will be removed: " << f.filename << endl;
-                    removeOldJournalFile(p);
+                    queueForJournalFileWorker( f.filename );
                 }
                 else {
                     break;
@@ -596,8 +708,10 @@ namespace mongo {
             return j._ageOut ? 1 : 0;
         }*/
         void setAgeOutJournalFiles(bool a) {
-            scoped_lock lk(j._curLogFileMutex);
-            j._ageOut = a;
+            for( unsigned s = 0; s < nJournalStreams(); s++ ) {
+                scoped_lock lk(journals[s]._curLogFileMutex);
+                journals[s]._ageOut = a;
+            }
         }
 
         void Journal::_rotate() {
@@ -634,13 +748,15 @@ namespace mongo {
             @param uncompressed - a buffer that will be written to the journal after compression
             will not return until on disk
         */
-        void WRITETOJOURNAL(JSectHeader h, AlignedBuilder& uncompressed) {
+        void WRITETOJOURNAL(unsigned streamNo, JSectHeader h, AlignedBuilder& uncompressed) {
             Timer t;
-            j.journal(h, uncompressed);
+            journals[streamNo].journal(h, uncompressed);
             stats.curr->_writeToJournalMicros += t.micros();
         }
         void Journal::journal(const JSectHeader& h, const AlignedBuilder& uncompressed) {
             RACECHECK
+            // static ok: journal() calls are serialized across all streams (they come
+            // from the journal writer thread, or from a group commit that drained it)
             static AlignedBuilder b(32*1024*1024);
             /* buffer to journal will be
                JSectHeader
@@ -687,7 +803,7 @@ namespace mongo {
                 // must already be open -- so that _curFileId is correct for previous buffer building
                 assert( _curLogFile );
 
-                stats.curr->_uncompressedBytes += b.len();
+                stats.curr->_uncompressedBytes += uncompressed.len();
                 unsigned w = b.len();
                 _written += w;
                 assert( w <= L );
@@ -24,6 +24,15 @@ namespace mongo {
 
         const unsigned Alignment = 8192;
 
+        /** upper bound for --journalStreams.  databases are hashed across the
+            streams; stream 0 writes the traditional j._<n> files, stream s>0
+            writes j.<s>_<n> files. */
+        const unsigned MaxJournalStreams = 8;
+
+        /** number of journal streams configured (cmdLine.journalStreams clamped
+            to [1,MaxJournalStreams]).  1 means the traditional single journal. */
+        unsigned nJournalStreams();
+
 #pragma pack(1)
         /** beginning header for a journal/j._<n> file
             there is nothing important int this header at this time.  except perhaps version #.
@@ -39,7 +48,11 @@ namespace mongo {
 #if defined(_NOCOMPRESS)
             enum { CurrentVersion = 0x4148 };
 #else
-            enum { CurrentVersion = 0x4149 };
+            // 0x414a added packed micro write runs (JEntry::OpCode_Micro).  a
+            // 0x4149 section can't contain one, so those files remain readable.
+            // 0x414b switched section checksums to crc32c; JSectFooter::checkHash
+            // accepts the old hash too, so older files also remain readable.
+            enum { CurrentVersion = 0x414b, MicroVersion = 0x414a, LastVersion = 0x4149 };
 #endif
             unsigned short _version;
 
@@ -55,7 +68,11 @@ namespace mongo {
             char reserved3[8026]; // 8KB total for the file header
             char txt2[2];         // "\n\n" at the end
 
+#if defined(_NOCOMPRESS)
             bool versionOk() const { return _version == CurrentVersion; }
+#else
+            bool versionOk() const { return _version == CurrentVersion || _version == MicroVersion || _version == LastVersion; }
+#endif
             bool valid() const { return magic[0] == 'j' && txt2[1] == '\n' && fileId; }
         };
 
@@ -91,6 +108,7 @@ namespace mongo {
                 OpCode_DbContext   = 0xfffffffe,
                 OpCode_FileCreated = 0xfffffffd,
                 OpCode_DropDb      = 0xfffffffc,
+                OpCode_Micro       = 0xfffffffb,
                 OpCode_Min         = 0xfffff000
             };
             union {
@@ -129,6 +147,32 @@ namespace mongo {
             }
         };
 
+        /** header for a dense run of tiny writes (in-place field updates such as $inc)
+            to a single file.  each write in the run costs a JMicroEntry (6 bytes)
+            rather than a full JEntry (12 bytes), and the file number is recorded once
+            for the whole run.  n JMicroEntry's follow the header.
+        */
+        struct JMicroRun {
+            unsigned sentinel;   // JEntry::OpCode_Micro
+            int _fileNo;         // same encoding as JEntry::_fileNo
+            unsigned short n;    // how many JMicroEntry's follow, > 0
+
+            int getFileNo() const { return _fileNo & (~JEntry::LocalDbBit); }
+            void setFileNo(int f) { _fileNo = f; }
+            void setLocalDbContextBit() { _fileNo |= JEntry::LocalDbBit; }
+            bool isLocalDbContext() const { return _fileNo & JEntry::LocalDbBit; }
+        };
+
+        /** one tiny write within a JMicroRun.  data[len] follows. */
+        struct JMicroEntry {
+            unsigned ofs;        // offset in file
+            unsigned short len;  // length in bytes of the data that follows
+
+            const char * srcData() const {
+                return ((const char *) this) + sizeof(JMicroEntry);
+            }
+        };
+
         /** group commit section footer. md5 is a key field. */
         struct JSectFooter {
             JSectFooter();
@@ -24,15 +24,21 @@
 namespace mongo {
     namespace dur {
 
-        /** the writeahead journal for durability */
+        /** one stream of the writeahead journal for durability.  normally there
+            is a single stream; with --journalStreams databases are hashed across
+            several, each with its own files, so one database's write volume does
+            not inflate the journal sections (and fsyncs) of the others.
+        */
         class Journal {
         public:
             string dir; // set by journalMakeDir() during initialization
 
             Journal();
 
-            /** call during startup by journalMakeDir() */
-            void init();
+            /** call during startup by journalMakeDir()
+                @param streamNo which journal stream this is (0 is always present)
+            */
+            void init(unsigned streamNo);
 
             /** check if time to rotate files.  assure a file is open.
                 done separately from the journal() call as we can do this part
@@ -48,7 +54,7 @@ namespace mongo {
             boost::filesystem::path getFilePathFor(int filenumber) const;
 
             unsigned long long lastFlushTime() const { return _lastFlushTime; }
-            void cleanup(bool log); // closes and removes journal files
+            void cleanup(); // closes the current journal file (at shutdown, before the files are removed)
 
             unsigned long long curFileId() const { return _curFileId; }
 
@@ -73,6 +79,7 @@ namespace mongo {
 
             unsigned long long _written; // bytes written so far to the current journal (log) file
             unsigned _nextFileNumber;
+            unsigned _streamNo; // which journal stream we are; determines our file names
         public:
             mutex _curLogFileMutex;
             bool _ageOut;
@@ -99,5 +106,10 @@ namespace mongo {
             void updateLSNFile();
         };
 
+        /** the journal streams.  stream 0 is always present and owns the lsn
+            file; PREPLOGBUFFER hashes databases across streams [0,nJournalStreams()).
+        */
+        extern Journal journals[MaxJournalStreams];
+
     }
 }
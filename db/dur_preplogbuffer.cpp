@@ -42,8 +42,6 @@ using namespace mongoutils;
 namespace mongo {
     namespace dur {
 
-        extern Journal j;
-
         RelativePath local = RelativePath::fromRelativePath("local");
 
         MongoMMF* findMMF_inlock(void *ptr, size_t &ofs) {
@@ -55,10 +53,33 @@ namespace mongo {
             return f;
         }
 
-        /** put the basic write operation into the buffer (bb) to be journaled */
-        void prepBasicWrite_inlock(AlignedBuilder&bb, const WriteIntent *i, RelativePath& lastDbPath) {
+        /** which journal stream a database's entries go to.  everything for one
+            database lands in a single stream, so each stream is internally
+            ordered and recovery can replay the streams one after another.
+        */
+        unsigned journalStreamFor(const string& db) {
+            const unsigned n = nJournalStreams();
+            if( n == 1 )
+                return 0;
+            unsigned h = 0;
+            for( const char *p = db.c_str(); *p; p++ )
+                h = h * 131 + (unsigned char) *p;
+            return h % n;
+        }
+        unsigned journalStreamFor(const RelativePath& dbPath) {
+            // with --directoryperdb the relative path is e.g. "foo/foo"; key on the
+            // simple name so DurOp's (which only know the database name) route the same
+            const string p = dbPath.toString();
+            size_t x = p.find_last_of("/\\");
+            return journalStreamFor( x == string::npos ? p : p.substr(x+1) );
+        }
+
+        /** put the basic write operation into its stream's buffer to be journaled */
+        void prepBasicWrite_inlock(const WriteIntent *i, RelativePath lastDbPath[]) {
             size_t ofs = 1;
             MongoMMF *mmf = findMMF_inlock(i->start(), /*out*/ofs);
+            const unsigned stream = journalStreamFor( mmf->relativePath() );
+            AlignedBuilder& bb = commitJob.ab( stream );
 
             if( unlikely(!mmf->willNeedRemap()) ) {
                 // tag this mmf as needed a remap of its private view later.
@@ -85,11 +106,11 @@ namespace mongo {
             if( mmf->relativePath() == local ) {
                 e.setLocalDbContextBit();
             }
-            else if( mmf->relativePath() != lastDbPath ) {
-                lastDbPath = mmf->relativePath();
+            else if( mmf->relativePath() != lastDbPath[stream] ) {
+                lastDbPath[stream] = mmf->relativePath();
                 JDbContext c;
                 bb.appendStruct(c);
-                bb.appendStr(lastDbPath.toString());
+                bb.appendStr(lastDbPath[stream].toString());
             }
             bb.appendStruct(e);
 #if defined(_EXPERIMENTAL)
@@ -106,7 +127,75 @@ namespace mongo {
                 // mappings, but better to be safe.
 
                 WriteIntent next ((char*)i->start() + e.len, i->length() - e.len);
-                prepBasicWrite_inlock(bb, &next, lastDbPath);
+                prepBasicWrite_inlock(&next, lastDbPath);
+            }
+        }
+
+        /** put the accumulated tiny write intents into the buffer as packed micro runs.
+            consecutive (after sorting) intents that land in the same file share one
+            JMicroRun header and cost only a JMicroEntry each.  @see JMicroRun
+        */
+        void prepMicroWrites_inlock(RelativePath lastDbPath[]) {
+            vector<WriteIntent>& micros = commitJob.wi()._micros;
+            if( micros.empty() )
+                return;
+
+            // sort by address so same-file intents are adjacent (each file's private
+            // view is one contiguous region)
+            sort(micros.begin(), micros.end());
+
+            unsigned i = 0;
+            while( i < micros.size() ) {
+                size_t ofs = 1;
+                MongoMMF *mmf = findMMF_inlock(micros[i].start(), /*out*/ofs);
+                assert( ofs <= 0x80000000 );
+
+                if( unlikely(!mmf->willNeedRemap()) ) {
+                    mmf->willNeedRemap() = true;
+                }
+
+                char *viewStart = (char*)micros[i].start() - ofs;
+                char *viewEnd = viewStart + mmf->length();
+
+                if( unlikely((char*)micros[i].end() > viewEnd) ) {
+                    // straddles the end of the file's mapping - basic writes know how
+                    // to split at the boundary, so hand this one off
+                    prepBasicWrite_inlock(&micros[i], lastDbPath);
+                    i++;
+                    continue;
+                }
+
+                const unsigned stream = journalStreamFor( mmf->relativePath() );
+                AlignedBuilder& bb = commitJob.ab( stream );
+
+                // find the run: entries for the same file, capped by the 16 bit count
+                unsigned j = i + 1;
+                while( j < micros.size() && j - i < 0xffff &&
+                        micros[j].start() >= viewStart && (char*)micros[j].end() <= viewEnd )
+                    j++;
+
+                JMicroRun run;
+                run.sentinel = JEntry::OpCode_Micro;
+                run.setFileNo( mmf->fileSuffixNo() );
+                run.n = (unsigned short)( j - i );
+                if( mmf->relativePath() == local ) {
+                    run.setLocalDbContextBit();
+                }
+                else if( mmf->relativePath() != lastDbPath[stream] ) {
+                    lastDbPath[stream] = mmf->relativePath();
+                    JDbContext c;
+                    bb.appendStruct(c);
+                    bb.appendStr(lastDbPath[stream].toString());
+                }
+                bb.appendStruct(run);
+
+                for( ; i < j; i++ ) {
+                    JMicroEntry e;
+                    e.ofs = (unsigned)( (char*)micros[i].start() - viewStart );
+                    e.len = (unsigned short) micros[i].length();
+                    bb.appendStruct(e);
+                    bb.appendBuf(micros[i].start(), e.len);
+                }
             }
         }
 
@@ -114,31 +203,35 @@ namespace mongo {
             two writes to the same location during the group commit interval, it is likely
             (although not assured) that it is journaled here once.
         */
-        void prepBasicWrites(AlignedBuilder& bb) {
+        void prepBasicWrites() {
             scoped_lock lk(privateViews._mutex());
 
-            // each time events switch to a different database we journal a JDbContext
-            RelativePath lastDbPath;
+            // each time events switch to a different database we journal a JDbContext.
+            // tracked per stream as each stream is a separate entry sequence.
+            RelativePath lastDbPath[MaxJournalStreams];
 
             for( set<WriteIntent>::iterator i = commitJob.writes().begin(); i != commitJob.writes().end(); i++ ) {
-                prepBasicWrite_inlock(bb, &(*i), lastDbPath);
+                prepBasicWrite_inlock(&(*i), lastDbPath);
             }
+
+            prepMicroWrites_inlock(lastDbPath);
         }
 
-        void resetLogBuffer(/*out*/JSectHeader& h, AlignedBuilder& bb) {
+        void resetLogBuffer(/*out*/JSectHeader& h, AlignedBuilder& bb, unsigned streamNo) {
             bb.reset();
 
             h.setSectionLen(0xffffffff);  // total length, will fill in later
             h.seqNumber = getLastDataFileFlushTime();
-            h.fileId = j.curFileId();
+            h.fileId = journals[streamNo].curFileId();
         }
 
         /** we will build an output buffer ourself and then use O_DIRECT
             we could be in read lock for this
             caller handles locking
-            @return partially populated sectheader and _ab set
+            @param h one JSectHeader per journal stream
+            @return partially populated sectheaders and the commit job's builders set
         */
-        void _PREPLOGBUFFER(JSectHeader& h) {
+        void _PREPLOGBUFFER(JSectHeader h[]) {
             assert( cmdLine.dur );
 
             {
@@ -149,23 +242,26 @@ namespace mongo {
                 writes._drained = true;
             }
 
-            AlignedBuilder& bb = commitJob._ab;
-            resetLogBuffer(h, bb); // adds JSectHeader
+            for( unsigned s = 0; s < nJournalStreams(); s++ )
+                resetLogBuffer(h[s], commitJob.ab(s), s);
 
-            // ops other than basic writes (DurOp's)
+            // ops other than basic writes (DurOp's).  each op goes to the same
+            // stream as its database's basic writes so that, for example, a file
+            // create stays ordered with the writes into that file.
             {
                 for( vector< shared_ptr<DurOp> >::iterator i = commitJob.ops().begin(); i != commitJob.ops().end(); ++i ) {
-                    (*i)->serialize(bb);
+                    (*i)->serialize( commitJob.ab( journalStreamFor( (*i)->dbSimpleName() ) ) );
                 }
             }
 
-            prepBasicWrites(bb);
+            prepBasicWrites();
 
             return;
         }
-        void PREPLOGBUFFER(/*out*/ JSectHeader& h) {
+        void PREPLOGBUFFER(/*out*/ JSectHeader h[]) {
             Timer t;
-            j.assureLogFileOpen(); // so fileId is set
+            for( unsigned s = 0; s < nJournalStreams(); s++ )
+                journals[s].assureLogFileOpen(); // so fileId is set
             _PREPLOGBUFFER(h);
             stats.curr->_prepLogBufferMicros += t.micros();
         }
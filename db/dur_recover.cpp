@@ -37,6 +37,7 @@
 #include "curop.h"
 #include "mongommf.h"
 #include "../util/compress.h"
+#include "../util/concurrency/thread_pool.h"
 
 #include <sys/stat.h>
 #include <fcntl.h>
@@ -48,7 +49,7 @@ namespace mongo {
     namespace dur {
 
         struct ParsedJournalEntry { /*copyable*/
-            ParsedJournalEntry() : e(0) { }
+            ParsedJournalEntry() : e(0), micro(0), microFileNo(0) { }
 
             // relative path of database for the operation.
             // might be a pointer into mmaped Journal file
@@ -57,22 +58,32 @@ namespace mongo {
             // thse are pointers into the memory mapped journal file
             const JEntry *e;  // local db sentinel is already parsed out here into dbName
 
-            // if not one of the two simple JEntry's above, this is the operation:
+            // a tiny write from a JMicroRun.  the run's file number is copied here as
+            // the header isn't repeated per entry.
+            const JMicroEntry *micro;
+            int microFileNo;
+
+            // if not one of the simple entries above, this is the operation:
             shared_ptr<DurOp> op;
         };
 
         void removeJournalFiles();
         path getJournalDir();
 
-        /** get journal filenames, in order. throws if unexpected content found */
-        static void getFiles(path dir, vector<path>& files) {
+        /** get one stream's journal filenames, in order. throws if unexpected content found.
+            stream 0's files are named j._<n>, stream s>0's j.<s>_<n>.
+        */
+        static void getFiles(path dir, unsigned streamNo, vector<path>& files) {
+            string prefix = "j._";
+            if( streamNo )
+                prefix = str::stream() << "j." << streamNo << "_";
             map<unsigned,path> m;
             for ( filesystem::directory_iterator i( dir );
                     i != filesystem::directory_iterator();
                     ++i ) {
                 filesystem::path filepath = *i;
                 string fileName = filesystem::path(*i).leaf();
-                if( str::startsWith(fileName, "j._") ) {
+                if( str::startsWith(fileName, prefix) ) {
                     unsigned u = str::toUnsigned( str::after(fileName, '_') );
                     if( m.count(u) ) {
                         uasserted(13531, str::stream() << "unexpected files in journal directory " << dir.string() << " : " << fileName);
@@ -97,12 +108,15 @@ namespace mongo {
             auto_ptr<BufReader> _entries;
             const JSectHeader _h;
             const char *_lastDbName; // pointer into mmaped journal file
+            const JMicroRun *_microRun; // run we are in the middle of, if any
+            unsigned _microRemaining;   // entries left in that run
             const bool _doDurOps;
             string _uncompressed;
         public:
             JournalSectionIterator(const JSectHeader& h, const void *compressed, unsigned compressedLen, bool doDurOpsRecovering) :
                 _h(h),
-                _lastDbName(0)
+                _lastDbName(0),
+                _microRun(0), _microRemaining(0)
                 , _doDurOps(doDurOpsRecovering)
             {
                 assert( doDurOpsRecovering );
@@ -121,7 +135,8 @@ namespace mongo {
             JournalSectionIterator(const JSectHeader &h, const void *p, unsigned len) :
                 _entries( new BufReader((const char *) p, len) ),
                 _h(h),
-                _lastDbName(0)
+                _lastDbName(0),
+                _microRun(0), _microRemaining(0)
                 , _doDurOps(false)
 
                 { }
@@ -134,6 +149,16 @@ namespace mongo {
              *  throws on premature end of section.
              */
             void next(ParsedJournalEntry& e) {
+                // the caller reuses e; don't leave anything from the last entry behind
+                e.e = 0;
+                e.micro = 0;
+                e.op.reset();
+
+                if( _microRemaining ) {
+                    nextMicro(e);
+                    return;
+                }
+
                 unsigned lenOrOpCode;
                 _entries->read(lenOrOpCode);
 
@@ -154,6 +179,11 @@ namespace mongo {
                         return;
                     }
 
+                    case JEntry::OpCode_Micro: {
+                        beginMicroRun(e);
+                        return;
+                    }
+
                     case JEntry::OpCode_DbContext: {
                         _lastDbName = (const char*) _entries->pos();
                         const unsigned limit = std::min((unsigned)Namespace::MaxNsLen, _entries->remaining());
@@ -161,6 +191,10 @@ namespace mongo {
                         massert(13533, "problem processing journal file during recovery", _lastDbName[len] == '\0');
                         _entries->skip(len+1); // skip '\0' too
                         _entries->read(lenOrOpCode); // read this for the fall through
+                        if( lenOrOpCode == JEntry::OpCode_Micro ) {
+                            beginMicroRun(e);
+                            return;
+                        }
                     }
                     // fall through as a basic operation always follows jdbcontext, and we don't have anything to return yet
 
@@ -179,6 +213,23 @@ namespace mongo {
                 _entries->skip(e.e->len);
             }
 
+        private:
+            /** we just read a JMicroRun sentinel; parse the run header and yield its first entry */
+            void beginMicroRun(ParsedJournalEntry& e) {
+                _entries->rewind(4);
+                _microRun = (const JMicroRun *) _entries->skip(sizeof(JMicroRun));
+                _microRemaining = _microRun->n;
+                assert( _microRemaining );
+                nextMicro(e);
+            }
+
+            void nextMicro(ParsedJournalEntry& e) {
+                e.micro = (const JMicroEntry *) _entries->skip(sizeof(JMicroEntry));
+                _entries->skip(e.micro->len);
+                e.microFileNo = _microRun->getFileNo();
+                e.dbName = _microRun->isLocalDbContext() ? "local" : _lastDbName;
+                _microRemaining--;
+            }
         };
 
         static string fileName(const char* dbName, int fileNo) {
@@ -213,13 +264,12 @@ namespace mongo {
             _mmfs.clear();
         }
 
-        void RecoveryJob::write(const ParsedJournalEntry& entry) {
+        MongoMMF* RecoveryJob::getMongoMMF(const char *dbName, int fileNo) {
             //TODO(mathias): look into making some of these dasserts
-            assert(entry.e);
-            assert(entry.dbName);
-            assert(strnlen(entry.dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
+            assert(dbName);
+            assert(strnlen(dbName, MaxDatabaseNameLen) < MaxDatabaseNameLen);
 
-            const string fn = fileName(entry.dbName, entry.e->getFileNo());
+            const string fn = fileName(dbName, fileNo);
             MongoFile* file;
             {
                 MongoFileFinder finder; // must release lock before creating new MongoMMF
@@ -238,6 +288,26 @@ namespace mongo {
                 _mmfs.push_back(sp);
                 mmf = sp.get();
             }
+            return mmf;
+        }
+
+        void RecoveryJob::write(const ParsedJournalEntry& entry) {
+            if( entry.micro ) {
+                MongoMMF *mmf = getMongoMMF(entry.dbName, entry.microFileNo);
+
+                if ((entry.micro->ofs + entry.micro->len) <= mmf->length()) {
+                    assert(mmf->view_write());
+                    void* dest = (char*)mmf->view_write() + entry.micro->ofs;
+                    memcpy(dest, entry.micro->srcData(), entry.micro->len);
+                    stats.curr->_writeToDataFilesBytes += entry.micro->len;
+                }
+                else {
+                    massert(15969, "Trying to write past end of file in WRITETODATAFILES", _recovering);
+                }
+                return;
+            }
+
+            MongoMMF *mmf = getMongoMMF(entry.dbName, entry.e->getFileNo());
 
             if ((entry.e->ofs + entry.e->len) <= mmf->length()) {
                 assert(mmf->view_write());
@@ -253,7 +323,23 @@ namespace mongo {
         }
 
         void RecoveryJob::applyEntry(const ParsedJournalEntry& entry, bool apply, bool dump) {
-            if( entry.e ) {
+            if( entry.micro ) {
+                if( dump ) {
+                    stringstream ss;
+                    ss << "  MICROWRITE " << setw(20) << entry.dbName << '.';
+                    if( entry.microFileNo == JEntry::DotNsSuffix )
+                        ss << "ns";
+                    else
+                        ss << setw(2) << entry.microFileNo;
+                    ss << ' ' << setw(6) << entry.micro->len <<
+                       "  " << hexdump(entry.micro->srcData(), entry.micro->len);
+                    log() << ss.str() << endl;
+                }
+                if( apply ) {
+                    write(entry);
+                }
+            }
+            else if( entry.e ) {
                 if( dump ) {
                     stringstream ss;
                     ss << "  BASICWRITE " << setw(20) << entry.dbName << '.';
@@ -283,14 +369,129 @@ namespace mongo {
             }
         }
 
+        /** the basic writes from one journal section that land in a single datafile.
+            the target view is resolved serially (under _mx) before the batch is handed
+            to a pool worker, so workers never touch _mmfs; they only memcpy into the
+            already-mapped view.  pool workers swallow exceptions, so we latch any error
+            here and the scheduling thread rethrows after join().
+        */
+        struct FileWriteBatch : boost::noncopyable {
+            MongoMMF * const mmf;
+            const bool recovering;
+            vector<const JEntry *> entries;
+            vector<const JMicroEntry *> micros;
+            unsigned long long bytes; // written; summed into stats by the scheduling thread
+            string error;             // empty if all writes applied cleanly
+            FileWriteBatch(MongoMMF *m, bool r) : mmf(m), recovering(r), bytes(0) { }
+            void apply() {
+                try {
+                    for( vector<const JEntry*>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                        const JEntry *e = *i;
+                        if ((e->ofs + e->len) <= mmf->length()) {
+                            assert(mmf->view_write());
+                            assert(e->srcData());
+                            void* dest = (char*)mmf->view_write() + e->ofs;
+                            memcpy(dest, e->srcData(), e->len);
+                            bytes += e->len;
+                        }
+                        else {
+                            massert(15945, "Trying to write past end of file in WRITETODATAFILES", recovering);
+                        }
+                    }
+                    // ordering with the entries above is immaterial: all of a
+                    // section's writes carry bytes from the same commit point
+                    for( vector<const JMicroEntry*>::const_iterator i = micros.begin(); i != micros.end(); ++i ) {
+                        const JMicroEntry *m = *i;
+                        if ((m->ofs + m->len) <= mmf->length()) {
+                            assert(mmf->view_write());
+                            void* dest = (char*)mmf->view_write() + m->ofs;
+                            memcpy(dest, m->srcData(), m->len);
+                            bytes += m->len;
+                        }
+                        else {
+                            massert(15970, "Trying to write past end of file in WRITETODATAFILES", recovering);
+                        }
+                    }
+                }
+                catch( std::exception& e ) {
+                    error = e.what();
+                }
+            }
+        };
+
+        /** run the queued per-file batches, in parallel when there is more than one,
+            and wait for all of them before returning (the barrier the caller relies on).
+        */
+        void RecoveryJob::flushBatches(map< MongoMMF*, shared_ptr<FileWriteBatch> >& batches) {
+            if( batches.empty() )
+                return;
+
+            if( batches.size() == 1 ) {
+                batches.begin()->second->apply();
+            }
+            else {
+                // shared by recovery and WRITETODATAFILES; processSection is serialized
+                // by _mx so lazy construction here is effectively single threaded
+                static ThreadPool pool( 4 );
+                for( map< MongoMMF*, shared_ptr<FileWriteBatch> >::const_iterator i = batches.begin(); i != batches.end(); ++i ) {
+                    pool.schedule( &FileWriteBatch::apply , i->second.get() );
+                }
+                pool.join();
+            }
+
+            for( map< MongoMMF*, shared_ptr<FileWriteBatch> >::const_iterator i = batches.begin(); i != batches.end(); ++i ) {
+                const FileWriteBatch& b = *i->second;
+                if( !b.error.empty() ) {
+                    msgasserted(15946, str::stream() << "error applying journal section : " << b.error);
+                }
+                stats.curr->_writeToDataFilesBytes += b.bytes;
+            }
+            batches.clear();
+        }
+
+        /** apply one section's entries with the writes to different datafiles done in
+            parallel.  within a file the original entry order is kept (one worker per
+            file); cross-file order is immaterial for basic writes because a section's
+            entries were all snapshotted at the same commit point, so even overlapping
+            intents carry identical bytes.  DurOps (file create, drop db) act as
+            barriers: everything queued before one is flushed and joined first.
+            sections themselves stay strictly serial (processSection holds _mx).
+        */
+        void RecoveryJob::applyEntriesParallel(const vector<ParsedJournalEntry> &entries) {
+            map< MongoMMF*, shared_ptr<FileWriteBatch> > batches;
+            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                if( i->e || i->micro ) {
+                    MongoMMF *mmf = getMongoMMF(i->dbName, i->e ? i->e->getFileNo() : i->microFileNo);
+                    shared_ptr<FileWriteBatch>& b = batches[mmf];
+                    if( !b )
+                        b.reset( new FileWriteBatch( mmf , _recovering ) );
+                    if( i->e )
+                        b->entries.push_back( i->e );
+                    else
+                        b->micros.push_back( i->micro );
+                }
+                else {
+                    flushBatches(batches);
+                    applyEntry(*i, true, false);
+                }
+            }
+            flushBatches(batches);
+        }
+
         void RecoveryJob::applyEntries(const vector<ParsedJournalEntry> &entries) {
             bool apply = (cmdLine.durOptions & CmdLine::DurScanOnly) == 0;
             bool dump = cmdLine.durOptions & CmdLine::DurDumpJournal;
             if( dump )
                 log() << "BEGIN section" << endl;
 
-            for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
-                applyEntry(*i, apply, dump);
+            if( apply && !dump && entries.size() >= 128 ) {
+                // large group commit - spread the memcpy work over several threads
+                applyEntriesParallel(entries);
+            }
+            else {
+                for( vector<ParsedJournalEntry>::const_iterator i = entries.begin(); i != entries.end(); ++i ) {
+                    applyEntry(*i, apply, dump);
+                }
             }
 
             if( dump )
@@ -434,7 +635,8 @@ namespace mongo {
             return processFileBuffer(p, (unsigned) f.length());
         }
 
-        /** @param files all the j._0 style files we need to apply for recovery */
+        /** @param files all the journal files we need to apply for recovery,
+                         stream by stream, each stream's files in order */
         void RecoveryJob::go(vector<path>& files) {
             log() << "recover begin" << endl;
             _recovering = true;
@@ -481,8 +683,13 @@ namespace mongo {
                 return;
             }
 
+            // all of a database's entries land in a single stream and each stream is
+            // ordered within itself, so the streams can be replayed one after another.
+            // we scan every possible stream regardless of the current --journalStreams
+            // setting in case the crashed run was configured differently.
             vector<path> journalFiles;
-            getFiles(p, journalFiles);
+            for( unsigned s = 0; s < MaxJournalStreams; s++ )
+                getFiles(p, s, journalFiles);
 
             if( journalFiles.empty() ) {
                 log() << "recover : no journal files present, no recovery needed" << endl;
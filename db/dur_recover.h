@@ -11,6 +11,7 @@ namespace mongo {
 
     namespace dur {
         struct ParsedJournalEntry;
+        struct FileWriteBatch;
 
         /** call go() to execute a recovery from existing journal files.
          */
@@ -28,9 +29,12 @@ namespace mongo {
 
             static RecoveryJob & get() { return _instance; }
         private:
+            MongoMMF* getMongoMMF(const char *dbName, int fileNo); // finds or opens the target datafile
             void write(const ParsedJournalEntry& entry); // actually writes to the file
             void applyEntry(const ParsedJournalEntry& entry, bool apply, bool dump);
             void applyEntries(const vector<ParsedJournalEntry> &entries);
+            void applyEntriesParallel(const vector<ParsedJournalEntry> &entries);
+            void flushBatches(map< MongoMMF*, shared_ptr<FileWriteBatch> >& batches);
             bool processFileBuffer(const void *, unsigned len);
             bool processFile(path journalfile);
             void _close(); // doesn't lock
@@ -66,7 +66,7 @@ namespace mongo {
 #endif
 
 #if defined(_EXPERIMENTAL)
-        // doesn't work with groupCommitWithLimitedLocks()
+        // doesn't work with groupCommitWithLimitedLocks() (and assumes a single journal stream)
         void WRITETODATAFILES_Impl3() {
             /* we go backwards as what is at the end is most likely in the cpu cache.  it won't be much, but we'll take it. */
             for( set<WriteIntent>::const_iterator it(commitJob.writes().begin()), end(commitJob.writes().end()); it != end; ++it ) {
@@ -74,7 +74,7 @@ namespace mongo {
                 stats.curr->_writeToDataFilesBytes += intent.length();
                 dassert(intent.w_ptr);
                 memcpy(intent.w_ptr,
-                       commitJob._ab.atOfs(intent.ofsInJournalBuffer),
+                       commitJob.ab(0).atOfs(intent.ofsInJournalBuffer),
                        intent.length());
             }
         }
@@ -107,6 +107,18 @@ namespace mongo {
             return str::stream() << "FileCreatedOp " << _p.toString() << ' ' << _len/1024.0/1024.0 << "MB";
         }
 
+        string FileCreatedOp::dbSimpleName() const {
+            // _p is e.g. "foo.3", or "foo/foo.3" with --directoryperdb
+            string s = _p.toString();
+            size_t x = s.find_last_of("/\\");
+            if( x != string::npos )
+                s = s.substr(x+1);
+            x = s.find_last_of('.');
+            if( x != string::npos )
+                s = s.substr(0, x);
+            return s;
+        }
+
         // if an operation deletes or creates a file (or moves etc.), it may need files closed.
         bool FileCreatedOp::needFilesClosed() {
             return exists( _p.asFullPath() );
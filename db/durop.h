@@ -65,6 +65,11 @@ namespace mongo {
             /** if the op requires all file to be closed before doing its work, returns true. */
             virtual bool needFilesClosed() { return false; }
 
+            /** simple name of the database the op applies to.  used to journal the op
+                in the same stream as the database's basic writes (see --journalStreams).
+            */
+            virtual string dbSimpleName() const = 0;
+
         protected:
             /** DurOp will have already written the opcode for you */
             virtual void _serialize(AlignedBuilder& ab) = 0;
@@ -82,6 +87,7 @@ namespace mongo {
             virtual void replay();
             virtual string toString();
             virtual bool needFilesClosed();
+            virtual string dbSimpleName() const;
         protected:
             virtual void _serialize(AlignedBuilder& ab);
         private:
@@ -98,6 +104,7 @@ namespace mongo {
             virtual void replay();
             virtual string toString() { return string("DropDbOp ") + _db; }
             virtual bool needFilesClosed() { return true; }
+            virtual string dbSimpleName() const { return _db; }
         protected:
             virtual void _serialize(AlignedBuilder& ab);
         private:
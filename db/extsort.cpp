@@ -19,7 +19,9 @@
 #include "pch.h"
 
 #include "extsort.h"
+#include "index.h"
 #include "namespace-inl.h"
+#include "curop-inl.h"
 #include "../util/file.h"
 #include <sys/types.h>
 #include <sys/stat.h>
@@ -27,13 +29,13 @@
 
 namespace mongo {
 
-    IndexInterface *BSONObjExternalSorter::extSortIdxInterface;
-    Ordering BSONObjExternalSorter::extSortOrder( Ordering::make(BSONObj()) );
     unsigned long long BSONObjExternalSorter::_compares = 0;
 
     BSONObjExternalSorter::BSONObjExternalSorter( IndexInterface &i, const BSONObj & order , long maxFileSize )
-        : _idxi(i), _order( order.getOwned() ) , _maxFilesize( maxFileSize ) ,
-          _arraySize(1000000), _cur(0), _curSizeSoFar(0), _sorted(0) {
+        : _idxi(i), _order( order.getOwned() ) , _compact(false) , _maxFilesize( maxFileSize ) ,
+          _arraySize(1000000), _cur(0), _curSizeSoFar(0),
+          _spilling(0), _spillFailed(false), _spillShutdown(false), _spillMutex("extsort"),
+          _sorted(0) {
 
         stringstream rootpath;
         rootpath << dbpath;
@@ -49,6 +51,9 @@ namespace mongo {
     }
 
     BSONObjExternalSorter::~BSONObjExternalSorter() {
+        _stopSpillThread();
+        if ( _curSizeSoFar && haveClient() )
+            cc().curop()->noteMemFreed( _curSizeSoFar );
         if ( _cur ) {
             delete _cur;
             _cur = 0;
@@ -57,13 +62,15 @@ namespace mongo {
         wassert( removed == 1 + _files.size() );
     }
 
+    void BSONObjExternalSorter::setIndexKeys() {
+        dassert( ! _cur && ! _sorted );
+        _compact = _idxi.compactSortKeys();
+    }
+
     void BSONObjExternalSorter::_sortInMem() {
-        // extSortComp needs to use glbals
-        // qsort_r only seems available on bsd, which is what i really want to use
-        dblock l;
-        extSortIdxInterface = &_idxi;
-        extSortOrder = Ordering::make(_order);
-        _cur->sort( BSONObjExternalSorter::extSortComp );
+        // MyCmp is re-entrant so no global state (and no lock) is needed here --
+        // several sorters can sort at once during a parallel index build
+        stable_sort( _cur->data() , _cur->data() + _cur->size() , MyCmp( _idxi , _order ) );
     }
 
     void BSONObjExternalSorter::sort() {
@@ -86,6 +93,10 @@ namespace mongo {
             _cur = 0;
         }
 
+        // all batches must be on disk before anyone opens the spill files
+        _stopSpillThread();
+        uassert( 15909 , "error spilling to disk for external sort: " + _spillErrmsg , ! _spillFailed );
+
         if ( _files.size() == 0 )
             return;
 
@@ -98,12 +109,20 @@ namespace mongo {
             _cur = new InMemory( _arraySize );
         }
 
-        Data& d = _cur->getNext();
-        d.first = o.getOwned();
-        d.second = loc;
+        Entry& e = _cur->getNext();
+        long size;
+        if ( _compact ) {
+            e.key = KeyV1Shared( o );
+            size = e.key.dataSize();
+        }
+        else {
+            e.bkey = o.getOwned();
+            size = o.objsize();
+        }
+        e.loc = loc;
 
-        long size = o.objsize();
-        _curSizeSoFar += size + sizeof( DiskLoc ) + sizeof( BSONObj );
+        _curSizeSoFar += size + sizeof( Entry );
+        cc().curop()->noteMemUsed( size + sizeof( Entry ) );
 
         if (  _cur->hasSpace() == false ||  _curSizeSoFar > _maxFilesize ) {
             finishMap();
@@ -115,34 +134,102 @@ namespace mongo {
     void BSONObjExternalSorter::finishMap() {
         uassert( 10050 ,  "bad" , _cur );
 
+        // this batch is headed to disk; its memory no longer counts against the op
+        if ( _curSizeSoFar && haveClient() )
+            cc().curop()->noteMemFreed( _curSizeSoFar );
         _curSizeSoFar = 0;
         if ( _cur->size() == 0 )
             return;
 
-        _sortInMem();
-
         stringstream ss;
         ss << _root.string() << "/file." << _files.size();
         string file = ss.str();
+        _files.push_back( file );
 
-        ofstream out;
-        out.open( file.c_str() , ios_base::out | ios_base::binary );
-        assertStreamGood( 10051 ,  (string)"couldn't open file: " + file , out );
-
-        int num = 0;
-        for ( InMemory::iterator i=_cur->begin(); i != _cur->end(); ++i ) {
-            Data p = *i;
-            out.write( p.first.objdata() , p.first.objsize() );
-            out.write( (char*)(&p.second) , sizeof( DiskLoc ) );
-            num++;
+        // hand the full batch to the spill thread; add() keeps going into a fresh
+        // batch while this one is sorted and written in the background.  we only
+        // block here if the previous batch is still being written (disk is behind).
+        {
+            scoped_lock lk(_spillMutex);
+            while ( _spilling && ! _spillFailed )
+                _spillDone.wait(lk.boost());
+            uassert( 15908 , "error spilling to disk for external sort: " + _spillErrmsg , ! _spillFailed );
+            _spilling = _cur;
+            _spillFile = file;
+            _cur = 0;
+            _spillReady.notify_one();
         }
 
-        _cur->clear();
+        if ( ! _spillThread )
+            _spillThread.reset( new boost::thread( boost::bind( &BSONObjExternalSorter::_spillThreadLoop , this ) ) );
+    }
 
-        _files.push_back( file );
-        out.close();
+    void BSONObjExternalSorter::_spillThreadLoop() {
+        Client::initThread( "extsort" );
+        while ( 1 ) {
+            InMemory * batch;
+            string file;
+            {
+                scoped_lock lk(_spillMutex);
+                while ( ! _spilling && ! _spillShutdown )
+                    _spillReady.wait(lk.boost());
+                if ( ! _spilling ) // shutdown and drained
+                    break;
+                batch = _spilling;
+                file = _spillFile;
+            }
 
-        log(2) << "Added file: " << file << " with " << num << "objects for external sort" << endl;
+            try {
+                // MyCmp is re-entrant, so we don't need the write lock
+                // (which the foreground likely holds)
+                stable_sort( batch->data() , batch->data() + batch->size() , MyCmp( _idxi , _order ) );
+
+                ofstream out;
+                out.open( file.c_str() , ios_base::out | ios_base::binary );
+                assertStreamGood( 10051 ,  (string)"couldn't open file: " + file , out );
+
+                int num = 0;
+                for ( InMemory::iterator i=batch->begin(); i != batch->end(); ++i ) {
+                    Entry& p = *i;
+                    if ( p.key.data() )
+                        out.write( p.key.data() , p.key.dataSize() );
+                    else
+                        out.write( p.bkey.objdata() , p.bkey.objsize() );
+                    out.write( (char*)(&p.loc) , sizeof( DiskLoc ) );
+                    num++;
+                }
+                out.close();
+
+                log(2) << "Added file: " << file << " with " << num << "objects for external sort" << endl;
+            }
+            catch ( std::exception& e ) {
+                scoped_lock lk(_spillMutex);
+                _spillFailed = true;
+                _spillErrmsg = e.what();
+            }
+
+            delete batch;
+
+            {
+                scoped_lock lk(_spillMutex);
+                _spilling = 0;
+                _spillDone.notify_one();
+            }
+        }
+        cc().shutdown();
+    }
+
+    void BSONObjExternalSorter::_stopSpillThread() {
+        if ( ! _spillThread )
+            return;
+        {
+            scoped_lock lk(_spillMutex);
+            _spillShutdown = true;
+            _spillReady.notify_one();
+        }
+        _spillThread->join();
+        _spillThread.reset();
+        _spillShutdown = false;
     }
 
     // ---------------------------------
@@ -151,14 +238,40 @@ namespace mongo {
         _cmp( sorter->_idxi, sorter->_order ) , _in( 0 ) {
 
         for ( list<string>::iterator i=sorter->_files.begin(); i!=sorter->_files.end(); i++ ) {
-            _files.push_back( new FileIterator( *i ) );
-            _stash.push_back( pair<Data,bool>( Data( BSONObj() , DiskLoc() ) , false ) );
+            _files.push_back( new FileIterator( *i , sorter->_compact ) );
+            _stash.push_back( pair<Entry,bool>( Entry() , false ) );
         }
 
         if ( _files.size() == 0 && sorter->_cur ) {
             _in = sorter->_cur;
             _it = sorter->_cur->begin();
         }
+
+        // build the loser tree: prime every stream, then climb each one until an
+        // empty slot takes the loser.  the last stream's path is fully occupied by
+        // then, so it plays through to the root and leaves the winner at node 0.
+        int k = _files.size();
+        if ( k > 0 ) {
+            for ( int i=0; i<k; i++ )
+                _refill( i );
+            _tree.resize( k , -1 );
+            for ( int i=0; i<k; i++ ) {
+                int s = i;
+                int t = ( k + i ) / 2;
+                while ( t > 0 ) {
+                    if ( _tree[t] == -1 ) {
+                        _tree[t] = s;
+                        s = -1;
+                        break;
+                    }
+                    if ( _beats( _tree[t] , s ) )
+                        swap( _tree[t] , s );
+                    t /= 2;
+                }
+                if ( s != -1 )
+                    _tree[0] = s;
+            }
+        }
     }
 
     BSONObjExternalSorter::Iterator::~Iterator() {
@@ -167,56 +280,73 @@ namespace mongo {
         _files.clear();
     }
 
+    void BSONObjExternalSorter::Iterator::_refill( unsigned i ) {
+        if ( _files[i]->more() )
+            _stash[i] = pair<Entry,bool>( _files[i]->next() , true );
+        else
+            _stash[i].second = false;
+    }
+
+    bool BSONObjExternalSorter::Iterator::_beats( int a , int b ) {
+        if ( a < 0 )
+            return false;
+        if ( b < 0 )
+            return true;
+        if ( ! _stash[a].second )
+            return false;
+        if ( ! _stash[b].second )
+            return true;
+        return _cmp( _stash[a].first , _stash[b].first );
+    }
+
+    void BSONObjExternalSorter::Iterator::_replay( int s ) {
+        for ( int t = ( (int)_files.size() + s ) / 2; t > 0; t /= 2 ) {
+            if ( _beats( _tree[t] , s ) )
+                swap( _tree[t] , s );
+        }
+        _tree[0] = s;
+    }
+
     bool BSONObjExternalSorter::Iterator::more() {
 
         if ( _in )
             return _it != _in->end();
 
-        for ( vector<FileIterator*>::iterator i=_files.begin(); i!=_files.end(); i++ )
-            if ( (*i)->more() )
-                return true;
-        for ( vector< pair<Data,bool> >::iterator i=_stash.begin(); i!=_stash.end(); i++ )
-            if ( i->second )
-                return true;
-        return false;
+        if ( _files.size() == 0 )
+            return false;
+
+        // the winner of the tree is exhausted only once every stream is
+        int s = _tree[0];
+        return s >= 0 && _stash[s].second;
+    }
+
+    BSONObjExternalSorter::Data BSONObjExternalSorter::Iterator::_toData( const Entry& e ) {
+        if ( e.key.data() )
+            return Data( e.key.toBson() , e.loc );
+        return Data( e.bkey , e.loc );
     }
 
     BSONObjExternalSorter::Data BSONObjExternalSorter::Iterator::next() {
 
         if ( _in ) {
-            Data& d = *_it;
+            Entry& e = *_it;
             ++_it;
-            return d;
+            return _toData( e );
         }
 
-        Data best;
-        int slot = -1;
-
-        for ( unsigned i=0; i<_stash.size(); i++ ) {
+        int s = _tree[0];
+        assert( s >= 0 && _stash[s].second );
 
-            if ( ! _stash[i].second ) {
-                if ( _files[i]->more() )
-                    _stash[i] = pair<Data,bool>( _files[i]->next() , true );
-                else
-                    continue;
-            }
-
-            if ( slot == -1 || _cmp( best , _stash[i].first ) == 0 ) {
-                best = _stash[i].first;
-                slot = i;
-            }
+        Entry best = _stash[s].first;
+        _refill( s );
+        _replay( s );
 
-        }
-
-        assert( slot >= 0 );
-        _stash[slot].second = false;
-
-        return best;
+        return _toData( best );
     }
 
     // -----------------------------------
 
-    BSONObjExternalSorter::FileIterator::FileIterator( string file ) {
+    BSONObjExternalSorter::FileIterator::FileIterator( string file, bool compact ) : _compact( compact ) {
         unsigned long long length;
         _buf = (char*)_file.map( file.c_str() , length , MemoryMappedFile::SEQUENTIAL );
         massert( 10308 ,  "mmap failed" , _buf );
@@ -229,12 +359,22 @@ namespace mongo {
         return _buf < _end;
     }
 
-    BSONObjExternalSorter::Data BSONObjExternalSorter::FileIterator::next() {
-        BSONObj o( _buf );
-        _buf += o.objsize();
-        DiskLoc * l = (DiskLoc*)_buf;
+    BSONObjExternalSorter::Entry BSONObjExternalSorter::FileIterator::next() {
+        Entry e;
+        if ( _compact ) {
+            /* KeyV1 encodings are self delimiting, so like the bson case the
+               entry stays a view into the mapped file rather than a copy */
+            KeyV1Shared k( _buf );
+            _buf += k.dataSize();
+            e.key = k;
+        }
+        else {
+            e.bkey = BSONObj( _buf );
+            _buf += e.bkey.objsize();
+        }
+        e.loc = *(DiskLoc*)_buf;
         _buf += 8;
-        return Data( o , *l );
+        return e;
     }
 
 }
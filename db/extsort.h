@@ -20,6 +20,7 @@
 
 #include "../pch.h"
 #include "jsobj.h"
+#include "key.h"
 #include "namespace-inl.h"
 #include "curop-inl.h"
 #include "../util/array.h"
@@ -34,23 +35,40 @@ namespace mongo {
         BSONObjExternalSorter( IndexInterface &i, const BSONObj & order = BSONObj() , long maxFileSize = 1024 * 1024 * 100 );
         ~BSONObjExternalSorter();
         typedef pair<BSONObj,DiskLoc> Data;
- 
+
+        /** internal form of one (key, loc) entry.  when the sorter runs in
+            compact mode -- setIndexKeys() was called and the index version
+            orders keys the way KeyV1::woCompare does -- the key is held in
+            its KeyV1 encoding: a fraction of the bson rendering's bytes, in
+            memory and in the spill files, compared with a dense byte loop.
+            otherwise the owned bson form is kept in bkey and compares go
+            through the index interface as before. */
+        struct Entry {
+            KeyV1Shared key; // null (data()==0) outside compact mode
+            BSONObj bkey;
+            DiskLoc loc;
+        };
+
     private:
         IndexInterface& _idxi;
 
-        static int _compare(IndexInterface& i, const Data& l, const Data& r, const Ordering& order) { 
+        static int _compare(IndexInterface& i, const Entry& l, const Entry& r, const Ordering& order) {
             RARELY killCurrentOp.checkForInterrupt();
             _compares++;
-            int x = i.keyCompare(l.first, r.first, order);
+            int x;
+            if ( l.key.data() )
+                x = l.key.woCompare( r.key, order );
+            else
+                x = i.keyCompare( l.bkey, r.bkey, order );
             if ( x )
                 return x;
-            return l.second.compare( r.second );
+            return l.loc.compare( r.loc );
         }
 
         class MyCmp {
         public:
             MyCmp( IndexInterface& i, BSONObj order = BSONObj() ) : _i(i), _order( Ordering::make(order) ) {}
-            bool operator()( const Data &l, const Data &r ) const {
+            bool operator()( const Entry &l, const Entry &r ) const {
                 return _compare(_i, l, r, _order) < 0;
             };
         private:
@@ -58,32 +76,22 @@ namespace mongo {
             const Ordering _order;
         };
 
-        static IndexInterface *extSortIdxInterface;
-        static Ordering extSortOrder;
-        static int extSortComp( const void *lv, const void *rv ) {
-            DEV RARELY {                 
-                dbMutex.assertWriteLocked(); // must be as we use a global var
-            }
-            Data * l = (Data*)lv;
-            Data * r = (Data*)rv;
-            return _compare(*extSortIdxInterface, *l, *r, extSortOrder);
-        };
-
         class FileIterator : boost::noncopyable {
         public:
-            FileIterator( string file );
+            FileIterator( string file, bool compact );
             ~FileIterator();
             bool more();
-            Data next();
+            Entry next();
         private:
             MemoryMappedFile _file;
             char * _buf;
             char * _end;
+            bool _compact; // file holds KeyV1 encodings rather than bson
         };
 
     public:
 
-        typedef FastArray<Data> InMemory;
+        typedef FastArray<Entry> InMemory;
 
         class Iterator : boost::noncopyable {
         public:
@@ -94,9 +102,26 @@ namespace mongo {
             Data next();
 
         private:
+            /** a beats b if a's current datum sorts first.  exhausted streams lose
+                to live ones; -1 marks an empty tree slot and loses to everything. */
+            bool _beats( int a , int b );
+            /** advance stream i, updating its stash slot */
+            void _refill( unsigned i );
+            /** replay stream s's leaf-to-root path after its head changed */
+            void _replay( int s );
+
+            /** surface form handed to consumers; decodes compact keys */
+            static Data _toData( const Entry& e );
+
             MyCmp _cmp;
             vector<FileIterator*> _files;
-            vector< pair<Data,bool> > _stash;
+            vector< pair<Entry,bool> > _stash;
+
+            /* loser tree over the file iterators: node t holds the stream that lost
+               the match played there, the overall winner sits at node 0.  consuming
+               the winner replays a single leaf-to-root path, so each element costs
+               O(log k) compares instead of a scan of all k spill files. */
+            vector<int> _tree;
 
             InMemory * _in;
             InMemory::iterator _it;
@@ -122,6 +147,13 @@ namespace mongo {
 
         long getCurSizeSoFar() { return _curSizeSoFar; }
 
+        /** declare that the objects to be added are index keys: values only,
+            with no field names to preserve.  (keys from IndexSpec::getKeys
+            qualify; arbitrary tuples, e.g. map/reduce's, do not.)  lets the
+            sorter run in compact mode when the index version permits -- see
+            Entry.  call before the first add(). */
+        void setIndexKeys();
+
         void hintNumObjects( long long numObjects ) {
             if ( numObjects < _arraySize )
                 _arraySize = (int)(numObjects + 100);
@@ -134,7 +166,14 @@ namespace mongo {
         void sort( string file );
         void finishMap();
 
+        /** body of the background spill thread: sorts and writes handed-off batches
+            so add() keeps accumulating while the previous batch hits disk */
+        void _spillThreadLoop();
+        /** stop the spill thread after it drains any pending batch */
+        void _stopSpillThread();
+
         BSONObj _order;
+        bool _compact; // hold keys KeyV1 encoded; see Entry
         long _maxFilesize;
         path _root;
 
@@ -142,6 +181,18 @@ namespace mongo {
         InMemory * _cur;
         long _curSizeSoFar;
 
+        // spill pipeline -- one batch being written in the background while the
+        // foreground fills the next
+        InMemory * _spilling;  // batch owned by the spill thread; 0 when idle
+        string _spillFile;     // destination of _spilling
+        bool _spillFailed;
+        string _spillErrmsg;
+        bool _spillShutdown;
+        mongo::mutex _spillMutex;
+        boost::condition _spillReady; // work handed to the thread
+        boost::condition _spillDone;  // the thread went idle
+        boost::scoped_ptr<boost::thread> _spillThread;
+
         list<string> _files;
         bool _sorted;
 
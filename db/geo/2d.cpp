@@ -1443,12 +1443,14 @@ namespace mongo {
 
                             // log() << "Diving to level : " << ( _fringe.back().size() / 2 + 1 ) << endl;
 
+                            // pushed in descending hash order so the back-to-front
+                            // scan probes the btree in ascending, sequential order
                             string lastSuffix = _fringe.back();
                             _fringe.pop_back();
-                            _fringe.push_back( lastSuffix + "00" );
-                            _fringe.push_back( lastSuffix + "01" );
                             _fringe.push_back( lastSuffix + "11" );
                             _fringe.push_back( lastSuffix + "10" );
+                            _fringe.push_back( lastSuffix + "01" );
+                            _fringe.push_back( lastSuffix + "00" );
 
                             continue;
                         }
@@ -48,11 +48,35 @@ namespace mongo {
                 hashedToNormal[fixed] = i;
             }
 
+            // the inverse direction: spread the 8 bits of a byte into the
+            // even bit positions of 16, so hashing interleaves a byte at a
+            // time instead of a bit at a time
+            long long currAllX = 0 , currAllY = 0;
+            for ( unsigned i=0; i<64; i++ ) {
+                if ( i % 2 == 0 ) currAllX |= masks64[i];
+                else currAllY |= masks64[i];
+            }
+            allX = currAllX;
+            allY = currAllY;
+            for ( unsigned i=0; i<256; i++ ) {
+                unsigned spread = 0;
+                for ( int j=0; j<8; j++ ) {
+                    if ( i & ( 1 << j ) )
+                        spread |= ( 1 << ( j * 2 ) );
+                }
+                hashedFromNormal[i] = spread;
+            }
+
         }
         int masks32[32];
         long long masks64[64];
 
         unsigned hashedToNormal[256];
+        unsigned hashedFromNormal[256];
+
+        // interleaved positions belonging to each axis
+        long long allX;
+        long long allY;
     };
 
     extern GeoBitSets geoBitSets;
@@ -111,12 +135,9 @@ namespace mongo {
 
         void init( unsigned x , unsigned y , unsigned bits ) {
             assert( bits <= 32 );
-            _hash = 0;
             _bits = bits;
-            for ( unsigned i=0; i<bits; i++ ) {
-                if ( isBitSet( x , i ) ) _hash |= geoBitSets.masks64[i*2];
-                if ( isBitSet( y , i ) ) _hash |= geoBitSets.masks64[(i*2)+1];
-            }
+            _hash = ( _interleave( x ) << 1 ) | _interleave( y );
+            _fix();
         }
 
         void unhash_fast( unsigned& x , unsigned& y ) const {
@@ -233,43 +254,22 @@ namespace mongo {
             _move( 1 , y );
         }
 
+        /** step one axis of the hash by a cell without deinterleaving.
+            filling the other axis' positions with ones lets an add carry
+            straight across them, and zeros do the same for a borrow, so this
+            is a single masked add/subtract instead of a bit-by-bit carry
+            walk.  over/underflow wraps, as the old walk did. */
         void _move( unsigned offset , int d ) {
             if ( d == 0 )
                 return;
             assert( d <= 1 && d>= -1 ); // TEMP
 
-            bool from, to;
-            if ( d > 0 ) {
-                from = 0;
-                to = 1;
-            }
-            else {
-                from = 1;
-                to = 0;
-            }
-
-            unsigned pos = ( _bits * 2 ) - 1;
-            if ( offset == 0 )
-                pos--;
-            while ( true ) {
-                if ( getBit(pos) == from ) {
-                    setBit( pos , to );
-                    return;
-                }
-
-                if ( pos < 2 ) {
-                    // overflow
-                    for ( ; pos < ( _bits * 2 ) ; pos += 2 ) {
-                        setBit( pos , from );
-                    }
-                    return;
-                }
-
-                setBit( pos , from );
-                pos -= 2;
-            }
-
-            assert(0);
+            long long keep = offset == 0 ? geoBitSets.allX : geoBitSets.allY;
+            long long unit = geoBitSets.masks64[ ( _bits - 1 ) * 2 + offset ];
+            if ( d > 0 )
+                _hash = ( ( ( _hash | ~keep ) + unit ) & keep ) | ( _hash & ~keep );
+            else
+                _hash = ( ( ( _hash & keep ) - unit ) & keep ) | ( _hash & ~keep );
         }
 
         GeoHash& operator=(const GeoHash& h) {
@@ -348,6 +348,16 @@ namespace mongo {
 
     private:
 
+        /** spread the bits of v over the even positions of the result, a
+            byte at a time via the table, rather than a bit at a time */
+        static long long _interleave( unsigned v ) {
+            const unsigned * t = geoBitSets.hashedFromNormal;
+            return ( (long long) t[ v >> 24 ] << 48 ) |
+                   ( (long long) t[ ( v >> 16 ) & 0xff ] << 32 ) |
+                   ( (long long) t[ ( v >> 8 ) & 0xff ] << 16 ) |
+                   ( (long long) t[ v & 0xff ] );
+        }
+
         static void _copy( char * dst , const char * src ) {
             for ( unsigned a=0; a<8; a++ ) {
                 dst[a] = src[7-a];
@@ -0,0 +1,71 @@
+// @file hasher.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "hasher.h"
+
+namespace mongo {
+
+    void BSONElementHasher::recursiveHash( md5_state_t *st , const BSONElement& e , bool includeFieldName ) {
+        int canonicalType = e.canonicalType();
+        md5_append( st , (const md5_byte_t*)&canonicalType , sizeof(canonicalType) );
+
+        if ( includeFieldName ) {
+            md5_append( st , (const md5_byte_t*)e.fieldName() , e.fieldNameSize() );
+        }
+
+        if ( !e.mayEncapsulate() ) {
+            if ( e.isNumber() ) {
+                /* hash the same value for all numeric representations.  woCompare
+                   treats 2, 2LL and 2.0 as equal, so they must hash equally;
+                   non integral doubles simply collide with their truncation,
+                   which is harmless for a hash. */
+                long long v = e.numberLong();
+                md5_append( st , (const md5_byte_t*)&v , sizeof(v) );
+            }
+            else {
+                md5_append( st , (const md5_byte_t*)e.value() , e.valuesize() );
+            }
+            return;
+        }
+
+        /* Object, Array, CodeWScope : recurse so that numeric canonicalization
+           applies to the contained elements too */
+        if ( e.type() == CodeWScope ) {
+            md5_append( st , (const md5_byte_t*)e.codeWScopeCode() ,
+                        (int)strlen( e.codeWScopeCode() ) + 1 );
+        }
+        BSONObjIterator i( e.type() == CodeWScope ? e.codeWScopeObject() : e.embeddedObject() );
+        while ( i.more() ) {
+            recursiveHash( st , i.next() , true );
+        }
+    }
+
+    long long BSONElementHasher::hash64( const BSONElement& e , long long seed ) {
+        md5_state_t st;
+        md5_init( &st );
+        md5_append( &st , (const md5_byte_t*)&seed , sizeof(seed) );
+        recursiveHash( &st , e , false );
+        md5digest d;
+        md5_finish( &st , d );
+        long long out;
+        memcpy( &out , d , sizeof(out) );
+        return out;
+    }
+
+} // namespace mongo
@@ -0,0 +1,45 @@
+// @file hasher.h
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "jsobj.h"
+#include "../util/md5.hpp"
+
+namespace mongo {
+
+    /** 64 bit hash of a BSONElement's value, for hashed indexes.
+
+        elements whose values compare equal with woCompare (field name aside)
+        hash equally; in particular the numeric types are canonicalized so 2,
+        2LL and 2.0 all produce the same hash.  md5 underneath so distribution
+        is uniform regardless of the input distribution - that is the point.
+
+        the hash of a given (seed, element) pair must never change across
+        versions: hashes are persisted in index buckets.
+    */
+    class BSONElementHasher : boost::noncopyable {
+    public:
+        static long long hash64( const BSONElement& e , long long seed );
+
+    private:
+        BSONElementHasher();
+        static void recursiveHash( md5_state_t *st , const BSONElement& e , bool includeFieldName );
+    };
+
+} // namespace mongo
@@ -0,0 +1,113 @@
+// @file hashindex.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "namespace-inl.h"
+#include "jsobj.h"
+#include "index.h"
+#include "btree.h"
+#include "pdfile.h"
+#include "hasher.h"
+
+namespace mongo {
+
+    static const string HASHED_INDEX_NAME = "hashed";
+
+    /* hashed index : db.foo.ensureIndex( { x : "hashed" } )
+
+       stores BSONElementHasher::hash64 of the field's value as the key, so
+       monotonically increasing values (ObjectId _ids, timestamps) scatter
+       across the key space instead of appending to the rightmost bucket, and
+       long string keys compare as cheap 8 byte integers in the btree.
+
+       only equality lookups can use it.  the cursor below is a plain btree
+       cursor over the hash value; collisions are pruned by the matcher against
+       the full document, which always runs because a typed index never claims
+       exact keys (see BtreeCursor::modifiedKeys).
+    */
+    class HashedIndexType : public IndexType {
+    public:
+        HashedIndexType( const IndexPlugin *plugin , const IndexSpec *spec )
+            : IndexType( plugin , spec ) {
+            BSONObjIterator i( spec->keyPattern );
+            uassert( 15902 , "hashed index takes exactly one field" , i.more() );
+            BSONElement firstElt = i.next();
+            uassert( 15903 , "hashed index takes exactly one field" , !i.more() );
+            uassert( 15904 , "bad key pattern for hashed index" ,
+                     firstElt.type() == String && HASHED_INDEX_NAME == firstElt.valuestr() );
+            _field = firstElt.fieldName();
+            _seed = spec->info["seed"].numberLong(); // 0 unless specified
+        }
+
+        virtual void getKeys( const BSONObj &obj, BSONObjSet &keys ) const {
+            BSONElement e = obj.getFieldDotted( _field );
+            uassert( 15905 , "hashed index doesn't support array values" , e.type() != Array );
+            if ( e.eoo() )
+                e = _spec->missingField();
+            BSONObjBuilder b;
+            b.append( "" , BSONElementHasher::hash64( e , _seed ) );
+            keys.insert( b.obj() );
+        }
+
+        virtual shared_ptr<Cursor> newCursor( const BSONObj &query , const BSONObj &order , int numWanted ) const {
+            BSONElement e = query[ _field.c_str() ];
+            massert( 15906 , "hashed index requires an equality predicate" , isEquality( e ) );
+            BSONObjBuilder b;
+            b.append( "" , BSONElementHasher::hash64( e , _seed ) );
+            BSONObj key = b.obj();
+            IndexDetails *id = const_cast<IndexDetails*>( _spec->getDetails() );
+            NamespaceDetails *d = nsdetails( id->parentNS().c_str() );
+            return shared_ptr<Cursor>( BtreeCursor::make( d , d->idxNo( *id ) , *id , key , key , true , 1 ) );
+        }
+
+        virtual IndexSuitability suitability( const BSONObj &query , const BSONObj &order ) const {
+            if ( isEquality( query[ _field.c_str() ] ) )
+                return HELPFUL;
+            return USELESS;
+        }
+
+        virtual bool scanAndOrderRequired( const BSONObj &query , const BSONObj &order ) const {
+            return !order.isEmpty();
+        }
+
+    private:
+        /** a simple equality predicate - not a regex and not an operator expression */
+        static bool isEquality( const BSONElement &e ) {
+            if ( e.eoo() || e.type() == RegEx )
+                return false;
+            if ( e.isABSONObj() && !e.embeddedObject().isEmpty() &&
+                 e.embeddedObject().firstElement().fieldName()[0] == '$' )
+                return false;
+            return true;
+        }
+
+        string _field;
+        long long _seed;
+    };
+
+    class HashedIndexPlugin : public IndexPlugin {
+    public:
+        HashedIndexPlugin() : IndexPlugin( HASHED_INDEX_NAME ) {}
+
+        virtual IndexType* generate( const IndexSpec *spec ) const {
+            return new HashedIndexType( this , spec );
+        }
+
+    } hashedIndexPlugin;
+
+} // namespace mongo
@@ -23,6 +23,7 @@
 #include "background.h"
 #include "repl/rs.h"
 #include "ops/delete.h"
+#include "stats/indexstats.h"
 
 
 namespace mongo {
@@ -32,6 +33,7 @@ namespace mongo {
     public:
         typedef typename V::KeyOwned KeyOwned;
         virtual int keyCompare(const BSONObj& l,const BSONObj& r, const Ordering &ordering);
+        virtual bool compactSortKeys() const;
 
 /*        virtual DiskLoc locate(const IndexDetails &idx , const DiskLoc& thisLoc, const BSONObj& key, const Ordering &order,
             int& pos, bool& found, const DiskLoc &recordLoc, int direction) { 
@@ -64,6 +66,114 @@ namespace mongo {
             }
         }
 
+        /** extrapolate total keys from one bucket per level: each level's key
+            count is taken to be this bucket's count times the number of buckets
+            the level would hold at the fanout seen so far.  rough, but reads at
+            most tree-depth buckets and is plenty for comparing index sizes. */
+        virtual long long keyCountEstimate(const DiskLoc& thisLoc) const {
+            long long estimate = 0;
+            long long bucketsAtLevel = 1;
+            DiskLoc loc = thisLoc;
+            while( !loc.isNull() ) {
+                const BtreeBucket<V> *b = loc.btree<V>();
+                int n = b->nKeys();
+                estimate += bucketsAtLevel * n;
+                if( n == 0 )
+                    break;
+                bucketsAtLevel *= ( n + 1 );
+                // sample the middle child as representative of the next level
+                DiskLoc next = b->keyNode( n / 2 ).prevChildBucket;
+                if( next.isNull() )
+                    next = b->getNextChild();
+                loc = next;
+            }
+            return estimate;
+        }
+
+        /** tally every used key in the subtree.  no comparisons - just the
+            bucket headers and each key's used bit (n can include unused keys
+            left behind by deletes, so summing n alone would overcount).
+            a nonzero cap stops the walk once the tally reaches it. */
+        static long long countSubtree( const DiskLoc& thisLoc, long long cap ) {
+            const BtreeBucket<V> *b = thisLoc.btree<V>();
+            int n = b->nKeys();
+            long long c = 0;
+            for( int i = 0; i < n; i++ ) {
+                if ( cap && c >= cap )
+                    return c;
+                if ( b->isUsed( i ) )
+                    c++;
+                const DiskLoc prev = b->keyNode( i ).prevChildBucket;
+                if ( !prev.isNull() )
+                    c += countSubtree( prev, cap ? cap - c : 0 );
+            }
+            if ( !b->getNextChild().isNull() && !( cap && c >= cap ) )
+                c += countSubtree( b->getNextChild(), cap ? cap - c : 0 );
+            return c;
+        }
+
+        /** @return -1/0/1 for key below/inside/above the range.  a 0 bound
+            pointer means that side is no longer constrained at this depth. */
+        static int relToRange( const typename V::Key& k,
+                               const typename V::Key* lo, bool loInc,
+                               const typename V::Key* hi, bool hiInc,
+                               const Ordering& order ) {
+            if ( lo ) {
+                int c = k.woCompare( *lo, order );
+                if ( c < 0 || ( c == 0 && !loInc ) )
+                    return -1;
+            }
+            if ( hi ) {
+                int c = k.woCompare( *hi, order );
+                if ( c > 0 || ( c == 0 && !hiInc ) )
+                    return 1;
+            }
+            return 0;
+        }
+
+        /** descend along the range boundaries.  a child subtree sits between
+            the keys on either side of it (duplicates may equal a separator),
+            so when both separators are inside the range the whole subtree is
+            and countSubtree() takes over with no further comparing. */
+        static long long countRangeRec( const DiskLoc& thisLoc,
+                                        const typename V::Key* lo, bool loInc,
+                                        const typename V::Key* hi, bool hiInc,
+                                        const Ordering& order, long long cap ) {
+            const BtreeBucket<V> *b = thisLoc.btree<V>();
+            int n = b->nKeys();
+            long long c = 0;
+            int prevRel = lo ? -1 : 0; // rel of the imaginary key left of child 0
+            for( int i = 0; i <= n; i++ ) {
+                if ( cap && c >= cap )
+                    return c;
+                int rel = ( i == n ) ? ( hi ? 1 : 0 ) :
+                          relToRange( b->keyNode( i ).key, lo, loInc, hi, hiInc, order );
+                const DiskLoc child = ( i == n ) ? b->getNextChild() : b->keyNode( i ).prevChildBucket;
+                if ( !child.isNull() && prevRel <= 0 && rel >= 0 ) {
+                    if ( prevRel == 0 && rel == 0 )
+                        c += countSubtree( child, cap ? cap - c : 0 );
+                    else
+                        c += countRangeRec( child,
+                                            prevRel < 0 ? lo : 0, loInc,
+                                            rel > 0 ? hi : 0, hiInc,
+                                            order, cap ? cap - c : 0 );
+                }
+                if ( i < n && rel == 0 && b->isUsed( i ) )
+                    c++;
+                prevRel = rel;
+            }
+            return c;
+        }
+
+        virtual long long countRange(const DiskLoc& thisLoc, const BSONObj& lo, bool loInc,
+                                     const BSONObj& hi, bool hiInc, const Ordering& order,
+                                     long long cap = 0) const {
+            if ( thisLoc.isNull() )
+                return 0;
+            KeyOwned l(lo), h(hi);
+            return countRangeRec( thisLoc, &l, loInc, &h, hiInc, order, cap );
+        }
+
         // for geo:
         virtual bool isUsed(DiskLoc thisLoc, int pos) { return thisLoc.btree<V>()->isUsed(pos); }
         virtual void keyAt(DiskLoc thisLoc, int pos, BSONObj& key, DiskLoc& recordLoc) {
@@ -91,10 +201,17 @@ namespace mongo {
     }
 
     template <>
-    int IndexInterfaceImpl< V1 >::keyCompare(const BSONObj& l, const BSONObj& r, const Ordering &ordering) { 
+    int IndexInterfaceImpl< V1 >::keyCompare(const BSONObj& l, const BSONObj& r, const Ordering &ordering) {
         return l.woCompare(r, ordering, /*considerfieldname*/false);
     }
 
+    // v0's legacy ordering (oldCompare) is not what KeyV1::woCompare produces
+    template <>
+    bool IndexInterfaceImpl< V0 >::compactSortKeys() const { return false; }
+
+    template <>
+    bool IndexInterfaceImpl< V1 >::compactSortKeys() const { return true; }
+
     IndexInterfaceImpl<V0> iii_v0;
     IndexInterfaceImpl<V1> iii_v1;
 
@@ -172,6 +289,8 @@ namespace mongo {
             int n = removeFromSysIndexes(pns.c_str(), name.c_str());
             wassert( n == 1 );
 
+            IndexUsage::global.forget( ns );
+
         }
         catch ( DBException &e ) {
             log() << "exception in kill_idx: " << e << ", ns: " << ns << endl;
@@ -227,6 +346,64 @@ namespace mongo {
         }
     }
 
+    void IndexUpdateBatch::noteRemoved( NamespaceDetails *d, int idxNo, const BSONObj& key, const DiskLoc& loc ) {
+        Entry e;
+        e.key = key.getOwned(); // the caller's key buffers don't outlive its update
+        e.loc = loc;
+        _changes[idxNo].removed.push_back( e );
+        if ( ++_n >= MaxPending )
+            flush( d );
+    }
+
+    void IndexUpdateBatch::noteAdded( NamespaceDetails *d, int idxNo, const BSONObj& key, const DiskLoc& loc ) {
+        Entry e;
+        e.key = key.getOwned();
+        e.loc = loc;
+        _changes[idxNo].added.push_back( e );
+        if ( ++_n >= MaxPending )
+            flush( d );
+    }
+
+    void IndexUpdateBatch::flush( NamespaceDetails *d ) {
+        if ( _n == 0 )
+            return;
+        for( map<int,Changes>::iterator it = _changes.begin(); it != _changes.end(); ++it ) {
+            assert( it->first < d->nIndexesBeingBuilt() );
+            IndexDetails& idx = d->idx(it->first);
+            IndexInterface& ii = idx.idxInterface();
+            BSONObj idxKey = idx.info.obj().getObjectField("key");
+            Ordering ordering = Ordering::make(idxKey);
+            Changes& ch = it->second;
+            sort( ch.removed.begin(), ch.removed.end(), EntryCmp(idxKey) );
+            for( unsigned i = 0; i < ch.removed.size(); i++ ) {
+                Entry& e = ch.removed[i];
+                try {
+                    bool found = ii.unindex( idx.head, idx, e.key, e.loc );
+                    if ( ! found ) {
+                        RARELY warning() << "couldn't unindex key: " << e.key
+                                         << " " << idx.indexNamespace() << endl;
+                    }
+                }
+                catch ( AssertionException& ) {
+                    problem() << " caught assertion batched update unindex " << idx.indexNamespace() << endl;
+                }
+            }
+            sort( ch.added.begin(), ch.added.end(), EntryCmp(idxKey) );
+            for( unsigned i = 0; i < ch.added.size(); i++ ) {
+                Entry& e = ch.added[i];
+                try {
+                    /* the updater did its dup check when it collected the key */
+                    ii.bt_insert( idx.head, e.loc, e.key, ordering, /*dupsAllowed*/true, idx );
+                }
+                catch ( AssertionException& ex ) {
+                    problem() << " caught assertion batched update index " << idx.indexNamespace() << " " << ex << endl;
+                }
+            }
+        }
+        _changes.clear();
+        _n = 0;
+    }
+
     // should be { <something> : <simpletype[1|-1]>, .keyp.. }
     static bool validKeyPattern(BSONObj kp) {
         BSONObjIterator i(kp);
@@ -390,4 +567,46 @@ namespace mongo {
         _init();
     }
 
+    BgIndexBuildControl bgIndexBuildControl;
+
+    void BgIndexBuildControl::start( const string& ns, unsigned long long total ) {
+        scoped_lock lk( _mutex );
+        Build& b = _builds[ns];
+        b.total = total;
+        b.done = 0;
+        b.lastLoc = DiskLoc();
+    }
+
+    void BgIndexBuildControl::progress( const string& ns, unsigned long long done, const DiskLoc& lastLoc ) {
+        scoped_lock lk( _mutex );
+        map<string,Build>::iterator i = _builds.find( ns );
+        if ( i == _builds.end() )
+            return;
+        i->second.done = done;
+        i->second.lastLoc = lastLoc;
+    }
+
+    void BgIndexBuildControl::finish( const string& ns ) {
+        scoped_lock lk( _mutex );
+        _builds.erase( ns );
+    }
+
+    void BgIndexBuildControl::appendInfo( BSONObjBuilder& b ) const {
+        b.append( "maxDocsPerSec" , _maxDocsPerSec );
+        b.appendBool( "paused" , _paused );
+        BSONArrayBuilder arr( b.subarrayStart( "inprog" ) );
+        {
+            scoped_lock lk( _mutex );
+            for ( map<string,Build>::const_iterator i = _builds.begin(); i != _builds.end(); ++i ) {
+                BSONObjBuilder bb( arr.subobjStart() );
+                bb.append( "ns" , i->first );
+                bb.appendNumber( "done" , (long long)i->second.done );
+                bb.appendNumber( "total" , (long long)i->second.total );
+                bb.append( "lastLoc" , i->second.lastLoc.toString() );
+                bb.done();
+            }
+        }
+        arr.done();
+    }
+
 }
@@ -31,6 +31,11 @@ namespace mongo {
         virtual ~IndexInterface() { }
     public:
         virtual int keyCompare(const BSONObj& l,const BSONObj& r, const Ordering &ordering) = 0;
+
+        /** @return true if this index version orders keys exactly as
+            KeyV1::woCompare does, so sort pipelines feeding the index may hold
+            keys in the dense KeyV1 encoding rather than as bson. */
+        virtual bool compactSortKeys() const = 0;
         virtual long long fullValidate(const DiskLoc& thisLoc, const BSONObj &order) = 0;
         virtual DiskLoc findSingle(const IndexDetails &indexdetails , const DiskLoc& thisLoc, const BSONObj& key) const = 0;
         virtual bool unindex(const DiskLoc thisLoc, IndexDetails& id, const BSONObj& key, const DiskLoc recordLoc) const = 0;
@@ -38,9 +43,25 @@ namespace mongo {
             const BSONObj& key, const Ordering &order, bool dupsAllowed,
             IndexDetails& idx, bool toplevel = true) const = 0;
         virtual DiskLoc addBucket(const IndexDetails&) = 0;
-        virtual void uassertIfDups(IndexDetails& idx, vector<BSONObj*>& addedKeys, DiskLoc head, 
+        virtual void uassertIfDups(IndexDetails& idx, vector<BSONObj*>& addedKeys, DiskLoc head,
             DiskLoc self, const Ordering& ordering) = 0;
 
+        /** cheap estimate of the number of keys in the btree - samples one bucket
+            per level rather than traversing.  @param thisLoc the btree head */
+        virtual long long keyCountEstimate(const DiskLoc& thisLoc) const = 0;
+
+        /** exact count of the used keys in [lo,hi] (inclusivity per the flags)
+            by walking buckets: subtrees strictly inside the range are tallied
+            from their headers without key comparisons; compares happen only
+            along the two boundary descent paths.  bounds are index-key-shaped
+            objects in the tree's own ordering.  @param thisLoc the btree head
+            @param cap if nonzero, stop counting once the tally reaches cap -
+            the return value is then >= cap but not the full count.  bounds the
+            cost of asking "is this range bigger than n?" on a huge range. */
+        virtual long long countRange(const DiskLoc& thisLoc, const BSONObj& lo, bool loInc,
+                                     const BSONObj& hi, bool hiInc, const Ordering& order,
+                                     long long cap = 0) const = 0;
+
         // these are for geo
         virtual bool isUsed(DiskLoc thisLoc, int pos) = 0;
         virtual void keyAt(DiskLoc thisLoc, int pos, BSONObj&, DiskLoc& recordLoc) = 0;
@@ -227,4 +248,90 @@ namespace mongo {
     // changedId should be initialized to false
     void getIndexChanges(vector<IndexChanges>& v, NamespaceDetails& d, BSONObj newObj, BSONObj oldObj, bool &cangedId);
     void dupCheck(vector<IndexChanges>& v, NamespaceDetails& d, DiskLoc curObjLoc);
+
+    /** collects index key changes across a batch of in-place multi-update
+        modifications so they can be applied index-by-index in key order,
+        instead of re-entering every index once per document.  only changes for
+        non-unique indexes may be deferred here: unique indexes need their dup
+        checks run against an up to date tree, so the updater keeps maintaining
+        those immediately.
+
+        all batched work must stay within one write lock window - entries
+        reference indexes by number and hold raw DiskLocs, so flush() must be
+        called before any yield.  the caller is responsible for noting/checking
+        its cursor position around flush() the same way it would around any
+        other index write.
+    */
+    class IndexUpdateBatch : boost::noncopyable {
+    public:
+        IndexUpdateBatch() : _n(0) {}
+        void noteRemoved( NamespaceDetails *d, int idxNo, const BSONObj& key, const DiskLoc& loc );
+        void noteAdded( NamespaceDetails *d, int idxNo, const BSONObj& key, const DiskLoc& loc );
+        bool pending() const { return _n > 0; }
+        /** apply everything collected, one index at a time, keys in order */
+        void flush( NamespaceDetails *d );
+    private:
+        enum { MaxPending = 8192 }; // auto-flush bound, as $atomic updates never yield
+        struct Entry {
+            BSONObj key;
+            DiskLoc loc;
+        };
+        /** btree order, DiskLoc breaking ties */
+        class EntryCmp {
+        public:
+            EntryCmp( const BSONObj& keyPattern ) : _keyPattern( keyPattern ) {}
+            bool operator()( const Entry& l, const Entry& r ) const {
+                int x = l.key.woCompare( r.key, _keyPattern );
+                if ( x )
+                    return x < 0;
+                return l.loc.compare( r.loc ) < 0;
+            }
+        private:
+            const BSONObj& _keyPattern;
+        };
+        struct Changes {
+            vector<Entry> removed;
+            vector<Entry> added;
+        };
+        map<int,Changes> _changes; // by index #
+        int _n;
+    };
+
+    /** runtime control of background index builds: a docs-per-second throttle
+        and a pause flag, adjustable while builds run via the indexBuildControl
+        admin command.  the build loop also reports progress (docs done, last
+        indexed DiskLoc) here so an operator can watch a throttled or paused
+        build through the same command.
+
+        the settings are plain volatile flags read lock-free from the build
+        loop; only the progress map takes the mutex.
+    */
+    class BgIndexBuildControl : boost::noncopyable {
+    public:
+        BgIndexBuildControl() : _mutex( "BgIndexBuildControl" ), _maxDocsPerSec( 0 ), _paused( false ) {}
+
+        void setMaxDocsPerSec( int n ) { _maxDocsPerSec = n; }
+        void setPaused( bool b ) { _paused = b; }
+        int maxDocsPerSec() const { return _maxDocsPerSec; }
+        bool paused() const { return _paused; }
+
+        // called by BackgroundIndexBuildJob, keyed by collection ns
+        void start( const string& ns, unsigned long long total );
+        void progress( const string& ns, unsigned long long done, const DiskLoc& lastLoc );
+        void finish( const string& ns );
+
+        void appendInfo( BSONObjBuilder& b ) const;
+
+    private:
+        struct Build {
+            unsigned long long total;
+            unsigned long long done;
+            DiskLoc lastLoc;
+        };
+        mutable mongo::mutex _mutex;
+        map<string,Build> _builds;
+        volatile int _maxDocsPerSec; // 0 = unlimited
+        volatile bool _paused;
+    };
+    extern BgIndexBuildControl bgIndexBuildControl;
 } // namespace mongo
@@ -35,11 +35,13 @@
 #include <sys/file.h>
 #endif
 #include "stats/counters.h"
+#include "stats/opsampler.h"
 #include "background.h"
 #include "dur_journal.h"
 #include "dur_recover.h"
 #include "ops/update.h"
 #include "ops/delete.h"
+#include "ops/insertqueue.h"
 #include "ops/query.h"
 
 namespace mongo {
@@ -79,6 +81,9 @@ namespace mongo {
 
     // see FSyncCommand:
     extern bool lockedForWriting;
+    // see ShutdownPrepareCommand:
+    extern bool refusingWrites;
+    extern bool replSetBlind;
 
     void inProgCmd( Message &m, DbResponse &dbresponse ) {
         BSONObjBuilder b;
@@ -234,6 +239,22 @@ namespace mongo {
 
         // before we lock...
         int op = m.operation();
+
+        /* lightweight replica set liveness ping: tiny fixed payload, no
+           command parse, no auth, no CurOp - answered before any dispatch
+           work.  full heartbeat state goes over replSetHeartbeat; this just
+           says "the process is responsive".  see repl/heartbeat.cpp. */
+        if ( op == dbMsg && strcmp( m.singleData()->_data , "rsping" ) == 0 ) {
+            Message *resp = new Message();
+            if ( replSetBlind )
+                resp->setData( opReply , "rsblind" ); // test hook: simulate partition
+            else
+                resp->setData( opReply , "rspong" );
+            dbresponse.response = resp;
+            dbresponse.responseTo = m.header()->id;
+            return;
+        }
+
         bool isCommand = false;
         const char *ns = m.singleData()->_data + 4;
         if ( op == dbQuery ) {
@@ -282,6 +303,16 @@ namespace mongo {
         OpDebug& debug = currentOp.debug();
         debug.op = op;
 
+        {
+            // a tracing-aware driver or mongos carries a trace id in the
+            // otherwise unused responseTo field of the request.  note it for
+            // the profiler / slow query log and put it on the thread so any
+            // outbound calls made servicing this op carry it too.
+            int rt = m.header()->responseTo;
+            debug.traceId = ( rt != -1 && rt != 0 ) ? (unsigned) rt : 0;
+            setCurrentTraceId( debug.traceId );
+        }
+
         int logThreshold = cmdLine.slowMS;
         bool log = logLevel >= 1;
 
@@ -320,6 +351,12 @@ namespace mongo {
             }
             else {
                 try {
+                    if ( refusingWrites && ( op == dbInsert || op == dbUpdate || op == dbDelete ) ) {
+                        // shutdownPrepare is draining this node ahead of a
+                        // restart.  reads still work; the error reaches the
+                        // client via getLastError so it can fail over.
+                        uasserted( 15998 , "not accepting writes: shutdownPrepare in progress" );
+                    }
                     if ( op == dbInsert ) {
                         receivedInsert(m, currentOp);
                     }
@@ -355,6 +392,13 @@ namespace mongo {
         currentOp.done();
         int ms = currentOp.totalTimeMillis();
 
+        if ( OpSampler::global.tick() ) {
+            OpSampler::global.record( currentOp.getNS() , op ,
+                                      currentOp.haveQuery() ? currentOp.query() : BSONObj() ,
+                                      (long long) currentOp.totalTimeMicros() ,
+                                      debug.nscanned , debug.nreturned );
+        }
+
         //DEV log = true;
         if ( log || ms > logThreshold ) {
             if( logLevel < 3 && op == dbGetMore && strstr(ns, ".oplog.") && ms < 4300 && !log ) {
@@ -433,6 +477,14 @@ namespace mongo {
 
         NamespaceDetailsTransient::clearForPrefix( prefix.c_str() );
 
+        {
+            // the warmer may hold a mapping of this db's next datafile; the
+            // files may be about to be deleted (dropDatabase)
+            string filePrefix = database->fileName( 0 ).string();
+            filePrefix.erase( filePrefix.size() - 1 ); // strip the "0" - matches all this db's datafiles
+            DataFileWarmer::get()->discard( filePrefix );
+        }
+
         dbHolder.erase( db, path );
         ctx->clear();
         delete database; // closes files
@@ -520,8 +572,12 @@ namespace mongo {
         int pass = 0;
         bool exhaust = false;
         QueryResult* msgdata;
+        NamespaceNotifier::When nversion = 0;
         while( 1 ) {
             try {
+                // captured before the scan, so a write that lands during it is
+                // not missed by the wait below
+                nversion = NamespaceNotifier::now(ns);
                 readlock lk;
                 Client::Context ctx(ns);
                 msgdata = processGetMore(ns, ntoreturn, cursorid, curop, pass, exhaust);
@@ -547,10 +603,10 @@ namespace mongo {
                     }
                 }
                 pass++;
-                DEV
-                sleepmillis(20);
-                else
-                    sleepmillis(2);
+                // block until the namespace gets new data rather than polling.
+                // the timeout bounds a missed wakeup (first pass races channel
+                // creation) and keeps the 4 second overall cap above working.
+                NamespaceNotifier::waitBeyond( ns , nversion , 150 );
                 continue;
             }
             break;
@@ -572,7 +628,10 @@ namespace mongo {
         return ok;
     }
 
-    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) { 
+    /* cheap per-document checks.  needs no lock, so the async staging path
+       runs it on the connection thread where a failure still reaches the
+       client as an error. */
+    void checkForInsert(const BSONObj& js) {
         uassert( 10059 , "object to insert too large", js.objsize() <= BSONObjMaxUserSize);
         {
             // check no $ modifiers.  note we only check top level.  (scanning deep would be quite expensive)
@@ -582,21 +641,54 @@ namespace mongo {
                 uassert( 13511 , "document to insert can't have $ fields" , e.fieldName()[0] != '$' );
             }
         }
+    }
+
+    /* checkAndInsert without the oplog entry -- insertMulti batches those up */
+    static void _checkAndInsert(const char *ns, /*modifies*/BSONObj& js) {
+        checkForInsert(js);
         theDataFileMgr.insertWithObjMod(ns, js, false); // js may be modified in the call to add an _id field.
+    }
+
+    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js) {
+        _checkAndInsert(ns, js);
         logOp("i", ns, js);
     }
 
-    NOINLINE_DECL void insertMulti(DbMessage& d, const char *ns, const BSONObj& _js) { 
+    /** can this insert go through the async staging queue?  sharded
+        namespaces need their shard version checked against the message under
+        the lock, and system collections (index builds etc.) should stay
+        synchronous, so both take the normal path. */
+    static bool canStageInsert(const char *ns) {
+        if ( ! cmdLine.asyncInserts )
+            return false;
+        if ( shardingState.enabled() )
+            return false;
+        if ( strstr(ns, ".system.") )
+            return false;
+        return true;
+    }
+
+    NOINLINE_DECL void insertMulti(DbMessage& d, const char *ns, const BSONObj& _js) {
         const bool keepGoing = d.reservedField() & InsertOption_ContinueOnError;
         int n = 0;
         BSONObj js(_js);
+        // oplog entries for the batch are written in bulk, but always before a
+        // journal commit point so a document and its oplog entry can't be split
+        // across a crash
+        vector<BSONObj> toLog;
         while( 1 ) {
             try {
-                checkAndInsert(ns, js);
+                _checkAndInsert(ns, js);
+                toLog.push_back(js);
                 ++n;
-                getDur().commitIfNeeded();
+                if( getDur().aCommitIsNeeded() ) {
+                    logInsertOps(ns, toLog);
+                    toLog.clear();
+                    getDur().commitIfNeeded();
+                }
             } catch (const UserException&) {
                 if (!keepGoing || !d.moreJSObjs()){
+                    logInsertOps(ns, toLog); // docs already inserted must be logged
                     globalOpCounters.incInsertInWriteLock(n);
                     throw;
                 }
@@ -606,6 +698,7 @@ namespace mongo {
                 break;
             js = d.nextJsObj(); // TODO: refactor to do objcheck outside of writelock
         }
+        logInsertOps(ns, toLog);
     }
 
     void receivedInsert(Message& m, CurOp& op) {
@@ -617,6 +710,38 @@ namespace mongo {
             // strange.  should we complain?
             return;
         }
+
+        {
+            // structurally check every document before the write lock is taken
+            // so a corrupt buffer is rejected for the price of a scan, not for
+            // write lock hold time.  iterate a scratch DbMessage so the real
+            // one stays positioned at the first document.
+            DbMessage checker(m);
+            while ( checker.moreJSObjs() ) {
+                BSONObj o = checker.nextJsObj();
+                uassert( 15928 , "insert message contains invalid bson" , o.structurallyValid() );
+            }
+        }
+
+        if( canStageInsert(ns) ) {
+            // --asyncInserts: stage the documents and return without taking
+            // the write lock.  the background writer applies them in batches;
+            // getLastError drains the queue first so acknowledged clients
+            // still read their own writes.
+            // best effort lockless check; the writer rechecks under the write
+            // lock and discards anything staged across a stepdown
+            uassert( 15951 , "not master", isMasterNs(ns) );
+            while( 1 ) {
+                BSONObj js = d.nextJsObj();
+                checkForInsert(js);
+                InsertQueue::global.push(ns, js);
+                globalOpCounters.gotInsert();
+                if( !d.moreJSObjs() )
+                    break;
+            }
+            return;
+        }
+
         BSONObj js = d.nextJsObj();
 
         writelock lk(ns);
@@ -823,6 +948,12 @@ namespace mongo {
 
     void exitCleanly( ExitCode code ) {
         killCurrentOp.killAll();
+        if( cmdLine.asyncInserts ) {
+            // flush staged inserts while the writer can still take the write
+            // lock -- once we hold dblock below it no longer can
+            log() << "shutdown: draining insert queue..." << endl;
+            InsertQueue::global.waitUntilDrained();
+        }
         {
             dblock lk;
             log() << "now exiting" << endl;
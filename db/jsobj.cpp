@@ -60,7 +60,9 @@ namespace mongo {
         if ( t == Undefined )
             return "undefined";
 
-        stringstream s;
+        // StringBuilder rather than stringstream - constructing a stream (and
+        // its locale) per element dominated profiles of large json exports
+        StringBuilder s;
         if ( includeFieldNames )
             s << '"' << escape( fieldName() ) << "\" : ";
         switch ( type() ) {
@@ -75,8 +77,11 @@ namespace mongo {
         case NumberDouble:
             if ( number() >= -numeric_limits< double >::max() &&
                     number() <= numeric_limits< double >::max() ) {
-                s.precision( 16 );
-                s << number();
+                // same digits a stringstream with precision(16) would print
+                char buf[32];
+                int len = sprintf( buf , "%.16g" , number() );
+                assert( len > 0 );
+                s.write( buf , len );
             }
             else {
                 StringBuilder ss;
@@ -163,12 +168,10 @@ namespace mongo {
             BinDataType type = BinDataType( *(char *)( (int *)( value() ) + 1 ) );
             s << "{ \"$binary\" : \"";
             char *start = ( char * )( value() ) + sizeof( int ) + 1;
-            base64::encode( s , start , len );
-            s << "\", \"$type\" : \"" << hex;
-            s.width( 2 );
-            s.fill( '0' );
-            s << type << dec;
-            s << "\" }";
+            s << base64::encode( start , len );
+            char typebuf[8];
+            sprintf( typebuf , "%02x" , (int) type );
+            s << "\", \"$type\" : \"" << typebuf << "\" }";
             break;
         }
         case mongo::Date:
@@ -431,6 +434,141 @@ namespace mongo {
         return false;
     }
 
+    /* one linear walk over the buffer with an explicit stack of object
+       boundaries instead of recursion.  cstring scans go through memchr, which
+       the c library implements word-at-a-time / vectorized, so the common case
+       (lots of small fields) moves through the buffer several bytes per cycle.
+    */
+    bool BSONObj::structurallyValid() const {
+        static const int MaxDepth = 100;
+
+        const char * const start = objdata();
+        const int len = objsize();
+        if ( len < 5 )
+            return false;
+
+        const char * ends[MaxDepth]; // one past the last byte of each open object
+        int depth = 0;
+        ends[0] = start + len;
+        if ( ends[0][-1] != EOO )
+            return false;
+
+        const char * p = start + 4;
+        while ( true ) {
+            const char * end = ends[depth];
+            if ( p >= end )
+                return false; // ran off the object without seeing its EOO
+            int type = (signed char) *p++;
+
+            if ( type == EOO ) {
+                if ( p != end )
+                    return false; // EOO not at the declared end
+                if ( depth == 0 )
+                    return true;
+                depth--;
+                continue;
+            }
+
+            // field name
+            const char * q = (const char *) memchr( p , 0 , end - p );
+            if ( q == 0 )
+                return false;
+            p = q + 1;
+
+            switch ( type ) {
+            case NumberDouble:
+            case Date:
+            case Timestamp:
+            case NumberLong:
+                if ( end - p < 8 ) return false;
+                p += 8;
+                break;
+            case NumberInt:
+                if ( end - p < 4 ) return false;
+                p += 4;
+                break;
+            case Bool:
+                if ( end - p < 1 ) return false;
+                p += 1;
+                break;
+            case jstOID:
+                if ( end - p < 12 ) return false;
+                p += 12;
+                break;
+            case Undefined:
+            case jstNULL:
+            case MaxKey:
+            case MinKey:
+                break;
+            case String:
+            case Code:
+            case Symbol: {
+                if ( end - p < 4 ) return false;
+                int sz = *reinterpret_cast<const int*>( p );
+                if ( sz < 1 || sz > end - p - 4 ) return false;
+                if ( p[ 4 + sz - 1 ] != 0 ) return false;
+                p += 4 + sz;
+                break;
+            }
+            case DBRef: {
+                if ( end - p < 4 ) return false;
+                int sz = *reinterpret_cast<const int*>( p );
+                if ( sz < 1 || sz > end - p - 4 - 12 ) return false;
+                if ( p[ 4 + sz - 1 ] != 0 ) return false;
+                p += 4 + sz + 12;
+                break;
+            }
+            case BinData: {
+                if ( end - p < 5 ) return false;
+                int sz = *reinterpret_cast<const int*>( p );
+                if ( sz < 0 || sz > end - p - 5 ) return false;
+                p += 5 + sz;
+                break;
+            }
+            case RegEx: {
+                q = (const char *) memchr( p , 0 , end - p );
+                if ( q == 0 ) return false;
+                p = q + 1;
+                q = (const char *) memchr( p , 0 , end - p );
+                if ( q == 0 ) return false;
+                p = q + 1;
+                break;
+            }
+            case Object:
+            case Array: {
+                if ( end - p < 4 ) return false;
+                int sz = *reinterpret_cast<const int*>( p );
+                if ( sz < 5 || sz > end - p ) return false;
+                if ( ++depth >= MaxDepth ) return false;
+                ends[depth] = p + sz;
+                if ( ends[depth][-1] != EOO ) return false;
+                p += 4;
+                break;
+            }
+            case CodeWScope: {
+                if ( end - p < 4 + 4 + 1 + 5 ) return false;
+                int total = *reinterpret_cast<const int*>( p );
+                if ( total < 4 + 4 + 1 + 5 || total > end - p ) return false;
+                const char * cwEnd = p + total;
+                p += 4;
+                int sz = *reinterpret_cast<const int*>( p );
+                if ( sz < 1 || sz > cwEnd - p - 4 - 5 ) return false;
+                if ( p[ 4 + sz - 1 ] != 0 ) return false;
+                p += 4 + sz;
+                // the rest of the region must be exactly the scope object
+                if ( *reinterpret_cast<const int*>( p ) != cwEnd - p ) return false;
+                if ( ++depth >= MaxDepth ) return false;
+                ends[depth] = cwEnd;
+                if ( cwEnd[-1] != EOO ) return false;
+                p += 4;
+                break;
+            }
+            default:
+                return false; // unknown type byte
+            }
+        }
+    }
+
     int BSONObj::woCompare(const BSONObj& r, const Ordering &o, bool considerFieldName) const {
         if ( isEmpty() )
             return r.isEmpty() ? 0 : -1;
@@ -1194,6 +1332,45 @@ namespace mongo {
         _cur = 0;
     }
 
+    /* strcmp order, unlike BSONElementFieldSorter, so getField can binary search
+       with plain strcmp */
+    int BSONFieldIndexSorter( const void * a , const void * b ) {
+        const char * x = *((const char**)a);
+        const char * y = *((const char**)b);
+        x++; y++;
+        return strcmp( x , y );
+    }
+
+    BSONFieldIndex::BSONFieldIndex( const BSONObj& o ) {
+        _objdata = o.objdata();
+        _nfields = o.nFields();
+        _fields = new const char*[_nfields];
+        int x = 0;
+        BSONObjIterator i( o );
+        while ( i.more() ) {
+            _fields[x++] = i.next().rawdata();
+            assert( _fields[x-1] );
+        }
+        assert( x == _nfields );
+        qsort( _fields , _nfields , sizeof(char*) , BSONFieldIndexSorter );
+    }
+
+    BSONElement BSONFieldIndex::getField( const char *name ) const {
+        int lo = 0;
+        int hi = _nfields - 1;
+        while ( lo <= hi ) {
+            int mid = ( lo + hi ) / 2;
+            int cmp = strcmp( name , _fields[mid] + 1 );
+            if ( cmp == 0 )
+                return BSONElement( _fields[mid] );
+            if ( cmp < 0 )
+                hi = mid - 1;
+            else
+                lo = mid + 1;
+        }
+        return BSONElement();
+    }
+
     bool BSONObjBuilder::appendAsNumber( const StringData& fieldName , const string& data ) {
         if ( data.size() == 0 || data == "-" || data == ".")
             return false;
@@ -596,4 +596,258 @@ namespace mongo {
         return fromjson( str.c_str() );
     }
 
+    /* Hand-written parser for strict JSON: double quoted names and strings,
+       {} [] numbers true false null.  Tools like mongoimport are normally cpu
+       bound in the spirit grammar above; parsing straight into BSONObjBuilder
+       is several times faster on well formed feeds.  Anything outside the
+       strict subset -- single quotes, unquoted names, $-special objects,
+       ObjectId(...) style constructors -- makes us return false so the caller
+       can retry with the full grammar, which stays the single authority on
+       what is accepted and on error reporting.
+    */
+    class FastJsonParser : boost::noncopyable {
+    public:
+        FastJsonParser( const char *s ) : _p( s ) {}
+
+        bool parse( BSONObjBuilder& b ) {
+            skipWs();
+            if ( *_p != '{' )
+                return false;
+            _p++;
+            return parseMembers( b );
+        }
+
+        /** one past the last character consumed */
+        const char * pos() {
+            skipWs();
+            return _p;
+        }
+
+    private:
+        /* the opening brace was already consumed */
+        bool parseMembers( BSONObjBuilder& b ) {
+            skipWs();
+            if ( *_p == '}' ) {
+                _p++;
+                return true;
+            }
+            while ( 1 ) {
+                skipWs();
+                string field;
+                if ( *_p != '"' || ! parseString( field ) )
+                    return false;
+                if ( field.size() && field[0] == '$' )
+                    return false; // reserved and special names -- full grammar decides
+                skipWs();
+                if ( *_p != ':' )
+                    return false;
+                _p++;
+                if ( ! parseValue( b , field.c_str() ) )
+                    return false;
+                skipWs();
+                if ( *_p == ',' ) {
+                    _p++;
+                    continue;
+                }
+                if ( *_p == '}' ) {
+                    _p++;
+                    return true;
+                }
+                return false;
+            }
+        }
+
+        bool parseValue( BSONObjBuilder& b , const char *fieldName ) {
+            skipWs();
+            switch( *_p ) {
+            case '{' : {
+                _p++;
+                BSONObjBuilder sub( b.subobjStart( fieldName ) );
+                if ( ! parseMembers( sub ) )
+                    return false;
+                sub.done();
+                return true;
+            }
+            case '[' : {
+                _p++;
+                BSONObjBuilder sub( b.subarrayStart( fieldName ) );
+                skipWs();
+                if ( *_p == ']' ) {
+                    _p++;
+                    sub.done();
+                    return true;
+                }
+                int n = 0;
+                while ( 1 ) {
+                    if ( ! parseValue( sub , BSONObjBuilder::numStr( n++ ).c_str() ) )
+                        return false;
+                    skipWs();
+                    if ( *_p == ',' ) {
+                        _p++;
+                        continue;
+                    }
+                    if ( *_p != ']' )
+                        return false;
+                    _p++;
+                    sub.done();
+                    return true;
+                }
+            }
+            case '"' : {
+                string s;
+                if ( ! parseString( s ) )
+                    return false;
+                b.append( fieldName , s );
+                return true;
+            }
+            case 't' :
+                if ( strncmp( _p , "true" , 4 ) != 0 )
+                    return false;
+                _p += 4;
+                b.appendBool( fieldName , true );
+                return true;
+            case 'f' :
+                if ( strncmp( _p , "false" , 5 ) != 0 )
+                    return false;
+                _p += 5;
+                b.appendBool( fieldName , false );
+                return true;
+            case 'n' :
+                if ( strncmp( _p , "null" , 4 ) != 0 )
+                    return false;
+                _p += 4;
+                b.appendNull( fieldName );
+                return true;
+            default:
+                return parseNumber( b , fieldName );
+            }
+        }
+
+        /* parse a double quoted string.  the common no-escape case is one scan
+           and one append rather than a character at a time through the grammar. */
+        bool parseString( string& out ) {
+            _p++; // the '"'
+            out.clear();
+            while ( 1 ) {
+                const char *start = _p;
+                while ( (unsigned char)(*_p) >= 0x20 && *_p != '"' && *_p != '\\' )
+                    _p++;
+                out.append( start , _p - start );
+                if ( *_p == '"' ) {
+                    _p++;
+                    return true;
+                }
+                if ( *_p != '\\' )
+                    return false; // control character or end of input
+                _p++;
+                switch( *_p ) {
+                case '"': out += '"'; break;
+                case '\'': out += '\''; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'v': out += '\v'; break;
+                case 'u': {
+                    _p++;
+                    for( int i = 0; i < 4; i++ ) {
+                        if ( ! isxdigit( (unsigned char)_p[i] ) )
+                            return false;
+                    }
+                    appendUtf8( out );
+                    _p += 3; // to the last hex digit; advanced below like the other cases
+                    break;
+                }
+                default:
+                    return false; // unusual escapes: let the full grammar decide
+                }
+                _p++;
+            }
+        }
+
+        /* same utf8 encoding as chU above; _p is at the first of 4 hex digits */
+        void appendUtf8( string& out ) {
+            unsigned char first = fromHex( _p );
+            unsigned char second = fromHex( _p + 2 );
+            if ( first == 0 && second < 0x80 )
+                out += second;
+            else if ( first < 0x08 ) {
+                out += char( 0xc0 | ( ( first << 2 ) | ( second >> 6 ) ) );
+                out += char( 0x80 | ( ~0xc0 & second ) );
+            }
+            else {
+                out += char( 0xe0 | ( first >> 4 ) );
+                out += char( 0x80 | ( ~0xc0 & ( ( first << 2 ) | ( second >> 6 ) ) ) );
+                out += char( 0x80 | ( ~0xc0 & second ) );
+            }
+        }
+
+        bool parseNumber( BSONObjBuilder& b , const char *fieldName ) {
+            const char *q = _p;
+            bool neg = false;
+            if ( *q == '-' ) {
+                neg = true;
+                q++;
+            }
+            const char *digits = q;
+            while ( *q >= '0' && *q <= '9' )
+                q++;
+            int ndigits = q - digits;
+            if ( ndigits == 0 )
+                return false;
+            if ( *q == '.' || *q == 'e' || *q == 'E' || ndigits > 19 ) {
+                // strtod for consistency with numberValue above
+                char *end;
+                double d = strtod( _p , &end );
+                if ( end == _p )
+                    return false;
+                b.append( fieldName , d );
+                _p = end;
+                return true;
+            }
+            if ( ndigits == 19 )
+                return false; // could overflow a long long; punt to the full grammar
+            long long n = 0;
+            for( const char *z = digits; z < q; z++ )
+                n = n * 10 + ( *z - '0' );
+            if ( neg )
+                n = -n;
+            if ( n >= numeric_limits<int>::min() && n <= numeric_limits<int>::max() )
+                b.append( fieldName , (int)n );
+            else
+                b.append( fieldName , n );
+            _p = q;
+            return true;
+        }
+
+        void skipWs() {
+            while ( *_p == ' ' || *_p == '\t' || *_p == '\n' || *_p == '\r' )
+                _p++;
+        }
+
+        const char *_p;
+    };
+
+    bool fromjsonFast( const char *str , BSONObj& result , int* len ) {
+        if ( str[0] == '\0' ) {
+            if (len) *len = 0;
+            result = BSONObj();
+            return true;
+        }
+
+        FastJsonParser p( str );
+        BSONObjBuilder b;
+        if ( ! p.parse( b ) )
+            return false;
+        if ( len )
+            *len = p.pos() - str;
+        else if ( *p.pos() != '\0' )
+            return false; // trailing garbage; full grammar reports the error
+        result = b.obj();
+        return true;
+    }
+
 } // namespace mongo
@@ -38,4 +38,14 @@ namespace mongo {
     /** len will be size of JSON object in text chars. */
     BSONObj fromjson(const char *str, int* len=NULL);
 
+    /** Fast parser for strict JSON only (double quoted names and strings; no
+     extended syntax).  Much faster than fromjson() for bulk loads.
+     @param result set to the parsed object on success
+     @param len if not null, set to the size of the JSON object in text chars
+     @return false if the input is not strict JSON that parsed cleanly; the
+       caller should then retry with fromjson(), which accepts the extended
+       syntax and reports parse errors.  Never throws.
+    */
+    bool fromjsonFast(const char *str, BSONObj& result, int* len=NULL);
+
 } // namespace mongo
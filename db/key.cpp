@@ -18,6 +18,7 @@
 
 #include "pch.h"
 #include "key.h"
+#include "../bson/util/wordcmp.h"
 #include "../util/unittest.h"
 
 namespace mongo {
@@ -343,7 +344,16 @@ namespace mongo {
         dassert( (*_keyData & cNOTUSED) == 0 );
     }
 
-    BSONObj KeyV1::toBson() const { 
+    // encode via a transient KeyV1Owned, then keep just the bytes
+    KeyV1Shared::KeyV1Shared(const BSONObj& obj) {
+        KeyV1Owned k(obj);
+        int sz = k.dataSize();
+        _buf.reset( new char[sz] );
+        memcpy( _buf.get(), k.data(), sz );
+        _keyData = (const unsigned char *) _buf.get();
+    }
+
+    BSONObj KeyV1::toBson() const {
         assert( _keyData != 0 );
         if( !isCompactFormat() )
             return bson();
@@ -443,8 +453,8 @@ namespace mongo {
                 int rsz = *r;
                 int common = min(lsz, rsz);
                 l++; r++; // skip the size byte
-                // use memcmp as we (will) allow zeros in UTF8 strings
-                int res = memcmp(l, r, common);
+                // use wordcmp (memcmp order) as we (will) allow zeros in UTF8 strings
+                int res = wordcmp(l, r, common);
                 if( res ) 
                     return res;
                 // longer string is the greater one
@@ -469,7 +479,7 @@ namespace mongo {
                 }
                 // same length, same type
                 l++; r++;
-                int res = memcmp(l, r, llen);
+                int res = wordcmp(l, r, llen);
                 if( res ) 
                     return res;
                 l += llen; r += llen;
@@ -488,7 +498,7 @@ namespace mongo {
             }
         case coid:
             {
-                int res = memcmp(l, r, sizeof(OID));
+                int res = wordcmp(l, r, sizeof(OID));
                 if( res ) 
                     return res;
                 l += 12; r += 12;
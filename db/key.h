@@ -18,9 +18,11 @@
 
 #pragma once
  
+#include <boost/shared_array.hpp>
+
 #include "jsobj.h"
 
-namespace mongo { 
+namespace mongo {
 
     /** Key class for precomputing a small format index key that is denser than a traditional BSONObj. 
 
@@ -95,11 +97,11 @@ namespace mongo {
         int compareHybrid(const KeyV1& right, const Ordering& order) const;
     };
 
-    class KeyV1Owned : public KeyV1 { 
+    class KeyV1Owned : public KeyV1 {
         KeyV1Owned(const KeyV1Owned&); // not copyable -- StackBufBuilder is not copyable and that owns our buffer
         void operator=(const KeyV1Owned&);
     public:
-        /** @obj a BSON object to be translated to KeyV1 format.  If the object isn't 
+        /** @obj a BSON object to be translated to KeyV1 format.  If the object isn't
                  representable in KeyV1 format (which happens, intentionally, at times)
                  it will stay as bson herein.
         */
@@ -109,4 +111,32 @@ namespace mongo {
         void traditional(const BSONObj& obj); // store as traditional bson not as compact format
     };
 
+    /** A KeyV1 holding an exactly sized, shared heap copy of its encoding.
+
+        KeyV1Owned is built for transient use: it is not copyable and its
+        StackBufBuilder reserves several hundred bytes whether needed or not.
+        When many keys must be held at once -- in-memory sort pipelines, say --
+        use this instead.  Copies share the underlying buffer, so it can live
+        in standard containers and costs the encoded bytes once per distinct
+        key.
+    */
+    class KeyV1Shared : public KeyV1 {
+    public:
+        KeyV1Shared() { }
+        /** translate obj to KeyV1 format, with the same fallback to bson
+            storage as KeyV1Owned when obj isn't representable compactly. */
+        explicit KeyV1Shared(const BSONObj& obj);
+        /** wrap an existing encoding without copying; the caller guarantees
+            keyData outlives this object and every copy of it. */
+        explicit KeyV1Shared(const char *keyData) : KeyV1(keyData) { }
+        KeyV1Shared(const KeyV1Shared& rhs) : KeyV1(), _buf(rhs._buf) { _keyData = rhs._keyData; }
+        KeyV1Shared& operator=(const KeyV1Shared& rhs) {
+            _buf = rhs._buf;
+            _keyData = rhs._keyData;
+            return *this;
+        }
+    private:
+        boost::shared_array<char> _buf;
+    };
+
 };
@@ -29,6 +29,18 @@ namespace mongo {
     LastError LastError::noError;
     LastErrorHolder lastError;
 
+#if defined(__GNUC__) && !defined(__APPLE__)
+    /* mirror of _tl's contents.  every write path below keeps the two in
+       sync; _tl stays the owner and runs the destructor on thread exit.
+       (darwin's toolchain has no __thread, so it keeps the boost path.) */
+    static __thread LastError * _tlFast = 0;
+    static inline LastError * tlGet( boost::thread_specific_ptr<LastError>& ) { return _tlFast; }
+    static inline void tlCache( LastError * le ) { _tlFast = le; }
+#else
+    static inline LastError * tlGet( boost::thread_specific_ptr<LastError>& tl ) { return tl.get(); }
+    static inline void tlCache( LastError * ) { }
+#endif
+
     bool isShell = false;
     void raiseError(int code , const char *msg) {
         LastError *le = lastError.get();
@@ -99,26 +111,32 @@ namespace mongo {
     }
 
     LastError * LastErrorHolder::_get( bool create ) {
-        LastError * le = _tl.get();
+        LastError * le = tlGet( _tl );
         if ( ! le && create ) {
             le = new LastError();
             _tl.reset( le );
+            tlCache( le );
         }
         return le;
     }
 
     void LastErrorHolder::release() {
         _tl.release();
+        tlCache( 0 );
     }
 
     /** ok to call more than once. */
     void LastErrorHolder::initThread() {
-        if( ! _tl.get() ) 
-            _tl.reset( new LastError() );
+        if( ! tlGet( _tl ) ) {
+            LastError * le = new LastError();
+            _tl.reset( le );
+            tlCache( le );
+        }
     }
 
     void LastErrorHolder::reset( LastError * le ) {
         _tl.reset( le );
+        tlCache( le );
     }
 
     void prepareErrForNewRequest( Message &m, LastError * err ) {
@@ -120,25 +120,20 @@ namespace mongo {
         /** ok to call more than once. */
         void initThread();
 
-        int getID();
-        
         void release();
 
         /** when db receives a message/request, call this */
         LastError * startRequest( Message& m , LastError * connectionOwned );
 
-        void disconnect( int clientId );
-
         // used to disable lastError reporting while processing a killCursors message
         // disable causes get() to return 0.
         LastError *disableForCommand(); // only call once per command invocation!
     private:
+        // owns the record and destroys it on thread exit.  on gcc the current
+        // pointer is also mirrored in a __thread variable (see lasterror.cpp)
+        // so the several lookups per operation are a single tls-relative load
+        // instead of pthread_getspecific calls.
         boost::thread_specific_ptr<LastError> _tl;
-
-        struct Status {
-            time_t time;
-            LastError *lerr;
-        };
     } lastError;
 
     void raiseError(int code , const char *msg);
@@ -0,0 +1,134 @@
+// @file lockstats.cpp
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+#include "lockstats.h"
+#include "concurrency.h"
+#include "client.h"
+#include "curop.h"
+#include "jsobj.h"
+#include "../util/net/message.h"
+
+namespace mongo {
+
+    LockStats writeLockStats;
+
+    const unsigned long long LockStats::BucketMicros[LockStats::NumBuckets-1] =
+        { 100 , 1000 , 4000 , 16000 , 64000 , 256000 };
+
+    LockStats::LockStats() : _mutex("LockStats") , _count(0) , _totalMicros(0) {
+        for ( int i = 0; i < NumBuckets; i++ )
+            _buckets[i] = 0;
+    }
+
+    void LockStats::recordHold( const char *ns , int op , unsigned long long micros ) {
+        string key = str::stream() << opToString( op ) << ' ' << ( ns ? ns : "" );
+
+        scoped_lock lk( _mutex );
+
+        _count++;
+        _totalMicros += micros;
+
+        int b = 0;
+        while ( b < NumBuckets - 1 && micros >= BucketMicros[b] )
+            b++;
+        _buckets[b]++;
+
+        Holder * h;
+        HolderMap::iterator i = _holders.find( key );
+        if ( i != _holders.end() )
+            h = &i->second;
+        else if ( _holders.size() < MaxTracked )
+            h = &_holders[key];
+        else
+            h = &_other;
+
+        h->count++;
+        h->totalMicros += micros;
+        if ( (long long)micros > h->maxMicros )
+            h->maxMicros = micros;
+    }
+
+    void LockStats::append( BSONObjBuilder& b ) const {
+        scoped_lock lk( _mutex );
+
+        b.appendNumber( "holds" , _count );
+        b.appendNumber( "timeMicros" , _totalMicros );
+
+        {
+            // bin names are exclusive upper bounds in microseconds, as in
+            // the latencyHistograms section
+            BSONObjBuilder hist( b.subobjStart( "holdTimeHistogram" ) );
+            for ( int i = 0; i < NumBuckets; i++ ) {
+                string name = i < NumBuckets - 1 ?
+                              (string)( str::stream() << BucketMicros[i] ) : "rest";
+                hist.appendNumber( name , _buckets[i] );
+            }
+            hist.done();
+        }
+
+        // rank (op,ns) pairs by total held time
+        vector< pair<long long,string> > ranked;
+        for ( HolderMap::const_iterator i = _holders.begin(); i != _holders.end(); ++i )
+            ranked.push_back( make_pair( i->second.totalMicros , i->first ) );
+        sort( ranked.rbegin() , ranked.rend() );
+
+        {
+            BSONArrayBuilder top( b.subarrayStart( "topByTimeMicros" ) );
+            for ( unsigned i = 0; i < ranked.size() && i < 10; i++ ) {
+                const Holder& h = _holders.find( ranked[i].second )->second;
+                BSONObjBuilder e( top.subobjStart() );
+                e.append( "who" , ranked[i].second );
+                e.appendNumber( "count" , h.count );
+                e.appendNumber( "timeMicros" , h.totalMicros );
+                e.appendNumber( "maxMicros" , h.maxMicros );
+                e.done();
+            }
+            top.done();
+        }
+
+        if ( _other.count ) {
+            BSONObjBuilder o( b.subobjStart( "other" ) );
+            o.appendNumber( "count" , _other.count );
+            o.appendNumber( "timeMicros" , _other.totalMicros );
+            o.done();
+        }
+    }
+
+    /** called by MongoMutex::unlock() on the final release of a write lock.
+        attribution comes from the releasing thread's CurOp; nothing here
+        touches dbMutex, which is already free.
+    */
+    void MongoMutex::_recordHold( unsigned long long acquiredAtMicros ) {
+        unsigned long long micros = curTimeMicros64() - acquiredAtMicros;
+
+        const char * ns = "";
+        int op = 0;
+        Client * c = currentClient.get();
+        if ( c ) {
+            CurOp * co = c->curop();
+            if ( co ) {
+                ns = co->getNS();
+                op = co->getOp();
+            }
+        }
+
+        writeLockStats.recordHold( ns , op , micros );
+    }
+
+}
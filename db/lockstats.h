@@ -0,0 +1,74 @@
+// @file lockstats.h
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../util/concurrency/mutex.h"
+
+namespace mongo {
+
+    class BSONObjBuilder;
+
+    /** write lock hold time attributed to namespace and op type.
+
+        MutexInfo gives us the aggregate time the write lock has been held;
+        this table says *what* held it.  MongoMutex reports here once per
+        write lock release, with the op and namespace taken from the holder's
+        CurOp.  output goes in the lockStats section of serverStatus.
+    */
+    class LockStats {
+    public:
+        LockStats();
+
+        /** note a completed write lock hold.  called with dbMutex already
+            released; the table has its own mutex, touched once per hold.
+            @param ns     namespace the holding op was acting on ("" if unknown)
+            @param op     wire op code (dbUpdate, dbInsert, ...) or 0
+            @param micros how long the write lock was held
+        */
+        void recordHold( const char *ns , int op , unsigned long long micros );
+
+        /** hold time histogram plus the top holders by total held time */
+        void append( BSONObjBuilder& b ) const;
+
+    private:
+        struct Holder {
+            Holder() : count(0) , totalMicros(0) , maxMicros(0) {}
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+        };
+        typedef map<string,Holder> HolderMap;
+
+        // distinct (op,ns) pairs tracked before new ones lump into "other"
+        static const unsigned MaxTracked = 256;
+
+        static const int NumBuckets = 7;
+        static const unsigned long long BucketMicros[NumBuckets-1]; // exclusive upper bounds
+
+        mutable mongo::mutex _mutex;
+        HolderMap _holders;
+        Holder _other;
+        long long _buckets[NumBuckets];
+        long long _count;
+        long long _totalMicros;
+    };
+
+    extern LockStats writeLockStats;
+
+}
@@ -96,8 +96,25 @@ namespace mongo {
         _where = 0;
     }
 
+    void FieldPath::compile( const char *fieldName ) {
+        _parts.clear();
+        _suffixes.clear();
+        const char *p = fieldName;
+        while ( 1 ) {
+            _suffixes.push_back( p );
+            const char *q = strchr( p, '.' );
+            if ( !q ) {
+                _parts.push_back( p );
+                break;
+            }
+            _parts.push_back( string( p, q - p ) );
+            p = q + 1;
+        }
+    }
+
     ElementMatcher::ElementMatcher( BSONElement e , int op, bool isNot )
-        : _toMatch( e ) , _compareOp( op ), _isNot( isNot ), _subMatcherOnPrimitives(false) {
+        : _toMatch( e ) , _compareOp( op ), _isNot( isNot ),
+          _path( new FieldPath( e.fieldName() ) ), _subMatcherOnPrimitives(false) {
         if ( op == BSONObj::opMOD ) {
             BSONObj o = e.embeddedObject();
             _mod = o["0"].numberInt();
@@ -125,7 +142,8 @@ namespace mongo {
     }
 
     ElementMatcher::ElementMatcher( BSONElement e , int op , const BSONObj& array, bool isNot )
-        : _toMatch( e ) , _compareOp( op ), _isNot( isNot ), _subMatcherOnPrimitives(false) {
+        : _toMatch( e ) , _compareOp( op ), _isNot( isNot ),
+          _path( new FieldPath( e.fieldName() ) ), _subMatcherOnPrimitives(false) {
 
         _myset.reset( new set<BSONElement,element_lt>() );
 
@@ -345,7 +363,9 @@ namespace mongo {
             }
             
             _where->scope->execSetup( "_mongo.readOnly = true;" , "make read only" );
-            
+            // constant across documents; bind it once here instead of per match
+            _where->scope->setBoolean( "fullObject" , true ); // this is a hack b/c fullObject used to be relevant
+
             return;
         }
         
@@ -556,8 +576,8 @@ namespace mongo {
         return (op & z);
     }
 
-    int Matcher::matchesNe(const char *fieldName, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details ) {
-        int ret = matchesDotted( fieldName, toMatch, obj, BSONObj::Equality, bm , false , details );
+    int Matcher::matchesNe(int level, const BSONElement &toMatch, const BSONObj &obj, const ElementMatcher& bm , MatchDetails * details , const BSONFieldIndex *fieldIndex ) {
+        int ret = matchesDotted( level, toMatch, obj, BSONObj::Equality, bm , false , details , fieldIndex );
         if ( bm._toMatch.type() != jstNULL )
             return ( ret <= 0 ) ? 1 : 0;
         else
@@ -568,6 +588,14 @@ namespace mongo {
         return bm._toMatch.trueValue() ? 1 : -1;
     }
 
+    /* use the prebuilt field table when it indexes the object in hand, otherwise a
+       plain linear scan.  subobjects reached by recursion always take the scan. */
+    static inline BSONElement getFieldMaybeIndexed( const BSONObj &obj, const char *name, const BSONFieldIndex *fieldIndex ) {
+        if ( fieldIndex && fieldIndex->objdata() == obj.objdata() )
+            return fieldIndex->getField( name );
+        return obj.getField( name );
+    }
+
     /* Check if a particular field matches.
 
        fieldName - field to match "a.b" if we are reaching into an embedded object.
@@ -587,7 +615,9 @@ namespace mongo {
         0 missing element
         1 match
     */
-    int Matcher::matchesDotted(const char *fieldName, const BSONElement& toMatch, const BSONObj& obj, int compareOp, const ElementMatcher& em , bool isArr, MatchDetails * details ) {
+    int Matcher::matchesDotted(int level, const BSONElement& toMatch, const BSONObj& obj, int compareOp, const ElementMatcher& em , bool isArr, MatchDetails * details , const BSONFieldIndex *fieldIndex ) {
+        const char *fieldName = em._path->suffix( level );
+        bool lastPart = level + 1 == em._path->size();
         DEBUGMATCHER( "\t matchesDotted : " << fieldName << " hasDetails: " << ( details ? "yes" : "no" ) );
         if ( compareOp == BSONObj::opALL ) {
 
@@ -650,10 +680,10 @@ namespace mongo {
         } // end opALL
 
         if ( compareOp == BSONObj::NE )
-            return matchesNe( fieldName, toMatch, obj, em , details );
+            return matchesNe( level, toMatch, obj, em , details , fieldIndex );
         if ( compareOp == BSONObj::NIN ) {
             for( set<BSONElement,element_lt>::const_iterator i = em._myset->begin(); i != em._myset->end(); ++i ) {
-                int ret = matchesNe( fieldName, *i, obj, em , details );
+                int ret = matchesNe( level, *i, obj, em , details , fieldIndex );
                 if ( ret != 1 )
                     return ret;
             }
@@ -684,18 +714,17 @@ namespace mongo {
         }
         else {
 
-            const char *p = strchr(fieldName, '.');
-            if ( p ) {
-                string left(fieldName, p-fieldName);
-
-                BSONElement se = obj.getField(left.c_str());
+            if ( !lastPart ) {
+                // path components were split at parse time - no strchr or
+                // string allocation here, once per predicate per document
+                BSONElement se = getFieldMaybeIndexed(obj, em._path->part( level ), fieldIndex);
                 if ( se.eoo() )
                     ;
                 else if ( se.type() != Object && se.type() != Array )
                     ;
                 else {
                     BSONObj eo = se.embeddedObject();
-                    return matchesDotted(p+1, toMatch, eo, compareOp, em, se.type() == Array , details );
+                    return matchesDotted(level+1, toMatch, eo, compareOp, em, se.type() == Array , details );
                 }
             }
 
@@ -721,7 +750,7 @@ namespace mongo {
 
                     if ( z.type() == Object ) {
                         BSONObj eo = z.embeddedObject();
-                        int cmp = matchesDotted(fieldName, toMatch, eo, compareOp, em, false, details );
+                        int cmp = matchesDotted(level, toMatch, eo, compareOp, em, false, details );
                         if ( cmp > 0 ) {
                             if ( details )
                                 details->_elemMatchKey = z.fieldName();
@@ -735,12 +764,12 @@ namespace mongo {
                 return found ? -1 : 0;
             }
 
-            if( p ) {
+            if( !lastPart ) {
                 // Left portion of field name was not found or wrong type.
                 return 0;
             }
             else {
-                e = obj.getField(fieldName);
+                e = getFieldMaybeIndexed(obj, fieldName, fieldIndex);
             }
         }
 
@@ -809,12 +838,21 @@ namespace mongo {
         /* assuming there is usually only one thing to match.  if more this
         could be slow sometimes. */
 
+        /* with several predicates against a wide document, each matchesDotted call
+           rescans the object top to bottom - quadratic.  index the top level fields
+           once up front instead.  the size gate keeps the common small document case
+           on the cheap path. */
+        scoped_ptr<BSONFieldIndex> fieldIndex;
+        if ( _basics.size() > 1 && _constrainIndexKey.isEmpty() && jsobj.objsize() > 1024 ) {
+            fieldIndex.reset( new BSONFieldIndex( jsobj ) );
+        }
+
         // check normal non-regex cases:
         for ( unsigned i = 0; i < _basics.size(); i++ ) {
             ElementMatcher& bm = _basics[i];
             BSONElement& m = bm._toMatch;
             // -1=mismatch. 0=missing element. 1=match
-            int cmp = matchesDotted(m.fieldName(), m, jsobj, bm._compareOp, bm , false , details );
+            int cmp = matchesDotted(0, m, jsobj, bm._compareOp, bm , false , details , fieldIndex.get() );
             if ( cmp == 0 && bm._compareOp == BSONObj::opEXISTS ) {
                 // If missing, match cmp is opposite of $exists spec.
                 cmp = -retExistsFound(bm);
@@ -924,9 +962,12 @@ namespace mongo {
                 _where->scope->init( _where->jsScope );
             }
             _where->scope->setObject( "obj", const_cast< BSONObj & >( jsobj ) );
-            _where->scope->setBoolean( "fullObject" , true ); // this is a hack b/c fullObject used to be relevant
 
-            int err = _where->scope->invoke( _where->func , 0, &jsobj , 1000 * 60 , false );
+            /* read-only recv: the engines bind 'this' as a read-only lazy
+               object, skipping the modification tracking a writable binding
+               pays for on every property touch.  $where runs with
+               _mongo.readOnly anyway. */
+            int err = _where->scope->invoke( _where->func , 0, &jsobj , 1000 * 60 , false , false , true );
             if ( err == -3 ) { // INVOKE_ERROR
                 stringstream ss;
                 ss << "error on invocation of $where function:\n"
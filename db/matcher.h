@@ -50,6 +50,31 @@ namespace mongo {
         }
     };
 
+    struct element_eq {
+        bool operator()(const BSONElement& l, const BSONElement& r) const {
+            if ( l.canonicalType() != r.canonicalType() )
+                return false;
+            return compareElementValues(l,r) == 0;
+        }
+    };
+
+
+    /** a dotted field name split once at parse time so matching doesn't
+        re-parse (and re-allocate) the path for every document scanned.
+        part(i) is the i-th component; suffix(i) is the dotted tail starting
+        at component i, so suffix(0) is the full name. */
+    class FieldPath {
+    public:
+        FieldPath() {}
+        explicit FieldPath( const char *fieldName ) { compile( fieldName ); }
+        void compile( const char *fieldName );
+        int size() const { return _parts.size(); }
+        const char * part( int i ) const { return _parts[i].c_str(); }
+        const char * suffix( int i ) const { return _suffixes[i].c_str(); }
+    private:
+        vector<string> _parts;
+        vector<string> _suffixes;
+    };
 
     class ElementMatcher {
     public:
@@ -66,6 +91,7 @@ namespace mongo {
         BSONElement _toMatch;
         int _compareOp;
         bool _isNot;
+        shared_ptr<FieldPath> _path; // _toMatch's field name, precompiled
         shared_ptr< set<BSONElement,element_lt> > _myset;
         shared_ptr< vector<RegexMatcher> > _myregex;
 
@@ -119,15 +145,22 @@ namespace mongo {
        TODO: we should rewrite the matcher to be more an AST style.
     */
     class Matcher : boost::noncopyable {
+        /* fieldIndex, if provided, is a prebuilt top level field lookup table for the
+           outermost object being matched; used instead of a linear getField() scan
+           when the object in hand is the one indexed. */
+        /* level indexes into bm._path - the portion of the dotted field name
+           still to be matched.  the path itself is compiled once at parse time. */
         int matchesDotted(
-            const char *fieldName,
+            int level,
             const BSONElement& toMatch, const BSONObj& obj,
-            int compareOp, const ElementMatcher& bm, bool isArr , MatchDetails * details );
+            int compareOp, const ElementMatcher& bm, bool isArr , MatchDetails * details ,
+            const BSONFieldIndex *fieldIndex = 0 );
 
         int matchesNe(
-            const char *fieldName,
+            int level,
             const BSONElement &toMatch, const BSONObj &obj,
-            const ElementMatcher&bm, MatchDetails * details );
+            const ElementMatcher&bm, MatchDetails * details ,
+            const BSONFieldIndex *fieldIndex = 0 );
 
     public:
         static int opDirection(int op) {
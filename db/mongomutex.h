@@ -41,6 +41,11 @@ namespace mongo {
          */
         int getState() const { return _state.get(); }
 
+        /** queue depth on the lock - how many threads are blocked acquiring.
+            two atomic reads, so cheap enough to consult on every cursor advance. */
+        int writersWaiting() const { return _writersWaiting; }
+        int readersWaiting() const { return _readersWaiting; }
+
         bool atLeastReadLocked() const { return _state.get() != 0; }
         void assertAtLeastReadLocked() const { assert(atLeastReadLocked()); }
         bool isWriteLocked() const { return getState() > 0; }
@@ -57,10 +62,13 @@ namespace mongo {
             _state.set(1);
 
             Client *c = curopWaitingForLock( 1 ); // stats
+            _writersWaiting++;
             _m.lock();
+            _writersWaiting--;
             curopGotLock(c);
 
             _minfo.entered();
+            _acquiredAtMicros = curTimeMicros64();
 
             MongoFile::markAllWritable(); // for _DEBUG validation -- a no op for release build
 
@@ -73,11 +81,14 @@ namespace mongo {
                 return true;
 
             Client *c = curopWaitingForLock( 1 );
+            _writersWaiting++;
             bool got = _m.lock_try( millis );
+            _writersWaiting--;
 
             if ( got ) {
                 curopGotLock(c);
                 _minfo.entered();
+                _acquiredAtMicros = curTimeMicros64();
                 _state.set(1);
                 MongoFile::markAllWritable(); // for _DEBUG validation -- a no op for release build
                 _acquiredWriteLock();
@@ -104,7 +115,9 @@ namespace mongo {
             MongoFile::unmarkAllWritable(); // _DEBUG validation
             _state.set(0);
             _minfo.leaving();
+            unsigned long long acquiredAt = _acquiredAtMicros; // next writer may scribble on it once we release
             _m.unlock();
+            _recordHold( acquiredAt ); // lockStats attribution - after release so we add no hold time
         }
 
         /* unlock (write lock), and when unlock() is called later,
@@ -133,7 +146,9 @@ namespace mongo {
             else {
                 _state.set(-1);
                 Client *c = curopWaitingForLock( -1 );
+                _readersWaiting++;
                 _m.lock_shared();
+                _readersWaiting--;
                 curopGotLock(c);
             }
         }
@@ -151,7 +166,9 @@ namespace mongo {
                              Client *c = curopWaitingForLock( 1 );
                here?  i think so.  seems to be missing.
                */
+            _readersWaiting++;
             bool got = _m.lock_shared_try( millis );
+            _readersWaiting--;
             if ( got )
                 _state.set(-1);
             return got;
@@ -178,6 +195,7 @@ namespace mongo {
     private:
         void _acquiredWriteLock();
         void _releasingWriteLock();
+        void _recordHold( unsigned long long acquiredAtMicros ); // in lockstats.cpp - reports hold time/holder to writeLockStats
 
         /* @return true if was already write locked.  increments recursive lock count. */
         bool _writeLockedAlready();
@@ -191,6 +209,13 @@ namespace mongo {
 
         MutexInfo _minfo;
 
+        /* when the current write lock hold began.  only touched by the
+           thread holding the write lock, so a plain member is fine. */
+        unsigned long long _acquiredAtMicros;
+
+        AtomicUInt _writersWaiting; // threads blocked in _m.lock()
+        AtomicUInt _readersWaiting; // threads blocked in _m.lock_shared()
+
     public:
         // indicates we need to call dur::REMAPPRIVATEVIEW on the next write lock
         bool _remapPrivateViewRequested;
@@ -69,7 +69,7 @@ namespace mongo {
         reservedA = 0;
         extraOffset = 0;
         indexBuildInProgress = 0;
-        reservedB = 0;
+        cappedSlotSize = 0;
         capped2.cc2_ptr = 0;
         capped2.fileNumber = 0;
         memset(reserved, 0, sizeof(reserved));
@@ -87,6 +87,14 @@ namespace mongo {
         return ret;
     }
 
+    boost::filesystem::path NamespaceIndex::extensionPath() const {
+        boost::filesystem::path ret( dir_ );
+        if ( directoryperdb )
+            ret /= database_;
+        ret /= ( database_ + ".ns1" );
+        return ret;
+    }
+
     void NamespaceIndex::maybeMkdir() const {
         if ( !directoryperdb )
             return;
@@ -200,8 +208,48 @@ namespace mongo {
 
         assert( len <= 0x7fffffff );
         ht = new HashTable<Namespace,NamespaceDetails>(p, (int) len, "namespace index");
-        if( checkNsFilesOnLoad )
+
+        // a lazily allocated extension file may be left from a previous run
+        boost::filesystem::path xPath = extensionPath();
+        if( MMF::exists(xPath) ) {
+            string xs = xPath.string();
+            if( !fExt.open(xs, true) ) {
+                log() << "error couldn't open file " << xs << " terminating" << endl;
+                dbexit( EXIT_FS );
+            }
+            unsigned long long xlen = fExt.length();
+            uassert( 15977 , "bad .ns1 file length, cannot open database", xlen % (1024*1024) == 0 && xlen <= 0x7fffffff );
+            htExt = new HashTable<Namespace,NamespaceDetails>(fExt.getView(), (int) xlen, "namespace index extension");
+        }
+
+        if( checkNsFilesOnLoad ) {
             ht->iterAll(namespaceOnLoadCallback);
+            if( htExt )
+                htExt->iterAll(namespaceOnLoadCallback);
+        }
+    }
+
+    /* the .ns file is fixed size, and a NamespaceDetails address must never
+       change once handed out, so we cannot rehash in place when it fills.
+       instead overflow goes to a second table in its own (lazily created,
+       so most databases never pay for it) mmapped file. */
+    void NamespaceIndex::allocExtension() {
+        if ( htExt )
+            return;
+        maybeMkdir();
+        boost::filesystem::path xPath = extensionPath();
+        assert( !MMF::exists(xPath) );
+        string xs = xPath.string();
+        unsigned long long l = (unsigned long long) lenForNewNsFiles * 2;
+        if ( l > 0x7f000000 )
+            l = 0x7f000000; // the hash table addresses with a signed 32 bit offset
+        if( !fExt.create(xs, l, true) ) {
+            log() << "error couldn't create file " << xs << endl;
+            uasserted( 15978 , "couldn't create .ns1 extension file" );
+        }
+        getDur().createdFile(xs, l);
+        log() << "info: namespace index for " << database_ << " full, created extension file " << xs << endl;
+        htExt = new HashTable<Namespace,NamespaceDetails>(fExt.getView(), (int) l, "namespace index extension");
     }
 
     static void namespaceGetNamespacesCallback( const Namespace& k , NamespaceDetails& v , void * extra ) {
@@ -215,6 +263,8 @@ namespace mongo {
 
         if ( ht )
             ht->iterAll( namespaceGetNamespacesCallback , (void*)&tofill );
+        if ( htExt )
+            htExt->iterAll( namespaceGetNamespacesCallback , (void*)&tofill );
     }
 
     void NamespaceDetails::addDeletedRec(DeletedRecord *d, DiskLoc dloc) {
@@ -243,7 +293,9 @@ namespace mongo {
             else {
                 d->nextDeleted = cappedFirstDeletedInCurExtent();
                 getDur().writingDiskLoc( cappedFirstDeletedInCurExtent() ) = dloc;
-                // always compact() after this so order doesn't matter
+                // order within the extent's chunk of the list doesn't matter: the normal
+                // path compact()s right after this, and in uniform slot mode any freed
+                // slot fits any insert
             }
         }
         else {
@@ -262,6 +314,13 @@ namespace mongo {
     */
     DiskLoc NamespaceDetails::alloc(const char *ns, int lenToAlloc, DiskLoc& extentLoc) {
         lenToAlloc = (lenToAlloc + 3) & 0xfffffffc;
+        if ( capped && cappedSlotSize ) {
+            // uniform slot mode -- every record gets the full slot, so a freed
+            // record always exact-fits the next insert.  see __capAlloc().
+            uassert( 15922, str::stream() << "object too large for capped collection slotSize of "
+                     << cappedSlotSize << " bytes", lenToAlloc <= (int) cappedSlotSize );
+            lenToAlloc = cappedSlotSize;
+        }
         DiskLoc loc = _alloc(ns, lenToAlloc);
         if ( loc.isNull() )
             return loc;
@@ -285,6 +344,11 @@ namespace mongo {
                 return loc;
             }
         }
+        else if ( left == 0 ) {
+            // an exact fit from a recycled slot - only happens in uniform slot
+            // mode, where __capAlloc() guarantees such a region matches exactly.
+            return loc;
+        }
 
         /* split off some for further use. */
         getDur().writingInt(r->lengthWithHeaders) = lenToAlloc;
@@ -302,80 +366,105 @@ namespace mongo {
         return loc;
     }
 
+    /* how deep into the home bucket's chain __stdAlloc probes for a fit
+       before giving up and popping from a larger size class. */
+    const int AllocProbes = 5;
+
+    /* pop cur, whose back pointer is *prev, off its deleted chain */
+    static DiskLoc popDeleted( DiskLoc *prev, const DiskLoc cur ) {
+        const DeletedRecord *r = cur.drec();
+        *getDur().writing(prev) = r->nextDeleted;
+        r->nextDeleted.writing().setInvalid(); // defensive.
+        assert( r->extentOfs < cur.getOfs() );
+        return cur;
+    }
+
+    static bool deletedLocBad( const DiskLoc& cur, int b ) {
+        int a = cur.a();
+        if ( a < -1 || a >= 100000 ) {
+            problem() << "~~ Assertion - cur out of range in __stdAlloc() " << cur.toString() <<
+                      " a:" << a << " b:" << b << '\n';
+            sayDbContext();
+            return true;
+        }
+        return false;
+    }
+
     /* for non-capped collections.
        returned item is out of the deleted list upon return
+
+       segregated fit over the size-class buckets.  the home bucket for len can
+       hold records a bit smaller than len, so only its first few entries are
+       probed; after that we pop the head of the first nonempty larger bucket,
+       where every record is guaranteed big enough.  the walk is thus bounded
+       no matter how fragmented the lists get - alloc() splits the leftover off
+       an oversized grab and returns it to the freelist, so this self heals.
     */
     DiskLoc NamespaceDetails::__stdAlloc(int len) {
-        DiskLoc *prev;
-        DiskLoc *bestprev = 0;
-        DiskLoc bestmatch;
-        int bestmatchlen = 0x7fffffff;
         int b = bucket(len);
-        DiskLoc cur = deletedList[b];
-        prev = &deletedList[b];
-        int extra = 5; // look for a better fit, a little.
-        int chain = 0;
-        while ( 1 ) {
-            {
-                int a = cur.a();
-                if ( a < -1 || a >= 100000 ) {
-                    problem() << "~~ Assertion - cur out of range in _alloc() " << cur.toString() <<
-                              " a:" << a << " b:" << b << " chain:" << chain << '\n';
-                    sayDbContext();
-                    if ( cur == *prev )
-                        prev->Null();
-                    cur.Null();
-                }
-            }
-            if ( cur.isNull() ) {
-                // move to next bucket.  if we were doing "extra", just break
-                if ( bestmatchlen < 0x7fffffff )
+        {
+            // the top bucket has no larger size class to fall back on, so dig
+            // a little deeper there before giving up
+            int maxProbes = b == MaxBucket ? 6 * AllocProbes : AllocProbes;
+            DiskLoc *prev = &deletedList[b];
+            DiskLoc cur = *prev;
+            for( int probes = 0; probes < maxProbes && !cur.isNull(); probes++ ) {
+                if ( deletedLocBad( cur, b ) ) {
+                    // truncate the chain at the bad link
+                    getDur().writingDiskLoc(*prev).Null();
                     break;
-                b++;
-                if ( b > MaxBucket ) {
-                    // out of space. alloc a new extent.
-                    return DiskLoc();
                 }
-                cur = deletedList[b];
-                prev = &deletedList[b];
-                continue;
-            }
-            DeletedRecord *r = cur.drec();
-            if ( r->lengthWithHeaders >= len &&
-                    r->lengthWithHeaders < bestmatchlen ) {
-                bestmatchlen = r->lengthWithHeaders;
-                bestmatch = cur;
-                bestprev = prev;
-            }
-            if ( bestmatchlen < 0x7fffffff && --extra <= 0 )
-                break;
-            if ( ++chain > 30 && b < MaxBucket ) {
-                // too slow, force move to next bucket to grab a big chunk
-                //b++;
-                chain = 0;
-                cur.Null();
-            }
-            else {
-                /*this defensive check only made sense for the mmap storage engine:
-                  if ( r->nextDeleted.getOfs() == 0 ) {
-                    problem() << "~~ Assertion - bad nextDeleted " << r->nextDeleted.toString() <<
-                    " b:" << b << " chain:" << chain << ", fixing.\n";
-                    r->nextDeleted.Null();
-                }*/
-                cur = r->nextDeleted;
+                DeletedRecord *r = cur.drec();
+                if ( r->lengthWithHeaders >= len )
+                    return popDeleted( prev, cur );
                 prev = &r->nextDeleted;
+                cur = r->nextDeleted;
             }
         }
 
-        /* unlink ourself from the deleted list */
-        {
-            const DeletedRecord *bmr = bestmatch.drec();
-            *getDur().writing(bestprev) = bmr->nextDeleted;
-            bmr->nextDeleted.writing().setInvalid(); // defensive.
-            assert(bmr->extentOfs < bestmatch.getOfs());
+        /* records in bucket b+1 and up are all at least bucketSizes[b] > len
+           bytes long, so the first nonempty head fits: O(1). */
+        while ( ++b <= MaxBucket ) {
+            DiskLoc cur = deletedList[b];
+            if ( cur.isNull() )
+                continue;
+            if ( deletedLocBad( cur, b ) ) {
+                getDur().writingDiskLoc(deletedList[b]).Null();
+                continue;
+            }
+            return popDeleted( &deletedList[b], cur );
         }
 
-        return bestmatch;
+        // out of space. alloc a new extent.
+        return DiskLoc();
+    }
+
+    /* how far into the home bucket's chain claimDeletedRec searches for the
+       exact record before giving up.  addDeletedRec pushes at the head, so
+       recently freed space - the common case for an adjacent merge - is found
+       quickly. */
+    const int ClaimProbes = 30;
+
+    bool NamespaceDetails::claimDeletedRec( const DiskLoc& dloc ) {
+        if ( capped )
+            return false;
+        int b = bucket( dloc.drec()->lengthWithHeaders );
+        DiskLoc *prev = &deletedList[b];
+        DiskLoc cur = *prev;
+        for( int probes = 0; probes < ClaimProbes && !cur.isNull(); probes++ ) {
+            if ( deletedLocBad( cur, b ) ) {
+                getDur().writingDiskLoc(*prev).Null();
+                break;
+            }
+            if ( cur == dloc ) {
+                popDeleted( prev, cur );
+                return true;
+            }
+            DeletedRecord *r = cur.drec();
+            prev = &r->nextDeleted;
+            cur = r->nextDeleted;
+        }
+        return false;
     }
 
     void NamespaceDetails::dumpDeleted(set<DiskLoc> *extents) {
@@ -396,6 +485,20 @@ namespace mongo {
         }
     }
 
+    void NamespaceDetails::deletedListOccupancy( long long *counts, long long *bytes ) const {
+        for ( int i = 0; i < Buckets; i++ ) {
+            counts[i] = 0;
+            bytes[i] = 0;
+            DiskLoc loc = deletedList[i];
+            while ( !loc.isNull() ) {
+                DeletedRecord *r = loc.drec();
+                counts[i]++;
+                bytes[i] += r->lengthWithHeaders;
+                loc = r->nextDeleted;
+            }
+        }
+    }
+
     DiskLoc NamespaceDetails::firstRecord( const DiskLoc &startExtent ) const {
         for (DiskLoc i = startExtent.isNull() ? firstExtent : startExtent;
                 !i.isNull(); i = i.ext()->xnext ) {
@@ -445,11 +548,15 @@ namespace mongo {
             return;
         Namespace n(ns);
         ht->kill(n);
+        if ( htExt )
+            htExt->kill(n);
 
         for( int i = 0; i<=1; i++ ) {
             try {
                 Namespace extra(n.extraName(i).c_str());
                 ht->kill(extra);
+                if ( htExt )
+                    htExt->kill(extra);
             }
             catch(DBException&) { }
         }
@@ -462,11 +569,16 @@ namespace mongo {
         Namespace extra(n.extraName(i).c_str()); // throws userexception if ns name too long
 
         massert( 10350 ,  "allocExtra: base ns missing?", d );
-        massert( 10351 ,  "allocExtra: extra already exists", ht->get(extra) == 0 );
+        massert( 10351 ,  "allocExtra: extra already exists",
+                 ht->get(extra) == 0 && ( !htExt || htExt->get(extra) == 0 ) );
 
         NamespaceDetails::Extra temp;
         temp.init();
-        uassert( 10082 ,  "allocExtra: too many namespaces/collections", ht->put(extra, (NamespaceDetails&) temp));
+        if ( !ht->put(extra, (NamespaceDetails&) temp) ) {
+            allocExtension();
+            uassert( 10082 ,  "allocExtra: too many namespaces/collections", htExt && htExt->put(extra, (NamespaceDetails&) temp));
+            return (NamespaceDetails::Extra *) htExt->get(extra);
+        }
         NamespaceDetails::Extra *e = (NamespaceDetails::Extra *) ht->get(extra);
         return e;
     }
@@ -584,6 +696,25 @@ namespace mongo {
         clearQueryCache();
         _keysComputed = false;
         _indexSpecs.clear();
+        _indexKeyCounts.clear();
+        _modSetCache.clear();
+        _upsertLocs.clear();
+    }
+
+    long long NamespaceDetailsTransient::indexKeyCountEstimate( NamespaceDetails *d, int idxNo ) {
+        IndexDetails& idx = d->idx( idxNo );
+        IndexKeyCount& c = _indexKeyCounts[ &idx ];
+        long long nrecords = d->stats.nrecords;
+        // resample once the collection has grown or shrunk enough that the old
+        // estimate could misorder indexes; the slop term keeps tiny collections
+        // from resampling on every call
+        if ( c.keys < 0 || nrecords > 2 * c.nrecords + 128 || 2 * nrecords + 128 < c.nrecords ) {
+            if ( idx.head.isNull() )
+                return -1;
+            c.keys = idx.idxInterface().keyCountEstimate( idx.head );
+            c.nrecords = nrecords;
+        }
+        return c.keys;
     }
 
     /*    NamespaceDetailsTransient& NamespaceDetailsTransient::get(const char *ns) {
@@ -615,6 +746,21 @@ namespace mongo {
         }
     }
 
+    int NamespaceDetailsTransient::adaptiveAllocationSize( int minSize ) const {
+        if ( _sizeBinSamples < 256 )
+            return minSize; // too few updates seen to trust the distribution
+        long long target = ( _sizeBinSamples * 9 ) / 10;
+        long long seen = 0;
+        for ( int b = 0; b < NSizeBins; b++ ) {
+            seen += _sizeBins[b];
+            if ( seen >= target ) {
+                int allocSize = 1 << b;
+                return allocSize > minSize ? allocSize : minSize;
+            }
+        }
+        return minSize;
+    }
+
     void NamespaceDetailsTransient::computeIndexKeys() {
         _keysComputed = true;
         _indexKeys.clear();
@@ -695,10 +841,12 @@ namespace mongo {
         BSONObjIterator i( oldSpec.getObjectField( "options" ) );
         while( i.more() ) {
             BSONElement e = i.next();
-            if ( strcmp( e.fieldName(), "create" ) != 0 )
-                newSpecB.append( e );
-            else
+            if ( strcmp( e.fieldName(), "create" ) == 0 )
                 newSpecB << "create" << to;
+            else if ( strcmp( e.fieldName(), "temp" ) == 0 )
+                ; // renaming is how a temp collection becomes permanent (e.g. map-reduce output)
+            else
+                newSpecB.append( e );
         }
         BSONObj newSpec = newSpecB.done();
         addNewNamespaceToCatalog( to, newSpec.isEmpty() ? 0 : &newSpec );
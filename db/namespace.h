@@ -173,7 +173,13 @@ namespace mongo {
         long long extraOffset;                // where the $extra info is located (bytes relative to this)
     public:
         int indexBuildInProgress;             // 1 if in prog
-        unsigned reservedB;
+        /* uniform slot mode for capped collections (see cap.cpp).  when nonzero, every record
+           is allocated exactly this many bytes (with header) so freed space always exact-fits
+           the next insert and the deleted list never needs compact()ing.  0 = normal behavior.
+           set at create time via the 'slotSize' option.  (this field was formerly reservedB,
+           which was always written as zero, so old datafiles read back as normal behavior.)
+        */
+        unsigned cappedSlotSize;
         // ofs 424 (8)
         struct Capped2 {
             unsigned long long cc2_ptr;       // see capped.cpp
@@ -260,7 +266,9 @@ namespace mongo {
                  this isn't thread safe.  TODO
         */
         enum NamespaceFlags {
-            Flag_HaveIdIndex = 1 << 0 // set when we have _id index (ONLY if ensureIdIndex was called -- 0 if that has never been called)
+            Flag_HaveIdIndex = 1 << 0, // set when we have _id index (ONLY if ensureIdIndex was called -- 0 if that has never been called)
+            Flag_UsePowerOf2Sizes = 1 << 1, // quantize record allocations to powers of two (see collMod)
+            Flag_AdaptivePadding = 1 << 2   // preallocate from the observed post-update size distribution (see collMod)
         };
 
         IndexDetails& idx(int idxNo, bool missingExpected = false );
@@ -333,6 +341,29 @@ namespace mongo {
             }
         }
 
+        /* opt-in allocation strategies, set per namespace via the collMod command */
+        bool usingPowerOf2Sizes() const { return ( flags & Flag_UsePowerOf2Sizes ) != 0; }
+        bool usingAdaptivePadding() const { return ( flags & Flag_AdaptivePadding ) != 0; }
+        void setUserFlag( int flag ) {
+            if ( ( flags & flag ) == 0 )
+                *getDur().writing(&flags) = flags | flag;
+        }
+        void clearUserFlag( int flag ) {
+            if ( flags & flag )
+                *getDur().writing(&flags) = flags & ~flag;
+        }
+
+        /* record allocation size (with headers) rounded up to the next power of
+           two, so deleted records get reused by later allocations of the same
+           bucket instead of fragmenting the free lists.
+        */
+        static int quantizePowerOf2AllocationSpace( int allocSize ) {
+            int z = 32;
+            while ( z < allocSize )
+                z <<= 1;
+            return z;
+        }
+
         // @return offset in indexes[]
         int findIndexByName(const char *name);
 
@@ -375,7 +406,19 @@ namespace mongo {
         DiskLoc alloc(const char *ns, int lenToAlloc, DiskLoc& extentLoc);
         /* add a given record to the deleted chains for this NS */
         void addDeletedRec(DeletedRecord *d, DiskLoc dloc);
+        /* if the deleted record at dloc is on this namespace's freelist, unlink
+           and claim it.  the record header alone can't distinguish deleted from
+           live space, so callers that want to reuse a specific location (e.g.
+           merging adjacent free space into a growing record) must confirm it
+           this way.  probes only a bounded prefix of the home size bucket.
+           @return true if the record was found and unlinked */
+        bool claimDeletedRec( const DiskLoc& dloc );
         void dumpDeleted(set<DiskLoc> *extents = 0);
+        /* per size-class freelist occupancy.  counts and bytes must each have
+           Buckets entries.  walks every chain - diagnostics only, not for hot
+           paths.  not meaningful for capped collections (they overload
+           deletedList - see above). */
+        void deletedListOccupancy( long long *counts, long long *bytes ) const;
         // Start from firstExtent by default.
         DiskLoc firstRecord( const DiskLoc &startExtent = DiskLoc() ) const;
         // Start from lastExtent by default.
@@ -416,6 +459,8 @@ namespace mongo {
     }; // NamespaceDetails
 #pragma pack()
 
+    class ModSet;
+
     /* NamespaceDetailsTransient
 
        these are things we know / compute about a namespace that are transient -- things
@@ -437,7 +482,10 @@ namespace mongo {
         void reset();
         static std::map< string, shared_ptr< NamespaceDetailsTransient > > _map;
     public:
-        NamespaceDetailsTransient(const char *ns) : _ns(ns), _keysComputed(false), _qcWriteCount() { }
+        NamespaceDetailsTransient(const char *ns) : _ns(ns), _keysComputed(false), _qcWriteCount() {
+            memset( _sizeBins , 0 , sizeof(_sizeBins) );
+            _sizeBinSamples = 0;
+        }
     private:
         /* _get() is not threadsafe -- see get_inlock() comments */
         static NamespaceDetailsTransient& _get(const char *ns);
@@ -510,10 +558,115 @@ namespace mongo {
             return spec;
         }
 
+        /* index key count estimates (for the query optimizer) ------------------- */
+    private:
+        struct IndexKeyCount {
+            IndexKeyCount() : keys(-1), nrecords(-1) {}
+            long long keys;     // estimated keys in the index, -1 = not sampled yet
+            long long nrecords; // collection record count when sampled
+        };
+        map<const IndexDetails*,IndexKeyCount> _indexKeyCounts;
+    public:
+        /** estimated number of keys in index 'idxNo', sampled from the btree and
+            cached; resampled once the collection's record count has drifted far
+            enough to make the old figure misleading.  call within _qcMutex like
+            the query cache accessors. */
+        long long indexKeyCountEstimate( NamespaceDetails *d, int idxNo );
+
+        /* update mod cache ------------------------------------------------------ */
+        /* assumed to be in write lock for this, like indexKeys() */
+    private:
+        map< string, shared_ptr<ModSet> > _modSetCache;
+        enum { MaxCachedModSets = 500 };
+    public:
+        /** parsed modifiers for an update object, cached by the object's exact
+            bytes.  repeated applications of the same update document (the
+            common case for $inc / $set style traffic) then skip the per-op
+            ModSet parse.  invalidated with the rest of the transient state on
+            index changes since the mods note which fields are indexed.
+            defined in ops/update.cpp. */
+        shared_ptr<ModSet> cachedModSet( const BSONObj& updateobj );
+
+        /* recently upserted location cache -------------------------------------- */
+        /* assumed to be in write lock for this, like indexKeys() */
+    private:
+        map< string, DiskLoc > _upsertLocs; // query pattern bytes -> last location
+        enum { MaxUpsertLocs = 64 };
+    public:
+        /** remember where an upsert for this exact query pattern landed.  dedup
+            style workloads upsert the same keys over and over; the next one can
+            try this location before paying for a full query.  entries are hints
+            only - the reader must validate the record against the pattern, and
+            deleteRecord() calls deletingRecord() below so a hint never outlives
+            the record it points at. */
+        void notedUpsert( const BSONObj& pattern , const DiskLoc& loc ) {
+            if ( _upsertLocs.size() >= MaxUpsertLocs )
+                _upsertLocs.clear();
+            _upsertLocs[ string( pattern.objdata() , pattern.objsize() ) ] = loc;
+        }
+
+        /** @return the location last upserted for this pattern, or DiskLoc() */
+        DiskLoc upsertLoc( const BSONObj& pattern ) const {
+            map< string, DiskLoc >::const_iterator i =
+                _upsertLocs.find( string( pattern.objdata() , pattern.objsize() ) );
+            return i == _upsertLocs.end() ? DiskLoc() : i->second;
+        }
+
+        /** all records may have moved or been reclaimed without individual
+            deleteRecord() calls (compact frees whole extents) - drop every hint */
+        void clearUpsertLocs() { _upsertLocs.clear(); }
+
+        /** the record at loc is being deleted (or moved) - drop hints to it */
+        void deletingRecord( const DiskLoc& loc ) {
+            if ( _upsertLocs.empty() )
+                return;
+            for ( map< string, DiskLoc >::iterator i = _upsertLocs.begin(); i != _upsertLocs.end(); ) {
+                if ( i->second == loc )
+                    _upsertLocs.erase( i++ );
+                else
+                    ++i;
+            }
+        }
+
+        /* post-update record size distribution (for adaptive padding) ----------- */
+        /* assumed to be in write lock for this, like indexKeys() */
+    private:
+        enum { NSizeBins = 32 };
+        long long _sizeBins[NSizeBins]; // bin b counts record lengths <= (1<<b)
+        long long _sizeBinSamples;
+        static int sizeBin( int lenWithHeaders ) {
+            int b = 5; // nothing interesting below 32 bytes
+            while ( b < NSizeBins - 1 && lenWithHeaders > ( 1 << b ) )
+                b++;
+            return b;
+        }
+    public:
+        /** note the total record length (object plus headers) after an update */
+        void recordUpdateSize( int lenWithHeaders ) {
+            _sizeBins[ sizeBin( lenWithHeaders ) ]++;
+            _sizeBinSamples++;
+        }
+        /** allocation size covering the 90th percentile of post-update record
+            lengths seen for this namespace, or minSize if that is larger or we
+            have not observed enough updates yet to trust the distribution. */
+        int adaptiveAllocationSize( int minSize ) const;
+
         /* query cache (for query optimizer) ------------------------------------- */
+    public:
+        /** winning plan recorded for a query shape.  idxNo is a hint only - the index
+            list may have changed since recording, so verify the key pattern at idxNo
+            before using it. */
+        struct CachedQueryPlan {
+            CachedQueryPlan() : nScanned( 0 ), idxNo( -1 ) { }
+            CachedQueryPlan( const BSONObj &key, long long n, int idx ) :
+                indexKey( key ), nScanned( n ), idxNo( idx ) { }
+            BSONObj indexKey;
+            long long nScanned;
+            int idxNo;
+        };
     private:
         int _qcWriteCount;
-        map< QueryPattern, pair< BSONObj, long long > > _qcCache;
+        map< QueryPattern, CachedQueryPlan > _qcCache;
     public:
         static SimpleMutex _qcMutex;
         /* you must be in the qcMutex when calling this (and using the returned val): */
@@ -532,13 +685,16 @@ namespace mongo {
                 clearQueryCache();
         }
         BSONObj indexForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ].first;
+            return _qcCache[ pattern ].indexKey;
         }
         long long nScannedForPattern( const QueryPattern &pattern ) {
-            return _qcCache[ pattern ].second;
+            return _qcCache[ pattern ].nScanned;
+        }
+        CachedQueryPlan cachedPlanForPattern( const QueryPattern &pattern ) {
+            return _qcCache[ pattern ];
         }
-        void registerIndexForPattern( const QueryPattern &pattern, const BSONObj &indexKey, long long nScanned ) {
-            _qcCache[ pattern ] = make_pair( indexKey, nScanned );
+        void registerIndexForPattern( const QueryPattern &pattern, const BSONObj &indexKey, long long nScanned, int idxNo = -1 ) {
+            _qcCache[ pattern ] = CachedQueryPlan( indexKey, nScanned, idxNo );
         }
 
     }; /* NamespaceDetailsTransient */
@@ -558,7 +714,7 @@ namespace mongo {
 
     public:
         NamespaceIndex(const string &dir, const string &database) :
-            ht( 0 ), dir_( dir ), database_( database ) {}
+            ht( 0 ), htExt( 0 ), dir_( dir ), database_( database ) {}
 
         /* returns true if new db will be created if we init lazily */
         bool exists() const;
@@ -572,7 +728,19 @@ namespace mongo {
         void add_ns( const char *ns, const NamespaceDetails &details ) {
             init();
             Namespace n(ns);
-            uassert( 10081 , "too many namespaces/collections", ht->put(n, details));
+            if ( htExt && htExt->get(n) ) {
+                // already lives in the extension - update in place
+                assert( htExt->put(n, details) );
+                return;
+            }
+            if ( ht->put(n, details) )
+                return;
+            /* the fixed size .ns table is full (or its probe chains hit the
+               cap).  overflow into the lazily allocated extension file -
+               existing entries never move, as NamespaceDetails addresses are
+               held all over and must stay stable. */
+            allocExtension();
+            uassert( 10081 , "too many namespaces/collections", htExt && htExt->put(n, details));
         }
 
         /* just for diagnostics */
@@ -587,6 +755,8 @@ namespace mongo {
                 return 0;
             Namespace n(ns);
             NamespaceDetails *d = ht->get(n);
+            if ( !d && htExt )
+                d = htExt->get(n);
             if ( d && d->capped )
                 d->cappedCheckMigrate();
             return d;
@@ -613,13 +783,18 @@ namespace mongo {
 
         boost::filesystem::path path() const;
 
-        unsigned long long fileLength() const { return f.length(); }
+        unsigned long long fileLength() const { return f.length() + ( htExt ? fExt.length() : 0 ); }
 
     private:
         void maybeMkdir() const;
+        boost::filesystem::path extensionPath() const;
+        /* create (or open, at init) the overflow table for when ht fills up */
+        void allocExtension();
 
         MongoMMF f;
+        MongoMMF fExt;
         HashTable<Namespace,NamespaceDetails> *ht;
+        HashTable<Namespace,NamespaceDetails> *htExt;
         string dir_;
         string database_;
     };
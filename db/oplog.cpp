@@ -197,6 +197,78 @@ namespace mongo {
         }
     }
 
+    /** batched flavor of _logOpRS for multi-inserts.  writes one entry per object
+        (capped allocation can wrap extents, so a batch cannot be laid down as one
+        contiguous region), but enters the oplog context, checks primaryness and
+        updates lastOpTimeWritten/lastH once per batch instead of once per document.
+    */
+    static void _logInsertOpsRS(const char *ns, const vector<BSONObj>& objs) {
+        DEV assertInWriteLock();
+
+        if ( strncmp(ns, "local.", 6) == 0 ) {
+            if ( strncmp(ns, "local.slaves", 12) == 0 )
+                resetSlaveCache();
+            return;
+        }
+
+        long long h;
+        if( theReplSet ) {
+            massert(15910, "replSet error : logOp() but not primary?", theReplSet->box.getState().primary());
+            h = theReplSet->lastH;
+        }
+        else {
+            // must be initiation
+            assert( *ns == 0 );
+            h = 0;
+        }
+
+        const char *logns = rsoplog;
+        if ( rsOplogDetails == 0 ) {
+            Client::Context ctx( logns , dbpath, 0, false);
+            localDB = ctx.db();
+            assert( localDB );
+            rsOplogDetails = nsdetails(logns);
+            massert(15911, "local.oplog.rs missing. did you drop it? if so restart server", rsOplogDetails);
+        }
+        Client::Context ctx( logns , localDB, false );
+
+        OpTime ts;
+        for ( unsigned i = 0; i < objs.size(); i++ ) {
+            const BSONObj& obj = objs[i];
+
+            ts = OpTime::now();
+            if( theReplSet )
+                h = (h * 131 + ts.asLL()) * 17 + theReplSet->selfId();
+
+            logopbufbuilder.reset();
+            BSONObjBuilder b(logopbufbuilder);
+            b.appendTimestamp("ts", ts.asDate());
+            b.append("h", h);
+            b.append("op", "i");
+            b.append("ns", ns);
+            BSONObj partial = b.done();
+            int len = partial.objsize() + obj.objsize() + 1 + 2 /*o:*/;
+
+            Record *r = theDataFileMgr.fast_oplog_insert(rsOplogDetails, logns, len);
+            append_O_Obj(r->data, partial, obj);
+
+            if ( logLevel >= 6 ) {
+                BSONObj temp(r);
+                log( 6 ) << "logOp:" << temp << endl;
+            }
+        }
+
+        if( theReplSet ) {
+            if( !(theReplSet->lastOpTimeWritten<ts) ) {
+                log() << "replSet ERROR possible failover clock skew issue? " << theReplSet->lastOpTimeWritten << ' ' << ts << rsLog;
+                log() << "replSet " << theReplSet->isPrimary() << rsLog;
+            }
+            theReplSet->lastOpTimeWritten = ts;
+            theReplSet->lastH = h;
+            ctx.getClient()->setLastOp( ts.asDate() );
+        }
+    }
+
     /* we write to local.opload.$main:
          { ts : ..., op: ..., ns: ..., o: ... }
        ts: an OpTime timestamp
@@ -316,6 +388,25 @@ namespace mongo {
         logOpForSharding( opstr , ns , obj , patt );
     }
 
+    void logInsertOps(const char *ns, const vector<BSONObj>& objs) {
+        if ( objs.empty() )
+            return;
+
+        if ( replSettings.master ) {
+            if ( _logOp == _logOpRS ) {
+                _logInsertOpsRS(ns, objs);
+            }
+            else {
+                // non replset flavors don't carry per-batch state worth amortizing
+                for ( unsigned i = 0; i < objs.size(); i++ )
+                    _logOp("i", ns, 0, objs[i], 0, 0);
+            }
+        }
+
+        for ( unsigned i = 0; i < objs.size(); i++ )
+            logOpForSharding( "i" , ns , objs[i] , 0 );
+    }
+
     void createOplog() {
         dblock lk;
 
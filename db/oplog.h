@@ -51,6 +51,11 @@ namespace mongo {
     */
     void logOp(const char *opstr, const char *ns, const BSONObj& obj, BSONObj *patt = 0, bool *b = 0);
 
+    /** log a batch of inserts to the same ns.  one oplog entry per object, but the
+        context switch, primary check and optime/hash bookkeeping are paid once for
+        the whole batch.  must be in the write lock, like logOp. */
+    void logInsertOps(const char *ns, const vector<BSONObj>& objs);
+
     void logKeepalive();
 
     /** puts obj in the oplog as a comment (a no-op).  Just for diags.
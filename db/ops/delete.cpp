@@ -19,6 +19,7 @@
 #include "pch.h"
 #include "delete.h"
 #include "../queryoptimizer.h"
+#include "../btree.h"
 #include "../oplog.h"
 
 namespace mongo {
@@ -104,6 +105,121 @@ namespace mongo {
         int _orClauseIndex;
     };
 
+    /* if pattern is a pure range on one field - e.g. { ts : { $lt : x } } or
+       { ts : { $gte : a , $lt : b } } - compute btree bounds for it.
+       conservative: any operator we don't recognize disqualifies the pattern.
+       the bounds may be a superset of what matches (an exclusive $gt start is
+       returned inclusive); callers must still run the matcher per key. */
+    static bool rangePatternBounds( const BSONObj& pattern , BSONObj& startKey , BSONObj& endKey , bool& endInclusive ) {
+        if ( pattern.nFields() != 1 )
+            return false;
+        BSONElement e = pattern.firstElement();
+        if ( e.type() != Object )
+            return false;
+        BSONElement lo, hi;
+        endInclusive = true;
+        BSONObjIterator i( e.embeddedObject() );
+        while ( i.more() ) {
+            BSONElement op = i.next();
+            switch( op.getGtLtOp( -1 ) ) {
+            case BSONObj::LT:
+                if ( !hi.eoo() ) return false;
+                hi = op; endInclusive = false;
+                break;
+            case BSONObj::LTE:
+                if ( !hi.eoo() ) return false;
+                hi = op; endInclusive = true;
+                break;
+            case BSONObj::GT:
+            case BSONObj::GTE:
+                if ( !lo.eoo() ) return false;
+                lo = op;
+                break;
+            default:
+                return false;
+            }
+        }
+        if ( lo.eoo() && hi.eoo() )
+            return false;
+        BSONObjBuilder s, t;
+        if ( lo.eoo() ) s.appendMinKey( "" ); else s.appendAs( lo , "" );
+        if ( hi.eoo() ) t.appendMaxKey( "" ); else t.appendAs( hi , "" );
+        startKey = s.obj();
+        endKey = t.obj();
+        return true;
+    }
+
+    /* bulk path for unindexed-criteria-free range deletes (ttl style purges of
+       old events).  walks the index range once, batching up doomed DiskLocs and
+       deleting each batch in disk order - so record pages are touched
+       sequentially and the (slow) cursor noteLocation/checkLocation dance
+       happens once per batch rather than once per document.  yields between
+       batches, never in the middle of one: collected locs are only valid while
+       we hold the lock.
+    */
+    static long long bulkDeleteRange( const char *ns , NamespaceDetails *d , int idxNo ,
+                                      const BSONObj& startKey , const BSONObj& endKey , bool endInclusive ,
+                                      const BSONObj& pattern , bool logop , bool god , RemoveSaver *rs ) {
+        IndexDetails& idx = d->idx( idxNo );
+        shared_ptr<Cursor> c( BtreeCursor::make( d , idxNo , idx , startKey , endKey , endInclusive , 1 ) );
+        auto_ptr<ClientCursor> cc( new ClientCursor( QueryOption_NoCursorTimeout , c , ns ) );
+        cc->setDoingDeletes( true );
+
+        // multikey: several entries can point at one doc, and only the full
+        // document tells us whether it really matches
+        CoveredIndexMatcher matcher( pattern , idx.keyPattern() , d->isMultikey( idxNo ) );
+
+        const unsigned batchMax = 1000;
+        long long nDeleted = 0;
+        vector<DiskLoc> batch;
+
+        while ( cc->ok() ) {
+            batch.clear();
+            while ( c->ok() && batch.size() < batchMax ) {
+                DiskLoc rloc = c->currLoc();
+                if ( matcher.matchesCurrent( c.get() ) && !c->getsetdup( rloc ) )
+                    batch.push_back( rloc );
+                c->advance();
+            }
+            c->noteLocation();
+
+            // disk order so the record reads and deletes below are sequential
+            sort( batch.begin() , batch.end() );
+
+            for ( unsigned j = 0; j < batch.size(); j++ ) {
+                DiskLoc rloc = batch[j];
+                if ( logop ) {
+                    BSONElement e;
+                    if ( BSONObj( rloc.rec() ).getObjectID( e ) ) {
+                        BSONObjBuilder b;
+                        b.append( e );
+                        bool replJustOne = true;
+                        logOp( "d", ns, b.done(), 0, &replJustOne );
+                    }
+                    else {
+                        problem() << "deleted object without id, not logging" << endl;
+                    }
+                }
+                if ( rs )
+                    rs->goingToDelete( rloc.obj() );
+                theDataFileMgr.deleteRecord( ns , rloc.rec() , rloc );
+                nDeleted++;
+            }
+
+            if ( !god )
+                getDur().commitIfNeeded();
+
+            c->checkLocation();
+
+            if ( !god && ! cc->yieldSometimes( ClientCursor::WillNeed ) ) {
+                cc.release(); // has already been deleted elsewhere
+                break;
+            }
+        }
+
+        return nDeleted;
+    }
+
     /* ns:      namespace, e.g. <database>.<collection>
        pattern: the "where" clause / criteria
        justOne: stop after 1 match
@@ -129,6 +245,20 @@ namespace mongo {
             if ( ! d )
                 return 0;
             uassert( 10101 ,  "can't remove from a capped collection" , ! d->capped );
+
+            /* multi delete by a pure range on a singly (ascending) indexed
+               field?  take the bulk path - much friendlier to the working set
+               for big purges. */
+            if ( !justOneOrig ) {
+                BSONObj startKey, endKey;
+                bool endInclusive;
+                if ( rangePatternBounds( pattern , startKey , endKey , endInclusive ) ) {
+                    int idxNo = d->findIndexByKeyPattern( BSON( pattern.firstElement().fieldName() << 1 ) );
+                    if ( idxNo >= 0 )
+                        return bulkDeleteRange( ns , d , idxNo , startKey , endKey , endInclusive ,
+                                                pattern , logop , god , rs );
+                }
+            }
         }
 
         long long nDeleted = 0;
@@ -0,0 +1,163 @@
+// insertqueue.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "insertqueue.h"
+#include "../client.h"
+#include "../concurrency.h"
+#include "../replutil.h"
+#include "../dur.h"
+#include "../../util/background.h"
+
+namespace mongo {
+
+    void checkAndInsert(const char *ns, /*modifies*/BSONObj& js); // from instance.cpp
+
+    InsertQueue InsertQueue::global;
+
+    void InsertQueue::push( const char *ns , const BSONObj& o ) {
+        Staged s;
+        s.ns = ns;
+        s.o = o.getOwned();
+        scoped_lock lk( _mx );
+        if ( _bytes >= (long long) MaxQueuedBytes ) {
+            _stalls++;
+            while ( _bytes >= (long long) MaxQueuedBytes && ! inShutdown() )
+                _notFull.wait( lk.boost() );
+        }
+        _bytes += s.o.objsize();
+        _q.push_back( s );
+        _pushed++;
+        _notEmpty.notify_one();
+    }
+
+    bool InsertQueue::_popBatch( vector<Staged>& batch ) {
+        scoped_lock lk( _mx );
+        while ( _q.empty() ) {
+            boost::xtime xt;
+            boost::xtime_get(&xt, boost::TIME_UTC);
+            xt.sec += 1;
+            if ( ! _notEmpty.timed_wait( lk.boost() , xt ) && _q.empty() )
+                return false;
+        }
+        long long bytes = 0;
+        while ( ! _q.empty() && bytes < (long long) MaxBatchBytes ) {
+            bytes += _q.front().o.objsize();
+            batch.push_back( _q.front() );
+            _q.pop_front();
+        }
+        _bytes -= bytes;
+        _notFull.notify_all();
+        return true;
+    }
+
+    unsigned InsertQueue::_apply( vector<Staged>& batch ) {
+        // group by namespace so each run shares one Client::Context; staged
+        // inserts are fire and forget so the reordering is acceptable, and
+        // stable_sort keeps the arrival order within a namespace
+        stable_sort( batch.begin() , batch.end() , _byNs );
+
+        unsigned failed = 0;
+        writelock lk("");
+        unsigned i = 0;
+        while ( i < batch.size() ) {
+            const string& ns = batch[i].ns;
+            if ( ! isMasterNs( ns.c_str() ) ) {
+                // stepped down with documents staged; fire and forget drops them
+                unsigned n = 0;
+                while ( i < batch.size() && batch[i].ns == ns ) { i++; n++; }
+                failed += n;
+                log() << "insert queue: not master, discarding " << n << " staged documents for " << ns << endl;
+                continue;
+            }
+            Client::Context ctx( ns );
+            while ( i < batch.size() && batch[i].ns == ns ) {
+                try {
+                    checkAndInsert( ns.c_str() , batch[i].o );
+                }
+                catch ( UserException& e ) {
+                    // nothing to return the error to -- count it and move on
+                    failed++;
+                    log(1) << "insert queue: " << e.toString() << " ns:" << ns << endl;
+                }
+                i++;
+                if ( getDur().aCommitIsNeeded() )
+                    getDur().commitIfNeeded();
+            }
+        }
+        return failed;
+    }
+
+    void InsertQueue::_finishBatch( unsigned n , unsigned failed ) {
+        scoped_lock lk( _mx );
+        _applied += n;
+        _failed += failed;
+        _batches++;
+        _drained.notify_all();
+    }
+
+    void InsertQueue::waitUntilDrained() {
+        scoped_lock lk( _mx );
+        unsigned long long target = _pushed;
+        while ( _applied < target )
+            _drained.wait( lk.boost() );
+    }
+
+    void InsertQueue::appendStats( BSONObjBuilder& b ) const {
+        scoped_lock lk( _mx );
+        b.appendNumber( "queuedDocs" , (long long) _q.size() );
+        b.appendNumber( "queuedBytes" , _bytes );
+        b.appendNumber( "staged" , (long long) _pushed );
+        b.appendNumber( "applied" , (long long) ( _applied - _failed ) );
+        b.appendNumber( "failed" , (long long) _failed );
+        b.appendNumber( "batches" , (long long) _batches );
+        b.appendNumber( "stalls" , (long long) _stalls );
+    }
+
+    class InsertQueueWriter : public BackgroundJob {
+    public:
+        string name() const { return "insertwriter"; }
+        void run() {
+            Client::initThread( "insertwriter" );
+            log() << "insert queue writer starting" << endl;
+            while ( ! inShutdown() ) {
+                vector<InsertQueue::Staged> batch;
+                if ( ! InsertQueue::global._popBatch( batch ) )
+                    continue;
+                unsigned failed = 0;
+                try {
+                    failed = InsertQueue::global._apply( batch );
+                }
+                catch ( DBException& e ) {
+                    // whole batch failure (e.g. interrupted during shutdown).
+                    // failed is approximate then; _applied must still advance
+                    // by the full batch or drain waiters would hang.
+                    log() << "insert queue writer: " << e.toString() << endl;
+                    failed = batch.size();
+                }
+                InsertQueue::global._finishBatch( batch.size() , failed );
+            }
+            cc().shutdown();
+        }
+    } insertQueueWriter;
+
+    void startInsertQueueWriter() {
+        insertQueueWriter.go();
+    }
+
+}
@@ -0,0 +1,103 @@
+// insertqueue.h - staging queue for asynchronous (fire and forget) inserts
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../../pch.h"
+#include "../jsobj.h"
+#include <deque>
+
+namespace mongo {
+
+    class InsertQueueWriter;
+
+    /** bounded staging area for inserts when running with --asyncInserts.
+
+        connection threads validate documents and stage them here instead of
+        applying them under the write lock; a background writer drains the
+        queue, applying a whole batch per lock acquisition with documents
+        grouped by namespace.  a slow disk then stalls the writer, not the
+        sockets -- until the queue fills, at which point push() blocks and
+        the backpressure reaches the clients.
+
+        semantics are deliberately relaxed for staged inserts:
+        - a document is not visible to queries until the writer applies it.
+          getLastError waits for the queue to drain, so clients that do
+          acknowledge still read their own writes.
+        - per document errors (duplicate key, not master after a stepdown)
+          are counted and logged, not reported back to the client.
+    */
+    class InsertQueue : boost::noncopyable {
+    public:
+        enum {
+            MaxQueuedBytes = 64 * 1024 * 1024, // push() blocks beyond this
+            MaxBatchBytes  =  4 * 1024 * 1024  // per write lock acquisition
+        };
+
+        InsertQueue() : _mx("InsertQueue"), _bytes(0),
+            _pushed(0), _applied(0), _failed(0), _batches(0), _stalls(0) { }
+
+        /** stage one document for insertion into ns.  blocks while the queue
+            is full.  caller has already structurally validated o. */
+        void push( const char *ns , const BSONObj& o );
+
+        /** block until everything staged before the call has been applied (or
+            discarded).  used by getLastError and by clean shutdown. */
+        void waitUntilDrained();
+
+        void appendStats( BSONObjBuilder& b ) const;
+
+        static InsertQueue global;
+
+    private:
+        friend class InsertQueueWriter;
+
+        struct Staged {
+            string ns;
+            BSONObj o;
+        };
+
+        static bool _byNs( const Staged& l , const Staged& r ) { return l.ns < r.ns; }
+
+        /** wait briefly for work, then take up to MaxBatchBytes of it.
+            @return false if nothing arrived */
+        bool _popBatch( vector<Staged>& batch );
+        /** apply a batch under a single write lock.
+            @return number of documents that were not inserted */
+        unsigned _apply( vector<Staged>& batch );
+        /** account for a finished batch and wake drain waiters */
+        void _finishBatch( unsigned n , unsigned failed );
+
+        mutable mongo::mutex _mx;
+        std::deque<Staged> _q;
+        long long _bytes;            // of queued documents
+        unsigned long long _pushed;  // documents ever staged
+        unsigned long long _applied; // documents applied or discarded
+        unsigned long long _failed;  // subset of _applied that were discarded
+        unsigned long long _batches; // write lock acquisitions by the writer
+        unsigned long long _stalls;  // pushes that blocked on a full queue
+        boost::condition _notFull;
+        boost::condition _notEmpty;
+        boost::condition _drained;
+    };
+
+    /** start the background writer.  called once at startup when
+        --asyncInserts is set. */
+    void startInsertQueueWriter();
+
+}
@@ -61,8 +61,7 @@ namespace mongo {
         }
         anObjBuilder.append("errmsg", "db assertion failure");
         anObjBuilder.append("ok", 0.0);
-        BSONObj x = anObjBuilder.done();
-        b.appendBuf((void*) x.objdata(), x.objsize());
+        anObjBuilder.doneFast();
         return true;
     }
 
@@ -93,7 +92,18 @@ namespace mongo {
         ClientCursor::Pointer p(cursorid);
         ClientCursor *cc = p.c();
 
-        int bufSize = 512 + sizeof( QueryResult ) + MaxBytesToReturnToClientAtOnce;
+        // size the reply buffer from this cursor's history rather than always
+        // reserving the full batch limit up front: the previous reply's byte
+        // count is a very good estimate for the next one on a steady scan.
+        // BufBuilder grows if the guess is low, so this only affects
+        // allocation, never how much a batch can carry.
+        int bufSize = 512 + sizeof( QueryResult );
+        if ( cc ) {
+            int est = cc->lastBatchBytes();
+            if ( est <= 0 )
+                est = 128 * 1024; // first getMore on this cursor
+            bufSize += est + est / 8;
+        }
 
         BufBuilder b( bufSize );
         b.skip(sizeof(QueryResult));
@@ -117,11 +127,23 @@ namespace mongo {
             
             curop.debug().query = cc->query();
 
+            // fast consumers may be granted more than MaxBytesToReturnToClientAtOnce
+            int maxBytes = cc->nextBatchBytes();
+
             start = cc->pos();
             Cursor *c = cc->c();
             c->checkLocation();
             DiskLoc last;
 
+            // results staged by the previous getMore (tailable cursors) go
+            // out first - usually making this reply instant
+            if ( cc->haveStaged() ) {
+                int sn = cc->drainStaged( b );
+                cc->incPos( sn );
+                n += sn;
+            }
+            bool staging = false;
+
             scoped_ptr<Projection::KeyOnly> keyFieldsOnly;
             if ( cc->modifiedKeys() == false && cc->isMultiKey() == false && cc->fields )
                 keyFieldsOnly.reset( cc->fields->checkKey( cc->indexKeyPattern() ) );
@@ -163,6 +185,23 @@ namespace mongo {
                     if( c->getsetdup(c->currLoc()) ) {
                         //out() << "  but it's a dup \n";
                     }
+                    else if ( staging ) {
+                        // the reply batch is full; copy ahead into the staged
+                        // buffer so the next getMore is served instantly
+                        DiskLoc sl = c->currLoc();
+                        if ( keyFieldsOnly ) {
+                            fillQueryResultFromObj( cc->stagedBuf(), 0, keyFieldsOnly->hydrate( c->currKey() ) );
+                        }
+                        else {
+                            BSONObj js = c->current();
+                            fillQueryResultFromObj( cc->stagedBuf(), cc->fields.get(), js, ( cc->pq.get() && cc->pq->showDiskLoc() ? &sl : 0));
+                        }
+                        cc->noteStaged();
+                        if ( cc->stagedBytes() >= ClientCursor::MaxStagedBytes ) {
+                            c->advance();
+                            break;
+                        }
+                    }
                     else {
                         last = c->currLoc();
                         n++;
@@ -176,10 +215,19 @@ namespace mongo {
                             fillQueryResultFromObj(b, cc->fields.get(), js, ( cc->pq.get() && cc->pq->showDiskLoc() ? &last : 0));
                         }
 
-                        if ( ( ntoreturn && n >= ntoreturn ) || b.len() > MaxBytesToReturnToClientAtOnce ) {
-                            c->advance();
+                        if ( ( ntoreturn && n >= ntoreturn ) || b.len() > maxBytes ) {
                             cc->incPos( n );
-                            break;
+                            if ( c->tailable() && ! ( queryOptions & QueryOption_OplogReplay ) ) {
+                                // speculative read-ahead rather than stopping here.
+                                // oplog tailing is excluded: storeOpForSlave dereferences
+                                // the last delivered loc, which could have been recycled
+                                // by the time staged results go out.
+                                staging = true;
+                            }
+                            else {
+                                c->advance();
+                                break;
+                            }
                         }
                     }
                 }
@@ -198,6 +246,7 @@ namespace mongo {
                 cc->updateLocation();
                 cc->mayUpgradeStorage();
                 cc->storeOpForSlave( last );
+                cc->noteBatchSent( b.len() );
                 exhaust = cc->queryOptions() & QueryOption_Exhaust;
             }
         }
@@ -345,6 +394,88 @@ namespace mongo {
         ClientCursor::YieldData _yieldData;
     };
 
+    /* Count btree keys instead of iterating a cursor and matching every
+       document, for queries that are exactly one range on a singly indexed
+       field, e.g. { x : { $gt : 3 , $lte : 9 } }.
+
+       We stay conservative so the key count provably equals what the normal
+       plan (scan the same bounds, re-check with the matcher) would return:
+       only plain relational operators over simple scalar bounds, a single
+       field ascending/descending btree index, and no multikey - with arrays a
+       document can appear under several keys.  FieldRange supplies the same
+       type-bracketed interval a cursor would scan, and every key inside it
+       matches the predicate outright, so no document is ever fetched.
+
+       @return true if handled, with the count in 'count' */
+    static bool countViaIndexRange( const char *ns, NamespaceDetails *d, const BSONObj &query, long long &count ) {
+        if ( query.nFields() != 1 )
+            return false;
+        BSONElement e = query.firstElement();
+        if ( e.fieldName()[0] == '$' || e.type() != Object )
+            return false;
+        {
+            BSONObjIterator i( e.Obj() );
+            while ( i.more() ) {
+                BSONElement op = i.next();
+                if ( strcmp( op.fieldName(), "$gt" ) && strcmp( op.fieldName(), "$gte" ) &&
+                     strcmp( op.fieldName(), "$lt" ) && strcmp( op.fieldName(), "$lte" ) )
+                    return false;
+                switch( op.type() ) {
+                case NumberInt: case NumberLong: case NumberDouble:
+                case String: case Date: case Timestamp: case jstOID: case Bool:
+                    break;
+                default:
+                    // null, arrays, objects, regexes... have matching
+                    // subtleties the matcher owns - leave those alone
+                    return false;
+                }
+            }
+        }
+
+        int idxNo = -1;
+        for( int i = 0; i < d->nIndexes; i++ ) {
+            IndexDetails& ii = d->idx( i );
+            BSONObj kp = ii.keyPattern();
+            if ( kp.nFields() != 1 || strcmp( kp.firstElement().fieldName(), e.fieldName() ) )
+                continue;
+            if ( ii.getSpec().getType() ) // geo & friends order keys their own way
+                continue;
+            idxNo = i;
+            break;
+        }
+        if ( idxNo < 0 || d->isMultikey( idxNo ) )
+            return false;
+
+        FieldRangeSet frs( ns, query, true );
+        if ( !frs.matchPossible() ) {
+            count = 0;
+            return true;
+        }
+        const FieldRange& r = frs.range( e.fieldName() );
+        if ( r.intervals().size() != 1 )
+            return false;
+
+        IndexDetails& idx = d->idx( idxNo );
+        BSONObj lo, hi;
+        {
+            BSONObjBuilder lb, hb;
+            lb.appendAs( r.min(), "" );
+            hb.appendAs( r.max(), "" );
+            lo = lb.obj();
+            hi = hb.obj();
+        }
+        bool loInc = r.minInclusive();
+        bool hiInc = r.maxInclusive();
+        if ( idx.keyPattern().firstElement().number() < 0 ) {
+            // descending index: the range's low end is the tree's high end
+            swap( lo, hi );
+            swap( loInc, hiInc );
+        }
+        count = idx.idxInterface().countRange( idx.head, lo, loInc, hi, hiInc,
+                                               Ordering::make( idx.keyPattern() ) );
+        return true;
+    }
+
     /* { count: "collectionname"[, query: <query>] }
        returns -1 on ns does not exist error.
     */
@@ -361,6 +492,14 @@ namespace mongo {
         if ( query.isEmpty() ) {
             return applySkipLimit( d->stats.nrecords , cmd );
         }
+
+        // pure index range: count btree keys, no documents fetched
+        {
+            long long c;
+            if ( countViaIndexRange( ns, d, query, c ) )
+                return applySkipLimit( c, cmd );
+        }
+
         MultiPlanScanner mps( ns, query, BSONObj(), 0, true, BSONObj(), BSONObj(), false, true );
         CountOp original( ns , cmd );
         shared_ptr< CountOp > res = mps.runOp( original );
@@ -452,12 +591,44 @@ namespace mongo {
         int _i;
     };
 
+    /**
+     * @return true if every field of the shard key pattern appears, undotted, in the
+     * index key pattern.  chunk ownership can then be determined from the index key
+     * alone, without fetching the document.
+     */
+    static bool shardKeyCoveredByIndex( const BSONObj &shardKeyPattern, const BSONObj &indexKeyPattern ) {
+        BSONObjIterator i( shardKeyPattern );
+        while( i.more() ) {
+            BSONElement e = i.next();
+            if ( strchr( e.fieldName(), '.' ) != 0 )
+                return false;
+            if ( indexKeyPattern[ e.fieldName() ].eoo() )
+                return false;
+        }
+        return true;
+    }
+
+    /* initial size for a reply data buffer.  sized from the collection's
+       average object size and how many documents the reply can carry, so a
+       typical reply is built without growing (and copying) the buffer.
+       just an estimate - BufBuilder still grows when it's low. */
+    static int replyBufSize( const ParsedQuery& pq ) {
+        NamespaceDetails *d = nsdetails( pq.ns() );
+        if ( ! d )
+            return 512 + sizeof( QueryResult );
+        long long n = pq.getNumToReturn() ? pq.getNumToReturn() : 101;
+        long long want = 512 + sizeof( QueryResult ) + n * d->averageObjectSize();
+        if ( want > MaxBytesToReturnToClientAtOnce )
+            want = MaxBytesToReturnToClientAtOnce; // a first batch can't (usefully) exceed this
+        return (int) want;
+    }
+
     // Implements database 'query' requests using the query optimizer's QueryOp interface
     class UserQueryOp : public QueryOp {
     public:
 
         UserQueryOp( const ParsedQuery& pq, Message &response, ExplainBuilder &eb, CurOp &curop ) :
-            _buf( 32768 ) , // TODO be smarter here
+            _buf( replyBufSize( pq ) ) ,
             _pq( pq ) ,
             _ntoskip( pq.getSkip() ) ,
             _nscanned(0), _oldNscanned(0), _nscannedObjects(0), _oldNscannedObjects(0),
@@ -468,6 +639,8 @@ namespace mongo {
             _chunkManager( shardingState.needShardChunkManager(pq.ns()) ?
                            shardingState.getShardChunkManager(pq.ns()) : ShardChunkManagerPtr() ),
             _inMemSort(false),
+            _shardKeyFromIndexKey(false),
+            _chunkRangeOwned(false),
             _capped(false),
             _saveClientCursor(false),
             _wouldSaveClientCursor(false),
@@ -492,8 +665,22 @@ namespace mongo {
                 _capped = _c->capped();
 
                 // setup check for if we can only use index to extract
-                if ( _c->modifiedKeys() == false && _c->isMultiKey() == false && _pq.getFields() ) {
-                    _keyFieldsOnly.reset( _pq.getFields()->checkKey( _c->indexKeyPattern() ) );
+                if ( _c->modifiedKeys() == false && _c->isMultiKey() == false ) {
+                    if ( _pq.getFields() ) {
+                        _keyFieldsOnly.reset( _pq.getFields()->checkKey( _c->indexKeyPattern() ) );
+                    }
+                    // the chunk ownership test can also run off the index key when it
+                    // covers the shard key, so covered queries stay document-free
+                    if ( _chunkManager ) {
+                        _shardKeyFromIndexKey = shardKeyCoveredByIndex( _chunkManager->getKey(), _c->indexKeyPattern() );
+                    }
+                }
+
+                // resolve the query's range against the chunk boundaries once, at cursor
+                // creation: when everything this query can match is in owned chunks the
+                // per-document ownership test is pure overhead
+                if ( _chunkManager ) {
+                    _chunkRangeOwned = queryRangeBelongsToMe();
                 }
             }
 
@@ -558,6 +745,9 @@ namespace mongo {
         }
 
         virtual void next() {
+            // stop runaway scans within milliseconds, not at the next yield
+            uassert( 15944 , "operation exceeded time limit" , ! _curop.maxTimeExpired() );
+
             if ( _findingStartCursor.get() ) {
                 if ( !_findingStartCursor->done() ) {
                     _findingStartCursor->next();
@@ -595,7 +785,7 @@ namespace mongo {
             else {
                 _nscannedObjects++;
                 DiskLoc cl = _c->currLoc();
-                if ( _chunkManager && ! _chunkManager->belongsToMe( cl.obj() ) ) { // TODO: should make this covered at some point
+                if ( _chunkManager && ! _chunkRangeOwned && ! currentChunkBelongsToMe( cl ) ) {
                     _nChunkSkips++;
                     // log() << "TEMP skipping un-owned chunk: " << _c->current() << endl;
                 }
@@ -753,8 +943,45 @@ namespace mongo {
         }
 
         ShardChunkManagerPtr getChunkManager(){ return _chunkManager; }
+        bool chunkRangeOwned() const { return _chunkRangeOwned; }
 
     private:
+        /** resolves the query's shard key constraints against the chunk boundaries.
+            @return true if every document this query can match has its shard key in
+            ranges owned by this shard, so the per-document ownership test can be
+            skipped for the life of the cursor. */
+        bool queryRangeBelongsToMe() {
+            const FieldRangeSet& frs = qp().multikeyFrs();
+            if ( ! frs.matchPossible() )
+                return false;
+
+            // each key field must be pinned to a single interval.  shard keys are
+            // never arrays, so a matching document's key falls inside the box those
+            // intervals describe, and the box lies within [min, max] in woCompare
+            // order.  endpoints are treated as inclusive - conservative.
+            BSONObj key = _chunkManager->getKey();
+            BSONObjBuilder minb, maxb;
+            BSONForEach( k , key ) {
+                const FieldRange& r = frs.range( k.fieldName() );
+                if ( r.intervals().size() != 1 )
+                    return false;
+                minb.appendAs( r.min() , k.fieldName() );
+                maxb.appendAs( r.max() , k.fieldName() );
+            }
+            return _chunkManager->rangeBelongsToMe( minb.obj() , maxb.obj() );
+        }
+
+        /** chunk ownership test for the current cursor position.  runs off the index
+            key when it covers the shard key; only loads the document otherwise. */
+        bool currentChunkBelongsToMe( const DiskLoc &cl ) {
+            if ( _shardKeyFromIndexKey ) {
+                BSONObjBuilder bb;
+                bb.appendKeys( _c->indexKeyPattern(), _c->currKey() );
+                return _chunkManager->belongsToMe( bb.obj() );
+            }
+            return _chunkManager->belongsToMe( cl.obj() );
+        }
+
         BufBuilder _buf;
         const ParsedQuery& _pq;
         scoped_ptr<Projection::KeyOnly> _keyFieldsOnly;
@@ -775,6 +1002,8 @@ namespace mongo {
         ShardChunkManagerPtr _chunkManager;
 
         bool _inMemSort;
+        bool _shardKeyFromIndexKey;
+        bool _chunkRangeOwned;
         auto_ptr< ScanAndOrder > _so;
 
         shared_ptr<Cursor> _c;
@@ -793,6 +1022,225 @@ namespace mongo {
         OpTime _slaveReadTill;
     };
 
+    /* oplog tailing fast path
+
+       replication readers fetch oplog entries with OplogReplay queries that are
+       always the same shape: a lone 'ts' filter against a capped collection, in
+       natural order, no skip and no projection.  there is nothing for the query
+       optimizer to decide for those, and on a loaded primary every pass through
+       plan selection and UserQueryOp adds lock hold time.  instead, resolve the
+       start point directly from the capped extent structure (FindingStartCursor)
+       and stream records from there straight into the reply buffer.
+
+       the caller holds the read lock and has verified the gating conditions.
+
+       @return points to ns if exhaust mode. 0=normal mode
+    */
+    static const char *queryOplogReplay( Message &m, CurOp &curop, Message &result,
+                                         const shared_ptr<ParsedQuery> &pq_shared,
+                                         const BSONObj &jsobj, NamespaceDetails *d,
+                                         int queryOptions ) {
+        ParsedQuery &pq( *pq_shared );
+        const char *ns = pq.ns();
+        BSONObj query = pq.getFilter();
+
+        // locate the first matching op by walking the capped extents backwards,
+        // rather than scanning forward from the beginning of the collection
+        FieldRangeSetPair frsp( ns, query );
+        QueryPlan qp( d, -1, frsp, &frsp, query, BSON( "$natural" << 1 ) );
+        FindingStartCursor fsc( qp );
+        while( !fsc.done() ) {
+            RARELY {
+                if ( fsc.prepareToYield() ) {
+                    ClientCursor::staticYield( Client::recommendedYieldMicros(), ns, 0 );
+                    fsc.recoverFromYield();
+                }
+            }
+            fsc.next();
+        }
+        shared_ptr<Cursor> c = fsc.cursor();
+        // if the start point is overrun while yielded above, the cursor restarts
+        // from the beginning of the collection, so the 'ts' filter must stay on
+        c->setMatcher( shared_ptr<CoveredIndexMatcher>( new CoveredIndexMatcher( query, qp.indexKey() ) ) );
+
+        BufBuilder bb( 32768 );
+        bb.skip( sizeof( QueryResult ) );
+
+        // register the cursor so the scan below can yield
+        ClientCursor::CleanupPointer ccPointer;
+        ccPointer.reset( new ClientCursor( QueryOption_NoCursorTimeout, c, ns ) );
+
+        int n = 0;
+        OpTime slaveReadTill;
+        while( c->ok() ) {
+            // stop runaway scans within milliseconds, not at the next yield
+            uassert( 15980 , "operation exceeded time limit" , ! curop.maxTimeExpired() );
+
+            if ( !c->matcher() || c->matcher()->matchesCurrent( c.get() ) ) {
+                BSONObj js = c->current();
+                assert( js.isValid() );
+
+                BSONElement e = js["ts"];
+                if ( e.type() == Date || e.type() == Timestamp )
+                    slaveReadTill = e._opTime();
+
+                fillQueryResultFromObj( bb , 0 , js );
+                n++;
+                if ( pq.enoughForFirstBatch( n , bb.len() ) ) {
+                    if ( pq.wantMore() && pq.getNumToReturn() != 1 && useCursors ) {
+                        // more...so save a cursor
+                        c->advance();
+                    }
+                    break;
+                }
+            }
+            c->advance();
+
+            if ( ! ccPointer->yieldSometimes( ClientCursor::WillNeed ) ) {
+                // the registered cursor was dropped while we yielded; on a capped
+                // collection that means the reader was overrun
+                msgassertedNoTrace( 15979, str::stream() << "capped cursor overrun during oplog query: " << ns );
+            }
+        }
+        long long nscanned = c->nscanned();
+        ccPointer.reset();
+
+        long long cursorid = 0;
+        const char *exhaust = 0;
+        if ( pq.hasOption( QueryOption_CursorTailable ) )
+            c->setTailable();
+        if ( c->tailable() || ( c->ok() && pq.wantMore() && useCursors ) ) {
+            ClientCursor *cc = new ClientCursor( queryOptions, c, ns, jsobj.getOwned() );
+            cursorid = cc->cursorid();
+            DEV tlog(2) << "oplog query has more, cursorid: " << cursorid << endl;
+            cc->setPos( n );
+            cc->pq = pq_shared;
+            cc->fields = pq.getFieldPtr();
+            cc->originalMessage = m;
+            cc->updateLocation();
+            if ( ! slaveReadTill.isNull() )
+                cc->slaveReadTill( slaveReadTill );
+            if ( queryOptions & QueryOption_Exhaust ) {
+                exhaust = ns;
+                curop.debug().exhaust = true;
+            }
+        }
+
+        auto_ptr< QueryResult > qr;
+        qr.reset( (QueryResult *) bb.buf() );
+        bb.decouple();
+        qr->setResultFlagsToOk();
+        qr->len = bb.len();
+        curop.debug().responseLength = bb.len();
+        qr->setOperation(opReply);
+        qr->cursorId = cursorid;
+        qr->startingFrom = 0;
+        qr->nReturned = n;
+        result.setData( qr.release(), true );
+
+        int duration = curop.elapsedMillis();
+        if ( curop.shouldDBProfile( duration ) || duration >= cmdLine.slowMS ) {
+            curop.debug().nscanned = (int) nscanned;
+        }
+        curop.debug().nreturned = n;
+        return exhaust;
+    }
+
+    /* whole collection streaming fast path
+
+       internal bulk readers - the cloner, initial sync, mongodump - issue bare
+       {} queries in natural order with no skip and no projection.  running
+       those through plan selection, a Matcher and per document response
+       shaping roughly doubles the cpu of what is really a byte copy.  here we
+       walk the records in natural order and append each record's payload to
+       the reply buffer as is; a bson document is already length prefixed, so
+       the raw record bytes are the wire framing.
+
+       the caller holds the read lock and has verified the gating conditions
+       (empty filter, natural order, no skip/projection, ns not sharded).
+
+       @return points to ns if exhaust mode. 0=normal mode
+    */
+    static const char *queryRawScan( Message &m, CurOp &curop, Message &result,
+                                     const shared_ptr<ParsedQuery> &pq_shared,
+                                     const BSONObj &jsobj, int queryOptions ) {
+        ParsedQuery &pq( *pq_shared );
+        const char *ns = pq.ns();
+
+        shared_ptr<Cursor> c = findTableScan( ns , BSONObj() );
+
+        BufBuilder bb( replyBufSize( pq ) );
+        bb.skip( sizeof( QueryResult ) );
+
+        // register the cursor so the scan below can yield
+        ClientCursor::CleanupPointer ccPointer;
+        ccPointer.reset( new ClientCursor( QueryOption_NoCursorTimeout, c, ns ) );
+
+        int n = 0;
+        bool killed = false;
+        while( c->ok() ) {
+            // stop runaway scans within milliseconds, not at the next yield
+            uassert( 15994 , "operation exceeded time limit" , ! curop.maxTimeExpired() );
+
+            const char *data = c->currLoc().rec()->data;
+            int len = *reinterpret_cast<const int*>( data );
+            massert( 15995 , "invalid object size in raw scan - object corrupt?" ,
+                     len >= 5 && len <= BSONObjMaxInternalSize );
+            bb.appendBuf( data , len );
+            n++;
+            if ( pq.enoughForFirstBatch( n , bb.len() ) ) {
+                if ( pq.wantMore() && pq.getNumToReturn() != 1 && useCursors ) {
+                    // more...so save a cursor
+                    c->advance();
+                }
+                break;
+            }
+            c->advance();
+
+            if ( ! ccPointer->yieldSometimes( ClientCursor::WillNeed ) ) {
+                // the registered cursor was dropped while we yielded (collection
+                // drop); return what was gathered and don't touch the cursor again
+                killed = true;
+                break;
+            }
+        }
+        ccPointer.reset();
+
+        long long cursorid = 0;
+        const char *exhaust = 0;
+        if ( !killed && c->ok() && pq.wantMore() && useCursors ) {
+            ClientCursor *cc = new ClientCursor( queryOptions, c, ns, jsobj.getOwned() );
+            cursorid = cc->cursorid();
+            DEV tlog(2) << "raw scan has more, cursorid: " << cursorid << endl;
+            cc->setPos( n );
+            cc->pq = pq_shared;
+            cc->fields = pq.getFieldPtr();
+            cc->originalMessage = m;
+            cc->updateLocation();
+            if ( queryOptions & QueryOption_Exhaust ) {
+                exhaust = ns;
+                curop.debug().exhaust = true;
+            }
+        }
+
+        auto_ptr< QueryResult > qr;
+        qr.reset( (QueryResult *) bb.buf() );
+        bb.decouple();
+        qr->setResultFlagsToOk();
+        qr->len = bb.len();
+        curop.debug().responseLength = bb.len();
+        qr->setOperation(opReply);
+        qr->cursorId = cursorid;
+        qr->startingFrom = 0;
+        qr->nReturned = n;
+        result.setData( qr.release(), true );
+
+        // no filter, so every scanned record was returned
+        curop.debug().nscanned = n;
+        curop.debug().nreturned = n;
+        return exhaust;
+    }
+
     /* run a query -- includes checking for and running a Command \
        @return points to ns if exhaust mode. 0=normal mode
     */
@@ -811,10 +1259,16 @@ namespace mongo {
         curop.debug().ntoreturn = pq.getNumToReturn();
         curop.setQuery(jsobj);
 
+        if ( pq.getMaxTimeMS() > 0 )
+            curop.setMaxTimeMicros( 1000ULL * pq.getMaxTimeMS() );
+
         if ( pq.couldBeCommand() ) {
             BufBuilder bb;
             bb.skip(sizeof(QueryResult));
-            BSONObjBuilder cmdResBuf;
+            // the reply document is built in place in the message buffer; building
+            // it in a standalone BSONObjBuilder and copying the finished object in
+            // doubled the work for large command replies
+            BSONObjBuilder cmdResBuf( bb );
             if ( runCommands(ns, jsobj, curop, bb, cmdResBuf, false, queryOptions) ) {
                 curop.debug().iscommand = true;
                 curop.debug().query = jsobj;
@@ -866,6 +1320,88 @@ namespace mongo {
 
         replVerifyReadsOk(pq);
 
+        /* point read by _id - straight to the index and into the reply buffer,
+           skipping plan selection and cursor setup entirely.  the common case
+           for many workloads. */
+        if ( ! (explain || pq.showDiskLoc()) && isSimpleIdQuery( query ) &&
+             pq.getSkip() == 0 && !pq.hasOption( QueryOption_CursorTailable ) ) {
+
+            bool nsFound = false;
+            bool indexFound = false;
+            bool covered = false;
+
+            BSONObj resObject;
+            Client& c = cc();
+            bool found = false;
+            if ( pq.getFields() ) {
+                /* covered point read: if an _id prefixed index contains every
+                   projected field, answer from the index key alone.  a small
+                   document kept entirely in such an index is then read with
+                   half the page touches - the btree leaf, but no record. */
+                NamespaceDetails *d = nsdetails( ns );
+                if ( d ) {
+                    NamespaceDetails::IndexIterator ii = d->ii();
+                    while( ii.more() ) {
+                        int idxNo = ii.pos();
+                        IndexDetails &idx = ii.next();
+                        if ( !str::equals( idx.keyPattern().firstElementFieldName(), "_id" ) ||
+                             d->isMultikey( idxNo ) ) {
+                            continue;
+                        }
+                        scoped_ptr<Projection::KeyOnly> keyFieldsOnly( pq.getFields()->checkKey( idx.keyPattern() ) );
+                        if ( !keyFieldsOnly ) {
+                            continue;
+                        }
+                        // equality on _id; the trailing key fields are unbounded
+                        BSONObjBuilder startb, endb;
+                        startb.appendAs( query["_id"], "" );
+                        endb.appendAs( query["_id"], "" );
+                        BSONObjIterator k( idx.keyPattern() );
+                        k.next();
+                        while( k.more() ) {
+                            k.next();
+                            startb.appendMinKey( "" );
+                            endb.appendMaxKey( "" );
+                        }
+                        scoped_ptr<BtreeCursor> bc( BtreeCursor::make( d, idxNo, idx, startb.obj(), endb.obj(), true, 1 ) );
+                        if ( bc->ok() ) {
+                            resObject = keyFieldsOnly->hydrate( bc->currKey() );
+                            found = true;
+                        }
+                        nsFound = indexFound = covered = true;
+                        break;
+                    }
+                }
+            }
+            if ( !covered ) {
+                found = Helpers::findById( c, ns , query , resObject , &nsFound , &indexFound );
+            }
+            if ( nsFound == false || indexFound == true ) {
+                BufBuilder bb(sizeof(QueryResult)+resObject.objsize()+32);
+                bb.skip(sizeof(QueryResult));
+
+                curop.debug().idhack = true;
+                if ( found ) {
+                    n = 1;
+                    // a covered result is already projected
+                    fillQueryResultFromObj( bb , covered ? 0 : pq.getFields() , resObject );
+                }
+                auto_ptr< QueryResult > qr;
+                qr.reset( (QueryResult *) bb.buf() );
+                bb.decouple();
+                qr->setResultFlagsToOk();
+                qr->len = bb.len();
+
+                curop.debug().responseLength = bb.len();
+                qr->setOperation(opReply);
+                qr->cursorId = 0;
+                qr->startingFrom = 0;
+                qr->nReturned = n;
+                result.setData( qr.release(), true );
+                return NULL;
+            }
+        }
+
         if ( pq.hasOption( QueryOption_CursorTailable ) ) {
             NamespaceDetails *d = nsdetails( ns );
             uassert( 13051, "tailable cursor requested on non capped collection", d && d->capped );
@@ -878,6 +1414,37 @@ namespace mongo {
             }
         }
 
+        /* oplog tailing - bypass the query optimizer entirely when the query is
+           the canonical replication fetch: a bare { ts : ... } filter against
+           the oplog in natural order.  see queryOplogReplay() above. */
+        if ( pq.hasOption( QueryOption_OplogReplay ) &&
+             str::startsWith( ns, "local.oplog." ) &&
+             !explain && !snapshot && !pq.showDiskLoc() && !pq.returnKey() &&
+             !pq.getFields() && !pq.hasIndexSpecifier() &&
+             pq.getSkip() == 0 && pq.getNumToReturn() != 1 && pq.getMaxScan() == 0 &&
+             query.nFields() == 1 && str::equals( query.firstElementFieldName(), "ts" ) &&
+             ( order.isEmpty() || order == BSON( "$natural" << 1 ) ) ) {
+            NamespaceDetails *d = nsdetails( ns );
+            if ( d && d->capped ) {
+                return queryOplogReplay( m, curop, result, pq_shared, jsobj, d, queryOptions );
+            }
+        }
+
+        /* whole collection streaming - the cloner, initial sync and dumps issue
+           bare {} queries in natural order; stream the record bytes straight
+           into the reply buffer without a matcher or response shaping.  see
+           queryRawScan() above. */
+        if ( !explain && !snapshot && !pq.showDiskLoc() && !pq.returnKey() &&
+             !pq.getFields() && !pq.hasIndexSpecifier() &&
+             pq.getSkip() == 0 && pq.getMaxScan() == 0 &&
+             !pq.hasOption( QueryOption_CursorTailable ) &&
+             query.isEmpty() &&
+             ( order.isEmpty() || order == BSON( "$natural" << 1 ) ) &&
+             !shardingState.needShardChunkManager( ns ) &&
+             nsdetails( ns ) ) {
+            return queryRawScan( m, curop, result, pq_shared, jsobj, queryOptions );
+        }
+
         BSONObj snapshotHint; // put here to keep the data in scope
         if( snapshot ) {
             NamespaceDetails *d = nsdetails(ns);
@@ -900,39 +1467,6 @@ namespace mongo {
             }
         }
 
-        if ( ! (explain || pq.showDiskLoc()) && isSimpleIdQuery( query ) && !pq.hasOption( QueryOption_CursorTailable ) ) {
-
-            bool nsFound = false;
-            bool indexFound = false;
-
-            BSONObj resObject;
-            Client& c = cc();
-            bool found = Helpers::findById( c, ns , query , resObject , &nsFound , &indexFound );
-            if ( nsFound == false || indexFound == true ) {
-                BufBuilder bb(sizeof(QueryResult)+resObject.objsize()+32);
-                bb.skip(sizeof(QueryResult));
-                
-                curop.debug().idhack = true;
-                if ( found ) {
-                    n = 1;
-                    fillQueryResultFromObj( bb , pq.getFields() , resObject );
-                }
-                auto_ptr< QueryResult > qr;
-                qr.reset( (QueryResult *) bb.buf() );
-                bb.decouple();
-                qr->setResultFlagsToOk();
-                qr->len = bb.len();
-                
-                curop.debug().responseLength = bb.len();
-                qr->setOperation(opReply);
-                qr->cursorId = 0;
-                qr->startingFrom = 0;
-                qr->nReturned = n;
-                result.setData( qr.release(), true );
-                return NULL;
-            }
-        }
-
         // regular, not QO bypass query
 
         BSONObj oldPlan;
@@ -941,7 +1475,10 @@ namespace mongo {
             if ( mps.usingPrerecordedPlan() )
                 oldPlan = mps.oldExplain();
         }
-        auto_ptr< MultiPlanScanner > mps( new MultiPlanScanner( ns, query, order, &hint, !explain, pq.getMin(), pq.getMax(), false, true ) );
+        // micro-queries: hand the plan set the limit so a provably short scan can
+        // skip the per advance yield bookkeeping entirely
+        int numWanted = ( !explain && pq.getNumToReturn() ) ? pq.getSkip() + pq.getNumToReturn() : 0;
+        auto_ptr< MultiPlanScanner > mps( new MultiPlanScanner( ns, query, order, &hint, !explain, pq.getMin(), pq.getMax(), false, true, numWanted ) );
         BSONObj explainSuffix;
         if ( explain ) {
             BSONObjBuilder bb;
@@ -980,7 +1517,11 @@ namespace mongo {
                 cc = new ClientCursor( queryOptions, cursor, ns, jsobj.getOwned() );
             }
 
-            cc->setChunkManager( dqo.getChunkManager() );
+            // a cursor whose whole range resolved as owned at creation never needs the
+            // per-document test in getMore either.  $or clauses to come may cover other
+            // ranges though, so only drop the manager when this was the last clause.
+            if ( moreClauses || ! dqo.chunkRangeOwned() )
+                cc->setChunkManager( dqo.getChunkManager() );
 
             cursorid = cc->cursorid();
             DEV tlog(2) << "query has more, cursorid: " << cursorid << endl;
@@ -102,6 +102,7 @@ namespace mongo {
         const BSONObj& getOrder() const { return _order; }
         const BSONElement& getHint() const { return _hint; }
         int getMaxScan() const { return _maxScan; }
+        int getMaxTimeMS() const { return _maxTimeMS; }
 
         bool couldBeCommand() const {
             /* we assume you are using findOne() for running a cmd... */
@@ -166,6 +167,7 @@ namespace mongo {
             _returnKey = false;
             _showDiskLoc = false;
             _maxScan = 0;
+            _maxTimeMS = 0;
         }
 
         void _initTop( const BSONObj& top ) {
@@ -204,6 +206,8 @@ namespace mongo {
                         _returnKey = e.trueValue();
                     else if ( strcmp( "maxScan" , name ) == 0 )
                         _maxScan = e.numberInt();
+                    else if ( strcmp( "maxTimeMS" , name ) == 0 )
+                        _maxTimeMS = e.numberInt();
                     else if ( strcmp( "showDiskLoc" , name ) == 0 )
                         _showDiskLoc = e.trueValue();
                     else if ( strcmp( "comment" , name ) == 0 ) {
@@ -242,6 +246,7 @@ namespace mongo {
         BSONObj _max;
         BSONElement _hint;
         int _maxScan;
+        int _maxTimeMS;
     };
 
 
@@ -969,57 +969,13 @@ namespace mongo {
         uassert( 12522 , "$ operator made object too large" , newObj.objsize() <= BSONObjMaxUserSize );
     }
 
-    /* note: this is only (as-is) called for
-
-             - not multi
-             - not mods is indexed
-             - not upsert
-    */
-    static UpdateResult _updateById(bool isOperatorUpdate, int idIdxNo, ModSet *mods, int profile, NamespaceDetails *d,
-                                    NamespaceDetailsTransient *nsdt,
-                                    bool god, const char *ns,
-                                    const BSONObj& updateobj, BSONObj patternOrig, bool logop, OpDebug& debug) {
-
-        DiskLoc loc;
-        {
-            IndexDetails& i = d->idx(idIdxNo);
-            BSONObj key = i.getKeyFromQuery( patternOrig );            
-            loc = i.idxInterface().findSingle(i, i.head, key);
-            if( loc.isNull() ) {
-                // no upsert support in _updateById yet, so we are done.
-                return UpdateResult(0, 0, 0);
-            }
-        }
+    /* apply an update to the document at 'loc'.  the caller has already
+       established that the document matches the query pattern. */
+    static UpdateResult _updateAtLoc(const DiskLoc& loc, bool isOperatorUpdate, ModSet *mods, NamespaceDetails *d,
+                                     NamespaceDetailsTransient *nsdt, const char *ns,
+                                     const BSONObj& updateobj, const BSONObj& patternOrig, bool logop, OpDebug& debug) {
         Record *r = loc.rec();
 
-        if ( ! r->likelyInPhysicalMemory() ) {
-            {
-                auto_ptr<RWLockRecursive::Shared> lk( new RWLockRecursive::Shared( MongoFile::mmmutex) );
-                dbtempreleasewritelock t;
-                r->touch();
-                lk.reset(0); // we have to release mmmutex before we can re-acquire dbmutex
-            }
-            
-            {
-                // we need to re-find in case something changed
-                d = nsdetails( ns );
-                if ( ! d ) {
-                    // dropped 
-                    return UpdateResult(0, 0, 0);
-                }
-                nsdt = &NamespaceDetailsTransient::get_w(ns);
-                IndexDetails& i = d->idx(idIdxNo);
-                BSONObj key = i.getKeyFromQuery( patternOrig );            
-                loc = i.idxInterface().findSingle(i, i.head, key);
-                if( loc.isNull() ) {
-                    // no upsert support in _updateById yet, so we are done.
-                    return UpdateResult(0, 0, 0);
-                }
-                
-                r = loc.rec();
-            }
-        }
-
         /* look for $inc etc.  note as listed here, all fields to inc must be this type, you can't set some
            regular ones at the moment. */
         if ( isOperatorUpdate ) {
@@ -1070,6 +1026,83 @@ namespace mongo {
         return UpdateResult( 1 , 0 , 1 );
     }
 
+    /* note: this is only (as-is) called for
+
+             - not multi
+             - not mods is indexed
+             - not upsert
+    */
+    static UpdateResult _updateById(bool isOperatorUpdate, int idIdxNo, ModSet *mods, int profile, NamespaceDetails *d,
+                                    NamespaceDetailsTransient *nsdt,
+                                    bool god, const char *ns,
+                                    const BSONObj& updateobj, BSONObj patternOrig, bool logop, OpDebug& debug) {
+
+        DiskLoc loc;
+        {
+            IndexDetails& i = d->idx(idIdxNo);
+            BSONObj key = i.getKeyFromQuery( patternOrig );            
+            loc = i.idxInterface().findSingle(i, i.head, key);
+            if( loc.isNull() ) {
+                // no upsert support in _updateById yet, so we are done.
+                return UpdateResult(0, 0, 0);
+            }
+        }
+        Record *r = loc.rec();
+
+        bool inMemory = r->likelyInPhysicalMemory();
+        Top::global.faultCheck( ns , inMemory );
+        if ( ! inMemory ) {
+            {
+                auto_ptr<RWLockRecursive::Shared> lk( new RWLockRecursive::Shared( MongoFile::mmmutex) );
+                dbtempreleasewritelock t;
+                r->touch();
+                lk.reset(0); // we have to release mmmutex before we can re-acquire dbmutex
+            }
+            
+            {
+                // we need to re-find in case something changed
+                d = nsdetails( ns );
+                if ( ! d ) {
+                    // dropped 
+                    return UpdateResult(0, 0, 0);
+                }
+                nsdt = &NamespaceDetailsTransient::get_w(ns);
+                IndexDetails& i = d->idx(idIdxNo);
+                BSONObj key = i.getKeyFromQuery( patternOrig );            
+                loc = i.idxInterface().findSingle(i, i.head, key);
+                if( loc.isNull() ) {
+                    // no upsert support in _updateById yet, so we are done.
+                    return UpdateResult(0, 0, 0);
+                }
+            }
+        }
+
+        return _updateAtLoc( loc, isOperatorUpdate, mods, d, nsdt, ns, updateobj, patternOrig, logop, debug );
+    }
+
+    /* shared_ptr deleter that also holds the owned update object - the parsed
+       mods keep pointers into its bytes, so the two must live and die
+       together even if the cache entry itself is evicted mid-use */
+    struct ModSetWithObjDeleter {
+        BSONObj obj;
+        void operator()( ModSet *p ) { delete p; }
+    };
+
+    shared_ptr<ModSet> NamespaceDetailsTransient::cachedModSet( const BSONObj& updateobj ) {
+        string key( updateobj.objdata() , updateobj.objsize() );
+        map< string, shared_ptr<ModSet> >::iterator i = _modSetCache.find( key );
+        if ( i != _modSetCache.end() )
+            return i->second;
+        if ( _modSetCache.size() >= MaxCachedModSets )
+            _modSetCache.clear();
+        ModSetWithObjDeleter holder;
+        holder.obj = updateobj.getOwned();
+        // parse errors throw here, before anything is cached
+        shared_ptr<ModSet> mods( new ModSet( holder.obj , indexKeys() ) , holder );
+        _modSetCache[ key ] = mods;
+        return mods;
+    }
+
     UpdateResult _updateObjects(bool god, const char *ns, const BSONObj& updateobj, BSONObj patternOrig, bool upsert, bool multi, bool logop , OpDebug& debug, RemoveSaver* rs ) {
         DEBUGUPDATE( "update: " << ns << " update: " << updateobj << " query: " << patternOrig << " upsert: " << upsert << " multi: " << multi );
         Client& client = cc();
@@ -1082,7 +1115,7 @@ namespace mongo {
         NamespaceDetails *d = nsdetails(ns); // can be null if an upsert...
         NamespaceDetailsTransient *nsdt = &NamespaceDetailsTransient::get_w(ns);
 
-        auto_ptr<ModSet> mods;
+        shared_ptr<ModSet> mods;
         bool isOperatorUpdate = updateobj.firstElementFieldName()[0] == '$';
         int modsIsIndexed = false; // really the # of indexes
         if ( isOperatorUpdate ) {
@@ -1092,7 +1125,11 @@ namespace mongo {
                 mods.reset( new ModSet(updateobj, nsdt->indexKeys(), &bgKeys) );
             }
             else {
-                mods.reset( new ModSet(updateobj, nsdt->indexKeys()) );
+                // the same update document recurs constantly in $inc / $set
+                // style traffic; reuse the parsed mods rather than rebuilding
+                // them under the write lock each time.  a ModSet is immutable
+                // once constructed so sharing across ops (and yields) is safe.
+                mods = nsdt->cachedModSet( updateobj );
             }
             modsIsIndexed = mods->isIndexed();
         }
@@ -1116,8 +1153,34 @@ namespace mongo {
             }
         }
 
+        /* dedup style workloads upsert the same keys over and over; after the
+           first one inserts, every later "miss" is really a hit.  try the
+           namespace's recently upserted location before paying for a full
+           query.  the hint is only trusted once the record it points at
+           matches the pattern, and deleteRecord drops hints to records it
+           removes, so a stale entry can never resurrect a dead document. */
+        if ( upsert && ! multi && ! modsIsIndexed && d && ! d->capped &&
+             ! ( mods.get() && mods->hasDynamicArray() ) ) {
+            DiskLoc cachedLoc = nsdt->upsertLoc( patternOrig );
+            if ( ! cachedLoc.isNull() && Matcher( patternOrig ).matches( cachedLoc.obj() ) ) {
+                if ( profile )
+                    debug.nscanned = 0;
+                return _updateAtLoc( cachedLoc, isOperatorUpdate, mods.get(), d, nsdt, ns, updateobj, patternOrig, logop, debug );
+            }
+        }
+
         int numModded = 0;
         long long nscanned = 0;
+
+        /* for a multi update touching indexed fields, batch the (non-unique)
+           index key changes and apply them index-by-index in key order instead
+           of re-entering every index once per document.  the batch never spans
+           a yield - it is flushed (with the cursor location noted) before the
+           lock is given up. */
+        auto_ptr<IndexUpdateBatch> batch;
+        if ( multi && isOperatorUpdate && modsIsIndexed )
+            batch.reset( new IndexUpdateBatch() );
+
         shared_ptr< MultiCursor::CursorOp > opPtr( new UpdateOp( mods.get() && mods->hasDynamicArray() ) );
         shared_ptr< MultiCursor > c( new MultiCursor( ns, patternOrig, BSONObj(), opPtr, true ) );
 
@@ -1135,11 +1198,20 @@ namespace mongo {
                 
                 if ( !atomic ) {
                     // *****************
+                    if ( batch.get() && batch->pending() ) {
+                        if ( cc.get() )
+                            cc->updateLocation();
+                        else
+                            c->noteLocation();
+                        batch->flush( d );
+                        c->checkLocation();
+                    }
+
                     if ( cc.get() == 0 ) {
                         shared_ptr< Cursor > cPtr = c;
                         cc.reset( new ClientCursor( QueryOption_NoCursorTimeout , cPtr , ns ) );
                     }
-    
+
                     bool didYield;
                     if ( ! cc->yieldSometimes( ClientCursor::WillNeed, &didYield ) ) {
                         cc.release();
@@ -1244,6 +1316,7 @@ namespace mongo {
                             c->noteLocation();
                     }
 
+                    DiskLoc updatedLoc = loc;
                     if ( modsIsIndexed <= 0 && mss->canApplyInPlace() ) {
                         mss->applyModsInPlace( true );// const_cast<BSONObj&>(onDisk) );
 
@@ -1261,7 +1334,8 @@ namespace mongo {
 
                         BSONObj newObj = mss->createNewFromMods();
                         checkTooLarge(newObj);
-                        DiskLoc newLoc = theDataFileMgr.updateRecord(ns, d, nsdt, r, loc , newObj.objdata(), newObj.objsize(), debug);
+                        DiskLoc newLoc = theDataFileMgr.updateRecord(ns, d, nsdt, r, loc , newObj.objdata(), newObj.objsize(), debug, false, batch.get());
+                        updatedLoc = newLoc;
                         if ( newLoc != loc || modsIsIndexed ) {
                             // object moved, need to make sure we don' get again
                             seenObjects.insert( newLoc );
@@ -1288,8 +1362,11 @@ namespace mongo {
                         }
                     }
                     numModded++;
-                    if ( ! multi )
+                    if ( ! multi ) {
+                        if ( upsert && d && ! d->capped )
+                            nsdt->notedUpsert( patternOrig, updatedLoc );
                         return UpdateResult( 1 , 1 , numModded );
+                    }
                     if ( indexHack )
                         c->checkLocation();
 
@@ -1298,6 +1375,11 @@ namespace mongo {
                             shared_ptr< Cursor > cPtr = c;
                             cc.reset( new ClientCursor( QueryOption_NoCursorTimeout , cPtr , ns ) );
                         }
+                        if ( batch.get() && batch->pending() ) {
+                            cc->updateLocation();
+                            batch->flush( d );
+                            c->checkLocation();
+                        }
                         if ( ! cc->yield() ) {
                             cc.release();
                             break;
@@ -1318,15 +1400,20 @@ namespace mongo {
 
                 BSONElementManipulator::lookForTimestamps( updateobj );
                 checkNoMods( updateobj );
-                theDataFileMgr.updateRecord(ns, d, nsdt, r, loc , updateobj.objdata(), updateobj.objsize(), debug, god);
+                DiskLoc newLoc = theDataFileMgr.updateRecord(ns, d, nsdt, r, loc , updateobj.objdata(), updateobj.objsize(), debug, god);
                 if ( logop ) {
                     DEV wassert( !god ); // god doesn't get logged, this would be bad.
                     logOp("u", ns, updateobj, &pattern );
                 }
+                if ( upsert && d && ! d->capped )
+                    nsdt->notedUpsert( patternOrig, newLoc );
                 return UpdateResult( 1 , 0 , 1 );
             } while ( c->ok() );
         } // endif
 
+        if ( batch.get() && batch->pending() )
+            batch->flush( d );
+
         if ( numModded )
             return UpdateResult( 1 , 1 , numModded );
 
@@ -1339,19 +1426,26 @@ namespace mongo {
                 BSONObj newObj = mods->createNewFromQuery( patternOrig );
                 checkNoMods( newObj );
                 debug.fastmodinsert = true;
-                theDataFileMgr.insertWithObjMod(ns, newObj, god);
+                DiskLoc newLoc = theDataFileMgr.insertWithObjMod(ns, newObj, god);
                 if ( logop )
                     logOp( "i", ns, newObj );
 
+                // remember where this landed so the next upsert of the same
+                // key skips the query.  get_w afresh - the insert may have
+                // just created the collection.
+                if ( ! multi && ! newLoc.isNull() )
+                    NamespaceDetailsTransient::get_w( ns ).notedUpsert( patternOrig, newLoc );
                 return UpdateResult( 0 , 1 , 1 , newObj );
             }
             uassert( 10159 ,  "multi update only works with $ operators" , ! multi );
             checkNoMods( updateobj );
             debug.upsert = true;
             BSONObj no = updateobj;
-            theDataFileMgr.insertWithObjMod(ns, no, god);
+            DiskLoc newLoc = theDataFileMgr.insertWithObjMod(ns, no, god);
             if ( logop )
                 logOp( "i", ns, no );
+            if ( ! newLoc.isNull() )
+                NamespaceDetailsTransient::get_w( ns ).notedUpsert( patternOrig, newLoc );
             return UpdateResult( 0 , 0 , 1 , no );
         }
         return UpdateResult( 0 , 0 , 0 );
@@ -46,6 +46,7 @@ _ disallow system* manipulations from the database.
 #include "ops/delete.h"
 #include "instance.h"
 #include "replutil.h"
+#include "stats/indexstats.h"
 
 namespace mongo {
 
@@ -74,6 +75,7 @@ namespace mongo {
         }
     };
 
+    mongo::mutex BackgroundOperation::m("bgOpInProg");
     map<string, unsigned> BackgroundOperation::dbsInProg;
     set<string> BackgroundOperation::nsInProg;
 
@@ -99,6 +101,7 @@ namespace mongo {
 
     BackgroundOperation::BackgroundOperation(const char *ns) : _ns(ns) {
         assertInWriteLock();
+        scoped_lock lk(m);
         dbsInProg[_ns.db]++;
         assert( nsInProg.count(_ns.ns()) == 0 );
         nsInProg.insert(_ns.ns());
@@ -106,11 +109,13 @@ namespace mongo {
 
     BackgroundOperation::~BackgroundOperation() {
         wassert( dbMutex.isWriteLocked() );
+        scoped_lock lk(m);
         dbsInProg[_ns.db]--;
         nsInProg.erase(_ns.ns());
     }
 
     void BackgroundOperation::dump(stringstream& ss) {
+        scoped_lock lk(m);
         if( nsInProg.size() ) {
             ss << "\n<b>Background Jobs in Progress</b>\n";
             for( set<string>::iterator i = nsInProg.begin(); i != nsInProg.end(); i++ )
@@ -236,6 +241,19 @@ namespace mongo {
             }
         }
 
+        // uniform slot allocation for capped collections - every record is allocated
+        // 'slotSize' bytes so inserts reuse freed space O(1) with no freelist scan or
+        // compact().  only sensible when the documents are all about the same size.
+        int slotSize = 0;
+        if ( options["slotSize"].isNumber() ) {
+            uassert( 15923, "slotSize is only allowed on capped collections", newCapped );
+            long long s = options["slotSize"].numberLong();
+            uassert( 15924, "create collection invalid slotSize spec",
+                     s >= 5 && s <= BSONObjMaxUserSize ); // 5 = empty bson obj
+            // the option is the max document size; a slot holds that plus the record header
+            slotSize = ( (int) s + Record::HeaderSize + 3 ) & 0xfffffffc;
+        }
+
         // $nExtents just for debug/testing.
         BSONElement e = options.getField( "$nExtents" );
         Database *database = cc().database();
@@ -303,10 +321,13 @@ namespace mongo {
         if ( mx > 0 )
             getDur().writingInt( d->max ) = mx;
 
+        if ( slotSize > 0 )
+            *getDur().writing( &d->cappedSlotSize ) = (unsigned) slotSize;
+
         return true;
     }
 
-    /** { ..., capped: true, size: ..., max: ... }
+    /** { ..., capped: true, size: ..., max: ..., slotSize: ... }
         @param deferIdIndex - if not not, defers id index creation.  sets the bool value to true if we wanted to create the id index.
         @return true if successful
     */
@@ -367,7 +388,7 @@ namespace mongo {
         return size;
     }
 
-    void MongoDataFile::open( const char *filename, int minSize, bool preallocateOnly ) {
+    long MongoDataFile::chooseSize( const char *filename, int minSize ) const {
         long size = defaultSize( filename );
         while ( size < minSize ) {
             if ( size < maxSize() / 2 )
@@ -382,34 +403,189 @@ namespace mongo {
 
         assert( size >= 64*1024*1024 || cmdLine.smallfiles );
         assert( size % 4096 == 0 );
+        return size;
+    }
 
+    void MongoDataFile::open( const char *filename, int minSize, bool preallocateOnly ) {
         if ( preallocateOnly ) {
+            long size = chooseSize( filename, minSize );
             if ( cmdLine.prealloc ) {
                 FileAllocator::get()->requestAllocation( filename, size );
             }
             return;
         }
+        openMapOnly( filename, minSize );
+        finishOpen();
+    }
 
+    void MongoDataFile::openMapOnly( const char *filename, int minSize ) {
+        long size = chooseSize( filename, minSize );
         {
             assert( _mb == 0 );
             unsigned long long sz = size;
             if( mmf.create(filename, sz, false) )
                 _mb = mmf.getView();
             assert( sz <= 0x7fffffff );
-            size = (int) sz;
         }
         //header = (DataFileHeader *) _p;
         if( sizeof(char *) == 4 )
             uassert( 10084 , "can't map file memory - mongo requires 64 bit build for larger datasets", _mb != 0);
         else
             uassert( 10085 , "can't map file memory", _mb != 0);
-        header()->init(fileNo, size, filename);
+    }
+
+    void MongoDataFile::finishOpen() {
+        assert( _mb != 0 );
+        header()->init(fileNo, (int) mmf.length(), mmf.filename().c_str());
     }
 
     void MongoDataFile::flush( bool sync ) {
         mmf.flush( sync );
     }
 
+    void MongoDataFile::flagAccessPattern( int advice ) {
+        if ( advice == _accessPattern || _mb == 0 )
+            return;
+        // benign race - worst case an extra madvise, the kernel applies whichever lands last
+        _accessPattern = advice;
+        MAdvise::flag( _mb , mmf.length() , advice );
+    }
+
+    /*---------------------------------------------------------------------*/
+
+    DataFileWarmer* DataFileWarmer::_instance = 0;
+
+    DataFileWarmer* DataFileWarmer::get() {
+        // lazy init without locking is fine - all callers hold the write lock
+        if ( _instance == 0 )
+            _instance = new DataFileWarmer();
+        return _instance;
+    }
+
+    DataFileWarmer::DataFileWarmer()
+        : _mutex( "DataFileWarmer" ), _queuedNo( 0 ), _queuedMin( 0 ),
+          _discardInflight( false ), _standby( 0 ), _started( false ) {
+    }
+
+    void DataFileWarmer::emptyTrash() {
+        // with --dur, closing a mapped file commits the journal, which the
+        // warmer thread can't do - so it trashes and we free here instead
+        for ( unsigned i = 0; i < _trash.size(); i++ )
+            delete _trash[i];
+        _trash.clear();
+    }
+
+    void DataFileWarmer::request( const string &filename, int n, int minSize ) {
+        dbMutex.assertWriteLocked();
+        scoped_lock lk( _mutex );
+        emptyTrash();
+        if ( !_queuedName.empty() || !_inflightName.empty() )
+            return; // one file at a time - boundary crossings are rare
+        if ( _standby ) {
+            if ( _standbyName == filename )
+                return; // already warm
+            // standby is for some other file; the most recently growing db is
+            // the better bet, so replace it (its file stays preallocated on
+            // disk and gets a normal open if ever needed)
+            delete _standby;
+            _standby = 0;
+            _standbyName.clear();
+        }
+        _queuedName = filename;
+        _queuedNo = n;
+        _queuedMin = minSize;
+        if ( !_started ) {
+            _started = true;
+            go();
+        }
+        _updated.notify_all();
+    }
+
+    MongoDataFile* DataFileWarmer::take( const string &filename, int minSize ) {
+        dbMutex.assertWriteLocked();
+        scoped_lock lk( _mutex );
+        emptyTrash();
+        if ( _standby == 0 || _standbyName != filename )
+            return 0;
+        MongoDataFile *p = _standby;
+        _standby = 0;
+        _standbyName.clear();
+        if ( p->length() < (unsigned long long) minSize ) {
+            // mapped before we knew how much space was needed - fall back to a
+            // normal open
+            delete p;
+            return 0;
+        }
+        // for _DEBUG validation (no op in release) - the mapping was marked
+        // read-only when created outside the lock, after this lock's
+        // markAllWritable() pass
+        MongoFile::markAllWritable();
+        return p;
+    }
+
+    void DataFileWarmer::discard( const string &prefix ) {
+        dbMutex.assertWriteLocked();
+        scoped_lock lk( _mutex );
+        if ( startsWith( _queuedName, prefix ) )
+            _queuedName.clear();
+        if ( _standby && startsWith( _standbyName, prefix ) ) {
+            delete _standby;
+            _standby = 0;
+            _standbyName.clear();
+        }
+        while ( !_inflightName.empty() && startsWith( _inflightName, prefix ) ) {
+            // the db's files may be about to be deleted; wait out the in
+            // flight mapping (the file is already allocated, so it's brief)
+            _discardInflight = true;
+            _updated.wait( lk.boost() );
+        }
+        emptyTrash();
+    }
+
+    void DataFileWarmer::run() {
+        while ( 1 ) {
+            string filename;
+            int n;
+            int minSize;
+            {
+                scoped_lock lk( _mutex );
+                while ( _queuedName.empty() )
+                    _updated.wait( lk.boost() );
+                filename = _queuedName;
+                n = _queuedNo;
+                minSize = _queuedMin;
+                _queuedName.clear();
+                _inflightName = filename;
+                _discardInflight = false;
+            }
+            // let the paced runway allocation finish first - mapping now would
+            // allocateAsap() the file and unthrottle the zero filling
+            FileAllocator::get()->waitUntilFinished();
+            MongoDataFile *p = new MongoDataFile( n );
+            bool ok = false;
+            if ( !inShutdown() ) {
+                try {
+                    p->openMapOnly( filename.c_str(), minSize );
+                    ok = true;
+                }
+                catch ( std::exception& e ) {
+                    log() << "warning: datafile warmer couldn't map " << filename
+                          << ' ' << e.what() << endl;
+                }
+            }
+            scoped_lock lk( _mutex );
+            _inflightName.clear();
+            if ( ok && !_discardInflight && _standby == 0 ) {
+                _standby = p;
+                _standbyName = filename;
+            }
+            else {
+                _trash.push_back( p );
+            }
+            _updated.notify_all();
+        }
+    }
+
     void addNewExtentToNamespace(const char *ns, Extent *e, DiskLoc eloc, DiskLoc emptyLoc, bool capped) {
         NamespaceIndex *ni = nsindex(ns);
         NamespaceDetails *details = ni->details(ns);
@@ -899,6 +1075,9 @@ namespace mongo {
                 log() << "unindex failed (key too big?) " << id.indexNamespace() << " key: " << j << " " << obj["_id"] << endl;
             }
         }
+
+        if ( !keys.empty() )
+            IndexUsage::global.noteRemoved( id.indexNamespace() , (int)keys.size() );
     }
 
     /* unindex all keys in all indexes for this record. */
@@ -993,7 +1172,9 @@ namespace mongo {
         unindexRecord(d, todelete, dl, noWarn);
 
         _deleteRecord(d, ns, todelete, dl);
-        NamespaceDetailsTransient::get_w( ns ).notifyOfWriteOp();
+        NamespaceDetailsTransient& nsdt = NamespaceDetailsTransient::get_w( ns );
+        nsdt.notifyOfWriteOp();
+        nsdt.deletingRecord( dl );
 
         if ( ! toDelete.isEmpty() ) {
             logOp( "d" , ns , toDelete );
@@ -1001,6 +1182,47 @@ namespace mongo {
     }
 
 
+    /* try to grow a record in place for an update that no longer fits, by
+       merging in the physically following space when it is a deleted record on
+       the freelist.  much cheaper than relocating the document, which has to
+       redo every index key.  @return true if the record now fits newObjSize. */
+    static bool tryGrowInPlace( NamespaceDetails *d, Record *r, const DiskLoc& dl, int newObjSize ) {
+        Extent *e = r->myExtent( dl );
+        int adjOfs = dl.getOfs() + r->lengthWithHeaders;
+        if ( adjOfs + Record::HeaderSize > e->myLoc.getOfs() + e->length )
+            return false; // we are the last record in the extent
+        DiskLoc adj( dl.a(), adjOfs );
+        DeletedRecord *adjd = adj.drec();
+        if ( adjd->extentOfs != r->extentOfs )
+            return false;
+        int required = newObjSize + Record::HeaderSize;
+        if ( r->lengthWithHeaders + adjd->lengthWithHeaders < required )
+            return false;
+        /* the header alone can't tell a deleted record from a live one -
+           claimDeletedRec confirms it is on the freelist and unlinks it */
+        if ( ! d->claimDeletedRec( adj ) )
+            return false;
+        int combined = r->lengthWithHeaders + adjd->lengthWithHeaders;
+        int newLenWHdr = combined;
+        /* give surplus back to the freelist unless it's tiny (same cutoffs as alloc()) */
+        int left = combined - required;
+        if ( left >= 24 && left >= (required >> 3) ) {
+            newLenWHdr = required;
+            DiskLoc leftLoc( dl.a(), dl.getOfs() + newLenWHdr );
+            DeletedRecord *leftover = getDur().writing( DataFileMgr::makeDeletedRecord( leftLoc, left ) );
+            leftover->lengthWithHeaders = left;
+            leftover->extentOfs = r->extentOfs;
+            leftover->nextDeleted.Null();
+            d->addDeletedRec( leftover, leftLoc );
+        }
+        {
+            NamespaceDetails::Stats *s = getDur().writing( &d->stats );
+            s->datasize += newLenWHdr - r->lengthWithHeaders;
+        }
+        getDur().writingInt( r->lengthWithHeaders ) = newLenWHdr;
+        return true;
+    }
+
     /** Note: if the object shrinks a lot, we don't free up space, we leave extra at end of the record.
      */
     const DiskLoc DataFileMgr::updateRecord(
@@ -1008,7 +1230,7 @@ namespace mongo {
         NamespaceDetails *d,
         NamespaceDetailsTransient *nsdt,
         Record *toupdate, const DiskLoc& dl,
-        const char *_buf, int _len, OpDebug& debug,  bool god) {
+        const char *_buf, int _len, OpDebug& debug,  bool god, IndexUpdateBatch *batch) {
 
         dassert( toupdate == dl.rec() );
 
@@ -1039,17 +1261,27 @@ namespace mongo {
         uassert( 13596 , str::stream() << "cannot change _id of a document old:" << objOld << " new:" << objNew , ! changedId );
         dupCheck(changes, *d, dl);
 
+        if ( nsdt )
+            nsdt->recordUpdateSize( objNew.objsize() + Record::HeaderSize );
+
         if ( toupdate->netLength() < objNew.objsize() ) {
-            // doesn't fit.  reallocate -----------------------------------------------------
+            // doesn't fit.
             uassert( 10003 , "failing update: objects in a capped ns cannot grow", !(d && d->capped));
             d->paddingTooSmall();
-            debug.moved = true;
-            deleteRecord(ns, toupdate, dl);
-            return insert(ns, objNew.objdata(), objNew.objsize(), god);
+            if ( ! tryGrowInPlace( d, toupdate, dl, objNew.objsize() ) ) {
+                // reallocate -----------------------------------------------------
+                debug.moved = true;
+                deleteRecord(ns, toupdate, dl);
+                return insert(ns, objNew.objdata(), objNew.objsize(), god);
+            }
+            // merged the adjacent deleted record into ours; the update is now an
+            // ordinary in place update
+        }
+        else {
+            d->paddingFits();
         }
 
         nsdt->notifyOfWriteOp();
-        d->paddingFits();
 
         /* have any index keys changed? */
         {
@@ -1058,11 +1290,19 @@ namespace mongo {
             for ( int x = 0; x < z; x++ ) {
                 IndexDetails& idx = d->idx(x);
                 IndexInterface& ii = idx.idxInterface();
+                /* non-unique indexes can have their key changes batched up and
+                   applied in key order later; unique indexes dup check against
+                   the tree, so they are always maintained right away */
+                const bool defer = batch != 0 && ! idx.unique();
                 for ( unsigned i = 0; i < changes[x].removed.size(); i++ ) {
+                    if ( defer ) {
+                        batch->noteRemoved( d, x, *changes[x].removed[i], dl );
+                        continue;
+                    }
                     try {
                         bool found = ii.unindex(idx.head, idx, *changes[x].removed[i], dl);
                         if ( ! found ) {
-                            RARELY warning() << "ns: " << ns << " couldn't unindex key: " << *changes[x].removed[i] 
+                            RARELY warning() << "ns: " << ns << " couldn't unindex key: " << *changes[x].removed[i]
                                              << " for doc: " << objOld["_id"] << endl;
                         }
                     }
@@ -1076,6 +1316,10 @@ namespace mongo {
                 Ordering ordering = Ordering::make(idxKey);
                 keyUpdates += changes[x].added.size();
                 for ( unsigned i = 0; i < changes[x].added.size(); i++ ) {
+                    if ( defer ) {
+                        batch->noteAdded( d, x, *changes[x].added[i], dl );
+                        continue;
+                    }
                     try {
                         /* we did the dupCheck() above.  so we don't have to worry about it here. */
                         ii.bt_insert(
@@ -1150,6 +1394,7 @@ namespace mongo {
                 problem() << " caught assertion _indexRecord " << idx.indexNamespace() << " " << obj["_id"] << endl;
             }
         }
+        IndexUsage::global.noteInserted( idx.indexNamespace() , n );
     }
 
 #if 0    
@@ -1180,19 +1425,20 @@ namespace mongo {
 
     SortPhaseOne *precalced = 0;
 
-    template< class V >
-    void buildBottomUpPhases2And3(bool dupsAllowed, IndexDetails& idx, BSONObjExternalSorter& sorter, 
+    /* SORTED is either a BSONObjExternalSorter::Iterator or a merge over several
+       of them (parallel builds) -- anything with the same more()/next() surface. */
+    template< class V, class SORTED >
+    void buildBottomUpPhases2And3(bool dupsAllowed, IndexDetails& idx, SORTED& sorted,
         bool dropDups, list<DiskLoc> &dupsToDrop, CurOp * op, SortPhaseOne *phase1, ProgressMeterHolder &pm,
         Timer& t
         )
     {
         BtreeBuilder<V> btBuilder(dupsAllowed, idx);
         BSONObj keyLast;
-        auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
         assert( pm == op->setMessage( "index: (2/3) btree bottom up" , phase1->nkeys , 10 ) );
-        while( i->more() ) {
+        while( sorted.more() ) {
             RARELY killCurrentOp.checkForInterrupt();
-            BSONObjExternalSorter::Data d = i->next();
+            BSONObjExternalSorter::Data d = sorted.next();
 
             try {
                 if ( !dupsAllowed && dropDups ) {
@@ -1233,6 +1479,131 @@ namespace mongo {
         }
     }
 
+    /** one slice of a parallel foreground index build's collection scan: a set
+        of extents scanned on a dedicated thread, with keys extracted into the
+        slice's own external sorter.  the build holds the write lock throughout,
+        so the extent chain is frozen; records are resolved straight off the
+        Extent with pointer arithmetic, keeping the worker away from per-client
+        db state entirely.
+    */
+    class IndexScanSlice : boost::noncopyable {
+    public:
+        IndexScanSlice( const IndexSpec& spec , IndexInterface& ii , const BSONObj& order , long long sizeHint )
+            : _spec(spec), _failed(false) {
+            phase1.sorter.reset( new BSONObjExternalSorter(ii, order) );
+            phase1.sorter->setIndexKeys();
+            phase1.sorter->hintNumObjects( sizeHint );
+        }
+        void add( Extent *e ) { _extents.push_back(e); }
+        void run() {
+            Client::initThread( "idxscan" );
+            try {
+                for( unsigned i = 0; i < _extents.size(); i++ ) {
+                    Extent *e = _extents[i];
+                    int a = e->myLoc.a();
+                    for( DiskLoc loc = e->firstRecord; !loc.isNull(); ) {
+                        Record *r = e->getRecord(loc);
+                        BSONObj o(r);
+                        phase1.addKeys(_spec, o, loc);
+                        loc = r->nextOfs == DiskLoc::NullOfs ? DiskLoc() : DiskLoc(a, r->nextOfs);
+                    }
+                }
+                phase1.sorter->sort();
+            }
+            catch( DBException& e ) {
+                _failed = true;
+                _errmsg = e.toString();
+            }
+            catch( std::exception& e ) {
+                _failed = true;
+                _errmsg = e.what();
+            }
+            cc().shutdown();
+        }
+        bool failed() const { return _failed; }
+        string errmsg() const { return _errmsg; }
+        SortPhaseOne phase1;
+    private:
+        const IndexSpec& _spec;
+        vector<Extent*> _extents;
+        bool _failed;
+        string _errmsg;
+    };
+
+    /** merges the pre-sorted output of several scan slices.  presents the same
+        more()/next() surface as BSONObjExternalSorter::Iterator so the btree
+        bottom-up phase can consume either.  the stream count is tiny (the
+        thread count) so a linear scan per key is fine - each underlying
+        iterator is already a loser tree over its own spill files. */
+    class SortedSliceMerger : boost::noncopyable {
+    public:
+        typedef BSONObjExternalSorter::Data Data;
+        SortedSliceMerger( const vector< shared_ptr<IndexScanSlice> > &slices , IndexInterface& ii , const BSONObj& order )
+            : _ii(ii), _ordering( Ordering::make(order) ) {
+            for( unsigned i = 0; i < slices.size(); i++ ) {
+                shared_ptr<BSONObjExternalSorter::Iterator> it( slices[i]->phase1.sorter->iterator().release() );
+                if ( it->more() ) {
+                    _iters.push_back( it );
+                    _heads.push_back( it->next() );
+                }
+            }
+        }
+        bool more() const { return ! _iters.empty(); }
+        Data next() {
+            unsigned best = 0;
+            for( unsigned i = 1; i < _iters.size(); i++ )
+                if ( _before( _heads[i] , _heads[best] ) )
+                    best = i;
+            Data d = _heads[best];
+            if ( _iters[best]->more() ) {
+                _heads[best] = _iters[best]->next();
+            }
+            else {
+                _iters.erase( _iters.begin() + best );
+                _heads.erase( _heads.begin() + best );
+            }
+            return d;
+        }
+    private:
+        // same ordering the sorters used: key order, DiskLoc breaking ties
+        bool _before( const Data& l , const Data& r ) const {
+            int x = _ii.keyCompare( l.first , r.first , _ordering );
+            if ( x )
+                return x < 0;
+            return l.second.compare( r.second ) < 0;
+        }
+        IndexInterface& _ii;
+        const Ordering _ordering;
+        vector< shared_ptr<BSONObjExternalSorter::Iterator> > _iters;
+        vector<Data> _heads;
+    };
+
+    /* partition the extent chain across cmdLine.indexBuildThreads scanner
+       threads, each extracting and sorting its keys independently.  throws if
+       any slice failed. */
+    static void parallelSortPhaseOne( NamespaceDetails *d, IndexDetails& idx,
+                                      vector< shared_ptr<IndexScanSlice> > &slices ) {
+        int nThreads = cmdLine.indexBuildThreads;
+        const IndexSpec& spec = idx.getSpec(); // force the lazy init before the workers share it
+        BSONObj order = idx.keyPattern();
+        long long hint = d->stats.nrecords / nThreads + 1;
+        for( int i = 0; i < nThreads; i++ )
+            slices.push_back( shared_ptr<IndexScanSlice>( new IndexScanSlice( spec , idx.idxInterface() , order , hint ) ) );
+        unsigned nExtents = 0;
+        if( !d->firstExtent.isNull() ) {
+            for( Extent *e = d->firstExtent.ext(); e; e = e->getNextExtent() )
+                slices[nExtents++ % slices.size()]->add( e );
+        }
+        log(1) << "\t parallel index scan: " << nThreads << " threads " << nExtents << " extents" << endl;
+        vector< shared_ptr<boost::thread> > threads;
+        for( unsigned i = 0; i < slices.size(); i++ )
+            threads.push_back( shared_ptr<boost::thread>( new boost::thread( boost::bind( &IndexScanSlice::run , slices[i].get() ) ) ) );
+        for( unsigned i = 0; i < threads.size(); i++ )
+            threads[i]->join();
+        for( unsigned i = 0; i < slices.size(); i++ )
+            uassert( 15921 , str::stream() << "parallel index build failed: " << slices[i]->errmsg() , ! slices[i]->failed() );
+    }
+
     // throws DBException
     unsigned long long fastBuildIndex(const char *ns, NamespaceDetails *d, IndexDetails& idx, int idxNo) {
         CurOp * op = cc().curop();
@@ -1253,11 +1624,26 @@ namespace mongo {
         ProgressMeterHolder pm( op->setMessage( "index: (1/3) external sort" , d->stats.nrecords , 10 ) );
         SortPhaseOne _ours;
         SortPhaseOne *phase1 = precalced;
-        if( phase1 == 0 ) {
+        vector< shared_ptr<IndexScanSlice> > slices;
+        if( phase1 == 0 && cmdLine.indexBuildThreads > 1 && !d->capped ) {
+            /* parallel scan+sort; each slice sorts on its own thread and phase 2
+               merges the sorted streams below.  capped collections keep the
+               serial path - their extents are recycled in place. */
+            phase1 = &_ours;
+            parallelSortPhaseOne( d, idx, slices );
+            for( unsigned i = 0; i < slices.size(); i++ ) {
+                SortPhaseOne& sp = slices[i]->phase1;
+                phase1->n += sp.n;
+                phase1->nkeys += sp.nkeys;
+                phase1->multi = phase1->multi || sp.multi;
+            }
+        }
+        else if( phase1 == 0 ) {
             phase1 = &_ours;
             SortPhaseOne& p1 = *phase1;
             shared_ptr<Cursor> c = theDataFileMgr.findAll(ns);
             p1.sorter.reset( new BSONObjExternalSorter(idx.idxInterface(), order) );
+            p1.sorter->setIndexKeys();
             p1.sorter->hintNumObjects( d->stats.nrecords );
             const IndexSpec& spec = idx.getSpec();
             while ( c->ok() ) {
@@ -1273,26 +1659,39 @@ namespace mongo {
         }
         pm.finished();
 
-        BSONObjExternalSorter& sorter = *(phase1->sorter);
-
         if( phase1->multi )
             d->setIndexIsMultikey(idxNo);
 
-        if ( logLevel > 1 ) printMemInfo( "before final sort" );
-        phase1->sorter->sort();
-        if ( logLevel > 1 ) printMemInfo( "after final sort" );
-
-        log(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles() << " files " << " in " << t.seconds() << " secs" << endl;
-
         list<DiskLoc> dupsToDrop;
 
         /* build index --- */
-        if( idx.version() == 0 )
-            buildBottomUpPhases2And3<V0>(dupsAllowed, idx, sorter, dropDups, dupsToDrop, op, phase1, pm, t);
-        else if( idx.version() == 1 ) 
-            buildBottomUpPhases2And3<V1>(dupsAllowed, idx, sorter, dropDups, dupsToDrop, op, phase1, pm, t);
-        else
-            assert(false);
+        if( slices.empty() ) {
+            BSONObjExternalSorter& sorter = *(phase1->sorter);
+
+            if ( logLevel > 1 ) printMemInfo( "before final sort" );
+            phase1->sorter->sort();
+            if ( logLevel > 1 ) printMemInfo( "after final sort" );
+
+            log(t.seconds() > 5 ? 0 : 1) << "\t external sort used : " << sorter.numFiles() << " files " << " in " << t.seconds() << " secs" << endl;
+
+            auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
+            if( idx.version() == 0 )
+                buildBottomUpPhases2And3<V0>(dupsAllowed, idx, *i, dropDups, dupsToDrop, op, phase1, pm, t);
+            else if( idx.version() == 1 )
+                buildBottomUpPhases2And3<V1>(dupsAllowed, idx, *i, dropDups, dupsToDrop, op, phase1, pm, t);
+            else
+                assert(false);
+        }
+        else {
+            // the slices already sorted themselves - merge their streams
+            SortedSliceMerger merged( slices, idx.idxInterface(), order );
+            if( idx.version() == 0 )
+                buildBottomUpPhases2And3<V0>(dupsAllowed, idx, merged, dropDups, dupsToDrop, op, phase1, pm, t);
+            else if( idx.version() == 1 )
+                buildBottomUpPhases2And3<V1>(dupsAllowed, idx, merged, dropDups, dupsToDrop, op, phase1, pm, t);
+            else
+                assert(false);
+        }
 
         log(1) << "\t fastBuildIndex dupsToDrop:" << dupsToDrop.size() << endl;
 
@@ -1320,6 +1719,9 @@ namespace mongo {
             }
             CursorId id = cc->cursorid();
 
+            Timer rateTimer;       // for the docs/sec throttle
+            unsigned long long nAtTimer = 0;
+
             while ( cc->ok() ) {
                 BSONObj js = cc->current();
                 try {
@@ -1365,6 +1767,37 @@ namespace mongo {
 
                 getDur().commitIfNeeded();
 
+                if ( ( n & 0x3ff ) == 0 )
+                    bgIndexBuildControl.progress( ns, n, cc->currLoc() );
+
+                /* runtime throttle and pause (indexBuildControl command).  any
+                   sleeping happens with the write lock yielded so foreground
+                   work proceeds. */
+                int maxPerSec = bgIndexBuildControl.maxDocsPerSec();
+                if ( maxPerSec > 0 && n - nAtTimer >= (unsigned long long)maxPerSec ) {
+                    int micros = 1000000 - (int)rateTimer.micros();
+                    if ( micros > 0 && !cc->yield( micros ) ) {
+                        cc.release();
+                        uasserted(15974, "cursor gone during bg index (throttled)");
+                    }
+                    rateTimer.reset();
+                    nAtTimer = n;
+                }
+                else if ( rateTimer.micros() > 1000000 ) {
+                    rateTimer.reset();
+                    nAtTimer = n;
+                }
+                while ( bgIndexBuildControl.paused() ) {
+                    bgIndexBuildControl.progress( ns, n, cc->currLoc() );
+                    killCurrentOp.checkForInterrupt();
+                    if ( !cc->yield( 100 * 1000 ) ) {
+                        cc.release();
+                        uasserted(15975, "cursor gone during bg index (paused)");
+                    }
+                    rateTimer.reset();
+                    nAtTimer = n;
+                }
+
                 if ( cc->yieldSometimes( ClientCursor::WillNeed ) ) {
                     progress.setTotalWhileRunning( d->stats.nrecords );
                 }
@@ -1400,11 +1833,13 @@ namespace mongo {
 
             prep(ns.c_str(), d);
             assert( idxNo == d->nIndexes );
+            bgIndexBuildControl.start( ns, d->stats.nrecords );
             try {
                 idx.head.writing() = idx.idxInterface().addBucket(idx);
                 n = addExistingToIndex(ns.c_str(), d, idx, idxNo);
             }
             catch(...) {
+                bgIndexBuildControl.finish( ns );
                 if( cc().database() && nsdetails(ns.c_str()) == d ) {
                     assert( idxNo == d->nIndexes );
                     done(ns.c_str(), d);
@@ -1414,6 +1849,7 @@ namespace mongo {
                 }
                 throw;
             }
+            bgIndexBuildControl.finish( ns );
             assert( idxNo == d->nIndexes );
             done(ns.c_str(), d);
             return n;
@@ -1794,6 +2230,12 @@ namespace mongo {
             *getDur().writing(&d->paddingFactor) = 1.0;
             lenWHdr = len + Record::HeaderSize;
         }
+        if ( !god && !d->capped ) {
+            if ( d->usingAdaptivePadding() )
+                lenWHdr = NamespaceDetailsTransient::get_w(ns).adaptiveAllocationSize( lenWHdr );
+            if ( d->usingPowerOf2Sizes() )
+                lenWHdr = NamespaceDetails::quantizePowerOf2AllocationSpace( lenWHdr );
+        }
 
         // If the collection is capped, check if the new object will violate a unique index
         // constraint before allocating space.
@@ -1864,9 +2306,70 @@ namespace mongo {
             }
         }
 
+        if ( d->capped )
+            NamespaceNotifier::notify( ns ); // wake tailable+awaitData getmores
+
         return loc;
     }
 
+    namespace {
+        struct NotifierChannel {
+            NotifierChannel() : waiters(0) , armed(false) , version(1) {}
+            int waiters;
+            bool armed;
+            NamespaceNotifier::When version;
+            boost::condition c;
+        };
+        mongo::mutex channelsMutex("NamespaceNotifier");
+        // channels are never deleted: there is at most one per namespace ever
+        // awaited on (capped collections being tailed), a small set
+        map<string,NotifierChannel*> channels;
+        volatile int nChannels = 0; // dirty read fast path for notify()
+    }
+
+    NamespaceNotifier::When NamespaceNotifier::now( const char *ns ) {
+        if ( nChannels == 0 )
+            return 0;
+        scoped_lock lk( channelsMutex );
+        map<string,NotifierChannel*>::const_iterator i = channels.find( ns );
+        return i == channels.end() ? 0 : i->second->version;
+    }
+
+    void NamespaceNotifier::notify( const char *ns ) {
+        if ( nChannels == 0 )
+            return;
+        scoped_lock lk( channelsMutex );
+        map<string,NotifierChannel*>::const_iterator i = channels.find( ns );
+        if ( i == channels.end() )
+            return;
+        NotifierChannel *ch = i->second;
+        ch->version++;
+        if ( ch->armed ) {
+            ch->armed = false;
+            ch->c.notify_all();
+        }
+    }
+
+    bool NamespaceNotifier::waitBeyond( const char *ns , When v , unsigned millis ) {
+        scoped_lock lk( channelsMutex );
+        NotifierChannel *&ch = channels[ns];
+        if ( ch == 0 ) {
+            ch = new NotifierChannel();
+            nChannels++;
+        }
+        if ( ch->version > v )
+            return true;
+        ch->waiters++;
+        boost::xtime deadline = incxtimemillis( millis );
+        while ( ch->version <= v ) {
+            ch->armed = true;
+            if ( !ch->c.timed_wait( lk.boost() , deadline ) )
+                break;
+        }
+        ch->waiters--;
+        return ch->version > v;
+    }
+
     /* special version of insert for transaction logging -- streamlined a bit.
        assumes ns is capped and no indexes
     */
@@ -1907,6 +2410,10 @@ namespace mongo {
             s->nrecords++;
         }
 
+        // the caller fills in the record after we return, but a woken waiter
+        // can't read until the write lock we hold is released, so this is safe
+        NamespaceNotifier::notify( ns );
+
         return r;
     }
 
@@ -2149,6 +2656,10 @@ namespace mongo {
         q = p / (c+"ns");
         bool ok = false;
         BOOST_CHECK_EXCEPTION( ok = fo.apply( q ) );
+        if ( ok )
+            log(2) << fo.op() << " file " << q.string() << endl;
+        q = p / (c+"ns1"); // lazily allocated namespace index extension, often absent
+        BOOST_CHECK_EXCEPTION( ok = fo.apply( q ) );
         if ( ok )
             log(2) << fo.op() << " file " << q.string() << endl;
         int i = 0;
@@ -27,6 +27,7 @@
 
 #include "../pch.h"
 #include "../util/mmap.h"
+#include "../util/background.h"
 #include "diskloc.h"
 #include "jsobjmanipulator.h"
 #include "namespace-inl.h"
@@ -40,6 +41,7 @@ namespace mongo {
     class Record;
     class Cursor;
     class OpDebug;
+    class IndexUpdateBatch;
 
     void dropDatabase(string db);
     bool repairDatabase(string db, string &errmsg, bool preserveClonedFilesOnFailure = false, bool backupOriginalFiles = false);
@@ -54,15 +56,47 @@ namespace mongo {
 
     bool isValidNS( const StringData& ns );
 
+    /** per namespace channel that wakes blocked tailable+awaitData getmores
+        when new data arrives, replacing the old sleep-and-rescan polling.
+        writes bump the channel's version; a broadcast goes out only while a
+        waiter is armed, so a stream of writes wakes each waiter once per
+        getMore cycle (at the batch boundary) rather than once per document.
+    */
+    class NamespaceNotifier {
+    public:
+        typedef unsigned long long When;
+
+        /** the channel's current version, or 0 if nobody ever waited on ns.
+            capture before scanning so a write racing the scan is not missed
+            by the subsequent waitBeyond(). */
+        static When now( const char *ns );
+
+        /** signal that ns received new data.  near free when there are no
+            channels; ok to call under the write lock. */
+        static void notify( const char *ns );
+
+        /** block until the channel version passes v or millis elapse.  do not
+            hold dbMutex when calling.  @return true if new data was signalled */
+        static bool waitBeyond( const char *ns , When v , unsigned millis );
+    };
+
     /*---------------------------------------------------------------------*/
 
     class MongoDataFile {
         friend class DataFileMgr;
         friend class BasicCursor;
     public:
-        MongoDataFile(int fn) : _mb(0), fileNo(fn) { }
+        MongoDataFile(int fn) : _mb(0), fileNo(fn), _accessPattern(0) { }
         void open(const char *filename, int requestedDataSize = 0, bool preallocateOnly = false);
 
+        /** map the file but defer the (journaled) header init to finishOpen().
+            used by the DataFileWarmer to map a datafile off the write path. */
+        void openMapOnly(const char *filename, int minSize = 0);
+
+        /** second half of openMapOnly() - initializes the header if the file
+            is new.  must be called under the write lock. */
+        void finishOpen();
+
         /* allocate a new extent from this datafile.
            @param capped - true if capped collection
            @param loops is our recursion check variable - you want to pass in zero
@@ -79,12 +113,20 @@ namespace mongo {
         /** fsync */
         void flush( bool sync );
 
+        /** hint the kernel about the expected access pattern for this file's
+            mapping.  tracked per file, so cursors can call this freely - madvise
+            is only issued when the advice actually changes.
+            @param advice MAdvise::Advice, or 0 for normal
+        */
+        void flagAccessPattern( int advice );
+
         /** only use fore debugging */
         Extent* debug_getExtent(DiskLoc loc) { return _getExtent( loc ); }
     private:
         void badOfs(int) const;
         void badOfs2(int) const;
         int defaultSize( const char *filename ) const;
+        long chooseSize( const char *filename, int minSize ) const;
 
         Extent* getExtent(DiskLoc loc) const;
         Extent* _getExtent(DiskLoc loc) const;
@@ -98,6 +140,62 @@ namespace mongo {
         MongoMMF mmf;
         void *_mb; // the memory mapped view
         int fileNo;
+        int _accessPattern; // last advice issued for the mapping - see flagAccessPattern()
+    };
+
+    /** maps the next datafile for a database before it is needed, so that when
+        a write finally crosses a file boundary Database::getFile() can adopt
+        an already mapped file - a pointer swap - instead of running mmap (and,
+        with --dur, private view creation) while holding the write lock.  the
+        journaled header init is still deferred to getFile() under the write
+        lock.  file boundary crossings are rare, so one queued request and one
+        standby file at a time suffice.  singleton.
+    */
+    class DataFileWarmer : public BackgroundJob {
+    public:
+        DataFileWarmer();
+
+        /** ask for datafile number n, to live at filename, to be mapped in the
+            background.  caller must hold the write lock.  noop if a request is
+            already queued, mapping or on standby. */
+        void request( const string &filename, int n, int minSize );
+
+        /** @return the prepared datafile for filename - caller owns it and
+            must call MongoDataFile::finishOpen() - or 0 if none is ready or
+            the standby mapping turned out too small.  caller must hold the
+            write lock. */
+        MongoDataFile* take( const string &filename, int minSize );
+
+        /** drop anything queued, mapping or on standby whose filename starts
+            with prefix.  called when a database closes, as its files may be
+            about to be deleted.  caller must hold the write lock. */
+        void discard( const string &prefix );
+
+        static DataFileWarmer* get();
+
+    protected:
+        virtual string name() const { return "DataFileWarmer"; }
+        virtual void run();
+
+    private:
+        void emptyTrash(); // caller must hold _mutex and the write lock
+
+        mongo::mutex _mutex;
+        boost::condition _updated;
+        string _queuedName; // pending request; empty = none
+        int _queuedNo;
+        int _queuedMin;
+        string _inflightName; // file the background thread is mapping now
+        bool _discardInflight;
+        string _standbyName; // mapped and ready for take()
+        MongoDataFile *_standby;
+        // mappings discarded while only the warmer thread could see them; with
+        // --dur a mapped file may not be closed outside the write lock, so
+        // these wait for the next locked caller
+        vector<MongoDataFile*> _trash;
+        bool _started;
+
+        static DataFileWarmer *_instance;
     };
 
     class DataFileMgr {
@@ -110,12 +208,15 @@ namespace mongo {
 
         /** @return DiskLoc where item ends up */
         // changedId should be initialized to false
+        // if batch is provided, key changes on non-unique indexes are collected
+        // there instead of applied, for the caller to flush() in key order
         const DiskLoc updateRecord(
             const char *ns,
             NamespaceDetails *d,
             NamespaceDetailsTransient *nsdt,
             Record *toupdate, const DiskLoc& dl,
-            const char *buf, int len, OpDebug& debug, bool god=false);
+            const char *buf, int len, OpDebug& debug, bool god=false,
+            IndexUpdateBatch *batch=0);
 
         // The object o may be updated if modified on insert.
         void insertAndLog( const char *ns, const BSONObj &o, bool god = false );
@@ -171,18 +171,18 @@ namespace mongo {
 
             switch(e.type()) {
             case Array: {
-                BSONObjBuilder subb;
+                BSONObjBuilder subb( b.subarrayStart( b.numStr(i++) ) );
                 appendArray(subb , e.embeddedObject(), true);
-                b.appendArray(b.numStr(i++), subb.obj());
+                subb.done();
                 break;
             }
             case Object: {
-                BSONObjBuilder subb;
+                BSONObjBuilder subb( b.subobjStart( b.numStr(i++) ) );
                 BSONObjIterator jt(e.embeddedObject());
                 while (jt.more()) {
                     append(subb , jt.next());
                 }
-                b.append(b.numStr(i++), subb.obj());
+                subb.done();
                 break;
             }
             default:
@@ -207,18 +207,17 @@ namespace mongo {
                     b.append(e);
             }
             else if (e.type() == Object) {
-                BSONObjBuilder subb;
+                BSONObjBuilder subb( b.subobjStart( e.fieldName() ) );
                 BSONObjIterator it(e.embeddedObject());
                 while (it.more()) {
                     subfm.append(subb, it.next());
                 }
-                b.append(e.fieldName(), subb.obj());
-
+                subb.done();
             }
             else { //Array
-                BSONObjBuilder subb;
+                BSONObjBuilder subb( b.subarrayStart( e.fieldName() ) );
                 subfm.appendArray(subb, e.embeddedObject());
-                b.appendArray(e.fieldName(), subb.obj());
+                subb.done();
             }
         }
     }
@@ -81,7 +81,10 @@ namespace mongo {
 
 
         /**
-         * transforms in according to spec
+         * transforms in according to spec, streaming the selected elements
+         * straight into b's buffer (typically the query reply buffer) -
+         * excluded elements are skipped by length, and subobjects are built
+         * in place, so no intermediate object is materialized
          */
         void transform( const BSONObj& in , BSONObjBuilder& b ) const;
 
@@ -269,7 +269,7 @@ doneCheckOrder:
         // FIXME SERVER-2864 Otherwise no query pattern can be generated.
         if ( _frs.matchPossible() ) {
             SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
-            NamespaceDetailsTransient::get_inlock( ns() ).registerIndexForPattern( _frs.pattern( _order ), indexKey(), nScanned );
+            NamespaceDetailsTransient::get_inlock( ns() ).registerIndexForPattern( _frs.pattern( _order ), indexKey(), nScanned, _idxNo );
         }
     }
     
@@ -306,7 +306,7 @@ doneCheckOrder:
         _init();
     }    
 
-    QueryPlanSet::QueryPlanSet( const char *ns, auto_ptr<FieldRangeSetPair> frsp, auto_ptr<FieldRangeSetPair> originalFrsp, const BSONObj &originalQuery, const BSONObj &order, bool mustAssertOnYieldFailure, const BSONElement *hint, bool honorRecordedPlan, const BSONObj &min, const BSONObj &max, bool bestGuessOnly, bool mayYield ) :
+    QueryPlanSet::QueryPlanSet( const char *ns, auto_ptr<FieldRangeSetPair> frsp, auto_ptr<FieldRangeSetPair> originalFrsp, const BSONObj &originalQuery, const BSONObj &order, bool mustAssertOnYieldFailure, const BSONElement *hint, bool honorRecordedPlan, const BSONObj &min, const BSONObj &max, bool bestGuessOnly, bool mayYield, int numWanted ) :
         _ns(ns),
         _originalQuery( originalQuery ),
         _frsp( frsp ),
@@ -327,6 +327,14 @@ doneCheckOrder:
             _hint = hint->wrap();
         }
         init();
+        // A scan provably shorter than the yield tracker's interval will finish
+        // before a yield would ever fire, so run it straight through without the
+        // per advance yield bookkeeping (and hence with no ClientCursor
+        // registration, since the ops only register when a yield fires).
+        if ( _mayYield && numWanted > 0 && numWanted < 256 &&
+                _plans.size() == 1 && _plans[ 0 ]->boundedScan( numWanted ) ) {
+            _mayYield = false;
+        }
     }
 
     bool QueryPlanSet::modifiedKeys() const {
@@ -461,9 +469,9 @@ doneCheckOrder:
         }
 
         if ( _honorRecordedPlan ) {
-            pair< BSONObj, long long > best = QueryUtilIndexed::bestIndexForPatterns( *_frsp, _order );
-            BSONObj bestIndex = best.first;
-            long long oldNScanned = best.second;
+            NamespaceDetailsTransient::CachedQueryPlan best = QueryUtilIndexed::bestIndexForPatterns( *_frsp, _order );
+            BSONObj bestIndex = best.indexKey;
+            long long oldNScanned = best.nScanned;
             if ( !bestIndex.isEmpty() ) {
                 QueryPlanPtr p;
                 _oldNScanned = oldNScanned;
@@ -472,12 +480,21 @@ doneCheckOrder:
                     p.reset( new QueryPlan( d, -1, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) );
                 }
 
-                NamespaceDetails::IndexIterator i = d->ii();
-                while( i.more() ) {
-                    int j = i.pos();
-                    IndexDetails& ii = i.next();
-                    if( ii.keyPattern().woCompare(bestIndex) == 0 ) {
-                        p.reset( new QueryPlan( d, j, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) );
+                // Fast path for hot query shapes: the cache remembers which index slot won
+                // last time, so verify it and skip the scan of the index list below.
+                if ( !p.get() && best.idxNo >= 0 && best.idxNo < d->nIndexes &&
+                        d->idx( best.idxNo ).keyPattern().woCompare( bestIndex ) == 0 ) {
+                    p.reset( new QueryPlan( d, best.idxNo, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) );
+                }
+
+                if ( !p.get() ) {
+                    NamespaceDetails::IndexIterator i = d->ii();
+                    while( i.more() ) {
+                        int j = i.pos();
+                        IndexDetails& ii = i.next();
+                        if( ii.keyPattern().woCompare(bestIndex) == 0 ) {
+                            p.reset( new QueryPlan( d, j, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) );
+                        }
                     }
                 }
 
@@ -494,6 +511,22 @@ doneCheckOrder:
         addOtherPlans( false );
     }
 
+    /** estimated number of keys in index 'idxNo' of 'ns', from the per-namespace
+        cache.  @return -1 if no estimate is available */
+    static long long indexKeyEstimate( const char *ns, NamespaceDetails *d, int idxNo ) {
+        SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
+        return NamespaceDetailsTransient::get_inlock( ns ).indexKeyCountEstimate( d, idxNo );
+    }
+
+    typedef pair<long long,QueryPlanSet::QueryPlanPtr> RankedPlan;
+    static bool cheaperPlanFirst( const RankedPlan &l, const RankedPlan &r ) {
+        if ( l.first < 0 )
+            return false; // unknown size sorts last
+        if ( r.first < 0 )
+            return true;
+        return l.first < r.first;
+    }
+
     void QueryPlanSet::addOtherPlans( bool checkFirst ) {
         const char *ns = _frsp->ns();
         NamespaceDetails *d = nsdetails( ns );
@@ -510,8 +543,9 @@ doneCheckOrder:
 
         bool normalQuery = _hint.isEmpty() && _min.isEmpty() && _max.isEmpty();
 
-        PlanSet plans;
+        vector<RankedPlan> plans;
         QueryPlanPtr optimalPlan;
+        long long optimalPlanKeys = -1;
         for( int i = 0; i < d->nIndexes; ++i ) {
             if ( normalQuery ) {
                 BSONObj keyPattern = d->idx( i ).keyPattern();
@@ -529,20 +563,30 @@ doneCheckOrder:
 
             QueryPlanPtr p( new QueryPlan( d, i, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) );
             if ( p->optimal() ) {
-                if ( !optimalPlan.get() ) {
+                // among several optimal indexes prefer the one with the fewest
+                // keys - a sparse index over an optional field can be a small
+                // fraction of the size of a full index with the same prefix
+                long long keys = indexKeyEstimate( ns, d, i );
+                if ( !optimalPlan.get() ||
+                     ( keys >= 0 && ( optimalPlanKeys < 0 || keys < optimalPlanKeys ) ) ) {
                     optimalPlan = p;
+                    optimalPlanKeys = keys;
                 }
             }
             else if ( !p->unhelpful() ) {
-                plans.push_back( p );
+                plans.push_back( make_pair( indexKeyEstimate( ns, d, i ), p ) );
             }
         }
         if ( optimalPlan.get() ) {
             addPlan( optimalPlan, checkFirst );
             return;
         }
-        for( PlanSet::iterator i = plans.begin(); i != plans.end(); ++i )
-            addPlan( *i, checkFirst );
+        // start the plan race with the apparently cheapest candidates: for the
+        // same bounds a smaller index has fewer buckets to scan, so the ordering
+        // biases both the best guess (plan 0) and the race toward it
+        stable_sort( plans.begin(), plans.end(), cheaperPlanFirst );
+        for( vector<RankedPlan>::iterator i = plans.begin(); i != plans.end(); ++i )
+            addPlan( i->second, checkFirst );
 
         // Table scan plan
         addPlan( QueryPlanPtr( new QueryPlan( d, -1, *_frsp, _originalFrsp.get(), _originalQuery, _order, _mustAssertOnYieldFailure ) ), checkFirst );
@@ -840,7 +884,8 @@ doneCheckOrder:
                                         const BSONObj &min,
                                         const BSONObj &max,
                                         bool bestGuessOnly,
-                                        bool mayYield ) :
+                                        bool mayYield,
+                                        int numWanted ) :
         _ns( ns ),
         _or( !query.getField( "$or" ).eoo() ),
         _query( query.getOwned() ),
@@ -866,7 +911,8 @@ doneCheckOrder:
         // if _or == false, don't use or clauses for index selection
         if ( !_or ) {
             auto_ptr<FieldRangeSetPair> frsp( new FieldRangeSetPair( ns, _query, true ) );
-            _currentQps.reset( new QueryPlanSet( ns, frsp, auto_ptr<FieldRangeSetPair>(), _query, order, false, hint, honorRecordedPlan, min, max, _bestGuessOnly, _mayYield ) );
+            cc().curop()->noteMemUsed( frsp->approxMemUsage() ); // a giant $in parses into a lot of intervals
+            _currentQps.reset( new QueryPlanSet( ns, frsp, auto_ptr<FieldRangeSetPair>(), _query, order, false, hint, honorRecordedPlan, min, max, _bestGuessOnly, _mayYield, numWanted ) );
         }
         else {
             BSONElement e = _query.getField( "$or" );
@@ -883,6 +929,7 @@ doneCheckOrder:
         ++_i;
         auto_ptr<FieldRangeSetPair> frsp( _org->topFrsp() );
         auto_ptr<FieldRangeSetPair> originalFrsp( _org->topFrspOriginal() );
+        cc().curop()->noteMemUsed( frsp->approxMemUsage() );
         BSONElement hintElt = _hint.firstElement();
         _currentQps.reset( new QueryPlanSet( _ns, frsp, originalFrsp, _query, BSONObj(), true, &hintElt, _honorRecordedPlan, BSONObj(), BSONObj(), _bestGuessOnly, _mayYield ) );
         shared_ptr<QueryOp> ret( _currentQps->runOp( op ) );
@@ -1251,28 +1298,26 @@ doneCheckOrder:
         nsd.registerIndexForPattern( frsp._multiKey.pattern( order ), BSONObj(), 0 );
     }
     
-    pair< BSONObj, long long > QueryUtilIndexed::bestIndexForPatterns( const FieldRangeSetPair &frsp, const BSONObj &order ) {
+    NamespaceDetailsTransient::CachedQueryPlan QueryUtilIndexed::bestIndexForPatterns( const FieldRangeSetPair &frsp, const BSONObj &order ) {
         SimpleMutex::scoped_lock lk(NamespaceDetailsTransient::_qcMutex);
         NamespaceDetailsTransient& nsd = NamespaceDetailsTransient::get_inlock( frsp.ns() );
         // TODO Maybe it would make sense to return the index with the lowest
         // nscanned if there are two possibilities.
         if ( frsp._singleKey.matchPossible() ) {
             QueryPattern pattern = frsp._singleKey.pattern( order );
-            BSONObj oldIdx = nsd.indexForPattern( pattern );
-            if ( !oldIdx.isEmpty() ) {
-                long long oldNScanned = nsd.nScannedForPattern( pattern );
-                return make_pair( oldIdx, oldNScanned );
+            NamespaceDetailsTransient::CachedQueryPlan old = nsd.cachedPlanForPattern( pattern );
+            if ( !old.indexKey.isEmpty() ) {
+                return old;
             }
         }
         if ( frsp._multiKey.matchPossible() ) {
             QueryPattern pattern = frsp._multiKey.pattern( order );
-            BSONObj oldIdx = nsd.indexForPattern( pattern );
-            if ( !oldIdx.isEmpty() ) {
-                long long oldNScanned = nsd.nScannedForPattern( pattern );
-                return make_pair( oldIdx, oldNScanned );
+            NamespaceDetailsTransient::CachedQueryPlan old = nsd.cachedPlanForPattern( pattern );
+            if ( !old.indexKey.isEmpty() ) {
+                return old;
             }
         }
-        return make_pair( BSONObj(), 0 );
+        return NamespaceDetailsTransient::CachedQueryPlan();
     }
     
     bool QueryUtilIndexed::uselessOr( const OrRangeGenerator &org, NamespaceDetails *d, int hintIdx ) {
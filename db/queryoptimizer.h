@@ -22,6 +22,7 @@
 #include "jsobj.h"
 #include "queryutil.h"
 #include "matcher.h"
+#include "namespace.h"
 #include "../util/net/listen.h"
 #include <queue>
 
@@ -60,6 +61,15 @@ namespace mongo {
          * query expression to match by itself without ever checking the main object.
          */
         bool exactKeyMatch() const { return _exactKeyMatch; }
+        /**
+         * @return true iff this plan will advance over at most numWanted index keys.
+         * Only an all equality bounded index scan that the index resolves by itself
+         * qualifies - every key advanced is then a match, so the scan stops once
+         * numWanted documents have been returned.
+         */
+        bool boundedScan( int numWanted ) const {
+            return numWanted > 0 && indexed() && _exactKeyMatch && !_scanAndOrderRequired;
+        }
         /** @return true iff this QueryPlan would perform an unindexed scan. */
         bool willScanTable() const { return _idxNo < 0 && !_impossible; }
 
@@ -266,7 +276,8 @@ namespace mongo {
                       const BSONObj &min = BSONObj(),
                       const BSONObj &max = BSONObj(),
                       bool bestGuessOnly = false,
-                      bool mayYield = false);
+                      bool mayYield = false,
+                      int numWanted = 0 );
 
         /** @return number of candidate plans. */
         int nPlans() const { return _plans.size(); }
@@ -391,7 +402,8 @@ namespace mongo {
                           const BSONObj &min = BSONObj(),
                           const BSONObj &max = BSONObj(),
                           bool bestGuessOnly = false,
-                          bool mayYield = false);
+                          bool mayYield = false,
+                          int numWanted = 0 );
 
         /**
          * Clone op for each query plan of a single $or clause, and @return the first cloned op
@@ -571,7 +583,7 @@ namespace mongo {
         /** Clear any indexes recorded as the best for either the single or multi key pattern. */
         static void clearIndexesForPatterns( const FieldRangeSetPair &frsp, const BSONObj &order );
         /** Return a recorded best index for the single or multi key pattern. */
-        static pair< BSONObj, long long > bestIndexForPatterns( const FieldRangeSetPair &frsp, const BSONObj &order );        
+        static NamespaceDetailsTransient::CachedQueryPlan bestIndexForPatterns( const FieldRangeSetPair &frsp, const BSONObj &order );        
         static bool uselessOr( const OrRangeGenerator& org, NamespaceDetails *d, int hintIdx );
     };
     
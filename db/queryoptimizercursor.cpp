@@ -25,7 +25,65 @@
 namespace mongo {
     
     static const int OutOfOrderDocumentsAssertionCode = 14810;
-    
+
+    /**
+     * A compact hash set of DiskLocs used for duplicate checking while
+     * multiplexing cursors.  Open addressed with power of two sizing, so a
+     * membership test is a probe or two in a flat array rather than a walk
+     * of a set<DiskLoc> tree, and memory is one DiskLoc per bucket rather
+     * than a heap node per entry.
+     */
+    class DiskLocHashSet : boost::noncopyable {
+    public:
+        DiskLocHashSet() : _n(), _mask( MinBuckets - 1 ), _buckets( new DiskLoc[ MinBuckets ] ) {}
+        ~DiskLocHashSet() { delete[] _buckets; }
+        /** add loc to the set.  @return true if newly added, false if already present. */
+        bool insert( const DiskLoc &loc ) {
+            dassert( !loc.isNull() ); // the null DiskLoc marks an empty bucket
+            if ( ( _n + 1 ) * 3 > ( _mask + 1 ) * 2 ) {
+                grow();
+            }
+            unsigned i = bucketFor( loc );
+            if ( !_buckets[ i ].isNull() ) {
+                return false;
+            }
+            _buckets[ i ] = loc;
+            ++_n;
+            return true;
+        }
+        bool contains( const DiskLoc &loc ) const { return !_buckets[ bucketFor( loc ) ].isNull(); }
+        unsigned size() const { return _n; }
+        /** buckets may be visited directly for iteration; empty buckets are null. */
+        unsigned capacity() const { return _mask + 1; }
+        const DiskLoc &at( unsigned i ) const { return _buckets[ i ]; }
+    private:
+        enum { MinBuckets = 256 };
+        /** @return the bucket holding loc, or the empty bucket where it would go. */
+        unsigned bucketFor( const DiskLoc &loc ) const {
+            unsigned i = ( unsigned( loc.a() ) * 2654435761U ) ^ ( unsigned( loc.getOfs() ) * 65537U );
+            i &= _mask;
+            while( !_buckets[ i ].isNull() && _buckets[ i ] != loc ) {
+                i = ( i + 1 ) & _mask;
+            }
+            return i;
+        }
+        void grow() {
+            unsigned oldCapacity = _mask + 1;
+            DiskLoc *old = _buckets;
+            _mask = oldCapacity * 2 - 1;
+            _buckets = new DiskLoc[ oldCapacity * 2 ];
+            for( unsigned i = 0; i < oldCapacity; ++i ) {
+                if ( !old[ i ].isNull() ) {
+                    _buckets[ bucketFor( old[ i ] ) ] = old[ i ];
+                }
+            }
+            delete[] old;
+        }
+        unsigned _n;
+        unsigned _mask;
+        DiskLoc *_buckets;
+    };
+
     /**
      * A QueryOp implementation utilized by the QueryOptimizerCursor
      */
@@ -317,23 +375,201 @@ namespace mongo {
 
         /** Insert and check for dups before takeover occurs */
         bool getsetdupInternal(const DiskLoc &loc) {
-            pair<set<DiskLoc>::iterator, bool> p = _dups.insert(loc);
-            return !p.second;
+            return !_dups.insert( loc );
         }
 
         /** Just check for dups - after takeover occurs */
         bool getdupInternal(const DiskLoc &loc) {
-            return _dups.count( loc ) > 0;
+            return _dups.contains( loc );
         }
-        
+
         auto_ptr<MultiPlanScanner> _mps;
         shared_ptr<QueryOptimizerCursorOp> _originalOp;
         QueryOptimizerCursorOp *_currOp;
-        set<DiskLoc> _dups;
+        DiskLocHashSet _dups;
         shared_ptr<Cursor> _takeover;
         long long _nscanned;
     };
     
+    /**
+     * Runs several index range cursors over the same collection as coroutines,
+     * advancing them round robin and deduplicating the locations they return
+     * with a compact DiskLoc hash set.  In union mode every location found by
+     * any sub cursor is returned once.  In intersect mode (two sub cursors)
+     * the two ranges are scanned in lock step and a location is returned once
+     * both sides have seen it, so two selective single field indexes can
+     * answer a conjunction that would otherwise require a compound index.
+     *
+     * If one range is exhausted well before the other in intersect mode, the
+     * surviving scan is cut off after a bounded number of additional keys and
+     * the exhausted side's remaining locations are drained instead.  Those
+     * locations are a superset of the intersection and the matcher the caller
+     * attaches discards the non matches, so the worst case stays close to the
+     * cost of the better single index plan.
+     *
+     * The loc sets accumulated here cannot be repositioned if documents move
+     * or are deleted, so this cursor does not support yielding and must be
+     * used under a continuously held lock.  The caller is responsible for
+     * keeping that tolerable by only handing it small ranges - see
+     * MaxIntersectRangeKeys in indexIntersectionCursor().
+     */
+    class IndexMergeCursor : public Cursor {
+    public:
+        IndexMergeCursor( const vector<shared_ptr<Cursor> > &subs, bool intersect ) :
+        _subs( subs ),
+        _intersect( intersect ),
+        _rr(),
+        _drainFrom( -1 ),
+        _scanBudget(),
+        _bothScanned(),
+        _drainPos(),
+        _nscanned() {
+            massert( 15983, "IndexMergeCursor requires at least two sub cursors", _subs.size() >= 2 );
+            massert( 15984, "index range intersection requires exactly two sub cursors", !_intersect || _subs.size() == 2 );
+            next();
+        }
+
+        virtual bool ok() { return !_curr.isNull(); }
+        virtual Record* _current() { assertOk(); return _curr.rec(); }
+        virtual BSONObj current() { assertOk(); return _curr.obj(); }
+        virtual DiskLoc currLoc() { return _curr; }
+        virtual bool advance() {
+            if ( _curr.isNull() ) {
+                return false;
+            }
+            return next();
+        }
+
+        /** This cursor will be ignored for yielding by the client cursor implementation. */
+        virtual DiskLoc refLoc() { return DiskLoc(); }
+
+        virtual bool supportGetMore() { return false; }
+        virtual bool supportYields() { return false; }
+
+        /** Returned locations are already deduplicated. */
+        virtual bool getsetdup(DiskLoc loc) { return false; }
+
+        virtual bool isMultiKey() const { return false; }
+
+        /** Results come from different indexes, so currKey() is left empty. */
+        virtual bool modifiedKeys() const { return true; }
+
+        virtual long long nscanned() { return _nscanned; }
+
+        virtual CoveredIndexMatcher *matcher() const { return _matcher.get(); }
+        virtual shared_ptr<CoveredIndexMatcher> matcherPtr() const { return _matcher; }
+        virtual void setMatcher( shared_ptr<CoveredIndexMatcher> matcher ) { _matcher = matcher; }
+
+        virtual string toString() { return "IndexMergeCursor"; }
+
+    private:
+        /** extra keys the surviving intersect scan may visit, per key of the exhausted scan */
+        enum { DrainScanFactor = 10 };
+
+        void assertOk() const {
+            massert( 15985, "Invalid access for cursor that is not ok()", !_curr.isNull() );
+        }
+
+        /** position at the next location to return.  @return false when exhausted. */
+        bool next() {
+            _curr = DiskLoc();
+            return _intersect ? nextIntersect() : nextUnion();
+        }
+
+        bool nextUnion() {
+            unsigned dead = 0;
+            while( dead < _subs.size() ) {
+                _rr = ( _rr + 1 ) % _subs.size();
+                Cursor &c = *_subs[ _rr ];
+                if ( !c.ok() ) {
+                    ++dead; // done when every sub cursor is seen exhausted in turn
+                    continue;
+                }
+                dead = 0;
+                DiskLoc loc = c.currLoc();
+                ++_nscanned;
+                bool fresh = !c.getsetdup( loc ) && _dups.insert( loc );
+                c.advance();
+                if ( fresh ) {
+                    _curr = loc;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        bool nextIntersect() {
+            // phase 1: coroutine the two scans, emitting each loc seen by both
+            while( _drainFrom < 0 ) {
+                _rr = 1 - _rr;
+                Cursor &c = *_subs[ _rr ];
+                if ( !c.ok() ) {
+                    // this side's loc set now bounds the result.  finish (or
+                    // cheaply cut off) the other scan before draining.
+                    _drainFrom = _rr;
+                    _scanBudget = (long long) DrainScanFactor * _seen[ _rr ].size() + 100;
+                    break;
+                }
+                DiskLoc loc = c.currLoc();
+                ++_nscanned;
+                bool fresh = !c.getsetdup( loc ) && _seen[ _rr ].insert( loc );
+                c.advance();
+                if ( fresh && _seen[ 1 - _rr ].contains( loc ) && _dups.insert( loc ) ) {
+                    _curr = loc;
+                    return true;
+                }
+            }
+            // phase 2: scan the surviving side within a budget; every loc it
+            // shares with the exhausted side is known to intersect
+            {
+                Cursor &c = *_subs[ 1 - _drainFrom ];
+                while( c.ok() && _scanBudget-- > 0 ) {
+                    DiskLoc loc = c.currLoc();
+                    ++_nscanned;
+                    bool fresh = !c.getsetdup( loc ) && _seen[ 1 - _drainFrom ].insert( loc );
+                    c.advance();
+                    if ( fresh && _seen[ _drainFrom ].contains( loc ) && _dups.insert( loc ) ) {
+                        _curr = loc;
+                        return true;
+                    }
+                }
+                if ( !c.ok() ) {
+                    _bothScanned = true;
+                }
+            }
+            if ( _bothScanned ) {
+                // both ranges were scanned completely, so every intersecting
+                // loc has already been returned
+                return false;
+            }
+            // phase 3: the surviving scan was cut off, so we don't know which
+            // of the exhausted side's remaining locs intersect; return them
+            // all and let the matcher discard the non matches
+            const DiskLocHashSet &s = _seen[ _drainFrom ];
+            while( _drainPos < s.capacity() ) {
+                DiskLoc loc = s.at( _drainPos++ );
+                if ( !loc.isNull() && _dups.insert( loc ) ) {
+                    _curr = loc;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        vector<shared_ptr<Cursor> > _subs;
+        bool _intersect;
+        unsigned _rr;
+        int _drainFrom;
+        long long _scanBudget;
+        bool _bothScanned;
+        unsigned _drainPos;
+        long long _nscanned;
+        DiskLoc _curr;
+        DiskLocHashSet _dups;
+        DiskLocHashSet _seen[ 2 ];
+        shared_ptr<CoveredIndexMatcher> _matcher;
+    };
+
     shared_ptr<Cursor> newQueryOptimizerCursor( auto_ptr<MultiPlanScanner> mps ) {
         try {
             return shared_ptr<Cursor>( new QueryOptimizerCursor( mps ) );
@@ -348,6 +584,99 @@ namespace mongo {
         return shared_ptr<Cursor>( new QueryOptimizerCursor( mps ) );
     }
     
+    /** largest equality range, in index keys, the intersection rewrite will
+        take on.  the merge cursor holds its lock for the whole scan, so both
+        ranges must be small enough to walk without yielding. */
+    enum { MaxIntersectRangeKeys = 10000 };
+
+    /**
+     * If query is a plain conjunction with scalar equality constraints on at
+     * least two fields that each have a dedicated single field index, no
+     * compound index leads with two of those fields, and both equality ranges
+     * are verified small (< MaxIntersectRangeKeys keys each), @return a cursor
+     * intersecting the first two such index ranges.  Otherwise @return an
+     * empty pointer, leaving plan selection to the query optimizer.
+     */
+    static shared_ptr<Cursor> indexIntersectionCursor( const char *ns, const BSONObj &query ) {
+        Database *database = cc().database();
+        assert( database );
+        NamespaceDetails *d = database->namespaceIndex.details(ns);
+        if ( !d ) {
+            return shared_ptr<Cursor>();
+        }
+        set<string> eqFields;
+        vector<int> idxNos;
+        BSONObjIterator q( query );
+        while( q.more() ) {
+            BSONElement e = q.next();
+            if ( e.fieldName()[ 0 ] == '$' ) {
+                // $or, $where etc - leave these to the query optimizer
+                return shared_ptr<Cursor>();
+            }
+            if ( strcmp( "_id", e.fieldName() ) == 0 ) {
+                // an _id equality plan cannot be beaten
+                return shared_ptr<Cursor>();
+            }
+            if ( !e.isSimpleType() ) {
+                // not a scalar equality constraint; the matcher will apply it
+                continue;
+            }
+            if ( !eqFields.insert( e.fieldName() ).second ) {
+                return shared_ptr<Cursor>();
+            }
+            int i = d->findIndexByKeyPattern( BSON( e.fieldName() << 1 ) );
+            if ( i >= 0 ) {
+                if ( d->idx( i ).unique() ) {
+                    // a unique index equality plan cannot be beaten
+                    return shared_ptr<Cursor>();
+                }
+                if ( idxNos.size() < 2 ) {
+                    idxNos.push_back( i );
+                }
+            }
+        }
+        if ( idxNos.size() < 2 ) {
+            return shared_ptr<Cursor>();
+        }
+        // a compound index leading with two of the equality fields will beat
+        // an intersection; let the query optimizer use it
+        NamespaceDetails::IndexIterator i = d->ii();
+        while( i.more() ) {
+            BSONObjIterator k( i.next().keyPattern() );
+            BSONElement first = k.next();
+            BSONElement second = first.eoo() ? first : k.next();
+            if ( !second.eoo() && eqFields.count( first.fieldName() ) && eqFields.count( second.fieldName() ) ) {
+                return shared_ptr<Cursor>();
+            }
+        }
+        // the merge cursor scans both equality ranges to exhaustion under a
+        // continuously held lock (it cannot yield), so only take over from the
+        // query optimizer when both ranges are provably small.  the capped
+        // count gives up after MaxIntersectRangeKeys keys, so sizing a huge
+        // range costs a bounded number of bucket reads, and a cheap range is
+        // just two boundary descents.
+        for( int s = 0; s < 2; ++s ) {
+            IndexDetails &idx = d->idx( idxNos[ s ] );
+            BSONObj key = idx.getKeyFromQuery( query );
+            long long keys = idx.idxInterface().countRange( idx.head, key, true, key, true,
+                                                            Ordering::make( idx.keyPattern() ),
+                                                            MaxIntersectRangeKeys );
+            if ( keys >= MaxIntersectRangeKeys ) {
+                return shared_ptr<Cursor>();
+            }
+        }
+        vector<shared_ptr<Cursor> > subs;
+        for( int s = 0; s < 2; ++s ) {
+            IndexDetails &idx = d->idx( idxNos[ s ] );
+            BSONObj key = idx.getKeyFromQuery( query );
+            subs.push_back( shared_ptr<Cursor>( BtreeCursor::make( d, idxNos[ s ], idx, key, key, true, 1 ) ) );
+        }
+        shared_ptr<Cursor> merged( new IndexMergeCursor( subs, true ) );
+        // an empty key pattern makes the matcher evaluate full documents
+        merged->setMatcher( shared_ptr<CoveredIndexMatcher>( new CoveredIndexMatcher( query, BSONObj() ) ) );
+        return merged;
+    }
+
     shared_ptr<Cursor> NamespaceDetailsTransient::getCursor( const char *ns, const BSONObj &query, const BSONObj &order ) {
         if ( query.isEmpty() && order.isEmpty() ) {
             // TODO This will not use a covered index.
@@ -366,6 +695,12 @@ namespace mongo {
                 }
             }
         }
+        if ( order.isEmpty() ) {
+            shared_ptr<Cursor> merged = indexIntersectionCursor( ns, query );
+            if ( merged ) {
+                return merged;
+            }
+        }
         auto_ptr<MultiPlanScanner> mps( new MultiPlanScanner( ns, query, order ) ); // mayYield == false
         shared_ptr<Cursor> single = mps->singleCursor();
         if ( single ) {
@@ -383,5 +718,10 @@ namespace mongo {
         auto_ptr<MultiPlanScanner> mps( new MultiPlanScanner( ns, query, order ) ); // mayYield == false
         return newQueryOptimizerCursor( mps );
     }
+
+    /** This interface just available for testing. */
+    shared_ptr<Cursor> newIndexMergeCursor( const vector<shared_ptr<Cursor> > &subs, bool intersect ) {
+        return shared_ptr<Cursor>( new IndexMergeCursor( subs, intersect ) );
+    }
         
 } // namespace mongo;
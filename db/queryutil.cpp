@@ -162,7 +162,7 @@ namespace mongo {
 
         // NOTE with $not, we could potentially form a complementary set of intervals.
         if ( !isNot && !e.eoo() && e.type() != RegEx && op == BSONObj::opIN ) {
-            set<BSONElement,element_lt> vals;
+            vector<BSONElement> vals;
             vector<FieldRange> regexes;
             uassert( 12580 , "invalid query" , e.isABSONObj() );
             BSONObjIterator i( e.embeddedObject() );
@@ -178,18 +178,24 @@ namespace mongo {
                     // A document array may be indexed by its first element, by undefined
                     // if it is empty, or as a full array if it is embedded within another
                     // array.
-                    vals.insert( ie );                        
+                    vals.push_back( ie );
                     if ( ie.type() == Array ) {
                         BSONElement temp = ie.embeddedObject().firstElement();
                         if ( temp.eoo() ) {
                             temp = staticUndefined.firstElement();
-                        }                        
-                        vals.insert( temp );
+                        }
+                        vals.push_back( temp );
                     }
                 }
             }
 
-            for( set<BSONElement,element_lt>::const_iterator i = vals.begin(); i != vals.end(); ++i )
+            // sort and dedupe in one pass - for large $in arrays this is much
+            // cheaper than maintaining a search tree element by element
+            sort( vals.begin(), vals.end(), element_lt() );
+            vals.erase( unique( vals.begin(), vals.end(), element_eq() ), vals.end() );
+
+            _intervals.reserve( vals.size() );
+            for( vector<BSONElement>::const_iterator i = vals.begin(); i != vals.end(); ++i )
                 _intervals.push_back( FieldInterval(*i) );
 
             for( vector<FieldRange>::const_iterator i = regexes.begin(); i != regexes.end(); ++i )
@@ -669,6 +675,17 @@ namespace mongo {
         return s;
     }
 
+    long long FieldRangeSet::approxMemUsage() const {
+        long long size = 0;
+        for ( map<string,FieldRange>::const_iterator i=_ranges.begin(); i!=_ranges.end(); i++ ) {
+            size += i->second.approxMemUsage();
+        }
+        for ( vector<BSONObj>::const_iterator i=_queries.begin(); i!=_queries.end(); i++ ) {
+            size += i->objsize();
+        }
+        return size;
+    }
+
     /**
      * Btree scanning for a multidimentional key range will yield a
      * multidimensional box.  The idea here is that if an 'other'
@@ -768,6 +785,16 @@ namespace mongo {
         }
     }    
     
+    void FieldRangeSet::intersectRange( const char *fieldName, const FieldRange &other ) {
+        FieldRange &existing = range( fieldName );
+        if ( existing.nontrivial() ) {
+            // a second predicate on this field - single and multi key
+            // intersection semantics diverge from here on
+            _singlePredicatePerField = false;
+        }
+        existing &= other;
+    }
+
     void FieldRangeSet::processOpElement( const char *fieldName, const BSONElement &f, bool isNot, bool optimize ) {
         BSONElement g = f;
         int op2 = g.getGtLtOp();
@@ -793,18 +820,18 @@ namespace mongo {
 
                 int op3 = getGtLtOp( h );
                 if ( op3 == BSONObj::Equality ) {
-                    range( fullname.c_str() ) &= FieldRange( h , _singleKey , isNot , optimize );
+                    intersectRange( fullname.c_str() , FieldRange( h , _singleKey , isNot , optimize ) );
                 }
                 else {
                     BSONObjIterator l( h.embeddedObject() );
                     while ( l.more() ) {
-                        range( fullname.c_str() ) &= FieldRange( l.next() , _singleKey , isNot , optimize );
+                        intersectRange( fullname.c_str() , FieldRange( l.next() , _singleKey , isNot , optimize ) );
                     }
                 }
             }
         }
         else {
-            range( fieldName ) &= FieldRange( f , _singleKey , isNot , optimize );
+            intersectRange( fieldName , FieldRange( f , _singleKey , isNot , optimize ) );
         }
     }
 
@@ -842,7 +869,7 @@ namespace mongo {
         }
 
         if ( equality || ( e.type() == Object && !e.embeddedObject()[ "$regex" ].eoo() ) ) {
-            range( e.fieldName() ) &= FieldRange( e , _singleKey , false , optimize );
+            intersectRange( e.fieldName() , FieldRange( e , _singleKey , false , optimize ) );
         }
         if ( !equality ) {
             BSONObjIterator j( e.embeddedObject() );
@@ -874,13 +901,27 @@ namespace mongo {
     }
 
     FieldRangeSet::FieldRangeSet( const char *ns, const BSONObj &query, bool singleKey, bool optimize )
-        : _ns( ns ), _queries( 1, query.getOwned() ), _singleKey( singleKey ) {
+        : _ns( ns ), _queries( 1, query.getOwned() ), _singleKey( singleKey ),
+          _singlePredicatePerField( true ) {
         BSONObjIterator i( _queries[ 0 ] );
 
         while( i.more() ) {
             processQueryField( i.next(), optimize );
         }
     }
+
+    FieldRangeSet::FieldRangeSet( const FieldRangeSet &other, bool singleKey )
+        : _ranges( other._ranges ), _ns( other._ns ), _queries( other._queries ),
+          _singleKey( singleKey ), _singlePredicatePerField( other._singlePredicatePerField ) {
+        // parsing a single predicate yields the same intervals for single and
+        // multi key indexes, so with one predicate per field the ranges can be
+        // copied rather than re-parsed (and large $in sets re-sorted); only
+        // the intersection semantics flag has to be adjusted
+        assert( other._singlePredicatePerField );
+        for( map<string,FieldRange>::iterator i = _ranges.begin(); i != _ranges.end(); ++i ) {
+            i->second.setSingleKey( singleKey );
+        }
+    }
     
     FieldRangeVector::FieldRangeVector( const FieldRangeSet &frs, const IndexSpec &indexSpec, int direction )
     :_indexSpec( indexSpec ), _direction( direction >= 0 ? 1 : -1 ) {
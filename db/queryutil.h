@@ -96,6 +96,8 @@ namespace mongo {
         /** Empty the range so it matches no BSONElements. */
         void makeEmpty() { _intervals.clear(); }
         const vector<FieldInterval> &intervals() const { return _intervals; }
+        /** approximate heap footprint of the parsed intervals; a giant $in shows up here */
+        long long approxMemUsage() const { return _intervals.capacity() * (long long)sizeof( FieldInterval ); }
         string getSpecial() const { return _special; }
         /** Make component intervals noninclusive. */
         void setExclusiveBounds();
@@ -106,6 +108,14 @@ namespace mongo {
          */
         void reverse( FieldRange &ret ) const;
 
+        /**
+         * Change the single key flag.  A single predicate parses to the same
+         * intervals for single and multi key indexes; only subsequent
+         * intersections differ.  Used when cloning a FieldRangeSet for the
+         * other index type.
+         */
+        void setSingleKey( bool singleKey ) { _singleKey = singleKey; }
+
         string toString() const;
     private:
         BSONObj addObj( const BSONObj &o );
@@ -137,7 +147,16 @@ namespace mongo {
         friend class OrRangeGenerator;
         friend class FieldRangeVector;
         FieldRangeSet( const char *ns, const BSONObj &query , bool singleKey , bool optimize=true );
-        
+
+        /**
+         * Creates a copy of 'other' for the other index type, sharing its
+         * parsed ranges rather than re-parsing the query.  Only valid when
+         * other.singlePredicatePerField() - with multiple predicates on one
+         * field, single and multi key intersections diverge and the sets must
+         * be parsed independently.
+         */
+        FieldRangeSet( const FieldRangeSet &other, bool singleKey );
+
         /** @return true if there is a nontrivial range for the given field. */
         bool hasRange( const char *fieldName ) const {
             map<string, FieldRange>::const_iterator f = _ranges.find( fieldName );
@@ -175,6 +194,9 @@ namespace mongo {
         QueryPattern pattern( const BSONObj &sort = BSONObj() ) const;
         string getSpecial() const;
 
+        /** approximate heap footprint of the parsed ranges and retained query objects */
+        long long approxMemUsage() const;
+
         /**
          * @return a FieldRangeSet approximation of the documents in 'this' but
          * not in 'other'.  The approximation will be a superset of the documents
@@ -202,11 +224,15 @@ namespace mongo {
         FieldRangeSet *subset( const BSONObj &fields ) const;
         
         bool singleKey() const { return _singleKey; }
-        
+
+        /** @return true if no field was constrained by more than one predicate. */
+        bool singlePredicatePerField() const { return _singlePredicatePerField; }
+
         BSONObj originalQuery() const { return _queries[ 0 ]; }
     private:
         void appendQueries( const FieldRangeSet &other );
         void makeEmpty();
+        void intersectRange( const char *fieldName, const FieldRange &other );
         void processQueryField( const BSONElement &e, bool optimize );
         void processOpElement( const char *fieldName, const BSONElement &f, bool isNot, bool optimize );
         static FieldRange *__singleKeyTrivialRange;
@@ -217,6 +243,7 @@ namespace mongo {
         // Owns memory for FieldRange BSONElements.
         vector<BSONObj> _queries;
         bool _singleKey;
+        bool _singlePredicatePerField;
     };
 
     class NamespaceDetails;
@@ -232,7 +259,13 @@ namespace mongo {
     class FieldRangeSetPair {
     public:
         FieldRangeSetPair( const char *ns, const BSONObj &query, bool optimize=true )
-        :_singleKey( ns, query, true, optimize ), _multiKey( ns, query, false, optimize ) {}
+        :_singleKey( ns, query, true, optimize ),
+         // with one predicate per field both sets parse to the same intervals,
+         // so share the single key set's ranges instead of re-parsing the
+         // query (and re-sorting any large $in arrays)
+         _multiKey( _singleKey.singlePredicatePerField() ?
+                    FieldRangeSet( _singleKey, false ) :
+                    FieldRangeSet( ns, query, false, optimize ) ) {}
 
         /**
          * @return the appropriate single or multi key FieldRangeSet for the specified index.
@@ -258,6 +291,9 @@ namespace mongo {
 
         string getSpecial() const { return _singleKey.getSpecial(); }
 
+        /** approximate heap footprint of both sets, for per-op memory accounting */
+        long long approxMemUsage() const { return _singleKey.approxMemUsage() + _multiKey.approxMemUsage(); }
+
         /** Intersect with another FieldRangeSetPair. */
         FieldRangeSetPair &operator&=( const FieldRangeSetPair &other );
         /**
@@ -1120,6 +1120,11 @@ namespace mongo {
                 log() << "repl:  " << errmsg << endl;
                 return false;
             }
+            // replication links are often cross-datacenter and oplog entries
+            // compress well; not fatal if the sync source is too old
+            if ( !_conn->negotiateWireCompression() ) {
+                LOG(1) << "repl: wire compression not negotiated with " << hostName << endl;
+            }
         }
         return true;
     }
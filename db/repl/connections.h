@@ -64,6 +64,18 @@ namespace mongo {
         void setTimeout(double to) {
             conn()->setSoTimeout(to);
         }
+        /** lightweight liveness check - a tiny fixed dbMsg the remote answers
+            before any command dispatch (see assembleResponse).  no cursor, so
+            safe to wrapper here.  @return true if the remote answered */
+        bool ping() {
+            Message msg;
+            msg.setData( dbMsg , "rsping" );
+            Message res;
+            if ( !conn()->call( msg , res , false ) )
+                return false;
+            return res.operation() == opReply &&
+                   strcmp( res.singleData()->_data , "rspong" ) == 0;
+        }
 
     private:
         auto_ptr<scoped_lock> connLock;
@@ -107,6 +119,11 @@ namespace mongo {
             log() << "could not authenticate against " << conn()->toString() << ", " << err << rsLog;
             return;
         }
+
+        // harmless if the peer is too old to negotiate - we just stay uncompressed
+        if (!x->cc.negotiateWireCompression()) {
+            LOG(1) << "wire compression not negotiated with " << hostport << rsLog;
+        }
     }
 
 }
@@ -147,8 +147,9 @@ namespace mongo {
     class ReplSetHealthPollTask : public task::Task {
         HostAndPort h;
         HeartbeatInfo m;
+        time_t lastFullResponse; // last time a full replSetHeartbeat was answered
     public:
-        ReplSetHealthPollTask(const HostAndPort& hh, const HeartbeatInfo& mm) : h(hh), m(mm) { }
+        ReplSetHealthPollTask(const HostAndPort& hh, const HeartbeatInfo& mm) : h(hh), m(mm), lastFullResponse(0) { }
 
         string name() const { return "rsHealthPoll"; }
         void doWork() {
@@ -165,6 +166,37 @@ namespace mongo {
 
                 Timer timer;
 
+                /* in steady state (both sides primary/secondary/arbiter and the
+                   member up) most rounds send only the cheap wire-level liveness
+                   ping; full state - optime, electability, config - is refreshed
+                   every few rounds or as soon as anything looks off. */
+                MemberState self = theReplSet->box.getState();
+                bool steady = ( self.primary() || self.secondary() || self.s == MemberState::RS_ARBITER ) &&
+                              ( mem.hbstate.primary() || mem.hbstate.secondary() || mem.hbstate.s == MemberState::RS_ARBITER );
+                bool full = !steady || !mem.up() ||
+                            lastFullResponse == 0 || time(0) - lastFullResponse >= 10;
+
+                if ( !full ) {
+                    bool ok = false;
+                    if ( !replSetBlind ) {
+                        ScopedConn conn(h.toString());
+                        ok = conn.ping();
+                    }
+                    mem.ping = (unsigned int)timer.millis();
+                    mem.lastHeartbeat = timer.startTime() / 1000000 + (mem.ping / 1000);
+                    if (old.ping != 0)
+                        mem.ping = (unsigned int)((old.ping * .8) + (mem.ping * .2));
+                    if ( ok ) {
+                        HeartbeatInfo::numPings++;
+                        mem.health = 1.0;
+                    }
+                    else {
+                        down(mem, "liveness ping failed");
+                    }
+                    finish(mem, old);
+                    return;
+                }
+
                 bool ok = requestHeartbeat(theReplSet->name(), theReplSet->selfFullName(), h.toString(), info, theReplSet->config().version, theirConfigVersion);
 
                 mem.ping = (unsigned int)timer.millis();
@@ -173,6 +205,7 @@ namespace mongo {
                 // we set this on any response - we don't get this far if
                 // couldn't connect because exception is thrown
                 time_t after = mem.lastHeartbeat = before + (mem.ping / 1000);
+                lastFullResponse = after;
 
                 // weight new ping with old pings
                 // on the first ping, just use the ping value
@@ -253,9 +286,20 @@ namespace mongo {
             catch(...) {
                 down(mem, "replSet unexpected exception in ReplSetHealthPollTask");
             }
+            finish(mem, old);
+        }
+
+    private:
+        void finish(const HeartbeatInfo& mem, const HeartbeatInfo& old) {
             m = mem;
 
-            theReplSet->mgr->send( boost::bind(&ReplSet::msgUpdateHBInfo, theReplSet, mem) );
+            /* update the member's hbinfo directly rather than queueing through
+               the manager: we are the only writer for this member (one poll
+               task each), members are never deleted on reconfig (see rs.h),
+               and hbinfo is already read without locks elsewhere.  this keeps
+               heartbeat bookkeeping off the manager's serialized queue, which
+               matters most right when an election is being sorted out. */
+            theReplSet->msgUpdateHBInfo(mem);
 
             static time_t last = 0;
             time_t now = time(0);
@@ -270,7 +314,6 @@ namespace mongo {
             }
         }
 
-    private:
         void down(HeartbeatInfo& mem, string msg) {
             mem.health = 0.0;
             mem.ping = 0;
@@ -230,8 +230,27 @@ namespace mongo {
 
     void ReplSetImpl::_fillIsMaster(BSONObjBuilder& b) {
         lock lk(this);
-        
+
         const StateBox::SP sp = box.get();
+        int primaryId = sp.primary ? (int) sp.primary->id() : -1;
+        if ( !_isMasterCache.isEmpty() &&
+             _isMasterCacheConfigVersion == (unsigned) config().version &&
+             _isMasterCacheState == sp.state.s &&
+             _isMasterCachePrimary == primaryId ) {
+            b.appendElements(_isMasterCache);
+            return;
+        }
+
+        BSONObjBuilder c;
+        _buildIsMaster(c, sp);
+        _isMasterCache = c.obj();
+        _isMasterCacheConfigVersion = (unsigned) config().version;
+        _isMasterCacheState = sp.state.s;
+        _isMasterCachePrimary = primaryId;
+        b.appendElements(_isMasterCache);
+    }
+
+    void ReplSetImpl::_buildIsMaster(BSONObjBuilder& b, const StateBox::SP& sp) {
         bool isp = sp.state.primary();
         b.append("setName", name());
         b.append("ismaster", isp);
@@ -339,6 +358,8 @@ namespace mongo {
         memset(_hbmsg, 0, sizeof(_hbmsg));
         strcpy( _hbmsg , "initial startup" );
         lastH = 0;
+        _isMasterCacheConfigVersion = 0;
+        _isMasterCacheState = _isMasterCachePrimary = -1;
         changeState(MemberState::RS_STARTUP);
 
         _seeds = &replSetCmdline.seeds;
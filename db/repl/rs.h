@@ -106,6 +106,7 @@ namespace mongo {
             GhostSlave() : last(0), slave(0), init(false) {}
             OplogReader reader;
             OpTime last;
+            OpTime acked; // newest optime this slave has reported reaching (used while primary)
             Member* slave;
             bool init;
         };
@@ -404,9 +405,19 @@ namespace mongo {
          *  - intentionally leaks the old _cfg and any old _members (if the
          *    change isn't strictly additive)
          */
-        bool initFromConfig(ReplSetConfig& c, bool reconf=false); 
+        bool initFromConfig(ReplSetConfig& c, bool reconf=false);
         void _fillIsMaster(BSONObjBuilder&);
+        void _buildIsMaster(BSONObjBuilder&, const StateBox::SP&);
         void _fillIsMasterHost(const Member*, vector<string>&, vector<string>&, vector<string>&);
+
+        /* cache of the _fillIsMaster body.  ismaster is hammered by
+           reconnecting clients, and its content only changes on reconfig,
+           state change or a new primary - the cache token captures all three
+           so no explicit invalidation hooks are needed. */
+        BSONObj _isMasterCache;
+        unsigned _isMasterCacheConfigVersion;
+        int _isMasterCacheState;
+        int _isMasterCachePrimary;
         const ReplSetConfig& config() { return *_cfg; }
         string name() const { return _name; } /* @return replica set's logical name */
         MemberState state() const { return box.getState(); }
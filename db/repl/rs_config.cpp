@@ -177,49 +177,17 @@ namespace mongo {
         return result+"}";
     }
 
-    void ReplSetConfig::TagSubgroup::updateLast(const OpTime& op) {
-        if (last < op) {
-            last = op;
-
-            for (vector<TagClause*>::iterator it = clauses.begin(); it < clauses.end(); it++) {
-                (*it)->updateLast(op);
-            }
-        }
-    }
-
-    void ReplSetConfig::TagClause::updateLast(const OpTime& op) {
-        if (last >= op) {
-            return;
-        }
-
-        // check at least n subgroups greater than clause.last
-        int count = 0;
-        map<string,TagSubgroup*>::iterator it;
-        for (it = subgroups.begin(); it != subgroups.end(); it++) {
-            if ((*it).second->last >= op) {
-                count++;
-            }
-        }
-
-        if (count >= actualTarget) {
-            last = op;
-            rule->updateLast(op);
-        }
-    }
-
-    void ReplSetConfig::TagRule::updateLast(const OpTime& op) {
-        OpTime *earliest = (OpTime*)&op;
-        vector<TagClause*>::iterator it;
-
-        for (it = clauses.begin(); it < clauses.end(); it++) {
-            if ((*it)->last < *earliest) {
-                earliest = &(*it)->last;
+    bool ReplSetConfig::TagRule::satisfiedBy( MemberSet upToDate ) const {
+        for (vector<CompiledClause>::const_iterator c = compiled.begin(); c != compiled.end(); c++) {
+            int hit = 0;
+            for (vector<MemberSet>::const_iterator g = (*c).groups.begin(); g != (*c).groups.end(); g++) {
+                if ( *g & upToDate )
+                    hit++;
             }
+            if ( hit < (*c).target )
+                return false;
         }
-
-        // rules are simply and-ed clauses, so whatever the most-behind
-        // clause is at is what the rule is at
-        last = *earliest;
+        return true;
     }
 
     /** @param o old config
@@ -354,6 +322,12 @@ namespace mongo {
         map<string,TagClause> tagMap;
         _populateTagMap(tagMap);
 
+        // a bit per member; the 12 member limit keeps this well within 64 bits
+        _memberMasks.clear();
+        for (unsigned i=0; i<members.size() && i<64; i++) {
+            _memberMasks[members[i]._id] = (MemberSet)1 << i;
+        }
+
         for (BSONObj::iterator i = modes.begin(); i.more(); ) {
             unsigned int primaryOnly = 0;
 
@@ -385,21 +359,32 @@ namespace mongo {
                 // if any subgroups contain "me", we can decrease the target
                 node->actualTarget = node->target;
 
-                // then we want to add pointers between clause & subgroup
+                // then we want to add pointers between clause & subgroup, and
+                // compile each subgroup into a mask over member bits
+                TagRule::CompiledClause compiledClause;
                 for (map<string,TagSubgroup*>::iterator sgs = node->subgroups.begin();
                      sgs != node->subgroups.end(); sgs++) {
                     bool foundMe = false;
-                    (*sgs).second->clauses.push_back(node);
+                    MemberSet mask = 0;
 
                     // if this subgroup contains the primary, it's automatically always up-to-date
                     for( set<MemberCfg*>::const_iterator cfg = (*sgs).second->m.begin();
-                         cfg != (*sgs).second->m.end(); 
-                         cfg++) 
+                         cfg != (*sgs).second->m.end();
+                         cfg++)
                     {
                         if ((*cfg)->h.isSelf()) {
                             node->actualTarget--;
                             foundMe = true;
                         }
+                        else {
+                            mask |= memberMask((*cfg)->_id);
+                        }
+                    }
+
+                    // subgroups containing this node are covered by the
+                    // actualTarget discount rather than by a mask
+                    if (!foundMe) {
+                        compiledClause.groups.push_back(mask);
                     }
 
                     for (set<MemberCfg *>::iterator cfg = (*sgs).second->m.begin();
@@ -407,6 +392,8 @@ namespace mongo {
                         (*cfg)->groupsw().insert((*sgs).second);
                     }
                 }
+                compiledClause.target = node->actualTarget;
+                r->compiled.push_back(compiledClause);
 
                 // if all of the members of this clause involve the primary, it's always up-to-date
                 if (node->actualTarget == 0) {
@@ -74,11 +74,6 @@ namespace mongo {
             void check() const;   /* check validity, assert if not. */
             BSONObj asBson() const;
             bool potentiallyHot() const { return !arbiterOnly && priority > 0; }
-            void updateGroups(const OpTime& last) {
-                for (set<TagSubgroup*>::iterator it = _groups.begin(); it != _groups.end(); it++) {
-                    ((TagSubgroup*)(*it))->updateLast(last);
-                }
-            }
             bool operator==(const MemberCfg& r) const {
                 return _id==r._id && votes == r.votes && h == r.h && priority == r.priority &&
                        arbiterOnly == r.arbiterOnly && slaveDelay == r.slaveDelay && hidden == r.hidden &&
@@ -95,6 +90,17 @@ namespace mongo {
         BSONObj getLastErrorDefaults;
         map<string,TagRule*> rules;
 
+        /** one bit per member, assigned at config load.  getLastErrorModes are
+            compiled down to these masks so slave progress can be evaluated with
+            bitwise ops instead of walking member lists per waiter per update. */
+        typedef unsigned long long MemberSet;
+
+        /** @return the bit for the member with the given _id, 0 if unknown */
+        MemberSet memberMask(int id) const {
+            map<int,MemberSet>::const_iterator i = _memberMasks.find(id);
+            return i == _memberMasks.end() ? 0 : i->second;
+        }
+
         list<HostAndPort> otherMemberHostnames() const; // except self
 
         /** @return true if could connect, and there is no cfg object there at all */
@@ -142,15 +148,12 @@ namespace mongo {
             TagSubgroup(string nm) : name(nm) { }
             const string name;
             OpTime last;
-            vector<TagClause*> clauses;
 
             // this probably won't actually point to valid members after the
             // subgroup is created, as initFromConfig() makes a copy of the
             // config
             set<MemberCfg*> m;
 
-            void updateLast(const OpTime& op);
-
             //string toString() const;
 
             /**
@@ -183,7 +186,6 @@ namespace mongo {
             int target;
             int actualTarget;
 
-            void updateLast(const OpTime& op);
             string toString() const;
         };
 
@@ -215,9 +217,23 @@ namespace mongo {
             vector<TagClause*> clauses;
             OpTime last;
 
-            void updateLast(const OpTime& op);
+            /** a clause compiled to one member mask per tag subgroup.
+                subgroups containing this node are folded into target instead,
+                as we are always up-to-date with ourselves. */
+            struct CompiledClause {
+                vector<MemberSet> groups;
+                int target; // # of groups that must contain an up-to-date member
+            };
+            vector<CompiledClause> compiled;
+
+            /** @return true if the members in upToDate satisfy every clause */
+            bool satisfiedBy( MemberSet upToDate ) const;
+
             string toString() const;
         };
+
+    private:
+        map<int,MemberSet> _memberMasks; // member _id -> bit
     };
 
 }
@@ -60,8 +60,12 @@ namespace mongo {
     /* todo : progress metering to sethbmsg. */
     static bool clone(const char *master, string db) {
         string err;
+        /* copy several collections at a time so the sync target's network round trips
+           overlap; inserts still serialize on the write lock per batch. */
+        const int parallel = 4;
         return cloneFrom(master, err, db, false,
-                         /* slave_ok */ true, true, false, /*mayYield*/true, /*mayBeInterrupted*/false);
+                         /* slave_ok */ true, true, false, /*mayYield*/true, /*mayBeInterrupted*/false,
+                         /*errCode*/0, parallel);
     }
 
     void _logOpObjRS(const BSONObj& op);
@@ -329,24 +329,52 @@ namespace mongo {
 
         bo newMinValid;
 
-        /* fetch all the goodVersions of each document from current primary */
+        /* fetch all the goodVersions of each document from current primary.
+           toRefetch is sorted by (ns,_id), so the ids for one collection are
+           contiguous - refetch them in sorted $in batches over a single cursor
+           rather than one findOne round trip per document. */
         DocID d;
         unsigned long long n = 0;
         try {
-            for( set<DocID>::iterator i = h.toRefetch.begin(); i != h.toRefetch.end(); i++ ) {
+            set<DocID>::iterator i = h.toRefetch.begin();
+            while( i != h.toRefetch.end() ) {
                 d = *i;
 
-                assert( !d._id.eoo() );
+                /* batch of ids for one collection.  cap the batch size so the
+                   $in query stays well under the max bson object size. */
+                vector<DocID> batch;
+                unsigned idBytes = 0;
+                while( i != h.toRefetch.end() && strcmp(i->ns, d.ns) == 0 ) {
+                    assert( !i->_id.eoo() );
+                    batch.push_back(*i);
+                    idBytes += i->_id.size();
+                    i++;
+                    if( idBytes > 4 * 1024 * 1024 )
+                        break;
+                }
 
-                {
-                    /* TODO : slow.  lots of round trips. */
-                    n++;
-                    bo good= them->findOne(d.ns, d._id.wrap(), NULL, QueryOption_SlaveOk).getOwned();
+                BSONArrayBuilder ids;
+                for( unsigned j = 0; j < batch.size(); j++ )
+                    ids.append(batch[j]._id);
+                bo query = BSON( "_id" << BSON( "$in" << ids.arr() ) );
+
+                map<be,bo> found;
+                auto_ptr<DBClientCursor> cur = them->query(d.ns, query, 0, 0, NULL, QueryOption_SlaveOk);
+                uassert( 15982, "replSet rollback error querying refetch batch", cur.get() );
+                while( cur->more() ) {
+                    bo good = cur->nextSafe().getOwned();
                     totSize += good.objsize();
                     uassert( 13410, "replSet too much data to roll back", totSize < 300 * 1024 * 1024 );
+                    found.insert(pair<be,bo>(good["_id"], good));
+                }
 
-                    // note good might be eoo, indicating we should delete it
-                    goodVersions.push_back(pair<DocID,bo>(d,good));
+                for( unsigned j = 0; j < batch.size(); j++ ) {
+                    d = batch[j];
+                    n++;
+                    map<be,bo>::iterator f = found.find(d._id);
+                    // a document missing from the batch result wasn't on the
+                    // primary; an empty object marks it for deletion below
+                    goodVersions.push_back(pair<DocID,bo>(d, f == found.end() ? bo() : f->second));
                 }
             }
             newMinValid = r.getLastOp(rsoplog);
@@ -465,106 +493,115 @@ namespace mongo {
         map<string,shared_ptr<RemoveSaver> > removeSavers;
 
         unsigned deletes = 0, updates = 0;
-        for( list<pair<DocID,bo> >::iterator i = goodVersions.begin(); i != goodVersions.end(); i++ ) {
-            const DocID& d = i->first;
-            bo pattern = d._id.wrap(); // { _id : ... }
-            try {
-                assert( d.ns && *d.ns );
-                if( h.collectionsToResync.count(d.ns) ) {
-                    /* we just synced this entire collection */
-                    continue;
-                }
+        list<pair<DocID,bo> >::iterator i = goodVersions.begin();
+        while( i != goodVersions.end() ) {
+            const char *ns = i->first.ns;
+            assert( ns && *ns );
+
+            if( h.collectionsToResync.count(ns) ) {
+                /* we just synced this entire collection */
+                while( i != goodVersions.end() && strcmp(i->first.ns, ns) == 0 )
+                    i++;
+                continue;
+            }
 
-                getDur().commitIfNeeded();
-
-                /* keep an archive of items rolled back */
-                shared_ptr<RemoveSaver>& rs = removeSavers[d.ns];
-                if ( ! rs )
-                    rs.reset( new RemoveSaver( "rollback" , "" , d.ns ) );
-
-                // todo: lots of overhead in context, this can be faster
-                Client::Context c(d.ns);
-                if( i->second.isEmpty() ) {
-                    // wasn't on the primary; delete.
-                    /* TODO1.6 : can't delete from a capped collection.  need to handle that here. */
-                    deletes++;
-
-                    NamespaceDetails *nsd = nsdetails(d.ns);
-                    if( nsd ) {
-                        if( nsd->capped ) {
-                            /* can't delete from a capped collection - so we truncate instead. if this item must go,
-                            so must all successors!!! */
-                            try {
-                                /** todo: IIRC cappedTrunateAfter does not handle completely empty.  todo. */
-                                // this will crazy slow if no _id index.
-                                long long start = Listener::getElapsedTimeMillis();
-                                DiskLoc loc = Helpers::findOne(d.ns, pattern, false);
-                                if( Listener::getElapsedTimeMillis() - start > 200 )
-                                    log() << "replSet warning roll back slow no _id index for " << d.ns << " perhaps?" << rsLog;
-                                //would be faster but requires index: DiskLoc loc = Helpers::findById(nsd, pattern);
-                                if( !loc.isNull() ) {
-                                    try {
-                                        nsd->cappedTruncateAfter(d.ns, loc, true);
-                                    }
-                                    catch(DBException& e) {
-                                        if( e.getCode() == 13415 ) {
-                                            // hack: need to just make cappedTruncate do this...
-                                            nsd->emptyCappedCollection(d.ns);
+            /* keep an archive of items rolled back */
+            shared_ptr<RemoveSaver>& rs = removeSavers[ns];
+            if ( ! rs )
+                rs.reset( new RemoveSaver( "rollback" , "" , ns ) );
+
+            /* the refetches above were gathered in ns order, so all the fixes for
+               one collection arrive together - set up the context once per
+               collection rather than once per document */
+            Client::Context c(ns);
+            for( ; i != goodVersions.end() && strcmp(i->first.ns, ns) == 0; i++ ) {
+                const DocID& d = i->first;
+                bo pattern = d._id.wrap(); // { _id : ... }
+                try {
+                    getDur().commitIfNeeded();
+
+                    if( i->second.isEmpty() ) {
+                        // wasn't on the primary; delete.
+                        /* TODO1.6 : can't delete from a capped collection.  need to handle that here. */
+                        deletes++;
+
+                        NamespaceDetails *nsd = nsdetails(d.ns);
+                        if( nsd ) {
+                            if( nsd->capped ) {
+                                /* can't delete from a capped collection - so we truncate instead. if this item must go,
+                                so must all successors!!! */
+                                try {
+                                    /** todo: IIRC cappedTrunateAfter does not handle completely empty.  todo. */
+                                    // this will crazy slow if no _id index.
+                                    long long start = Listener::getElapsedTimeMillis();
+                                    DiskLoc loc = Helpers::findOne(d.ns, pattern, false);
+                                    if( Listener::getElapsedTimeMillis() - start > 200 )
+                                        log() << "replSet warning roll back slow no _id index for " << d.ns << " perhaps?" << rsLog;
+                                    //would be faster but requires index: DiskLoc loc = Helpers::findById(nsd, pattern);
+                                    if( !loc.isNull() ) {
+                                        try {
+                                            nsd->cappedTruncateAfter(d.ns, loc, true);
                                         }
-                                        else {
-                                            throw;
+                                        catch(DBException& e) {
+                                            if( e.getCode() == 13415 ) {
+                                                // hack: need to just make cappedTruncate do this...
+                                                nsd->emptyCappedCollection(d.ns);
+                                            }
+                                            else {
+                                                throw;
+                                            }
                                         }
                                     }
                                 }
+                                catch(DBException& e) {
+                                    log() << "replSet error rolling back capped collection rec " << d.ns << ' ' << e.toString() << rsLog;
+                                }
                             }
-                            catch(DBException& e) {
-                                log() << "replSet error rolling back capped collection rec " << d.ns << ' ' << e.toString() << rsLog;
-                            }
-                        }
-                        else {
-                            try {
-                                deletes++;
-                                deleteObjects(d.ns, pattern, /*justone*/true, /*logop*/false, /*god*/true, rs.get() );
-                            }
-                            catch(...) {
-                                log() << "replSet error rollback delete failed ns:" << d.ns << rsLog;
+                            else {
+                                try {
+                                    deletes++;
+                                    deleteObjects(d.ns, pattern, /*justone*/true, /*logop*/false, /*god*/true, rs.get() );
+                                }
+                                catch(...) {
+                                    log() << "replSet error rollback delete failed ns:" << d.ns << rsLog;
+                                }
                             }
-                        }
-                        // did we just empty the collection?  if so let's check if it even exists on the source.
-                        if( nsd->stats.nrecords == 0 ) {
-                            try {
-                                string sys = cc().database()->name + ".system.namespaces";
-                                bo o = them->findOne(sys, QUERY("name"<<d.ns));
-                                if( o.isEmpty() ) {
-                                    // we should drop
-                                    try {
-                                        bob res;
-                                        string errmsg;
-                                        dropCollection(d.ns, errmsg, res);
-                                    }
-                                    catch(...) {
-                                        log() << "replset error rolling back collection " << d.ns << rsLog;
+                            // did we just empty the collection?  if so let's check if it even exists on the source.
+                            if( nsd->stats.nrecords == 0 ) {
+                                try {
+                                    string sys = cc().database()->name + ".system.namespaces";
+                                    bo o = them->findOne(sys, QUERY("name"<<d.ns));
+                                    if( o.isEmpty() ) {
+                                        // we should drop
+                                        try {
+                                            bob res;
+                                            string errmsg;
+                                            dropCollection(d.ns, errmsg, res);
+                                        }
+                                        catch(...) {
+                                            log() << "replset error rolling back collection " << d.ns << rsLog;
+                                        }
                                     }
                                 }
-                            }
-                            catch(DBException& ) {
-                                /* this isn't *that* big a deal, but is bad. */
-                                log() << "replSet warning rollback error querying for existence of " << d.ns << " at the primary, ignoring" << rsLog;
+                                catch(DBException& ) {
+                                    /* this isn't *that* big a deal, but is bad. */
+                                    log() << "replSet warning rollback error querying for existence of " << d.ns << " at the primary, ignoring" << rsLog;
+                                }
                             }
                         }
                     }
+                    else {
+                        // todo faster...
+                        OpDebug debug;
+                        updates++;
+                        _updateObjects(/*god*/true, d.ns, i->second, pattern, /*upsert=*/true, /*multi=*/false , /*logtheop=*/false , debug, rs.get() );
+                    }
                 }
-                else {
-                    // todo faster...
-                    OpDebug debug;
-                    updates++;
-                    _updateObjects(/*god*/true, d.ns, i->second, pattern, /*upsert=*/true, /*multi=*/false , /*logtheop=*/false , debug, rs.get() );
+                catch(DBException& e) {
+                    log() << "replSet exception in rollback ns:" << d.ns << ' ' << pattern.toString() << ' ' << e.toString() << " ndeletes:" << deletes << rsLog;
+                    warn = true;
                 }
             }
-            catch(DBException& e) {
-                log() << "replSet exception in rollback ns:" << d.ns << ' ' << pattern.toString() << ' ' << e.toString() << " ndeletes:" << deletes << rsLog;
-                warn = true;
-            }
         }
 
         removeSavers.clear(); // this effectively closes all of them
@@ -19,6 +19,8 @@
 #include "../../client/dbclient.h"
 #include "rs.h"
 #include "../repl.h"
+#include "../dbhelpers.h"
+#include "../curop-inl.h"
 #include "connections.h"
 
 namespace mongo {
@@ -32,6 +34,125 @@ namespace mongo {
         }
     }
 
+    /* fault in the btree and record pages an op will need, before the write
+       locked apply.  on an io bound secondary most of the apply time is page
+       faults taken while holding the write lock, which stalls everything;
+       probing the same pages here under a read lock means the apply below runs
+       against warm memory.  strictly best effort: a miss or an error just
+       means the apply faults the page itself, as before. */
+    static void prefetchOpPages(const BSONObj& op) {
+        const char *opType = op.getStringField("op");
+        if( *opType != 'i' && *opType != 'u' && *opType != 'd' )
+            return;
+        const char *ns = op.getStringField("ns");
+        if( *ns == '.' || *ns == 0 )
+            return;
+        try {
+            readlock lk(ns);
+            Client::Context ctx(ns);
+            NamespaceDetails *d = nsdetails(ns);
+            if( d == 0 )
+                return;
+
+            BSONObj doc;
+            if( *opType == 'i' ) {
+                doc = op.getObjectField("o");
+            }
+            else {
+                /* update / delete: descend the _id index and pull in the
+                   target record.  the fetched doc then seeds the index probes
+                   below so the unindex/index work in the apply lands on warm
+                   leaves too. */
+                BSONObj pattern = op.getObjectField(*opType == 'u' ? "o2" : "o");
+                if( pattern["_id"].eoo() )
+                    return;
+                DiskLoc loc = Helpers::findById(d, pattern);
+                if( loc.isNull() )
+                    return;
+                doc = loc.obj();
+            }
+            if( doc.isEmpty() )
+                return;
+
+            NamespaceDetails::IndexIterator i = d->ii();
+            while( i.more() ) {
+                IndexDetails& idx = i.next();
+                if( idx.head.isNull() )
+                    continue;
+                BSONObjSet keys;
+                idx.getKeysFromObject(doc, keys);
+                for( BSONObjSet::const_iterator k = keys.begin(); k != keys.end(); ++k )
+                    idx.idxInterface().findSingle(idx, idx.head, *k);
+            }
+        }
+        catch( DBException& ) {
+            // just a hint; the apply deals with any real problems itself
+        }
+    }
+
+    /* true if op is an update whose modifier is purely a top level $set with
+       no dotted field names.  a run of these against one document coalesces
+       into a single application: per field the newest $set wins, so applying
+       the merged modifier once gives the same document as applying each in
+       turn, and the merged op is $set only so it is as idempotent as the
+       originals.  dotted names are excluded because merging {$set:{"a.b":1}}
+       with {$set:{a:{}}} can produce conflicting mods that never coexisted in
+       a real op. */
+    static bool isPlainSetOp(const BSONObj& op) {
+        const char *opType = op.getStringField("op");
+        if( opType[0] != 'u' || opType[1] )
+            return false;
+        BSONObj o = op.getObjectField("o");
+        BSONElement set = o.firstElement();
+        if( o.nFields() != 1 || strcmp(set.fieldName(), "$set") != 0 || set.type() != Object )
+            return false;
+        BSONObjIterator i( set.embeddedObject() );
+        while( i.more() ) {
+            if( strchr(i.next().fieldName(), '.') )
+                return false;
+        }
+        return true;
+    }
+
+    /* do ops a and b target the same document the same way? */
+    static bool sameUpdateTarget(const BSONObj& a, const BSONObj& b) {
+        if( strcmp(a.getStringField("ns"), b.getStringField("ns")) != 0 )
+            return false;
+        if( a.getBoolField("b") != b.getBoolField("b") )
+            return false;
+        return a.getObjectField("o2").binaryEqual( b.getObjectField("o2") );
+    }
+
+    /* merge a run of $set only ops on one document into one op.  fields set
+       more than once keep the last value; ns, o2 and the upsert flag are
+       identical across the run by construction so the newest op serves as the
+       template. */
+    static BSONObj coalesceSetRun(vector<BSONObj>::const_iterator begin, vector<BSONObj>::const_iterator end) {
+        map<string,BSONElement> newest; // elements are backed by the owned batch objects
+        for( vector<BSONObj>::const_iterator i = begin; i != end; ++i ) {
+            BSONObjIterator s( i->getObjectField("o").getObjectField("$set") );
+            while( s.more() ) {
+                BSONElement e = s.next();
+                newest[e.fieldName()] = e;
+            }
+        }
+        BSONObjBuilder setb;
+        for( map<string,BSONElement>::const_iterator i = newest.begin(); i != newest.end(); ++i )
+            setb.append( i->second );
+        BSONObj set = setb.obj();
+
+        BSONObjBuilder b;
+        BSONObjIterator i( *(end-1) );
+        while( i.more() ) {
+            BSONElement e = i.next();
+            if( strcmp(e.fieldName(), "o") == 0 )
+                b.append( "o", BSON( "$set" << set ) );
+            else
+                b.append(e);
+        }
+        return b.obj();
+    }
+
     /* apply the log op that is in param o */
     void ReplSetImpl::syncApply(const BSONObj &o) {
         const char *ns = o.getStringField("ns");
@@ -383,6 +504,7 @@ namespace mongo {
                     BSONObj o = r.nextSafe(); /* note we might get "not master" at some point */
 
                     int sd = myConfig().slaveDelay;
+                    bool batching = sd == 0; // a delayed member inspects ts op by op below; don't batch there
                     // ignore slaveDelay if the box is still initializing. once
                     // it becomes secondary we can worry about it.
                     if( sd && box.getState().secondary() ) {
@@ -417,6 +539,31 @@ namespace mongo {
 
                     }
 
+                    /* batch ops already buffered client side so one write lock (and one
+                       journal commit window) is amortized across many ops.  a primary with
+                       hundreds of writer threads produces ops far faster than we can apply
+                       them taking/dropping the write lock per op.  application order is
+                       preserved; the lock is held for the whole batch so readers never see
+                       a partially applied batch. */
+                    const unsigned maxBatchOps = 128;
+                    const unsigned maxBatchBytes = 4 * 1024 * 1024;
+                    vector<BSONObj> batch;
+                    batch.push_back( o.getOwned() );
+                    if ( batching ) {
+                        unsigned bytes = (unsigned) o.objsize();
+                        while( batch.size() < maxBatchOps && bytes < maxBatchBytes &&
+                               r.moreInCurrentBatch() ) {
+                            BSONObj nxt = r.nextSafe();
+                            bytes += (unsigned) nxt.objsize();
+                            batch.push_back( nxt.getOwned() );
+                        }
+                    }
+
+                    /* warm the pages the batch will touch while we do not yet
+                       hold the write lock */
+                    for( vector<BSONObj>::const_iterator i = batch.begin(); i != batch.end(); ++i )
+                        prefetchOpPages(*i);
+
                     try {
                         writelock lk("");
 
@@ -428,8 +575,23 @@ namespace mongo {
                             return;
                         }
 
-                        syncApply(o);
-                        _logOpObjRS(o);   // with repl sets we write the ops to our oplog too 
+                        for( vector<BSONObj>::const_iterator i = batch.begin(); i != batch.end(); ) {
+                            /* a document $set many times in a row in one batch
+                               (counter style workloads) applies once with the
+                               merged modifier.  each original op still lands in
+                               our oplog below so it remains a faithful copy. */
+                            vector<BSONObj>::const_iterator j = i + 1;
+                            if( isPlainSetOp(*i) )
+                                while( j != batch.end() && isPlainSetOp(*j) && sameUpdateTarget(*i, *j) )
+                                    j++;
+                            if( j - i > 1 )
+                                syncApply( coalesceSetRun(i, j) );
+                            else
+                                syncApply(*i);
+                            for( ; i != j; ++i )
+                                _logOpObjRS(*i);   // with repl sets we write the ops to our oplog too
+                        }
+                        getDur().commitIfNeeded();
                     }
                     catch (DBException& e) {
                         sethbmsg(str::stream() << "syncTail: " << e.toString() << ", syncing: " << o);
@@ -520,6 +682,7 @@ namespace mongo {
 
         Client::initThread("rsSync");
         cc().iAmSyncThread(); // for isSyncThread() (which is used not used much, is used in secondary create index code
+        cc().setOpPriority( CurOp::LOW ); // background sync yields to user reads
         replLocalAuth();
         theReplSet->syncThread();
         cc().shutdown();
@@ -550,20 +713,40 @@ namespace mongo {
     }
 
     void GhostSync::updateSlave(const mongo::OID& rid, const OpTime& last) {
-        rwlock lk( _lock , false );
+        rwlock lk( _lock , true );
         MAP::iterator i = _ghostCache.find( rid );
         if ( i == _ghostCache.end() ) {
             OCCASIONALLY warning() << "couldn't update slave " << rid << " no entry" << rsLog;
             return;
         }
-        
+
         GhostSlave& slave = i->second;
         if (!slave.init) {
-            OCCASIONALLY log() << "couldn't update slave " << rid << " not init" << rsLog;            
+            OCCASIONALLY log() << "couldn't update slave " << rid << " not init" << rsLog;
             return;
         }
 
-        ((ReplSetConfig::MemberCfg)slave.slave->config()).updateGroups(last);
+        slave.acked = last;
+
+        const ReplSetConfig& cfg = rs->config();
+        if ( cfg.rules.empty() )
+            return;
+
+        // which members have reported reaching `last`, as a bitmask
+        ReplSetConfig::MemberSet upToDate = 0;
+        for ( MAP::const_iterator j = _ghostCache.begin(); j != _ghostCache.end(); j++ ) {
+            const GhostSlave& s = j->second;
+            if ( s.init && !( s.acked < last ) )
+                upToDate |= cfg.memberMask( s.slave->id() );
+        }
+
+        // advance each getLastError mode whose compiled masks are satisfied
+        for ( map<string,ReplSetConfig::TagRule*>::const_iterator r = cfg.rules.begin();
+              r != cfg.rules.end(); r++ ) {
+            ReplSetConfig::TagRule* rule = r->second;
+            if ( rule->last < last && rule->satisfiedBy( upToDate ) )
+                rule->last = last;
+        }
     }
 
     void GhostSync::percolate(const BSONObj& id, const OpTime& last) {
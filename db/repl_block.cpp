@@ -67,6 +67,19 @@ namespace mongo {
             OpTime * loc;
         };
 
+        /* a getLastError w:N wait parked on the stack of its connection thread.
+           update() signals the waiter's own condition the moment a slave report
+           satisfies it - no broadcast, no polling interval. */
+        struct Waiter : boost::noncopyable {
+            Waiter( const OpTime& o , int n ) : op(o), needed(n), rule(0), satisfied(false) {}
+            Waiter( const OpTime& o , const ReplSetConfig::TagRule* r ) : op(o), needed(0), rule(r), satisfied(false) {}
+            const OpTime op;
+            const int needed; // # of slaves that must reach op (when rule is null)
+            const ReplSetConfig::TagRule* rule; // compiled getLastError mode, if waiting on one
+            bool satisfied;
+            boost::condition cond;
+        };
+
         SlaveTracking() : _mutex("SlaveTracking") {
             _dirty = false;
             _started = false;
@@ -132,6 +145,7 @@ namespace mongo {
                     i.loc[0] = last;
                 else
                     getDur().setNoJournal(i.loc, &last, sizeof(last));
+                _notifyWaiters( last );
                 return;
             }
 
@@ -143,12 +157,14 @@ namespace mongo {
                 i.owned = false;
                 i.loc = (OpTime*)res["syncedTo"].value();
                 getDur().setNoJournal(i.loc, &last, sizeof(last));
+                _notifyWaiters( last );
                 return;
             }
 
             i.owned = true;
             i.loc = new OpTime(last);
             _dirty = true;
+            _notifyWaiters( last );
 
             if ( ! _started ) {
                 // start background thread here since we definitely need it
@@ -158,6 +174,29 @@ namespace mongo {
 
         }
 
+        /* _mutex held.  a slave just reported reaching `last`; wake exactly the
+           waiters whose thresholds that satisfies. */
+        void _notifyWaiters( const OpTime& last ) {
+            for ( list<Waiter*>::iterator it = _waiters.begin(); it != _waiters.end(); ) {
+                Waiter * w = *it;
+                bool done;
+                if ( w->rule ) {
+                    // rule->last was just advanced by GhostSync::updateSlave
+                    done = w->op <= w->rule->last;
+                }
+                else {
+                    done = !( last < w->op ) && _slavesHaveReached( w->op , w->needed );
+                }
+                if ( ! done ) {
+                    ++it;
+                    continue;
+                }
+                w->satisfied = true;
+                w->cond.notify_one(); // per waiter - nobody else is woken
+                it = _waiters.erase( it );
+            }
+        }
+
         bool opReplicatedEnough( OpTime op , BSONElement w ) {
             RARELY {
                 REPLDEBUG( "looking for : " << op << " w=" << w );
@@ -191,15 +230,67 @@ namespace mongo {
 
             w--; // now this is the # of slaves i need
             scoped_lock mylk(_mutex);
+            return _slavesHaveReached( op , w );
+        }
+
+        /* _mutex held */
+        bool _slavesHaveReached( const OpTime& op , int numSlaves ) {
             for ( map<Ident,Info>::iterator i=_slaves.begin(); i!=_slaves.end(); i++) {
                 OpTime s = *(i->second.loc);
                 if ( s < op ) {
                     continue;
                 }
-                if ( --w == 0 )
+                if ( --numSlaves == 0 )
                     return true;
             }
-            return w <= 0;
+            return numSlaves <= 0;
+        }
+
+        /** park until w-1 slaves have reached op, or millis elapse.  update()
+            signals us directly when a slave report crosses the threshold, so
+            there is no polling interval on the satisfied path.
+            @return true if replicated to enough slaves */
+        bool waitForReplicatedToNum( OpTime& op , int w , int millis ) {
+            if ( w <= 1 || ! _isMaster() )
+                return true;
+
+            w--; // now this is the # of slaves i need
+            Waiter waiter( op , w );
+            scoped_lock mylk(_mutex);
+            if ( _slavesHaveReached( op , w ) )
+                return true;
+            return _park( waiter , mylk , millis );
+        }
+
+        /** park until the given getLastError mode's compiled rule is satisfied,
+            or millis elapse.  @return true if the rule was satisfied */
+        bool waitForRule( OpTime& op , const ReplSetConfig::TagRule* rule , int millis ) {
+            if ( op <= rule->last )
+                return true;
+            Waiter waiter( op , rule );
+            scoped_lock mylk(_mutex);
+            if ( op <= rule->last ) // re-check now that we hold _mutex
+                return true;
+            return _park( waiter , mylk , millis );
+        }
+
+        /* _mutex held.  parks waiter until satisfied or millis elapse. */
+        bool _park( Waiter& waiter , scoped_lock& mylk , int millis ) {
+            _waiters.push_back( &waiter );
+            boost::xtime xt;
+            boost::xtime_get(&xt, boost::TIME_UTC);
+            xt.sec += millis / 1000;
+            xt.nsec += ( millis % 1000 ) * 1000000;
+            if ( xt.nsec >= 1000000000 ) {
+                xt.nsec -= 1000000000;
+                xt.sec += 1;
+            }
+            while ( ! waiter.satisfied ) {
+                if ( ! waiter.cond.timed_wait( mylk.boost() , xt ) )
+                    break; // timed out; caller rechecks and handles wtimeout/interrupt
+            }
+            _waiters.remove( &waiter );
+            return waiter.satisfied;
         }
 
         unsigned getSlaveCount() const {
@@ -211,6 +302,7 @@ namespace mongo {
         // need to be careful not to deadlock with this
         mutable mongo::mutex _mutex;
         map<Ident,Info> _slaves;
+        list<Waiter*> _waiters; // stack-resident; each is removed by its owner before returning
         bool _dirty;
         bool _started;
 
@@ -248,6 +340,21 @@ namespace mongo {
         return slaveTracking.replicatedToNum( op , w );
     }
 
+    bool waitForReplicatedEnough( OpTime op , BSONElement w , int millis ) {
+        if ( w.isNumber() )
+            return slaveTracking.waitForReplicatedToNum( op , w.numberInt() , millis );
+        if ( theReplSet && w.type() == String ) {
+            if ( w.String() == "majority" )
+                return slaveTracking.waitForReplicatedToNum( op , theReplSet->config().members.size()/2+1 , millis );
+            map<string,ReplSetConfig::TagRule*>::const_iterator it = theReplSet->config().rules.find(w.String());
+            if ( it != theReplSet->config().rules.end() )
+                return slaveTracking.waitForRule( op , (*it).second , millis );
+        }
+        // unknown mode; let the caller's recheck raise the error
+        sleepmillis(1);
+        return false;
+    }
+
     void resetSlaveCache() {
         slaveTracking.reset();
     }
@@ -34,6 +34,11 @@ namespace mongo {
     bool opReplicatedEnough( OpTime op , int w );
     bool opReplicatedEnough( OpTime op , BSONElement w );
 
+    /** block up to millis waiting for op to make it to w servers, woken the
+        moment a slave's reported optime satisfies the wait (no polling).
+        @return true if replicated to enough servers */
+    bool waitForReplicatedEnough( OpTime op , BSONElement w , int millis );
+
     void resetSlaveCache();
     unsigned getSlaveCount();
 }
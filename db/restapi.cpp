@@ -237,9 +237,15 @@ namespace mongo {
     } restHandler;
 
     bool RestAdminAccess::haveAdminUsers() const {
+        unsigned long long now = curTimeMillis64();
+        if ( _lastChecked && now - _lastChecked < CacheMillis )
+            return _haveAdminUsers;
+
         readlocktryassert rl("admin.system.users", 10000);
         Client::Context cx( "admin.system.users", dbpath, NULL, false );
-        return ! Helpers::isEmpty("admin.system.users", false);
+        _haveAdminUsers = ! Helpers::isEmpty("admin.system.users", false);
+        _lastChecked = now;
+        return _haveAdminUsers;
     }
 
     BSONObj RestAdminAccess::getAdminUser( const string& username ) const {
@@ -254,13 +260,17 @@ namespace mongo {
 
     class LowLevelMongodStatus : public WebStatusPlugin {
     public:
-        LowLevelMongodStatus() : WebStatusPlugin( "low level" , 5 , "requires read lock" ) {}
+        LowLevelMongodStatus() : WebStatusPlugin( "low level" , 5 ) {}
 
         virtual void init() {}
 
-        void _gotLock( int millis , stringstream& ss ) {
+        virtual void run( stringstream& ss ) {
+            // rendered without touching dbMutex so monitoring polls never
+            // contend with production ops
             ss << "<pre>\n";
-            ss << "time to get readlock: " << millis << "ms\n";
+            ss << "write locked now: " << ( dbMutex.info().isLocked() ? "true" : "false" ) << '\n';
+            ss << "writers waiting: " << dbMutex.writersWaiting()
+               << "  readers waiting: " << dbMutex.readersWaiting() << '\n';
 
             ss << "# databases: " << dbHolder.size() << '\n';
 
@@ -285,16 +295,5 @@ namespace mongo {
             BackgroundOperation::dump(ss);
             ss << "</pre>\n";
         }
-
-        virtual void run( stringstream& ss ) {
-            Timer t;
-            readlocktry lk( "" , 300 );
-            if ( lk.got() ) {
-                _gotLock( t.millis() , ss );
-            }
-            else {
-                ss << "\n<b>timed out getting lock</b>\n";
-            }
-        }
     } lowLevelMongodStatus;
 }
@@ -25,10 +25,18 @@ namespace mongo {
 
     class RestAdminAccess : public AdminAccess {
     public:
+        RestAdminAccess() : _haveAdminUsers(false), _lastChecked(0) { }
         virtual ~RestAdminAccess() { }
 
         virtual bool haveAdminUsers() const;
         virtual BSONObj getAdminUser( const string& username ) const;
+
+    private:
+        enum { CacheMillis = 10 * 1000 };
+        // cached so status page polls don't take the read lock per request.
+        // a newly added admin user may take CacheMillis to be enforced here.
+        mutable bool _haveAdminUsers;
+        mutable unsigned long long _lastChecked;
     };
 
 } // namespace mongo
@@ -20,27 +20,34 @@
 
 #include "pch.h"
 #include "scanandorder.h"
+#include "curop-inl.h"
 
 namespace mongo {
 
     const unsigned ScanAndOrder::MaxScanAndOrderBytes = 32 * 1024 * 1024;
 
-    void ScanAndOrder::_add(BSONObj& k, BSONObj o, DiskLoc* loc) {
-        if (!loc) {
-            _best.insert(make_pair(k.getOwned(),o.getOwned()));
-        }
-        else {
-            BSONObjBuilder b;
-            b.appendElements(o);
-            b.append("$diskLoc", loc->toBSONObj());
-            _best.insert(make_pair(k.getOwned(), b.obj().getOwned()));
-        }
+    ScanAndOrder::~ScanAndOrder() {
+        if ( _approxSize && haveClient() )
+            cc().curop()->noteMemFreed( _approxSize );
+    }
+
+    BSONObj ScanAndOrder::_ownedWithLoc(BSONObj& o, DiskLoc* loc) {
+        if ( !loc )
+            return o.getOwned();
+        BSONObjBuilder b;
+        b.appendElements(o);
+        b.append("$diskLoc", loc->toBSONObj());
+        return b.obj();
+    }
+
+    void ScanAndOrder::_add(const KeyV1Shared& k, BSONObj o, DiskLoc* loc) {
+        _best.insert(make_pair(k, _ownedWithLoc(o, loc)));
     }
 
-    void ScanAndOrder::_addIfBetter(BSONObj& k, BSONObj o, BestMap::iterator i, DiskLoc* loc) {
+    void ScanAndOrder::_addIfBetter(const KeyV1Shared& k, BSONObj o, BestMap::iterator i, DiskLoc* loc) {
         /* todo : we don't correct _approxSize here. */
-        const BSONObj& worstBestKey = i->first;
-        int c = worstBestKey.woCompare(k, _order._spec.keyPattern);
+        const KeyV1Shared& worstBestKey = i->first;
+        int c = worstBestKey.woCompare(k, _ordering);
         if ( c > 0 ) {
             // k is better, 'upgrade'
             _best.erase(i);
@@ -49,31 +56,87 @@ namespace mongo {
     }
 
 
+    /* with a limit, we only ever hold the best limit+skip entries: a max-heap
+       keyed on KeyV1 compressed sort keys with the current worst at the front.
+       a losing candidate costs one compressed-key compare; a winner evicts the
+       worst in O(log k).  fill() sorts the survivors.
+    */
+    void ScanAndOrder::_addWithHeap(const KeyV1Shared& k, BSONObj o, DiskLoc* loc) {
+        HeapEntry e;
+        e.key = k;
+        HeapEntryCmp cmp(_ordering);
+        if ( (int) _heap.size() < _limit ) {
+            _approxSize += e.key.dataSize();
+            _approxSize += o.objsize();
+
+            /* note : adjust when bson return limit adjusts. note this limit should be a bit higher. */
+            uassert( 15907 ,  "too much data for sort() with no index.  add an index or specify a smaller limit", _approxSize < MaxScanAndOrderBytes );
+            cc().curop()->noteMemUsed( e.key.dataSize() + o.objsize() );
+
+            e.o = _ownedWithLoc(o, loc);
+            _heap.push_back(e);
+            push_heap(_heap.begin(), _heap.end(), cmp);
+            return;
+        }
+        if ( e.key.woCompare( _heap.front().key, _ordering ) < 0 ) {
+            // better than the worst we have, 'upgrade'
+            pop_heap(_heap.begin(), _heap.end(), cmp);
+            _heap.pop_back();
+            e.o = _ownedWithLoc(o, loc);
+            _heap.push_back(e);
+            push_heap(_heap.begin(), _heap.end(), cmp);
+        }
+    }
+
     void ScanAndOrder::add(BSONObj o, DiskLoc* loc) {
         assert( o.isValid() );
         BSONObj k = _order.getKeyFromObject(o);
         if ( k.isEmpty() ) {
-            return;   
+            return;
+        }
+        KeyV1Shared key(k); // compress the sort key; we may hold many of these
+        if ( _useHeap ) {
+            _addWithHeap(key, o, loc);
+            return;
         }
         if ( (int) _best.size() < _limit ) {
-            _approxSize += k.objsize();
+            _approxSize += key.dataSize();
             _approxSize += o.objsize();
             
             /* note : adjust when bson return limit adjusts. note this limit should be a bit higher. */
             uassert( 10128 ,  "too much data for sort() with no index.  add an index or specify a smaller limit", _approxSize < MaxScanAndOrderBytes );
-            
-            _add(k, o, loc);
+            cc().curop()->noteMemUsed( key.dataSize() + o.objsize() );
+
+            _add(key, o, loc);
             return;
         }
         BestMap::iterator i;
         assert( _best.end() != _best.begin() );
         i = _best.end();
         i--;
-        _addIfBetter(k, o, i, loc);
+        _addIfBetter(key, o, i, loc);
     }
 
 
     void ScanAndOrder::fill(BufBuilder& b, Projection *filter, int& nout ) const {
+        if ( _useHeap ) {
+            vector<HeapEntry> sorted(_heap);
+            sort(sorted.begin(), sorted.end(), HeapEntryCmp(_ordering));
+            int n = 0;
+            int nFilled = 0;
+            for ( unsigned i = 0; i < sorted.size(); i++ ) {
+                n++;
+                if ( n <= _startFrom )
+                    continue;
+                fillQueryResultFromObj(b, filter, sorted[i].o);
+                nFilled++;
+                if ( nFilled >= _limit )
+                    break;
+                uassert( 10129 ,  "too much data for sort() with no index", b.len() < (int)MaxScanAndOrderBytes ); // appserver limit
+            }
+            nout = nFilled;
+            return;
+        }
         int n = 0;
         int nFilled = 0;
         for ( BestMap::const_iterator i = _best.begin(); i != _best.end(); i++ ) {
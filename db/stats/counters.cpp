@@ -23,23 +23,26 @@
 namespace mongo {
 
     OpCounters::OpCounters() {
-        int zero = 0;
+    }
 
-        BSONObjBuilder b;
-        b.append( "insert" , zero );
-        b.append( "query" , zero );
-        b.append( "update" , zero );
-        b.append( "delete" , zero );
-        b.append( "getmore" , zero );
-        b.append( "command" , zero );
-        _obj = b.obj();
-
-        _insert = (AtomicUInt*)_obj["insert"].value();
-        _query = (AtomicUInt*)_obj["query"].value();
-        _update = (AtomicUInt*)_obj["update"].value();
-        _delete = (AtomicUInt*)_obj["delete"].value();
-        _getmore = (AtomicUInt*)_obj["getmore"].value();
-        _command = (AtomicUInt*)_obj["command"].value();
+    OpCounters::Slot& OpCounters::_slot() {
+        int s = _mySlot.get();
+        if ( s == 0 ) {
+            s = ( _nextSlot++ % NumSlots ) + 1;
+            _mySlot.set( s );
+        }
+        return _slots[ s - 1 ];
+    }
+
+    void OpCounters::_zeroAll() {
+        for( int i = 0; i < NumSlots; ++i ) {
+            _slots[i].insert.zero();
+            _slots[i].query.zero();
+            _slots[i].update.zero();
+            _slots[i].del.zero();
+            _slots[i].getmore.zero();
+            _slots[i].command.zero();
+        }
     }
 
     void OpCounters::gotOp( int op , bool isCommand ) {
@@ -63,28 +66,33 @@ namespace mongo {
         }
     }
 
-    BSONObj& OpCounters::getObj() {
-        const unsigned MAX = 1 << 30;
+    BSONObj OpCounters::getObj() {
+        unsigned long long insert = 0, query = 0, update = 0, del = 0, getmore = 0, command = 0;
+        for( int i = 0; i < NumSlots; ++i ) {
+            insert += _slots[i].insert.get();
+            query += _slots[i].query.get();
+            update += _slots[i].update.get();
+            del += _slots[i].del.get();
+            getmore += _slots[i].getmore.get();
+            command += _slots[i].command.get();
+        }
+
+        const unsigned long long MAX = 1 << 30;
         RARELY {
-            bool wrap =
-            _insert->get() > MAX ||
-            _query->get() > MAX ||
-            _update->get() > MAX ||
-            _delete->get() > MAX ||
-            _getmore->get() > MAX ||
-            _command->get() > MAX;
-
-            if ( wrap ) {
-                _insert->zero();
-                _query->zero();
-                _update->zero();
-                _delete->zero();
-                _getmore->zero();
-                _command->zero();
+            if ( insert > MAX || query > MAX || update > MAX ||
+                 del > MAX || getmore > MAX || command > MAX ) {
+                _zeroAll();
             }
-
         }
-        return _obj;
+
+        BSONObjBuilder b;
+        b.append( "insert" , (int) insert );
+        b.append( "query" , (int) query );
+        b.append( "update" , (int) update );
+        b.append( "delete" , (int) del );
+        b.append( "getmore" , (int) getmore );
+        b.append( "command" , (int) command );
+        return b.obj();
     }
 
     IndexCounters::IndexCounters() {
@@ -29,41 +29,49 @@ namespace mongo {
      * for storing operation counters
      * note: not thread safe.  ok with that for speed
      */
+    /**
+     * operation counters, sharded over a small set of cache line padded slots so
+     * that connection threads incrementing them at high op rates don't bounce a
+     * single hot line between cores.  each thread sticks to one slot (assigned
+     * round robin on first use); readers sum the slots in getObj(), which is
+     * rare (serverStatus, snapshots) relative to increments.
+     */
     class OpCounters {
     public:
 
         OpCounters();
 
-        AtomicUInt * getInsert() { return _insert; }
-        AtomicUInt * getQuery() { return _query; }
-        AtomicUInt * getUpdate() { return _update; }
-        AtomicUInt * getDelete() { return _delete; }
-        AtomicUInt * getGetMore() { return _getmore; }
-        AtomicUInt * getCommand() { return _command; }
-
-        void incInsertInWriteLock(int n) { _insert->x += n; }
-        void gotInsert() { _insert[0]++; }
-        void gotQuery() { _query[0]++; }
-        void gotUpdate() { _update[0]++; }
-        void gotDelete() { _delete[0]++; }
-        void gotGetMore() { _getmore[0]++; }
-        void gotCommand() { _command[0]++; }
+        void incInsertInWriteLock(int n) { _slot().insert.x += n; }
+        void gotInsert() { _slot().insert++; }
+        void gotQuery() { _slot().query++; }
+        void gotUpdate() { _slot().update++; }
+        void gotDelete() { _slot().del++; }
+        void gotGetMore() { _slot().getmore++; }
+        void gotCommand() { _slot().command++; }
 
         void gotOp( int op , bool isCommand );
 
-        BSONObj& getObj();
+        BSONObj getObj();
 
     private:
-        BSONObj _obj;
-
-        // todo: there will be a lot of cache line contention on these.  need to do something 
-        //       else eventually.
-        AtomicUInt * _insert;
-        AtomicUInt * _query;
-        AtomicUInt * _update;
-        AtomicUInt * _delete;
-        AtomicUInt * _getmore;
-        AtomicUInt * _command;
+        enum { NumSlots = 16 };
+
+        struct Slot {
+            AtomicUInt insert;
+            AtomicUInt query;
+            AtomicUInt update;
+            AtomicUInt del;
+            AtomicUInt getmore;
+            AtomicUInt command;
+            char pad[ 64 - 6 * sizeof(AtomicUInt) ]; // one cache line per slot
+        };
+
+        Slot& _slot();
+        void _zeroAll();
+
+        Slot _slots[NumSlots];
+        AtomicUInt _nextSlot;
+        ThreadLocalValue<int> _mySlot; // 0 = unassigned, else slot index + 1
     };
 
     extern OpCounters globalOpCounters;
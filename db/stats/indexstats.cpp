@@ -0,0 +1,56 @@
+// indexstats.cpp
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+#include "indexstats.h"
+
+namespace mongo {
+
+    IndexUsage IndexUsage::global;
+
+    void IndexUsage::noteAccess( const string& indexNs ) {
+        scoped_lock lk( _lock );
+        Data& d = _usage[indexNs];
+        d.accesses++;
+        d.lastAccess = jsTime();
+    }
+
+    void IndexUsage::noteInserted( const string& indexNs , int nKeys ) {
+        scoped_lock lk( _lock );
+        _usage[indexNs].keysInserted += nKeys;
+    }
+
+    void IndexUsage::noteRemoved( const string& indexNs , int nKeys ) {
+        scoped_lock lk( _lock );
+        _usage[indexNs].keysRemoved += nKeys;
+    }
+
+    void IndexUsage::forget( const string& indexNs ) {
+        scoped_lock lk( _lock );
+        _usage.erase( indexNs );
+    }
+
+    IndexUsage::Data IndexUsage::get( const string& indexNs ) const {
+        scoped_lock lk( _lock );
+        map<string,Data>::const_iterator i = _usage.find( indexNs );
+        if ( i == _usage.end() )
+            return Data();
+        return i->second;
+    }
+
+}
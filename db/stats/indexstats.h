@@ -0,0 +1,59 @@
+// indexstats.h : per index read and maintenance counters
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+namespace mongo {
+
+    /**
+     * in memory per index counters: how often an index is read versus what
+     * its upkeep costs on the write path.  keyed by the index's own
+     * namespace (e.g. test.foo.$x_1).  evidence for dropping dead indexes -
+     * an index with months of keysInserted and zero accesses pays rent on
+     * every insert for nothing.  counters reset on restart; see the
+     * indexStats command.
+     */
+    class IndexUsage {
+    public:
+        IndexUsage() : _lock( "IndexUsage" ) {}
+
+        struct Data {
+            Data() : accesses(0), keysInserted(0), keysRemoved(0), lastAccess(0) {}
+            long long accesses;     // btree cursors opened over this index
+            long long keysInserted; // maintenance done for inserts and updates
+            long long keysRemoved;  // maintenance done for deletes and updates
+            Date_t lastAccess;      // 0 = not read since startup
+        };
+
+        void noteAccess( const string& indexNs );
+        void noteInserted( const string& indexNs , int nKeys );
+        void noteRemoved( const string& indexNs , int nKeys );
+
+        /** the index was dropped - stop carrying its counters */
+        void forget( const string& indexNs );
+
+        Data get( const string& indexNs ) const;
+
+        static IndexUsage global;
+
+    private:
+        mutable mongo::mutex _lock;
+        map<string,Data> _usage; // index ns -> counters
+    };
+
+}
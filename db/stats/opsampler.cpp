@@ -0,0 +1,176 @@
+// opsampler.cpp
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "pch.h"
+#include "opsampler.h"
+#include "../commands.h"
+#include "../../util/net/message.h"
+
+namespace mongo {
+
+    OpSampler OpSampler::global;
+
+    namespace {
+
+        /* render the structure of a query - field names and operators, no
+           values - e.g. { x : { $gt : 7 }, y : 1 } becomes "{ x: { $gt }, y }" */
+        void shapeString( const BSONObj& o, StringBuilder& s ) {
+            s << "{ ";
+            bool first = true;
+            BSONObjIterator i( o );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( !first )
+                    s << ", ";
+                first = false;
+                s << e.fieldName();
+                if ( e.type() == Object || e.type() == Array ) {
+                    s << ": ";
+                    shapeString( e.embeddedObject(), s );
+                }
+            }
+            s << " }";
+        }
+
+        unsigned long long hashChars( const char *p, unsigned long long h ) {
+            while ( *p )
+                h = h * 131 + (unsigned char)*p++;
+            return h;
+        }
+    }
+
+    void OpSampler::record( const char *ns, int op, const BSONObj& query, long long micros, int nscanned, int nreturned ) {
+        StringBuilder shape;
+        if ( ! query.isEmpty() )
+            shapeString( query, shape );
+        string ss = shape.str();
+
+        unsigned long long h = hashChars( ns, 0 );
+        h = h * 131 + op;
+        h = hashChars( ss.c_str(), h );
+        if ( h == 0 )
+            h = 1;
+
+        /* two threads landing on the same slot requires a full wrap of the
+           ring between their increments - possible, rare, harmless here */
+        Record& r = _records[ _pos++ % NumRecords ];
+        r.shapeHash = 0; // readers skip us while we scribble
+        r.ts = curTimeMillis64();
+        r.micros = micros;
+        r.op = op;
+        r.nscanned = nscanned;
+        r.nreturned = nreturned;
+        strncpy( r.ns, ns, MaxNs - 1 );
+        r.ns[MaxNs-1] = 0;
+        strncpy( r.shape, ss.c_str(), MaxShape - 1 );
+        r.shape[MaxShape-1] = 0;
+        r.shapeHash = h;
+    }
+
+    void OpSampler::reset() {
+        for ( int i = 0; i < NumRecords; i++ )
+            _records[i].shapeHash = 0;
+    }
+
+    namespace {
+        struct ShapeAgg {
+            ShapeAgg() : count(0), totalMicros(0), maxMicros(0), nscanned(0), nreturned(0), example(-1) {}
+            long long count;
+            long long totalMicros;
+            long long maxMicros;
+            long long nscanned;
+            long long nreturned;
+            int example; // ring index of a representative record
+        };
+    }
+
+    void OpSampler::append( BSONObjBuilder& b, int max ) const {
+        typedef map<unsigned long long,ShapeAgg> AggMap;
+        AggMap aggs;
+        long long sampled = 0;
+
+        for ( int i = 0; i < NumRecords; i++ ) {
+            const Record& r = _records[i];
+            if ( r.shapeHash == 0 )
+                continue;
+            sampled++;
+            ShapeAgg& a = aggs[ r.shapeHash ];
+            a.count++;
+            a.totalMicros += r.micros;
+            if ( r.micros > a.maxMicros )
+                a.maxMicros = r.micros;
+            a.nscanned += r.nscanned;
+            a.nreturned += r.nreturned;
+            if ( a.example < 0 )
+                a.example = i;
+        }
+
+        b.append( "sampleRate", (int)SampleEvery );
+        b.append( "bufferSize", (int)NumRecords );
+        b.appendNumber( "sampled", sampled );
+
+        vector< pair<long long,unsigned long long> > ranked;
+        for ( AggMap::const_iterator i = aggs.begin(); i != aggs.end(); ++i )
+            ranked.push_back( make_pair( i->second.totalMicros, i->first ) );
+        sort( ranked.rbegin(), ranked.rend() );
+
+        BSONArrayBuilder arr( b.subarrayStart( "shapes" ) );
+        int n = 0;
+        for ( vector< pair<long long,unsigned long long> >::const_iterator i = ranked.begin();
+              i != ranked.end() && n < max; ++i, ++n ) {
+            const ShapeAgg& a = aggs[ i->second ];
+            const Record& ex = _records[ a.example ];
+            BSONObjBuilder s( arr.subobjStart() );
+            s.append( "ns", ex.ns );
+            s.append( "op", opToString( ex.op ) );
+            if ( ex.shape[0] )
+                s.append( "shape", ex.shape );
+            s.appendNumber( "count", a.count );
+            s.appendNumber( "totalMicros", a.totalMicros );
+            s.appendNumber( "maxMicros", a.maxMicros );
+            s.append( "avgMicros", a.count ? (int)( a.totalMicros / a.count ) : 0 );
+            s.appendNumber( "nscanned", a.nscanned );
+            s.appendNumber( "nreturned", a.nreturned );
+            s.done();
+        }
+        arr.done();
+    }
+
+    /* report the sampled ops aggregated by query shape, most total time first.
+       { opSamples : 1 }                 top 20 shapes
+       { opSamples : 1, max : 50 }      top 50
+       { opSamples : 1, reset : true }  also clear the buffer afterwards
+    */
+    class CmdOpSamples : public Command {
+    public:
+        CmdOpSamples() : Command( "opSamples" ) {}
+        virtual bool slaveOk() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "report sampled operations aggregated by query shape.  { opSamples : 1, max : <n>, reset : <bool> }";
+        }
+        virtual bool run(const string&, BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool) {
+            int max = cmdObj["max"].isNumber() ? cmdObj["max"].numberInt() : 20;
+            OpSampler::global.append( result, max );
+            if ( cmdObj["reset"].trueValue() )
+                OpSampler::global.reset();
+            return true;
+        }
+    } cmdOpSamples;
+
+} // namespace mongo
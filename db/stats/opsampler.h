@@ -0,0 +1,87 @@
+// opsampler.h : sampled operation profiler
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "../../pch.h"
+#include "../jsobj.h"
+#include "../../bson/util/atomic_int.h"
+
+namespace mongo {
+
+    /** always-on sampling profiler.
+
+        unlike the system.profile profiler, which writes a document through the
+        full storage path for every profiled op while holding locks, this keeps
+        1 of every SampleEvery completed ops as a fixed size record in a lock
+        free ring buffer: two atomic increments on the hot path, no allocation,
+        no locks, no collection writes.  records carry a query *shape* (field
+        names and operators, no values) and its hash so the opSamples command
+        can aggregate cheaply by shape.
+
+        readers scan the ring without locking, so a record being overwritten
+        concurrently can be seen torn.  this is diagnostic data; an occasional
+        garbled sample is acceptable and shapeHash==0 slots are skipped.
+    */
+    class OpSampler {
+    public:
+        enum {
+            NumRecords = 4096,  // ring slots (~1MB)
+            SampleEvery = 4,    // keep 1 of this many ops
+            MaxNs = 128,
+            MaxShape = 80
+        };
+
+        struct Record {
+            unsigned long long shapeHash; // 0 = empty / being written
+            unsigned long long ts;        // curTimeMillis64() at op completion
+            long long micros;
+            int op;                       // enum Operations, or 0 for a command
+            int nscanned;
+            int nreturned;
+            char ns[MaxNs];
+            char shape[MaxShape];         // truncated shape rendering, e.g. "{ x, y: { $gt } }"
+        };
+
+        OpSampler() {
+            memset( _records, 0, sizeof(_records) );
+        }
+
+        /** hot path gate: one atomic increment.  @return true if this op is
+            sampled, in which case the caller gathers the (pricier) arguments
+            and calls record(). */
+        bool tick() { return ( _ticket++ % SampleEvery ) == 0; }
+
+        /** store a sampled operation.  only call when tick() returned true.
+            @param query the op's query, if any (shapes the sample); values are not kept */
+        void record( const char *ns, int op, const BSONObj& query, long long micros, int nscanned, int nreturned );
+
+        /** aggregate the ring by query shape into b.  no locking - see class comment. */
+        void append( BSONObjBuilder& b, int max ) const;
+
+        void reset();
+
+        static OpSampler global;
+
+    private:
+        AtomicUInt _ticket; // decides which ops get sampled
+        AtomicUInt _pos;    // next ring slot
+        Record _records[NumRecords];
+    };
+
+} // namespace mongo
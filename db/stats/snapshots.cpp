@@ -81,6 +81,19 @@ namespace mongo {
         return p;
     }
 
+    void Snapshots::refresh( unsigned maxAgeMillis ) {
+        {
+            scoped_lock lk(_lock);
+            if ( _stored > 0 ) {
+                unsigned long long age = curTimeMicros64() - _snapshots[_loc]._created;
+                if ( age < maxAgeMillis * 1000ULL )
+                    return;
+            }
+        }
+        // racing refreshes just produce an extra snapshot, which is harmless
+        takeSnapshot();
+    }
+
     const SnapshotData& Snapshots::getPrev( int numBack ) {
         int x = _loc - numBack;
         if ( x < 0 )
@@ -141,6 +154,7 @@ namespace mongo {
         virtual void init() {}
 
         virtual void run( stringstream& ss ) {
+            statsSnapshots.refresh();
             statsSnapshots.outputLockInfoHTML( ss );
 
             ss << "<a "
@@ -188,6 +202,7 @@ namespace mongo {
         }
 
         void run( stringstream& ss ) {
+            statsSnapshots.refresh();
             auto_ptr<SnapshotDelta> delta = statsSnapshots.computeDelta();
             if ( ! delta.get() )
                 return;
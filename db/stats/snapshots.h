@@ -86,6 +86,16 @@ namespace mongo {
 
         const SnapshotData* takeSnapshot();
 
+        /**
+         * takes a new snapshot unless the current one is younger than
+         * maxAgeMillis.  Top's counters are monotonic, so snapshots only need
+         * to exist when somebody wants a delta - this is called lazily from
+         * the display paths rather than from a periodic thread, which on
+         * nodes with many namespaces made copying Top::_usage a recurring
+         * stall even with no observers.
+         */
+        void refresh( unsigned maxAgeMillis = 1000 );
+
         int numDeltas() const { return _stored-1; }
 
         const SnapshotData& getPrev( int numBack = 0 );
@@ -101,6 +111,7 @@ namespace mongo {
         int _stored;
     };
 
+    /** only started when --cpu is set - snapshots are otherwise taken on demand */
     class SnapshotThread : public BackgroundJob {
     public:
         virtual string name() const { return "snapshot"; }
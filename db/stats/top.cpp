@@ -27,6 +27,8 @@ namespace mongo {
         // this won't be 100% accurate on rollovers and drop(), but at least it won't be negative
         time  = (newer.time  >= older.time)  ? (newer.time  - older.time)  : newer.time;
         count = (newer.count >= older.count) ? (newer.count - older.count) : newer.count;
+        for ( int i = 0; i < NBins; i++ )
+            hist[i] = (newer.hist[i] >= older.hist[i]) ? (newer.hist[i] - older.hist[i]) : newer.hist[i];
     }
 
     Top::CollectionData::CollectionData( const CollectionData& older , const CollectionData& newer )
@@ -39,7 +41,8 @@ namespace mongo {
           update( older.update , newer.update ) ,
           remove( older.remove , newer.remove ),
           commands( older.commands , newer.commands ) {
-
+        faultChecks = (newer.faultChecks >= older.faultChecks) ? (newer.faultChecks - older.faultChecks) : newer.faultChecks;
+        faults = (newer.faults >= older.faults) ? (newer.faults - older.faults) : newer.faults;
     }
 
     void Top::record( const string& ns , int op , int lockType , long long micros , bool command ) {
@@ -101,6 +104,20 @@ namespace mongo {
 
     }
 
+    void Top::faultCheck( const string& ns , bool inMemory ) {
+        if ( ns.empty() || ns[0] == '?' )
+            return;
+
+        scoped_lock lk(_lock);
+        CollectionData& coll = _usage[ns];
+        coll.faultChecks++;
+        _global.faultChecks++;
+        if ( ! inMemory ) {
+            coll.faults++;
+            _global.faults++;
+        }
+    }
+
     void Top::collectionDropped( const string& ns ) {
         //cout << "collectionDropped: " << ns << endl;
         scoped_lock lk(_lock);
@@ -113,37 +130,63 @@ namespace mongo {
         out = _usage;
     }
 
-    void Top::append( BSONObjBuilder& b ) {
+    void Top::append( BSONObjBuilder& b , bool histograms ) {
         scoped_lock lk( _lock );
-        _appendToUsageMap( b , _usage );
+        _appendToUsageMap( b , _usage , histograms );
     }
 
-    void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const {
+    void Top::appendLatencyStats( BSONObjBuilder& b ) {
+        scoped_lock lk( _lock );
+        _appendHistogram( b , "total" , _global.total );
+        _appendHistogram( b , "queries" , _global.queries );
+        _appendHistogram( b , "getmore" , _global.getmore );
+        _appendHistogram( b , "insert" , _global.insert );
+        _appendHistogram( b , "update" , _global.update );
+        _appendHistogram( b , "remove" , _global.remove );
+        _appendHistogram( b , "commands" , _global.commands );
+    }
+
+    void Top::_appendToUsageMap( BSONObjBuilder& b , const UsageMap& map , bool histograms ) const {
         for ( UsageMap::const_iterator i=map.begin(); i!=map.end(); i++ ) {
             BSONObjBuilder bb( b.subobjStart( i->first ) );
 
             const CollectionData& coll = i->second;
 
-            _appendStatsEntry( b , "total" , coll.total );
+            _appendStatsEntry( b , "total" , coll.total , histograms );
 
-            _appendStatsEntry( b , "readLock" , coll.readLock );
-            _appendStatsEntry( b , "writeLock" , coll.writeLock );
+            _appendStatsEntry( b , "readLock" , coll.readLock , histograms );
+            _appendStatsEntry( b , "writeLock" , coll.writeLock , histograms );
 
-            _appendStatsEntry( b , "queries" , coll.queries );
-            _appendStatsEntry( b , "getmore" , coll.getmore );
-            _appendStatsEntry( b , "insert" , coll.insert );
-            _appendStatsEntry( b , "update" , coll.update );
-            _appendStatsEntry( b , "remove" , coll.remove );
-            _appendStatsEntry( b , "commands" , coll.commands );
+            _appendStatsEntry( b , "queries" , coll.queries , histograms );
+            _appendStatsEntry( b , "getmore" , coll.getmore , histograms );
+            _appendStatsEntry( b , "insert" , coll.insert , histograms );
+            _appendStatsEntry( b , "update" , coll.update , histograms );
+            _appendStatsEntry( b , "remove" , coll.remove , histograms );
+            _appendStatsEntry( b , "commands" , coll.commands , histograms );
 
             bb.done();
         }
     }
 
-    void Top::_appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const {
+    void Top::_appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map , bool histogram ) const {
         BSONObjBuilder bb( b.subobjStart( statsName ) );
         bb.appendNumber( "time" , map.time );
         bb.appendNumber( "count" , map.count );
+        if ( histogram )
+            _appendHistogram( bb , "histogram" , map );
+        bb.done();
+    }
+
+    void Top::_appendHistogram( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const {
+        BSONObjBuilder bb( b.subobjStart( statsName ) );
+        for ( int i = 0; i < UsageData::NBins; i++ ) {
+            if ( map.hist[i] == 0 )
+                continue; // mostly-empty bins would dominate the document
+            if ( i == UsageData::NBins - 1 )
+                bb.appendNumber( "rest" , map.hist[i] );
+            else
+                bb.appendNumber( BSONObjBuilder::numStr( (int)UsageData::binBoundary( i ) ) , map.hist[i] );
+        }
         bb.done();
     }
 
@@ -154,13 +197,13 @@ namespace mongo {
         virtual bool slaveOk() const { return true; }
         virtual bool adminOnly() const { return true; }
         virtual LockType locktype() const { return READ; }
-        virtual void help( stringstream& help ) const { help << "usage by collection, in micros "; }
+        virtual void help( stringstream& help ) const { help << "usage by collection, in micros.  pass latency:true for per-optype latency histograms"; }
 
         virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
             {
                 BSONObjBuilder b( result.subobjStart( "totals" ) );
                 b.append( "note" , "all times in microseconds" );
-                Top::global.append( b );
+                Top::global.append( b , cmdObj["latency"].trueValue() );
                 b.done();
             }
             return true;
@@ -168,6 +211,46 @@ namespace mongo {
 
     } topCmd;
 
+    /* per collection residency estimates from the sampled faultCheck()
+       probes.  tells you which collections are actually causing page
+       faults, which collStats and top cannot. */
+    class WorkingSetCommand : public Command {
+    public:
+        WorkingSetCommand() : Command( "workingSet", true ) {}
+
+        virtual bool slaveOk() const { return true; }
+        virtual bool adminOnly() const { return true; }
+        virtual LockType locktype() const { return NONE; }
+        virtual void help( stringstream& help ) const {
+            help << "sampled per-collection memory residency.  faults/checks approximates\n"
+                    "the fraction of accesses that had to go to disk.";
+        }
+
+        virtual bool run(const string& , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            Top::UsageMap usage;
+            Top::global.cloneMap( usage );
+
+            BSONObjBuilder colls( result.subobjStart( "collections" ) );
+            for ( Top::UsageMap::const_iterator i = usage.begin(); i != usage.end(); i++ ) {
+                const Top::CollectionData& coll = i->second;
+                if ( coll.faultChecks == 0 )
+                    continue; // nothing sampled - no estimate to offer
+                BSONObjBuilder bb( colls.subobjStart( i->first ) );
+                bb.appendNumber( "checks" , coll.faultChecks );
+                bb.appendNumber( "faults" , coll.faults );
+                bb.append( "residentEstimate" , 1.0 - (double)coll.faults / (double)coll.faultChecks );
+                bb.done();
+            }
+            colls.done();
+
+            Top::CollectionData g = Top::global.getGlobalData();
+            result.appendNumber( "checks" , g.faultChecks );
+            result.appendNumber( "faults" , g.faults );
+            return true;
+        }
+
+    } workingSetCmd;
+
     Top Top::global;
 
     TopOld::T TopOld::_snapshotStart = TopOld::currentTime();
@@ -32,22 +32,43 @@ namespace mongo {
         Top() : _lock("Top") { }
 
         struct UsageData {
-            UsageData() : time(0) , count(0) {}
+            UsageData() : time(0) , count(0) { memset( hist , 0 , sizeof(hist) ); }
             UsageData( const UsageData& older , const UsageData& newer );
             long long time;
             long long count;
 
+            /* fixed power-of-two latency bins.  hist[i] counts ops that took
+               less than (64<<i) micros; the last bin takes everything slower.
+               plain array increments, recorded under the same mutex as
+               time/count -- no allocation on the hot path. */
+            enum { NBins = 16 };
+            long long hist[NBins];
+
             void inc( long long micros ) {
                 count++;
                 time += micros;
+                hist[ bin( micros ) ]++;
+            }
+
+            static int bin( long long micros ) {
+                long long t = micros >> 6;
+                int b = 0;
+                while ( t > 0 && b < NBins - 1 ) {
+                    t >>= 1;
+                    b++;
+                }
+                return b;
             }
+
+            /** exclusive upper bound of the b-th bin, in micros */
+            static long long binBoundary( int b ) { return 64LL << b; }
         };
 
         struct CollectionData {
             /**
              * constructs a diff
              */
-            CollectionData() {}
+            CollectionData() : faultChecks(0) , faults(0) {}
             CollectionData( const CollectionData& older , const CollectionData& newer );
 
             UsageData total;
@@ -61,13 +82,26 @@ namespace mongo {
             UsageData update;
             UsageData remove;
             UsageData commands;
+
+            /* sampled record residency checks (see faultCheck()).  faults
+               counts the checks that found the record out of memory; the
+               ratio estimates how much of the collection's working set is
+               resident. */
+            long long faultChecks;
+            long long faults;
         };
 
         typedef map<string,CollectionData> UsageMap;
 
     public:
         void record( const string& ns , int op , int lockType , long long micros , bool command );
-        void append( BSONObjBuilder& b );
+        /** note the outcome of a Record::likelyInPhysicalMemory probe.  call
+            from the places that already sample residency (yield decisions
+            etc.) - not from every record access. */
+        void faultCheck( const string& ns , bool inMemory );
+        void append( BSONObjBuilder& b , bool histograms = false );
+        /** per-optype latency histograms across all namespaces, for serverStatus */
+        void appendLatencyStats( BSONObjBuilder& b );
         void cloneMap(UsageMap& out) const;
         CollectionData getGlobalData() const { return _global; }
         void collectionDropped( const string& ns );
@@ -76,8 +110,9 @@ namespace mongo {
         static Top global;
 
     private:
-        void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map ) const;
-        void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
+        void _appendToUsageMap( BSONObjBuilder& b , const UsageMap& map , bool histograms ) const;
+        void _appendStatsEntry( BSONObjBuilder& b , const char * statsName , const UsageData& map , bool histogram ) const;
+        void _appendHistogram( BSONObjBuilder& b , const char * statsName , const UsageData& map ) const;
         void _record( CollectionData& c , int op , int lockType , long long micros , bool command );
 
         mutable mongo::mutex _lock;
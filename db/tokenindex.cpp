@@ -0,0 +1,208 @@
+// @file tokenindex.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "namespace-inl.h"
+#include "jsobj.h"
+#include "index.h"
+#include "btree.h"
+#include "pdfile.h"
+#include "commands.h"
+
+namespace mongo {
+
+    static const string TOKENIZED_INDEX_NAME = "tokenized";
+
+    /* tokenized index : db.foo.ensureIndex( { name : "tokenized" } )
+
+       splits the field's string value on non alphanumeric characters at index
+       time and stores each distinct lowercased token as its own key, so "Joe
+       van der Smith" indexes under joe, van, der and smith.  a word prefix
+       lookup is then a plain btree range scan [prefix, prefix+1) regardless of
+       where the word sits in the string - exactly what ^term regexes can't get
+       from a normal index once anything but a literal prefix is involved.
+
+       queried through the prefixSearch command below rather than find();
+       tokenized matching is deliberately looser than the query language (case
+       insensitive, any word position) so the regular matcher would prune away
+       the matches the search wants.
+    */
+
+    /** lowercased alphanumeric runs of s, deduped.  ascii only, like the
+        rest of the server's string handling. */
+    static void tokenize( const char *s , set<string>& tokens ) {
+        string cur;
+        for ( ; ; s++ ) {
+            if ( isalnum( (unsigned char)*s ) ) {
+                cur += (char)tolower( (unsigned char)*s );
+                continue;
+            }
+            if ( cur.size() )
+                tokens.insert( cur );
+            cur.clear();
+            if ( *s == 0 )
+                break;
+        }
+    }
+
+    class TokenizedIndexType : public IndexType {
+    public:
+        TokenizedIndexType( const IndexPlugin *plugin , const IndexSpec *spec )
+            : IndexType( plugin , spec ) {
+            BSONObjIterator i( spec->keyPattern );
+            uassert( 15988 , "tokenized index takes exactly one field" , i.more() );
+            BSONElement firstElt = i.next();
+            uassert( 15989 , "tokenized index takes exactly one field" , !i.more() );
+            uassert( 15990 , "bad key pattern for tokenized index" ,
+                     firstElt.type() == String && TOKENIZED_INDEX_NAME == firstElt.valuestr() );
+            _field = firstElt.fieldName();
+        }
+
+        virtual void getKeys( const BSONObj &obj, BSONObjSet &keys ) const {
+            BSONElementSet elts;
+            obj.getFieldsDotted( _field , elts );
+            set<string> tokens;
+            for ( BSONElementSet::const_iterator i = elts.begin(); i != elts.end(); ++i ) {
+                if ( i->type() == String )
+                    tokenize( i->valuestr() , tokens );
+            }
+            // missing or non-string fields simply contribute no keys
+            for ( set<string>::const_iterator i = tokens.begin(); i != tokens.end(); ++i ) {
+                BSONObjBuilder b;
+                b.append( "" , *i );
+                keys.insert( b.obj() );
+            }
+        }
+
+        virtual shared_ptr<Cursor> newCursor( const BSONObj &query , const BSONObj &order , int numWanted ) const {
+            massert( 15991 , "tokenized index is only queryable via the prefixSearch command" , 0 );
+            return shared_ptr<Cursor>();
+        }
+
+        /** never selected by the planner; token keys don't satisfy the query
+            language's matching semantics for the raw field value */
+        virtual IndexSuitability suitability( const BSONObj &query , const BSONObj &order ) const {
+            return USELESS;
+        }
+
+        void searchCommand( NamespaceDetails *d , int idxNo , const string& prefix ,
+                            BSONObjBuilder& result , unsigned limit ) const {
+            Timer t;
+
+            BSONObj min = BSON( "" << prefix );
+            string end = prefix;
+            ++end[ end.size() - 1 ]; // ascii token, so no overflow
+            BSONObj max = BSON( "" << end );
+
+            IndexDetails *id = const_cast<IndexDetails*>( _spec->getDetails() );
+            long long btreeMatches = 0;
+            set<DiskLoc> seen; // several tokens of one doc can share the prefix
+            BSONArrayBuilder arr( result.subarrayStart( "results" ) );
+            unsigned n = 0;
+            scoped_ptr<BtreeCursor> cursor( BtreeCursor::make( d , idxNo , *id , min , max , false , 1 ) );
+            while ( cursor->ok() ) {
+                btreeMatches++;
+                if ( seen.insert( cursor->currLoc() ).second ) {
+                    if ( n < limit ) {
+                        arr.append( cursor->currLoc().obj() );
+                        n++;
+                    }
+                }
+                cursor->advance();
+            }
+            arr.done();
+
+            BSONObjBuilder b( result.subobjStart( "stats" ) );
+            b.append( "time" , t.millis() );
+            b.appendNumber( "btreeMatches" , btreeMatches );
+            b.append( "n" , (int)n );
+            b.done();
+        }
+
+        const IndexDetails* getDetails() const {
+            return _spec->getDetails();
+        }
+
+    private:
+        string _field;
+    };
+
+    class TokenizedIndexPlugin : public IndexPlugin {
+    public:
+        TokenizedIndexPlugin() : IndexPlugin( TOKENIZED_INDEX_NAME ) {}
+
+        virtual IndexType* generate( const IndexSpec *spec ) const {
+            return new TokenizedIndexType( this , spec );
+        }
+
+    } tokenizedIndexPlugin;
+
+    /* { prefixSearch : "users" , prefix : "jo" [, limit : 50] } */
+    class PrefixSearchCommand : public Command {
+    public:
+        PrefixSearchCommand() : Command( "prefixSearch" ) {}
+        virtual LockType locktype() const { return READ; }
+        bool slaveOk() const { return true; }
+        bool slaveOverrideOk() const { return true; }
+        virtual void help(stringstream& h) const {
+            h << "case insensitive word prefix search over a tokenized index\n"
+                 "{ prefixSearch : <collection> , prefix : <string> [, limit : 50] }";
+        }
+
+        bool run(const string& dbname , BSONObj& cmdObj, int, string& errmsg, BSONObjBuilder& result, bool fromRepl) {
+            string ns = dbname + "." + cmdObj.firstElement().valuestr();
+
+            NamespaceDetails *d = nsdetails( ns.c_str() );
+            if ( ! d ) {
+                errmsg = "can't find ns";
+                return false;
+            }
+
+            vector<int> idxs;
+            d->findIndexByType( TOKENIZED_INDEX_NAME , idxs );
+            if ( idxs.size() == 0 ) {
+                errmsg = "no tokenized index";
+                return false;
+            }
+            if ( idxs.size() > 1 ) {
+                errmsg = "more than 1 tokenized index";
+                return false;
+            }
+
+            int idxNum = idxs[0];
+            IndexDetails& id = d->idx( idxNum );
+            TokenizedIndexType *si = (TokenizedIndexType*)id.getSpec().getType();
+            assert( &id == si->getDetails() );
+
+            BSONElement p = cmdObj["prefix"];
+            uassert( 15992 , "prefix must be a string" , p.type() == String );
+            set<string> tokens;
+            tokenize( p.valuestr() , tokens );
+            uassert( 15993 , "prefix must contain exactly one word" , tokens.size() == 1 );
+
+            unsigned limit = 50;
+            if ( cmdObj["limit"].isNumber() )
+                limit = (unsigned)cmdObj["limit"].numberInt();
+
+            si->searchCommand( d , idxNum , *tokens.begin() , result , limit );
+            return true;
+        }
+
+    } prefixSearchCommand;
+
+} // namespace mongo
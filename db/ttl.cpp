@@ -0,0 +1,135 @@
+// @file ttl.cpp
+
+/*
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* built-in document expiration.
+
+   declare an index on a date field with the expireAfterSeconds option:
+
+       db.events.ensureIndex( { ts : 1 } , { expireAfterSeconds : 3600 } )
+
+   and documents whose indexed field is older than that many seconds are
+   removed by a background thread.  the deletes go through deleteObjects,
+   so a pure range pattern over the TTL index takes the bulk btree-range
+   delete path (batched, yielding), and they are oplog'd so secondaries
+   just replicate the primary's removes.
+*/
+
+#include "pch.h"
+#include "ttl.h"
+#include "concurrency.h"
+#include "instance.h"
+#include "ops/delete.h"
+#include "replutil.h"
+#include "../util/background.h"
+
+namespace mongo {
+
+    class TTLMonitor : public BackgroundJob {
+    public:
+        string name() const { return "TTLMonitor"; }
+
+        void doTTLForDB( const string& dbName ) {
+            vector<BSONObj> indexes;
+            {
+                DBDirectClient db;
+                auto_ptr<DBClientCursor> cursor =
+                    db.query( dbName + ".system.indexes" ,
+                              BSON( "expireAfterSeconds" << BSON( "$exists" << true ) ) );
+                while ( cursor->more() )
+                    indexes.push_back( cursor->next().getOwned() );
+            }
+
+            for ( unsigned i = 0; i < indexes.size(); i++ ) {
+                const BSONObj& idx = indexes[i];
+
+                if ( ! idx["expireAfterSeconds"].isNumber() ) {
+                    log() << "ttl: expireAfterSeconds is not a number: " << idx << endl;
+                    continue;
+                }
+
+                BSONObj key = idx["key"].Obj();
+                if ( key.nFields() != 1 ) {
+                    log() << "ttl: index spec must be a single field: " << idx << endl;
+                    continue;
+                }
+
+                unsigned long long expireMillis =
+                    (unsigned long long)( idx["expireAfterSeconds"].numberLong() * 1000 );
+                BSONObj query = BSON( key.firstElement().fieldName()
+                                      << BSON( "$lt" << Date_t( curTimeMillis64() - expireMillis ) ) );
+
+                string ns = idx["ns"].String();
+
+                // back off while there is queueing on the write lock; expiring
+                // a little late is fine, adding to a pile-up is not
+                while ( dbMutex.writersWaiting() + dbMutex.readersWaiting() > 2 && ! inShutdown() )
+                    sleepmillis( 100 );
+                if ( inShutdown() )
+                    return;
+
+                {
+                    writelock lk( ns );
+                    Client::Context ctx( ns );
+
+                    if ( ! _isMaster() ) // stepped down mid-pass - the new primary expires now
+                        return;
+
+                    long long n = deleteObjects( ns.c_str() , query , false /*justOne*/ , true /*logop*/ );
+                    if ( n )
+                        LOG(1) << "ttl: removed " << n << " expired documents from " << ns << endl;
+                }
+            }
+        }
+
+        virtual void run() {
+            Client::initThread( "ttlMonitor" );
+            cc().getAuthenticationInfo()->authorize( "admin" , "_ttl" );
+            cc().setOpPriority( CurOp::LOW ); // maintenance yields to user ops
+
+            while ( ! inShutdown() ) {
+                sleepsecs( 60 );
+
+                if ( ! _isMaster() ) // secondaries replicate the primary's deletes
+                    continue;
+
+                LOG(3) << "ttl: pass starting" << endl;
+
+                try {
+                    vector<string> dbs;
+                    getDatabaseNames( dbs );
+                    for ( unsigned i = 0; i < dbs.size(); i++ ) {
+                        if ( dbs[i] == "local" )
+                            continue;
+                        doTTLForDB( dbs[i] );
+                    }
+                }
+                catch ( std::exception& e ) {
+                    log() << "ttl: error in pass: " << e.what() << endl;
+                }
+            }
+
+            cc().shutdown();
+        }
+    };
+
+    void startTTLBackgroundJob() {
+        TTLMonitor* ttl = new TTLMonitor();
+        ttl->go();
+    }
+
+}
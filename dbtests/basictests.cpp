@@ -631,7 +631,29 @@ namespace BasicTests {
         }
     };
 
-    struct CompressionTest1 { 
+    class WordCmpTest {
+    public:
+        static int sign( int x ) { return x < 0 ? -1 : ( x > 0 ? 1 : 0 ); }
+        void run() {
+            // wordcmp must agree with memcmp for every length and difference position,
+            // including the unaligned tails and the embedded zero case
+            const char *a = "abcdefghijklmnopqrstuvwxyz0123456789";
+            char b[64];
+            for( unsigned len = 0; len <= 36; len++ ) {
+                memcpy( b, a, 36 );
+                ASSERT_EQUALS( 0, wordcmp( a, b, len ) );
+                for( unsigned i = 0; i < len; i++ ) {
+                    memcpy( b, a, 36 );
+                    b[i] = (char) 0xff;
+                    ASSERT_EQUALS( sign( memcmp( a, b, len ) ), sign( wordcmp( a, b, len ) ) );
+                    b[i] = 0;
+                    ASSERT_EQUALS( sign( memcmp( a, b, len ) ), sign( wordcmp( a, b, len ) ) );
+                }
+            }
+        }
+    };
+
+    struct CompressionTest1 {
         void run() { 
             const char * c = "this is a test";
             std::string s;
@@ -684,6 +706,7 @@ namespace BasicTests {
             add< RelativePathTest >();
             add< CmdLineParseConfigTest >();
 
+            add< WordCmpTest >();
             add< CompressionTest1 >();
         }
     } myall;
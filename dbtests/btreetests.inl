@@ -151,6 +151,39 @@
         }
     };
 
+    /* ascending inserts take the appendRightmost fast path; make sure the
+       tree stays valid across the splits it triggers and that out of order
+       and duplicate keys still land correctly via the regular descent. */
+    class AppendRightmost : public Base {
+    public:
+        void run() {
+            int n = 0;
+            // enough ascending keys to split several levels
+            for ( int i = 0; i < 2000; i += 2 ) {
+                BSONObj key = BSON( "a" << bigNumString( i, 80 ) );
+                insert( key );
+                n++;
+            }
+            checkValid( n );
+
+            // out of order keys fall back to a full descent
+            for ( int i = 1; i < 100; i += 2 ) {
+                BSONObj key = BSON( "a" << bigNumString( i, 80 ) );
+                insert( key );
+                n++;
+            }
+            checkValid( n );
+
+            // appends resume after interleaved out of order work
+            BSONObj last = BSON( "a" << bigNumString( 5000, 80 ) );
+            insert( last );
+            checkValid( n + 1 );
+
+            BSONObj probe = BSON( "" << bigNumString( 55, 80 ) );
+            ASSERT( present( probe, 1 ) );
+        }
+    };
+
     class SplitUnevenBucketBase : public Base {
     public:
         virtual ~SplitUnevenBucketBase() {}
@@ -1621,6 +1654,7 @@
         void setupTests() {
             add< Create >();
             add< SimpleInsertDelete >();
+            add< AppendRightmost >();
             add< SplitRightHeavyBucket >();
             add< SplitLeftHeavyBucket >();
             add< MissingLocate >();
@@ -18,6 +18,7 @@
 
 #include "pch.h"
 #include "../client/dbclient.h"
+#include "../client/writepipeline.h"
 #include "dbtests.h"
 #include "../db/concurrency.h"
 
@@ -162,6 +163,50 @@ namespace ClientTests {
         }
     };
     
+    class PipelinedWrites : public Base {
+    public:
+        PipelinedWrites() : Base( "pipelinedwrites" ) {}
+
+        /** collects the getLastError results handed to write callbacks */
+        struct Ack {
+            Ack( vector<BSONObj> &acks ) : _acks( &acks ) {}
+            void operator()( const BSONObj &res ) { _acks->push_back( res.getOwned() ); }
+            vector<BSONObj> *_acks;
+        };
+
+        void run() {
+            vector<BSONObj> acks;
+
+            {
+                WritePipeline p( db , 4 , 1000 * 60 );
+                for( int i = 0; i < 10; ++i )
+                    p.insert( ns() , BSON( "_id" << i ) , Ack( acks ) );
+                // two full batches confirmed, two writes still awaiting a getLastError
+                ASSERT_EQUALS( 8U , acks.size() );
+                ASSERT_EQUALS( 2 , p.pending() );
+                p.insert( ns() , BSON( "_id" << 10 ) );
+                // destruction flushes the remainder
+            }
+            ASSERT_EQUALS( 10U , acks.size() );
+            ASSERT_EQUALS( 11ULL , db.count( ns() ) );
+            for( unsigned i = 0; i < acks.size(); ++i )
+                ASSERT( acks[ i ][ "err" ].isNull() );
+
+            // an error reaches the callbacks of its batch; it cannot be
+            // attributed to an individual write, so all of them see it
+            acks.clear();
+            WritePipeline p( db , 10 , 1000 * 60 );
+            p.update( ns() , BSON( "_id" << 4 ) , BSON( "$set" << BSON( "a" << 1 ) ) , Ack( acks ) );
+            p.insert( ns() , BSON( "_id" << 4 ) , Ack( acks ) ); // duplicate key
+            BSONObj res = p.flush();
+            ASSERT( !res[ "err" ].isNull() );
+            ASSERT_EQUALS( 2U , acks.size() );
+            ASSERT( !acks[ 0 ][ "err" ].isNull() );
+            ASSERT( !acks[ 1 ][ "err" ].isNull() );
+            ASSERT_EQUALS( 0 , p.pending() );
+        }
+    };
+
     class ConnectionStringTests {
     public:
         void run() {
@@ -190,6 +235,7 @@ namespace ClientTests {
             add<CS_10>();
             add<PushBack>();
             add<Create>();
+            add<PipelinedWrites>();
             add<ConnectionStringTests>();
         }
 
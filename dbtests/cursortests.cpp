@@ -286,6 +286,73 @@ namespace CursorTests {
 
     } // namespace BtreeCursorTests
 
+    namespace RandomSampleCursorTests {
+
+        class Base {
+        public:
+            virtual ~Base() { _c.dropCollection( ns() ); }
+        protected:
+            static const char *ns() { return "unittests.cursortests.RandomSample"; }
+            DBDirectClient _c;
+        };
+
+        /** An empty collection yields no samples. */
+        class Empty : public Base {
+        public:
+            void run() {
+                _c.insert( ns(), BSON( "_id" << 0 ) );
+                _c.remove( ns(), BSONObj() );
+                dblock lk;
+                Client::Context ctx( ns() );
+                RandomSampleCursor c( nsdetails( ns() ), 10 );
+                ASSERT( !c.ok() );
+            }
+        };
+
+        /** Samples are valid documents of the collection and the requested count is honored. */
+        class Sample : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 1000; ++i ) {
+                    _c.insert( ns(), BSON( "_id" << i << "a" << i ) );
+                }
+                dblock lk;
+                Client::Context ctx( ns() );
+                RandomSampleCursor c( nsdetails( ns() ), 50 );
+                int count = 0;
+                while( c.ok() ) {
+                    BSONObj o = c.current();
+                    int id = o.getIntField( "_id" );
+                    ASSERT( id >= 0 && id < 1000 );
+                    ASSERT_EQUALS( id, o.getIntField( "a" ) );
+                    ++count;
+                    c.advance();
+                }
+                ASSERT_EQUALS( 50, count );
+            }
+        };
+
+        /** Freed records are never returned. */
+        class SkipsDeleted : public Base {
+        public:
+            void run() {
+                for( int i = 0; i < 1000; ++i ) {
+                    _c.insert( ns(), BSON( "_id" << i ) );
+                }
+                // free every other record
+                _c.remove( ns(), BSON( "_id" << BSON( "$mod" << BSON_ARRAY( 2 << 0 ) ) ) );
+                dblock lk;
+                Client::Context ctx( ns() );
+                RandomSampleCursor c( nsdetails( ns() ), 50 );
+                while( c.ok() ) {
+                    ASSERT_EQUALS( 1, c.current().getIntField( "_id" ) % 2 );
+                    c.advance();
+                }
+            }
+        };
+
+    } // namespace RandomSampleCursorTests
+
     class All : public Suite {
     public:
         All() : Suite( "cursor" ) {}
@@ -300,6 +367,9 @@ namespace CursorTests {
             add< BtreeCursorTests::RangeEq >();
             add< BtreeCursorTests::RangeIn >();
             add< BtreeCursorTests::AbortImplicitScan >();
+            add< RandomSampleCursorTests::Empty >();
+            add< RandomSampleCursorTests::Sample >();
+            add< RandomSampleCursorTests::SkipsDeleted >();
         }
     } myall;
 } // namespace CursorTests
@@ -113,6 +113,58 @@ namespace {
         }
     };
 
+    class RangeBelongsToMeTests {
+    public:
+        void run() {
+            BSONObj collection = BSON( "_id"     << "x.y" <<
+                                       "dropped" << false <<
+                                       "key"     << BSON( "a" << 1 ) <<
+                                       "unique"  << false );
+
+            // 3-chunk collection, 2 of them being contiguous
+            // [min->10) , [10->20) , <gap> , [30->max)
+            BSONArray chunks = BSON_ARRAY( BSON( "_id" << "x.y-a_MinKey" <<
+                                                 "ns"  << "x.y" <<
+                                                 "min" << BSON( "a" << MINKEY ) <<
+                                                 "max" << BSON( "a" << 10 ) ) <<
+                                           BSON( "_id" << "x.y-a_10" <<
+                                                 "ns"  << "x.y" <<
+                                                 "min" << BSON( "a" << 10 ) <<
+                                                 "max" << BSON( "a" << 20 ) ) <<
+                                           BSON( "_id" << "x.y-a_30" <<
+                                                 "ns"  << "x.y" <<
+                                                 "min" << BSON( "a" << 30 ) <<
+                                                 "max" << BSON( "a" << MAXKEY ) ) );
+
+            ShardChunkManager s ( collection , chunks );
+
+            // within one chunk
+            ASSERT( s.rangeBelongsToMe( BSON( "a" << 2 ) , BSON( "a" << 5 ) ) );
+
+            // straddling two contiguous chunks
+            ASSERT( s.rangeBelongsToMe( BSON( "a" << 5 ) , BSON( "a" << 15 ) ) );
+
+            // endpoints are inclusive, so max may not touch a range's upper bound
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << 15 ) , BSON( "a" << 20 ) ) );
+
+            // reaching into the gap
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << 15 ) , BSON( "a" << 25 ) ) );
+
+            // wholly inside the gap
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << 22 ) , BSON( "a" << 25 ) ) );
+
+            // straddling the gap
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << 15 ) , BSON( "a" << 35 ) ) );
+
+            // in the top range, open ended
+            ASSERT( s.rangeBelongsToMe( BSON( "a" << 30 ) , BSON( "a" << 40 ) ) );
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << 30 ) , BSON( "a" << MAXKEY ) ) );
+
+            // the whole key space requires owning a single contiguous run
+            ASSERT( ! s.rangeBelongsToMe( BSON( "a" << MINKEY ) , BSON( "a" << MAXKEY ) ) );
+        }
+    };
+
     class GetNextTests {
     public:
         void run() {
@@ -451,6 +503,7 @@ namespace {
             add< BasicTests >();
             add< BasicCompoundTests >();
             add< RangeTests >();
+            add< RangeBelongsToMeTests >();
             add< GetNextTests >();
             add< DeletedTests >();
             add< ClonePlusTests >();
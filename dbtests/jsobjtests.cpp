@@ -1052,6 +1052,56 @@ namespace JsobjTests {
                 double frequency_;
             };
 
+            // the fast single-pass checker should accept everything well formed
+            // and reject the structural corruptions above
+            class Structural {
+            public:
+                void run() {
+                    BSONObj good = fromjson( "{\"one\":2, \"two\":5, \"three\": {},"
+                                             "\"four\": { \"five\": { \"six\" : 11 } },"
+                                             "\"seven\": [ \"a\", \"bb\", \"ccc\", 5 ],"
+                                             "\"eight\": Dbref( \"rrr\", \"01234567890123456789aaaa\" ),"
+                                             "\"_id\": ObjectId( \"deadbeefdeadbeefdeadbeef\" ),"
+                                             "\"nine\": { \"$binary\": \"abc=\", \"$type\": \"00\" },"
+                                             "\"ten\": Date( 44 ), \"eleven\": /foooooo/i }" );
+                    ASSERT( good.structurallyValid() );
+                    ASSERT( BSONObj().structurallyValid() );
+
+                    {
+                        // bad type byte
+                        BSONObj o = good.copy();
+                        const_cast<char*>( o.objdata() )[4] = 50;
+                        ASSERT( !o.structurallyValid() );
+                    }
+                    {
+                        // string length overruns the object
+                        BSONObj o = fromjson( "{\"a\":\"b\"}" );
+                        const_cast<char*>( o.objdata() )[7] = 100;
+                        ASSERT( !o.structurallyValid() );
+                    }
+                    {
+                        // embedded object size inconsistent with its parent
+                        BSONObj o = fromjson( "{\"a\":{\"b\":1}}" );
+                        const_cast<char*>( o.objdata() )[7]++;
+                        ASSERT( !o.structurallyValid() );
+                    }
+                    {
+                        // missing final EOO
+                        BSONObj o = fromjson( "{\"a\":1}" );
+                        const_cast<char*>( o.objdata() )[ o.objsize() - 1 ] = (char) 0xff;
+                        ASSERT( !o.structurallyValid() );
+                    }
+                    {
+                        // nesting depth cap
+                        BSONObj o = BSON( "a" << 1 );
+                        for ( int i = 0; i < 150; i++ )
+                            o = BSON( "a" << o );
+                        ASSERT( o.valid() );
+                        ASSERT( !o.structurallyValid() );
+                    }
+                }
+            };
+
         } // namespace Validation
 
     } // namespace BSONObjTests
@@ -1604,6 +1654,35 @@ namespace JsobjTests {
             }
         };
 
+        /** index keys declared via setIndexKeys() are held KeyV1 encoded (for
+            v1 interfaces) in memory and in the spill files; make sure they
+            come back in order and with their values intact. */
+        class CompactKeys {
+        public:
+            void run() {
+                BSONObjExternalSorter sorter( *IndexDetails::iis[1], BSON( "" << 1 ) , 2000 );
+                sorter.setIndexKeys();
+                for ( int i=0; i<10000; i++ ) {
+                    sorter.add( BSON( "" << rand() % 10000 ) , 5 , i );
+                }
+
+                sorter.sort();
+                ASSERT( sorter.numFiles() > 0 );
+
+                auto_ptr<BSONObjExternalSorter::Iterator> i = sorter.iterator();
+                int num=0;
+                double prev = -1;
+                while ( i->more() ) {
+                    pair<BSONObj,DiskLoc> p = i->next();
+                    num++;
+                    double cur = p.first.firstElement().number();
+                    assert( cur >= prev );
+                    prev = cur;
+                }
+                assert( num == 10000 );
+            }
+        };
+
         class D1 {
         public:
             void run() {
@@ -2119,6 +2198,7 @@ namespace JsobjTests {
             add< BSONObjTests::Validation::NoSize >( Object );
             add< BSONObjTests::Validation::NoSize >( Array );
             add< BSONObjTests::Validation::NoSize >( BinData );
+            add< BSONObjTests::Validation::Structural >();
             add< BSONObjTests::Validation::Fuzz >( .5 );
             add< BSONObjTests::Validation::Fuzz >( .1 );
             add< BSONObjTests::Validation::Fuzz >( .05 );
@@ -2155,6 +2235,7 @@ namespace JsobjTests {
             add< external_sort::ByDiskLock >();
             add< external_sort::Big1 >();
             add< external_sort::Big2 >();
+            add< external_sort::CompactKeys >();
             add< external_sort::D1 >();
             add< CompatBSON >();
             add< CompareDottedFieldNamesTest >();
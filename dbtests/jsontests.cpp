@@ -404,6 +404,10 @@ namespace JsonTests {
                 assertEquals( bson(), fromjson( bson().jsonString( Strict ) ) );
                 assertEquals( bson(), fromjson( bson().jsonString( TenGen ) ) );
                 assertEquals( bson(), fromjson( bson().jsonString( JS ) ) );
+                // the fast parser must either decline or agree exactly with fromjson()
+                BSONObj fast;
+                if ( fromjsonFast( bson().jsonString( Strict ).c_str(), fast ) )
+                    assertEquals( bson(), fast );
             }
         protected:
             virtual BSONObj bson() const = 0;
@@ -1084,6 +1088,35 @@ namespace JsonTests {
             }
         };
 
+        /** strict json the fast parser must handle itself */
+        class FastParse {
+        public:
+            virtual ~FastParse() {}
+            void run() {
+                const char *json =
+                    "{ \"a\" : 1, \"b\" : -2.5, \"c\" : \"x\\ny\\u00e9\", \"d\" : [ 1, \"two\", { \"e\" : true } ], "
+                    "\"f\" : null, \"g\" : false, \"h\" : {}, \"i\" : [], \"j\" : 12345678901 }";
+                BSONObj fast;
+                ASSERT( fromjsonFast( json, fast ) );
+                ASSERT( !fast.woCompare( fromjson( json ) ) );
+            }
+        };
+
+        /** extended syntax the fast parser must punt on rather than misparse */
+        class FastParseFallback {
+        public:
+            virtual ~FastParseFallback() {}
+            void run() {
+                BSONObj fast;
+                ASSERT( !fromjsonFast( "{ 'a' : 1 }", fast ) );
+                ASSERT( !fromjsonFast( "{ a : 1 }", fast ) );
+                ASSERT( !fromjsonFast( "{ \"a\" : ObjectId( \"deadbeefdeadbeefdeadbeef\" ) }", fast ) );
+                ASSERT( !fromjsonFast( "{ \"a\" : { \"$oid\" : \"deadbeefdeadbeefdeadbeef\" } }", fast ) );
+                ASSERT( !fromjsonFast( "{ \"a\" : 1 } trailing", fast ) );
+                ASSERT( !fromjsonFast( "{ \"a\" : 1", fast ) );
+            }
+        };
+
     } // namespace FromJsonTests
 
     class All : public Suite {
@@ -1175,6 +1208,8 @@ namespace JsonTests {
             add< FromJsonTests::EmbeddedDatesFormat2 >();
             add< FromJsonTests::EmbeddedDatesFormat3 >();
             add< FromJsonTests::NullString >();
+            add< FromJsonTests::FastParse >();
+            add< FromJsonTests::FastParseFallback >();
         }
     } myall;
 
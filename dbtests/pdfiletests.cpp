@@ -303,8 +303,92 @@ namespace PdfileTests {
                 ASSERT( 0 != o.getField( "a" ).date() );
             }
         };
+
+        /* an update that outgrows its record merges the physically following
+           deleted record instead of relocating */
+        class GrowInPlace : public Base {
+        public:
+            void run() {
+                BSONObj a = BSON( "_id" << 1 << "x" << string( 100, 'a' ) );
+                BSONObj b = BSON( "_id" << 2 << "x" << string( 100, 'b' ) );
+                DiskLoc al = theDataFileMgr.insertWithObjMod( ns(), a );
+                DiskLoc bl = theDataFileMgr.insertWithObjMod( ns(), b );
+                ASSERT_EQUALS( al.getOfs() + al.rec()->lengthWithHeaders, bl.getOfs() );
+                theDataFileMgr.deleteRecord( ns(), bl.rec(), bl );
+                // grows past its padding, but the space right after it is free
+                BSONObj big = BSON( "_id" << 1 << "x" << string( 200, 'a' ) );
+                OpDebug debug;
+                DiskLoc nl = theDataFileMgr.updateRecord( ns(), nsd(), &NamespaceDetailsTransient::get_w( ns() ),
+                                                          al.rec(), al, big.objdata(), big.objsize(), debug );
+                ASSERT( nl == al ); // grew in place, no relocation
+                ASSERT_EQUALS( 0, big.woCompare( al.obj() ) );
+                ASSERT( !debug.moved );
+            }
+        };
     } // namespace Insert
 
+    namespace SlotCapped {
+
+        /* capped collection in uniform slot mode (created with slotSize) - records
+           must occupy fixed slots, wrap like a normal capped collection, and reject
+           documents over the slot size. */
+        class WrapAround {
+        public:
+            WrapAround() : _context( ns() ) {
+            }
+            ~WrapAround() {
+                if ( nsdetails( ns() ) )
+                    dropNS( string( ns() ) );
+            }
+            void run() {
+                string err;
+                ASSERT( userCreateNS( ns(), fromjson( "{\"capped\":true,\"size\":4096,\"slotSize\":100}" ), err, false ) );
+                NamespaceDetails *d = nsdetails( ns() );
+                ASSERT( d->cappedSlotSize >= 100 + Record::HeaderSize );
+
+                {
+                    // over the slot size - must be refused
+                    BSONObjBuilder b;
+                    b.append( "_id", 0 );
+                    b.append( "pad", string( 150, 'x' ) );
+                    BSONObj big = b.obj();
+                    ASSERT_THROWS( theDataFileMgr.insertWithObjMod( ns(), big ), UserException );
+                }
+
+                const int N = 500; // enough to wrap several times
+                for( int i = 0; i < N; ++i ) {
+                    BSONObj o = BSON( "_id" << i << "pad" << string( 40, 'x' ) );
+                    ASSERT( !theDataFileMgr.insertWithObjMod( ns(), o ).isNull() );
+                }
+
+                // still a coherent capped collection: a natural order scan sees a
+                // contiguous ascending run ending at the newest document, and every
+                // record occupies exactly one slot.
+                int n = 0;
+                int expected = -1;
+                for ( boost::shared_ptr<Cursor> c = theDataFileMgr.findAll( ns() ); c->ok(); c->advance() ) {
+                    int id = c->current()["_id"].numberInt();
+                    if ( expected != -1 )
+                        ASSERT_EQUALS( expected, id );
+                    expected = id + 1;
+                    Record *r = c->currLoc().rec();
+                    ASSERT_EQUALS( (int) d->cappedSlotSize, r->lengthWithHeaders );
+                    ++n;
+                }
+                ASSERT_EQUALS( N, expected );
+                ASSERT( n < N );                     // wrapped - the oldest are gone
+                ASSERT_EQUALS( n, (int) d->stats.nrecords );
+            }
+        private:
+            static const char *ns() {
+                return "unittests.pdfiletests.SlotCapped";
+            }
+            dblock lk_;
+            Client::Context _context;
+        };
+
+    } // namespace SlotCapped
+
     class ExtentSizing {
     public:
         struct SmallFilesControl {
@@ -398,6 +482,8 @@ namespace PdfileTests {
             add< ScanCapped::FirstInExtent >();
             add< ScanCapped::LastInExtent >();
             add< Insert::UpdateDate >();
+            add< Insert::GrowInPlace >();
+            add< SlotCapped::WrapAround >();
             add< ExtentSizing >();
             add< ExtentAllocOrder >();
         }
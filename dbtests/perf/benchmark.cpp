@@ -0,0 +1,363 @@
+// benchmark.cpp : parameterized regression benchmarks with JSON output.
+
+/**
+ *    Copyright (C) 2011 10gen Inc.
+ *
+ *    This program is free software: you can redistribute it and/or  modify
+ *    it under the terms of the GNU Affero General Public License, version 3,
+ *    as published by the Free Software Foundation.
+ *
+ *    This program is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU Affero General Public License for more details.
+ *
+ *    You should have received a copy of the GNU Affero General Public License
+ *    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/* runs a set of parameterized workloads (insert/update/query mixes, document
+   sizes, index counts) against a direct client and reports ops/sec and
+   latency percentiles as JSON, suitable for tracking across releases:
+
+       ./benchmark --ops 100000 --docSize 256 --out results.json
+       ./benchmark --baseline results.json        # fails on regression
+
+   see also dbtests/perf/perftest.cpp for the older fixed-scenario timings.
+*/
+
+#include "pch.h"
+#include "../../util/version.h"
+#include <boost/program_options.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#undef assert
+#define assert MONGO_assert
+
+#include "../../client/dbclient.h"
+#include "../../db/instance.h"
+#include "../../db/dur.h"
+#include "../../db/json.h"
+#include "../../util/file_allocator.h"
+#include "../../util/timer.h"
+
+namespace po = boost::program_options;
+
+namespace mongo {
+    CmdLine cmdLine;
+    extern string dbpath;
+}
+
+using namespace mongo;
+
+namespace {
+
+    DBClientBase *client_;
+
+    struct Params {
+        string workload;   // insert, query, update, mixed, or all
+        int ops;
+        int docSize;
+        int indexes;       // secondary indexes to maintain during writes
+        string outFile;    // write the JSON report here as well as stdout
+        string baseline;   // compare against a previous report
+        double threshold;  // % ops/sec drop that counts as a regression
+    };
+    Params params;
+
+    const char * const kDb = "benchmark";
+
+    string nsFor( const char *workload ) {
+        return str::stream() << kDb << "." << workload;
+    }
+
+    BSONObj makeDoc( int id, int size ) {
+        static const string padding( 16 * 1024, 'x' );
+        // rough bson overhead of the fixed fields; close enough for sizing
+        int pad = size - 48;
+        if ( pad < 0 )
+            pad = 0;
+        return BSON( "_id" << id << "a" << id % 1000 << "pad" << padding.substr( 0, pad ) );
+    }
+
+    /** a single timed workload.  setup() is untimed; op( i ) is called and
+        timed params.ops times. */
+    class Workload {
+    public:
+        Workload( const char *name ) : _name( name ) {}
+        virtual ~Workload() {}
+        const char * name() const { return _name; }
+        virtual void setup() = 0;
+
+        BSONObj run() {
+            log() << "benchmark: " << _name << endl;
+            client_->dropDatabase( kDb );
+            setup();
+            vector<unsigned long long> micros( params.ops );
+            Timer total;
+            for( int i = 0; i < params.ops; ++i ) {
+                Timer t;
+                op( i );
+                micros[i] = t.micros();
+            }
+            unsigned long long totalMicros = total.micros();
+            sort( micros.begin(), micros.end() );
+
+            BSONObjBuilder b;
+            b.append( "name", _name );
+            b.append( "ops", params.ops );
+            b.append( "opsPerSec", params.ops * 1000000.0 / totalMicros );
+            BSONObjBuilder lat( b.subobjStart( "latencyMicros" ) );
+            lat.appendNumber( "p50", (long long) micros[ percentile( 50 ) ] );
+            lat.appendNumber( "p90", (long long) micros[ percentile( 90 ) ] );
+            lat.appendNumber( "p99", (long long) micros[ percentile( 99 ) ] );
+            lat.appendNumber( "max", (long long) micros[ params.ops - 1 ] );
+            lat.done();
+            return b.obj();
+        }
+
+    protected:
+        virtual void op( int i ) = 0;
+
+        /** create n additional indexes so writes pay index maintenance */
+        void addIndexes( const string& ns ) {
+            for( int i = 0; i < params.indexes; ++i ) {
+                client_->resetIndexCache();
+                // duplicate keys with distinct names, as in perftest's TenIndex --
+                // the point is just to make every write maintain more indexes
+                client_->ensureIndex( ns, BSON( "a" << 1 ), false,
+                                      str::stream() << "extra" << i );
+            }
+        }
+
+        /** untimed bulk preload of count documents */
+        void preload( const string& ns, int count ) {
+            vector<BSONObj> batch;
+            for( int i = 0; i < count; ++i ) {
+                batch.push_back( makeDoc( i, params.docSize ) );
+                if ( batch.size() >= 1000 ) {
+                    client_->insert( ns, batch );
+                    batch.clear();
+                }
+            }
+            if ( !batch.empty() )
+                client_->insert( ns, batch );
+        }
+
+    private:
+        int percentile( int p ) const {
+            int i = (int)( (long long)params.ops * p / 100 );
+            return i < params.ops ? i : params.ops - 1;
+        }
+        const char *_name;
+    };
+
+    class InsertWorkload : public Workload {
+    public:
+        InsertWorkload() : Workload( "insert" ), _ns( nsFor( "insert" ) ) {}
+        virtual void setup() {
+            addIndexes( _ns );
+        }
+        virtual void op( int i ) {
+            client_->insert( _ns, makeDoc( i, params.docSize ) );
+        }
+    private:
+        string _ns;
+    };
+
+    class QueryWorkload : public Workload {
+    public:
+        QueryWorkload() : Workload( "query" ), _ns( nsFor( "query" ) ) {}
+        virtual void setup() {
+            preload( _ns, params.ops );
+        }
+        virtual void op( int i ) {
+            client_->findOne( _ns, QUERY( "_id" << ( ( i * 9973 ) % params.ops ) ) );
+        }
+    private:
+        string _ns;
+    };
+
+    class UpdateWorkload : public Workload {
+    public:
+        UpdateWorkload() : Workload( "update" ), _ns( nsFor( "update" ) ) {}
+        virtual void setup() {
+            preload( _ns, params.ops );
+            addIndexes( _ns );
+        }
+        virtual void op( int i ) {
+            int id = ( i * 9973 ) % params.ops;
+            client_->update( _ns, QUERY( "_id" << id ), BSON( "$set" << BSON( "a" << i ) ) );
+        }
+    private:
+        string _ns;
+    };
+
+    /** 50% inserts, 30% point queries, 20% updates */
+    class MixedWorkload : public Workload {
+    public:
+        MixedWorkload() : Workload( "mixed" ), _ns( nsFor( "mixed" ) ) {}
+        virtual void setup() {
+            preload( _ns, params.ops );
+            addIndexes( _ns );
+        }
+        virtual void op( int i ) {
+            int id = ( i * 9973 ) % params.ops;
+            switch ( i % 10 ) {
+            case 0: case 1: case 2: case 3: case 4:
+                client_->insert( _ns, makeDoc( params.ops + i, params.docSize ) );
+                break;
+            case 5: case 6: case 7:
+                client_->findOne( _ns, QUERY( "_id" << id ) );
+                break;
+            default:
+                client_->update( _ns, QUERY( "_id" << id ), BSON( "$set" << BSON( "a" << i ) ) );
+            }
+        }
+    private:
+        string _ns;
+    };
+
+    /** @return exit code: nonzero if any benchmark regressed past the threshold */
+    int compareWithBaseline( const BSONObj& report, const string& file ) {
+        ifstream f( file.c_str() );
+        uassert( 15968, str::stream() << "cannot open baseline file " << file, f.is_open() );
+        stringstream ss;
+        ss << f.rdbuf();
+        BSONObj baseline = fromjson( ss.str() );
+
+        map<string,double> old;
+        BSONForEach( e, baseline["results"].Obj() ) {
+            BSONObj r = e.Obj();
+            old[ r["name"].String() ] = r["opsPerSec"].Number();
+        }
+
+        int regressions = 0;
+        BSONForEach( e, report["results"].Obj() ) {
+            BSONObj r = e.Obj();
+            string name = r["name"].String();
+            if ( old.count( name ) == 0 ) {
+                cout << name << ": no baseline" << endl;
+                continue;
+            }
+            double was = old[name];
+            double now = r["opsPerSec"].Number();
+            double delta = ( now - was ) * 100.0 / was;
+            cout << name << ": " << was << " -> " << now << " ops/sec ("
+                 << ( delta >= 0 ? "+" : "" ) << delta << "%)";
+            if ( -delta > params.threshold ) {
+                cout << "  REGRESSION";
+                regressions++;
+            }
+            cout << endl;
+        }
+        return regressions;
+    }
+
+}
+
+int main( int argc, char **argv ) {
+    logLevel = -1;
+
+    string dbpathSpec;
+
+    po::options_description options( "options" );
+    options.add_options()
+    ( "help,h", "show this usage information" )
+    ( "dbpath", po::value<string>( &dbpathSpec )->default_value( "/data/db/benchmark" ),
+      "db data path for this run.  NOTE: the contents of this directory will "
+      "be overwritten if it already exists" )
+    ( "workload", po::value<string>( &params.workload )->default_value( "all" ),
+      "insert, query, update, mixed, or all" )
+    ( "ops", po::value<int>( &params.ops )->default_value( 100000 ), "operations per workload" )
+    ( "docSize", po::value<int>( &params.docSize )->default_value( 256 ), "approximate document size in bytes" )
+    ( "indexes", po::value<int>( &params.indexes )->default_value( 0 ), "extra secondary indexes to maintain" )
+    ( "out", po::value<string>( &params.outFile ), "also write the JSON report to this file" )
+    ( "baseline", po::value<string>( &params.baseline ), "compare against this previous report; exit nonzero on regression" )
+    ( "threshold", po::value<double>( &params.threshold )->default_value( 10.0 ), "ops/sec drop (percent) that counts as a regression" )
+    ( "dur", "enable journaling" )
+    ;
+
+    po::variables_map vm;
+    try {
+        po::store( po::command_line_parser( argc, argv ).options( options ).run(), vm );
+        po::notify( vm );
+    }
+    catch ( po::error &e ) {
+        cout << "ERROR: " << e.what() << endl << endl << options << endl;
+        return EXIT_FAILURE;
+    }
+
+    if ( vm.count( "help" ) ) {
+        cout << options << endl;
+        return EXIT_SUCCESS;
+    }
+
+    if ( vm.count( "dur" ) )
+        cmdLine.dur = true;
+
+    boost::filesystem::path p( dbpathSpec );
+    if ( boost::filesystem::exists( p ) ) {
+        boost::filesystem::directory_iterator end_iter;
+        for ( boost::filesystem::directory_iterator dir_iter( p ); dir_iter != end_iter; ++dir_iter )
+            boost::filesystem::remove_all( *dir_iter );
+    }
+    else {
+        boost::filesystem::create_directory( p );
+    }
+    dbpath = p.native_directory_string();
+
+    cmdLine.prealloc = false;
+    cmdLine.smallfiles = true;
+    cmdLine.oplogSize = 10 * 1024 * 1024;
+
+    Client::initThread( "benchmark" );
+    acquirePathLock();
+    FileAllocator::get()->start();
+    dur::startup();
+
+    client_ = new DBDirectClient();
+
+    vector< shared_ptr<Workload> > workloads;
+    if ( params.workload == "all" || params.workload == "insert" )
+        workloads.push_back( shared_ptr<Workload>( new InsertWorkload() ) );
+    if ( params.workload == "all" || params.workload == "query" )
+        workloads.push_back( shared_ptr<Workload>( new QueryWorkload() ) );
+    if ( params.workload == "all" || params.workload == "update" )
+        workloads.push_back( shared_ptr<Workload>( new UpdateWorkload() ) );
+    if ( params.workload == "all" || params.workload == "mixed" )
+        workloads.push_back( shared_ptr<Workload>( new MixedWorkload() ) );
+    if ( workloads.empty() ) {
+        cout << "unknown workload: " << params.workload << endl;
+        return EXIT_FAILURE;
+    }
+
+    BSONObjBuilder reportBuilder;
+    reportBuilder.append( "version", versionString );
+    reportBuilder.append( "gitVersion", gitVersion() );
+    reportBuilder.appendDate( "time", jsTime() );
+    reportBuilder.append( "params", BSON( "ops" << params.ops << "docSize" << params.docSize
+                                          << "indexes" << params.indexes << "dur" << cmdLine.dur ) );
+    {
+        BSONArrayBuilder results( reportBuilder.subarrayStart( "results" ) );
+        for ( unsigned i = 0; i < workloads.size(); i++ )
+            results << workloads[i]->run();
+        results.done();
+    }
+    BSONObj report = reportBuilder.obj();
+
+    cout << report.jsonString( Strict, 1 ) << endl;
+    if ( params.outFile.size() ) {
+        ofstream out( params.outFile.c_str() );
+        out << report.jsonString( Strict, 1 ) << endl;
+    }
+
+    int ret = 0;
+    if ( params.baseline.size() )
+        ret = compareWithBaseline( report, params.baseline );
+
+    client_->dropDatabase( kDb );
+    cc().shutdown();
+    dbexit( (ExitCode)ret );
+    return ret;
+}
@@ -708,6 +708,68 @@ namespace PerfTests {
         }
     };
 
+    // test speed of the crc32c checksum used by the journal
+    class Crc32cTest : public B {
+    public:
+        const unsigned sz;
+        Crc32cTest() : sz(1024*1024*100+3) { }
+        string name() { return "crc32c"; }
+        virtual int howLongMillis() { return 2000; }
+        int expectationTimeMillis() { return 5000; }
+        virtual bool showDurStats() { return false; }
+        virtual unsigned batchSize() { return 1; }
+
+        void *p;
+
+        void prep() {
+            {
+                // known answer check - crc32c("123456789") == 0xe3069283
+                Checksum c;
+                c.genCrc32c("123456789", 9);
+                ASSERT( (unsigned)(c.words[0] & 0xffffffff) == 0xe3069283U );
+            }
+            {
+                // hardware and software paths must agree
+                Checksum hw, sw;
+                hw.genCrc32c("123456789", 9);
+                bool save = checksum_detail::crc32cContext.hw;
+                checksum_detail::crc32cContext.hw = false;
+                sw.genCrc32c("123456789", 9);
+                checksum_detail::crc32cContext.hw = save;
+                ASSERT( hw == sw );
+            }
+
+            p = malloc(sz);
+            for (unsigned i = 0; i<sz; i++)
+                ((char*)p)[i] = rand();
+        }
+
+        Checksum last;
+
+        void timed() {
+            static int i;
+            Checksum c;
+            c.genCrc32c(p, sz);
+            if( i == 0 )
+                last = c;
+            else if( i == 1 ) {
+                ASSERT( c == last );
+            }
+        }
+        void post() {
+            {
+                mongo::Checksum c;
+                c.genCrc32c(p, sz-1);
+                ASSERT( c != last );
+                ((char *&)p)[0]++;
+                ((char *&)p)[1]--;
+                c.genCrc32c(p, sz);
+                ASSERT( c != last );
+            }
+            free(p);
+        }
+    };
+
     class InsertDup : public B {
         const BSONObj o;
     public:
@@ -888,6 +950,7 @@ namespace PerfTests {
             else {
                 add< Dummy >();
                 add< ChecksumTest >();
+                add< Crc32cTest >();
                 add< Compress >();
                 add< TLS >();
                 add< Malloc >();
@@ -23,6 +23,7 @@
 #include "../db/instance.h"
 #include "../db/ops/query.h"
 #include "../db/ops/delete.h"
+#include "../db/btree.h"
 #include "dbtests.h"
 
 
@@ -39,6 +40,7 @@ namespace mongo {
     }
     void __forceLinkGeoPlugin();
     shared_ptr<Cursor> newQueryOptimizerCursor( const char *ns, const BSONObj &query, const BSONObj &order = BSONObj() );
+    shared_ptr<Cursor> newIndexMergeCursor( const vector<shared_ptr<Cursor> > &subs, bool intersect );
 } // namespace mongo
 
 namespace QueryOptimizerTests {
@@ -291,6 +293,19 @@ namespace QueryOptimizerTests {
             }
         };
 
+        class BoundedScan : public Base {
+        public:
+            void run() {
+                QueryPlan p( nsd(), INDEXNO( "a" << 1 ), FRSP( BSON( "a" << "z" ) ), FRSP2( BSON( "a" << "z" ) ), BSON( "a" << "z" ), BSONObj() );
+                ASSERT( p.boundedScan( 5 ) );
+                ASSERT( !p.boundedScan( 0 ) );
+                QueryPlan p2( nsd(), INDEXNO( "a" << 1 ), FRSP( BSON( "a" << GT << "z" ) ), FRSP2( BSON( "a" << GT << "z" ) ), BSON( "a" << GT << "z" ), BSONObj() );
+                ASSERT( !p2.boundedScan( 5 ) );
+                QueryPlan p3( nsd(), -1, FRSP( BSONObj() ), FRSP2( BSONObj() ), BSONObj(), BSONObj() );
+                ASSERT( !p3.boundedScan( 5 ) );
+            }
+        };
+
         class ExactKeyQueryTypes : public Base {
         public:
             void run() {
@@ -2499,8 +2514,105 @@ namespace QueryOptimizerTests {
             }
         };
         
+        /** Base for tests of the IndexMergeCursor. */
+        class MergeBase : public Base {
+        protected:
+            /** @return a merge cursor over equality ranges a == a and b == b. */
+            shared_ptr<Cursor> mergeCursor( bool intersect, int a, int b ) {
+                vector<shared_ptr<Cursor> > subs;
+                subs.push_back( btreeCursor( BSON( "a" << 1 ), BSON( "a" << a ) ) );
+                subs.push_back( btreeCursor( BSON( "b" << 1 ), BSON( "b" << b ) ) );
+                return newIndexMergeCursor( subs, intersect );
+            }
+            int rawCount( const shared_ptr<Cursor> &c ) const {
+                int ret = 0;
+                while( c->ok() ) {
+                    ++ret;
+                    c->advance();
+                }
+                return ret;
+            }
+            int matchedCount( const shared_ptr<Cursor> &c ) const {
+                int ret = 0;
+                while( c->ok() ) {
+                    if ( c->matcher()->matchesCurrent( c.get() ) ) {
+                        ++ret;
+                    }
+                    c->advance();
+                }
+                return ret;
+            }
+        private:
+            shared_ptr<Cursor> btreeCursor( const BSONObj &keyPattern, const BSONObj &key ) {
+                NamespaceDetails *d = nsdetails( ns() );
+                int idxNo = d->findIndexByKeyPattern( keyPattern );
+                ASSERT( idxNo >= 0 );
+                IndexDetails &idx = d->idx( idxNo );
+                BSONObj k = idx.getKeyFromQuery( key );
+                return shared_ptr<Cursor>( BtreeCursor::make( d, idxNo, idx, k, k, true, 1 ) );
+            }
+        };
+
+        /** Union of two index ranges returns a shared location only once. */
+        class MergeUnion : public MergeBase {
+        public:
+            void run() {
+                _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                _cli.insert( ns(), BSON( "_id" << 0 << "a" << 1 << "b" << 1 ) );
+                _cli.insert( ns(), BSON( "_id" << 1 << "a" << 1 << "b" << 2 ) );
+                _cli.insert( ns(), BSON( "_id" << 2 << "a" << 2 << "b" << 1 ) );
+                dblock lk;
+                Client::Context ctx( ns() );
+                ASSERT_EQUALS( 3, rawCount( mergeCursor( false, 1, 1 ) ) );
+            }
+        };
+
+        /** Intersection of two index ranges returns exactly the shared locations. */
+        class MergeIntersect : public MergeBase {
+        public:
+            void run() {
+                _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                for( int i = 0; i < 20; ++i ) {
+                    _cli.insert( ns(), BSON( "_id" << i << "a" << 1 << "b" << ( i < 5 ? 1 : 2 ) ) );
+                }
+                dblock lk;
+                Client::Context ctx( ns() );
+                // the b == 1 range exhausts first and the a == 1 scan completes
+                // within its budget, so only intersecting locations appear
+                ASSERT_EQUALS( 5, rawCount( mergeCursor( true, 1, 1 ) ) );
+            }
+        };
+
+        /**
+         * When the surviving intersect scan is cut off, the drained locations
+         * are a superset of the intersection and the matcher discards the non
+         * matches.
+         */
+        class MergeIntersectCutoff : public MergeBase {
+        public:
+            void run() {
+                _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                for( int i = 0; i < 5; ++i ) {
+                    _cli.insert( ns(), BSON( "_id" << i << "a" << 2 << "b" << 1 ) );
+                }
+                for( int i = 5; i < 300; ++i ) {
+                    _cli.insert( ns(), BSON( "_id" << i << "a" << 1 << "b" << 2 ) );
+                }
+                dblock lk;
+                Client::Context ctx( ns() );
+                // the a == 1 scan is cut off, so the b == 1 locations drain
+                ASSERT_EQUALS( 5, rawCount( mergeCursor( true, 1, 1 ) ) );
+                shared_ptr<Cursor> c = mergeCursor( true, 1, 1 );
+                c->setMatcher( shared_ptr<CoveredIndexMatcher>( new CoveredIndexMatcher( BSON( "a" << 1 << "b" << 1 ), BSONObj() ) ) );
+                ASSERT_EQUALS( 0, matchedCount( c ) );
+            }
+        };
+
         namespace GetCursor {
-            
+
             class Base : public QueryOptimizerCursorTests::Base {
             public:
                 Base() {
@@ -2617,7 +2729,69 @@ namespace QueryOptimizerTests {
                 BSONObj query() const { return BSON( "_id" << GT << 0 << "a" << GT << 0 ); }
                 void check( const shared_ptr<Cursor> &c ) {}
             };
-            
+
+            /** Two equality constrained single field indexes are intersected. */
+            class IndexIntersection : public Base {
+            public:
+                IndexIntersection() {
+                    _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                    _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                    _cli.insert( ns(), BSON( "_id" << 0 << "a" << 1 << "b" << 1 ) );
+                    _cli.insert( ns(), BSON( "_id" << 1 << "a" << 1 << "b" << 2 ) );
+                    _cli.insert( ns(), BSON( "_id" << 2 << "a" << 2 << "b" << 1 ) );
+                    _cli.insert( ns(), BSON( "_id" << 3 << "a" << 1 << "b" << 1 ) );
+                }
+                string expectedType() const { return "IndexMergeCursor"; }
+                BSONObj query() const { return BSON( "a" << 1 << "b" << 1 ); }
+                void check( const shared_ptr<Cursor> &c ) {
+                    ASSERT( c->matcher() );
+                    int count = 0;
+                    while( c->ok() ) {
+                        if ( c->matcher()->matchesCurrent( c.get() ) ) {
+                            ASSERT_EQUALS( 1, c->current().getIntField( "a" ) );
+                            ASSERT_EQUALS( 1, c->current().getIntField( "b" ) );
+                            ++count;
+                        }
+                        c->advance();
+                    }
+                    ASSERT_EQUALS( 2, count );
+                }
+            };
+
+            /** A compound index on the equality fields beats an intersection. */
+            class IndexIntersectionCompound : public Base {
+            public:
+                IndexIntersectionCompound() {
+                    _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                    _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                    _cli.ensureIndex( ns(), BSON( "a" << 1 << "b" << 1 ) );
+                    _cli.insert( ns(), BSON( "_id" << 0 << "a" << 1 << "b" << 1 ) );
+                }
+                string expectedType() const { return "BtreeCursor a_1_b_1"; }
+                BSONObj query() const { return BSON( "a" << 1 << "b" << 1 ); }
+                void check( const shared_ptr<Cursor> &c ) {
+                    ASSERT( c->ok() );
+                    ASSERT_EQUALS( 0, c->current().getIntField( "_id" ) );
+                    ASSERT( !c->advance() );
+                }
+            };
+
+            /** An intersection is not attempted when an equality range is too
+                large to scan without yielding. */
+            class IndexIntersectionLargeRange : public Base {
+            public:
+                IndexIntersectionLargeRange() {
+                    _cli.ensureIndex( ns(), BSON( "a" << 1 ) );
+                    _cli.ensureIndex( ns(), BSON( "b" << 1 ) );
+                    for( int i = 0; i < 10100; ++i ) {
+                        _cli.insert( ns(), BSON( "_id" << i << "a" << 1 << "b" << i % 3 ) );
+                    }
+                }
+                string expectedType() const { return "QueryOptimizerCursor"; }
+                BSONObj query() const { return BSON( "a" << 1 << "b" << 1 ); }
+                void check( const shared_ptr<Cursor> &c ) {}
+            };
+
         } // namespace GetCursor
         
     } // namespace QueryOptimizerCursorTests
@@ -2639,6 +2813,7 @@ namespace QueryOptimizerTests {
             add<QueryPlanTests::MoreOptimal>();
             add<QueryPlanTests::KeyMatch>();
             add<QueryPlanTests::MoreKeyMatch>();
+            add<QueryPlanTests::BoundedScan>();
             add<QueryPlanTests::ExactKeyQueryTypes>();
             add<QueryPlanTests::Unhelpful>();
             add<QueryPlanSetTests::NoIndexes>();
@@ -2724,6 +2899,9 @@ namespace QueryOptimizerTests {
             add<QueryOptimizerCursorTests::KillOp>();
             add<QueryOptimizerCursorTests::KillOpFirstClause>();
             add<QueryOptimizerCursorTests::Nscanned>();
+            add<QueryOptimizerCursorTests::MergeUnion>();
+            add<QueryOptimizerCursorTests::MergeIntersect>();
+            add<QueryOptimizerCursorTests::MergeIntersectCutoff>();
             add<QueryOptimizerCursorTests::GetCursor::NoConstraints>();
             add<QueryOptimizerCursorTests::GetCursor::SimpleId>();
             add<QueryOptimizerCursorTests::GetCursor::OptimalIndex>();
@@ -2731,6 +2909,9 @@ namespace QueryOptimizerTests {
             add<QueryOptimizerCursorTests::GetCursor::OutOfOrder>();
             add<QueryOptimizerCursorTests::GetCursor::BestSavedOutOfOrder>();
             add<QueryOptimizerCursorTests::GetCursor::MultiIndex>();
+            add<QueryOptimizerCursorTests::GetCursor::IndexIntersection>();
+            add<QueryOptimizerCursorTests::GetCursor::IndexIntersectionCompound>();
+            add<QueryOptimizerCursorTests::GetCursor::IndexIntersectionLargeRange>();
         }
     } myall;
 
@@ -19,6 +19,7 @@
 
 #include "pch.h"
 #include "../db/ops/query.h"
+#include "../db/scanandorder.h"
 #include "../db/dbhelpers.h"
 #include "../db/clientcursor.h"
 
@@ -277,6 +278,29 @@ namespace QueryTests {
         }
     };
 
+    class TailStaged : public ClientBase {
+    public:
+        ~TailStaged() {
+            client().dropCollection( "unittests.querytests.TailStaged" );
+        }
+        void run() {
+            const char *ns = "unittests.querytests.TailStaged";
+            client().createCollection( ns, 8192, true );
+            for( int i = 0; i < 20; ++i )
+                insert( ns, BSON( "a" << i ) );
+            // a small batch size so each getMore fills its reply and stages
+            // the remainder; every doc must still arrive exactly once, in order
+            auto_ptr< DBClientCursor > c = client().query( ns, Query().hint( BSON( "$natural" << 1 ) ), 2, 0, 0, QueryOption_CursorTailable );
+            int next = 0;
+            while( c->more() )
+                ASSERT_EQUALS( next++, c->next().getIntField( "a" ) );
+            ASSERT_EQUALS( 20, next );
+            insert( ns, BSON( "a" << next ) );
+            ASSERT( c->more() );
+            ASSERT_EQUALS( 20, c->next().getIntField( "a" ) );
+        }
+    };
+
     class EmptyTail : public ClientBase {
     public:
         ~EmptyTail() {
@@ -1064,6 +1088,43 @@ namespace QueryTests {
         }
     };
 
+    class ParallelCollectionScan : public CollectionBase {
+    public:
+
+        ParallelCollectionScan() : CollectionBase( "parallelscan" ) {
+        }
+
+        void run() {
+            BSONObj info;
+            ASSERT( client().runCommand( "unittests", BSON( "create" << "querytests.parallelscan" << "size" << 65536 << "$nExtents" << 6 ), info ) );
+
+            int N = 2000;
+            for ( int i=0; i<N; i++ ) {
+                insert( ns() , BSON( "_id" << i << "x" << i * 2 ) );
+            }
+
+            ASSERT( client().runCommand( "unittests", BSON( "parallelCollectionScan" << "querytests.parallelscan" << "numCursors" << 3 ), info ) );
+
+            vector<BSONElement> cursors = info["cursors"].Array();
+            ASSERT_EQUALS( 3U , cursors.size() );
+
+            // together the cursors must cover every document exactly once
+            set<int> seen;
+            writelock lk("");
+            Client::Context ctx( "unittests" );
+            for ( unsigned i = 0; i < cursors.size(); i++ ) {
+                CursorId id = cursors[i].Obj()["id"].numberLong();
+                ClientCursor * cc = ClientCursor::find( id );
+                ASSERT( cc );
+                for ( Cursor * c = cc->c(); c->ok(); c->advance() ) {
+                    ASSERT( seen.insert( c->current()["_id"].numberInt() ).second );
+                }
+                ASSERT( ClientCursor::erase( id ) );
+            }
+            ASSERT_EQUALS( N , (int) seen.size() );
+        }
+    };
+
     class ClientCursorTest : public CollectionBase {
         ClientCursorTest() : CollectionBase( "clientcursortest" ) {
         }
@@ -1182,6 +1243,45 @@ namespace QueryTests {
         }
     };
 
+    /**
+     * Oplog replay queries on an actual oplog namespace are served by the
+     * dedicated reader in queryOplogReplay() rather than the query optimizer;
+     * check that it returns the same results, batches, and tails correctly.
+     */
+    class OplogReplayFastPath : public ClientBase {
+    public:
+        ~OplogReplayFastPath() {
+            client().dropCollection( "local.oplog.querytests" );
+        }
+        void run() {
+            const char *ns = "local.oplog.querytests";
+            BSONObj info;
+            ASSERT( client().runCommand( "local", BSON( "create" << "oplog.querytests" << "capped" << true << "size" << 8192 << "autoIndexId" << false ), info ) );
+
+            for( int i = 0; i < 10; ++i ) {
+                client().insert( ns, BSON( "ts" << i ) );
+            }
+
+            // start point resolution and batching with a small batch size
+            auto_ptr< DBClientCursor > c = client().query( ns, QUERY( "ts" << GTE << 5 ), 0, 0, 0, QueryOption_OplogReplay, 2 );
+            for( int i = 5; i < 10; ++i ) {
+                ASSERT( c->more() );
+                ASSERT_EQUALS( i, c->next().getIntField( "ts" ) );
+            }
+            ASSERT( !c->more() );
+
+            // a tailable cursor stays open at the end and sees later inserts
+            c = client().query( ns, QUERY( "ts" << GT << 8 ), 0, 0, 0, QueryOption_OplogReplay | QueryOption_CursorTailable );
+            ASSERT( c->more() );
+            ASSERT_EQUALS( 9, c->next().getIntField( "ts" ) );
+            ASSERT( !c->more() );
+            client().insert( ns, BSON( "ts" << 10 ) );
+            ASSERT( c->more() );
+            ASSERT_EQUALS( 10, c->next().getIntField( "ts" ) );
+            ASSERT( !c->isDead() );
+        }
+    };
+
     class WhatsMyUri : public CollectionBase {
     public:
         WhatsMyUri() : CollectionBase( "whatsmyuri" ) {}
@@ -1269,6 +1369,37 @@ namespace QueryTests {
             }
         };
 
+        /** nested projections and $slice stream subobjects in place - check
+            the output, including two documents written back to back into one
+            reply buffer as the query path does */
+        class T2 {
+        public:
+            void run() {
+                BSONObj doc = fromjson( "{x:1,a:{b:1,c:2},y:3}" );
+
+                Projection inc;
+                inc.init( BSON( "a.b" << 1 << "_id" << 0 ) );
+                ASSERT_EQUALS( fromjson( "{a:{b:1}}" ) , inc.transform( doc ) );
+
+                Projection exc;
+                exc.init( BSON( "a.c" << 0 ) );
+                ASSERT_EQUALS( fromjson( "{x:1,a:{b:1},y:3}" ) , exc.transform( doc ) );
+
+                Projection slice;
+                slice.init( BSON( "a" << BSON( "$slice" << 2 ) ) );
+                ASSERT_EQUALS( fromjson( "{a:[1,2]}" ) ,
+                               slice.transform( fromjson( "{a:[1,2,3,4]}" ) ) );
+
+                BufBuilder bb;
+                fillQueryResultFromObj( bb, &inc, doc );
+                fillQueryResultFromObj( bb, &exc, doc );
+                BSONObj first( bb.buf() );
+                BSONObj second( bb.buf() + first.objsize() );
+                ASSERT_EQUALS( fromjson( "{a:{b:1}}" ) , first );
+                ASSERT_EQUALS( fromjson( "{x:1,a:{b:1},y:3}" ) , second );
+            }
+        };
+
         class K1 {
         public:
             void run() {
@@ -1363,6 +1494,7 @@ namespace QueryTests {
             add< PositiveLimit >();
             add< ReturnOneOfManyAndTail >();
             add< TailNotAtEnd >();
+            add< TailStaged >();
             add< EmptyTail >();
             add< TailableDelete >();
             add< TailableInsertDelete >();
@@ -1395,8 +1527,10 @@ namespace QueryTests {
             add< TailableCappedRaceCondition >();
             add< HelperTest >();
             add< HelperByIdTest >();
+            add< ParallelCollectionScan >();
             add< FindingStartPartiallyFull >();
             add< FindingStartStale >();
+            add< OplogReplayFastPath >();
             add< WhatsMyUri >();
 
             add< parsedtests::basic1 >();
@@ -1406,6 +1540,7 @@ namespace QueryTests {
             add< OrderingTest >();
 
             add< proj::T1 >();
+            add< proj::T2 >();
             add< proj::K1 >();
             add< proj::K2 >();
             add< proj::K3 >();
@@ -820,6 +820,30 @@ namespace QueryUtilTests {
             }
         };
 
+        class SharedParse {
+        public:
+            void run() {
+                // with one predicate per field the multi key set shares the
+                // single key set's parsed ranges instead of re-parsing
+                FieldRangeSetPair frsp( "", fromjson( "{a:{$in:[9,3,5,3,1]},b:4}" ) );
+                const FieldRange &single = frsp.singleKeyRange( "a" );
+                const FieldRange &multi = frsp.frsForIndex( 0, -1 ).range( "a" );
+                // $in values sorted and deduped in both sets
+                ASSERT_EQUALS( 4U, single.intervals().size() );
+                ASSERT_EQUALS( 4U, multi.intervals().size() );
+                ASSERT_EQUALS( 1, single.min().numberInt() );
+                ASSERT_EQUALS( 9, single.max().numberInt() );
+                ASSERT_EQUALS( 1, multi.min().numberInt() );
+                ASSERT_EQUALS( 9, multi.max().numberInt() );
+
+                // two predicates on a field force an independent parse so the
+                // multi key set keeps its own intersection semantics
+                FieldRangeSetPair frsp2( "", BSON( "a" << GT << 4 << LT << 2 ) );
+                ASSERT( frsp2.matchPossible() );
+                ASSERT( !frsp2.frsForIndex( 0, -1 ).singlePredicatePerField() );
+            }
+        };
+
         class IndexBase {
         public:
             IndexBase() : _ctx( ns() ) , indexNum_( 0 ) {
@@ -980,6 +1004,7 @@ namespace QueryUtilTests {
             add< FieldRangeSetTests::MatchPossible >();
             add< FieldRangeSetTests::MatchPossibleForIndex >();
             add< FieldRangeSetPairTests::NoNontrivialRanges >();
+            add< FieldRangeSetPairTests::SharedParse >();
             add< FieldRangeSetPairTests::MatchPossible >();
             add< FieldRangeSetPairTests::MatchPossibleForIndex >();
         }
@@ -274,6 +274,30 @@ namespace UpdateTests {
         }
     };
 
+    class CachedModSetReuse : public SetBase {
+    public:
+        void run() {
+            client().insert( ns(), BSON( "a" << 1 ) );
+
+            // identical update documents reuse the cached parse; each still applies
+            for( int i = 0; i < 3; i++ )
+                client().update( ns(), Query(), BSON( "$inc" << BSON( "a" << 1 ) ) );
+            ASSERT( !client().findOne( ns(), BSON( "a" << 4 ) ).isEmpty() );
+
+            // same shape with a different value is a different cache entry
+            client().update( ns(), Query(), BSON( "$inc" << BSON( "a" << 10 ) ) );
+            ASSERT( !client().findOne( ns(), BSON( "a" << 14 ) ).isEmpty() );
+
+            {
+                dblock lk;
+                NamespaceDetailsTransient &nsdt = NamespaceDetailsTransient::get_w( ns() );
+                BSONObj mod = BSON( "$inc" << BSON( "a" << 1 ) );
+                ASSERT_EQUALS( nsdt.cachedModSet( mod ).get(), nsdt.cachedModSet( mod ).get() );
+                ASSERT( nsdt.cachedModSet( mod ).get() != nsdt.cachedModSet( BSON( "$inc" << BSON( "a" << 2 ) ) ).get() );
+            }
+        }
+    };
+
     class UnorderedNewSet : public SetBase {
     public:
         void run() {
@@ -827,6 +851,7 @@ namespace UpdateTests {
             add< SetAdjacentDotted >();
             add< IncMissing >();
             add< MultiInc >();
+            add< CachedModSetReuse >();
             add< UnorderedNewSet >();
             add< UnorderedNewSetAdjacent >();
             add< ArrayEmbeddedSet >();
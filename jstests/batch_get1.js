@@ -0,0 +1,31 @@
+// basic batchGet tests
+
+t = db.batch_get1;
+t.drop();
+
+for ( i = 0; i < 100; i++ )
+    t.save( { _id : i, x : i * 2 } );
+
+// simple fetch, results come back in _id order regardless of request order
+res = db.runCommand( { batchGet : "batch_get1", ids : [ 7, 3, 5 ] } );
+assert( res.ok, "command failed" );
+assert.eq( 3, res.documents.length, "A1" );
+assert.eq( [ 3, 5, 7 ], res.documents.map( function( z ) { return z._id; } ), "A2" );
+assert.eq( 10, res.documents[1].x, "A3" );
+
+// missing ids are omitted, duplicates are fetched once
+res = db.runCommand( { batchGet : "batch_get1", ids : [ 2, 2, 200, 4 ] } );
+assert.eq( 2, res.documents.length, "B1" );
+assert.eq( 2, res.stats.n, "B2" );
+
+// empty ids and missing collection
+assert.eq( 0, db.runCommand( { batchGet : "batch_get1", ids : [] } ).documents.length, "C1" );
+assert.eq( 0, db.runCommand( { batchGet : "no_such_coll", ids : [ 1 ] } ).documents.length, "C2" );
+
+// ids must be an array
+assert.eq( 0, db.runCommand( { batchGet : "batch_get1", ids : 5 } ).ok, "D1" );
+
+// mixed key types probe correctly
+t.save( { _id : "a", x : 1 } );
+res = db.runCommand( { batchGet : "batch_get1", ids : [ "a", 0 ] } );
+assert.eq( 2, res.documents.length, "E1" );
@@ -0,0 +1,28 @@
+// benchRun latency stats, warmup, and target-rate mode
+
+t = db.bench_test3;
+t.drop();
+
+t.insert( { _id : 1 , x : 1 } );
+
+ops = [
+    { op : "findOne" , ns : t.getFullName() , query : { _id : 1 } }
+];
+
+res = benchRun( { ops : ops , parallel : 2 , seconds : 0.7 , warmup : 0.3 ,
+                  host : db.getMongo().host } );
+assert( res.latency , "no latency section" );
+var lat = res.latency.findOne;
+assert( lat , "no findOne latency stats" );
+assert.gt( lat.count , 0 , "no ops recorded" );
+assert.lte( lat.p50Micros , lat.p95Micros , "p50 > p95" );
+assert.lte( lat.p95Micros , lat.p99Micros , "p95 > p99" );
+assert.lte( lat.p99Micros , lat.maxMicros , "p99 > max" );
+assert.gt( lat.histogram.length , 0 , "empty histogram" );
+
+// open loop: should do roughly rate * seconds ops, not as many as possible
+res = benchRun( { ops : ops , parallel : 2 , seconds : 1 , rate : 100 ,
+                  host : db.getMongo().host } );
+var lat = res.latency.findOne;
+assert.gt( lat.count , 20 , "open loop barely ran" );
+assert.lt( lat.count , 500 , "open loop ignored the target rate" );
@@ -0,0 +1,51 @@
+// range counts served from btree key counts must agree with a full scan
+
+t = db.count6;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ )
+    t.save( { x : i % 100 , y : "" + i } );
+t.save( { x : "str" } );
+t.save( { x : null } );
+t.save( { y : 1 } ); // no x
+
+function check( q ) {
+    var viaCount = t.count( q );
+    var viaScan = t.find( q ).itcount();
+    assert.eq( viaScan , viaCount , "count mismatch for " + tojson( q ) );
+}
+
+function checkAll() {
+    check( { x : { $gt : 50 } } );
+    check( { x : { $gte : 50 } } );
+    check( { x : { $lt : 50 } } );
+    check( { x : { $lte : 50 } } );
+    check( { x : { $gt : 10 , $lte : 20 } } );
+    check( { x : { $gte : 10 , $lt : 10 } } );   // empty range
+    check( { x : { $gt : 1000 } } );             // beyond all values
+    check( { x : { $gt : -1 } } );               // all numbers, not the string/null
+    check( { x : { $gte : "a" , $lt : "z" } } ); // string range
+    assert.eq( 5 , t.find( { x : { $gt : 10 , $lte : 20 } } ).limit( 5 ).count( true ) , "limit" );
+    assert.eq( t.count( { x : { $gt : 20 } } ) - 3 ,
+               db.runCommand( { count : "count6" , query : { x : { $gt : 20 } } , skip : 3 } ).n , "skip" );
+}
+
+// no index: matcher path
+checkAll();
+
+// ascending index: btree range path
+t.ensureIndex( { x : 1 } );
+checkAll();
+
+// descending index
+t.dropIndex( { x : 1 } );
+t.ensureIndex( { x : -1 } );
+checkAll();
+
+// deletes leave unused btree keys behind; they must not be counted
+t.remove( { x : { $gte : 30 , $lt : 60 } } );
+checkAll();
+
+// a multikey index can't serve counts from keys alone
+t.save( { x : [ 15 , 16 , 17 ] } );
+checkAll();
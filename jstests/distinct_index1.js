@@ -35,9 +35,11 @@ assert.eq( 1000 , x.stats.nscannedObjects , "AC3" )
 t.ensureIndex( { a : 1 } )
 
 x = d( "a" );
-assert.eq( 1000 , x.stats.n , "BA1" )
-assert.eq( 1000 , x.stats.nscanned , "BA2" )
+// index-only distinct hops between values - one key visit per distinct value
+assert.eq( 10 , x.stats.n , "BA1" )
+assert.eq( 10 , x.stats.nscanned , "BA2" )
 assert.eq( 0 , x.stats.nscannedObjects , "BA3" )
+assert.eq( [0,1,2,3,4,5,6,7,8,9] , x.values , "BA4" )
 
 x = d( "a" , { a : { $gt : 5 } } );
 assert.eq( 398 , x.stats.n , "BB1" )
@@ -0,0 +1,161 @@
+/*
+   test durability of tiny in-place updates ($inc counters etc.), which are
+   journaled as packed micro entries rather than full basic writes
+*/
+
+var debugging = false;
+var testname = "micro";
+var step = 1;
+var conn = null;
+
+function checkNoJournalFiles(path, pass) {
+    var files = listFiles(path);
+    if (files.some(function (f) { return f.name.indexOf("prealloc") < 0; })) {
+        if (pass == null) {
+            // wait a bit longer for mongod to potentially finish if it is still running.
+            sleep(10000);
+            return checkNoJournalFiles(path, 1);
+        }
+        print("\n\n\n");
+        print("FAIL path:" + path);
+        print("unexpected files:");
+        printjson(files);
+        assert(false, "FAIL a journal/lsn file is present which is unexpected");
+    }
+}
+
+function runDiff(a, b) {
+    function reSlash(s) {
+        var x = s;
+        if (_isWindows()) {
+            while (1) {
+                var y = x.replace('/', '\\');
+                if (y == x)
+                    break;
+                x = y;
+            }
+        }
+        return x;
+    }
+    a = reSlash(a);
+    b = reSlash(b);
+    print("diff " + a + " " + b);
+    return run("diff", a, b);
+}
+
+function log(str) {
+    print();
+    if(str)
+        print(testname+" step " + step++ + " " + str);
+    else
+        print(testname+" step " + step++);
+}
+
+// set _id on inserts so the two runs produce binary identical files
+function work() {
+    log("work");
+    var d = conn.getDB("test");
+
+    for (var i = 0; i < 10; i++)
+        d.counters.insert({ _id: i, n: 0, m: NumberLong(0), d: 0.0, s: "x" });
+
+    // lots of tiny in-place updates against a handful of documents - the case
+    // the micro entry format exists for
+    for (var pass = 0; pass < 50; pass++) {
+        for (var i = 0; i < 10; i++) {
+            d.counters.update({ _id: i }, { $inc: { n: 1, m: NumberLong(3), d: 0.5 } });
+        }
+        // an occasional same-size $set also goes in place
+        d.counters.update({ _id: pass % 10 }, { $set: { s: "y" } });
+    }
+
+    // and some ordinary writes mixed in so basic and micro entries share sections
+    d.other.insert({ _id: 1, x: 22 });
+    d.other.insert({ _id: 2, x: 22, y: [1, 2, 3] });
+    d.other.update({ _id: 2 }, { $inc: { x: 1} });
+
+    // assure writes applied in case we kill -9 on return from this function
+    d.getLastError();
+
+    log("endwork");
+    return d;
+}
+
+function verify() {
+    log("verify counters");
+    var d = conn.getDB("test");
+    assert.eq(10, d.counters.count(), "counters count");
+    d.counters.find().forEach(function (doc) {
+        assert.eq(50, doc.n, "n wrong for _id " + doc._id);
+        assert.eq(150, doc.m, "m wrong for _id " + doc._id);
+        assert.eq(25, doc.d, "d wrong for _id " + doc._id);
+        assert.eq("y", doc.s, "s wrong for _id " + doc._id);
+    });
+    assert.eq(2, d.other.count(), "other count");
+}
+
+if( debugging ) {
+    // mongod already running in debugger
+    conn = db.getMongo();
+    work();
+    sleep(30000);
+    quit();
+}
+
+log();
+
+// directories
+var path1 = "/data/db/" + testname+"nodur";
+var path2 = "/data/db/" + testname+"dur";
+
+// non-durable version
+log("run mongod without journaling");
+conn = startMongodEmpty("--port", 30000, "--dbpath", path1, "--nodur", "--smallfiles");
+work();
+stopMongod(30000);
+
+// durable version
+log("run mongod with --journal");
+conn = startMongodEmpty("--port", 30001, "--dbpath", path2, "--journal", "--smallfiles", "--journalOptions", 8);
+work();
+
+// wait for group commit.
+printjson(conn.getDB('admin').runCommand({getlasterror:1, fsync:1}));
+
+// kill the process hard
+log("kill 9");
+stopMongod(30001, /*signal*/9);
+
+// journal file should be present, and non-empty as we killed hard
+
+// restart and recover
+log("restart mongod --journal and recover");
+conn = startMongodNoReset("--port", 30002, "--dbpath", path2, "--journal", "--smallfiles", "--journalOptions", 8);
+verify();
+
+log("stop mongod");
+stopMongod(30002);
+
+// at this point, after clean shutdown, there should be no journal files
+log("check no journal files (after presumably clean shutdown)");
+checkNoJournalFiles(path2 + "/journal");
+
+log("check data matches ns");
+var diff = runDiff(path1 + "/test.ns", path2 + "/test.ns");
+if (diff != "") {
+    print("\n\n\nDIFFERS\n");
+    print(diff);
+}
+assert(diff == "", "error test.ns files differ");
+
+log("check data matches .0");
+var diff = runDiff(path1 + "/test.0", path2 + "/test.0");
+if (diff != "") {
+    print("\n\n\nDIFFERS\n");
+    print(diff);
+}
+assert(diff == "", "error test.0 files differ");
+
+log("check data matches done");
+
+print(testname + " SUCCESS");
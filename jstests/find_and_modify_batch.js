@@ -0,0 +1,50 @@
+// tests the batched claim mode of findAndModify
+
+t = db.find_and_modify_batch;
+t.drop();
+
+for ( i=0; i<10; i++ )
+    t.insert( { _id : i , priority : i % 3 , claimed : false } );
+
+// claim 4 highest priority unclaimed jobs
+out = t.runCommand( "findAndModify" , { query : { claimed : false } ,
+                                        sort : { priority : -1 } ,
+                                        update : { $set : { claimed : true } } ,
+                                        batch : 4 } );
+assert.eq( 4 , out.n );
+assert.eq( 4 , out.values.length );
+for ( i=0; i<out.values.length; i++ )
+    assert.eq( false , out.values[i].claimed , "old image returned by default" );
+assert.eq( 4 , t.count( { claimed : true } ) );
+
+// sort was honored - the claimed docs are the highest priority ones
+assert.eq( 0 , t.count( { claimed : false , priority : 2 } ) );
+
+// new:true returns the updated images
+out = t.runCommand( "findAndModify" , { query : { claimed : false } ,
+                                        update : { $set : { claimed : true } } ,
+                                        "new" : true ,
+                                        batch : 3 } );
+assert.eq( 3 , out.n );
+for ( i=0; i<out.values.length; i++ )
+    assert.eq( true , out.values[i].claimed );
+
+// asking for more than remain just returns what's there
+out = t.runCommand( "findAndModify" , { query : { claimed : false } ,
+                                        remove : true ,
+                                        batch : 100 } );
+assert.eq( 3 , out.n );
+assert.eq( 7 , t.count() );
+assert.eq( 0 , t.count( { claimed : false } ) );
+
+// nothing matches -> empty batch, not an error
+out = t.runCommand( "findAndModify" , { query : { claimed : false } , remove : true , batch : 5 } );
+assert.eq( 0 , out.n );
+assert.eq( 0 , out.values.length );
+
+// upsert is not allowed in batch mode
+out = t.runCommand( "findAndModify" , { query : { nosuch : 1 } ,
+                                        update : { $set : { a : 1 } } ,
+                                        upsert : true ,
+                                        batch : 2 } );
+assert.eq( 0 , out.ok );
@@ -0,0 +1,31 @@
+// per size-class freelist occupancy in validate and collStats
+
+t = db.freelist_stats;
+t.drop();
+
+big = new Array( 1000 ).join( "x" );
+for ( i = 0; i < 200; i++ )
+    t.save( { _id : i, s : big } );
+t.remove( { _id : { $lt : 100 } } );
+
+var v = t.validate();
+assert( v.valid, "collection should validate" );
+assert( v.deletedCount >= 100, "expected deleted records" );
+assert( v.deletedBuckets.length > 0, "per-bucket freelist stats missing" );
+var total = 0;
+var bytes = 0;
+v.deletedBuckets.forEach( function( b ) { total += b.count; bytes += b.bytes; } );
+assert.eq( v.deletedCount, total, "bucket counts should add up" );
+assert.eq( v.deletedSize, bytes, "bucket bytes should add up" );
+
+var s = db.runCommand( { collStats : "freelist_stats", verbose : true } );
+assert( s.ok, "collStats failed" );
+assert( s.freelist, "freelist missing from verbose collStats" );
+assert( s.freelist.length > 0, "freelist empty" );
+
+// freed space is reused, not leaked to new extents
+for ( i = 200; i < 300; i++ )
+    t.save( { _id : i, s : big } );
+assert.eq( 200, t.count() );
+
+t.drop();
@@ -0,0 +1,117 @@
+// native (non-JS) group accumulators
+
+t = db.group_accumulators;
+t.drop();
+
+t.insert( { cat : "a" , x : 1 } );
+t.insert( { cat : "a" , x : 5 } );
+t.insert( { cat : "b" , x : 2 } );
+t.insert( { cat : "b" , x : 4 } );
+t.insert( { cat : "b" , x : 6 } );
+t.insert( { cat : "c" } ); // no x
+
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : { cat : 1 } ,
+                                 accumulators : { total : { $sum : "x" } ,
+                                                  avg : { $avg : "x" } ,
+                                                  low : { $min : "x" } ,
+                                                  high : { $max : "x" } ,
+                                                  xs : { $push : "x" } ,
+                                                  n : { $count : 1 } } } } );
+assert.eq( 1 , res.ok , tojson( res ) );
+assert.eq( 3 , res.keys );
+assert.eq( 6 , res.count );
+
+byCat = {};
+res.retval.forEach( function( r ) { byCat[r.cat] = r; } );
+
+assert.eq( 6 , byCat.a.total );
+assert.eq( 3 , byCat.a.avg );
+assert.eq( 1 , byCat.a.low );
+assert.eq( 5 , byCat.a.high );
+assert.eq( [1,5] , byCat.a.xs );
+assert.eq( 2 , byCat.a.n );
+
+assert.eq( 12 , byCat.b.total );
+assert.eq( 4 , byCat.b.avg );
+assert.eq( 2 , byCat.b.low );
+assert.eq( 6 , byCat.b.high );
+assert.eq( 3 , byCat.b.n );
+
+// group with no x values: sum 0, avg/min/max null, empty push
+assert.eq( 0 , byCat.c.total );
+assert.eq( null , byCat.c.avg );
+assert.eq( null , byCat.c.low );
+assert.eq( [] , byCat.c.xs );
+assert.eq( 1 , byCat.c.n );
+
+// cond is honored
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : { cat : 1 } ,
+                                 cond : { x : { $gt : 1 } } ,
+                                 accumulators : { n : { $count : 1 } } } } );
+assert.eq( 1 , res.ok );
+assert.eq( 2 , res.keys );
+assert.eq( 4 , res.count );
+
+// can't mix with the JS reduce form
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : { cat : 1 } ,
+                                 initial : { n : 0 } ,
+                                 accumulators : { n : { $count : 1 } } } } );
+assert.eq( 0 , res.ok );
+
+// unknown operator rejected
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : { cat : 1 } ,
+                                 accumulators : { n : { $bogus : "x" } } } } );
+assert.eq( 0 , res.ok );
+
+// many distinct keys to exercise hash table growth
+t.drop();
+for ( i = 0; i < 5000; i++ )
+    t.insert( { k : i , x : i } );
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : { k : 1 } ,
+                                 accumulators : { total : { $sum : "x" } } } } );
+assert.eq( 1 , res.ok );
+assert.eq( 5000 , res.keys );
+assert.eq( 5000 , res.count );
+
+// empty key: single group, exercises the typed batch scan
+t.drop();
+for ( i = 0; i < 1000; i++ )
+    t.insert( { x : i } );             // NumberDouble run
+for ( i = 0; i < 1000; i++ )
+    t.insert( { x : NumberLong( 2 ) } ); // NumberLong run
+t.insert( { x : "not a number" } );
+t.insert( { y : 1 } );                 // x missing
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : {} ,
+                                 accumulators : { total : { $sum : "x" } ,
+                                                  avg : { $avg : "x" } ,
+                                                  n : { $count : 1 } } } } );
+assert.eq( 1 , res.ok );
+assert.eq( 1 , res.keys );
+assert.eq( 2002 , res.count );
+assert.eq( 999 * 1000 / 2 + 2000 , res.retval[0].total );
+assert.close( res.retval[0].total / 2000 , res.retval[0].avg );
+assert.eq( 2002 , res.retval[0].n );
+
+// empty key with a cond still filters
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : {} ,
+                                 cond : { x : { $lt : 10 } } ,
+                                 accumulators : { total : { $sum : "x" } } } } );
+assert.eq( 1 , res.ok );
+assert.eq( 10 , res.count );
+assert.eq( 45 , res.retval[0].total );
+
+// empty key on an empty collection: no groups
+t.drop();
+res = db.runCommand( { group : { ns : t.getName() ,
+                                 key : {} ,
+                                 accumulators : { n : { $count : 1 } } } } );
+assert.eq( 1 , res.ok );
+assert.eq( 0 , res.keys );
+assert.eq( 0 , res.retval.length );
@@ -0,0 +1,30 @@
+// covered point reads by _id: a projection contained in an _id prefixed
+// index is answered from the index key alone, without touching the document
+
+t = db.idhack_covered
+t.drop()
+
+t.insert( { _id : 1 , v : "a" , big : "x" } )
+t.insert( { _id : 2 , v : "b" , big : "y" } )
+
+t.ensureIndex( { _id : 1 , v : 1 } )
+
+assert.eq( "a" , t.findOne( { _id : 1 } , { _id : 1 , v : 1 } ).v , "A1" )
+assert.eq( undefined , t.findOne( { _id : 1 } , { _id : 1 , v : 1 } ).big , "A2" )
+assert.eq( 1 , t.findOne( { _id : 1 } , { _id : 1 } )._id , "A3" )
+assert.eq( null , t.findOne( { _id : 5 } , { _id : 1 , v : 1 } ) , "A4" )
+
+// the projection can also be served by the plain _id index
+assert.eq( 2 , t.findOne( { _id : 2 } , { _id : 1 } )._id , "A5" )
+
+// an uncovered projection still reads the document
+assert.eq( "y" , t.findOne( { _id : 2 } , { big : 1 } ).big , "A6" )
+
+// updates through the normal path are visible to covered reads
+t.update( { _id : 1 } , { $set : { v : "c" } } )
+assert.eq( "c" , t.findOne( { _id : 1 } , { _id : 1 , v : 1 } ).v , "B1" )
+
+// a multikey indexed field forces a fall back to the document
+t.insert( { _id : 3 , v : [ 1 , 2 ] } )
+assert.eq( 2 , t.findOne( { _id : 3 } , { _id : 1 , v : 1 } ).v.length , "C1" )
+assert.eq( "c" , t.findOne( { _id : 1 } , { _id : 1 , v : 1 } ).v , "C2" )
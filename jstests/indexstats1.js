@@ -0,0 +1,36 @@
+// basic tests for the indexStats command
+
+t = db.indexstats1;
+t.drop();
+
+t.ensureIndex( { x : 1 } );
+t.ensureIndex( { unused : 1 } );
+
+for ( i = 0; i < 100; i++ )
+    t.insert( { x : i , unused : i } );
+
+assert.eq( 1 , t.find( { x : 3 } ).hint( { x : 1 } ).itcount() );
+
+res = db.runCommand( { indexStats : "indexstats1" } );
+assert( res.ok , "command failed" );
+
+xs = res.indexes[ "x_1" ];
+assert( xs , "no stats for x_1" );
+assert( xs.keysInserted >= 100 , "keysInserted: " + tojson( xs ) );
+assert( xs.accesses >= 1 , "accesses: " + tojson( xs ) );
+assert( xs.lastAccess , "lastAccess: " + tojson( xs ) );
+
+// the unused index pays maintenance but shows no reads
+us = res.indexes[ "unused_1" ];
+assert( us , "no stats for unused_1" );
+assert( us.keysInserted >= 100 , "unused keysInserted: " + tojson( us ) );
+
+// removals are counted too
+t.remove( { x : { $lt : 50 } } );
+res = db.runCommand( { indexStats : "indexstats1" } );
+assert( res.indexes[ "x_1" ].keysRemoved >= 50 , "keysRemoved: " + tojson( res.indexes[ "x_1" ] ) );
+
+// dropping an index drops its counters
+t.dropIndex( { unused : 1 } );
+res = db.runCommand( { indexStats : "indexstats1" } );
+assert.eq( undefined , res.indexes[ "unused_1" ] , "stats survived index drop" );
@@ -0,0 +1,18 @@
+// $maxTimeMS: server side time limit on a query, enforced in the scan loop
+// itself rather than waiting for the next yield.
+
+t = db.jstests_maxtimems;
+t.drop();
+
+for( i = 0; i < 1000; ++i ) {
+    t.save( {i:i} );
+}
+
+// no limit and a generous limit are unaffected
+assert.eq( 1000, t.find().itcount() );
+assert.eq( 1000, t.find()._addSpecial( "$maxTimeMS", 600000 ).itcount() );
+
+// a scan that sleeps per document blows a 1ms budget almost immediately
+assert.throws( function() {
+    t.find( { $where: function() { sleep( 1 ); return true; } } )._addSpecial( "$maxTimeMS", 1 ).itcount();
+} );
@@ -0,0 +1,18 @@
+// setOpPriority command basics
+
+var res = db.adminCommand( { setOpPriority : -1 } );
+assert( res.ok, "setOpPriority -1 failed" );
+assert.eq( 0, res.was, "default priority should be normal" );
+
+// ops still run while low priority
+db.op_priority1.save( { _id : 1 } );
+assert.eq( 1, db.op_priority1.count() );
+
+res = db.adminCommand( { setOpPriority : 0 } );
+assert( res.ok, "setOpPriority 0 failed" );
+assert.eq( -1, res.was, "previous priority not reported" );
+
+// only -1 and 0 are valid
+assert.eq( 0, db.adminCommand( { setOpPriority : 5 } ).ok, "bad priority accepted" );
+
+db.op_priority1.drop();
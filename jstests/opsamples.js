@@ -0,0 +1,26 @@
+// basic test of the sampled operation profiler (opSamples command).
+// the sampler keeps 1 of every few ops, so issue plenty of one shape.
+
+t = db.opsamples1;
+t.drop();
+
+for ( var i = 0; i < 100; i++ )
+    t.insert( { x : i } );
+db.getLastError();
+
+for ( var i = 0; i < 200; i++ )
+    t.findOne( { x : { $gt : i } } );
+
+var res = db.adminCommand( { opSamples : 1, max : 1000 } );
+assert( res.ok, tojson( res ) );
+assert( res.sampled > 0, tojson( res ) );
+
+var found = false;
+res.shapes.forEach( function( s ) {
+    assert( s.count > 0, tojson( s ) );
+    if ( s.ns == t.getFullName() && s.op == "query" )
+        found = true;
+} );
+assert( found, "no sample for our query shape: " + tojson( res ) );
+
+t.drop();
@@ -0,0 +1,43 @@
+// range deletes on an indexed field take a bulk btree-range path; verify the
+// results match the generic path's semantics.
+
+t = db.jstests_remove11;
+
+function reset() {
+    t.drop();
+    t.ensureIndex( {ts:1} );
+    for( i = 0; i < 100; ++i ) {
+        t.save( {ts:i} );
+    }
+    t.save( {x:1} );       // no ts
+    t.save( {ts:"s"} );    // wrong type - outside the number bracket
+}
+
+reset();
+t.remove( {ts:{$lt:50}} );
+assert.eq( 52, t.count() );
+assert.eq( 50, t.find( {ts:{$gte:50}} ).itcount() );
+assert.eq( 1, t.count( {x:1} ) );
+assert.eq( 1, t.count( {ts:"s"} ) );
+
+reset();
+t.remove( {ts:{$gte:20,$lt:30}} );
+assert.eq( 92, t.count() );
+assert.eq( 0, t.count( {ts:{$gte:20,$lt:30}} ) );
+assert.eq( 1, t.count( {ts:19} ) );
+assert.eq( 1, t.count( {ts:30} ) );
+
+// exclusive lower bound
+reset();
+t.remove( {ts:{$gt:97}} );
+assert.eq( 1, t.count( {ts:97} ) );
+assert.eq( 0, t.count( {ts:{$gt:97,$lt:100}} ) );
+
+// multikey: doc appears under several entries but is deleted once
+reset();
+t.save( {ts:[1000,2000]} );
+t.remove( {ts:{$gte:1000}} );
+assert.eq( 0, t.count( {ts:{$gte:1000}} ) );
+
+// everything still consistent
+assert( t.validate().valid );
@@ -0,0 +1,34 @@
+// batch inserts through mongos are grouped by owning shard; every document
+// must land exactly once, on the shard that owns its chunk
+
+s = new ShardingTest( "bulk_insert1", 2, 0, 1, { chunksize : 1 } );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo", key : { x : 1 } } );
+
+db = s.getDB( "test" );
+
+// presplit and distribute so one batch straddles both shards
+s.adminCommand( { split : "test.foo", middle : { x : 500 } } );
+s.adminCommand( { moveChunk : "test.foo", find : { x : 500 },
+                  to : s.getOther( s.getServer( "test" ) ).name } );
+
+var batch = [];
+for ( var i = 0; i < 1000; i++ )
+    batch.push( { x : i, s : "some padding to make the documents non-trivial" } );
+db.foo.insert( batch );
+db.getLastError();
+
+assert.eq( 1000, db.foo.count(), "total count wrong" );
+for ( var i = 0; i < 1000; i += 111 )
+    assert.eq( 1, db.foo.find( { x : i } ).itcount(), "missing or duplicated doc " + i );
+
+var total = 0;
+s._connections.forEach( function( z ) {
+    var n = z.getDB( "test" ).foo.count();
+    assert( n > 0, "every shard should have received part of the batch" );
+    total += n;
+} );
+assert.eq( 1000, total, "shard counts should add up with no duplicates" );
+
+s.stop();
@@ -0,0 +1,48 @@
+// mongos result cache: repeated identical count/distinct on a sharded
+// collection are answered from the cache, entries expire after the TTL
+
+s = new ShardingTest( "result_cache1" , 2 , 0 , 2 ,
+                      { chunksize : 1 , extraOptions : { resultCacheSize : 4 , resultCacheTTL : 2 } } );
+
+s.adminCommand( { enablesharding : "test" } );
+s.adminCommand( { shardcollection : "test.foo" , key : { x : 1 } } );
+
+db = s.getDB( "test" );
+for ( i=0; i<100; i++ )
+    db.foo.insert( { x : i } );
+db.getLastError();
+
+s.adminCommand( { split : "test.foo" , middle : { x : 50 } } );
+s.adminCommand( { movechunk : "test.foo" , find : { x : 75 } ,
+                  to : s.getOther( s.getServer( "test" ) ).name } );
+
+function cacheStats() {
+    var st = s.s0.getDB( "admin" ).runCommand( { serverStatus : 1 } ).resultCache;
+    assert( st , "no resultCache section in serverStatus" );
+    return st;
+}
+
+assert( cacheStats().enabled , "cache not enabled" );
+
+// identical counts: first one fills the cache, second one hits it
+assert.eq( 100 , db.foo.count() , "A1" );
+var before = cacheStats();
+assert.eq( 100 , db.foo.count() , "A2" );
+var after = cacheStats();
+assert.eq( before.hits + 1 , after.hits , "A3 second identical count missed the cache" );
+
+// same for distinct
+assert.eq( 100 , db.foo.distinct( "x" ).length , "B1" );
+before = cacheStats();
+assert.eq( 100 , db.foo.distinct( "x" ).length , "B2" );
+after = cacheStats();
+assert.eq( before.hits + 1 , after.hits , "B3 second identical distinct missed the cache" );
+
+// a write through the other mongos doesn't bump shard versions, so s0 may
+// serve the old count - but only until the entry's TTL runs out
+s.s1.getDB( "test" ).foo.insert( { x : 100.5 } );
+s.s1.getDB( "test" ).getLastError();
+sleep( 2500 ); // > resultCacheTTL
+assert.eq( 101 , db.foo.count() , "C1 cache entry outlived its TTL" );
+
+s.stop();
@@ -0,0 +1,35 @@
+// basic coverage for --asyncInserts: staged inserts become visible after
+// getLastError drains the queue, and the serverStatus section is present
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_slowNightly_async_inserts";
+
+var m = startMongod( "--port", port, "--dbpath", "/data/db/" + baseName, "--asyncInserts" );
+var db = m.getDB( baseName );
+var t = db.getCollection( baseName );
+
+var N = 10000;
+for ( var i = 0; i < N; i++ )
+    t.insert( { _id: i, x: i } );
+
+// getLastError must wait for the queue to drain, so all documents are
+// visible afterwards (read-your-own-writes for acknowledged clients)
+db.getLastError();
+assert.eq( N, t.count(), "staged inserts not applied after getLastError" );
+
+// documents staged in a batch still get _ids and go through the usual checks
+assert.eq( 1, t.find( { _id: N - 1 } ).itcount() );
+
+// duplicate keys are dropped silently (fire and forget), not applied twice
+t.insert( { _id: 0 } );
+db.getLastError();
+assert.eq( N, t.count(), "duplicate applied or drain lost documents" );
+
+var stats = db.getSisterDB( "admin" ).runCommand( { serverStatus: 1 } ).insertQueue;
+assert( stats, "no insertQueue section in serverStatus" );
+assert.eq( N + 1, stats.staged, "staged count wrong" );
+assert.eq( N, stats.applied, "applied count wrong" );
+assert.eq( 1, stats.failed, "failed count wrong" );
+assert( stats.batches > 0, "no batches recorded" );
+
+stopMongod( port );
@@ -0,0 +1,60 @@
+// exercise the backupStart / backupFetch / backupEnd protocol.  this checks
+// the command contract; actual restore testing needs a harness that can write
+// the fetched bytes back out.
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_slowNightly_backup_commands";
+
+var m = startMongod( "--port", port, "--dbpath", "/data/db/" + baseName, "--dur", "--smallfiles" );
+var db = m.getDB( baseName );
+var admin = m.getDB( "admin" );
+
+for ( var i = 0; i < 1000; i++ )
+    db.foo.insert( { _id: i, x: i } );
+db.getLastError();
+
+var res = admin.runCommand( { backupStart: 1, throttleMBPerSec: 50 } );
+assert( res.ok, "backupStart failed: " + tojson( res ) );
+assert( res.backupId, "no backupId" );
+assert( res.files.length > 0, "no files listed" );
+
+// data files must come before journal files so a restore replays cleanly
+var sawJournal = false;
+for ( var i = 0; i < res.files.length; i++ ) {
+    var name = res.files[ i ].name;
+    if ( name.indexOf( "journal/" ) == 0 )
+        sawJournal = true;
+    else
+        assert( !sawJournal, "data file listed after journal files: " + name );
+}
+assert( sawJournal, "no journal files listed under --dur" );
+
+// a second backupStart while one is active must fail
+assert.eq( 0, admin.runCommand( { backupStart: 1 } ).ok, "concurrent backupStart allowed" );
+
+// fetch the first file end to end; chunks are capped at 4mb
+var f = res.files[ 0 ];
+var offset = 0;
+while ( true ) {
+    var chunk = admin.runCommand( { backupFetch: 1, backupId: res.backupId, file: f.name, offset: offset } );
+    assert( chunk.ok, "backupFetch failed: " + tojson( chunk ) );
+    assert.eq( offset, chunk.offset, "wrong offset echoed" );
+    if ( chunk.length == 0 )
+        break;
+    offset += chunk.length;
+}
+assert( offset >= f.length, "fetched less than the listed length of " + f.name );
+
+// bogus ids and path escapes are rejected
+assert.eq( 0, admin.runCommand( { backupFetch: 1, backupId: new ObjectId(), file: f.name, offset: 0 } ).ok, "wrong backupId accepted" );
+assert.eq( 0, admin.runCommand( { backupFetch: 1, backupId: res.backupId, file: "../etc/passwd", offset: 0 } ).ok, "path escape accepted" );
+
+assert( admin.runCommand( { backupEnd: 1, backupId: res.backupId } ).ok, "backupEnd failed" );
+
+// fetch after end must fail, and a fresh backup can start again
+assert.eq( 0, admin.runCommand( { backupFetch: 1, backupId: res.backupId, file: f.name, offset: 0 } ).ok, "fetch after backupEnd allowed" );
+var res2 = admin.runCommand( { backupStart: 1 } );
+assert( res2.ok, "backupStart after backupEnd failed" );
+assert( admin.runCommand( { backupEnd: 1, backupId: res2.backupId } ).ok );
+
+stopMongod( port );
@@ -0,0 +1,57 @@
+// indexBuildControl: pause/resume and throttle a background index build
+
+t = db.index_build_control;
+t.drop();
+
+var admin = db.getSisterDB( "admin" );
+
+function control( opts ) {
+    opts = opts || {};
+    opts.indexBuildControl = 1;
+    var res = admin.runCommand( opts );
+    assert( res.ok , "indexBuildControl failed: " + tojson( res ) );
+    return res;
+}
+
+var N = 50000;
+for ( var i = 0; i < N; i++ )
+    t.insert( { x : i , y : "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaaa" } );
+db.getLastError();
+
+// pause before the build starts so it can't finish under us
+control( { pause : true , maxDocsPerSec : 20000 } );
+
+var join = startParallelShell(
+    "db.getSisterDB('" + db.getName() + "').index_build_control.ensureIndex( { x : 1 } , { background : true } );" );
+
+function ourBuild() {
+    var inprog = control().inprog;
+    for ( var i = 0; i < inprog.length; i++ )
+        if ( inprog[i].ns == t.getFullName() )
+            return inprog[i];
+    return null;
+}
+
+assert.soon( ourBuild , "build never showed up in indexBuildControl" );
+
+// paused: progress must not move
+var a = ourBuild();
+sleep( 1500 );
+var b = ourBuild();
+assert( b , "build vanished while paused" );
+assert.eq( a.done , b.done , "build made progress while paused" );
+assert.lt( b.done , N , "build finished while paused" );
+
+// resume, throttled; 50k docs at 20k/sec shouldn't beat ~2 secs
+var start = new Date();
+control( { pause : false } );
+join();
+var secs = ( new Date() - start ) / 1000;
+
+assert.eq( 2 , t.getIndexes().length , "index didn't build" );
+assert.eq( N , t.find().hint( { x : 1 } ).itcount() , "index incomplete" );
+assert.gt( secs , 1.5 , "throttle had no effect: " + secs + " secs" );
+assert.eq( 0 , control().inprog.length , "build still listed after finishing" );
+
+// don't leak settings into later tests
+control( { maxDocsPerSec : 0 , pause : false } );
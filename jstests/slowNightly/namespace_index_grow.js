@@ -0,0 +1,45 @@
+// when the fixed size .ns table fills, new namespaces overflow into a lazily
+// created .ns1 extension file; it must survive restarts and go away with the db
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_namespace_index_grow";
+var dbpath = "/data/db/" + baseName;
+
+var m = startMongod( "--port", port, "--dbpath", dbpath, "--nssize", "1", "--smallfiles", "--noprealloc" );
+db = m.getDB( "test" );
+
+// a 1MB .ns holds ~1600 namespaces and each collection takes two (data +
+// _id index), so this has to spill over
+var N = 1200;
+for ( var i = 0; i < N; i++ )
+    db.getCollection( "coll" + i ).insert( { _id : i } );
+db.getLastError();
+
+function hasExt() {
+    var files = listFiles( dbpath );
+    for ( var i = 0; i < files.length; i++ )
+        if ( files[i].name.indexOf( "test.ns1" ) >= 0 )
+            return true;
+    return false;
+}
+
+assert( hasExt() , "no extension file created" );
+assert.eq( 1 , db.getCollection( "coll" + ( N - 1 ) ).count() , "insert into overflowed namespace failed" );
+assert.lte( N , db.getCollectionNames().length , "collections missing from listing" );
+assert.eq( N - 1 , db.getCollection( "coll" + ( N - 1 ) ).findOne()._id , "bad doc in overflowed collection" );
+
+// overflowed namespaces survive a restart
+stopMongod( port );
+m = startMongodNoReset( "--port", port, "--dbpath", dbpath, "--nssize", "1", "--smallfiles", "--noprealloc" );
+db = m.getDB( "test" );
+
+assert.lte( N , db.getCollectionNames().length , "collections missing after restart" );
+assert.eq( 1 , db.getCollection( "coll" + ( N - 1 ) ).count() , "overflowed collection lost on restart" );
+db.getCollection( "coll" + ( N - 1 ) ).drop();
+assert.eq( 0 , db.getCollection( "coll" + ( N - 1 ) ).count() , "drop of overflowed collection failed" );
+
+// dropDatabase must take the extension file with it
+db.dropDatabase();
+assert( !hasExt() , "extension file not removed on dropDatabase" );
+
+stopMongod( port );
@@ -0,0 +1,32 @@
+// collections created with { temp : true } are dropped at the next startup;
+// renaming one (how map-reduce promotes its output) makes it permanent
+
+port = allocatePorts( 1 )[ 0 ];
+var baseName = "jstests_temp_collection";
+var dbpath = "/data/db/" + baseName;
+
+var m = startMongod( "--port", port, "--dbpath", dbpath, "--smallfiles", "--noprealloc" );
+db = m.getDB( "test" );
+
+db.createCollection( "scratch", { temp: true } );
+db.scratch.insert( { a: 1 } );
+db.createCollection( "keepme" );
+db.keepme.insert( { a: 1 } );
+db.createCollection( "promoted", { temp: true } );
+db.promoted.insert( { a: 1 } );
+db.getLastError();
+
+assert.eq( 1, db.scratch.count(), "temp collection not usable" );
+assert( db.adminCommand( { renameCollection: "test.promoted", to: "test.final" } ).ok,
+        "rename of temp collection failed" );
+
+stopMongod( port );
+m = startMongodNoReset( "--port", port, "--dbpath", dbpath, "--smallfiles", "--noprealloc" );
+db = m.getDB( "test" );
+
+assert.eq( 0, db.scratch.count(), "temp collection not dropped on restart" );
+assert.eq( 0, db.system.namespaces.count( { name: "test.scratch" } ), "temp collection still listed" );
+assert.eq( 1, db.keepme.count(), "regular collection lost on restart" );
+assert.eq( 1, db.final.count(), "renamed temp collection lost on restart" );
+
+stopMongod( port );
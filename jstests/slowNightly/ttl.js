@@ -0,0 +1,25 @@
+// simple test for the TTL expiration monitor.
+// the monitor runs once a minute, so this has to wait for a pass.
+
+t = db.ttl_test;
+t.drop();
+
+var now = (new Date()).getTime();
+
+// 24 docs, one per hour going back a day
+for ( i = 0; i < 24; i++ )
+    t.insert( { x : new Date( now - ( 3600 * 1000 * i ) ) } );
+db.getLastError();
+
+assert.eq( 24 , t.count() );
+
+// expire everything older than 6 hours
+t.ensureIndex( { x : 1 } , { expireAfterSeconds : 3600 * 6 } );
+db.getLastError();
+
+// nothing happens until a monitor pass runs
+assert.eq( 24 , t.count() );
+
+sleep( 70 * 1000 );
+
+assert.eq( 6 , t.count() );
@@ -0,0 +1,37 @@
+// statusDelta: slim serverStatus where numeric fields are server-side deltas
+
+t = db.statusdelta1;
+t.drop();
+
+var admin = db.getSisterDB( "admin" );
+
+var first = admin.runCommand( { statusDelta : 1 } );
+assert( first.ok , "command failed" );
+assert( first.initial , "first call should return absolute values" );
+assert( first.token > 0 , "no token" );
+assert( first.opcounters , "no opcounters section" );
+
+for ( var i = 0; i < 100; i++ )
+    t.insert( { x : i } );
+db.getLastError();
+
+var second = admin.runCommand( { statusDelta : 1 , token : first.token } );
+assert( second.ok , "second call failed" );
+assert( ! second.initial , "second call should be a delta" );
+assert( second.token != first.token , "token not rotated" );
+assert( second.dtMillis >= 0 , "no dtMillis" );
+assert.gte( second.opcounters.insert , 100 , "insert delta too small" );
+
+// a stale or unknown token falls back to absolute values
+var third = admin.runCommand( { statusDelta : 1 , token : NumberLong( 999999999 ) } );
+assert( third.initial , "unknown token should give absolute values" );
+
+// only the requested sections come back
+var sel = admin.runCommand( { statusDelta : 1 , sections : [ "opcounters" , "network" ] } );
+assert( sel.ok , "sections call failed" );
+assert( sel.opcounters , "requested section missing" );
+assert( sel.network , "requested section missing" );
+assert( ! sel.mem , "unrequested section present" );
+
+assert.eq( 0 , admin.runCommand( { statusDelta : 1 , sections : [ "nosuchsection" ] } ).ok ,
+           "unknown section should fail" );
@@ -0,0 +1,44 @@
+// basic tokenized index / prefixSearch tests
+
+t = db.tokenindex1;
+t.drop();
+
+t.save( { _id : 1 , name : "Joe Smith" } );
+t.save( { _id : 2 , name : "joey tribbiani" } );
+t.save( { _id : 3 , name : "Mary Johnson-Smith" } );
+t.save( { _id : 4 , name : "Bob" } );
+t.save( { _id : 5 , name : [ "Jon" , "Jonathan" ] } );
+t.save( { _id : 6 , x : 17 } ); // no name; contributes no keys
+
+t.ensureIndex( { name : "tokenized" } );
+assert.isnull( db.getLastError() , "index build" );
+
+function ids( res ) {
+    assert( res.ok , "command failed: " + tojson( res ) );
+    return res.results.map( function( z ) { return z._id; } ).sort();
+}
+
+// word prefix matches any word position, case insensitively
+assert.eq( [ 1 , 2 , 5 ] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "jo" } ) ) , "jo" );
+assert.eq( [ 1 , 3 ] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "Smi" } ) ) , "Smi" );
+assert.eq( [ 3 ] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "johnson" } ) ) , "johnson" );
+assert.eq( [] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "zz" } ) ) , "zz" );
+
+// a doc with several matching tokens comes back once
+assert.eq( [ 5 ] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "jon" } ) ) , "jon" );
+
+// limit
+res = db.runCommand( { prefixSearch : "tokenindex1" , prefix : "jo" , limit : 1 } );
+assert.eq( 1 , res.results.length , "limit" );
+
+// bad prefixes are rejected
+assert.eq( 0 , db.runCommand( { prefixSearch : "tokenindex1" , prefix : "" } ).ok , "empty prefix" );
+assert.eq( 0 , db.runCommand( { prefixSearch : "tokenindex1" , prefix : "two words" } ).ok , "two words" );
+assert.eq( 0 , db.runCommand( { prefixSearch : "tokenindex1" , prefix : 5 } ).ok , "numeric prefix" );
+
+// updates maintain the token keys
+t.update( { _id : 4 } , { $set : { name : "Bobby Jones" } } );
+assert.eq( [ 1 , 2 , 4 , 5 ] , ids( db.runCommand( { prefixSearch : "tokenindex1" , prefix : "jo" } ) ) , "after update" );
+
+// the planner never picks the tokenized index for normal queries
+assert.eq( 1 , t.find( { name : "Bobby Jones" } ).itcount() , "plain query result" );
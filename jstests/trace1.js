@@ -0,0 +1,16 @@
+// operations sent by a tracing-aware client (the shell's driver is one)
+// carry a trace id that the profiler records as "traceid"
+
+db.setProfilingLevel( 0 );
+db.system.profile.drop();
+db.setProfilingLevel( 2 );
+
+t = db.trace1;
+t.drop();
+t.insert( { x : 1 } );
+t.findOne( { x : 1 } );
+
+db.setProfilingLevel( 0 );
+
+p = db.system.profile.find( { ns : "test.trace1" } ).sort( { $natural : -1 } ).limit( 1 ).next();
+assert( p.traceid > 0 , "no traceid in profile entry: " + tojson( p ) );
@@ -0,0 +1,31 @@
+// repeated upserts of the same key (dedup style) - exercises the recently
+// upserted location cache and its invalidation on delete
+
+t = db.upsert2;
+t.drop();
+
+for ( i = 0; i < 10; i++ )
+    t.update( { k : 1 } , { $inc : { n : 1 } } , true );
+assert.eq( 1 , t.count() );
+assert.eq( 10 , t.findOne( { k : 1 } ).n );
+
+// a delete must not leave a usable hint behind
+t.remove( { k : 1 } );
+t.update( { k : 1 } , { $inc : { n : 1 } } , true );
+assert.eq( 1 , t.count() );
+assert.eq( 1 , t.findOne( { k : 1 } ).n );
+
+// several hot keys at once
+for ( i = 0; i < 5; i++ )
+    for ( j = 0; j < 5; j++ )
+        t.update( { k : 10 + j } , { $inc : { n : 1 } } , true );
+for ( j = 0; j < 5; j++ )
+    assert.eq( 5 , t.findOne( { k : 10 + j } ).n , "key " + j );
+
+// growing documents force record moves; counts must stay right
+t.drop();
+big = new Array( 100 ).join( "x" );
+for ( i = 0; i < 20; i++ )
+    t.update( { k : 1 } , { $push : { a : big } } , true );
+assert.eq( 1 , t.count() );
+assert.eq( 20 , t.findOne( { k : 1 } ).a.length );
@@ -0,0 +1,35 @@
+// test the sample/yield options to the validate command
+
+t = db.validate_options;
+t.drop();
+
+for ( var i = 0; i < 1000; i++ )
+    t.save( { _id : i , x : "x".repeat ? "x".repeat( 10 ) : "xxxxxxxxxx" } );
+
+// plain validate
+res = db.runCommand( { validate : "validate_options" } );
+assert( res.ok , "plain ok" );
+assert( res.valid , "plain valid" );
+
+// full scan
+res = db.runCommand( { validate : "validate_options" , full : true } );
+assert( res.ok , "full ok" );
+assert( res.valid , "full valid" );
+assert.eq( 1000 , res.objectsFound , "full objectsFound" );
+assert.eq( 0 , res.invalidObjects , "full invalidObjects" );
+
+// quick spot check of 10% of records
+res = db.runCommand( { validate : "validate_options" , sample : 10 } );
+assert( res.ok , "sample ok" );
+assert( res.valid , "sample valid" );
+assert.eq( 1000 , res.objectsFound , "sample still walks all records" );
+assert.eq( 0 , res.invalidObjects , "sample invalidObjects" );
+
+// out of range samples are rejected
+assert.eq( 0 , db.runCommand( { validate : "validate_options" , sample : 101 } ).ok , "sample 101" );
+assert.eq( 0 , db.runCommand( { validate : "validate_options" , sample : -1 } ).ok , "sample -1" );
+
+// yielding scan
+res = db.runCommand( { validate : "validate_options" , full : true , yield : true } );
+assert( res.ok , "yield ok" );
+assert( res.valid , "yield valid" );
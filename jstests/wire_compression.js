@@ -0,0 +1,19 @@
+// negotiate snappy wire compression on this connection and make sure large
+// payloads still round trip (the server compresses its replies to us).
+
+t = db.wire_compression1;
+t.drop();
+
+var res = db.adminCommand( { setWireCompression : 1 } );
+assert( res.ok, "negotiation failed: " + tojson( res ) );
+assert.eq( "snappy", res.compression );
+
+var big = new Array( 50000 ).join( "abcdefgh" );
+for ( var i = 0; i < 10; i++ )
+    t.save( { _id : i, s : big } );
+
+assert.eq( 10, t.count() );
+for ( var i = 0; i < 10; i++ )
+    assert.eq( big, t.findOne( { _id : i } ).s );
+
+t.drop();
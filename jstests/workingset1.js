@@ -0,0 +1,21 @@
+// workingSet command and serverStatus section report sampled fault stats
+
+t = db.workingset1;
+t.drop();
+
+for ( i = 0; i < 1000; i++ )
+    t.save( { _id : i, x : i } );
+assert.eq( 1000, t.find( { x : { $gte : 0 } } ).itcount() );
+
+var res = db.adminCommand( { workingSet : 1 } );
+assert( res.ok, "workingSet command failed" );
+assert( res.checks >= 0, "no global checks counter" );
+assert( res.faults >= 0, "no global faults counter" );
+assert( res.faults <= res.checks, "faults cannot exceed checks" );
+assert( res.collections, "no per-collection section" );
+
+var ss = db.serverStatus();
+assert( ss.workingSet, "serverStatus workingSet section missing" );
+assert.eq( res.ok, 1 );
+
+t.drop();
@@ -22,6 +22,7 @@
 #include "../db/cmdline.h"
 
 #include "../client/distlock.h"
+#include "../util/net/listen.h"
 
 #include "balance.h"
 #include "server.h"
@@ -179,10 +180,24 @@ namespace mongo {
             const Shard& s = *it;
             ShardStatus status = s.getStatus();
 
+            // opcounters are cumulative; diff against the previous round's
+            // sample to get this shard's recent op rate.  first sight of a
+            // shard has no rate yet (-1 = unknown to the policy).
+            long long now = Listener::getElapsedTimeMillis();
+            long long opsPerSec = -1;
+            map< string, pair<long long,long long> >::iterator prev = _prevOpCounts.find( s.getName() );
+            if ( prev != _prevOpCounts.end() && now > prev->second.second ) {
+                long long opsDelta = status.opCount() - prev->second.first;
+                if ( opsDelta >= 0 )
+                    opsPerSec = opsDelta * 1000 / ( now - prev->second.second );
+            }
+            _prevOpCounts[ s.getName() ] = make_pair( status.opCount() , now );
+
             BSONObj limitsObj = BSON( ShardFields::maxSize( s.getMaxSize() ) <<
                                       LimitsFields::currSize( status.mapped() ) <<
                                       ShardFields::draining( s.isDraining() )  <<
-                                      LimitsFields::hasOpsQueued( status.hasOpsQueued() )
+                                      LimitsFields::hasOpsQueued( status.hasOpsQueued() ) <<
+                                      LimitsFields::opsPerSec( opsPerSec )
                                     );
 
             shardLimitsMap[ s.getName() ] = limitsObj;
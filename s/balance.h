@@ -58,6 +58,10 @@ namespace mongo {
         // number of moved chunks in last round
         int _balancedLastTime;
 
+        // last opcounter totals sampled per shard, with the sample time (millis);
+        // successive rounds diff these to derive each shard's op rate
+        map< string, pair<long long,long long> > _prevOpCounts;
+
         // decide which chunks to move; owned here.
         scoped_ptr<BalancerPolicy> _policy;
         
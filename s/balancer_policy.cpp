@@ -31,6 +31,7 @@ namespace mongo {
     // limits map fields
     BSONField<long long> LimitsFields::currSize( "currSize" );
     BSONField<bool> LimitsFields::hasOpsQueued( "hasOpsQueued" );
+    BSONField<long long> LimitsFields::opsPerSec( "opsPerSec" );
 
     BalancerPolicy::ChunkInfo* BalancerPolicy::balance( const string& ns,
             const ShardToLimitsMap& shardToLimitsMap,
@@ -38,6 +39,8 @@ namespace mongo {
             int balancedLastTime ) {
         pair<string,unsigned> min("",numeric_limits<unsigned>::max());
         pair<string,unsigned> max("",0);
+        long long minOps = -1; // op rate of the current receiver candidate, -1 = unknown
+        long long maxOps = -1; // op rate of the current donor candidate
         vector<string> drainingShards;
 
         bool maxOpsQueued = false;
@@ -52,17 +55,21 @@ namespace mongo {
             const bool maxedOut = isSizeMaxed( shardLimits );
             const bool draining = isDraining( shardLimits );
             const bool opsQueued = hasOpsQueued( shardLimits );
+            const long long ops = opRate( shardLimits );
+
 
-            
             // Is this shard a better chunk receiver then the current one?
             // Shards that would be bad receiver candidates:
             // + maxed out shards
             // + draining shards
             // + shards with operations queued for writeback
+            // Chunk count decides; among equals the quieter shard receives.
             const unsigned size = i->second.size();
             if ( ! maxedOut && ! draining && ! opsQueued ) {
-                if ( size < min.second ) {
+                if ( size < min.second ||
+                     ( size == min.second && ops >= 0 && ( minOps < 0 || ops < minOps ) ) ) {
                     min = make_pair( shard , size );
+                    minOps = ops;
                 }
             }
             else if ( opsQueued ) {
@@ -75,8 +82,11 @@ namespace mongo {
 
             // Check whether this shard is a better chunk donor then the current one.
             // Draining shards take a lower priority than overloaded shards.
-            if ( size > max.second ) {
+            // Among equal chunk counts the busier shard donates.
+            if ( size > max.second ||
+                 ( size == max.second && ops > maxOps ) ) {
                 max = make_pair( shard , size );
+                maxOps = ops;
                 maxOpsQueued = opsQueued;
             }
             if ( draining && (size > 0)) {
@@ -119,6 +129,19 @@ namespace mongo {
             from = drainingShards[ rand() % drainingShards.size() ];
             to = min.first;
 
+        }
+        else if ( max.second > 0 && maxOps >= 0 && minOps >= 0 &&
+                  maxOps > 4 * ( minOps + 1 ) && maxOps - minOps > 100 ) {
+            // Chunk counts are even but the traffic is not: bleed a chunk from
+            // the hot shard toward the quiet one.  Deliberately conservative -
+            // one chunk per round, and only when the measured rate gap is both
+            // large relative (>4x) and absolute (>100 ops/s), so sampling
+            // noise can't make the balancer thrash.
+            log() << "load imbalance: " << max.first << " at " << maxOps << " ops/s vs "
+                  << min.first << " at " << minOps << " ops/s" << endl;
+            from = max.first;
+            to = min.first;
+
         }
         else {
             // Everything is balanced here!
@@ -178,6 +201,14 @@ namespace mongo {
         return true;
     }
 
+    long long BalancerPolicy::opRate( BSONObj limits ) {
+        BSONElement ops = limits[ LimitsFields::opsPerSec.name() ];
+        if ( ops.eoo() || ! ops.isNumber() ) {
+            return -1;
+        }
+        return ops.numberLong();
+    }
+
     bool BalancerPolicy::hasOpsQueued( BSONObj limits ) {
         BSONElement opsQueued = limits[ LimitsFields::hasOpsQueued.name() ];
         if ( opsQueued.eoo() || ! opsQueued.trueValue() ) {
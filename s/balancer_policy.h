@@ -67,6 +67,11 @@ namespace mongo {
          */
         static bool hasOpsQueued( BSONObj shardLimits );
 
+        /**
+         * Returns the shard's recent op rate (ops/sec) from 'shardLimits', or -1 if unknown.
+         */
+        static long long opRate( BSONObj shardLimits );
+
     private:
         // Convenience types
         typedef ShardToChunksMap::const_iterator ShardToChunksIter;
@@ -89,8 +94,9 @@ namespace mongo {
      */
     struct LimitsFields {
         // we use 'draining' and 'maxSize' from the 'shards' collection plus the following
-        static BSONField<long long> currSize; // currently used disk space in bytes
-        static BSONField<bool> hasOpsQueued;  // writeback queue is not empty?
+        static BSONField<long long> currSize;  // currently used disk space in bytes
+        static BSONField<bool> hasOpsQueued;   // writeback queue is not empty?
+        static BSONField<long long> opsPerSec; // recent op rate from opcounters; absent/-1 = unknown
     };
 
 }  // namespace mongo
@@ -23,6 +23,7 @@
 #include "../db/queryutil.h"
 #include "../util/unittest.h"
 #include "../util/timer.h"
+#include "../util/concurrency/task.h"
 
 #include "chunk.h"
 #include "config.h"
@@ -166,7 +167,7 @@ namespace mongo {
         conn.done();
     }
 
-    void Chunk::pickSplitVector( vector<BSONObj>& splitPoints , int chunkSize /* bytes */, int maxPoints, int maxObjs ) const {
+    void Chunk::pickSplitVector( vector<BSONObj>& splitPoints , int chunkSize /* bytes */, int maxPoints, int maxObjs, bool throttle ) const {
         // Ask the mongod holding this chunk to figure out the split points.
         ScopedDbConnection conn( getShard().getConnString() );
         BSONObj result;
@@ -178,6 +179,8 @@ namespace mongo {
         cmd.append( "maxChunkSizeBytes" , chunkSize );
         cmd.append( "maxSplitPoints" , maxPoints );
         cmd.append( "maxChunkObjects" , maxObjs );
+        if ( throttle )
+            cmd.appendBool( "throttle" , true ); // yield + sleep periodically so the scan doesn't hog the shard
         BSONObj cmdObj = cmd.obj();
 
         if ( ! conn->runCommand( "admin" , cmdObj , result )) {
@@ -203,7 +206,7 @@ namespace mongo {
         if ( ! force ) {
             vector<BSONObj> candidates;
             const int maxPoints = 2;
-            pickSplitVector( candidates , getManager()->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk );
+            pickSplitVector( candidates , getManager()->getCurrentDesiredChunkSize() , maxPoints , MaxObjectPerChunk , true /* throttle - we run in the background, no one is waiting */ );
             if ( candidates.size() <= 1 ) {
                 // no split points means there isn't enough data to split on
                 // 1 split point means we have between half the chunk size to full chunk size
@@ -330,29 +333,111 @@ namespace mongo {
         return worked;
     }
 
-    bool Chunk::splitIfShould( long dataWritten ) const {
-        LastError::Disabled d( lastError.get() );
+    /**
+     * chunks that crossed their write threshold, waiting for the autosplit
+     * task to measure and (maybe) split them.  splitIfShould only appends
+     * here, so client writes never wait on a split's shard round trips.
+     */
+    class AutoSplitQueue {
+    public:
+        struct Candidate {
+            string ns;
+            BSONObj min;
+        };
+
+        AutoSplitQueue() : _mutex( "AutoSplitQueue" ) {}
+
+        void add( const string& ns , const BSONObj& min ) {
+            scoped_lock lk( _mutex );
+            for ( unsigned i = 0; i < _queue.size(); i++ ) {
+                if ( _queue[i].ns == ns && _queue[i].min.woCompare( min ) == 0 )
+                    return; // already noted
+            }
+            if ( _queue.size() >= MaxQueued )
+                return; // ok to drop - a hot chunk will trip its threshold again
+            Candidate c;
+            c.ns = ns;
+            c.min = min.getOwned();
+            _queue.push_back( c );
+        }
 
-        try {
-            _dataWritten += dataWritten;
-            int splitThreshold = getManager()->getCurrentDesiredChunkSize();
-            if ( minIsInf() || maxIsInf() ) {
-                splitThreshold = (int) ((double)splitThreshold * .9);
+        void drainTo( vector<Candidate>& out ) {
+            scoped_lock lk( _mutex );
+            _queue.swap( out );
+        }
+
+    private:
+        enum { MaxQueued = 256 };
+        mongo::mutex _mutex;
+        vector<Candidate> _queue;
+    } autoSplitQueue;
+
+    class AutoSplitTask : public task::Task {
+    public:
+        virtual string name() const { return "autoSplit"; }
+
+        virtual void doWork() {
+            vector<AutoSplitQueue::Candidate> todo;
+            autoSplitQueue.drainTo( todo );
+            for ( unsigned i = 0; i < todo.size(); i++ ) {
+                try {
+                    _handle( todo[i] );
+                }
+                catch ( std::exception& e ) {
+                    warning() << "could have autosplit on collection: " << todo[i].ns << " but: " << e.what() << endl;
+                }
             }
+        }
 
-            if ( _dataWritten < splitThreshold / 5 )
-                return false;
+    private:
+        void _handle( const AutoSplitQueue::Candidate& c ) {
+            DBConfigPtr conf = grid.getDBConfig( c.ns , false );
+            if ( ! conf || ! conf->isSharded( c.ns ) )
+                return; // dropped or unsharded since it was noted
+            ChunkManagerPtr cm = conf->getChunkManagerIfExists( c.ns );
+            if ( ! cm )
+                return;
+            ChunkPtr chunk = cm->findChunk( c.min );
+            if ( chunk->getMin().woCompare( c.min ) != 0 ) {
+                // already split or migrated since it was noted
+                return;
+            }
+            chunk->autoSplit();
+        }
+    } autoSplitTask;
 
-            // this is a bit ugly
-            // we need it so that mongos blocks for the writes to actually be committed
-            // this does mean mongos has more back pressure than mongod alone
-            // since it nots 100% tcp queue bound
-            // this was implicit before since we did a splitVector on the same socket
-            ShardConnection::sync();
+    void startAutoSplitTask() {
+        task::repeat( &autoSplitTask , 250 );
+    }
+
+    bool Chunk::splitIfShould( long dataWritten ) const {
+        _dataWritten += dataWritten;
+        int splitThreshold = getManager()->getCurrentDesiredChunkSize();
+        if ( minIsInf() || maxIsInf() ) {
+            splitThreshold = (int) ((double)splitThreshold * .9);
+        }
+
+        if ( _dataWritten < splitThreshold / 5 )
+            return false;
+
+        LOG(1) << "noting chunk for autosplit: " << *this << " dataWritten: " << _dataWritten << " splitThreshold: " << splitThreshold << endl;
+
+        _dataWritten = 0; // reset so we check often enough
+
+        autoSplitQueue.add( _manager->getns() , _min );
+        return true;
+    }
 
-            LOG(1) << "about to initiate autosplit: " << *this << " dataWritten: " << _dataWritten << " splitThreshold: " << splitThreshold << endl;
+    bool Chunk::autoSplit() const {
+        LastError::Disabled d( lastError.get() );
+
+        try {
+            // make sure the writes that tripped the threshold are committed on
+            // the shard before we measure.  this used to be implicit, back when
+            // the splitVector went out on the same socket as the writes.
+            ShardConnection::sync();
 
-            _dataWritten = 0; // reset so we check often enough
+            LOG(1) << "about to initiate autosplit: " << *this << endl;
 
             BSONObj res;
             BSONObj splitPoint = singleSplit( false /* does not force a split if not enough data */ , res );
@@ -363,7 +448,7 @@ namespace mongo {
             }
 
             log() << "autosplitted " << _manager->getns() << " shard: " << toString()
-                  << " on: " << splitPoint << "(splitThreshold " << splitThreshold << ")"
+                  << " on: " << splitPoint
 #ifdef _DEBUG
                   << " size: " << getPhysicalSize() // slow - but can be useful when debugging
 #endif
@@ -490,14 +575,25 @@ namespace mongo {
 
     AtomicUInt ChunkManager::NextSequenceNumber = 1;
 
-    ChunkManager::ChunkManager( string ns , ShardKeyPattern pattern , bool unique ) :
+    static string singleKeyFieldFor( const BSONObj& pattern ) {
+        if ( pattern.nFields() != 1 )
+            return "";
+        const char * f = pattern.firstElement().fieldName();
+        if ( strchr( f , '.' ) )
+            return ""; // dotted keys go through the generic extraction path
+        return f;
+    }
+
+    ChunkManager::ChunkManager( string ns , ShardKeyPattern pattern , bool unique , ChunkManagerPtr oldManager ) :
         _ns( ns ) , _key( pattern ) , _unique( unique ) , _chunkRanges(), _mutex("ChunkManager"),
         _nsLock( ConnectionString( configServer.modelServer() , ConnectionString::SYNC ) , ns ),
 
         // The shard versioning mechanism hinges on keeping track of the number of times we reloaded ChunkManager's.
         // Increasing this number here will prompt checkShardVersion() to refresh the connection-level versions to
         // the most up to date value.
-        _sequenceNumber(++NextSequenceNumber)
+        _sequenceNumber(++NextSequenceNumber),
+
+        _singleKeyField( singleKeyFieldFor( pattern.key() ) )
 
     {
         int tries = 3;
@@ -506,12 +602,13 @@ namespace mongo {
             set<Shard> shards;
             ShardVersionMap shardVersions;
             Timer t;
-            _load(chunkMap, shards, shardVersions);
+            _load(chunkMap, shards, shardVersions, oldManager);
             {
                 int ms = t.millis();
-                log() << "ChunkManager: time to load chunks for " << ns << ": " << ms << "ms" 
-                      << " sequenceNumber: " << _sequenceNumber 
-                      << " version: " << _version.toString() 
+                log() << "ChunkManager: time to load chunks for " << ns << ": " << ms << "ms"
+                      << " sequenceNumber: " << _sequenceNumber
+                      << " version: " << _version.toString()
+                      << ( oldManager ? " (differential)" : "" )
                       << endl;
             }
 
@@ -532,6 +629,13 @@ namespace mongo {
             
             warning() << "ChunkManager loaded an invalid config, trying again" << endl;
 
+            if ( oldManager ) {
+                // a differential load can come up invalid if the diff straddled a
+                // migration commit; retry with a full load from scratch
+                oldManager.reset();
+                _version = ShardChunkVersion();
+            }
+
             sleepmillis(10 * (3-tries));
         }
 
@@ -543,11 +647,40 @@ namespace mongo {
         return grid.getDBConfig(getns())->getChunkManager(getns(), force);
     }
 
-    void ChunkManager::_load(ChunkMap& chunkMap, set<Shard>& shards, ShardVersionMap& shardVersions) {
+    void ChunkManager::_load(ChunkMap& chunkMap, set<Shard>& shards, ShardVersionMap& shardVersions, ChunkManagerPtr oldManager) {
+        bool differential = oldManager && oldManager->getVersion().isSet();
+
+        Query query;
+        if ( differential ) {
+            // seed from the old manager's chunks, re-parented to us (we cannot
+            // share Chunk objects -- each holds a pointer to its manager), and
+            // only fetch documents modified past the old version.  a migration
+            // or split touches a couple of chunks; a full load refetches all of
+            // them from the config servers.
+            const ChunkMap& oldChunks = oldManager->_chunkMap;
+            for ( ChunkMap::const_iterator i = oldChunks.begin(); i != oldChunks.end(); ++i ) {
+                ChunkPtr c( new Chunk( this, i->second->getMin(), i->second->getMax(), i->second->getShard() ) );
+                c->setLastmod( i->second->getLastmod() );
+                chunkMap[c->getMax()] = c;
+            }
+
+            BSONObjBuilder b;
+            b.append( "ns" , _ns );
+            {
+                BSONObjBuilder lastmod( b.subobjStart( "lastmod" ) );
+                lastmod.appendTimestamp( "$gt" , oldManager->getVersion().toLong() );
+                lastmod.done();
+            }
+            query = Query( b.obj() ).sort( "lastmod" , -1 );
+        }
+        else {
+            // TODO really need the sort?
+            query = QUERY( "ns" << _ns ).sort( "lastmod" , -1 );
+        }
+
         ScopedDbConnection conn( configServer.modelServer() );
 
-        // TODO really need the sort?
-        auto_ptr<DBClientCursor> cursor = conn->query( Chunk::chunkMetadataNS, QUERY("ns" << _ns).sort("lastmod",-1), 0, 0, 0, 0,
+        auto_ptr<DBClientCursor> cursor = conn->query( Chunk::chunkMetadataNS, query, 0, 0, 0, 0,
                                           (DEBUG_BUILD ? 2 : 1000000)); // batch size. Try to induce potential race conditions in debug builds
         assert( cursor.get() );
         while ( cursor->more() ) {
@@ -558,20 +691,36 @@ namespace mongo {
 
             ChunkPtr c( new Chunk( this, d ) );
 
+            if ( differential ) {
+                // patch: drop the stale chunks this one replaces.  after a split
+                // its range can cover several old chunks and vice versa, so erase
+                // everything overlapping [min,max).
+                ChunkMap::iterator i = chunkMap.upper_bound( c->getMin() );
+                while ( i != chunkMap.end() && chunkMap.key_comp()( i->second->getMin() , c->getMax() ) ) {
+                    chunkMap.erase( i++ );
+                }
+            }
+
             chunkMap[c->getMax()] = c;
+        }
+        conn.done();
+
+        // compute the shard set and version maxes over the merged map, so shards
+        // that no longer own chunks (or stale versions) don't linger from the seed
+        for ( ChunkMap::const_iterator i = chunkMap.begin(); i != chunkMap.end(); ++i ) {
+            ChunkPtr c = i->second;
+
             shards.insert(c->getShard());
-            
 
             // set global max
             if ( c->getLastmod() > _version )
                 _version = c->getLastmod();
-            
+
             // set shard max
             ShardChunkVersion& shardMax = shardVersions[c->getShard()];
             if ( c->getLastmod() > shardMax )
                 shardMax = c->getLastmod();
         }
-        conn.done();
     }
 
     bool ChunkManager::_isValid(const ChunkMap& chunkMap) {
@@ -651,8 +800,79 @@ namespace mongo {
         log() << "successfully created first chunk for " << c.toString() << endl;
     }
 
+    /* fnv-1a over the given bytes, continuing from h */
+    static unsigned hashKeyBytes( const char * p , int len , unsigned h = 2166136261u ) {
+        for( int i = 0; i < len; i++ ) {
+            h ^= (unsigned char) p[i];
+            h *= 16777619;
+        }
+        return h;
+    }
+
+    /* hash of an element's type and value bytes only - the field name is fixed by
+       the shard key pattern so it carries no information */
+    static unsigned hashKeyValue( const BSONElement& e ) {
+        char t = (char) e.type();
+        return hashKeyBytes( e.value() , e.valuesize() , hashKeyBytes( &t , 1 ) );
+    }
+
+    unsigned ChunkManager::_keyCacheHash( const BSONObj& key ) const {
+        /* single-field managers hash on value bytes so the element-only probe in
+           findChunk() lands on the same slot as the stores done here */
+        if ( !_singleKeyField.empty() )
+            return hashKeyValue( key.firstElement() );
+        return hashKeyBytes( key.objdata() , key.objsize() );
+    }
+
+    ChunkPtr ChunkManager::_cachedChunk( unsigned h , const BSONElement& keyVal ) const {
+        KeyCacheSlot& s = _lookupCache[ h & ( LookupCacheSize - 1 ) ];
+        scoped_spinlock lk( _lookupCacheLock );
+        if ( s.chunk ) {
+            BSONElement cached = s.key.firstElement();
+            if ( cached.type() == keyVal.type() &&
+                 cached.valuesize() == keyVal.valuesize() &&
+                 memcmp( cached.value() , keyVal.value() , keyVal.valuesize() ) == 0 )
+                return s.chunk;
+        }
+        return ChunkPtr();
+    }
+
+    ChunkPtr ChunkManager::_cachedChunk( unsigned h , const BSONObj& key ) const {
+        KeyCacheSlot& s = _lookupCache[ h & ( LookupCacheSize - 1 ) ];
+        scoped_spinlock lk( _lookupCacheLock );
+        if ( s.chunk && s.key.binaryEqual( key ) )
+            return s.chunk;
+        return ChunkPtr();
+    }
+
+    void ChunkManager::_cacheChunk( unsigned h , const BSONObj& key , const ChunkPtr& c ) const {
+        BSONObj owned = key.getOwned(); // copy outside the lock
+        KeyCacheSlot& s = _lookupCache[ h & ( LookupCacheSize - 1 ) ];
+        scoped_spinlock lk( _lookupCacheLock );
+        s.key = owned;
+        s.chunk = c;
+    }
+
     ChunkPtr ChunkManager::findChunk( const BSONObj & obj ) const {
+        if ( !_singleKeyField.empty() ) {
+            /* single-field shard key: probe the cache straight off the element's
+               value bytes, skipping key extraction entirely on a hit */
+            BSONElement e = obj[ _singleKeyField.c_str() ];
+            if ( !e.eoo() && e.type() != Array ) {
+                ChunkPtr c = _cachedChunk( hashKeyValue( e ) , e );
+                if ( c )
+                    return c;
+            }
+        }
+
         BSONObj key = _key.extractKey(obj);
+        unsigned h = _keyCacheHash( key );
+
+        {
+            ChunkPtr c = _cachedChunk( h , key );
+            if ( c )
+                return c;
+        }
 
         {
             BSONObj foo;
@@ -668,6 +888,7 @@ namespace mongo {
             if ( c ) {
                 if ( c->contains( key ) ){
                     dassert(c->contains(key)); // doesn't use fast-path in extractKey
+                    _cacheChunk( h , key , c );
                     return c;
                 }
 
@@ -832,6 +1053,8 @@ namespace mongo {
             conn.done();
         }
 
+        chunkVersionGossip.forget( _ns );
+
         LOG(1) << "ChunkManager::drop : " << _ns << "\t DONE" << endl;
         configServer.logChange( "dropCollection" , _ns , BSONObj() );
     }
@@ -990,6 +1213,30 @@ namespace mongo {
     } shardObjTest;
 
 
+    // -------  ChunkVersionGossip --------
+
+    ChunkVersionGossip chunkVersionGossip;
+
+    void ChunkVersionGossip::note( const string& ns , const ShardChunkVersion& version ) {
+        if ( ! version.isSet() )
+            return;
+        scoped_lock lk( _mutex );
+        ShardChunkVersion& cur = _latest[ns];
+        if ( cur < version )
+            cur = version;
+    }
+
+    bool ChunkVersionGossip::hasNewerVersion( const string& ns , const ShardChunkVersion& current ) const {
+        scoped_lock lk( _mutex );
+        map<string,ShardChunkVersion>::const_iterator i = _latest.find( ns );
+        return i != _latest.end() && current < i->second;
+    }
+
+    void ChunkVersionGossip::forget( const string& ns ) {
+        scoped_lock lk( _mutex );
+        _latest.erase( ns );
+    }
+
     // ----- to be removed ---
     extern OID serverID;
 
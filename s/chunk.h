@@ -23,6 +23,7 @@
 #include "../bson/util/atomic_int.h"
 #include "../client/dbclient.h"
 #include "../client/distlock.h"
+#include "../util/concurrency/spin_lock.h"
 
 #include "shardkey.h"
 #include "shard.h"
@@ -94,11 +95,21 @@ namespace mongo {
 
         /**
          * if the amount of data written nears the max size of a shard
-         * then we check the real size, and if its too big, we split
-         * @return if something was split
+         * we note the chunk for the background autosplit task, which
+         * checks the real size and splits it if it is in fact too big.
+         * the caller never waits on the split itself.
+         * @return true if the chunk was handed to the autosplit task
          */
         bool splitIfShould( long dataWritten ) const;
 
+        /**
+         * checks this chunk's real size and splits it if too big, possibly
+         * migrating the tail chunk afterwards.  called by the autosplit task;
+         * several shard round trips, so never call on a client write path.
+         * @return if something was split
+         */
+        bool autoSplit() const;
+
         /**
          * Splits this chunk at a non-specificed split key to be chosen by the mongod holding this chunk.
          *
@@ -131,7 +142,7 @@ namespace mongo {
          * @param maxPoints limits the number of split points that are needed, zero is max (optional)
          * @param maxObjs limits the number of objects in each chunk, zero is as max (optional)
          */
-        void pickSplitVector( vector<BSONObj>& splitPoints , int chunkSize , int maxPoints = 0, int maxObjs = 0) const;
+        void pickSplitVector( vector<BSONObj>& splitPoints , int chunkSize , int maxPoints = 0, int maxObjs = 0, bool throttle = false ) const;
 
         //
         // migration support
@@ -285,7 +296,10 @@ namespace mongo {
     public:
         typedef map<Shard,ShardChunkVersion> ShardVersionMap;
 
-        ChunkManager( string ns , ShardKeyPattern pattern , bool unique );
+        /** @param oldManager if set, load differentially: seed from its chunks and
+                   only fetch chunk documents with lastmod past its version, rather
+                   than rereading the whole chunks collection from the config servers */
+        ChunkManager( string ns , ShardKeyPattern pattern , bool unique , ChunkManagerPtr oldManager = ChunkManagerPtr() );
 
         string getns() const { return _ns; }
 
@@ -333,9 +347,15 @@ namespace mongo {
         ChunkManagerPtr reload(bool force=true) const; // doesn't modify self!
 
         // helpers for constructor
-        void _load(ChunkMap& chunks, set<Shard>& shards, ShardVersionMap& shardVersions);
+        void _load(ChunkMap& chunks, set<Shard>& shards, ShardVersionMap& shardVersions, ChunkManagerPtr oldManager);
         static bool _isValid(const ChunkMap& chunks);
 
+        // findChunk lookup cache (see comment at the member declarations below)
+        unsigned _keyCacheHash( const BSONObj& key ) const;
+        ChunkPtr _cachedChunk( unsigned h , const BSONElement& keyVal ) const;
+        ChunkPtr _cachedChunk( unsigned h , const BSONObj& key ) const;
+        void _cacheChunk( unsigned h , const BSONObj& key , const ChunkPtr& c ) const;
+
         // All members should be const for thread-safety
         const string _ns;
         const ShardKeyPattern _key;
@@ -355,6 +375,22 @@ namespace mongo {
 
         const unsigned long long _sequenceNumber;
 
+        /* small cache mapping extracted shard key bytes -> owning chunk, for point
+           operations.  the chunk map never changes for the life of a ChunkManager -
+           a version bump builds a whole new manager (see reload()) - so entries can
+           never go stale and no explicit invalidation is needed. */
+        enum { LookupCacheSize = 256 }; // slots; power of two
+        struct KeyCacheSlot {
+            BSONObj key;   // owned copy of the extracted shard key
+            ChunkPtr chunk;
+        };
+        mutable KeyCacheSlot _lookupCache[LookupCacheSize];
+        mutable SpinLock _lookupCacheLock;
+
+        // the pattern's field name when it has exactly one, non-dotted field, else "".
+        // lets findChunk probe the cache without building the intermediate key object.
+        const string _singleKeyField;
+
         friend class Chunk;
         friend class ChunkRangeManager; // only needed for CRM::assertValid()
         static AtomicUInt NextSequenceNumber;
@@ -394,6 +430,36 @@ namespace mongo {
     */
     inline string Chunk::genID() const { return genID(_manager->getns(), _min); }
 
+    /**
+     * The highest chunk version this mongos has heard of for each namespace.
+     * Writebacks carry the version a shard wanted, so they are evidence that
+     * our ChunkManager is behind even before we reload it.  Dispatch paths can
+     * check hasNewerVersion() before sending and refresh proactively instead
+     * of sending stale writes and replaying them through the writeback path.
+     */
+    class ChunkVersionGossip {
+    public:
+        ChunkVersionGossip() : _mutex( "ChunkVersionGossip" ) {}
+
+        /** record that a version at least this new exists for ns */
+        void note( const string& ns , const ShardChunkVersion& version );
+
+        /** @return true if a version newer than current has been heard for ns */
+        bool hasNewerVersion( const string& ns , const ShardChunkVersion& current ) const;
+
+        /** forget ns, e.g. when the collection is dropped */
+        void forget( const string& ns );
+
+    private:
+        mutable mongo::mutex _mutex;
+        map<string,ShardChunkVersion> _latest;
+    };
+
+    extern ChunkVersionGossip chunkVersionGossip;
+
+    /** starts the background task that performs splits noted by Chunk::splitIfShould */
+    void startAutoSplitTask();
+
     bool setShardVersion( DBClientBase & conn , const string& ns , ShardChunkVersion version , bool authoritative , BSONObj& result );
 
 } // namespace mongo
@@ -70,6 +70,11 @@ namespace mongo {
         _cur = _prev;
         _prev = temp;
         _cur->clear();
+
+        // keep up to 1MB of capacity around for the next request's reply batch;
+        // anything bigger is freed so an occasional huge result doesn't pin
+        // memory on an idle connection
+        _scratch.reset( 1024 * 1024 );
     }
 
     ClientInfo * ClientInfo::get() {
@@ -135,6 +140,15 @@ namespace mongo {
             return true;
         }
 
+        /* optional client supplied time budget (maxTimeMS) for the whole
+           scatter gather.  without one, a single slow shard holds the entire
+           reply.  the remaining budget becomes a per round trip socket
+           timeout, and shards we couldn't wait for are reported in
+           timedOutShards rather than blocking everyone else. */
+        const int budgetMillis = options["maxTimeMS"].numberInt();
+        const BSONObj shardOptions = budgetMillis ? options.removeField( "maxTimeMS" ) : options;
+        Timer budget;
+
         vector<WBInfo> writebacks;
 
         // handle single server
@@ -146,16 +160,27 @@ namespace mongo {
             BSONObj res;
             bool ok = false;
             try{
-            	ok = conn->runCommand( "admin" , options , res );
+                if ( budgetMillis )
+                    conn->setSocketTimeout( budgetMillis / 1000.0 );
+            	ok = conn->runCommand( "admin" , shardOptions , res );
+                if ( budgetMillis )
+                    conn->setSocketTimeout( 0 );
             }
             catch( std::exception &e ){
-                
+
                 warning() << "could not get last error." << causedBy( e ) << endl;
-                
+
+                if ( budgetMillis ) {
+                    // a socket timeout leaves the connection mid message; don't reuse it
+                    conn.kill();
+                    result.append( "timedOutShards" , BSON_ARRAY( theShard ) );
+                    return false;
+                }
+
                 // Catch everything that happens here, since we need to ensure we return our connection when we're
             	// finished.
             	conn.done();
-                
+
             	return false;
             }
             
@@ -170,6 +195,8 @@ namespace mongo {
                 string temp = *i;
                 if ( temp == theShard )
                     continue;
+                if ( budgetMillis && budget.millis() >= budgetMillis )
+                    break; // courtesy blocking only; not worth busting the budget
 
                 ShardConnection conn( temp , "" );
                 _addWriteBack( writebacks , conn->getLastErrorDetailed() );
@@ -208,27 +235,53 @@ namespace mongo {
         // hit each shard
         vector<string> errors;
         vector<BSONObj> errorObjects;
+        vector<string> timedOutShards;
         for ( set<string>::iterator i = shards->begin(); i != shards->end(); i++ ) {
             string theShard = *i;
             bbb.append( theShard );
+
+            int left = 0;
+            if ( budgetMillis ) {
+                left = budgetMillis - budget.millis();
+                if ( left <= 0 ) {
+                    // budget already spent; report this shard rather than wait on it
+                    timedOutShards.push_back( theShard );
+                    continue;
+                }
+            }
+
             ShardConnection conn( theShard , "", true );
             BSONObj res;
             bool ok = false;
             try {
-                ok = conn->runCommand( "admin" , options , res );
+                if ( left )
+                    conn->setSocketTimeout( left / 1000.0 );
+                ok = conn->runCommand( "admin" , shardOptions , res );
+                if ( left )
+                    conn->setSocketTimeout( 0 );
                 shardRawGLE.append( theShard , res );
             }
             catch( std::exception &e ){
 
+                if ( budgetMillis ) {
+                    /* partial results: a socket timeout leaves this connection mid
+                       message, so kill it, note the shard, and keep collecting from
+                       the others. */
+                    warning() << "getLastError on shard " << theShard << " failed within time budget" << causedBy( e ) << endl;
+                    conn.kill();
+                    timedOutShards.push_back( theShard );
+                    continue;
+                }
+
         	    // Safe to return here, since we haven't started any extra processing yet, just collecting
         	    // responses.
-                
+
         	    warning() << "could not get last error." << causedBy( e ) << endl;
                 conn.done();
-                
+
                 return false;
             }
-            
+
             _addWriteBack( writebacks, res );
             
             string temp = DBClientWithCommands::getLastErrorString( res );
@@ -251,6 +304,18 @@ namespace mongo {
         bbb.done();
         result.append( "shardRawGLE" , shardRawGLE.obj() );
 
+        if ( timedOutShards.size() ) {
+            /* we can't vouch for writes on these shards, so they surface both
+               as per shard status and as errors */
+            BSONArrayBuilder t( result.subarrayStart( "timedOutShards" ) );
+            for ( unsigned i=0; i<timedOutShards.size(); i++ ) {
+                t.append( timedOutShards[i] );
+                errors.push_back( str::stream() << "getLastError timed out for shard " << timedOutShards[i] );
+                errorObjects.push_back( BSON( "err" << errors.back() ) );
+            }
+            t.done();
+        }
+
         result.appendNumber( "n" , n );
         if ( updatedExistingStat )
             result.appendBool( "updatedExisting" , updatedExistingStat > 0 );
@@ -260,6 +325,8 @@ namespace mongo {
             string temp = *i;
             if ( shards->count( temp ) )
                 continue;
+            if ( budgetMillis && budget.millis() >= budgetMillis )
+                break; // courtesy blocking only; not worth busting the budget
 
             ShardConnection conn( temp , "" );
             _addWriteBack( writebacks, conn->getLastErrorDetailed() );
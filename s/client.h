@@ -82,11 +82,20 @@ namespace mongo {
         
         void noAutoSplit() { _autoSplitOk = false; }
 
+        /**
+         * scratch buffer scoped to the current request: reset by newRequest(),
+         * so reply batches built here reuse one allocation per connection
+         * instead of mallocing per message.  callers must finish with it
+         * before the request completes.
+         */
+        BufBuilder& scratch() { return _scratch; }
+
         static ClientInfo * get();
         AuthenticationInfo* getAuthenticationInfo() const { return (AuthenticationInfo*)&_ai; }
         bool isAdmin() { return _ai.isAuthorized( "admin" ); }
     private:
         AuthenticationInfo _ai;
+        BufBuilder _scratch;
         struct WBInfo {
             WBInfo( const WriteBackListener::ConnectionIdent& c , OID o ) : ident( c ) , id( o ) {}
             WriteBackListener::ConnectionIdent ident;
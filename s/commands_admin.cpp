@@ -45,6 +45,7 @@
 #include "stats.h"
 #include "writeback_listener.h"
 #include "client.h"
+#include "result_cache.h"
 #include "../util/ramlog.h"
 
 namespace mongo {
@@ -162,6 +163,12 @@ namespace mongo {
 
                 result.append( "shardCursorType" , shardedCursorTypes.getObj() );
 
+                if ( resultCache.enabled() ) {
+                    BSONObjBuilder bb( result.subobjStart( "resultCache" ) );
+                    resultCache.appendInfo( bb );
+                    bb.done();
+                }
+
                 {
                     BSONObjBuilder asserts( result.subobjStart( "asserts" ) );
                     asserts.append( "regular" , assertionCount.regular );
@@ -175,6 +182,7 @@ namespace mongo {
                 {
                     BSONObjBuilder bb( result.subobjStart( "network" ) );
                     networkCounter.append( bb );
+                    bb.appendNumber( "accepts" , Listener::acceptCount() );
                     bb.done();
                 }
 
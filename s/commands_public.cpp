@@ -32,6 +32,7 @@
 #include "grid.h"
 #include "mr_shard.h"
 #include "client.h"
+#include "result_cache.h"
 
 namespace mongo {
 
@@ -432,8 +433,31 @@ namespace mongo {
 
                 long long total = 0;
                 map<string,long long> shardCounts;
+                unsigned long long cacheToken = 0;
 
                 ChunkManagerPtr cm = conf->getChunkManagerIfExists( fullns );
+                if ( cm && resultCache.get( fullns , cmdObj , cm->getSequenceNumber() , result ) )
+                    return true;
+
+                // push the limit down: no shard ever has to count past
+                // skip + limit documents, and the real skip/limit is still
+                // applied to the summed total below.  skip itself cannot be
+                // pushed - every shard would drop documents.
+                BSONObjBuilder shardCmdB;
+                shardCmdB.append( "count" , collection );
+                shardCmdB.append( "query" , filter );
+                if ( cmdObj["limit"].isNumber() ) {
+                    long long limit = cmdObj["limit"].numberLong();
+                    if ( limit != 0 ) {
+                        // a negative limit means the same as its absolute value
+                        long long shardLimit = limit >= 0 ? limit : -limit;
+                        if ( cmdObj["skip"].isNumber() && cmdObj["skip"].numberLong() > 0 )
+                            shardLimit += cmdObj["skip"].numberLong();
+                        shardCmdB.appendNumber( "limit" , shardLimit );
+                    }
+                }
+                BSONObj shardCmd = shardCmdB.obj();
+
                 while ( true ) {
                     if ( ! cm ) {
                         // probably unsharded now
@@ -443,55 +467,94 @@ namespace mongo {
                     set<Shard> shards;
                     cm->getShardsForQuery( shards , filter );
                     assert( shards.size() );
+                    cacheToken = cm->getSequenceNumber();
 
                     bool hadToBreak = false;
 
+                    // check versions up front, then count on every shard at
+                    // once - the total is gated on the slowest shard either way
+                    vector<Shard> shardList;
+                    vector< shared_ptr<ShardConnection> > conns;
                     for (set<Shard>::iterator it=shards.begin(), end=shards.end(); it != end; ++it) {
-                        ShardConnection conn(*it, fullns);
-                        if ( conn.setVersion() ) {
-                            total = 0;
-                            shardCounts.clear();
+                        shared_ptr<ShardConnection> conn( new ShardConnection( *it , fullns ) );
+                        if ( conn->setVersion() ) {
+                            conn->done();
                             cm = conf->getChunkManagerIfExists( fullns );
-                            conn.done();
                             hadToBreak = true;
                             break;
                         }
+                        shardList.push_back( *it );
+                        conns.push_back( conn );
+                    }
 
-                        BSONObj temp;
-                        bool ok = conn->runCommand( dbName , BSON( "count" << collection << "query" << filter ) , temp, options );
-                        conn.done();
+                    if ( hadToBreak ) {
+                        for ( unsigned i = 0; i < conns.size(); i++ )
+                            conns[i]->done();
+                        total = 0;
+                        shardCounts.clear();
+                        continue;
+                    }
 
-                        if ( ok ) {
-                            long long mine = temp["n"].numberLong();
+                    list< shared_ptr<Future::CommandResult> > futures;
+                    for ( unsigned i = 0; i < conns.size(); i++ )
+                        futures.push_back( Future::spawnCommand( shardList[i].getConnString() , dbName , shardCmd , options , conns[i]->get() ) );
+
+                    bool stale = false;
+                    bool cmdFailed = false;
+                    BSONObj failRes;
+                    string failShard;
+                    unsigned idx = 0;
+                    for ( list< shared_ptr<Future::CommandResult> >::iterator f=futures.begin(); f!=futures.end(); f++, idx++ ) {
+                        shared_ptr<Future::CommandResult> res = *f;
+                        if ( res->join() ) {
+                            long long mine = res->result()["n"].numberLong();
                             total += mine;
-                            shardCounts[it->getName()] = mine;
-                            continue;
+                            shardCounts[shardList[idx].getName()] = mine;
                         }
-
-                        if ( StaleConfigInContextCode == temp["code"].numberInt() ) {
+                        else if ( StaleConfigInContextCode == res->result()["code"].numberInt() ) {
                             // my version is old
-                            total = 0;
-                            shardCounts.clear();
-                            cm = conf->getChunkManagerIfExists( fullns , true );
-                            hadToBreak = true;
-                            break;
+                            stale = true;
+                        }
+                        else if ( ! cmdFailed ) {
+                            // command failed :(
+                            cmdFailed = true;
+                            failRes = res->result().getOwned();
+                            failShard = shardList[idx].getName();
                         }
+                    }
 
-                        // command failed :(
-                        errmsg = "failed on : " + it->getName();
-                        result.append( "cause" , temp );
+                    for ( unsigned i = 0; i < conns.size(); i++ )
+                        conns[i]->done();
+
+                    if ( stale ) {
+                        total = 0;
+                        shardCounts.clear();
+                        cm = conf->getChunkManagerIfExists( fullns , true );
+                        hadToBreak = true;
+                    }
+                    else if ( cmdFailed ) {
+                        errmsg = "failed on : " + failShard;
+                        result.append( "cause" , failRes );
                         return false;
                     }
+
                     if ( ! hadToBreak )
                         break;
                 }
 
                 total = applySkipLimit( total , cmdObj );
-                result.appendNumber( "n" , total );
-                BSONObjBuilder temp( result.subobjStart( "shards" ) );
-                for ( map<string,long long>::iterator i=shardCounts.begin(); i!=shardCounts.end(); ++i )
-                    temp.appendNumber( i->first , i->second );
-                temp.done();
+                BSONObjBuilder out;
+                out.appendNumber( "n" , total );
+                {
+                    BSONObjBuilder temp( out.subobjStart( "shards" ) );
+                    for ( map<string,long long>::iterator i=shardCounts.begin(); i!=shardCounts.end(); ++i )
+                        temp.appendNumber( i->first , i->second );
+                    temp.done();
+                }
+                BSONObj o = out.obj();
+                result.appendElements( o );
+                // cacheToken is from the manager the counts actually came from
+                resultCache.put( fullns , cmdObj , cacheToken , o );
                 return true;
             }
         } countCmd;
@@ -752,41 +815,81 @@ namespace mongo {
                 ChunkManagerPtr cm = conf->getChunkManager( fullns );
                 massert( 10420 ,  "how could chunk manager be null!" , cm );
 
+                if ( resultCache.get( fullns , cmdObj , cm->getSequenceNumber() , result ) )
+                    return true;
+
                 BSONObj query = getQuery(cmdObj);
                 set<Shard> shards;
                 cm->getShardsForQuery(shards, query);
 
-                set<BSONObj,BSONObjCmp> all;
-                int size = 32;
-
+                // all shards work on their piece at the same time
+                vector< shared_ptr<ShardConnection> > conns;
+                list< shared_ptr<Future::CommandResult> > futures;
                 for ( set<Shard>::iterator i=shards.begin(), end=shards.end() ; i != end; ++i ) {
-                    ShardConnection conn( *i , fullns );
-                    BSONObj res;
-                    bool ok = conn->runCommand( conf->getName() , cmdObj , res, options );
-                    conn.done();
-
-                    if ( ! ok ) {
-                        result.appendElements( res );
-                        return false;
-                    }
+                    shared_ptr<ShardConnection> conn( new ShardConnection( *i , fullns ) );
+                    futures.push_back( Future::spawnCommand( i->getConnString() , conf->getName() , cmdObj , options , conn->get() ) );
+                    conns.push_back( conn );
+                }
 
-                    BSONObjIterator it( res["values"].embeddedObject() );
-                    while ( it.more() ) {
-                        BSONElement nxt = it.next();
-                        BSONObjBuilder temp(32);
-                        temp.appendAs( nxt , "" );
-                        all.insert( temp.obj() );
+                bool failed = false;
+                BSONObj failRes;
+                vector<BSONObj> shardValues; // one sorted "values" array per shard
+                for ( list< shared_ptr<Future::CommandResult> >::iterator f=futures.begin(); f!=futures.end(); f++ ) {
+                    shared_ptr<Future::CommandResult> res = *f;
+                    if ( ! res->join() ) {
+                        failRes = res->result().getOwned();
+                        failed = true;
+                        continue; // still have to join the rest
                     }
+                    shardValues.push_back( res->result()["values"].embeddedObject().getOwned() );
+                }
+                for ( unsigned i = 0; i < conns.size(); i++ )
+                    conns[i]->done();
 
+                if ( failed ) {
+                    result.appendElements( failRes );
+                    return false;
                 }
 
+                // each shard returns its values sorted (see DistinctCommand),
+                // so the union is a streaming k-way merge straight into the
+                // reply - no set holding every distinct value is built here
+                vector<BSONObjIterator> its;
+                for ( unsigned i = 0; i < shardValues.size(); i++ )
+                    its.push_back( BSONObjIterator( shardValues[i] ) );
+                vector<BSONElement> heads( its.size() );
+                for ( unsigned i = 0; i < its.size(); i++ )
+                    heads[i] = its[i].more() ? its[i].next() : BSONElement();
+
+                int size = 32;
                 BSONObjBuilder b( size );
                 int n=0;
-                for ( set<BSONObj,BSONObjCmp>::iterator i = all.begin() ; i != all.end(); i++ ) {
-                    b.appendAs( i->firstElement() , b.numStr( n++ ) );
+                while ( 1 ) {
+                    int best = -1;
+                    for ( unsigned i = 0; i < heads.size(); i++ ) {
+                        if ( heads[i].eoo() )
+                            continue;
+                        if ( best < 0 || heads[i].woCompare( heads[best] , false ) < 0 )
+                            best = i;
+                    }
+                    if ( best < 0 )
+                        break;
+
+                    BSONElement v = heads[best];
+                    b.appendAs( v , b.numStr( n++ ) );
+
+                    // pop this value off every list that starts with it
+                    for ( unsigned i = 0; i < heads.size(); i++ ) {
+                        while ( ! heads[i].eoo() && heads[i].woCompare( v , false ) == 0 )
+                            heads[i] = its[i].more() ? its[i].next() : BSONElement();
+                    }
                 }
 
-                result.appendArray( "values" , b.obj() );
+                BSONObjBuilder out;
+                out.appendArray( "values" , b.obj() );
+                BSONObj o = out.obj();
+                result.appendElements( o );
+                resultCache.put( fullns , cmdObj , cm->getSequenceNumber() , o );
                 return true;
             }
         } disinctCmd;
@@ -922,6 +1025,129 @@ namespace mongo {
             }
         } geo2dFindNearCmd;
 
+        /**
+         * one partition of the final reduce for map/reduce with sharded
+         * output.  each worker merges a contiguous _id range of the (sorted)
+         * shard output collections and owns its own js scope, so several
+         * partitions can reduce concurrently.  output goes through the normal
+         * sharded write path, which is usable from any thread.
+         */
+        class MRShardedFinalReduce {
+        public:
+            MRShardedFinalReduce( const string& dbName , const BSONObj& cmdObj ,
+                                  const set<ServerAndQuery>& servers , const string& inputNS ,
+                                  DBConfigPtr conf , const string& outns , const string& tempns ,
+                                  const BSONObj& min , const BSONObj& max )
+                : _dbName( dbName ) , _cmdObj( cmdObj ) , _servers( servers ) , _inputNS( inputNS ) ,
+                  _conf( conf ) , _outns( outns ) , _tempns( tempns ) ,
+                  _min( min.getOwned() ) , _max( max.getOwned() ) ,
+                  _finalCount( 0 ) , _numReduces( 0 ) , _failed( false ) {
+            }
+
+            /** thread entry point - never throws, errors are kept for the caller */
+            void run() {
+                try {
+                    _run();
+                }
+                catch ( std::exception& e ) {
+                    _failed = true;
+                    _error = e.what();
+                }
+                catch ( ... ) {
+                    _failed = true;
+                    _error = "unknown error in sharded m/r final reduce";
+                }
+            }
+
+            bool failed() const { return _failed; }
+            const string& error() const { return _error; }
+            long long finalCount() const { return _finalCount; }
+            long long numReduces() const { return _numReduces; }
+
+        private:
+            void _run() {
+                // each worker compiles its own reducer/finalizer - js scopes
+                // cannot be shared between threads
+                mr_shard::Config config( _dbName , _cmdObj );
+                mr_shard::State state( config );
+                state.init();
+
+                BSONObj sortKey = BSON( "_id" << 1 );
+
+                Query q;
+                if ( ! _min.isEmpty() || ! _max.isEmpty() ) {
+                    BSONObjBuilder b;
+                    BSONObjBuilder r( b.subobjStart( "_id" ) );
+                    if ( ! _min.isEmpty() )
+                        r.appendAs( _min.firstElement() , "$gte" );
+                    if ( ! _max.isEmpty() )
+                        r.appendAs( _max.firstElement() , "$lt" );
+                    r.done();
+                    q = Query( b.obj() );
+                }
+                q.sort( sortKey );
+
+                ParallelSortClusteredCursor cursor( _servers , _inputNS , q );
+                cursor.init();
+
+                mr_shard::BSONList values;
+                Strategy* s = SHARDED;
+                int currentSize = 0;
+                while ( cursor.more() || !values.empty() ) {
+                    BSONObj t;
+                    if ( cursor.more() ) {
+                        t = cursor.next().getOwned();
+
+                        if ( values.size() == 0 || t.woSortOrder( *(values.begin()) , sortKey ) == 0 ) {
+                            values.push_back( t );
+                            currentSize += t.objsize();
+
+                            // check size and potentially reduce
+                            if (currentSize > config.maxInMemSize && values.size() > config.reduceTriggerRatio) {
+                                BSONObj reduced = config.reducer->finalReduce(values, 0);
+                                values.clear();
+                                values.push_back( reduced );
+                                currentSize = reduced.objsize();
+                            }
+                            continue;
+                        }
+                    }
+
+                    BSONObj final = config.reducer->finalReduce(values, config.finalizer.get());
+                    if (config.outType == mr_shard::Config::MERGE) {
+                        BSONObj id = final["_id"].wrap();
+                        s->updateSharded(_conf, _outns.c_str(), id, final, UpdateOption_Upsert, true);
+                    } else {
+                        // insert into temp collection, but using final collection's shard chunks
+                        s->insertSharded(_conf, _tempns.c_str(), final, 0, true, _outns.c_str());
+                    }
+                    ++_finalCount;
+                    values.clear();
+                    if (!t.isEmpty()) {
+                        values.push_back( t );
+                        currentSize = t.objsize();
+                    }
+                }
+
+                _numReduces = state.numReduces();
+            }
+
+            string _dbName;
+            BSONObj _cmdObj;
+            set<ServerAndQuery> _servers;
+            string _inputNS;
+            DBConfigPtr _conf;
+            string _outns;
+            string _tempns;
+            BSONObj _min; // first _id of this partition, empty for the first one
+            BSONObj _max; // first _id of the next partition, empty for the last one
+
+            long long _finalCount;
+            long long _numReduces;
+            bool _failed;
+            string _error;
+        };
+
         class MRCmd : public PublicGridCommand {
         public:
             AtomicUInt JOB_NUMBER;
@@ -1118,7 +1344,6 @@ namespace mongo {
 //                    string shardedIncLong = str::stream() << outdb << ".tmp.mr." << collection << "_" << "shardedTemp" << "_" << time(0) << "_" << JOB_NUMBER++;
 
                     mr_shard::Config config( dbName , cmdObj );
-                    mr_shard::State state(config);
                     LOG(1) << "mr sharded output ns: " << config.ns << endl;
 
                     if (config.outType == mr_shard::Config::INMEMORY) {
@@ -1171,49 +1396,90 @@ namespace mongo {
                         }
                     }
 
-                    ParallelSortClusteredCursor cursor( servers , dbName + "." + shardedOutputCollection ,
-                                                        Query().sort( sortKey ) );
-                    cursor.init();
-                    state.init();
+                    // partition the _id space so the final reduce can run on
+                    // several threads.  split points come from the shard with
+                    // the most output; its key distribution is a reasonable
+                    // stand-in for the merged stream.  no split points (small
+                    // output, or splitVector unavailable) means one partition,
+                    // i.e. the old single threaded behavior.
+                    vector<BSONObj> splitPoints;
+                    int nReducers = min( 4 , (int)boost::thread::hardware_concurrency() );
+                    if ( nReducers > 1 ) {
+                        string biggest;
+                        long long biggestCount = -1;
+                        BSONObjIterator sc( shardCounts );
+                        while ( sc.more() ) {
+                            BSONElement e = sc.next();
+                            long long out = e.embeddedObjectUserCheck()["output"].numberLong();
+                            if ( out > biggestCount ) {
+                                biggestCount = out;
+                                biggest = e.fieldName();
+                            }
+                        }
 
-                    mr_shard::BSONList values;
-                    Strategy* s = SHARDED;
-                    long long finalCount = 0;
-                    int currentSize = 0;
-                    while ( cursor.more() || !values.empty() ) {
-                        BSONObj t;
-                        if ( cursor.more() ) {
-                            t = cursor.next().getOwned();
-
-                            if ( values.size() == 0 || t.woSortOrder( *(values.begin()) , sortKey ) == 0 ) {
-                                values.push_back( t );
-                                currentSize += t.objsize();
-
-                                // check size and potentially reduce
-                                if (currentSize > config.maxInMemSize && values.size() > config.reduceTriggerRatio) {
-                                    BSONObj reduced = config.reducer->finalReduce(values, 0);
-                                    values.clear();
-                                    values.push_back( reduced );
-                                    currentSize = reduced.objsize();
+                        if ( biggestCount > 0 ) {
+                            try {
+                                ScopedDbConnection conn( biggest );
+                                BSONObj stats;
+                                long long bytes = 0;
+                                if ( conn->runCommand( dbName , BSON( "collstats" << shardedOutputCollection ) , stats ) )
+                                    bytes = stats["size"].numberLong();
+                                if ( bytes > 0 ) {
+                                    BSONObjBuilder cmd;
+                                    cmd.append( "splitVector" , dbName + "." + shardedOutputCollection );
+                                    cmd.append( "keyPattern" , sortKey );
+                                    cmd.append( "maxChunkSizeBytes" , (int)min( bytes / nReducers + 1 , (long long)( 500 * 1024 * 1024 ) ) );
+                                    cmd.append( "maxSplitPoints" , nReducers - 1 );
+                                    BSONObj res;
+                                    if ( conn->runCommand( "admin" , cmd.obj() , res ) ) {
+                                        BSONObjIterator it( res.getObjectField( "splitKeys" ) );
+                                        while ( it.more() )
+                                            splitPoints.push_back( it.next().Obj().getOwned() );
+                                    }
+                                    else {
+                                        warning() << "splitVector for m/r final reduce failed: " << res << ", reducing on one thread" << endl;
+                                    }
                                 }
-                                continue;
+                                conn.done();
+                            }
+                            catch ( std::exception& e ) {
+                                warning() << "couldn't partition m/r final reduce" << causedBy( e ) << ", reducing on one thread" << endl;
+                                splitPoints.clear();
                             }
                         }
+                    }
 
-                        BSONObj final = config.reducer->finalReduce(values, config.finalizer.get());
-                        if (config.outType == mr_shard::Config::MERGE) {
-                            BSONObj id = final["_id"].wrap();
-                            s->updateSharded(conf, outns.c_str(), id, final, UpdateOption_Upsert, true);
-                        } else {
-                            // insert into temp collection, but using final collection's shard chunks
-                            s->insertSharded(conf, tempns.c_str(), final, 0, true, outns.c_str());
-                        }
-                        ++finalCount;
-                        values.clear();
-                        if (!t.isEmpty()) {
-                            values.push_back( t );
-                            currentSize = t.objsize();
+                    vector< shared_ptr<MRShardedFinalReduce> > workers;
+                    for ( unsigned i = 0; i <= splitPoints.size(); i++ ) {
+                        BSONObj min = i == 0 ? BSONObj() : splitPoints[i-1];
+                        BSONObj max = i == splitPoints.size() ? BSONObj() : splitPoints[i];
+                        workers.push_back( shared_ptr<MRShardedFinalReduce>(
+                            new MRShardedFinalReduce( dbName , cmdObj , servers , dbName + "." + shardedOutputCollection ,
+                                                      conf , outns , tempns , min , max ) ) );
+                    }
+
+                    if ( workers.size() == 1 ) {
+                        workers[0]->run();
+                    }
+                    else {
+                        LOG(1) << "m/r final reduce on " << workers.size() << " partitions" << endl;
+                        vector< shared_ptr<boost::thread> > reduceThreads;
+                        for ( unsigned i = 0; i < workers.size(); i++ )
+                            reduceThreads.push_back( shared_ptr<boost::thread>(
+                                new boost::thread( boost::bind( &MRShardedFinalReduce::run , workers[i].get() ) ) ) );
+                        for ( unsigned i = 0; i < reduceThreads.size(); i++ )
+                            reduceThreads[i]->join();
+                    }
+
+                    long long finalCount = 0;
+                    long long reduceCount = 0;
+                    for ( unsigned i = 0; i < workers.size(); i++ ) {
+                        if ( workers[i]->failed() ) {
+                            errmsg = str::stream() << "final reduce failed: " << workers[i]->error();
+                            return false;
                         }
+                        finalCount += workers[i]->finalCount();
+                        reduceCount += workers[i]->numReduces();
                     }
 
                     if (config.outType == mr_shard::Config::REDUCE || config.outType == mr_shard::Config::REPLACE) {
@@ -1263,7 +1529,7 @@ namespace mongo {
                     while (j.more()) {
                         BSONElement elmt = j.next();
                         if (!strcmp(elmt.fieldName(), "reduce"))
-                            countsB.append("reduce", elmt.numberLong() + state.numReduces());
+                            countsB.append("reduce", elmt.numberLong() + reduceCount);
                         else if (!strcmp(elmt.fieldName(), "output"))
                             countsB.append("output", finalCount);
                         else
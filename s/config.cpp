@@ -199,6 +199,7 @@ namespace mongo {
         BSONObj key;
         bool unique;
         ShardChunkVersion oldVersion;
+        ChunkManagerPtr oldManager;
 
         {
             scoped_lock lk( _lock );
@@ -219,8 +220,10 @@ namespace mongo {
 
             key = ci.key().copy();
             unique = ci.unique();
-            if ( ci.getCM() )
+            if ( ci.getCM() ) {
+                oldManager = ci.getCM();
                 oldVersion = ci.getCM()->getVersion();
+            }
         }
         
         assert( ! key.isEmpty() );
@@ -240,12 +243,18 @@ namespace mongo {
                     return ci.getCM();
                 }
             }
-            
+            else {
+                // no chunk docs at all -- maybe dropped.  don't seed the new
+                // manager below or we would never notice the empty collection.
+                oldManager.reset();
+            }
+
         }
 
         // we are not locked now, and want to load a new ChunkManager
-        
-        auto_ptr<ChunkManager> temp( new ChunkManager( ns , key , unique ) );
+        // seeding from the old one (if any) so only changed chunks are fetched
+
+        auto_ptr<ChunkManager> temp( new ChunkManager( ns , key , unique , oldManager ) );
         if ( temp->numChunks() == 0 ) {
             // maybe we're not sharded any more
             reload(); // this is a full reload
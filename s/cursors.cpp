@@ -23,6 +23,7 @@
 #include "../db/commands.h"
 #include "../util/concurrency/task.h"
 #include "../util/net/listen.h"
+#include "client.h"
 
 namespace mongo {
 
@@ -35,6 +36,9 @@ namespace mongo {
         _skip = q.ntoskip;
         _ntoreturn = q.ntoreturn;
 
+        _stagedPos = 0;
+        _stagedBytes = 0;
+
         _totalSent = 0;
         _done = false;
 
@@ -79,13 +83,28 @@ namespace mongo {
         if ( _totalSent > 0 )
             maxSize *= 3;
 
-        BufBuilder b(32768);
+        // build into the connection's request-scoped scratch buffer rather
+        // than allocating per batch.  replyToQuery() below sends synchronously,
+        // so the buffer is free for reuse once this request is done.
+        BufBuilder& b = ClientInfo::get()->scratch();
+        b.reset();
 
         int num = 0;
         bool sendMore = true;
 
-        while ( _cursor->more() ) {
-            BSONObj o = _cursor->next();
+        while ( 1 ) {
+            BSONObj o;
+            if ( _stagedPos < _staged.size() ) {
+                // results prefetched after the previous batch went out
+                o = _staged[_stagedPos++];
+                _stagedBytes -= o.objsize();
+            }
+            else if ( _cursor->more() ) {
+                o = _cursor->next();
+            }
+            else {
+                break;
+            }
 
             b.appendBuf( (void*)o.objdata() , o.objsize() );
             num++;
@@ -111,16 +130,53 @@ namespace mongo {
             }
         }
 
-        bool hasMore = sendMore && _cursor->more();
+        // drop the entries just served
+        if ( _stagedPos == _staged.size() ) {
+            _staged.clear();
+        }
+        else if ( _stagedPos > 0 ) {
+            _staged.erase( _staged.begin() , _staged.begin() + _stagedPos );
+        }
+        _stagedPos = 0;
+
+        bool hasMore = sendMore && ( _staged.size() > 0 || _cursor->more() );
         LOG(6) << "\t hasMore:" << hasMore << " wouldSendMoreIfHad: " << sendMore << " id:" << getId() << " totalSent: " << _totalSent << endl;
 
         replyToQuery( 0 , r.p() , r.m() , b.buf() , b.len() , num , _totalSent , hasMore ? getId() : 0 );
         _totalSent += num;
         _done = ! hasMore;
 
+        if ( hasMore ) {
+            try {
+                _prefetch( ntoreturn );
+            }
+            catch ( std::exception& e ) {
+                // the reply already went out, so don't fail this request; the
+                // next getMore will hit the problem in a normal request context
+                LOG(1) << "prefetch error on cursor " << getId() << causedBy( e ) << endl;
+            }
+        }
+
         return hasMore;
     }
 
+    void ShardedClientCursor::_prefetch( int ntoreturn ) {
+        // the reply for the previous batch is already on the wire, so the
+        // shard getMores issued here run while the client chews on that batch.
+        // stage about one more batch; getOwned() because the shard reply
+        // buffers are recycled by the next underlying fetch.
+        const long long maxBytes = 1024 * 1024;
+        const int maxDocs = ntoreturn != 0 ? abs( ntoreturn ) : 0;
+
+        while ( _stagedBytes < maxBytes &&
+                ( maxDocs == 0 || (int)( _staged.size() - _stagedPos ) < maxDocs ) &&
+                _cursor->more() ) {
+            BSONObj o = _cursor->next().getOwned();
+            _stagedBytes += o.objsize();
+            _staged.push_back( o );
+        }
+    }
+
     // ---- CursorCache -----
 
     long long CursorCache::TIMEOUT = 600000;
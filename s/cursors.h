@@ -48,8 +48,19 @@ namespace mongo {
 
     protected:
 
+        /** after a reply is on the wire, keep draining the shard cursors into
+            _staged (bounded) so the next getMore is served from memory.  time
+            spent here overlaps the client processing the batch just sent. */
+        void _prefetch( int ntoreturn );
+
         ClusteredCursor * _cursor;
 
+        // results pulled ahead of the next getMore; served before going back
+        // to the shards
+        vector<BSONObj> _staged;
+        unsigned _stagedPos;   // next entry of _staged to serve
+        long long _stagedBytes; // bytes in _staged not yet served
+
         int _skip;
         int _ntoreturn;
 
@@ -172,6 +172,18 @@ namespace mongo {
         return good;
     }
 
+    bool ShardChunkManager::rangeBelongsToMe( const BSONObj& min , const BSONObj& max ) const {
+        if ( _rangesMap.size() == 0 )
+            return false;
+
+        RangeMap::const_iterator it = _rangesMap.upper_bound( min );
+        if ( it != _rangesMap.begin() )
+            it--;
+
+        // a contiguous range holding both endpoints holds everything between them
+        return contains( it->first , it->second , min ) && contains( it->first , it->second , max );
+    }
+
     bool ShardChunkManager::getNextChunk( const BSONObj& lookupKey, BSONObj* foundMin , BSONObj* foundMax ) const {
         assert( foundMin );
         assert( foundMax );
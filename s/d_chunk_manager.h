@@ -110,7 +110,19 @@ namespace mongo {
          * @return true if shards hold the object
          */
         bool belongsToMe( ClientCursor* cc ) const;
-        
+
+        /**
+         * Checks whether an entire range of shard keys is owned by this shard.
+         *
+         * The test is conservative: both endpoints are treated as inclusive and must fall in a
+         * single contiguous run of chunks.  A false return only means a per-document check is
+         * still required, not that the range is necessarily unowned.
+         *
+         * @param min max range of *shard keys* to test (the caller extracts the key)
+         * @return true if all documents whose keys lie in [min, max] belong to this shard
+         */
+        bool rangeBelongsToMe( const BSONObj& min , const BSONObj& max ) const;
+
         /**
          * Given a chunk's min key (or empty doc), gets the boundary of the chunk following that one (the first).
          *
@@ -91,6 +91,9 @@ namespace mongo {
         bool needShardChunkManager( const string& ns ) const;
         ShardChunkManagerPtr getShardChunkManager( const string& ns );
 
+        /** appends the namespaces of all collections that have a chunk manager installed */
+        void getShardedCollections( vector<string>& ns );
+
         // chunk migrate and split support
 
         /**
@@ -239,4 +242,7 @@ namespace mongo {
     void logOpForSharding( const char * opstr , const char * ns , const BSONObj& obj , BSONObj * patt );
     void aboutToDeleteForSharding( const Database* db , const DiskLoc& dl );
 
+    /** starts (once) the thread that deletes documents left behind by failed migration cleanup */
+    void startOrphanCleanup();
+
 }
@@ -1190,9 +1190,82 @@ namespace mongo {
        commend to "commit"
     */
 
+    /* pulls _migrateClone batches from the donor on its own connection so the
+       migrate thread can apply one batch while the next is already on the wire.
+       the donor caps each reply near the max bson size, so a chunk arrives as a
+       handful of multi-megabyte batches; fetching and applying them serially
+       pays a full network round trip per batch on top of the apply time.
+     */
+    class MigrateCloneFetcher {
+    public:
+        MigrateCloneFetcher( const string& from ) : _from( from ) , _failed( false ) {}
+
+        void run() {
+            Client::initThread( "migrateCloneFetcher" );
+            try {
+                ScopedDbConnection conn( _from );
+                while ( true ) {
+                    BSONObj res;
+                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {
+                        _errmsg = "_migrateClone failed: ";
+                        _errmsg += res.toString();
+                        _failed = true;
+                        break;
+                    }
+
+                    bool last = res["objects"].Obj().isEmpty();
+                    _queue.push( res.getOwned() );
+                    if ( last ) {
+                        // ask for the first batch of mods now - by the time the
+                        // migrate thread drains the clone queue it will already
+                        // be here.  it is still only *applied* after the clone.
+                        if ( conn->runCommand( "admin" , BSON( "_transferMods" << 1 ) , res ) )
+                            _firstMods = res.getOwned();
+                        break;
+                    }
+
+                    // keep at most a couple of batches buffered - no point holding
+                    // tens of megabytes of bson the applier isn't ready for
+                    while ( _queue.size() >= 2 && ! inShutdown() )
+                        sleepmillis( 10 );
+                }
+                conn.done();
+            }
+            catch ( std::exception& e ) {
+                _errmsg = e.what();
+                _failed = true;
+            }
+            catch ( ... ) {
+                _errmsg = "unknown error fetching migrate clone batch";
+                _failed = true;
+            }
+
+            if ( _failed )
+                _queue.push( BSONObj() ); // wake the applier; an empty obj means stop
+
+            cc().shutdown();
+        }
+
+        /** blocks until a batch is available.  an empty obj means the fetcher failed. */
+        BSONObj next() { return _queue.blockingPop(); }
+
+        bool failed() const { return _failed; }
+        string errmsg() const { return _errmsg; }
+
+        /** first _transferMods reply, prefetched after the last clone batch.  may be empty. */
+        BSONObj firstMods() const { return _firstMods; }
+
+    private:
+        string _from;
+        BlockingQueue<BSONObj> _queue;
+        volatile bool _failed;
+        string _errmsg;
+        BSONObj _firstMods;
+    };
+
     class MigrateStatus {
     public:
-        
+
         MigrateStatus() : m_active("MigrateStatus") { active = false; }
 
         void prepare() {
@@ -1272,20 +1345,19 @@ namespace mongo {
             }
 
 
+            // outlives step 3 so step 4 can pick up the prefetched mods
+            MigrateCloneFetcher fetcher( from );
+
             {
                 // 3. initial bulk clone
                 state = CLONE;
 
+                boost::thread fetcherThread( boost::bind( &MigrateCloneFetcher::run , &fetcher ) );
+
                 while ( true ) {
-                    BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_migrateClone" << 1 ) , res ) ) {
-                        state = FAIL;
-                        errmsg = "_migrateClone failed: ";
-                        errmsg += res.toString();
-                        error() << errmsg << migrateLog;
-                        conn.done();
-                        return;
-                    }
+                    BSONObj res = fetcher.next();
+                    if ( res.isEmpty() )
+                        break; // fetcher failed; handled after the join
 
                     BSONObj arr = res["objects"].Obj();
                     int thisTime = 0;
@@ -1306,6 +1378,16 @@ namespace mongo {
                         break;
                 }
 
+                fetcherThread.join();
+
+                if ( fetcher.failed() ) {
+                    state = FAIL;
+                    errmsg = fetcher.errmsg();
+                    error() << errmsg << migrateLog;
+                    conn.done();
+                    return;
+                }
+
                 timing.done(3);
             }
 
@@ -1315,9 +1397,15 @@ namespace mongo {
             {
                 // 4. do bulk of mods
                 state = CATCHUP;
+                bool first = true;
                 while ( true ) {
                     BSONObj res;
-                    if ( ! conn->runCommand( "admin" , BSON( "_transferMods" << 1 ) , res ) ) {
+                    if ( first && ! fetcher.firstMods().isEmpty() ) {
+                        // the fetcher grabbed this while we were applying the
+                        // tail of the clone
+                        res = fetcher.firstMods();
+                    }
+                    else if ( ! conn->runCommand( "admin" , BSON( "_transferMods" << 1 ) , res ) ) {
                         state = FAIL;
                         errmsg = "_transferMods failed: ";
                         errmsg += res.toString();
@@ -1325,6 +1413,7 @@ namespace mongo {
                         conn.done();
                         return;
                     }
+                    first = false;
                     if ( res["size"].number() == 0 )
                         break;
 
@@ -1665,6 +1754,156 @@ namespace mongo {
 
     } recvChunkAboortCommand;
 
+    /* Migration cleanup doesn't always get to run: the donor may crash or step down
+       after the commit, or the cleanup thread may give up waiting on open cursors.
+       The documents left behind are invisible to queries - belongsToMe() filters
+       them - but they cost a key extraction and a range lookup per matching
+       document, forever.  This thread periodically deletes local documents whose
+       shard key falls in the gaps between the ranges this shard owns, so the
+       filtering eventually has nothing left to do.
+    */
+    class OrphanCleaner : public BackgroundJob {
+    public:
+        OrphanCleaner() : BackgroundJob( true /* deleteSelf */ ) {}
+
+        virtual string name() const { return "cleanupOrphans"; }
+
+        virtual void run() {
+            Client::initThread( "cleanupOrphans" );
+            if (!noauth) {
+                cc().getAuthenticationInfo()->authorize("local", internalSecurity.user);
+            }
+
+            while ( ! inShutdown() ) {
+                sleepsecs( 60 );
+                try {
+                    _doPass();
+                }
+                catch ( std::exception& e ) {
+                    log() << "orphan cleanup pass error: " << e.what() << migrateLog;
+                }
+                catch ( ... ) {
+                    log() << "orphan cleanup pass: unknown error" << migrateLog;
+                }
+            }
+
+            cc().shutdown();
+        }
+
+    private:
+
+        // how long a collection's version must sit unchanged before we touch its data.
+        // matches the grace period _cleanupOldData extends to cursors that were open
+        // when a chunk was donated.
+        static const int StableSecs = 900;
+
+        void _doPass() {
+            vector<string> shardedColls;
+            shardingState.getShardedCollections( shardedColls );
+
+            for ( vector<string>::const_iterator i = shardedColls.begin(); i != shardedColls.end(); ++i ) {
+                const string& ns = *i;
+
+                // while a chunk is on the move the migrate logic owns cleanup; in
+                // particular an incoming chunk's range is not ours *yet* and must
+                // not be treated as a gap
+                if ( migrateStatus.getActive() || migrateFromStatus.isActive() )
+                    return;
+
+                ShardChunkManagerPtr manager = shardingState.getShardChunkManager( ns );
+                if ( ! manager )
+                    continue;
+
+                // a version 0 manager means no chunks here at all; we can't tell stray
+                // documents from a collection that was dropped and recreated unsharded,
+                // so leave those alone
+                if ( manager->getNumChunks() == 0 )
+                    continue;
+
+                // cursors opened before a migration are entitled to documents in ranges
+                // donated since; only clean once ownership has been stable longer than
+                // any such cursor is catered to (cf. _cleanupOldData)
+                if ( ! _stableLongEnough( ns , manager->getVersion() ) )
+                    continue;
+
+                _cleanCollection( ns , manager );
+            }
+        }
+
+        bool _stableLongEnough( const string& ns , ShardChunkVersion version ) {
+            time_t now = time(0);
+            map<string,pair<unsigned long long,time_t> >::iterator it = _lastVersion.find( ns );
+            if ( it == _lastVersion.end() || it->second.first != version.toLong() ) {
+                _lastVersion[ns] = make_pair( version.toLong() , now );
+                return false;
+            }
+            return now - it->second.second >= StableSecs;
+        }
+
+        void _cleanCollection( const string& ns , ShardChunkManagerPtr manager ) {
+            // collect the gaps between the chunks we own; everything in them is an orphan
+            vector< pair<BSONObj,BSONObj> > gaps;
+            {
+                BSONObjBuilder minb, maxb;
+                BSONObj key = manager->getKey();
+                BSONForEach( k , key ) {
+                    minb.appendMinKey( k.fieldName() );
+                    maxb.appendMaxKey( k.fieldName() );
+                }
+
+                BSONObj prevMax = minb.obj();
+                BSONObj globalMax = maxb.obj();
+
+                BSONObj lookup;
+                while ( true ) {
+                    BSONObj min, max;
+                    bool last = manager->getNextChunk( lookup , &min , &max );
+                    if ( min.isEmpty() )
+                        break;
+                    if ( prevMax.woCompare( min ) < 0 )
+                        gaps.push_back( make_pair( prevMax , min.getOwned() ) );
+                    prevMax = max.getOwned();
+                    if ( last )
+                        break;
+                    lookup = min.getOwned();
+                }
+
+                if ( prevMax.woCompare( globalMax ) < 0 )
+                    gaps.push_back( make_pair( prevMax , globalMax ) );
+            }
+
+            long long total = 0;
+            for ( unsigned i = 0; i < gaps.size(); i++ ) {
+                if ( migrateStatus.getActive() || migrateFromStatus.isActive() )
+                    break;
+
+                // the manager being swapped means ownership changed mid-pass; the
+                // stability clock restarts, try again a pass later
+                if ( shardingState.getShardChunkManager( ns ).get() != manager.get() )
+                    break;
+
+                ShardForceVersionOkModeBlock sf;
+                writelock lk( ns );
+                RemoveSaver rs( "cleanupOrphans" , ns , "orphans" );
+                total += Helpers::removeRange( ns , gaps[i].first , gaps[i].second , true , false ,
+                                               cmdLine.moveParanoia ? &rs : 0 );
+            }
+
+            if ( total > 0 )
+                log() << "cleanupOrphans deleted " << total << " orphaned documents from " << ns << migrateLog;
+        }
+
+        // last version seen per collection and when it was first seen
+        map<string,pair<unsigned long long,time_t> > _lastVersion;
+    };
+
+    void startOrphanCleanup() {
+        static bool started = false;
+        if ( started )
+            return;
+        started = true;
+        ( new OrphanCleaner() )->go();
+    }
 
     class IsInRangeTest : public UnitTest {
     public:
@@ -250,6 +250,7 @@ namespace mongo {
                  "  \n"
                  "  { splitVector : \"blog.post\" , keyPattern:{x:1} , min:{x:10} , max:{x:20}, force: true }\n"
                  "  'force' will produce one split point even if data is small; defaults to false\n"
+                 "  'throttle' makes the index scan yield the read lock and nap periodically; defaults to false\n"
                  "NOTE: This command may take a while to run";
         }
 
@@ -293,6 +294,11 @@ namespace mongo {
                 maxChunkObjects = MaxChunkObjectsElem.numberLong();
             }
 
+            // when throttled, the index scan periodically gives up the read lock and naps,
+            // trading its own latency for less interference with concurrent operations.
+            // used by mongos' background autosplit, where no one is waiting on the answer.
+            const bool throttle = jsobj[ "throttle" ].trueValue();
+
             vector<BSONObj> splitKeys;
 
             {
@@ -377,6 +383,7 @@ namespace mongo {
                 Timer timer;
                 long long currCount = 0;
                 long long numChunks = 0;
+                long long nscanned = 0;
                 
                 BtreeCursor * bc = BtreeCursor::make( d , d->idxNo(*idx) , *idx , min , max , false , 1 );
                 shared_ptr<Cursor> c( bc );
@@ -394,6 +401,7 @@ namespace mongo {
                 while ( 1 ) {
                     while ( cc->ok() ) {
                         currCount++;
+                        nscanned++;
                         BSONObj currKey = c->currKey();
                         
                         DEV assert( currKey.woCompare( max ) <= 0 );
@@ -424,7 +432,15 @@ namespace mongo {
                             break;
                         }
                         
-                        if ( ! cc->yieldSometimes( ClientCursor::DontNeed ) ) {
+                        bool stillOk;
+                        if ( throttle && nscanned % 16384 == 0 ) {
+                            // unconditional yield plus a short nap
+                            stillOk = cc->yield( 1000 /* micros */ );
+                        }
+                        else {
+                            stillOk = cc->yieldSometimes( ClientCursor::DontNeed );
+                        }
+                        if ( ! stillOk ) {
                             // we were near and and got pushed to the end
                             // i think returning the splits we've already found is fine
                             
@@ -56,6 +56,8 @@ namespace mongo {
         else {
             assert( server == _configServer );
         }
+
+        startOrphanCleanup();
     }
 
     void ShardingState::gotShardName( const string& name ) {
@@ -272,6 +274,14 @@ namespace mongo {
         }
     }
 
+    void ShardingState::getShardedCollections( vector<string>& ns ) {
+        scoped_lock lk( _mutex );
+
+        for ( ChunkManagersMap::const_iterator it = _chunks.begin(); it != _chunks.end(); ++it ) {
+            ns.push_back( it->first );
+        }
+    }
+
     ShardingState shardingState;
 
     // -----ShardingState END ----
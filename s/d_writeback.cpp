@@ -142,10 +142,28 @@ namespace mongo {
 
             // the command issuer is blocked awaiting a response
             // we want to do return at least at every 5 minutes so sockets don't timeout
+            shared_ptr<WriteBackManager::QueueInfo> q = writeBackManager.getWritebackQueue( id.str() );
             BSONObj z;
-            if ( writeBackManager.getWritebackQueue(id.str())->queue.blockingPop( z, 5 * 60 /* 5 minutes */ ) ) {
+            if ( q->queue.blockingPop( z, 5 * 60 /* 5 minutes */ ) ) {
                 LOG(1) << "WriteBackCommand got : " << z << endl;
                 result.append( "data" , z );
+
+                if ( cmdObj["batch"].trueValue() ) {
+                    // issuer can take everything queued in one response - drain
+                    // what's already here (bounded) and save it a blocking
+                    // listen round trip per op.  it replays in array order.
+                    const int maxBatchBytes = 4 * 1024 * 1024;
+                    int bytes = z.objsize();
+                    BSONArrayBuilder batch( result.subarrayStart( "dataBatch" ) );
+                    BSONObj nxt;
+                    while ( q->queue.peek( nxt ) && bytes + nxt.objsize() < maxBatchBytes ) {
+                        if ( ! q->queue.tryPop( nxt ) )
+                            break;
+                        batch.append( nxt );
+                        bytes += nxt.objsize();
+                    }
+                    batch.done();
+                }
             }
             else {
                 result.appendBool( "noop" , true );
@@ -20,6 +20,7 @@
 
 #include <iomanip>
 #include "../client/connpool.h"
+#include "../util/background.h"
 #include "../util/stringutils.h"
 #include "../util/unittest.h"
 
@@ -469,6 +470,120 @@ namespace mongo {
         _databases.clear();
     }
 
+    DBConfigPtr Grid::_getDBConfigIfCached( const string& database ) {
+        scoped_lock l( _lock );
+        map<string,DBConfigPtr>::const_iterator i = _databases.find( database );
+        return i == _databases.end() ? DBConfigPtr() : i->second;
+    }
+
+    void Grid::_getAllCachedDBs( vector<DBConfigPtr>& all ) {
+        scoped_lock l( _lock );
+        for ( map<string,DBConfigPtr>::const_iterator i = _databases.begin(); i != _databases.end(); ++i ) {
+            if ( i->second )
+                all.push_back( i->second );
+        }
+    }
+
+    /* keeps the metadata cached in _databases fresh from a background thread so the
+       request path rarely has to go to the config servers synchronously.  two
+       mechanisms:
+        (1) change poll - one cheap query per pass for the newest chunk lastmod
+            across all collections.  when nothing has moved (the common case) that
+            single findOne is all the config traffic we generate.  when something
+            did, only the collections with newer chunks are refreshed, and those use
+            the incremental (seeded) chunk load.
+        (2) ttl - every TTLSecs each cached db entry is reloaded outright, catching
+            changes the poll can't see (e.g. a collection drop writes no chunk).
+       a request that hits a stale config error still reloads inline; this just makes
+       that the rare case instead of the norm while chunks are moving. */
+    class Grid::MetadataPoller : public BackgroundJob {
+    public:
+        MetadataPoller() : _lastSeen( 0 ) {}
+
+        virtual string name() const { return "MetadataPoller"; }
+
+        virtual void run() {
+            int secsSinceReload = 0;
+            while ( ! inShutdown() ) {
+                sleepsecs( PollSecs );
+                secsSinceReload += PollSecs;
+                try {
+                    _poll();
+                    if ( secsSinceReload >= TTLSecs ) {
+                        _reloadAll();
+                        secsSinceReload = 0;
+                    }
+                }
+                catch ( std::exception& e ) {
+                    LOG(1) << "metadata poller caught exception: " << e.what() << endl;
+                }
+            }
+        }
+
+    private:
+        enum { PollSecs = 10 , TTLSecs = 300 };
+
+        void _poll() {
+            BSONObj newest;
+            {
+                ScopedDbConnection conn( configServer.modelServer() , 30.0 );
+                newest = conn->findOne( ShardNS::chunk , Query().sort( "lastmod" , -1 ) );
+                conn.done();
+            }
+            if ( newest.isEmpty() )
+                return;
+
+            ShardChunkVersion v = newest["lastmod"];
+            if ( _lastSeen == 0 || v.toLong() == _lastSeen ) {
+                // first pass, or (the common case) nothing has moved
+                _lastSeen = v.toLong();
+                return;
+            }
+
+            // chunks changed somewhere.  find out which collections and refresh just
+            // those, seeding from the chunk managers we already have.
+            set<string> changed;
+            {
+                ScopedDbConnection conn( configServer.modelServer() , 30.0 );
+                BSONObjBuilder q;
+                {
+                    BSONObjBuilder gt( q.subobjStart( "lastmod" ) );
+                    gt.appendTimestamp( "$gt" , _lastSeen );
+                    gt.done();
+                }
+                auto_ptr<DBClientCursor> c = conn->query( ShardNS::chunk , q.obj() );
+                assert( c.get() );
+                while ( c->more() )
+                    changed.insert( c->next()["ns"].String() );
+                conn.done();
+            }
+            _lastSeen = v.toLong();
+
+            for ( set<string>::const_iterator i = changed.begin(); i != changed.end(); ++i ) {
+                const string& ns = *i;
+                DBConfigPtr db = grid._getDBConfigIfCached( nsToDatabase( ns.c_str() ) );
+                if ( ! db )
+                    continue; // nobody has asked us about it - don't start caching it now
+                LOG(1) << "metadata poller refreshing " << ns << endl;
+                db->getChunkManagerIfExists( ns , true );
+            }
+        }
+
+        void _reloadAll() {
+            vector<DBConfigPtr> dbs;
+            grid._getAllCachedDBs( dbs );
+            for ( unsigned i = 0; i < dbs.size(); i++ )
+                dbs[i]->reload();
+        }
+
+        unsigned long long _lastSeen; // newest chunk lastmod we have acted on
+    };
+
+    void Grid::startMetadataPoller() {
+        static MetadataPoller poller;
+        poller.go();
+    }
+
     Grid grid;
 
 
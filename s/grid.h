@@ -83,9 +83,16 @@ namespace mongo {
         bool shouldBalance() const;
 
         unsigned long long getNextOpTime() const;
-        
+
         void flushConfig();
 
+        /**
+         * starts the background thread that keeps the cached metadata fresh: a
+         * cheap change poll against config.chunks plus a periodic full reload of
+         * the cached db entries.  called once at mongos startup.
+         */
+        void startMetadataPoller();
+
         // exposed methods below are for testing only
 
         /**
@@ -96,10 +103,18 @@ namespace mongo {
         static bool _inBalancingWindow( const BSONObj& balancerDoc , const boost::posix_time::ptime& now );
 
     private:
+        class MetadataPoller;                       // background refresher of cached metadata - see grid.cpp
+
         mongo::mutex              _lock;            // protects _databases; TODO: change to r/w lock ??
         map<string, DBConfigPtr > _databases;       // maps ns to DBConfig's
         bool                      _allowLocalShard; // can 'localhost' be used in shard addresses?
 
+        /** @return the cached entry for 'database', without creating or loading one */
+        DBConfigPtr _getDBConfigIfCached( const string& database );
+
+        /** all currently cached db entries */
+        void _getAllCachedDBs( vector<DBConfigPtr>& all );
+
         /**
          * @param name is the chose name for the shard. Parameter is mandatory.
          * @return true if it managed to generate a shard name. May return false if (currently)
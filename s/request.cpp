@@ -107,13 +107,29 @@ namespace mongo {
         int op = _m.operation();
         assert( op > dbMsg );
 
+        {
+            // trace id: adopt the client's if it sent one in the responseTo
+            // header field, otherwise start one here.  the id rides on the
+            // thread, so the shard-side calls made for this request carry it
+            // and mongod's profiler / slow query log can be correlated with
+            // ours (see util/net/message.h).
+            int rt = _m.header()->responseTo;
+            setCurrentTraceId( ( rt != -1 && rt != 0 ) ? (unsigned) rt : newTraceId() );
+        }
+
+        // connections checked out while servicing this request skip repeat
+        // version negotiation; a retry after StaleConfigException comes back
+        // through here and starts the lease over
+        ShardConnection::beginRequest();
+
         if ( op == dbKillCursors ) {
             cursorCache.gotKillCursors( _m );
             return;
         }
 
 
-        LOG(3) << "Request::process ns: " << getns() << " msg id:" << (int)(_m.header()->id) << " attempt: " << attempt << endl;
+        LOG(3) << "Request::process ns: " << getns() << " msg id:" << (int)(_m.header()->id)
+               << " traceid:" << currentTraceId() << " attempt: " << attempt << endl;
 
         Strategy * s = SINGLE;
         _counter = &opsNonSharded;
@@ -0,0 +1,129 @@
+// @file result_cache.cpp
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pch.h"
+#include "result_cache.h"
+
+namespace mongo {
+
+    ResultCache resultCache;
+
+    ResultCache::ResultCache() :
+        _mutex( "ResultCache" ) , _maxBytes( 0 ) , _ttlSecs( DefaultTTLSecs ) ,
+        _bytes( 0 ) , _hits( 0 ) , _misses( 0 ) {
+    }
+
+    void ResultCache::enable( long long maxBytes , int ttlSecs ) {
+        assert( maxBytes > 0 && ttlSecs > 0 );
+        _maxBytes = maxBytes;
+        _ttlSecs = ttlSecs;
+        log() << "result cache enabled size: " << maxBytes << " bytes ttl: " << ttlSecs << "s" << endl;
+    }
+
+    string ResultCache::makeKey( const string& ns , const BSONObj& cmd ) {
+        // exact command bytes: same shape and values or it's a different entry
+        string k = ns;
+        k.append( 1 , '\0' );
+        k.append( cmd.objdata() , cmd.objsize() );
+        return k;
+    }
+
+    bool ResultCache::get( const string& ns , const BSONObj& cmd , unsigned long long token , BSONObjBuilder& result ) {
+        if ( ! enabled() )
+            return false;
+
+        scoped_lock lk( _mutex );
+
+        map<string,Entry>::iterator i = _map.find( makeKey( ns , cmd ) );
+        if ( i == _map.end() ) {
+            _misses++;
+            return false;
+        }
+
+        Entry& e = i->second;
+        if ( e.token != token || time(0) - e.when >= _ttlSecs ) {
+            // shard versions moved on, or too old
+            _bytes -= e.res.objsize();
+            _map.erase( i );
+            _misses++;
+            return false;
+        }
+
+        result.appendElements( e.res );
+        _hits++;
+        return true;
+    }
+
+    void ResultCache::put( const string& ns , const BSONObj& cmd , unsigned long long token , const BSONObj& res ) {
+        if ( ! enabled() )
+            return;
+
+        if ( res.objsize() > MaxCachedResultSize )
+            return; // only small complete results
+
+        scoped_lock lk( _mutex );
+
+        string key = makeKey( ns , cmd );
+
+        map<string,Entry>::iterator i = _map.find( key );
+        if ( i != _map.end() ) {
+            _bytes -= i->second.res.objsize();
+            _map.erase( i );
+        }
+
+        if ( _bytes + res.objsize() > _maxBytes ) {
+            // sweep expired entries first
+            time_t now = time(0);
+            for ( map<string,Entry>::iterator j = _map.begin(); j != _map.end(); ) {
+                if ( now - j->second.when >= _ttlSecs ) {
+                    _bytes -= j->second.res.objsize();
+                    _map.erase( j++ );
+                }
+                else {
+                    ++j;
+                }
+            }
+            if ( _bytes + res.objsize() > _maxBytes ) {
+                // still full of live entries - everything here expires within
+                // _ttlSecs anyway, so starting over is fine and keeps this simple
+                _map.clear();
+                _bytes = 0;
+            }
+        }
+
+        Entry& e = _map[key];
+        e.token = token;
+        e.when = time(0);
+        e.res = res.getOwned();
+        _bytes += e.res.objsize();
+    }
+
+    void ResultCache::appendInfo( BSONObjBuilder& b ) const {
+        scoped_lock lk( _mutex );
+        b.appendBool( "enabled" , enabled() );
+        if ( ! enabled() )
+            return;
+        b.appendNumber( "entries" , (long long)_map.size() );
+        b.appendNumber( "bytes" , _bytes );
+        b.appendNumber( "maxBytes" , _maxBytes );
+        b.append( "ttlSecs" , _ttlSecs );
+        b.appendNumber( "hits" , _hits );
+        b.appendNumber( "misses" , _misses );
+    }
+
+}
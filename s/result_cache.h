@@ -0,0 +1,80 @@
+// @file result_cache.h caching of small scatter-gather command results in mongos
+
+/**
+*    Copyright (C) 2011 10gen Inc.
+*
+*    This program is free software: you can redistribute it and/or  modify
+*    it under the terms of the GNU Affero General Public License, version 3,
+*    as published by the Free Software Foundation.
+*
+*    This program is distributed in the hope that it will be useful,
+*    but WITHOUT ANY WARRANTY; without even the implied warranty of
+*    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*    GNU Affero General Public License for more details.
+*
+*    You should have received a copy of the GNU Affero General Public License
+*    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#pragma once
+
+#include "../pch.h"
+
+namespace mongo {
+
+    /** an opt-in cache of small, complete scatter-gather command results (count,
+        distinct).  dashboards tend to re-issue the exact same commands every few
+        seconds; answering from here skips a round trip to every shard.
+
+        a cached entry is keyed on the exact command bytes plus the namespace, and
+        carries the ChunkManager sequence number it was computed against.  any
+        version bump builds a new ChunkManager (new sequence number), so stale
+        entries miss naturally; the TTL bounds staleness from plain writes, which
+        don't bump versions.
+
+        disabled unless --resultCacheSize is given.  thread-safe.
+    */
+    class ResultCache {
+    public:
+        enum { MaxCachedResultSize = 16 * 1024, DefaultTTLSecs = 10 };
+
+        ResultCache();
+
+        bool enabled() const { return _maxBytes > 0; }
+
+        /** turn the cache on.  called once at startup from option parsing. */
+        void enable( long long maxBytes , int ttlSecs );
+
+        /** look up a previously cached result.
+            @param token the current ChunkManager sequence number for ns
+            @return true if found and still valid; fields appended to result */
+        bool get( const string& ns , const BSONObj& cmd , unsigned long long token , BSONObjBuilder& result );
+
+        /** remember a result.  oversized results are ignored. */
+        void put( const string& ns , const BSONObj& cmd , unsigned long long token , const BSONObj& res );
+
+        /** stats for serverStatus */
+        void appendInfo( BSONObjBuilder& b ) const;
+
+    private:
+        static string makeKey( const string& ns , const BSONObj& cmd );
+
+        struct Entry {
+            unsigned long long token; // ChunkManager sequence number at compute time
+            time_t when;
+            BSONObj res;              // owned
+        };
+
+        mutable mongo::mutex _mutex;
+        long long _maxBytes; // 0 = disabled
+        int _ttlSecs;
+
+        map<string,Entry> _map;
+        long long _bytes;
+        long long _hits;
+        long long _misses;
+    };
+
+    extern ResultCache resultCache;
+
+}
@@ -39,6 +39,7 @@
 #include "grid.h"
 #include "cursors.h"
 #include "shard_version.h"
+#include "result_cache.h"
 
 namespace mongo {
 
@@ -156,7 +157,9 @@ namespace mongo {
         setThreadName( "mongosMain" );
         installChunkShardVersioning();
         balancer.go();
+        grid.startMetadataPoller();
         cursorCache.startTimeoutThread();
+        startAutoSplitTask();
         PeriodicTask::theRunner->go();
 
         ShardedMessageHandler handler;
@@ -200,6 +203,8 @@ int _main(int argc, char* argv[]) {
     ( "test" , "just run unit tests" )
     ( "upgrade" , "upgrade meta data version" )
     ( "chunkSize" , po::value<int>(), "maximum amount of data per chunk" )
+    ( "resultCacheSize" , po::value<int>(), "cache small scatter-gather command results, max size in MB" )
+    ( "resultCacheTTL" , po::value<int>(), "result cache entry lifetime in seconds (default 10)" )
     ( "ipv6", "enable IPv6 support (disabled by default)" )
     ( "jsonp","allow JSONP access via http (has security implications)" )
     ("noscripting", "disable scripting engine")
@@ -229,6 +234,17 @@ int _main(int argc, char* argv[]) {
         Chunk::MaxChunkSize = params["chunkSize"].as<int>() * 1024 * 1024;
     }
 
+    if ( params.count( "resultCacheSize" ) ) {
+        int mb = params["resultCacheSize"].as<int>();
+        int ttl = params.count( "resultCacheTTL" ) ?
+                  params["resultCacheTTL"].as<int>() : (int)ResultCache::DefaultTTLSecs;
+        if ( mb <= 0 || ttl <= 0 ) {
+            out() << "error: resultCacheSize and resultCacheTTL must be > 0" << endl;
+            return 2;
+        }
+        resultCache.enable( mb * 1024LL * 1024 , ttl );
+    }
+
     if ( params.count( "ipv6" ) ) {
         enableIPv6();
     }
@@ -355,6 +355,14 @@ namespace mongo {
         _mapped = obj.getFieldDotted( "mem.mapped" ).numberLong();
         _hasOpsQueued = obj["writeBacksQueued"].Bool();
         _writeLock = 0; // TODO
+
+        _opCount = 0;
+        BSONElement oc = obj["opcounters"];
+        if ( oc.isABSONObj() ) {
+            BSONObjIterator i( oc.Obj() );
+            while ( i.more() )
+                _opCount += i.next().numberLong();
+        }
     }
 
     void ShardingConnectionHook::onCreate( DBClientBase * conn ) {
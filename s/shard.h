@@ -204,9 +204,16 @@ namespace mongo {
             return _hasOpsQueued;
         }
 
+        /** cumulative opcounters total (inserts+queries+updates+deletes+getmores+commands).
+            callers diff successive samples to get a rate. */
+        long long opCount() const {
+            return _opCount;
+        }
+
     private:
         Shard _shard;
         long long _mapped;
+        long long _opCount;
         bool _hasOpsQueued;  // true if 'writebacks' are pending
         double _writeLock;
     };
@@ -251,6 +258,10 @@ namespace mongo {
 
         static void sync();
 
+        /** marks the start of a new client request.  version checks done while
+            servicing it are not repeated on later checkouts within it. */
+        static void beginRequest();
+
         void donotCheckVersion() {
             _setVersion = false;
             _finishedInit = true;
@@ -174,6 +174,31 @@ namespace mongo {
             shardConnectionPool.release( addr , conn );
         }
 
+        /** called when a new client request starts.  version checks performed
+            while servicing it are not repeated for later checkouts of the same
+            connection within it - they are a measurable per-op tax otherwise. */
+        void startRequest() { _versionedThisRequest.clear(); }
+
+        bool versionedThisRequest( DBClientBase* conn , const string& ns ) const {
+            return _versionedThisRequest.count( make_pair( conn , ns ) ) > 0;
+        }
+
+        void noteVersioned( DBClientBase* conn , const string& ns ) {
+            _versionedThisRequest.insert( make_pair( conn , ns ) );
+        }
+
+        /** the connection is going away (e.g. kill()); its memo entries must not
+            short-circuit checks on a replacement connection */
+        void forgetVersioned( DBClientBase* conn ) {
+            for ( set< pair<DBClientBase*,string> >::iterator i = _versionedThisRequest.begin();
+                  i != _versionedThisRequest.end(); ) {
+                if ( i->first == conn )
+                    _versionedThisRequest.erase( i++ );
+                else
+                    ++i;
+            }
+        }
+
         void _check( const string& ns ) {
             if ( ns.size() == 0 || _seenNS.count( ns ) )
                 return;
@@ -184,6 +209,7 @@ namespace mongo {
         typedef map<string,Status*,DBConnectionPool::serverNameCompare> HostMap;
         HostMap _hosts;
         set<string> _seenNS;
+        set< pair<DBClientBase*,string> > _versionedThisRequest;
         // -----
 
         static thread_specific_ptr<ClientConnections> _perThread;
@@ -227,7 +253,15 @@ namespace mongo {
         _finishedInit = true;
 
         if ( _ns.size() ) {
-            _setVersion = checkShardVersionCB( *_conn , _ns , false , 1 );
+            ClientConnections* cc = ClientConnections::threadInstance();
+            if ( cc->versionedThisRequest( _conn , _ns ) ) {
+                // already negotiated for this connection while servicing this request
+                _setVersion = false;
+            }
+            else {
+                _setVersion = checkShardVersionCB( *_conn , _ns , false , 1 );
+                cc->noteVersioned( _conn , _ns );
+            }
         }
         else {
             _setVersion = false;
@@ -246,6 +280,7 @@ namespace mongo {
     void ShardConnection::kill() {
         if ( _conn ) {
             resetShardVersionCB( _conn );
+            ClientConnections::threadInstance()->forgetVersioned( _conn );
             delete _conn;
             _conn = 0;
             _finishedInit = true;
@@ -256,6 +291,10 @@ namespace mongo {
         ClientConnections::threadInstance()->sync();
     }
 
+    void ShardConnection::beginRequest() {
+        ClientConnections::threadInstance()->startRequest();
+    }
+
     bool ShardConnection::runCommand( const string& db , const BSONObj& cmd , BSONObj& res ) {
         assert( _conn );
         bool ok = _conn->runCommand( db , cmd , res );
@@ -57,15 +57,31 @@ namespace mongo {
         bool ok = c.call( r.m(), response, true , &actualServer );
         uassert( 10200 , "mongos: error calling db", ok );
 
-        {
-            QueryResult *qr = (QueryResult *) response.singleData();
-            if ( qr->resultFlags() & ResultFlag_ShardConfigStale ) {
-                dbcon.done();
-                throw StaleConfigException( r.getns() , "Strategy::doQuery" );
-            }
+        QueryResult *qr = (QueryResult *) response.singleData();
+        if ( qr->resultFlags() & ResultFlag_ShardConfigStale ) {
+            dbcon.done();
+            throw StaleConfigException( r.getns() , "Strategy::doQuery" );
         }
 
-        r.reply( response , actualServer.size() ? actualServer : c.getServerAddress() );
+        if ( qr->cursorId && ( r.m().header()->dataAsInt() & QueryOption_Exhaust ) ) {
+            /* exhaust pass-through.  the shard streams the remaining batches at us
+               with no further getMore requests; relay each one to the client.  we
+               bypass Request::reply() - the client never sends a getMore, so there
+               is no cursor ref to store.  on any error the connection is discarded
+               by ~ShardConnection since done() is never reached. */
+            massert( 15918 , "exhaust query needs a direct connection to the shard" ,
+                     c.type() == ConnectionString::MASTER );
+            r.p()->reply( r.m() , response , r.id() );
+            while ( qr->cursorId ) {
+                response.reset();
+                massert( 15919 , "error receiving exhaust stream from shard" , c.recv( response ) );
+                qr = (QueryResult *) response.singleData();
+                r.p()->reply( r.m() , response , r.id() );
+            }
+        }
+        else {
+            r.reply( response , actualServer.size() ? actualServer : c.getServerAddress() );
+        }
         dbcon.done();
     }
 
@@ -81,6 +97,18 @@ namespace mongo {
         dbcon.done();
     }
 
+    void Strategy::insert( const Shard& shard , const char * ns , const vector<BSONObj>& v , int flags, bool safe ) {
+        ShardConnection dbcon( shard , ns );
+        if ( dbcon.setVersion() ) {
+            dbcon.done();
+            throw StaleConfigException( ns , "for insert" );
+        }
+        dbcon->insert( ns , v , flags );
+        if (safe)
+            dbcon->getLastError();
+        dbcon.done();
+    }
+
     void Strategy::update( const Shard& shard , const char * ns , const BSONObj& query , const BSONObj& toupdate , int flags, bool safe ) {
         bool upsert = flags & UpdateOption_Upsert;
         bool multi = flags & UpdateOption_Multi;
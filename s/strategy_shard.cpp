@@ -42,6 +42,12 @@ namespace mongo {
             if ( q.ntoreturn == 1 && strstr(q.ns, ".$cmd") )
                 throw UserException( 8010 , "something is wrong, shouldn't see a command here" );
 
+            // a sharded query merges cursors from several shards; there is no
+            // single stream to relay, so fail fast rather than let the client
+            // block waiting for batches that will never come
+            uassert( 15920 , "exhaust mode is not supported for sharded namespaces" ,
+                     ! ( q.queryOptions & QueryOption_Exhaust ) );
+
             ChunkManagerPtr info = r.getChunkManager();
             assert( info );
 
@@ -125,6 +131,9 @@ namespace mongo {
             const int flags = d.reservedField();
             bool keepGoing = flags & InsertOption_ContinueOnError; // modified before assertion if should abort
 
+            // pull everything off the wire up front - a stale config retry
+            // below has to be able to regroup the undelivered documents
+            vector<BSONObj> docs;
             while ( d.moreJSObjs() ) {
                 try {
                     BSONObj o = d.nextJsObj();
@@ -148,49 +157,88 @@ namespace mongo {
                     }
 
                     // Many operations benefit from having the shard key early in the object
-                    o = manager->getShardKey().moveToFront(o);
+                    docs.push_back( manager->getShardKey().moveToFront(o) );
+                } catch (const UserException&){
+                    if (!keepGoing || !d.moreJSObjs()){
+                        throw;
+                    }
+                    // otherwise ignore and keep going
+                }
+            }
 
-                    const int maxTries = 30;
+            // preflight: a writeback may already have told us a newer chunk
+            // version exists for this collection.  refresh before dispatching
+            // so writeback handling is reserved for the true migrate race
+            // window instead of double-handling every write sent stale.
+            if ( chunkVersionGossip.hasNewerVersion( r.getns() , manager->getVersion() ) ) {
+                LOG(1) << "preflight refresh of " << r.getns() << " from version " << manager->getVersion().toString() << endl;
+                r.reset( true );
+                manager = r.getChunkManager();
+                uassert( 15986 , "collection no longer sharded" , manager );
+            }
+
+            const int maxTries = 30;
+
+            bool gotThrough = docs.empty();
+            for ( int i=0; i<maxTries && !gotThrough; i++ ) {
+                // each shard gets its documents in one message instead of one
+                // message per document.  regrouped from scratch on every retry.
+                map<Shard, vector<BSONObj> > byShard;
+                bool grouped = false;
+                try {
+                    map<ChunkPtr, int> bytesByChunk;
+                    for ( vector<BSONObj>::const_iterator it = docs.begin(); it != docs.end(); ++it ) {
+                        ChunkPtr c = manager->findChunk( *it );
+                        byShard[ c->getShard() ].push_back( *it );
+                        bytesByChunk[ c ] += it->objsize();
+                    }
+                    grouped = true;
 
-                    bool gotThrough = false;
-                    for ( int i=0; i<maxTries; i++ ) {
-                        try {
-                            ChunkPtr c = manager->findChunk( o );
-                            LOG(4) << "  server:" << c->getShard().toString() << " " << o << endl;
-                            insert( c->getShard() , r.getns() , o , flags);
+                    while ( ! byShard.empty() ) {
+                        map<Shard, vector<BSONObj> >::iterator group = byShard.begin();
+                        const Shard& shard = group->first;
+                        LOG(4) << "  server:" << shard.toString() << " bulk insert " << group->second.size() << " documents" << endl;
+                        insert( shard , r.getns() , group->second , flags );
 
+                        for ( size_t k = 0; k < group->second.size(); k++ )
                             r.gotInsert();
-                            if ( r.getClientInfo()->autoSplitOk() )
-                                c->splitIfShould( o.objsize() );
-                            gotThrough = true;
-                            break;
-                        }
-                        catch ( StaleConfigException& e ) {
-                            int logLevel = i < ( maxTries / 2 );
-                            LOG( logLevel ) << "retrying insert because of StaleConfigException: " << e << " object: " << o << endl;
-                            r.reset();
-
-                            manager = r.getChunkManager();
-                            if( ! manager ) {
-                                keepGoing = false;
-                                uasserted(14804, "collection no longer sharded");
+                        if ( r.getClientInfo()->autoSplitOk() ) {
+                            for ( map<ChunkPtr, int>::const_iterator ck = bytesByChunk.begin(); ck != bytesByChunk.end(); ++ck ) {
+                                if ( ck->first->getShard() == shard )
+                                    ck->first->splitIfShould( ck->second );
                             }
-
-                            unsigned long long old = manager->getSequenceNumber();
-                            
-                            LOG( logLevel ) << "  sequence number - old: " << old << " new: " << manager->getSequenceNumber() << endl;
                         }
-                        sleepmillis( i * 20 );
+                        byShard.erase( group );
                     }
+                    gotThrough = true;
+                    break;
+                }
+                catch ( StaleConfigException& e ) {
+                    int logLevel = i < ( maxTries / 2 );
+                    LOG( logLevel ) << "retrying insert because of StaleConfigException: " << e << " remaining: " << docs.size() << endl;
+                    r.reset();
 
-                    assert( inShutdown() || gotThrough ); // not caught below
-                } catch (const UserException&){
-                    if (!keepGoing || !d.moreJSObjs()){
-                        throw;
+                    manager = r.getChunkManager();
+                    if( ! manager ) {
+                        uasserted(14804, "collection no longer sharded");
+                    }
+
+                    unsigned long long old = manager->getSequenceNumber();
+
+                    LOG( logLevel ) << "  sequence number - old: " << old << " new: " << manager->getSequenceNumber() << endl;
+
+                    if ( grouped ) {
+                        // keep only the documents whose shard batch did not go out
+                        docs.clear();
+                        for ( map<Shard, vector<BSONObj> >::const_iterator g = byShard.begin(); g != byShard.end(); ++g )
+                            docs.insert( docs.end() , g->second.begin() , g->second.end() );
+                        gotThrough = docs.empty();
                     }
-                    // otherwise ignore and keep going
                 }
+                sleepmillis( i * 20 );
             }
+
+            assert( inShutdown() || gotThrough ); // not caught below
         }
 
         void insertSharded( DBConfigPtr conf, const char* ns, BSONObj& o, int flags, bool safe, const char* nsChunkLookup ) {
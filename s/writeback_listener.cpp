@@ -112,6 +112,112 @@ namespace mongo {
         throw 1; // never gets here
     }
 
+    void WriteBackListener::processWriteback( const BSONObj& data ) {
+        string ns = data["ns"].valuestrsafe();
+
+        ConnectionIdent cid( "" , 0 );
+        OID wid;
+        if ( data["connectionId"].isNumber() && data["id"].type() == jstOID ) {
+            string s = "";
+            if ( data["instanceIdent"].type() == String )
+                s = data["instanceIdent"].String();
+            cid = ConnectionIdent( s , data["connectionId"].numberLong() );
+            wid = data["id"].OID();
+        }
+        else {
+            warning() << "mongos/mongod version mismatch (1.7.5 is the split)" << endl;
+        }
+
+        int len; // not used, but needed for next call
+        Message m( (void*)data["msg"].binData( len ) , false );
+        massert( 10427 ,  "invalid writeback message" , m.header()->valid() );
+
+        DBConfigPtr db = grid.getDBConfig( ns );
+        ShardChunkVersion needVersion( data["version"] );
+
+        // remember the version the shard wanted so dispatch paths can refresh
+        // before sending instead of generating more writebacks
+        chunkVersionGossip.note( ns , needVersion );
+
+        LOG(1) << "connectionId: " << cid << " writebackId: " << wid << " needVersion : " << needVersion.toString()
+               << " mine : " << db->getChunkManager( ns )->getVersion().toString()
+               << endl;
+
+        LOG(1) << m.toString() << endl;
+
+        if ( needVersion.isSet() && needVersion <= db->getChunkManager( ns )->getVersion() ) {
+            // this means when the write went originally, the version was old
+            // if we're here, it means we've already updated the config, so don't need to do again
+            //db->getChunkManager( ns , true ); // SERVER-1349
+        }
+        else {
+            // we received a writeback object that was sent to a previous version of a shard
+            // the actual shard may not have the object the writeback operation is for
+            // we need to reload the chunk manager and get the new shard versions
+            db->getChunkManager( ns , true );
+        }
+
+        // do request and then call getLastError
+        // we have to call getLastError so we can return the right fields to the user if they decide to call getLastError
+
+        BSONObj gle;
+        int attempts = 0;
+        while ( true ) {
+            attempts++;
+
+            try {
+
+                Request r( m , 0 );
+                r.init();
+
+                r.d().reservedField() |= DbMessage::Reserved_FromWriteback;
+
+                ClientInfo * ci = r.getClientInfo();
+                if (!noauth) {
+                    ci->getAuthenticationInfo()->authorize("admin", internalSecurity.user);
+                }
+                ci->noAutoSplit();
+
+                r.process();
+
+                ci->newRequest(); // this so we flip prev and cur shards
+
+                BSONObjBuilder b;
+                if ( ! ci->getLastError( BSON( "getLastError" << 1 ) , b , true ) ) {
+                    b.appendBool( "commandFailed" , true );
+                }
+                gle = b.obj();
+
+                if ( gle["code"].numberInt() == 9517 ) {
+                    log() << "writeback failed because of stale config, retrying attempts: " << attempts << endl;
+                    if( ! db->getChunkManagerIfExists( ns , true ) ){
+                        uassert( 15884, str::stream() << "Could not reload chunk manager after " << attempts << " attempts.", attempts <= 4 );
+                        sleepsecs( attempts - 1 );
+                    }
+                    continue;
+                }
+
+                ci->clearSinceLastGetError();
+            }
+            catch ( DBException& e ) {
+                error() << "error processing writeback: " << e << endl;
+                BSONObjBuilder b;
+                b.append( "err" , e.toString() );
+                e.getInfo().append( b );
+                gle = b.obj();
+            }
+
+            break;
+        }
+
+        {
+            scoped_lock lk( _seenWritebacksLock );
+            WBStatus& s = _seenWritebacks[cid];
+            s.id = wid;
+            s.gle = gle;
+        }
+    }
+
     void WriteBackListener::run() {
         int secsToSleep = 0;
         while ( ! inShutdown() ) {
@@ -130,6 +236,7 @@ namespace mongo {
                 {
                     BSONObjBuilder cmd;
                     cmd.appendOID( "writebacklisten" , &serverID ); // Command will block for data
+                    cmd.appendBool( "batch" , true ); // we can take everything queued in one response
                     if ( ! conn->runCommand( "admin" , cmd.obj() , result ) ) {
                         result = result.getOwned();
                         log() <<  "writebacklisten command failed!  "  << result << endl;
@@ -143,104 +250,16 @@ namespace mongo {
 
                 BSONObj data = result.getObjectField( "data" );
                 if ( data.getBoolField( "writeBack" ) ) {
-                    string ns = data["ns"].valuestrsafe();
-
-                    ConnectionIdent cid( "" , 0 );
-                    OID wid;
-                    if ( data["connectionId"].isNumber() && data["id"].type() == jstOID ) {
-                        string s = "";
-                        if ( data["instanceIdent"].type() == String )
-                            s = data["instanceIdent"].String();
-                        cid = ConnectionIdent( s , data["connectionId"].numberLong() );
-                        wid = data["id"].OID();
-                    }
-                    else {
-                        warning() << "mongos/mongod version mismatch (1.7.5 is the split)" << endl;
-                    }
-
-                    int len; // not used, but needed for next call
-                    Message m( (void*)data["msg"].binData( len ) , false );
-                    massert( 10427 ,  "invalid writeback message" , m.header()->valid() );
-
-                    DBConfigPtr db = grid.getDBConfig( ns );
-                    ShardChunkVersion needVersion( data["version"] );
-
-                    LOG(1) << "connectionId: " << cid << " writebackId: " << wid << " needVersion : " << needVersion.toString()
-                           << " mine : " << db->getChunkManager( ns )->getVersion().toString() 
-                           << endl;
-
-                    LOG(1) << m.toString() << endl;
-
-                    if ( needVersion.isSet() && needVersion <= db->getChunkManager( ns )->getVersion() ) {
-                        // this means when the write went originally, the version was old
-                        // if we're here, it means we've already updated the config, so don't need to do again
-                        //db->getChunkManager( ns , true ); // SERVER-1349
-                    }
-                    else {
-                        // we received a writeback object that was sent to a previous version of a shard
-                        // the actual shard may not have the object the writeback operation is for
-                        // we need to reload the chunk manager and get the new shard versions
-                        db->getChunkManager( ns , true );
-                    }
-
-                    // do request and then call getLastError
-                    // we have to call getLastError so we can return the right fields to the user if they decide to call getLastError
-
-                    BSONObj gle;
-                    int attempts = 0;
-                    while ( true ) {
-                        attempts++;
-
-                        try {
-                            
-                            Request r( m , 0 );
-                            r.init();
-                            
-                            r.d().reservedField() |= DbMessage::Reserved_FromWriteback;
-                            
-                            ClientInfo * ci = r.getClientInfo();
-                            if (!noauth) {
-                                ci->getAuthenticationInfo()->authorize("admin", internalSecurity.user);
-                            }
-                            ci->noAutoSplit();
-                            
-                            r.process();
-                            
-                            ci->newRequest(); // this so we flip prev and cur shards
-                            
-                            BSONObjBuilder b;
-                            if ( ! ci->getLastError( BSON( "getLastError" << 1 ) , b , true ) ) {
-                                b.appendBool( "commandFailed" , true );
-                            }
-                            gle = b.obj();
-                            
-                            if ( gle["code"].numberInt() == 9517 ) {
-                                log() << "writeback failed because of stale config, retrying attempts: " << attempts << endl;
-                                if( ! db->getChunkManagerIfExists( ns , true ) ){
-                                    uassert( 15884, str::stream() << "Could not reload chunk manager after " << attempts << " attempts.", attempts <= 4 );
-                                    sleepsecs( attempts - 1 );
-                                }
-                                continue;
-                            }
-
-                            ci->clearSinceLastGetError();
-                        }
-                        catch ( DBException& e ) {
-                            error() << "error processing writeback: " << e << endl;
-                            BSONObjBuilder b;
-                            b.append( "err" , e.toString() );
-                            e.getInfo().append( b );
-                            gle = b.obj();
-                        }
-                        
-                        break;
-                    }
-
-                    {
-                        scoped_lock lk( _seenWritebacksLock );
-                        WBStatus& s = _seenWritebacks[cid];
-                        s.id = wid;
-                        s.gle = gle;
+                    processWriteback( data );
+
+                    /* a batching mongod piggybacks everything else it had
+                       queued onto the same response; replay in array order so
+                       per-connection write order is preserved.  absent against
+                       an older mongod, which returns one op per listen call. */
+                    if ( result["dataBatch"].type() == Array ) {
+                        BSONObjIterator i( result["dataBatch"].Obj() );
+                        while ( i.more() )
+                            processWriteback( i.next().Obj() );
                     }
                 }
                 else if ( result["noop"].trueValue() ) {
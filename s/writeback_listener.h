@@ -70,7 +70,11 @@ namespace mongo {
     private:
         string _addr;
         string _name;
-        
+
+        /** replay one writeback op against the (now correctly versioned) shard
+            and record its GLE for waitFor() */
+        void processWriteback( const BSONObj& data );
+
         static mongo::mutex _cacheLock; // protects _cache
         static map<string,WriteBackListener*> _cache; // server to listener
         static set<string> _seenSets; // cache of set urls we've seen - note this is ever expanding for order, case, changes
@@ -20,6 +20,7 @@
 #include "engine.h"
 #include "../util/md5.hpp"
 #include "../util/version.h"
+#include "../util/histogram.h"
 #include "../client/dbclient.h"
 #include "../client/connpool.h"
 // ---------------------------------
@@ -29,6 +30,86 @@
 
 namespace mongo {
 
+    /** per op-type latency accounting shared by the bench threads */
+    class BenchStats {
+    public:
+        BenchStats() : _mutex( "BenchStats" ) {}
+
+        void record( const string& op , unsigned long long micros ) {
+            scoped_lock lk( _mutex );
+            shared_ptr<OpStats>& s = _ops[op];
+            if ( ! s )
+                s.reset( new OpStats() );
+            s->count++;
+            s->totalMicros += micros;
+            if ( micros > s->maxMicros )
+                s->maxMicros = micros;
+            s->hist.insert( micros > 0xffffffffULL ? 0xffffffffU : (boost::uint32_t)micros );
+        }
+
+        void report( BSONObjBuilder& b , double seconds ) const {
+            scoped_lock lk( _mutex );
+            for ( map< string,shared_ptr<OpStats> >::const_iterator i = _ops.begin(); i != _ops.end(); ++i ) {
+                const OpStats& s = *i->second;
+                BSONObjBuilder op( b.subobjStart( i->first ) );
+                op.appendNumber( "count" , s.count );
+                op.append( "opsPerSec" , s.count / seconds );
+                op.append( "avgMicros" , s.count ? (double)s.totalMicros / s.count : 0.0 );
+                op.appendNumber( "p50Micros" , s.percentile( 0.50 ) );
+                op.appendNumber( "p95Micros" , s.percentile( 0.95 ) );
+                op.appendNumber( "p99Micros" , s.percentile( 0.99 ) );
+                op.appendNumber( "maxMicros" , (long long)s.maxMicros );
+                BSONArrayBuilder hb( op.subarrayStart( "histogram" ) );
+                for ( boost::uint32_t j = 0; j < s.hist.getBucketsNum(); j++ ) {
+                    if ( s.hist.getCount( j ) == 0 )
+                        continue;
+                    hb << BSON( "upperMicros" << (long long)s.hist.getBoundary( j )
+                                << "count" << (long long)s.hist.getCount( j ) );
+                }
+                hb.done();
+                op.done();
+            }
+        }
+
+    private:
+        struct OpStats {
+            OpStats() : count(0) , totalMicros(0) , maxMicros(0) , hist( histOpts() ) {}
+
+            static Histogram::Options histOpts() {
+                Histogram::Options o;
+                o.numBuckets = 24;
+                o.bucketSize = 16;   // exponential: 16us, 32us, ... ~2 minutes
+                o.exponential = true;
+                return o;
+            }
+
+            /** approximate: upper boundary of the histogram bucket the
+                requested percentile falls in */
+            long long percentile( double p ) const {
+                long long target = (long long)( p * count );
+                if ( target < 1 )
+                    target = 1;
+                long long seen = 0;
+                for ( boost::uint32_t i = 0; i < hist.getBucketsNum(); i++ ) {
+                    seen += hist.getCount( i );
+                    if ( seen >= target ) {
+                        if ( i + 1 == hist.getBucketsNum() )
+                            return (long long)maxMicros; // last bucket is open ended
+                        return hist.getBoundary( i );
+                    }
+                }
+                return (long long)maxMicros;
+            }
+
+            long long count;
+            unsigned long long totalMicros;
+            unsigned long long maxMicros;
+            Histogram hist;
+        };
+
+        mutable mongo::mutex _mutex;
+        map< string,shared_ptr<OpStats> > _ops;
+    };
 
     struct BenchRunConfig {
         BenchRunConfig() {
@@ -37,8 +118,11 @@ namespace mongo {
 
             parallel = 1;
             seconds = 1;
+            warmup = 0;
+            rate = 0;
 
             active = true;
+            recording = false;
             threadsReady = 0;
             error = false;
         }
@@ -48,13 +132,18 @@ namespace mongo {
 
         unsigned parallel;
         double seconds;
+        double warmup; // seconds of load before stats collection starts
+        double rate;   // target ops/sec across all threads; 0 = closed loop
 
         BSONObj ops;
 
         bool active; // true at starts, gets set to false when should stop
+        bool recording; // set once the warmup period has elapsed
         AtomicUInt threadsReady;
 
         bool error;
+
+        BenchStats stats;
     };
 
     static bool _hasSpecial( const BSONObj& obj ) {
@@ -128,13 +217,37 @@ namespace mongo {
         ScopedDbConnection conn( config->host );
         config->threadsReady++;
 
+        /* open-loop mode: ops run on a fixed cadence and latency is measured
+           from the scheduled start rather than the actual send, so a stalled
+           server accrues queueing delay in the stats instead of just issuing
+           fewer requests (the coordinated omission problem). */
+        unsigned long long interval = 0;
+        unsigned long long next = 0;
+        if ( config->rate > 0 ) {
+            interval = (unsigned long long)( 1000000.0 * config->parallel / config->rate );
+            // stagger the threads across the interval
+            next = curTimeMicros64() + ( rand() % ( interval + 1 ) );
+        }
+
         while ( config->active ) {
             BSONObjIterator i( config->ops );
-            while ( i.more() ) {
+            while ( i.more() && config->active ) {
                 BSONElement e = i.next();
                 string ns = e["ns"].String();
                 string op = e["op"].String();
 
+                unsigned long long start;
+                if ( interval ) {
+                    unsigned long long now = curTimeMicros64();
+                    if ( now < next )
+                        sleepmicros( next - now );
+                    start = next; // scheduled, not actual
+                    next += interval;
+                }
+                else {
+                    start = curTimeMicros64();
+                }
+
                 if ( op == "findOne" ) {
                     conn->findOne( ns , fixQuery( e["query"].Obj() ) );
                 }
@@ -149,7 +262,9 @@ namespace mongo {
                     config->error = true;
                     return;
                 }
-                
+
+                if ( config->recording )
+                    config->stats.record( op , curTimeMicros64() - start );
             }
         }
 
@@ -157,7 +272,14 @@ namespace mongo {
     }
 
     /**
-     * benchRun( { ops : [] , host : XXX , db : XXXX , parallel : 5 , seconds : 5 }
+     * benchRun( { ops : [] , host : XXX , db : XXXX , parallel : 5 , seconds : 5 ,
+     *             warmup : 2 ,   // seconds of load before stats collection
+     *             rate : 1000 }  // target ops/sec across all threads (open loop);
+     *                            // omit for the classic as-fast-as-possible loop
+     *
+     * the result includes a per-op-type "latency" section with ops/sec,
+     * p50/p95/p99 percentiles and an exponential histogram of microsecond
+     * latencies measured during the stats window.
      */
     BSONObj benchRun( const BSONObj& argsFake, void* data ) {
         assert( argsFake.firstElement().isABSONObj() );
@@ -176,6 +298,10 @@ namespace mongo {
             config.parallel = args["parallel"].numberInt();
         if ( args["seconds"].isNumber() )
             config.seconds = args["seconds"].number();
+        if ( args["warmup"].isNumber() )
+            config.warmup = args["warmup"].number();
+        if ( args["rate"].isNumber() )
+            config.rate = args["rate"].number();
 
 
         config.ops = args["ops"].Obj();
@@ -193,13 +319,19 @@ namespace mongo {
         while ( config.threadsReady < config.parallel )
             sleepmillis( 1 );
 
+        //    warmup load runs before any stats are collected
+        if ( config.warmup > 0 )
+            sleepmillis( (int)(1000.0 * config.warmup) );
+
         BSONObj before;
         conn->simpleCommand( "admin" , &before , "serverStatus" );
+        config.recording = true;
 
         sleepmillis( (int)(1000.0 * config.seconds) );
 
         BSONObj after;
         conn->simpleCommand( "admin" , &after , "serverStatus" );
+        config.recording = false;
 
         conn.done();
 
@@ -233,6 +365,13 @@ namespace mongo {
                 buf.append( e.fieldName() , x );
             }
         }
+
+        {
+            BSONObjBuilder lat( buf.subobjStart( "latency" ) );
+            config.stats.report( lat , config.seconds );
+            lat.done();
+        }
+
         BSONObj zoo = buf.obj();
         return BSON( "" << zoo );
     }
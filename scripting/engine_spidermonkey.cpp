@@ -1419,7 +1419,7 @@ namespace mongo {
             assert( JS_SetProperty( _context , _global , field , &v ) );
         }
 
-        void setThis( const BSONObj * obj ) {
+        void setThis( const BSONObj * obj , bool readOnly = false ) {
             smlock;
             if ( _this ) {
                 JS_RemoveRoot( _context , &_this );
@@ -1427,7 +1427,7 @@ namespace mongo {
             }
 
             if ( obj ) {
-                _this = _convertor->toJSObject( obj );
+                _this = _convertor->toJSObject( obj , readOnly );
                 JS_AddNamedRoot( _context , &_this , "scope this" );
             }
         }
@@ -1580,7 +1580,7 @@ namespace mongo {
 
             installInterrupt( timeoutMs );
             jsval rval;
-            setThis(recv);
+            setThis(recv, readOnlyRecv);
             JSBool ret = JS_CallFunction( _context , _this ? _this : _global , func , nargs , smargsPtr.get() , &rval );
             setThis(0);
             uninstallInterrupt( timeoutMs );
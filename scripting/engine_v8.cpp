@@ -29,12 +29,12 @@ using namespace boost;
 #include "v8_utils.h"
 #include "v8_db.h"
 
-#define V8_SIMPLE_HEADER V8Lock l; HandleScope handle_scope; Context::Scope context_scope( _context );
+#define V8_SIMPLE_HEADER v8Locks::BucketBinding __bind( _bucket ); V8Lock l; HandleScope handle_scope; Context::Scope context_scope( _context );
 
 namespace mongo {
 
-    // guarded by v8 mutex
-    map< unsigned, int > __interruptSpecToThreadId;
+    map< unsigned, InterruptTarget > __interruptSpecToThreadId;
+    mongo::mutex __interruptSpecMutex( "interruptSpec" );
 
     /**
      * Unwraps a BSONObj from the JS wrapper
@@ -279,20 +279,40 @@ namespace mongo {
         }
     }
 
+    static void terminateTarget( const InterruptTarget &t ) {
+        // the locker can be acquired even while javascript is executing
+        // because preemption is enabled for it
+        v8::Locker l( t.isolate );
+        if ( t.isolate ) {
+            v8::Isolate::Scope isolate_scope( t.isolate );
+            V8::TerminateExecution( t.threadId );
+        }
+        else {
+            V8::TerminateExecution( t.threadId );
+        }
+    }
+
     void V8ScriptEngine::interrupt( unsigned opSpec ) {
-        v8::Locker l;
-        if ( __interruptSpecToThreadId.count( opSpec ) ) {
-            V8::TerminateExecution( __interruptSpecToThreadId[ opSpec ] );
+        InterruptTarget t;
+        {
+            scoped_lock lk( __interruptSpecMutex );
+            map< unsigned, InterruptTarget >::const_iterator i = __interruptSpecToThreadId.find( opSpec );
+            if ( i == __interruptSpecToThreadId.end() )
+                return;
+            t = i->second;
         }
+        terminateTarget( t );
     }
     void V8ScriptEngine::interruptAll() {
-        v8::Locker l;
-        vector< int > toKill; // v8 mutex could potentially be yielded during the termination call
-        for( map< unsigned, int >::const_iterator i = __interruptSpecToThreadId.begin(); i != __interruptSpecToThreadId.end(); ++i ) {
-            toKill.push_back( i->second );
+        vector< InterruptTarget > toKill; // the lockers below could potentially be yielded during the termination calls
+        {
+            scoped_lock lk( __interruptSpecMutex );
+            for( map< unsigned, InterruptTarget >::const_iterator i = __interruptSpecToThreadId.begin(); i != __interruptSpecToThreadId.end(); ++i ) {
+                toKill.push_back( i->second );
+            }
         }
-        for( vector< int >::const_iterator i = toKill.begin(); i != toKill.end(); ++i ) {
-            V8::TerminateExecution( *i );
+        for( vector< InterruptTarget >::const_iterator i = toKill.begin(); i != toKill.end(); ++i ) {
+            terminateTarget( *i );
         }
     }
 
@@ -300,8 +320,10 @@ namespace mongo {
 
     V8Scope::V8Scope( V8ScriptEngine * engine )
         : _engine( engine ) ,
+          _bucket( v8Locks::bucketForNewScope() ) ,
           _connectState( NOT ) {
 
+        v8Locks::BucketBinding __bind( _bucket );
         V8Lock l;
         HandleScope handleScope;
         _context = Context::New();
@@ -366,6 +388,7 @@ namespace mongo {
     }
 
     V8Scope::~V8Scope() {
+        v8Locks::BucketBinding __bind( _bucket );
         V8Lock l;
         Context::Scope context_scope( _context );
         _wrapper.Dispose();
@@ -830,6 +853,7 @@ namespace mongo {
 
     void V8Scope::gc() {
         cout << "in gc" << endl;
+        v8Locks::BucketBinding __bind( _bucket );
         V8Lock l;
         while( !V8::IdleNotification() );
     }
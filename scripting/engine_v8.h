@@ -35,26 +35,78 @@ namespace mongo {
     // will not be preempted.  The V8Lock should be used in place of v8::Locker
     // except in certain special cases involving interrupts.
     namespace v8Locks {
+
+        /** a v8 isolate plus the non-preemptable mutex guarding it.  we keep a
+            pool of these, sized to the core count, so scopes bound to
+            different isolates can run javascript concurrently. */
+        struct IsolateBucket;
+
+        /** pick the bucket for a new scope.  if the calling thread is already
+            bound to a bucket (a nested scope, e.g. a shell Thread), the new
+            scope shares it, since its handles will reference objects from the
+            creator's isolate.  otherwise buckets are handed out round robin. */
+        IsolateBucket * bucketForNewScope();
+
+        /** the bucket the calling thread is bound to, or 0 if unbound */
+        IsolateBucket * boundBucket();
+
+        /** the isolate of the bucket the current thread is bound to, or 0 for
+            the default isolate */
+        v8::Isolate * currentIsolate();
+
+        /** binds the calling thread to a scope's bucket so V8Lock / V8Unlock
+            guard the right isolate.  construct before V8Lock.  a no-op while
+            the thread is inside a V8Lock - the isolate can't change then. */
+        class BucketBinding : boost::noncopyable {
+        public:
+            BucketBinding( IsolateBucket * bucket );
+            ~BucketBinding();
+        private:
+            IsolateBucket * _prev;
+            bool _bound;
+        };
+
         // the implementations are quite simple - objects must be destroyed in
         // reverse of the order created, and should not be shared between threads
         struct RecursiveLock {
             RecursiveLock();
             ~RecursiveLock();
+            IsolateBucket * _bucket;
             bool _unlock;
         };
         struct RecursiveUnlock {
             RecursiveUnlock();
             ~RecursiveUnlock();
+            IsolateBucket * _bucket;
             bool _lock;
         };
+
+        /** enters the bound isolate once the locks are held.  the default
+            isolate is entered implicitly by v8 and is left alone.  balanced
+            against nesting - only the outermost V8Lock enters. */
+        struct IsolateEnter {
+            IsolateEnter();
+            ~IsolateEnter();
+            v8::Isolate * _exit;
+        };
+        struct IsolateExit {
+            IsolateExit();
+            ~IsolateExit();
+            v8::Isolate * _enter;
+        };
     } // namespace v8Locks
     class V8Lock {
         v8Locks::RecursiveLock _noPreemptionLock;
         v8::Locker _preemptionLock;
+        v8Locks::IsolateEnter _isolateEnter;
+    public:
+        V8Lock() : _preemptionLock( v8Locks::currentIsolate() ) {}
     };
     struct V8Unlock {
+        v8Locks::IsolateExit _isolateExit;
         v8::Unlocker _preemptionUnlock;
         v8Locks::RecursiveUnlock _noPreemptionUnlock;
+        V8Unlock() : _preemptionUnlock( v8Locks::currentIsolate() ) {}
     };
 
     class V8Scope : public Scope {
@@ -163,6 +215,7 @@ namespace mongo {
 
 
         V8ScriptEngine * _engine;
+        v8Locks::IsolateBucket * _bucket; // the isolate this scope's handles live in
 
         Persistent<Context> _context;
         Persistent<v8::Object> _global;
@@ -226,6 +279,16 @@ namespace mongo {
     };
 
     extern ScriptEngine * globalScriptEngine;
-    extern map< unsigned, int > __interruptSpecToThreadId;
+
+    /** which isolate and v8 thread an operation's javascript is running on,
+        so killop can terminate it */
+    struct InterruptTarget {
+        InterruptTarget() : isolate(0), threadId(0) {}
+        v8::Isolate * isolate; // 0 for the default isolate
+        int threadId;
+    };
+    extern map< unsigned, InterruptTarget > __interruptSpecToThreadId;
+    // guards the map above - scopes on different isolates no longer share a lock
+    extern mongo::mutex __interruptSpecMutex;
 
 }
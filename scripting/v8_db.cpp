@@ -1003,47 +1003,141 @@ namespace mongo {
     // to be called with v8 mutex
     void enableV8Interrupt() {
         if ( globalScriptEngine->haveGetInterruptSpecCallback() ) {
-            __interruptSpecToThreadId[ globalScriptEngine->getInterruptSpec() ] = v8::V8::GetCurrentThreadId();
+            InterruptTarget t;
+            t.isolate = v8Locks::currentIsolate();
+            t.threadId = v8::V8::GetCurrentThreadId();
+            scoped_lock lk( __interruptSpecMutex );
+            __interruptSpecToThreadId[ globalScriptEngine->getInterruptSpec() ] = t;
         }
     }
 
     // to be called with v8 mutex
     void disableV8Interrupt() {
         if ( globalScriptEngine->haveGetInterruptSpecCallback() ) {
+            scoped_lock lk( __interruptSpecMutex );
             __interruptSpecToThreadId.erase( globalScriptEngine->getInterruptSpec() );
         }
     }
 
     namespace v8Locks {
-        boost::mutex& __v8Mutex = *( new boost::mutex );
+
+        struct IsolateBucket {
+            IsolateBucket() : _isolate(0) {}
+            boost::mutex _mutex;
+            v8::Isolate * _isolate; // 0 means the default isolate
+        };
+
+        // bucket 0 holds the default isolate, so unbound threads keep the old
+        // single-mutex behavior.  deliberately never freed - threads may still
+        // be inside v8 at shutdown.
+        static IsolateBucket& __defaultBucket = *( new IsolateBucket() );
+        static vector< IsolateBucket * >& __pool = *( new vector< IsolateBucket * >() );
+        static boost::mutex& __poolMutex = *( new boost::mutex );
+        static unsigned __nextBucket = 0;
+
+        static ThreadLocalValue< IsolateBucket * > __bucket;
         ThreadLocalValue< bool > __locked;
 
-        RecursiveLock::RecursiveLock() : _unlock() {
+        static IsolateBucket * currentBucket() {
+            IsolateBucket * b = __bucket.get();
+            return b ? b : &__defaultBucket;
+        }
+
+        IsolateBucket * boundBucket() {
+            return __bucket.get();
+        }
+
+        v8::Isolate * currentIsolate() {
+            return currentBucket()->_isolate;
+        }
+
+        IsolateBucket * bucketForNewScope() {
+            IsolateBucket * bound = __bucket.get();
+            if ( bound ) {
+                // a scope created while running javascript handles objects
+                // from its creator's isolate, so it must share the bucket
+                return bound;
+            }
+            boost::mutex::scoped_lock lk( __poolMutex );
+            if ( __pool.empty() ) {
+                unsigned n = boost::thread::hardware_concurrency();
+                if ( n == 0 )
+                    n = 1;
+                __pool.push_back( &__defaultBucket );
+                for ( unsigned i = 1; i < n; i++ ) {
+                    IsolateBucket * b = new IsolateBucket();
+                    b->_isolate = v8::Isolate::New();
+                    __pool.push_back( b );
+                }
+                log(1) << "v8 isolate pool size: " << __pool.size() << endl;
+            }
+            return __pool[ __nextBucket++ % __pool.size() ];
+        }
+
+        BucketBinding::BucketBinding( IsolateBucket * bucket ) : _prev(), _bound() {
             if ( !__locked.get() ) {
-                __v8Mutex.lock();
+                _prev = __bucket.get();
+                __bucket.set( bucket );
+                _bound = true;
+            }
+        }
+        BucketBinding::~BucketBinding() {
+            if ( _bound )
+                __bucket.set( _prev );
+        }
+
+        RecursiveLock::RecursiveLock() : _bucket(), _unlock() {
+            if ( !__locked.get() ) {
+                _bucket = currentBucket();
+                _bucket->_mutex.lock();
                 __locked.set( true );
                 _unlock = true;
             }
         }
         RecursiveLock::~RecursiveLock() {
             if ( _unlock ) {
-                __v8Mutex.unlock();
+                _bucket->_mutex.unlock();
                 __locked.set( false );
             }
         }
 
-        RecursiveUnlock::RecursiveUnlock() : _lock() {
+        RecursiveUnlock::RecursiveUnlock() : _bucket(), _lock() {
             if ( __locked.get() ) {
-                __v8Mutex.unlock();
+                _bucket = currentBucket();
+                _bucket->_mutex.unlock();
                 __locked.set( false );
                 _lock = true;
             }
         }
         RecursiveUnlock::~RecursiveUnlock() {
             if ( _lock ) {
-                __v8Mutex.lock();
+                _bucket->_mutex.lock();
                 __locked.set( true );
             }
         }
+
+        IsolateEnter::IsolateEnter() : _exit() {
+            v8::Isolate * iso = currentIsolate();
+            if ( iso && v8::Isolate::GetCurrent() != iso ) {
+                iso->Enter();
+                _exit = iso;
+            }
+        }
+        IsolateEnter::~IsolateEnter() {
+            if ( _exit )
+                _exit->Exit();
+        }
+
+        IsolateExit::IsolateExit() : _enter() {
+            v8::Isolate * iso = currentIsolate();
+            if ( iso && v8::Isolate::GetCurrent() == iso ) {
+                iso->Exit();
+                _enter = iso;
+            }
+        }
+        IsolateExit::~IsolateExit() {
+            if ( _enter )
+                _enter->Enter();
+        }
     } // namespace v8Locks
 }
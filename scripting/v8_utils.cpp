@@ -133,7 +133,7 @@ namespace mongo {
 
     class JSThreadConfig {
     public:
-        JSThreadConfig( const Arguments &args, bool newScope = false ) : started_(), done_(), newScope_( newScope ) {
+        JSThreadConfig( const Arguments &args, bool newScope = false ) : started_(), done_(), newScope_( newScope ), bucket_( v8Locks::boundBucket() ) {
             jsassert( args.Length() > 0, "need at least one argument" );
             jsassert( args[ 0 ]->IsFunction(), "first argument must be a function" );
             Local< v8::Function > f = v8::Function::Cast( *args[ 0 ] );
@@ -169,6 +169,8 @@ namespace mongo {
         public:
             JSThread( JSThreadConfig &config ) : config_( config ) {}
             void operator()() {
+                // handles passed in by the creator live in its isolate
+                v8Locks::BucketBinding __bind( config_.bucket_ );
                 V8Lock l;
                 HandleScope handle_scope;
                 Handle< Context > context;
@@ -210,6 +212,7 @@ namespace mongo {
         bool started_;
         bool done_;
         bool newScope_;
+        v8Locks::IsolateBucket * bucket_;
         Persistent< v8::Function > f_;
         vector< Persistent< Value > > args_;
         auto_ptr< boost::thread > thread_;
@@ -8,4 +8,6 @@ def configure( env , fileLists , options ):
     
     files = ["third_party/snappy/snappy.cc", "third_party/snappy/snappy-sinksource.cc"]
 
-    fileLists["serverOnlyFiles"] += [ myenv.Object(f) for f in files ]
+    # common, not serverOnly: wire compression (util/net/message_port.cpp) needs
+    # snappy in the client library, tools and mongos as well
+    fileLists["commonFiles"] += [ myenv.Object(f) for f in files ]
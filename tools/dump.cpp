@@ -44,6 +44,7 @@ public:
         ("oplog", "Use oplog for point-in-time snapshotting" )
         ("repair", "try to recover a crashed database" )
         ("forceTableScan", "force a table scan (do not use $snapshot)" )
+        ("numParallelCollections", po::value<int>()->default_value(1), "number of collections to dump in parallel, each on its own connection" )
         ;
     }
 
@@ -72,7 +73,7 @@ public:
         ProgressMeter* _m;
     };
 
-    void doCollection( const string coll , FILE* out , ProgressMeter *m ) {
+    void doCollection( DBClientBase& connBase , const string coll , FILE* out , ProgressMeter *m ) {
         Query q = _query;
 
         int queryOptions = QueryOption_SlaveOk | QueryOption_NoCursorTimeout;
@@ -80,8 +81,7 @@ public:
             queryOptions |= QueryOption_OplogReplay;
         else if ( _query.isEmpty() && !hasParam("dbpath") && !hasParam("forceTableScan") )
             q.snapshot();
-        
-        DBClientBase& connBase = conn(true);
+
         Writer writer(out, m);
 
         // use low-latency "exhaust" mode if going over the network
@@ -99,21 +99,25 @@ public:
         }
     }
 
-    void writeCollectionFile( const string coll , path outputFile ) {
+    void writeCollectionFile( DBClientBase& c , const string coll , path outputFile ) {
         cout << "\t" << coll << " to " << outputFile.string() << endl;
 
         FilePtr f (fopen(outputFile.string().c_str(), "wb"));
         uassert(10262, errnoWithPrefix("couldn't open file"), f);
 
-        ProgressMeter m( conn( true ).count( coll.c_str() , BSONObj() , QueryOption_SlaveOk ) );
+        ProgressMeter m( c.count( coll.c_str() , BSONObj() , QueryOption_SlaveOk ) );
 
-        doCollection(coll, f, &m);
+        doCollection(c, coll, f, &m);
 
         cout << "\t\t " << m.done() << " objects" << endl;
     }
 
     void writeCollectionStdout( const string coll ) {
-        doCollection(coll, stdout, NULL);
+        doCollection(conn( true ), coll, stdout, NULL);
+    }
+
+    void dumpJob( DBClientBase& c , const string& ns , const string& file ) {
+        writeCollectionFile( c , ns , path( file ) );
     }
 
     void go( const string db , const path outdir ) {
@@ -121,6 +125,8 @@ public:
 
         create_directories( outdir );
 
+        ParallelJobs jobs;
+
         string sns = db + ".system.namespaces";
 
         auto_ptr<DBClientCursor> cursor = conn( true ).query( sns.c_str() , Query() , 0 , 0 , 0 , QueryOption_SlaveOk | QueryOption_NoCursorTimeout );
@@ -139,10 +145,29 @@ public:
             if ( _coll != "*" && db + "." + _coll != name && _coll != name )
                 continue;
 
-            writeCollectionFile( name.c_str() , outdir / ( filename + ".bson" ) );
+            long long size = 0;
+            if ( _numParallel > 1 ) {
+                // size drives largest-first scheduling of the workers
+                BSONObj res;
+                if ( conn( true ).runCommand( db , BSON( "collstats" << filename ) , res ) )
+                    size = res["size"].numberLong();
+            }
 
+            jobs.add( name , ( outdir / ( filename + ".bson" ) ).string() , size );
         }
 
+        if ( _numParallel <= 1 || jobs.size() <= 1 ) {
+            string ns , file;
+            while ( jobs.next( ns , file ) )
+                writeCollectionFile( conn( true ) , ns , path( file ) );
+            return;
+        }
+
+        // dump the biggest collections first so a straggler doesn't serialize the tail
+        jobs.sortBySize();
+
+        int failures = runParallelJobs( jobs , _numParallel , db , boost::bind( &Dump::dumpJob , this , _1 , _2 , _3 ) );
+        uassert( 15915 , str::stream() << failures << " collection(s) failed to dump" , failures == 0 );
     }
 
     int repair() {
@@ -366,6 +391,8 @@ public:
             opLogStart = op["ts"]._numberLong();
         }
 
+        _numParallel = numParallelCollections();
+
         // check if we're outputting to stdout
         string out = getParam("out");
         if ( out == "-" ) {
@@ -424,13 +451,14 @@ public:
 
             _query = BSON("ts" << b.obj());
 
-            writeCollectionFile( opLogName , root / "oplog.bson" );
+            writeCollectionFile( conn( true ) , opLogName , root / "oplog.bson" );
         }
 
         return 0;
     }
 
     bool _usingMongos;
+    int _numParallel;
     BSONObj _query;
 };
 
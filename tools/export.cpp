@@ -26,11 +26,120 @@
 #include <iostream>
 
 #include <boost/program_options.hpp>
+#include <boost/thread/thread.hpp>
 
 using namespace mongo;
 
 namespace po = boost::program_options;
 
+namespace {
+
+    /** pipeline for json output.  the main thread batches documents off the
+        cursor, worker threads run jsonString() - string formatting, not i/o,
+        is the bottleneck for a json export - and whichever worker finishes
+        the next batch in line writes it, so output order matches cursor
+        order. */
+    class JsonFormatter : boost::noncopyable {
+    public:
+        JsonFormatter( ostream &out , bool jsonArray , int nThreads )
+            : _out( out ) , _jsonArray( jsonArray ) , _mutex( "JsonFormatter" ) ,
+              _nextIn( 0 ) , _nextOut( 0 ) , _draining( false ) {
+            for ( int i = 0; i < nThreads; i++ )
+                _threads.push_back( shared_ptr<boost::thread>(
+                    new boost::thread( boost::bind( &JsonFormatter::workerThread , this ) ) ) );
+        }
+
+        ~JsonFormatter() {
+            finish();
+        }
+
+        /** hand a batch of owned documents to the formatters, emptying docs.
+            blocks if the formatters are more than a few batches behind. */
+        void push( vector<BSONObj> &docs ) {
+            scoped_lock lk( _mutex );
+            while ( _pending.size() >= _threads.size() + 2 )
+                _space.wait( lk.boost() );
+            _pending.push_back( Batch() );
+            _pending.back().seq = _nextIn++;
+            _pending.back().docs.swap( docs );
+            _work.notify_one();
+        }
+
+        /** wait until everything pushed has been formatted and written */
+        void finish() {
+            {
+                scoped_lock lk( _mutex );
+                if ( _draining )
+                    return;
+                _draining = true;
+                _work.notify_all();
+            }
+            for ( unsigned i = 0; i < _threads.size(); i++ )
+                _threads[i]->join();
+        }
+
+    private:
+        struct Batch {
+            long long seq;
+            vector<BSONObj> docs;
+        };
+
+        void workerThread() {
+            while ( 1 ) {
+                Batch b;
+                {
+                    scoped_lock lk( _mutex );
+                    while ( _pending.empty() && ! _draining )
+                        _work.wait( lk.boost() );
+                    if ( _pending.empty() )
+                        return;
+                    b.seq = _pending.front().seq;
+                    b.docs.swap( _pending.front().docs );
+                    _pending.pop_front();
+                    _space.notify_all();
+                }
+
+                StringBuilder ss( 256 * 1024 );
+                for ( unsigned i = 0; i < b.docs.size(); i++ ) {
+                    if ( _jsonArray ) {
+                        if ( b.seq > 0 || i > 0 )
+                            ss << ',';
+                        ss << b.docs[i].jsonString();
+                    }
+                    else {
+                        ss << b.docs[i].jsonString() << '\n';
+                    }
+                }
+                string formatted = ss.str();
+
+                scoped_lock lk( _mutex );
+                _formatted[ b.seq ].swap( formatted );
+                // whoever formatted the batch whose turn it is drains the map
+                // forward, so batches hit the stream in cursor order
+                map<long long,string>::iterator i;
+                while ( ( i = _formatted.find( _nextOut ) ) != _formatted.end() ) {
+                    _out.write( i->second.data() , i->second.size() );
+                    _formatted.erase( i );
+                    _nextOut++;
+                }
+            }
+        }
+
+        ostream &_out;
+        bool _jsonArray;
+        mongo::mutex _mutex;
+        boost::condition _work;
+        boost::condition _space;
+        deque<Batch> _pending; // waiting to be formatted
+        map<long long,string> _formatted; // formatted, awaiting their turn on the stream
+        long long _nextIn;
+        long long _nextOut;
+        bool _draining;
+        vector< shared_ptr<boost::thread> > _threads;
+    };
+
+}
+
 class Export : public Tool {
 public:
     Export() : Tool( "export" ) {
@@ -195,10 +304,10 @@ public:
             out << '[';
 
         long long num = 0;
-        while ( cursor->more() ) {
-            num++;
-            BSONObj obj = cursor->next();
-            if ( csv ) {
+        if ( csv ) {
+            while ( cursor->more() ) {
+                num++;
+                BSONObj obj = cursor->next();
                 for ( vector<string>::iterator i=_fields.begin(); i != _fields.end(); i++ ) {
                     if ( i != _fields.begin() )
                         out << ",";
@@ -209,15 +318,26 @@ public:
                 }
                 out << endl;
             }
-            else {
-                if (jsonArray && num != 1)
-                    out << ',';
-
-                out << obj.jsonString();
+        }
+        else {
+            int nThreads = (int) boost::thread::hardware_concurrency();
+            if ( nThreads < 1 )
+                nThreads = 1;
+            else if ( nThreads > 4 )
+                nThreads = 4; // formatting scales, but the writer is serial
 
-                if (!jsonArray)
-                    out << endl;
+            JsonFormatter formatter( out , jsonArray , nThreads );
+            vector<BSONObj> batch;
+            while ( cursor->more() ) {
+                num++;
+                // owned copy - the cursor's buffer is recycled on getMore
+                batch.push_back( cursor->next().getOwned() );
+                if ( batch.size() >= 256 )
+                    formatter.push( batch );
             }
+            if ( ! batch.empty() )
+                formatter.push( batch );
+            formatter.finish();
         }
 
         if (jsonArray)
@@ -44,6 +44,7 @@ class Import : public Tool {
     bool _upsert;
     bool _doimport;
     bool _jsonArray;
+    bool _fastParse;
     vector<string> _upsertFields;
     static const int BUF_SIZE = 1024 * 1024 * 4;
 
@@ -155,7 +156,8 @@ class Import : public Tool {
             return -1;
 
         int jslen;
-        o = fromjson(buf, &jslen);
+        if ( ! ( _fastParse && fromjsonFast( buf , o , &jslen ) ) )
+            o = fromjson(buf, &jslen);
         len += jslen;
 
         return len;
@@ -185,6 +187,10 @@ class Import : public Tool {
                 *end = 0;
                 end--;
             }
+            if ( _fastParse && fromjsonFast( line , o ) )
+                return true;
+            // not strict json (or malformed): the full parser is the authority
+            // on extended syntax and on error messages
             o = fromjson( line );
             return true;
         }
@@ -269,6 +275,7 @@ public:
         ("upsertFields", po::value<string>(), "comma-separated fields for the query part of the upsert. You should make sure this is indexed" )
         ("stopOnError", "stop importing at first error rather than continuing" )
         ("jsonArray", "load a json array, not one item per line. Currently limited to 4MB." )
+        ("fast", "use a faster parser for strict json documents. documents using extended syntax fall back to the standard parser." )
         ;
         add_hidden_options()
         ("noimport", "don't actually import. useful for benchmarking parser" )
@@ -280,6 +287,7 @@ public:
         _upsert = false;
         _doimport = true;
         _jsonArray = false;
+        _fastParse = false;
     }
 
     int run() {
@@ -343,6 +351,10 @@ public:
             _doimport = false;
         }
 
+        if ( hasParam( "fast" ) ) {
+            _fastParse = true;
+        }
+
         if ( hasParam( "type" ) ) {
             string type = getParam( "type" );
             if ( type == "json" )
@@ -33,6 +33,7 @@ namespace po = boost::program_options;
 
 namespace {
     const char* OPLOG_SENTINEL = "$oplog";  // compare by ptr not strcmp
+    const int MAX_BATCH_BYTES = 8 * 1024 * 1024;  // flush a bulk insert at this size regardless of count
 }
 
 class Restore : public BSONTool {
@@ -40,15 +41,27 @@ public:
 
     bool _drop;
     bool _keepIndexVersion;
+    int _numParallel;
+    int _batchSize;     // documents per bulk insert message
+    int _flushBatches;  // getLastError after this many batches - bounds unacknowledged data
     string _curns;
     string _curdb;
     set<string> _users; // For restoring users with --drop
 
-    Restore() : BSONTool( "restore" ) , _drop(false) {
+    // plain-insert batching for the serial (gotObject) path
+    vector<BSONObj> _insertBatch;
+    int _insertBatchBytes;
+    int _batchesSinceFlush;
+
+    Restore() : BSONTool( "restore" ) , _drop(false), _numParallel(1),
+        _batchSize(1000), _flushBatches(8), _insertBatchBytes(0), _batchesSinceFlush(0) {
         add_options()
         ("drop" , "drop each collection before import" )
         ("oplogReplay" , "replay oplog for point-in-time restore")
         ("keepIndexVersion" , "don't upgrade indexes to newest version")
+        ("numParallelCollections", po::value<int>()->default_value(1), "number of collections to restore in parallel, each on its own connection" )
+        ("insertBatchSize", po::value<int>()->default_value(1000), "documents per bulk insert message" )
+        ("flushBatches", po::value<int>()->default_value(8), "getLastError after this many batches; bounds data in flight" )
         ;
         add_hidden_options()
         ("dir", po::value<string>()->default_value("dump"), "directory to restore from")
@@ -73,6 +86,17 @@ public:
         _drop = hasParam( "drop" );
         _keepIndexVersion = hasParam("keepIndexVersion");
 
+        _batchSize = getParam( "insertBatchSize" , 1000 );
+        uassert( 15949 , "--insertBatchSize must be >= 1" , _batchSize >= 1 );
+        _flushBatches = getParam( "flushBatches" , 8 );
+        uassert( 15950 , "--flushBatches must be >= 1" , _flushBatches >= 1 );
+
+        _numParallel = numParallelCollections();
+        if ( _numParallel > 1 && ( hasParam( "filter" ) || hasParam( "objcheck" ) ) ) {
+            warning() << "--filter and --objcheck run on a single connection; restoring serially" << endl;
+            _numParallel = 1;
+        }
+
         bool doOplog = hasParam( "oplogReplay" );
         if (doOplog) {
             // fail early if errors
@@ -133,6 +157,7 @@ public:
             directory_iterator end;
             directory_iterator i(root);
             path indexes;
+            vector<path> dataFiles; // restored by the parallel workers
             while ( i != end ) {
                 path p = *i;
                 i++;
@@ -161,10 +186,30 @@ public:
 
                 if ( p.leaf() == "system.indexes.bson" )
                     indexes = p;
+                else if ( _numParallel > 1 && ! use_coll && ! is_directory( p ) &&
+                          endsWith( p.leaf().c_str() , ".bson" ) &&
+                          ! startsWith( p.leaf().c_str() , "system." ) )
+                    dataFiles.push_back( p );
                 else
                     drillDown(p, use_db, use_coll);
             }
 
+            if ( dataFiles.size() == 1 ) {
+                drillDown( dataFiles[0] , use_db , use_coll ); // nothing to parallelize
+            }
+            else if ( ! dataFiles.empty() ) {
+                ParallelJobs jobs;
+                for ( unsigned j = 0; j < dataFiles.size(); j++ )
+                    jobs.add( nsForFile( dataFiles[j] , use_db , use_coll ) , dataFiles[j].string() , file_size( dataFiles[j] ) );
+
+                // restore the biggest collections first so a straggler doesn't serialize the tail
+                jobs.sortBySize();
+
+                string authDb = NamespaceString( nsForFile( dataFiles[0] , use_db , use_coll ) ).db;
+                int failures = runParallelJobs( jobs , _numParallel , authDb , boost::bind( &Restore::restoreJob , this , _1 , _2 , _3 ) );
+                uassert( 15917 , str::stream() << failures << " collection(s) failed to restore" , failures == 0 );
+            }
+
             if (!indexes.empty())
                 drillDown(indexes, use_db, use_coll);
 
@@ -184,6 +229,41 @@ public:
             return;
         }
 
+        string ns = nsForFile( root , use_db , use_coll );
+
+        out() << "\t going into namespace [" << ns << "]" << endl;
+
+        if ( _drop ) {
+            if (root.leaf() != "system.users.bson" ) {
+                out() << "\t dropping" << endl;
+                conn().dropCollection( ns );
+            } else {
+                // Create map of the users currently in the DB
+                BSONObj fields = BSON("user" << 1);
+                scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
+                while (cursor->more()) {
+                    BSONObj user = cursor->next();
+                    _users.insert(user["user"].String());
+                }
+            }
+        }
+
+        _curns = ns.c_str();
+        _curdb = NamespaceString(_curns).db;
+        processFile( root );
+        flushInsertBatch();
+        conn().getLastError();
+        if (_drop && root.leaf() == "system.users.bson") {
+            // Delete any users that used to exist but weren't in the dump file
+            for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
+                BSONObj userMatch = BSON("user" << *it);
+                conn().remove(ns, Query(userMatch));
+            }
+            _users.clear();
+        }
+    }
+
+    string nsForFile( const path& root , bool use_db , bool use_coll ) {
         string ns;
         if (use_db) {
             ns += _db;
@@ -210,34 +290,86 @@ public:
             ns += "." + l;
         }
 
-        out() << "\t going into namespace [" << ns << "]" << endl;
+        return ns;
+    }
 
+    void restoreJob( DBClientBase& c , const string& ns , const string& file ) {
+        out() << "\t going into namespace [" << ns << "]" << endl;
         if ( _drop ) {
-            if (root.leaf() != "system.users.bson" ) {
-                out() << "\t dropping" << endl;
-                conn().dropCollection( ns );
-            } else {
-                // Create map of the users currently in the DB
-                BSONObj fields = BSON("user" << 1);
-                scoped_ptr<DBClientCursor> cursor(conn().query(ns, Query(), 0, 0, &fields));
-                while (cursor->more()) {
-                    BSONObj user = cursor->next();
-                    _users.insert(user["user"].String());
-                }
-            }
+            out() << "\t dropping" << endl;
+            c.dropCollection( ns );
         }
+        insertFile( c , path( file ) , ns );
+    }
 
-        _curns = ns.c_str();
-        _curdb = NamespaceString(_curns).db;
-        processFile( root );
-        if (_drop && root.leaf() == "system.users.bson") {
-            // Delete any users that used to exist but weren't in the dump file
-            for (set<string>::iterator it = _users.begin(); it != _users.end(); ++it) {
-                BSONObj userMatch = BSON("user" << *it);
-                conn().remove(ns, Query(userMatch));
+    /** stream a dumped .bson file into ns over the given connection.  the
+        plain-insert subset of processFile - the parallel path only handles
+        regular collections, so the oplog and system collection special cases
+        in gotObject don't apply. */
+    void insertFile( DBClientBase& c , const path& file , const string& ns ) {
+        unsigned long long fileLength = file_size( file );
+        if ( fileLength == 0 ) {
+            out() << "file " << file.string() << " empty, skipping" << endl;
+            return;
+        }
+
+        FILE* f = fopen( file.string().c_str() , "rb" );
+        if ( ! f ) {
+            log() << "error opening file: " << file.string() << " " << errnoWithDescription() << endl;
+            return;
+        }
+
+#if !defined(__sunos__) && defined(POSIX_FADV_SEQUENTIAL)
+        posix_fadvise(fileno(f), 0, fileLength, POSIX_FADV_SEQUENTIAL);
+#endif
+
+        const int BUF_SIZE = BSONObjMaxUserSize + ( 1024 * 1024 );
+        boost::scoped_array<char> buf_holder(new char[BUF_SIZE]);
+        char * buf = buf_holder.get();
+
+        unsigned long long read = 0;
+        unsigned long long num = 0;
+
+        vector<BSONObj> batch;
+        int batchBytes = 0;
+        int batchesSinceFlush = 0;
+
+        while ( read < fileLength ) {
+            size_t amt = fread(buf, 1, 4, f);
+            assert( amt == 4 );
+
+            int size = ((int*)buf)[0];
+            uassert( 15916 , str::stream() << "invalid object size: " << size , size < BUF_SIZE );
+
+            amt = fread(buf+4, 1, size-4, f);
+            assert( amt == (size_t)( size - 4 ) );
+
+            BSONObj o( buf );
+            batch.push_back( o.getOwned() ); // buf is reused for the next object
+            batchBytes += o.objsize();
+
+            if ( (int)batch.size() >= _batchSize || batchBytes >= MAX_BATCH_BYTES ) {
+                c.insert( ns , batch );
+                batch.clear();
+                batchBytes = 0;
+                if ( ++batchesSinceFlush >= _flushBatches ) {
+                    // settle the in-flight window so an error doesn't surface
+                    // megabytes later
+                    c.getLastError();
+                    batchesSinceFlush = 0;
+                }
             }
-            _users.clear();
+
+            read += o.objsize();
+            num++;
         }
+
+        fclose( f );
+
+        if ( ! batch.empty() )
+            c.insert( ns , batch );
+        c.getLastError();
+        out() << "\t " << num << " objects restored to " << ns << endl;
     }
 
     virtual void gotObject( const BSONObj& obj ) {
@@ -290,7 +422,26 @@ public:
             conn().update(_curns, Query(userMatch), obj);
             _users.erase(obj["user"].String());
         } else {
-            conn().insert( _curns , obj );
+            _insertBatch.push_back( obj.getOwned() ); // caller reuses the underlying buffer
+            _insertBatchBytes += obj.objsize();
+            if ( (int)_insertBatch.size() >= _batchSize || _insertBatchBytes >= MAX_BATCH_BYTES )
+                flushInsertBatch();
+        }
+    }
+
+    /** send any accumulated plain inserts as one bulk message.  called when a
+        batch fills and after each data file; the special-cased namespaces
+        (oplog, system.indexes, system.users) never accumulate here. */
+    void flushInsertBatch() {
+        if ( _insertBatch.empty() )
+            return;
+        conn().insert( _curns , _insertBatch );
+        _insertBatch.clear();
+        _insertBatchBytes = 0;
+        if ( ++_batchesSinceFlush >= _flushBatches ) {
+            // settle the in-flight window so an error doesn't surface megabytes later
+            conn().getLastError();
+            _batchesSinceFlush = 0;
         }
     }
 
@@ -480,6 +480,38 @@ namespace mongo {
             bool mongos;
         };
 
+        static bool _isDeltaMetaField( const char * f ) {
+            return strcmp( f , "token" ) == 0 || strcmp( f , "dtMillis" ) == 0 ||
+                   strcmp( f , "initial" ) == 0 || strcmp( f , "ok" ) == 0;
+        }
+
+        /** rebuild an absolute statusDelta snapshot: numeric fields add onto
+            the previous snapshot, everything else is taken verbatim.  exact
+            for counters and gauges alike (gauge deltas can go negative). */
+        static BSONObj applyDelta( const BSONObj& base , const BSONObj& delta ) {
+            BSONObjBuilder b;
+            BSONObjIterator i( delta );
+            while ( i.more() ) {
+                BSONElement e = i.next();
+                if ( _isDeltaMetaField( e.fieldName() ) )
+                    continue;
+                BSONElement p = base[e.fieldName()];
+                if ( e.type() == Object && p.type() == Object ) {
+                    b.append( e.fieldName() , applyDelta( p.Obj() , e.Obj() ) );
+                }
+                else if ( e.isNumber() && p.isNumber() ) {
+                    if ( e.type() == NumberDouble || p.type() == NumberDouble )
+                        b.append( e.fieldName() , p.numberDouble() + e.numberDouble() );
+                    else
+                        b.appendNumber( e.fieldName() , (long long)( p.numberLong() + e.numberLong() ) );
+                }
+                else {
+                    b.append( e );
+                }
+            }
+            return b.obj();
+        }
+
         static void serverThread( shared_ptr<ServerState> state ) {
             try {
                 DBClientConnection conn( true );
@@ -490,10 +522,39 @@ namespace mongo {
 
                 long long cycleNumber = 0;
 
+                // prefer the slim statusDelta command - much cheaper than a
+                // full serverStatus per second per node.  older servers and
+                // mongos don't have it; first failure drops us back to
+                // serverStatus for good.
+                bool useDelta = true;
+                long long token = 0;
+                BSONObj base; // absolute snapshot rebuilt from the deltas
+
                 while ( ++cycleNumber ) {
                     try {
                         BSONObj out;
-                        if ( conn.simpleCommand( "admin" , &out , "serverStatus" ) ) {
+                        bool ok = false;
+
+                        if ( useDelta ) {
+                            BSONObj res;
+                            if ( conn.runCommand( "admin" , BSON( "statusDelta" << 1 << "token" << token ) , res ) ) {
+                                token = res["token"].numberLong();
+                                if ( res["initial"].trueValue() || base.isEmpty() )
+                                    base = res.getOwned();
+                                else
+                                    base = applyDelta( base , res );
+                                out = base;
+                                ok = true;
+                            }
+                            else {
+                                useDelta = false;
+                            }
+                        }
+
+                        if ( ! useDelta )
+                            ok = conn.simpleCommand( "admin" , &out , "serverStatus" );
+
+                        if ( ok ) {
                             scoped_lock lk( state->lock );
                             state->error = "";
                             state->lastUpdate = time(0);
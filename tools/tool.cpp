@@ -393,6 +393,109 @@ namespace mongo {
         throw UserException( 9998 , "you need to specify fields" );
     }
 
+    void ParallelJobs::add( const string& ns , const string& file , long long size ) {
+        Job j;
+        j.ns = ns;
+        j.file = file;
+        j.size = size;
+        _jobs.push_back( j );
+    }
+
+    void ParallelJobs::sortBySize() {
+        std::sort( _jobs.begin() , _jobs.end() , _largerFirst );
+    }
+
+    bool ParallelJobs::next( string& ns , string& file ) {
+        scoped_lock lk( _lock );
+        if ( _next >= _jobs.size() )
+            return false;
+        ns = _jobs[_next].ns;
+        file = _jobs[_next].file;
+        _next++;
+        return true;
+    }
+
+    void ParallelJobs::noteFailure() {
+        scoped_lock lk( _lock );
+        _failures++;
+    }
+
+    int ParallelJobs::failures() {
+        scoped_lock lk( _lock );
+        return _failures;
+    }
+
+    int Tool::numParallelCollections() {
+        int n = getParam( "numParallelCollections" , 1 );
+        uassert( 15914 , "numParallelCollections must be a positive number" , n > 0 );
+        if ( n > 1 && hasParam( "dbpath" ) ) {
+            warning() << "--dbpath only supports a single direct connection; running serially" << endl;
+            return 1;
+        }
+        return n;
+    }
+
+    DBClientBase * Tool::newConnection( const string& authDb , string& errmsg ) {
+        if ( hasParam( "dbpath" ) ) {
+            errmsg = "--dbpath only supports a single direct connection";
+            return 0;
+        }
+        ConnectionString cs = ConnectionString::parse( _host , errmsg );
+        if ( ! cs.isValid() )
+            return 0;
+        DBClientBase * c = cs.connect( errmsg );
+        if ( ! c )
+            return 0;
+        if ( _username.size() || _password.size() ) {
+            // same fallback order as auth()
+            if ( c->auth( authDb.size() ? authDb : _db , _username , _password , errmsg ) )
+                return c;
+            if ( c->auth( "admin" , _username , _password , errmsg ) )
+                return c;
+            delete c;
+            return 0;
+        }
+        return c;
+    }
+
+    void Tool::_parallelWorker( ParallelJobs * jobs , string authDb , ParallelJobFn fn ) {
+        scoped_ptr<DBClientBase> c;
+        {
+            string errmsg;
+            c.reset( newConnection( authDb , errmsg ) );
+            if ( ! c ) {
+                cerr << "couldn't open worker connection: " << errmsg << endl;
+                jobs->noteFailure();
+                return;
+            }
+        }
+        string ns , file;
+        while ( jobs->next( ns , file ) ) {
+            try {
+                fn( *c , ns , file );
+            }
+            catch ( DBException& e ) {
+                cerr << "error processing " << ns << ": " << e.toString() << endl;
+                jobs->noteFailure();
+            }
+            catch ( std::exception& e ) {
+                cerr << "error processing " << ns << ": " << e.what() << endl;
+                jobs->noteFailure();
+            }
+        }
+    }
+
+    int Tool::runParallelJobs( ParallelJobs& jobs , int nThreads , const string& authDb , ParallelJobFn fn ) {
+        if ( nThreads > (int)jobs.size() )
+            nThreads = jobs.size();
+        vector< shared_ptr<boost::thread> > threads;
+        for ( int i = 0; i < nThreads; i++ )
+            threads.push_back( shared_ptr<boost::thread>( new boost::thread( boost::bind( &Tool::_parallelWorker , this , &jobs , authDb , fn ) ) ) );
+        for ( unsigned i = 0; i < threads.size(); i++ )
+            threads[i]->join();
+        return jobs.failures();
+    }
+
     void Tool::auth( string dbname ) {
         if ( ! dbname.size() )
             dbname = _db;
@@ -34,6 +34,37 @@ using std::string;
 
 namespace mongo {
 
+    /** work list for tools operating on several collections at once
+        ( --numParallelCollections ).  jobs are handed out in queue order, so
+        sort the biggest collections first for balanced completion. */
+    class ParallelJobs : boost::noncopyable {
+    public:
+        ParallelJobs() : _lock( "ParallelJobs" ) , _next( 0 ) , _failures( 0 ) {}
+
+        void add( const string& ns , const string& file , long long size = 0 );
+        unsigned size() const { return _jobs.size(); }
+
+        /** biggest collections first.  call before the workers start. */
+        void sortBySize();
+
+        bool next( string& ns , string& file );
+        void noteFailure();
+        int failures();
+
+    private:
+        struct Job {
+            string ns;
+            string file;
+            long long size;
+        };
+        static bool _largerFirst( const Job& a , const Job& b ) { return a.size > b.size; }
+
+        mongo::mutex _lock;
+        vector<Job> _jobs;
+        unsigned _next;
+        int _failures;
+    };
+
     class Tool {
     public:
         enum DBAccess {
@@ -101,6 +132,23 @@ namespace mongo {
         mongo::DBClientBase &conn( bool slaveIfPaired = false );
         void auth( string db = "" );
 
+        /** number of collections to work on concurrently, from
+            --numParallelCollections.  --dbpath supports only the single
+            direct connection, so it always runs serially. */
+        int numParallelCollections();
+
+        /** open an additional connection to the same server for a worker
+            thread, authenticating like the main connection.  returns 0 and
+            sets errmsg on failure.  caller owns the result. */
+        mongo::DBClientBase * newConnection( const string& authDb , string& errmsg );
+
+        /** run fn( connection , ns , file ) over the job list from nThreads
+            worker threads, each with its own connection.  returns the number
+            of failures. */
+        typedef boost::function< void( DBClientBase& , const string& , const string& ) > ParallelJobFn;
+        int runParallelJobs( ParallelJobs& jobs , int nThreads , const string& authDb , ParallelJobFn fn );
+        void _parallelWorker( ParallelJobs * jobs , string authDb , ParallelJobFn fn );
+
         string _name;
 
         string _db;
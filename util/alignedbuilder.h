@@ -94,6 +94,14 @@ namespace mongo {
         /** @return the in-use length */
         unsigned len() const { return _len; }
 
+        /** exchange buffers with another builder - a cheap pointer swap.  used to
+            hand a filled buffer to the journal writer thread while keeping a
+            recycled one here to fill next. */
+        void swap(AlignedBuilder& r) {
+            std::swap(_p, r._p);
+            std::swap(_len, r._len);
+        }
+
     private:
         static const unsigned Alignment = 8192;
 
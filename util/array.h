@@ -65,6 +65,11 @@ namespace mongo {
         bool hasSpace() {
             return _size < _capacity;
         }
+
+        /** raw access -- usable as a random access iterator range with size() */
+        T* data() {
+            return _data;
+        }
         class iterator {
         public:
             iterator() {
@@ -24,50 +24,52 @@ namespace mongo {
 
         Alphabet alphabet;
 
-        void encode( stringstream& ss , const char * data , int size ) {
-            for ( int i=0; i<size; i+=3 ) {
-                int left = size - i;
-                const unsigned char * start = (const unsigned char*)data + i;
-
-                // byte 0
-                ss << alphabet.e(start[0]>>2);
-
-                // byte 1
-                unsigned char temp = ( start[0] << 4 );
-                if ( left == 1 ) {
-                    ss << alphabet.e(temp);
-                    break;
-                }
-                temp |= ( ( start[1] >> 4 ) & 0xF );
-                ss << alphabet.e(temp);
-
-                // byte 2
-                temp = ( start[1] & 0xF ) << 2;
-                if ( left == 2 ) {
-                    ss << alphabet.e(temp);
-                    break;
-                }
-                temp |= ( ( start[2] >> 6 ) & 0x3 );
-                ss << alphabet.e(temp);
-
-                // byte 3
-                ss << alphabet.e(start[2] & 0x3f);
+        void encode( char * out , const char * data , int size ) {
+            const unsigned char * in = (const unsigned char*)data;
+            int i = 0;
+            for ( ; i + 2 < size; i += 3 ) {
+                // three bytes in, four table probes, four stores
+                unsigned x = ( in[i] << 16 ) | ( in[i+1] << 8 ) | in[i+2];
+                *out++ = alphabet.e( x >> 18 );
+                *out++ = alphabet.e( x >> 12 );
+                *out++ = alphabet.e( x >> 6 );
+                *out++ = alphabet.e( x );
             }
-
-            int mod = size % 3;
-            if ( mod == 1 ) {
-                ss << "==";
+            switch ( size - i ) {
+            case 1:
+                *out++ = alphabet.e( in[i] >> 2 );
+                *out++ = alphabet.e( in[i] << 4 );
+                *out++ = '=';
+                *out = '=';
+                break;
+            case 2:
+                *out++ = alphabet.e( in[i] >> 2 );
+                *out++ = alphabet.e( ( in[i] << 4 ) | ( in[i+1] >> 4 ) );
+                *out++ = alphabet.e( in[i+1] << 2 );
+                *out = '=';
+                break;
             }
-            else if ( mod == 2 ) {
-                ss << "=";
+        }
+
+        void encode( stringstream& ss , const char * data , int size ) {
+            // chunked through a stack buffer - appending to the stream one
+            // character at a time dominated the cost for large bindata.
+            // the chunk is a multiple of 3 so only the final one pads.
+            const int ChunkIn = 3 * 1024;
+            char buf[ 4 * 1024 ];
+            for ( int i=0; i<size; i+=ChunkIn ) {
+                int n = size - i < ChunkIn ? size - i : ChunkIn;
+                encode( buf , data + i , n );
+                ss.write( buf , encodedLength( n ) );
             }
         }
 
 
         string encode( const char * data , int size ) {
-            stringstream ss;
-            encode( ss , data ,size );
-            return ss.str();
+            int outLen = encodedLength( size );
+            boost::scoped_array<char> buf( new char[outLen+1] );
+            encode( buf.get() , data , size );
+            return string( buf.get() , outLen );
         }
 
         string encode( const string& s ) {
@@ -75,33 +77,33 @@ namespace mongo {
         }
 
 
-        void decode( stringstream& ss , const string& s ) {
-            uassert( 10270 ,  "invalid base64" , s.size() % 4 == 0 );
-            const unsigned char * data = (const unsigned char*)s.c_str();
-            int size = s.size();
-
-            unsigned char buf[3];
-            for ( int i=0; i<size; i+=4) {
-                const unsigned char * start = data + i;
-                buf[0] = ( ( alphabet.decode[start[0]] << 2 ) & 0xFC ) | ( ( alphabet.decode[start[1]] >> 4 ) & 0x3 );
-                buf[1] = ( ( alphabet.decode[start[1]] << 4 ) & 0xF0 ) | ( ( alphabet.decode[start[2]] >> 2 ) & 0xF );
-                buf[2] = ( ( alphabet.decode[start[2]] << 6 ) & 0xC0 ) | ( ( alphabet.decode[start[3]] & 0x3F ) );
-
-                int len = 3;
-                if ( start[3] == '=' ) {
-                    len = 2;
-                    if ( start[2] == '=' ) {
-                        len = 1;
-                    }
-                }
-                ss.write( (const char*)buf , len );
+        int decode( char * out , const char * data , int size ) {
+            uassert( 10270 ,  "invalid base64" , size % 4 == 0 );
+            const unsigned char * in = (const unsigned char*)data;
+            char * start = out;
+            for ( int i=0; i<size; i+=4 ) {
+                const unsigned char * four = in + i;
+                *out++ = ( ( alphabet.decode[four[0]] << 2 ) & 0xFC ) | ( ( alphabet.decode[four[1]] >> 4 ) & 0x3 );
+                if ( four[2] == '=' )
+                    break;
+                *out++ = ( ( alphabet.decode[four[1]] << 4 ) & 0xF0 ) | ( ( alphabet.decode[four[2]] >> 2 ) & 0xF );
+                if ( four[3] == '=' )
+                    break;
+                *out++ = ( ( alphabet.decode[four[2]] << 6 ) & 0xC0 ) | ( alphabet.decode[four[3]] & 0x3F );
             }
+            return (int)( out - start );
+        }
+
+        void decode( stringstream& ss , const string& s ) {
+            boost::scoped_array<char> buf( new char[ s.size() / 4 * 3 + 1 ] );
+            int len = decode( buf.get() , s.c_str() , (int)s.size() );
+            ss.write( buf.get() , len );
         }
 
         string decode( const string& s ) {
-            stringstream ss;
-            decode( ss , s );
-            return ss.str();
+            boost::scoped_array<char> buf( new char[ s.size() / 4 * 3 + 1 ] );
+            int len = decode( buf.get() , s.c_str() , (int)s.size() );
+            return string( buf.get() , len );
         }
 
     }
@@ -55,10 +55,22 @@ namespace mongo {
         extern Alphabet alphabet;
 
 
+        /** @return number of characters encode() produces for size input bytes */
+        inline int encodedLength( int size ) { return 4 * ( ( size + 2 ) / 3 ); }
+
+        /** encode straight into a caller supplied buffer of at least
+            encodedLength(size) characters.  no terminator.  this is the kernel
+            behind the string/stream variants below. */
+        void encode( char * out , const char * data , int size );
+
         void encode( stringstream& ss , const char * data , int size );
         string encode( const char * data , int size );
         string encode( const string& s );
 
+        /** decode into a caller supplied buffer of at least size/4*3 bytes.
+            @return number of bytes written */
+        int decode( char * out , const char * data , int size );
+
         void decode( stringstream& ss , const string& s );
         string decode( const string& s );
 
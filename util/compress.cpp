@@ -24,8 +24,18 @@ namespace mongo {
         return snappy::Compress(input, input_length, output);
     }
 
-    bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed) { 
+    bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed) {
         return snappy::Uncompress(compressed, compressed_length, uncompressed);
     }
 
+    bool rawUncompress(const char* compressed, size_t compressed_length,
+                       char* uncompressed, size_t uncompressed_length) {
+        size_t len;
+        if ( !snappy::GetUncompressedLength(compressed, compressed_length, &len) )
+            return false;
+        if ( len != uncompressed_length )
+            return false;
+        return snappy::RawUncompress(compressed, compressed_length, uncompressed);
+    }
+
 }
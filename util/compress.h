@@ -10,6 +10,12 @@ namespace mongo {
 
     bool uncompress(const char* compressed, size_t compressed_length, std::string* uncompressed);
 
+    /** uncompress directly into a caller supplied buffer of exactly
+        uncompressed_length bytes.  fails (without writing) if the compressed
+        stream is corrupt or does not expand to exactly that length. */
+    bool rawUncompress(const char* compressed, size_t compressed_length,
+                       char* uncompressed, size_t uncompressed_length);
+
     size_t maxCompressedLength(size_t source_len);
     void rawCompress(const char* input,
         size_t input_length,
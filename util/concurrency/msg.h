@@ -18,8 +18,8 @@
 
 #pragma once
 
-#include <deque>
 #include "task.h"
+#include "../../bson/util/atomic_int.h"
 
 namespace mongo {
 
@@ -33,7 +33,7 @@ namespace mongo {
             /** send a message to the port */
             void send(lam);
 
-            Server(string name) : _name(name), rq(false) { }
+            Server(string name) : _head(0), _maxDepth(0), _warnDepth(1000), _parked(false), _name(name), rq(false) { }
             virtual ~Server() { }
 
             /** send message but block until function completes */
@@ -41,6 +41,13 @@ namespace mongo {
 
             void requeue() { rq = true; }
 
+            /** instantaneous queue depth - messages sent but not yet run */
+            unsigned depth() const { return _depth.get(); }
+
+            /** high water mark for depth() since startup.  maintained by the
+                consumer thread, so reads from elsewhere may lag slightly. */
+            unsigned maxDepth() const { return _maxDepth; }
+
         protected:
             /* REMINDER : for use in mongod, you will want to have this call Client::initThread(). */
             virtual void starting() { }
@@ -49,7 +56,23 @@ namespace mongo {
             virtual bool initClient() { return true; }
             virtual string name() const { return _name; }
             void doWork();
-            deque<lam> d;
+
+            struct Node {
+                Node *next;
+                lam msg;
+            };
+            Node* grabAll();
+
+            /* producers push onto this singly linked stack with one CAS; the
+               consumer takes the whole chain with another and reverses it into
+               send order.  the mutex/condition below are only for parking the
+               consumer when the queue is empty - nothing takes them per
+               message. */
+            Node * volatile _head;
+            AtomicUInt _depth;       // messages pushed but not yet run
+            unsigned _maxDepth;      // high water mark, consumer maintained
+            unsigned _warnDepth;     // next depth worth a log line
+            volatile bool _parked;   // consumer is (about to be) waiting on c
             boost::mutex m;
             boost::condition c;
             string _name;
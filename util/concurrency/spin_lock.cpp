@@ -25,6 +25,7 @@ namespace mongo {
     SpinLock::~SpinLock() {
 #if defined(_WIN32)
         DeleteCriticalSection(&_cs);
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
 #elif defined(__USE_XOPEN2K)
         pthread_spin_destroy(&_lock);
 #endif
@@ -33,10 +34,10 @@ namespace mongo {
     SpinLock::SpinLock()
 #if defined(_WIN32)
     { InitializeCriticalSectionAndSpinCount(&_cs, 4000); }
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+    : _nextTicket( 0 ) , _nowServing( 0 ) { }
 #elif defined(__USE_XOPEN2K)
     { pthread_spin_init( &_lock , 0 ); }
-#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
-    : _locked( false ) { }
 #else
     : _mutex( "SpinLock" ) { }
 #endif
@@ -44,25 +45,36 @@ namespace mongo {
     void SpinLock::lock() {
 #if defined(_WIN32)
         EnterCriticalSection(&_cs);
-#elif defined(__USE_XOPEN2K)
-        pthread_spin_lock( &_lock );
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
-        // fast path
-        if (!_locked && !__sync_lock_test_and_set(&_locked, true)) {
-            return;
-        }
+        // ticket lock - see the class comment.  lock holds are very short so the
+        // common case is served on the fast path below; under contention we spin
+        // with exponential backoff, capped, and then start sleeping so an
+        // oversubscribed box doesn't burn whole cores waiting.
+        unsigned ticket = __sync_fetch_and_add( &_nextTicket, 1 );
 
-        // wait for lock
-        int wait = 1000;
-        while ((wait-- > 0) && (_locked)) {}
+        if ( _nowServing == ticket )
+            return; // uncontended
 
-        // if failed to grab lock, sleep
-        struct timespec t;
-        t.tv_sec = 0;
-        t.tv_nsec = 5000000;
-        while (__sync_lock_test_and_set(&_locked, true)) {
-            nanosleep(&t, NULL);
+        int backoff = 1;
+        while ( _nowServing != ticket ) {
+            if ( backoff < 1024 ) {
+                for ( int i = 0; i < backoff; i++ ) {
+                    asm volatile ( "" ::: "memory" );
+                }
+                backoff <<= 1;
+            }
+            else {
+                // we've spun long enough - we're deep in line, so give the cpu
+                // away; our turn is still reserved by the ticket.
+                struct timespec t;
+                t.tv_sec = 0;
+                t.tv_nsec = 100000; // 100us
+                nanosleep( &t, NULL );
+            }
         }
+        __sync_synchronize(); // acquire
+#elif defined(__USE_XOPEN2K)
+        pthread_spin_lock( &_lock );
 #else
         // WARNING Missing spin lock in this platform. This can potentially
         // be slow.
@@ -74,10 +86,11 @@ namespace mongo {
     void SpinLock::unlock() {
 #if defined(_WIN32)
         LeaveCriticalSection(&_cs);
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+        __sync_synchronize(); // release
+        _nowServing = _nowServing + 1; // only the holder writes this
 #elif defined(__USE_XOPEN2K)
         pthread_spin_unlock(&_lock);
-#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
-        __sync_lock_release(&_locked);
 #else
         _mutex.unlock();
 #endif
@@ -86,10 +99,10 @@ namespace mongo {
     bool SpinLock::isfast() {
 #if defined(_WIN32)
         return true;
-#elif defined(__USE_XOPEN2K)
-        return true;
 #elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
         return true;
+#elif defined(__USE_XOPEN2K)
+        return true;
 #else
         return false;
 #endif
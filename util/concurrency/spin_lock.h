@@ -25,6 +25,12 @@ namespace mongo {
     /**
      * The spinlock currently requires late GCC support routines to be efficient.
      * Other platforms default to a mutex implemenation.
+     *
+     * On GCC platforms this is a ticket lock: waiters take a ticket and spin
+     * reading the now-serving counter until their number comes up.  That grants
+     * the lock in FIFO order (no starvation) and waiters only read while they
+     * wait, so the line isn't ping-ponged by a pack of threads all writing one
+     * word as with test-and-set.
      */
     class SpinLock : boost::noncopyable {
     public:
@@ -39,10 +45,11 @@ namespace mongo {
     private:
 #if defined(_WIN32)
         CRITICAL_SECTION _cs;
+#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
+        volatile unsigned _nextTicket;   // next ticket to hand to a waiter
+        volatile unsigned _nowServing;   // ticket currently holding the lock
 #elif defined(__USE_XOPEN2K)
         pthread_spinlock_t _lock;
-#elif defined(__GCC_HAVE_SYNC_COMPARE_AND_SWAP_4)
-        volatile bool _locked;
 #else
         // default to a mutex if not implemented
         SimpleMutex _mutex;
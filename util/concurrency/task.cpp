@@ -110,36 +110,92 @@ namespace mongo {
             }
         }
 
+        /* helpers for the mpsc queue.  CAS is a full barrier on both
+           platforms, which send() below relies on. */
+        static inline bool casPtr( void * volatile * slot , void * expected , void * v ) {
+#if defined(_WIN32)
+            return InterlockedCompareExchangePointer( slot , v , expected ) == expected;
+#else
+            return __sync_bool_compare_and_swap( slot , expected , v );
+#endif
+        }
+        static inline void fullBarrier() {
+#if defined(_WIN32)
+            MemoryBarrier();
+#else
+            __sync_synchronize();
+#endif
+        }
+
         void Server::send( lam msg ) {
-            {
+            Node *n = new Node();
+            n->msg = msg;
+            while( 1 ) {
+                Node *h = _head;
+                n->next = h;
+                if( casPtr( (void * volatile *)&_head , h , n ) )
+                    break;
+            }
+            _depth++;
+            // the CAS above is a full barrier, so if the consumer parked
+            // before our push we are guaranteed to observe _parked here
+            if( _parked ) {
                 boost::mutex::scoped_lock lk(m);
-                d.push_back(msg);
+                c.notify_one();
+            }
+        }
+
+        Server::Node* Server::grabAll() {
+            while( 1 ) {
+                Node *h = _head;
+                if( h == 0 )
+                    return 0;
+                if( casPtr( (void * volatile *)&_head , h , 0 ) )
+                    return h;
             }
-            c.notify_one();
         }
 
         void Server::doWork() {
             starting();
+            Node *batch = 0; // grabbed from _head and reversed into send order
             while( 1 ) {
-                lam f;
-                try {
-                    boost::mutex::scoped_lock lk(m);
-                    while( d.empty() )
-                        c.wait(lk);
-                    f = d.front();
-                    d.pop_front();
-                }
-                catch(...) {
-                    log() << "ERROR exception in Server:doWork?" << endl;
+                if( batch == 0 ) {
+                    Node *all = grabAll();
+                    if( all == 0 ) {
+                        boost::mutex::scoped_lock lk(m);
+                        _parked = true;
+                        fullBarrier(); // _parked must be visible before we recheck
+                        if( _head == 0 )
+                            c.wait(lk);
+                        _parked = false;
+                        continue;
+                    }
+                    // the stack is newest first; reverse so we run in send order
+                    while( all ) {
+                        Node *next = all->next;
+                        all->next = batch;
+                        batch = all;
+                        all = next;
+                    }
+                    unsigned depth = _depth.get();
+                    if( depth > _maxDepth ) {
+                        _maxDepth = depth;
+                        if( depth >= _warnDepth ) {
+                            log() << "task " << name() << " queue depth " << depth << endl;
+                            _warnDepth *= 2;
+                        }
+                    }
                 }
+                Node *n = batch;
+                batch = batch->next;
+                lam f = n->msg;
+                delete n;
+                _depth--;
                 try {
                     f();
                     if( rq ) {
                         rq = false;
-                        {
-                            boost::mutex::scoped_lock lk(m);
-                            d.push_back(f);
-                        }
+                        send(f);
                     }
                 }
                 catch(std::exception& e) {
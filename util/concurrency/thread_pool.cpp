@@ -18,46 +18,76 @@
 
 #include "pch.h"
 #include "thread_pool.h"
-#include "mvar.h"
+#include "spin_lock.h"
 
 namespace mongo {
     namespace threadpool {
 
-        // Worker thread
+        // Worker thread with its own task deque.  the owner pops oldest first
+        // (fifo), thieves steal newest from the other end, so a stolen task is
+        // the one least likely to be cache-warm for the owner anyway.
         class Worker : boost::noncopyable {
         public:
             explicit Worker(ThreadPool& owner)
                 : _owner(owner)
-                , _is_done(true)
-                , _thread(boost::bind(&Worker::loop, this))
             {}
 
-            // destructor will block until current operation is completed
+            // destructor will block until the thread exits its loop
             // Acts as a "join" on this thread
             ~Worker() {
-                _task.put(Task());
-                _thread.join();
+                if( _thread )
+                    _thread->join();
             }
 
-            void set_task(Task& func) {
-                assert(!func.empty());
-                assert(_is_done);
-                _is_done = false;
+            // start after all workers are constructed -- the loop scans the
+            // owner's worker list when stealing
+            void start() {
+                _thread.reset( new boost::thread( boost::bind( &Worker::loop, this ) ) );
+            }
 
-                _task.put(func);
+            void push(Task& task) {
+                scoped_spinlock lk(_lock);
+                _q.push_back(task);
             }
 
-        private:
-            ThreadPool& _owner;
-            MVar<Task> _task;
-            bool _is_done; // only used for error detection
-            boost::thread _thread;
+            // owner's end of the deque
+            bool pop(Task& task) {
+                scoped_spinlock lk(_lock);
+                if( _q.empty() )
+                    return false;
+                task = _q.front();
+                _q.pop_front();
+                return true;
+            }
+
+            // thieves' end of the deque
+            bool steal(Task& task) {
+                scoped_spinlock lk(_lock);
+                if( _q.empty() )
+                    return false;
+                task = _q.back();
+                _q.pop_back();
+                return true;
+            }
 
+        private:
             void loop() {
-                while (true) {
-                    Task task = _task.take();
-                    if (task.empty())
-                        break; // ends the thread
+                while( true ) {
+                    Task task;
+                    while( !pop(task) && !_owner.stealFor(this, task) ) {
+                        // nothing queued anywhere.  park -- but recheck with the
+                        // sleep mutex held so a schedule() racing with our scan
+                        // cannot slip by unnoticed (it checks _nSleeping after
+                        // pushing, and we only bump _nSleeping under the mutex).
+                        scoped_lock lk(_owner._sleepMutex);
+                        if( _owner._shuttingDown )
+                            return;
+                        if( pop(task) || _owner.stealFor(this, task) )
+                            break;
+                        _owner._nSleeping++;
+                        _owner._wakeup.wait(lk.boost());
+                        _owner._nSleeping--;
+                    }
 
                     try {
                         task();
@@ -68,73 +98,80 @@ namespace mongo {
                     catch (...) {
                         log() << "Unhandled non-exception in worker thread" << endl;
                     }
-                    _is_done = true;
-                    _owner.task_done(this);
+                    _owner.task_done();
                 }
             }
+
+            ThreadPool& _owner;
+            SpinLock _lock;
+            list<Task> _q;
+            boost::scoped_ptr<boost::thread> _thread;
         };
 
         ThreadPool::ThreadPool(int nThreads)
-            : _mutex("ThreadPool"), _tasksRemaining(0)
+            : _sleepMutex("ThreadPool"), _shuttingDown(false)
             , _nThreads(nThreads) {
-            scoped_lock lock(_mutex);
-            while (nThreads-- > 0) {
-                Worker* worker = new Worker(*this);
-                _freeWorkers.push_front(worker);
-            }
+            for( int i = 0; i < nThreads; i++ )
+                _workers.push_back( new Worker(*this) );
+            for( unsigned i = 0; i < _workers.size(); i++ )
+                _workers[i]->start();
         }
 
         ThreadPool::~ThreadPool() {
             join();
 
-            assert(_tasks.empty());
-
-            // O(n) but n should be small
-            assert(_freeWorkers.size() == (unsigned)_nThreads);
-
-            while(!_freeWorkers.empty()) {
-                delete _freeWorkers.front();
-                _freeWorkers.pop_front();
+            {
+                scoped_lock lk(_sleepMutex);
+                _shuttingDown = true;
+                _wakeup.notify_all();
             }
+
+            for( unsigned i = 0; i < _workers.size(); i++ )
+                delete _workers[i];
+            _workers.clear();
         }
 
         void ThreadPool::join() {
-            scoped_lock lock(_mutex);
-            while(_tasksRemaining) {
-                _condition.wait(lock.boost());
+            scoped_lock lk(_sleepMutex);
+            while( _tasksRemaining ) {
+                _poolIdle.wait(lk.boost());
             }
         }
 
         void ThreadPool::schedule(Task task) {
-            scoped_lock lock(_mutex);
-
             _tasksRemaining++;
 
-            if (!_freeWorkers.empty()) {
-                _freeWorkers.front()->set_task(task);
-                _freeWorkers.pop_front();
+            // striped submission: touch a single worker's spinlock, round robin,
+            // rather than a pool-wide mutex
+            unsigned i = _nextQueue++ % _workers.size();
+            _workers[i]->push(task);
+
+            wake_one();
+        }
+
+        void ThreadPool::wake_one() {
+            if( _nSleeping > 0 ) {
+                scoped_lock lk(_sleepMutex);
+                _wakeup.notify_one();
             }
-            else {
-                _tasks.push_back(task);
+        }
+
+        bool ThreadPool::stealFor(Worker* thief, Task& task) {
+            for( unsigned i = 0; i < _workers.size(); i++ ) {
+                if( _workers[i] == thief )
+                    continue;
+                if( _workers[i]->steal(task) )
+                    return true;
             }
+            return false;
         }
 
         // should only be called by a worker from the worker thread
-        void ThreadPool::task_done(Worker* worker) {
-            scoped_lock lock(_mutex);
-
-            if (!_tasks.empty()) {
-                worker->set_task(_tasks.front());
-                _tasks.pop_front();
+        void ThreadPool::task_done() {
+            if( --_tasksRemaining == 0 ) {
+                scoped_lock lk(_sleepMutex);
+                _poolIdle.notify_all();
             }
-            else {
-                _freeWorkers.push_front(worker);
-            }
-
-            _tasksRemaining--;
-
-            if(_tasksRemaining == 0)
-                _condition.notify_all();
         }
 
     } //namespace threadpool
@@ -22,6 +22,8 @@
 #undef assert
 #define assert MONGO_assert
 
+#include "../../bson/util/atomic_int.h"
+
 namespace mongo {
 
     namespace threadpool {
@@ -29,6 +31,15 @@ namespace mongo {
 
         typedef boost::function<void(void)> Task; //nullary function or functor
 
+        /** a pool of worker threads with per-worker task deques and work stealing.
+
+            scheduling stripes tasks round robin over the workers' deques, so
+            concurrent schedule() callers touch different (spin) locks rather than
+            serializing on one pool-wide mutex; a pool-wide mutex is only taken to
+            park and wake idle workers and in join().  an idle worker steals the
+            newest task from the back of another worker's deque, leaving the older
+            entries for their owner.
+        */
         // exported to the mongo namespace
         class ThreadPool : boost::noncopyable {
         public:
@@ -62,16 +73,27 @@ namespace mongo {
             int tasks_remaining() { return _tasksRemaining; }
 
         private:
-            mongo::mutex _mutex;
-            boost::condition _condition;
+            // scan the other workers' deques for something to run.  called by an
+            // idle worker (from its own thread) after its deque came up empty.
+            bool stealFor(Worker* thief, Task& task);
 
-            list<Worker*> _freeWorkers; //used as LIFO stack (always front)
-            list<Task> _tasks; //used as FIFO queue (push_back, pop_front)
-            int _tasksRemaining; // in queue + currently processing
+            // should only be called by a worker from the worker's thread
+            void task_done();
+
+            // wake a parked worker if there is one.  cheap (no lock) when all
+            // workers are already running.
+            void wake_one();
+
+            vector<Worker*> _workers;
+            AtomicUInt _tasksRemaining; // in queues + currently processing
+            AtomicUInt _nextQueue;      // round robin cursor for schedule()
+            AtomicUInt _nSleeping;      // workers parked on _wakeup
+            mongo::mutex _sleepMutex;   // guards parking/waking and join() only
+            boost::condition _wakeup;   // idle workers park here
+            boost::condition _poolIdle; // join() waits here
+            bool _shuttingDown;
             int _nThreads; // only used for sanity checking. could be removed in the future.
 
-            // should only be called by a worker from the worker's thread
-            void task_done(Worker* worker);
             friend class Worker;
         };
 
@@ -72,7 +72,7 @@ namespace mongo {
         // no-op
     }
 
-    void FileAllocator::ensureLength(int fd , long size) {
+    void FileAllocator::ensureLength(int fd , long size, const string &name ) {
         // we don't zero on windows
         // TODO : we should to avoid fragmentation
     }
@@ -81,6 +81,10 @@ namespace mongo {
         return false;
     }
 
+    int FileAllocator::pendingAllocations() const {
+        return 0;
+    }
+
 #else
 
     FileAllocator::FileAllocator()
@@ -124,6 +128,7 @@ namespace mongo {
             ++i;
             _pending.insert( i, name );
         }
+        _urgent.insert( name ); // tells the worker to stop throttling this one
         _pendingUpdated.notify_all();
         while( inProgress( name ) ) {
             checkFailure();
@@ -140,11 +145,11 @@ namespace mongo {
             _pendingUpdated.wait( lk.boost() );
     }
 
-    void FileAllocator::ensureLength(int fd , long size) {
+    void FileAllocator::ensureLength(int fd , long size, const string &name ) {
 #if defined(__linux__)
         int ret = posix_fallocate(fd,0,size);
         if ( ret == 0 )
-            return;
+            return; // no data writes happened - nothing worth throttling
 
         log() << "FileAllocator: posix_fallocate failed: " << errnoWithDescription( ret ) << " falling back" << endl;
 #endif
@@ -177,6 +182,13 @@ namespace mongo {
                 int written = write( fd , buf , towrite );
                 uassert( 10443 , errnoWithPrefix("FileAllocator: file write failed" ), written > 0 );
                 left -= written;
+
+                // pace background zero filling to roughly 32mb/s so runway
+                // top-up doesn't fight live writes for the disk.  if a writer
+                // starts waiting on this file we notice on the next chunk and
+                // go full speed.
+                if ( left > 0 && ! urgent( name ) )
+                    sleepmillis( 8 );
             }
         }
     }
@@ -185,6 +197,18 @@ namespace mongo {
         return _failed;
     }
 
+    int FileAllocator::pendingAllocations() const {
+        scoped_lock lk( _pendingMutex );
+        return (int) _pending.size();
+    }
+
+    bool FileAllocator::urgent( const string &name ) const {
+        if ( name.empty() )
+            return true;
+        scoped_lock lk( _pendingMutex );
+        return _urgent.count( name ) > 0;
+    }
+
     void FileAllocator::checkFailure() {
         if (_failed) {
             // we want to log the problem (diskfull.js expects it) but we do not want to dump a stack tracke
@@ -264,7 +288,7 @@ namespace mongo {
                     Timer t;
 
                     /* make sure the file is the full desired length */
-                    ensureLength( fd , size );
+                    fa->ensureLength( fd , size , name );
 
                     close( fd );
                     fd = 0;
@@ -310,6 +334,7 @@ namespace mongo {
                     scoped_lock lk( fa->_pendingMutex );
                     fa->_pendingSize.erase( name );
                     fa->_pending.pop_front();
+                    fa->_urgent.erase( name );
                     fa->_pendingUpdated.notify_all();
                 }
             }
@@ -47,10 +47,18 @@ namespace mongo {
         void allocateAsap( const string &name, unsigned long long &size );
 
         void waitUntilFinished() const;
-        
+
         bool hasFailed() const;
 
-        static void ensureLength(int fd , long size);
+        /** @return number of requested allocations not yet completed (for serverStatus) */
+        int pendingAllocations() const;
+
+        /** make sure the file is size bytes long, zero filling if necessary.
+            @param name if nonempty, zero filling is paced while no thread is
+              blocked on this file in allocateAsap() - i.e. while we are just
+              topping up the preallocation runway - so background allocation
+              doesn't saturate the disk under live traffic */
+        void ensureLength(int fd , long size, const string &name = "" );
 
         /** @return the singletone */
         static FileAllocator * get();
@@ -69,6 +77,10 @@ namespace mongo {
         // caller must hold pendingMutex_ lock.
         bool inProgress( const string &name ) const;
 
+        // true if a thread is blocked on this file in allocateAsap().
+        // empty name (direct ensureLength call) counts as urgent.
+        bool urgent( const string &name ) const;
+
         /** called from the worked thread */
         static void run( FileAllocator * fa );
 
@@ -77,6 +89,7 @@ namespace mongo {
 
         list< string > _pending;
         mutable map< string, long > _pendingSize;
+        set< string > _urgent; // files someone is blocked on in allocateAsap()
 
         bool _failed;
 #endif
@@ -33,35 +33,63 @@ namespace mongo {
         return (char)(( fromHex( c[ 0 ] ) << 4 ) | fromHex( c[ 1 ] ));
     }
 
-    inline string toHex(const void* inRaw, int len) {
-        static const char hexchars[] = "0123456789ABCDEF";
-
-        StringBuilder out;
-        const char* in = reinterpret_cast<const char*>(inRaw);
-        for (int i=0; i<len; ++i) {
-            char c = in[i];
-            char hi = hexchars[(c & 0xF0) >> 4];
-            char lo = hexchars[(c & 0x0F)];
+    /* both hex digits of every byte value, precomputed.  encoding is then one
+       table probe and two character stores per input byte instead of two
+       shifts, two probes and two builder appends. */
+    struct HexTables {
+        char upper[512];
+        char lower[512];
+        HexTables() {
+            const char * U = "0123456789ABCDEF";
+            const char * L = "0123456789abcdef";
+            for ( int i=0; i<256; i++ ) {
+                upper[i*2]   = U[ i >> 4 ];
+                upper[i*2+1] = U[ i & 0xF ];
+                lower[i*2]   = L[ i >> 4 ];
+                lower[i*2+1] = L[ i & 0xF ];
+            }
+        }
+    };
+    inline const HexTables& hexTables() {
+        // a race on first use just builds the table twice with the same values
+        static HexTables t;
+        return t;
+    }
 
-            out << hi << lo;
+    /** hex encode straight into a caller supplied buffer.
+        writes 2*len characters, no terminator. */
+    inline void toHex( const void* inRaw , int len , char* out , bool lower = false ) {
+        const char * table = lower ? hexTables().lower : hexTables().upper;
+        const unsigned char * in = reinterpret_cast<const unsigned char*>( inRaw );
+        for ( int i=0; i<len; ++i ) {
+            const char * p = table + in[i] * 2;
+            *out++ = p[0];
+            *out++ = p[1];
         }
+    }
 
+    inline string _hexEncode( const void* inRaw , int len , bool lower ) {
+        char buf[128];
+        if ( len <= 64 ) {
+            toHex( inRaw , len , buf , lower );
+            return string( buf , 2 * len );
+        }
+        // large inputs (bindata dumps) go through a builder, a chunk at a time
+        StringBuilder out( 2 * len + 1 );
+        const char * in = reinterpret_cast<const char*>( inRaw );
+        for ( int i=0; i<len; i+=64 ) {
+            int n = len - i < 64 ? len - i : 64;
+            toHex( in + i , n , buf , lower );
+            out.write( buf , 2 * n );
+        }
         return out.str();
     }
 
-    inline string toHexLower(const void* inRaw, int len) {
-        static const char hexchars[] = "0123456789abcdef";
-
-        StringBuilder out;
-        const char* in = reinterpret_cast<const char*>(inRaw);
-        for (int i=0; i<len; ++i) {
-            char c = in[i];
-            char hi = hexchars[(c & 0xF0) >> 4];
-            char lo = hexchars[(c & 0x0F)];
-
-            out << hi << lo;
-        }
+    inline string toHex(const void* inRaw, int len) {
+        return _hexEncode( inRaw , len , false );
+    }
 
-        return out.str();
+    inline string toHexLower(const void* inRaw, int len) {
+        return _hexEncode( inRaw , len , true );
     }
 }
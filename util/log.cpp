@@ -20,6 +20,7 @@
 #include "assert_util.h"
 #include "assert.h"
 #include <cmath>
+#include <deque>
 #include "time_support.h"
 using namespace std;
 
@@ -149,4 +150,80 @@ namespace mongo {
     // done *before* static initialization
     FILE* Logstream::logfile = stdout;
 
+    // ---- asynchronous log flushing ----
+
+    volatile bool Logstream::_asyncFlush = false;
+
+    namespace {
+        mongo::mutex logQueueMutex("logQueue");
+        boost::condition logQueueNotEmpty;
+        deque<string> logQueue;          // guarded by logQueueMutex
+        size_t logQueueBytes = 0;        // bytes queued, for the bound below
+        long long logQueueDropped = 0;   // lines discarded because the queue was full
+        bool logWriterStarted = false;
+        enum { MaxLogQueueBytes = 4 * 1024 * 1024 };
+    }
+
+    bool Logstream::_asyncEnqueue( const string& line ) {
+        scoped_lock lk( logQueueMutex );
+        if ( ! logWriterStarted )
+            return false; // enabled but thread not up yet; write synchronously
+        if ( logQueueBytes + line.size() > MaxLogQueueBytes ) {
+            logQueueDropped++;
+            return true; // counted; the writer reports the gap
+        }
+        logQueueBytes += line.size();
+        logQueue.push_back( line );
+        logQueueNotEmpty.notify_one();
+        return true;
+    }
+
+    void Logstream::_asyncWriter() {
+        setThreadName( "logwriter" );
+        deque<string> todo;
+        long long reported = 0;
+        while ( 1 ) {
+            todo.clear();
+            long long dropped;
+            {
+                scoped_lock lk( logQueueMutex );
+                while ( logQueue.empty() )
+                    logQueueNotEmpty.wait( lk.boost() );
+                logQueue.swap( todo );
+                logQueueBytes = 0;
+                dropped = logQueueDropped;
+            }
+            for ( deque<string>::const_iterator i = todo.begin(); i != todo.end(); ++i ) {
+                if ( i->size() && fwrite( i->data() , i->size() , 1 , logfile ) != 1 ) {
+                    int x = errno;
+                    cout << "Failed to write to logfile: " << errnoWithDescription(x) << endl;
+                }
+            }
+            if ( dropped > reported ) {
+                char buf[128];
+                int n = sprintf( buf , "log queue full - %lld line(s) dropped\n" , dropped - reported );
+                fwrite( buf , n , 1 , logfile );
+                reported = dropped;
+            }
+            // one flush per drain rather than one per line
+            fflush( logfile );
+        }
+    }
+
+    void Logstream::setAsyncFlush( bool on ) {
+        if ( on ) {
+            scoped_lock lk( logQueueMutex );
+            if ( ! logWriterStarted ) {
+                boost::thread t( _asyncWriter );
+                logWriterStarted = true;
+            }
+        }
+        _asyncFlush = on;
+    }
+
+    long long Logstream::asyncDropped() {
+        scoped_lock lk( logQueueMutex );
+        return logQueueDropped;
+    }
+
 }
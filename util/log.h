@@ -197,12 +197,37 @@ namespace mongo {
     class Logstream : public Nullstream {
         static mongo::mutex mutex;
         static int doneSetup;
-        stringstream ss;
+        // per-thread line buffer.  StringBuilder formats numbers with sprintf
+        // rather than dragging locale machinery through every operator, and the
+        // underlying block is reused line to line (trimmed back in _init())
+        StringBuilder ss;
+        bool hexMode; // ios 'hex' manipulator state for the integer appends below
         int indent;
         LogLevel logLevel;
         static FILE* logfile;
         static boost::scoped_ptr<ostream> stream;
         static vector<Tee*> * globalTees;
+
+        Logstream& _num( long long x ) {
+            if ( hexMode ) return _hexnum( (unsigned long long)x );
+            ss << x;
+            return *this;
+        }
+        Logstream& _unum( unsigned long long x ) {
+            if ( hexMode ) return _hexnum( x );
+            ss << x;
+            return *this;
+        }
+        Logstream& _hexnum( unsigned long long x ) {
+            char tmp[24];
+            ss.write( tmp , sprintf( tmp , "%llx" , x ) );
+            return *this;
+        }
+        Logstream& _ptr( const void *x ) {
+            char tmp[32];
+            ss.write( tmp , sprintf( tmp , "%p" , x ) );
+            return *this;
+        }
     public:
         inline static void logLockless( const StringData& s );
 
@@ -237,21 +262,21 @@ namespace mongo {
         /** note these are virtual */
         Logstream& operator<<(const char *x) { ss << x; return *this; }
         Logstream& operator<<(const string& x) { ss << x; return *this; }
-        Logstream& operator<<(const StringData& x) { ss << x.data(); return *this; }
-        Logstream& operator<<(char *x)       { ss << x; return *this; }
+        Logstream& operator<<(const StringData& x) { ss << x; return *this; }
+        Logstream& operator<<(char *x)       { ss << (const char*)x; return *this; }
         Logstream& operator<<(char x)        { ss << x; return *this; }
-        Logstream& operator<<(int x)         { ss << x; return *this; }
-        Logstream& operator<<(ExitCode x)    { ss << x; return *this; }
-        Logstream& operator<<(long x)          { ss << x; return *this; }
-        Logstream& operator<<(unsigned long x) { ss << x; return *this; }
-        Logstream& operator<<(unsigned x)      { ss << x; return *this; }
-        Logstream& operator<<(unsigned short x){ ss << x; return *this; }
+        Logstream& operator<<(int x)         { return _num( x ); }
+        Logstream& operator<<(ExitCode x)    { return _num( x ); }
+        Logstream& operator<<(long x)          { return _num( x ); }
+        Logstream& operator<<(unsigned long x) { return _unum( x ); }
+        Logstream& operator<<(unsigned x)      { return _unum( x ); }
+        Logstream& operator<<(unsigned short x){ return _unum( x ); }
         Logstream& operator<<(double x)        { ss << x; return *this; }
-        Logstream& operator<<(void *x)         { ss << x; return *this; }
-        Logstream& operator<<(const void *x)   { ss << x; return *this; }
-        Logstream& operator<<(long long x)     { ss << x; return *this; }
-        Logstream& operator<<(unsigned long long x) { ss << x; return *this; }
-        Logstream& operator<<(bool x)               { ss << x; return *this; }
+        Logstream& operator<<(void *x)         { return _ptr( x ); }
+        Logstream& operator<<(const void *x)   { return _ptr( x ); }
+        Logstream& operator<<(long long x)     { return _num( x ); }
+        Logstream& operator<<(unsigned long long x) { return _unum( x ); }
+        Logstream& operator<<(bool x)               { return _num( x ? 1 : 0 ); }
 
         Logstream& operator<<(const LazyString& x) {
             ss << x.val();
@@ -267,8 +292,12 @@ namespace mongo {
             flush(0);
             return *this;
         }
-        Logstream& operator<< (ios_base& (*_hex)(ios_base&)) {
-            ss << _hex;
+        Logstream& operator<< (ios_base& (*f)(ios_base&)) {
+            // hex and dec are the only stream manipulators used with log streams
+            if ( f == (ios_base& (*)(ios_base&)) std::hex )
+                hexMode = true;
+            else if ( f == (ios_base& (*)(ios_base&)) std::dec )
+                hexMode = false;
             return *this;
         }
 
@@ -293,10 +322,27 @@ namespace mongo {
             _init();
         }
         void _init() {
-            ss.str("");
+            ss.reset( 4096 ); // reuse the block, but don't let one huge line pin memory forever
+            hexMode = false;
             logLevel = LL_INFO;
         }
+
+        static volatile bool _asyncFlush;
+        /** queue a formatted line for the background writer.
+            @return false if the writer isn't running (caller writes synchronously).
+            a full queue drops the line and counts it - see asyncDropped(). */
+        static bool _asyncEnqueue( const string& line );
+        static void _asyncWriter();
     public:
+        /** when enabled, flush() hands formatted lines to a background writer
+            through a bounded queue instead of fwrite+fflush on the logging
+            thread.  lines of LL_ERROR and worse still write synchronously so
+            they are on disk if we crash right after. */
+        static void setAsyncFlush( bool on );
+        static bool asyncFlush() { return _asyncFlush; }
+        /** lines discarded because the async queue was full */
+        static long long asyncDropped();
+
         static Logstream& get() {
             if ( StaticObserver::_destroyingStatics ) {
                 cout << "Logstream::get called in uninitialized state" << endl;
@@ -500,7 +546,11 @@ namespace mongo {
 #ifndef _WIN32
             //syslog( LOG_INFO , "%s" , cc );
 #endif
-            if(fwrite(out.data(), out.size(), 1, logfile)) {
+            if ( _asyncFlush && logLevel < LL_ERROR && _asyncEnqueue( out ) ) {
+                // handed to the background writer; errors and worse bypass the
+                // queue so they reach the disk even if we go down right after
+            }
+            else if(fwrite(out.data(), out.size(), 1, logfile)) {
                 fflush(logfile);
             }
             else {
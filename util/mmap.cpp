@@ -22,6 +22,11 @@
 #include "../db/namespace.h"
 #include "../db/cmdline.h"
 
+#if defined(__linux__)
+#include <unistd.h>
+#include <sys/syscall.h>
+#endif
+
 namespace mongo {
 
     set<MongoFile*> MongoFile::mmfiles;
@@ -159,6 +164,47 @@ namespace mongo {
         return seen.size();
     }
 
+    /*static*/ int MongoFile::flushAllPaced( int spreadMillis ) {
+        notifyPreFlush();
+
+        int nFiles;
+        {
+            RWLockRecursive::Shared lk(mmmutex);
+            nFiles = mmfiles.size();
+        }
+        int pause = nFiles > 1 ? spreadMillis / nFiles : 0;
+
+        set<MongoFile*> seen;
+        while ( true ) {
+            auto_ptr<Flushable> f;
+            {
+                RWLockRecursive::Shared lk(mmmutex);
+                for ( set<MongoFile*>::iterator i = mmfiles.begin(); i != mmfiles.end(); i++ ) {
+                    MongoFile * mmf = *i;
+                    if ( ! mmf )
+                        continue;
+                    if ( seen.count( mmf ) )
+                        continue;
+                    f.reset( mmf->prepareFlush() );
+                    seen.insert( mmf );
+                    break;
+                }
+            }
+            if ( ! f.get() )
+                break;
+
+            f->flush();
+
+            // spread the io out rather than hammering the controller with
+            // every file's writeback at once
+            if ( pause > 0 && ! inShutdown() )
+                sleepmillis( pause );
+        }
+
+        notifyPostFlush();
+        return seen.size();
+    }
+
     void MongoFile::created() {
         RWLockRecursive::Exclusive lk(mmmutex);
         mmfiles.insert(this);
@@ -173,6 +219,64 @@ namespace mongo {
         ptf = this;
     }
 
+#if defined(__linux__)
+    /* --numaInterleave support.  mbind/set_mempolicy are linux-only and glibc
+       has no wrappers for them without libnuma, so we issue the syscalls
+       directly.  MPOL_INTERLEAVE spreads page allocations round-robin across
+       the nodes in the mask instead of piling them on the faulting thread's
+       node.
+    */
+    namespace {
+        const int MPOL_INTERLEAVE = 3;
+
+        // a bit set for each node present in /sys/devices/system/node.
+        // topology is fixed for the life of the process so compute it once.
+        unsigned long computeNumaNodeMask() {
+            unsigned long mask = 0;
+            for ( unsigned long i = 0; i < sizeof(mask) * 8; i++ ) {
+                char path[64];
+                sprintf( path , "/sys/devices/system/node/node%lu" , i );
+                if ( access( path , F_OK ) )
+                    break;
+                mask |= 1UL << i;
+            }
+            return mask;
+        }
+
+        unsigned long numaNodeMask() {
+            static unsigned long mask = computeNumaNodeMask();
+            return mask;
+        }
+
+        // zero or one node means there is nothing to spread
+        bool multipleNumaNodes() {
+            unsigned long m = numaNodeMask();
+            return m && ( m & ( m - 1 ) );
+        }
+    }
+
+    void numaInterleaveMemory( void* p , size_t len ) {
+        if ( ! multipleNumaNodes() )
+            return;
+        unsigned long mask = numaNodeMask();
+        if ( syscall( SYS_mbind , p , len , MPOL_INTERLEAVE , &mask , sizeof(mask) * 8 , 0 ) ) {
+            RARELY warning() << "mbind failed: " << errnoWithDescription() << endl;
+        }
+    }
+
+    void numaInterleaveThisThread() {
+        if ( ! multipleNumaNodes() )
+            return;
+        unsigned long mask = numaNodeMask();
+        if ( syscall( SYS_set_mempolicy , MPOL_INTERLEAVE , &mask , sizeof(mask) * 8 ) ) {
+            warning() << "set_mempolicy failed: " << errnoWithDescription() << endl;
+        }
+    }
+#else
+    void numaInterleaveMemory( void* , size_t ) { }
+    void numaInterleaveThisThread() { }
+#endif
+
 #if defined(_DEBUG)
     void MongoFile::markAllWritable() {
       if( cmdLine.dur )
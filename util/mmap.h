@@ -25,11 +25,30 @@ namespace mongo {
         void *_p;
         unsigned _len;
     public:
-        enum Advice { Sequential=1 };
-        MAdvise(void *p, unsigned len, Advice a); 
+        enum Advice { Sequential=1, Random=2 };
+        MAdvise(void *p, unsigned len, Advice a);
         ~MAdvise(); // destructor resets the range to MADV_NORMAL
+
+        /** non-scoped advice - stays in effect until flagged again.
+            @param a Advice, or 0 to reset the range to normal */
+        static void flag(void *p, unsigned long long len, int a);
+
+        /** hint that the range will be needed soon so the kernel starts
+            reading it in asynchronously.  best effort; no-op where
+            unsupported. */
+        static void willNeed(void *p, unsigned long long len);
     };
 
+    /* NUMA placement for --numaInterleave.  both are no-ops on platforms
+       without NUMA syscalls and on boxes with a single memory node. */
+
+    /** spread the pages of an existing mapping round-robin across all nodes */
+    void numaInterleaveMemory( void* p , size_t len );
+
+    /** make this thread - and any thread it subsequently spawns - allocate
+        memory round-robin across all nodes */
+    void numaInterleaveThisThread();
+
     /* the administrative-ish stuff here */
     class MongoFile : boost::noncopyable {
     public:
@@ -62,6 +81,11 @@ namespace mongo {
         static void (*notifyPostFlush)();
 
         static int flushAll( bool sync ); // returns n flushed
+        /** like flushAll(true), but sleeps between files so the msyncs are
+            spread across roughly spreadMillis instead of issued back to back.
+            keeps the background sync from bursting enough io to saturate the
+            controller.  @return n flushed */
+        static int flushAllPaced( int spreadMillis );
         static long long totalMappedLength();
         static void closeAllFiles( stringstream &message );
 
@@ -263,16 +287,16 @@ namespace mongo {
         }
     };
     extern ourbitset writable;
-    void makeChunkWritable(size_t chunkno);
-    inline void MemoryMappedFile::makeWritable(void *_p, unsigned len) {
-        size_t p = (size_t) _p;
-        unsigned a = p/ChunkSize;
-        unsigned b = (p+len)/ChunkSize;
-        for( unsigned i = a; i <= b; i++ ) {
-            if( !writable.get(i) ) {
-                makeChunkWritable(i);
-            }
-        }
+    void makeChunkWritable(size_t chunkno);
+    inline void MemoryMappedFile::makeWritable(void *_p, unsigned len) {
+        size_t p = (size_t) _p;
+        unsigned a = p/ChunkSize;
+        unsigned b = (p+len)/ChunkSize;
+        for( unsigned i = a; i <= b; i++ ) {
+            if( !writable.get(i) ) {
+                makeChunkWritable(i);
+            }
+        }
     }
 
 #endif
@@ -19,6 +19,7 @@
 #include "mmap.h"
 #include "file_allocator.h"
 #include "../db/concurrency.h"
+#include "../db/cmdline.h"
 #include <errno.h>
 #include <sys/mman.h>
 #include <sys/types.h>
@@ -61,14 +62,30 @@ namespace mongo {
 #if defined(__sunos__)
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
+    void MAdvise::flag(void *, unsigned long long, int) { }
+    void MAdvise::willNeed(void *, unsigned long long) { }
 #else
     MAdvise::MAdvise(void *p, unsigned len, Advice a) : _p(p), _len(len) {
-        assert( a == Sequential ); // more later
-        madvise(_p,_len,MADV_SEQUENTIAL);
+        flag(_p,_len,a);
     }
-    MAdvise::~MAdvise() { 
+    MAdvise::~MAdvise() {
         madvise(_p,_len,MADV_NORMAL);
     }
+    void MAdvise::flag(void *p, unsigned long long len, int a) {
+        int advice = MADV_NORMAL;
+        if ( a == Sequential )
+            advice = MADV_SEQUENTIAL;
+        else if ( a == Random )
+            advice = MADV_RANDOM;
+        if ( madvise(p,len,advice) ) {
+            DEV warning() << "madvise failed " << errnoWithDescription() << endl;
+        }
+    }
+    void MAdvise::willNeed(void *p, unsigned long long len) {
+        if ( madvise(p,len,MADV_WILLNEED) ) {
+            DEV warning() << "madvise willneed failed " << errnoWithDescription() << endl;
+        }
+    }
 #endif
 
     void* MemoryMappedFile::map(const char *filename, unsigned long long &length, int options) {
@@ -113,6 +130,9 @@ namespace mongo {
         }
 #endif
 
+        if ( cmdLine.numaInterleave )
+            numaInterleaveMemory( view , length );
+
         views.push_back( view );
 
         DEV if (! dbMutex.info().isLocked()) {
@@ -153,6 +173,9 @@ namespace mongo {
             return 0;
         }
 
+        if ( cmdLine.numaInterleave )
+            numaInterleaveMemory( x , len );
+
         views.push_back(x);
         return x;
     }
@@ -168,6 +191,9 @@ namespace mongo {
             abort();
         }
         assert( x == oldPrivateAddr );
+        // mapping over the region discarded the old vma policy
+        if ( cmdLine.numaInterleave )
+            numaInterleaveMemory( x , len );
         return x;
     }
 
@@ -28,6 +28,8 @@ namespace mongo {
 
     MAdvise::MAdvise(void *,unsigned, Advice) { }
     MAdvise::~MAdvise() { }
+    void MAdvise::flag(void *, unsigned long long, int) { }
+    void MAdvise::willNeed(void *, unsigned long long) { }
 
     /** notification on unmapping so we can clear writable bits */
     void MemoryMappedFile::clearWritableBits(void *p) {
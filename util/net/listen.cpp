@@ -57,6 +57,7 @@ namespace mongo {
     // ----- Listener -------
 
     const Listener* Listener::_timeTracker;
+    AtomicUInt Listener::_acceptCount;
 
     vector<SockAddr> ipToAddrs(const char* ips, int port, bool useUnixSockets) {
         vector<SockAddr> out;
@@ -97,7 +98,7 @@ namespace mongo {
     }
     
     Listener::Listener(const string& name, const string &ip, int port, bool logConnect ) 
-        : _port(port), _name(name), _ip(ip), _logConnect(logConnect), _elapsedTime(0) { 
+        : _port(port), _name(name), _ip(ip), _logConnect(logConnect), _elapsedTime(0), _nAcceptors(1) {
 #ifdef MONGO_SSL
         _ssl = 0;
         _sslPort = 0;
@@ -108,6 +109,18 @@ namespace mongo {
 #endif
     }
     
+    void Listener::setAcceptors( int n ) {
+#ifdef SO_REUSEPORT
+        if ( n < 1 )
+            n = 1;
+        if ( n > 8 )
+            n = 8;
+        _nAcceptors = n;
+#else
+        // without SO_REUSEPORT only one socket may bind the address
+#endif
+    }
+
     Listener::~Listener() {
         if ( _timeTracker == this )
             _timeTracker = 0;
@@ -158,6 +171,16 @@ namespace mongo {
             }
 #endif
 
+#ifdef SO_REUSEPORT
+            if ( _nAcceptors > 1 && me.getType() != AF_UNIX ) {
+                // every acceptor's socket needs this before bind() so the kernel
+                // will spread incoming connections across them
+                const int one = 1;
+                if ( setsockopt( sock , SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one)) < 0 )
+                    out() << "Failed to set socket opt, SO_REUSEPORT" << endl;
+            }
+#endif
+
             if ( ::bind(sock, me.raw(), me.addressSize) != 0 ) {
                 int x = errno;
                 error() << "listen(): bind() failed " << errnoWithDescription(x) << " for socket: " << me.toString() << endl;
@@ -190,25 +213,21 @@ namespace mongo {
         return true;
     }
     
-    void Listener::initAndListen() {
-        checkTicketNumbers();
-        vector<int> socks;
-        set<int> sslSocks;
-        
+    bool Listener::_setupAll( vector<int>& socks , set<int>& sslSocks , bool unixToo ) {
         { // normal sockets
-            vector<SockAddr> mine = ipToAddrs(_ip.c_str(), _port, (!cmdLine.noUnixSocket && useUnixSockets()));
+            vector<SockAddr> mine = ipToAddrs(_ip.c_str(), _port, (unixToo && !cmdLine.noUnixSocket && useUnixSockets()));
             if ( ! _setupSockets( mine , socks ) )
-                return;
+                return false;
         }
-        
+
 #ifdef MONGO_SSL
         if ( _ssl && _sslPort > 0 ) {
             unsigned prev = socks.size();
-            
+
             vector<SockAddr> mine = ipToAddrs(_ip.c_str(), _sslPort, false );
             if ( ! _setupSockets( mine , socks ) )
-                return;
-            
+                return false;
+
             for ( unsigned i=prev; i<socks.size(); i++ ) {
                 sslSocks.insert( socks[i] );
             }
@@ -216,12 +235,17 @@ namespace mongo {
         }
 #endif
 
-        SOCKET maxfd = 0; // needed for select()
-        for ( unsigned i=0; i<socks.size(); i++ ) {
-            if ( socks[i] > maxfd )
-                maxfd = socks[i];
-        }
-        
+        return true;
+    }
+
+    void Listener::initAndListen() {
+        checkTicketNumbers();
+        vector<int> socks;
+        set<int> sslSocks;
+
+        if ( ! _setupAll( socks , sslSocks , true ) )
+            return;
+
 #ifdef MONGO_SSL
         if ( _ssl == 0 ) {
             _logListen( _port , false );
@@ -238,13 +262,43 @@ namespace mongo {
         _logListen( _port , false );
 #endif
 
-        static long connNumber = 0;
+#ifdef SO_REUSEPORT
+        // extra acceptors, each with its own listening socket(s); the kernel
+        // distributes incoming connections across all of them
+        for ( int i = 1; i < _nAcceptors; i++ ) {
+            boost::thread t( boost::bind( &Listener::_acceptorThread , this ) );
+        }
+#endif
+
+        _acceptLoop( socks , sslSocks , true );
+    }
+
+    void Listener::_acceptorThread() {
+        setThreadName( "accept" );
+        vector<int> socks;
+        set<int> sslSocks;
+        if ( ! _setupAll( socks , sslSocks , false ) ) {
+            error() << "listen(): extra acceptor couldn't set up its sockets" << endl;
+            return;
+        }
+        _acceptLoop( socks , sslSocks , false );
+    }
+
+    static AtomicUInt connNumber;
+
+    void Listener::_acceptLoop( const vector<int>& socks , const set<int>& sslSocks , bool primary ) {
+        SOCKET maxfd = 0; // needed for select()
+        for ( unsigned i=0; i<socks.size(); i++ ) {
+            if ( socks[i] > maxfd )
+                maxfd = socks[i];
+        }
+
         struct timeval maxSelectTime;
         while ( ! inShutdown() ) {
             fd_set fds[1];
             FD_ZERO(fds);
-            
-            for (vector<int>::iterator it=socks.begin(), end=socks.end(); it != end; ++it) {
+
+            for (vector<int>::const_iterator it=socks.begin(), end=socks.end(); it != end; ++it) {
                 FD_SET(*it, fds);
             }
 
@@ -253,11 +307,13 @@ namespace mongo {
             const int ret = select(maxfd+1, fds, NULL, NULL, &maxSelectTime);
 
             if (ret == 0) {
+                if ( primary ) {
 #if defined(__linux__)
-                _elapsedTime += ( 10000 - maxSelectTime.tv_usec ) / 1000;
+                    _elapsedTime += ( 10000 - maxSelectTime.tv_usec ) / 1000;
 #else
-                _elapsedTime += 10;
+                    _elapsedTime += 10;
 #endif
+                }
                 continue;
             }
 
@@ -274,13 +330,15 @@ namespace mongo {
                 return;
             }
 
+            if ( primary ) {
 #if defined(__linux__)
-            _elapsedTime += max(ret, (int)(( 10000 - maxSelectTime.tv_usec ) / 1000));
+                _elapsedTime += max(ret, (int)(( 10000 - maxSelectTime.tv_usec ) / 1000));
 #else
-            _elapsedTime += ret; // assume 1ms to grab connection. very rough
+                _elapsedTime += ret; // assume 1ms to grab connection. very rough
 #endif
+            }
 
-            for (vector<int>::iterator it=socks.begin(), end=socks.end(); it != end; ++it) {
+            for (vector<int>::const_iterator it=socks.begin(), end=socks.end(); it != end; ++it) {
                 if (! (FD_ISSET(*it, fds)))
                     continue;
 
@@ -307,8 +365,9 @@ namespace mongo {
                 }
                 if (from.getType() != AF_UNIX)
                     disableNagle(s);
+                _acceptCount++;
                 if ( _logConnect && ! cmdLine.quiet )
-                    log() << "connection accepted from " << from.toString() << " #" << ++connNumber << endl;
+                    log() << "connection accepted from " << from.toString() << " #" << (unsigned)++connNumber << endl;
                 
                 Socket newSock = Socket(s, from);
 #ifdef MONGO_SSL
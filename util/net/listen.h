@@ -18,6 +18,7 @@
 #pragma once
 
 #include "sock.h"
+#include "../../bson/util/atomic_int.h"
 
 namespace mongo {
 
@@ -40,6 +41,12 @@ namespace mongo {
         void addSecurePort( SSLManager* manager , int additionalPort );
 #endif
 
+        /** accept with 'n' threads, each on its own SO_REUSEPORT listening socket,
+            so a connection storm is spread over several accept loops instead of
+            queueing on one.  call before initAndListen().  no-op on platforms
+            without SO_REUSEPORT and for unix domain sockets. */
+        void setAcceptors( int n );
+
         void initAndListen(); // never returns unless error (start a thread)
 
         /* spawn a thread, etc., then return */
@@ -69,24 +76,42 @@ namespace mongo {
             return 0;
         }
 
+        /** total connections accepted by all listeners since startup (for serverStatus) */
+        static long long acceptCount() { return (long long)(unsigned)_acceptCount; }
+
     private:
         string _name;
         string _ip;
         bool _logConnect;
         long long _elapsedTime;
-        
+        int _nAcceptors;
+
 #ifdef MONGO_SSL
         SSLManager* _ssl;
         int _sslPort;
 #endif
-        
+
         /**
          * @return true iff everything went ok
          */
         bool _setupSockets( const vector<SockAddr>& mine , vector<int>& socks );
-        
+
+        /** set up this listener's full socket complement (tcp, and unix/ssl where
+            configured).  @param unixToo false for extra acceptors, which must not
+            rebind the unix socket path */
+        bool _setupAll( vector<int>& socks , set<int>& sslSocks , bool unixToo );
+
+        /** accept connections until shutdown.  only the primary loop maintains
+            _elapsedTime - the extra acceptors would race on it. */
+        void _acceptLoop( const vector<int>& socks , const set<int>& sslSocks , bool primary );
+
+        /** body of an extra acceptor thread: bind its own sockets, then loop */
+        void _acceptorThread();
+
         void _logListen( int port , bool ssl );
 
+        static AtomicUInt _acceptCount;
+
         static const Listener* _timeTracker;
         
         virtual bool useUnixSockets() const { return false; }
@@ -30,6 +30,119 @@
 
 namespace mongo {
 
+    namespace {
+        const int NumClasses = 7;     // 1k, 2k, 4k, 8k, 16k, 32k, 64k
+        const int LocalMax = 4;       // buffers cached per class per thread
+        const int ReservoirMax = 64;  // buffers kept per class in the shared reservoir
+        const int PrefixSize = 8;     // holds the class index; keeps the payload 8 byte aligned
+
+        // class index for a request of the given size, or -1 if too big to pool
+        inline int classFor( int size ) {
+            int c = 0;
+            int sz = 1024;
+            while ( sz < size ) {
+                sz <<= 1;
+                c++;
+            }
+            return c < NumClasses ? c : -1;
+        }
+        inline int classSize( int c ) { return 1024 << c; }
+
+        /* pointers stored below are the malloc'd base (prefix included); the
+           class index is written into the prefix once at allocation time */
+
+        struct Reservoir {
+            Reservoir() : m("MsgBufPool") {}
+            mongo::mutex m;
+            vector<char*> bufs[NumClasses];
+        };
+        Reservoir& reservoir() {
+            static Reservoir r;
+            return r;
+        }
+
+        struct ThreadCache {
+            vector<char*> bufs[NumClasses];
+            ~ThreadCache() {
+                // hand our buffers to the reservoir on thread exit
+                Reservoir& r = reservoir();
+                scoped_lock lk( r.m );
+                for ( int c = 0; c < NumClasses; c++ ) {
+                    for ( unsigned i = 0; i < bufs[c].size(); i++ ) {
+                        if ( r.bufs[c].size() < (unsigned) ReservoirMax )
+                            r.bufs[c].push_back( bufs[c][i] );
+                        else
+                            free( bufs[c][i] );
+                    }
+                }
+            }
+        };
+        boost::thread_specific_ptr<ThreadCache> msgBufThreadCache;
+
+        ThreadCache& threadCache() {
+            ThreadCache * c = msgBufThreadCache.get();
+            if ( ! c ) {
+                c = new ThreadCache();
+                msgBufThreadCache.reset( c );
+            }
+            return *c;
+        }
+    }
+
+    char * MsgBufPool::get( int size ) {
+        int c = classFor( size );
+        if ( c < 0 ) {
+            // large outlier - not worth keeping around
+            char * p = (char *) malloc( size + PrefixSize );
+            assert( p );
+            *(int*)p = -1;
+            return p + PrefixSize;
+        }
+        ThreadCache& tc = threadCache();
+        if ( tc.bufs[c].empty() ) {
+            // refill the local cache from the shared reservoir
+            Reservoir& r = reservoir();
+            scoped_lock lk( r.m );
+            while ( ! r.bufs[c].empty() && tc.bufs[c].size() < (unsigned) LocalMax ) {
+                tc.bufs[c].push_back( r.bufs[c].back() );
+                r.bufs[c].pop_back();
+            }
+        }
+        if ( ! tc.bufs[c].empty() ) {
+            char * p = tc.bufs[c].back();
+            tc.bufs[c].pop_back();
+            return p + PrefixSize;
+        }
+        char * p = (char *) malloc( classSize( c ) + PrefixSize );
+        assert( p );
+        *(int*)p = c;
+        return p + PrefixSize;
+    }
+
+    void MsgBufPool::release( char * buf ) {
+        char * p = buf - PrefixSize;
+        int c = *(int*)p;
+        if ( c < 0 ) {
+            free( p );
+            return;
+        }
+        ThreadCache& tc = threadCache();
+        if ( tc.bufs[c].size() < (unsigned) LocalMax ) {
+            tc.bufs[c].push_back( p );
+            return;
+        }
+        // local cache full; try the shared reservoir
+        {
+            Reservoir& r = reservoir();
+            scoped_lock lk( r.m );
+            if ( r.bufs[c].size() < (unsigned) ReservoirMax ) {
+                r.bufs[c].push_back( p );
+                return;
+            }
+        }
+        free( p );
+    }
+
     void Message::send( MessagingPort &p, const char *context ) {
         if ( empty() ) {
             return;
@@ -56,6 +169,35 @@ namespace mongo {
         return msgid;
     }
 
+    static AtomicUInt traceIdCounter;
+    static boost::thread_specific_ptr<unsigned> threadTraceId;
+
+    unsigned newTraceId() {
+        // high bits seeded per process so ids from different clients rarely
+        // collide; 0 and -1 are excluded because they mean "no trace id"
+        static unsigned base = (unsigned) ( time(0) << 16 );
+        unsigned id;
+        do {
+            id = base + traceIdCounter++;
+        } while ( id == 0 || id == (unsigned) -1 );
+        return id;
+    }
+
+    unsigned currentTraceId() {
+        unsigned *p = threadTraceId.get();
+        return p ? *p : 0;
+    }
+
+    void setCurrentTraceId( unsigned id ) {
+        unsigned *p = threadTraceId.get();
+        if ( p == 0 ) {
+            if ( id == 0 )
+                return;
+            threadTraceId.reset( p = new unsigned );
+        }
+        *p = id;
+    }
+
     bool doesOpGetAResponse( int op ) {
         return op == dbQuery || op == dbGetMore;
     }
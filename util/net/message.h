@@ -104,6 +104,15 @@ namespace mongo {
     };
 #pragma pack()
 
+    /* MsgData::_flags bits.  flags only appear on the wire between peers that
+       negotiated them (see the setWireCompression command); older peers always
+       send zero here. */
+    enum MessageFlags {
+        /* the payload is a 4 byte uncompressed data length followed by the
+           snappy compressed data.  see MessagingPort::say/recv. */
+        MessageFlagCompressed = 1
+    };
+
 #pragma pack(1)
     /* todo merge this with MSGHEADER (or inherit from it). */
     struct MsgData {
@@ -150,15 +159,33 @@ namespace mongo {
     }
 #pragma pack()
 
+    /** size classed pool for message payload buffers.
+
+        every request used to cost a malloc in MessagingPort::recv and a free at
+        the end of the request - at high op rates that is allocator traffic (and
+        contention) for nothing, since the sizes repeat constantly.  get() and
+        release() run against a small per-thread cache backed by a shared
+        reservoir, so the steady state is a couple of pointer pops with no lock.
+        buffers bigger than the largest class (64k) bypass the pool and are
+        plain malloc/free underneath.
+    */
+    class MsgBufPool {
+    public:
+        /** @return a buffer of at least size bytes.  always pair with release(). */
+        static char * get( int size );
+        /** return a buffer obtained from get() */
+        static void release( char * buf );
+    };
+
     class Message {
     public:
         // we assume here that a vector with initial size 0 does no allocation (0 is the default, but wanted to make it explicit).
-        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ) {}
+        Message() : _buf( 0 ), _data( 0 ), _freeIt( false ), _fromPool( false ) {}
         Message( void * data , bool freeIt ) :
-            _buf( 0 ), _data( 0 ), _freeIt( false ) {
+            _buf( 0 ), _data( 0 ), _freeIt( false ), _fromPool( false ) {
             _setData( reinterpret_cast< MsgData* >( data ), freeIt );
         };
-        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ) {
+        Message(Message& r) : _buf( 0 ), _data( 0 ), _freeIt( false ), _fromPool( false ) {
             *this = r;
         }
         ~Message() {
@@ -228,13 +255,18 @@ namespace mongo {
             }
             r._freeIt = false;
             _freeIt = true;
+            _fromPool = r._fromPool;
+            r._fromPool = false;
             return *this;
         }
 
         void reset() {
             if ( _freeIt ) {
                 if ( _buf ) {
-                    free( _buf );
+                    if ( _fromPool )
+                        MsgBufPool::release( (char *) _buf );
+                    else
+                        free( _buf );
                 }
                 for( vector< pair< char *, int > >::const_iterator i = _data.begin(); i != _data.end(); ++i ) {
                     free(i->first);
@@ -243,6 +275,7 @@ namespace mongo {
             _buf = 0;
             _data.clear();
             _freeIt = false;
+            _fromPool = false;
         }
 
         // use to add a buffer
@@ -259,6 +292,7 @@ namespace mongo {
             }
             assert( _freeIt );
             if ( _buf ) {
+                assert( !_fromPool ); // _data entries are freed with plain free()
                 _data.push_back( make_pair( (char*)_buf, _buf->len ) );
                 _buf = 0;
             }
@@ -266,11 +300,32 @@ namespace mongo {
             header()->len += size;
         }
 
+        /** add a buffer the message does NOT own.  for scatter-gather sends: the
+            fragments go to the socket as iovecs (see Socket::send) with no
+            intermediate coalescing copy.  the caller guarantees the bytes stay
+            valid until send() returns and frees them itself; reset() leaves them
+            alone.  cannot be mixed with owned buffers, and the first fragment
+            must start with a MsgData header whose len covers all fragments. */
+        void appendExternalData( const char *d, int size ) {
+            assert( !_freeIt );
+            assert( _buf == 0 ); // mixing owned storage with borrowed fragments unsupported
+            if ( size <= 0 ) {
+                return;
+            }
+            _data.push_back( make_pair( const_cast< char * >( d ), size ) );
+        }
+
         // use to set first buffer if empty
         void setData(MsgData *d, bool freeIt) {
             assert( empty() );
             _setData( d, freeIt );
         }
+        /** take ownership of a buffer obtained from MsgBufPool::get() */
+        void setPooledData( MsgData *d ) {
+            assert( empty() );
+            _setData( d, true );
+            _fromPool = true;
+        }
         void setData(int operation, const char *msgtxt) {
             setData(operation, msgtxt, strlen(msgtxt)+1);
         }
@@ -303,10 +358,23 @@ namespace mongo {
         typedef vector< pair< char*, int > > MsgVec;
         MsgVec _data;
         bool _freeIt;
+        bool _fromPool; // _buf came from MsgBufPool and goes back there on reset()
     };
 
 
     MSGID nextMessageId();
 
+    /* trace ids correlate one logical client operation across tiers
+       (driver -> mongos -> mongod).  on the wire they ride in the responseTo
+       header field of request messages, which is otherwise always -1; peers
+       that know nothing about tracing send -1 (or 0) there and get no trace.
+       within a process the id follows the thread servicing the operation, so
+       outbound calls made on its behalf carry the same id.  mongod notes it
+       on the op and it comes out in the profiler and slow query log as
+       "traceid". */
+    unsigned newTraceId();
+    unsigned currentTraceId();
+    void setCurrentTraceId( unsigned id );
+
 
 } // namespace mongo
@@ -25,6 +25,7 @@
 #include "message_port.h"
 #include "listen.h"
 
+#include "../compress.h"
 #include "../goodies.h"
 #include "../background.h"
 #include "../time_support.h"
@@ -52,6 +53,10 @@ namespace mongo {
 // if you want trace output:
 #define mmm(x)
 
+    /* messages smaller than this go out uncompressed even on a compressed
+       connection - the snappy and header overhead isn't worth it */
+    const int CompressWireThreshold = 1024;
+
     /* messagingport -------------------------------------------------------------- */
 
     class PiggyBackData {
@@ -126,19 +131,19 @@ namespace mongo {
         ports.closeAll(mask);
     }
 
-    MessagingPort::MessagingPort(int fd, const SockAddr& remote) 
-        : Socket( fd , remote ) , piggyBackData(0) {
+    MessagingPort::MessagingPort(int fd, const SockAddr& remote)
+        : Socket( fd , remote ) , piggyBackData(0) , _compressOut(false) {
         ports.insert(this);
     }
 
-    MessagingPort::MessagingPort( double timeout, int ll ) 
-        : Socket( timeout, ll ) {
+    MessagingPort::MessagingPort( double timeout, int ll )
+        : Socket( timeout, ll ) , _compressOut(false) {
         ports.insert(this);
         piggyBackData = 0;
     }
 
     MessagingPort::MessagingPort( Socket& sock )
-        : Socket( sock ) , piggyBackData( 0 ) {
+        : Socket( sock ) , piggyBackData( 0 ) , _compressOut(false) {
     }
 
     void MessagingPort::shutdown() {
@@ -186,7 +191,7 @@ again:
 
             int z = (len+1023)&0xfffffc00;
             assert(z>=len);
-            MsgData *md = (MsgData *) malloc(z);
+            MsgData *md = (MsgData *) MsgBufPool::get(z);
             assert(md);
             md->len = len;
 
@@ -197,11 +202,19 @@ again:
                 Socket::recv( p, left );
             }
             catch (...) {
-                free(md);
+                MsgBufPool::release((char*)md);
                 throw;
             }
 
-            m.setData(md, true);
+            if ( md->_flags & MessageFlagCompressed ) {
+                md = _uncompress( md );
+                if ( md == 0 )
+                    return false;
+            }
+
+            m.setPooledData(md);
+            _connOps++;
+            _connBytesIn += len;
             return true;
 
         }
@@ -252,7 +265,16 @@ again:
         assert( !toSend.empty() );
         mmm( log() << "*  say() sock:" << this->sock << " thr:" << GetCurrentThreadId() << endl; )
         toSend.header()->id = nextMessageId();
-        toSend.header()->responseTo = responseTo;
+        if ( responseTo == -1 ) {
+            // not a reply: responseTo is unused on requests, so carry the
+            // thread's trace id there if it has one (see message.h)
+            unsigned t = currentTraceId();
+            toSend.header()->responseTo = t ? (int) t : -1;
+        }
+        else {
+            toSend.header()->responseTo = responseTo;
+        }
+        _connBytesOut += toSend.header()->len;
 
         if ( piggyBackData && piggyBackData->len() ) {
             mmm( log() << "*     have piggy back" << endl; )
@@ -267,9 +289,63 @@ again:
             }
         }
 
+        if ( _compressOut && toSend.doIFreeIt() && toSend.header()->len >= CompressWireThreshold ) {
+            if ( _sayCompressed( toSend ) )
+                return;
+            // didn't shrink - fall through and send as is
+        }
+
         toSend.send( *this, "say" );
     }
 
+    /* wire format of a compressed message: the usual header (flag bit set,
+       len = bytes actually on the wire), then the uncompressed data length,
+       then the snappy compressed payload.
+    */
+    bool MessagingPort::_sayCompressed( Message& toSend ) {
+        toSend.concat(); // owned buffers only (see doIFreeIt check in say()) so this is safe
+        MsgData *md = toSend.singleData();
+        int dataLen = md->len - MsgDataHeaderSize;
+
+        boost::scoped_array<char> buf( new char[ MsgDataHeaderSize + 4 + maxCompressedLength( dataLen ) ] );
+        MsgData *out = (MsgData *) buf.get();
+        memcpy( out, md, MsgDataHeaderSize );
+        out->_flags |= MessageFlagCompressed;
+        *((int *) out->_data) = dataLen;
+
+        size_t compLen = 0;
+        rawCompress( (const char *) md->_data, dataLen, out->_data + 4, &compLen );
+        if ( (int) compLen + 4 >= dataLen )
+            return false;
+
+        out->len = MsgDataHeaderSize + 4 + (int) compLen;
+        send( buf.get(), out->len, "say" );
+        return true;
+    }
+
+    MsgData * MessagingPort::_uncompress( MsgData * md ) {
+        int compLen = md->len - MsgDataHeaderSize - 4;
+        int rawLen = compLen > 0 ? *((int *) md->_data) : -1;
+        MsgData *out = 0;
+        if ( rawLen >= 0 && rawLen <= 48000000 ) {
+            int len = rawLen + MsgDataHeaderSize;
+            int z = (len+1023)&0xfffffc00;
+            assert(z>=len);
+            out = (MsgData *) MsgBufPool::get(z);
+            memcpy( out, md, MsgDataHeaderSize );
+            out->_flags &= ~MessageFlagCompressed;
+            out->len = len;
+            if ( ! rawUncompress( md->_data + 4, compLen, out->_data, rawLen ) ) {
+                MsgBufPool::release( (char *) out );
+                out = 0;
+            }
+        }
+        MsgBufPool::release( (char *) md );
+        if ( out == 0 )
+            log(0) << "recv(): bad compressed message from " << remote() << endl;
+        return out;
+    }
+
     void MessagingPort::piggyBack( Message& toSend , int responseTo ) {
 
         if ( toSend.header()->len > 1300 ) {
@@ -29,7 +29,7 @@ namespace mongo {
 
     class AbstractMessagingPort : boost::noncopyable {
     public:
-        AbstractMessagingPort() : tag(0) {}
+        AbstractMessagingPort() : tag(0), _connOps(0), _connBytesIn(0), _connBytesOut(0) {}
         virtual ~AbstractMessagingPort() { }
         virtual void reply(Message& received, Message& response, MSGID responseTo) = 0; // like the reply below, but doesn't rely on received.data still being available
         virtual void reply(Message& received, Message& response) = 0;
@@ -37,7 +37,19 @@ namespace mongo {
         virtual HostAndPort remote() const = 0;
         virtual unsigned remotePort() const = 0;
 
-    private:
+        /** cumulative counters for the life of the connection.  bumped by the
+            connection's own thread with plain increments - no locking - so a
+            reader on another thread (e.g. the connStats command) may see values
+            that are a moment stale.
+        */
+        long long connOps() const { return _connOps; }
+        long long connBytesIn() const { return _connBytesIn; }
+        long long connBytesOut() const { return _connBytesOut; }
+
+    protected:
+        long long _connOps;
+        long long _connBytesIn;
+        long long _connBytesOut;
 
     public:
         // TODO make this private with some helpers
@@ -88,11 +100,25 @@ namespace mongo {
         unsigned remotePort() const { return Socket::remotePort(); }
         virtual HostAndPort remote() const;
 
+        /** snappy wire compression.  recv() always understands compressed
+            messages - a header flag marks them - but we only *send* compressed
+            once the peer has asked for it (the setWireCompression command). */
+        void setCompressOut( bool b ) { _compressOut = b; }
+        bool compressOut() const { return _compressOut; }
 
     private:
-        
+
         PiggyBackData * piggyBackData;
-        
+        bool _compressOut;
+
+        /** compress and send.  @return false if the payload didn't shrink, in
+            which case nothing was sent and the caller sends it uncompressed. */
+        bool _sayCompressed( Message& toSend );
+
+        /** swap a just-received compressed message for its expanded form.
+            releases md.  @return 0 (and logs) if the data is corrupt. */
+        MsgData * _uncompress( MsgData * md );
+
         // this is the parsed version of remote
         // mutable because its initialized only on call to remote()
         mutable HostAndPort _remoteParsed; 
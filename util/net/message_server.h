@@ -45,6 +45,17 @@ namespace mongo {
          * called once when a socket is disconnected
          */
         virtual void disconnected( AbstractMessagingPort* p ) = 0;
+
+        /**
+         * event-driven servers park idle connections and may process successive
+         * messages for one connection on different worker threads.  suspended()
+         * is called after process() to detach any thread local state the handler
+         * keeps for the connection; the returned token is passed back to
+         * resumed() before the next process() on whichever thread picks the
+         * connection up.  thread-per-connection servers never call these.
+         */
+        virtual void* suspended( AbstractMessagingPort* p ) { return 0; }
+        virtual void resumed( AbstractMessagingPort* p , void* state ) { }
     };
 
     class MessageServer {
@@ -0,0 +1,348 @@
+// message_server_epoll.cpp
+
+/*    Copyright 2011 10gen Inc.
+ *
+ *    Licensed under the Apache License, Version 2.0 (the "License");
+ *    you may not use this file except in compliance with the License.
+ *    You may obtain a copy of the License at
+ *
+ *    http://www.apache.org/licenses/LICENSE-2.0
+ *
+ *    Unless required by applicable law or agreed to in writing, software
+ *    distributed under the License is distributed on an "AS IS" BASIS,
+ *    WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ *    See the License for the specific language governing permissions and
+ *    limitations under the License.
+ */
+
+/* event-driven MessageServer: idle connections are parked in an epoll set and
+   cost no thread or stack; when a socket becomes readable a poller thread reads
+   one message off it and hands the message to a fixed thread-per-core execution
+   pool, which processes it and then re-arms the socket.  EPOLLONESHOT
+   guarantees a connection is only ever in one stage at a time.  messages are
+   classified read / write / command on the way into the pool; writes all
+   serialize on the global write lock anyway, so only a couple are admitted at
+   once and the rest of the pool keeps serving reads and commands.
+   build with --epoll (linux only).
+*/
+
+#include "pch.h"
+
+#if defined(MONGO_USE_EPOLL_SERVER)
+
+#include <sys/epoll.h>
+
+#include "message.h"
+#include "message_port.h"
+#include "message_server.h"
+#include "listen.h"
+
+#include "../../db/cmdline.h"
+#include "../../db/dbmessage.h"
+#include "../../db/lasterror.h"
+#include "../../db/stats/counters.h"
+
+namespace mongo {
+
+    namespace ems {
+
+        MessageHandler * handler;
+
+        struct Connection : boost::noncopyable {
+            Connection( MessagingPort *port ) :
+                p( port ), le( new LastError() ), handlerState( 0 ), seenFirstEvent( false ) {
+            }
+            ~Connection() {
+                delete le;
+            }
+            MessagingPort *p;
+            LastError *le;      // connection owned; installed in tls for the span of each message
+            void *handlerState; // opaque per-connection state from MessageHandler::suspended()
+            bool seenFirstEvent;
+        };
+
+        /* operation classes for the execution stage */
+        enum OpClass { ReadOp = 0, WriteOp, CommandOp };
+
+        OpClass classifyOp( const Message& m ) {
+            switch( m.operation() ) {
+            case dbInsert:
+            case dbUpdate:
+            case dbDelete:
+                return WriteOp;
+            case dbQuery: {
+                DbMessage d( m );
+                if ( strstr( d.getns(), ".$cmd" ) )
+                    return CommandOp;
+                return ReadOp;
+            }
+            default:
+                // getmore, killcursors, ...
+                return ReadOp;
+            }
+        }
+
+    }
+
+    class EPollMessageServer : public MessageServer , public Listener {
+    public:
+        EPollMessageServer( const MessageServer::Options& opts, MessageHandler * handler ) :
+            Listener( "" , opts.ipList, opts.port ),
+            _connMutex( "EPollMessageServer" ),
+            _execMutex( "EPollMessageServerExec" ),
+            _inflightWrites( 0 ),
+            _maxInflightWrites( 1 ) {
+            uassert( 15900 , "multiple EPollMessageServer not supported" , ! ems::handler );
+            ems::handler = handler;
+            _epfd = epoll_create( 1024 /* size hint, ignored by modern kernels */ );
+            massert( 15901 , errnoWithPrefix( "epoll_create failed" ), _epfd >= 0 );
+        }
+
+        virtual void accepted(MessagingPort * p) {
+            if ( ! connTicketHolder.tryAcquire() ) {
+                log() << "connection refused because too many open connections: " << connTicketHolder.used() << endl;
+                p->shutdown();
+                delete p;
+                sleepmillis(2); // otherwise we'll hard loop
+                return;
+            }
+
+            ems::Connection *c = new ems::Connection( p );
+            {
+                scoped_lock lk( _connMutex );
+                _conns[ p->rawFD() ] = c;
+            }
+
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLONESHOT;
+            ev.data.ptr = c;
+            if ( epoll_ctl( _epfd, EPOLL_CTL_ADD, p->rawFD(), &ev ) != 0 ) {
+                log() << "epoll_ctl add failed: " << errnoWithDescription() << endl;
+                _close( c, false );
+            }
+        }
+
+        virtual void setAsTimeTracker() {
+            Listener::setAsTimeTracker();
+        }
+
+        void run() {
+            // execution is thread-per-core: the pool is fixed no matter how many
+            // connections are parked in the epoll set
+            int nExec = boost::thread::hardware_concurrency();
+            if ( nExec < 2 )
+                nExec = 2;
+            _maxInflightWrites = nExec / 4 > 1 ? nExec / 4 : 1;
+            for( int i = 0; i < nExec; i++ )
+                boost::thread( boost::bind( &EPollMessageServer::execRun, this ) );
+
+            // pollers only wait on the epoll set and read messages off ready
+            // sockets, so a couple suffice
+            for( int i = 0; i < 2; i++ )
+                boost::thread( boost::bind( &EPollMessageServer::workerRun, this ) );
+            initAndListen();
+        }
+
+        virtual bool useUnixSockets() const { return true; }
+
+    private:
+        /** pull ready connections off the epoll set, read one message each and
+            pass it to the execution pool */
+        void workerRun() {
+            setThreadName( "epollpoller" );
+            while ( ! inShutdown() ) {
+                struct epoll_event ev;
+                int n = epoll_wait( _epfd, &ev, 1, 500 /*ms - bounded so we notice shutdown*/ );
+                if ( n < 0 ) {
+                    if ( errno == EINTR )
+                        continue;
+                    log() << "epoll_wait failed: " << errnoWithDescription() << endl;
+                    sleepmillis(100);
+                    continue;
+                }
+                if ( n == 0 )
+                    continue;
+                _dispatch( static_cast<ems::Connection*>( ev.data.ptr ) );
+            }
+        }
+
+        void _dispatch( ems::Connection *c ) {
+            MessagingPort *p = c->p;
+            try {
+                if ( ! c->seenFirstEvent ) {
+                    // first readable event - run the handler's per connection setup
+                    // here so it happens on a worker, as it would on a conn thread
+                    c->seenFirstEvent = true;
+                    ems::handler->connected( p );
+                    c->handlerState = ems::handler->suspended( p );
+                }
+
+                auto_ptr<Message> m( new Message() );
+                p->clearCounters();
+                if ( ! p->recv(*m) ) {
+                    if( !cmdLine.quiet )
+                        log() << "end connection " << p->remoteString() << endl;
+                    _close( c, true );
+                    return;
+                }
+
+                _enqueue( c, m.release() );
+            }
+            catch ( AssertionException& e ) {
+                log() << "AssertionException reading request, closing client connection: " << e << endl;
+                _close( c, true );
+            }
+            catch ( SocketException& e ) {
+                log() << "SocketException reading request, closing client connection: " << e << endl;
+                _close( c, true );
+            }
+            catch ( std::exception &e ) {
+                error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+            catch ( ... ) {
+                error() << "Uncaught exception, terminating" << endl;
+                dbexit( EXIT_UNCAUGHT );
+            }
+        }
+
+        void _enqueue( ems::Connection *c, Message *m ) {
+            Job j;
+            j.c = c;
+            j.m = m;
+            j.cls = ems::classifyOp( *m );
+            scoped_lock lk( _execMutex );
+            _jobs.push_back( j );
+            _execWork.notify_one();
+        }
+
+        /** fifo, except that at most _maxInflightWrites write ops run at once -
+            every write serializes on the global write lock anyway, so letting the
+            whole pool pile up behind it only adds context switches while reads
+            and commands sit in the queue. */
+        bool _next( Job& j ) {
+            scoped_lock lk( _execMutex );
+            while ( ! inShutdown() ) {
+                for( deque<Job>::iterator i = _jobs.begin(); i != _jobs.end(); ++i ) {
+                    if ( i->cls == ems::WriteOp && _inflightWrites >= _maxInflightWrites )
+                        continue;
+                    j = *i;
+                    _jobs.erase( i );
+                    if ( j.cls == ems::WriteOp )
+                        _inflightWrites++;
+                    return true;
+                }
+                _execWork.timed_wait( lk.boost(), incxtimemillis( 500 ) );
+            }
+            return false;
+        }
+
+        /** execution pool: process messages handed over by the pollers */
+        void execRun() {
+            setThreadName( "execworker" );
+            Job j;
+            while ( _next( j ) ) {
+                ems::Connection *c = j.c;
+                MessagingPort *p = c->p;
+                try {
+                    ems::handler->resumed( p, c->handlerState );
+                    c->handlerState = 0;
+                    lastError.reset( c->le );
+
+                    ems::handler->process( *j.m, p, c->le );
+                    networkCounter.hit( p->getBytesIn(), p->getBytesOut() );
+
+                    lastError.release();
+                    c->handlerState = ems::handler->suspended( p );
+                    _rearm( c );
+                }
+                catch ( AssertionException& e ) {
+                    log() << "AssertionException handling request, closing client connection: " << e << endl;
+                    lastError.release();
+                    _close( c, true );
+                }
+                catch ( SocketException& e ) {
+                    log() << "SocketException handling request, closing client connection: " << e << endl;
+                    lastError.release();
+                    _close( c, true );
+                }
+                catch ( const ClockSkewException & ) {
+                    log() << "ClockSkewException - shutting down" << endl;
+                    exitCleanly( EXIT_CLOCK_SKEW );
+                }
+                catch ( std::exception &e ) {
+                    error() << "Uncaught std::exception: " << e.what() << ", terminating" << endl;
+                    dbexit( EXIT_UNCAUGHT );
+                }
+                catch ( ... ) {
+                    error() << "Uncaught exception, terminating" << endl;
+                    dbexit( EXIT_UNCAUGHT );
+                }
+                delete j.m;
+                if ( j.cls == ems::WriteOp ) {
+                    scoped_lock lk( _execMutex );
+                    _inflightWrites--;
+                    _execWork.notify_one();
+                }
+            }
+        }
+
+        void _rearm( ems::Connection *c ) {
+            struct epoll_event ev;
+            ev.events = EPOLLIN | EPOLLONESHOT;
+            ev.data.ptr = c;
+            if ( epoll_ctl( _epfd, EPOLL_CTL_MOD, c->p->rawFD(), &ev ) != 0 ) {
+                log() << "epoll_ctl mod failed: " << errnoWithDescription() << endl;
+                _close( c, true );
+            }
+        }
+
+        /** tear down a connection.  caller must hold the connection (oneshot) so
+            nobody else can be dispatching it. */
+        void _close( ems::Connection *c, bool notifyHandler ) {
+            MessagingPort *p = c->p;
+            epoll_ctl( _epfd, EPOLL_CTL_DEL, p->rawFD(), 0 );
+            {
+                scoped_lock lk( _connMutex );
+                _conns.erase( p->rawFD() );
+            }
+            if ( notifyHandler ) {
+                // on the poller path the connection's state is detached; on the
+                // execution path a failed process() left it attached to this
+                // thread already, so don't re-attach over it
+                if ( c->handlerState ) {
+                    ems::handler->resumed( p, c->handlerState );
+                    c->handlerState = 0;
+                }
+                ems::handler->disconnected( p );
+            }
+            p->shutdown();
+            delete p;
+            delete c;
+            connTicketHolder.release();
+        }
+
+        int _epfd;
+        mutex _connMutex; // guards _conns; connections themselves are serialized by EPOLLONESHOT
+        map<int,ems::Connection*> _conns;
+
+        /* execution stage */
+        struct Job {
+            ems::Connection *c;
+            Message *m;
+            ems::OpClass cls;
+        };
+        mutex _execMutex; // guards _jobs and _inflightWrites
+        boost::condition _execWork;
+        deque<Job> _jobs;
+        int _inflightWrites;
+        int _maxInflightWrites;
+    };
+
+    MessageServer * createServer( const MessageServer::Options& opts , MessageHandler * handler ) {
+        return new EPollMessageServer( opts , handler );
+    }
+
+}
+
+#endif
@@ -17,7 +17,7 @@
 
 #include "pch.h"
 
-#ifndef USE_ASIO
+#if !defined(USE_ASIO) && !defined(MONGO_USE_EPOLL_SERVER)
 
 #include "message.h"
 #include "message_port.h"
@@ -181,6 +181,9 @@ namespace mongo {
         }
 
         void run() {
+            // spread accept load over a few SO_REUSEPORT sockets on larger
+            // machines so reconnect storms don't queue on a single thread
+            setAcceptors( min( 4 , (int)boost::thread::hardware_concurrency() ) );
             initAndListen();
         }
 
@@ -206,6 +206,9 @@ namespace mongo {
         string remoteString() const { return _remote.toString(); }
         unsigned remotePort() const { return _remote.getPort(); }
 
+        /** the underlying file descriptor - for multiplexing (epoll etc.), not for i/o */
+        int rawFD() const { return _fd; }
+
         void clearCounters() { _bytesIn = 0; _bytesOut = 0; }
         long long getBytesIn() const { return _bytesIn; }
         long long getBytesOut() const { return _bytesOut; }
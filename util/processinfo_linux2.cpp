@@ -218,6 +218,42 @@ namespace mongo {
 
         LinuxProc p(_pid);
         info.append("page_faults", (int)p._maj_flt);
+
+        if ( access( "/sys/devices/system/node/node1" , F_OK ) == 0 ) {
+            // more than one memory node - show how memory is spread so numa
+            // imbalance (all pages on one node) is visible from serverStatus
+            BSONObjBuilder numa( info.subobjStart( "numa" ) );
+            for ( int node = 0; ; node++ ) {
+                char name[128];
+                sprintf( name , "/sys/devices/system/node/node%d/meminfo" , node );
+                FILE * f = fopen( name , "r" );
+                if ( ! f )
+                    break;
+                unsigned long totalKB = 0;
+                unsigned long freeKB = 0;
+                unsigned long filePagesKB = 0;
+                char line[256];
+                while ( fgets( line , sizeof(line) , f ) ) {
+                    unsigned long kb;
+                    if ( sscanf( line , "Node %*d MemTotal: %lu kB" , &kb ) == 1 )
+                        totalKB = kb;
+                    else if ( sscanf( line , "Node %*d MemFree: %lu kB" , &kb ) == 1 )
+                        freeKB = kb;
+                    else if ( sscanf( line , "Node %*d FilePages: %lu kB" , &kb ) == 1 )
+                        filePagesKB = kb;
+                }
+                fclose( f );
+
+                sprintf( name , "node%d" , node );
+                BSONObjBuilder b( numa.subobjStart( name ) );
+                b.append( "total_mb" , (int)( totalKB / 1024 ) );
+                b.append( "free_mb" , (int)( freeKB / 1024 ) );
+                // mmapped datafiles land here; roughly even across nodes is good
+                b.append( "file_pages_mb" , (int)( filePagesKB / 1024 ) );
+                b.done();
+            }
+            numa.done();
+        }
     }
 
     bool ProcessInfo::blockCheckSupported() {
@@ -49,6 +49,17 @@ namespace mongo {
         }
 
 
+        /** look at the front element without removing it.
+            only meaningful with a single consumer. */
+        bool peek( T& t ) {
+            scoped_lock l( _lock );
+            if ( _queue.empty() )
+                return false;
+
+            t = _queue.front();
+            return true;
+        }
+
         bool tryPop( T & t ) {
             scoped_lock l( _lock );
             if ( _queue.empty() )
@@ -182,11 +182,14 @@ namespace mongo {
                     log() << "** WARNING: cannot parse numa_maps" << startupWarningsLog;
                     warned = true;
                 }
-                else if ( ! startsWith(space+1, "interleave") ) {
+                else if ( ! startsWith(space+1, "interleave") && ! cmdLine.numaInterleave ) {
+                    // with --numaInterleave we set the policy ourselves after startup,
+                    // so the text mapping numa_maps shows here still reads "default"
                     log() << startupWarningsLog;
                     log() << "** WARNING: You are running on a NUMA machine." << startupWarningsLog;
                     log() << "**          We suggest launching mongod like this to avoid performance problems:" << startupWarningsLog;
                     log() << "**              numactl --interleave=all mongod [other options]" << startupWarningsLog;
+                    log() << "**          or running with --numaInterleave" << startupWarningsLog;
                     warned = true;
                 }
             }